@@ -0,0 +1,291 @@
+/**
+ * @file
+ * @date October 2026
+ * @brief BACnet Ethernet (ISO 8802-3) datalink throughput benchmark.
+ *
+ * A receiver process opens the datalink on one interface and a sender
+ * process opens it on another, for example the two ends of a veth pair,
+ * or both on the loopback interface. The sender transmits proprietary
+ * network layer messages with a sequence number as fast as the datalink
+ * takes them, and both report frames per second.
+ *
+ * @section LICENSE
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+/* OS specific include*/
+#include "bacport.h"
+/* local includes */
+#include "bacnet/bacdef.h"
+#include "bacnet/bacenum.h"
+#include "bacnet/bacint.h"
+#include "bacnet/bits.h"
+#include "bacnet/npdu.h"
+#include "bacnet/datalink/ethernet.h"
+#include "bacnet/version.h"
+
+/* vendor identifier in the proprietary network layer message */
+#define ETHPERF_VENDOR_ID 260
+/* NPDU header, message type, vendor ID and sequence number */
+#define ETHPERF_PDU_MIN 9
+/* the receiver stops when no frame arrives for this long */
+#define ETHPERF_IDLE_MS 1000
+
+/* results passed from the receiver to the sender process */
+struct ethperf_result {
+    uint32_t count;
+    uint32_t out_of_order;
+    uint64_t first_ns;
+    uint64_t last_ns;
+};
+
+static uint32_t Frame_Count = 100000;
+static unsigned PDU_Len = 64;
+
+static uint64_t ethperf_clock(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return ((uint64_t)now.tv_sec * 1000000000ULL) + (uint64_t)now.tv_nsec;
+}
+
+static double ethperf_rate(uint32_t count, uint64_t elapsed_ns)
+{
+    if (elapsed_ns == 0) {
+        return 0.0;
+    }
+
+    return ((double)count * 1000000000.0) / (double)elapsed_ns;
+}
+
+static int ethperf_receiver(char *ifname, int ready_fd, int result_fd)
+{
+    struct ethperf_result result = { 0 };
+    BACNET_ADDRESS src = { 0 };
+    uint8_t pdu[MAX_PDU] = { 0 };
+    uint16_t pdu_len = 0;
+    uint16_t vendor_id = 0;
+    uint32_t sequence = 0;
+    uint32_t expected = 0;
+    uint64_t start_ns = 0;
+    uint64_t now = 0;
+    uint8_t ready = 1;
+
+    if (!ethernet_init(ifname)) {
+        return 1;
+    }
+    if (write(ready_fd, &ready, sizeof(ready)) != sizeof(ready)) {
+        return 1;
+    }
+    start_ns = ethperf_clock();
+    for (;;) {
+        pdu_len = ethernet_receive(&src, pdu, sizeof(pdu), ETHPERF_IDLE_MS);
+        now = ethperf_clock();
+        if (pdu_len >= ETHPERF_PDU_MIN) {
+            (void)decode_unsigned16(&pdu[3], &vendor_id);
+            if ((pdu[1] & BIT(7)) && (pdu[2] == 0x80) &&
+                (vendor_id == ETHPERF_VENDOR_ID)) {
+                (void)decode_unsigned32(&pdu[5], &sequence);
+                if (result.count == 0) {
+                    result.first_ns = now;
+                } else if (sequence != expected) {
+                    result.out_of_order++;
+                }
+                expected = sequence + 1;
+                result.last_ns = now;
+                result.count++;
+                if ((sequence + 1) >= Frame_Count) {
+                    break;
+                }
+            }
+        } else if (result.count &&
+            ((now - result.last_ns) >= (ETHPERF_IDLE_MS * 1000000ULL))) {
+            break;
+        } else if (!result.count &&
+            ((now - start_ns) >= (5 * ETHPERF_IDLE_MS * 1000000ULL))) {
+            break;
+        }
+    }
+    if (write(result_fd, &result, sizeof(result)) != sizeof(result)) {
+        return 1;
+    }
+
+    return 0;
+}
+
+static int ethperf_sender(char *ifname, int ready_fd, int result_fd)
+{
+    struct ethperf_result result = { 0 };
+    BACNET_ADDRESS dest = { 0 };
+    BACNET_NPDU_DATA npdu_data = { 0 };
+    uint8_t pdu[MAX_PDU] = { 0 };
+    uint32_t sequence = 0;
+    uint32_t errors = 0;
+    uint64_t start_ns = 0;
+    uint64_t end_ns = 0;
+    uint8_t ready = 0;
+    unsigned i;
+
+    if (read(ready_fd, &ready, sizeof(ready)) != sizeof(ready)) {
+        fprintf(stderr, "ethperf: receiver failed to start\n");
+        return 1;
+    }
+    if (!ethernet_init(ifname)) {
+        return 1;
+    }
+    ethernet_get_broadcast_address(&dest);
+    /* proprietary network layer message */
+    pdu[0] = BACNET_PROTOCOL_VERSION;
+    pdu[1] = BIT(7);
+    pdu[2] = 0x80;
+    (void)encode_unsigned16(&pdu[3], ETHPERF_VENDOR_ID);
+    for (i = ETHPERF_PDU_MIN; i < PDU_Len; i++) {
+        pdu[i] = (uint8_t)i;
+    }
+    start_ns = ethperf_clock();
+    for (sequence = 0; sequence < Frame_Count; sequence++) {
+        (void)encode_unsigned32(&pdu[5], sequence);
+        if (ethernet_send_pdu(&dest, &npdu_data, pdu, PDU_Len) <= 0) {
+            errors++;
+        }
+    }
+    end_ns = ethperf_clock();
+    if (read(result_fd, &result, sizeof(result)) != sizeof(result)) {
+        fprintf(stderr, "ethperf: no result from the receiver\n");
+        return 1;
+    }
+    printf("sent %lu frames of %u octets in %.3f s: %.0f frames/s, "
+           "%lu errors\n",
+        (unsigned long)Frame_Count, PDU_Len + ETHERNET_HEADER_MAX,
+        (double)(end_ns - start_ns) / 1000000000.0,
+        ethperf_rate(Frame_Count, end_ns - start_ns), (unsigned long)errors);
+    printf("received %lu frames: %.0f frames/s, %lu lost, "
+           "%lu out of order\n",
+        (unsigned long)result.count,
+        ethperf_rate(result.count ? result.count - 1 : 0,
+            result.last_ns - result.first_ns),
+        (unsigned long)(Frame_Count - result.count),
+        (unsigned long)result.out_of_order);
+
+    return 0;
+}
+
+static void print_usage(const char *filename)
+{
+    printf("Usage: %s [--frames N][--npdu N] sender [receiver]\n", filename);
+    printf("       [--version][--help]\n");
+}
+
+static void print_help(const char *filename)
+{
+    printf("Measure the frames per second of the BACnet Ethernet datalink.\n"
+           "A receiver process is started on the receiver interface,\n"
+           "or on the sender interface if none is given, and frames are\n"
+           "sent as fast as possible from the sender interface.\n"
+           "Needs root privileges.\n");
+    printf("\n");
+    printf("--frames N\n"
+           "Number of frames to send. Default %lu.\n",
+        (unsigned long)Frame_Count);
+    printf("--npdu N\n"
+           "NPDU length of each frame, %u to %u. Default %u.\n",
+        ETHPERF_PDU_MIN, MAX_PDU, PDU_Len);
+    printf("\n");
+    printf("Example:\n"
+           "ip link add veth0 type veth peer name veth1\n"
+           "ip link set veth0 up && ip link set veth1 up\n"
+           "%s --frames 1000000 veth0 veth1\n",
+        filename);
+}
+
+int main(int argc, char *argv[])
+{
+    char *ifname[2] = { NULL, NULL };
+    unsigned ifcount = 0;
+    int ready_pipe[2];
+    int result_pipe[2];
+    pid_t pid;
+    int status = 0;
+    int argi;
+
+    for (argi = 1; argi < argc; argi++) {
+        if (strcmp(argv[argi], "--help") == 0) {
+            print_usage(argv[0]);
+            print_help(argv[0]);
+            return 0;
+        }
+        if (strcmp(argv[argi], "--version") == 0) {
+            printf("ethperf %s\n", BACNET_VERSION_TEXT);
+            printf("This is free software; see the source for copying "
+                   "conditions.\n"
+                   "There is NO warranty; not even for MERCHANTABILITY or\n"
+                   "FITNESS FOR A PARTICULAR PURPOSE.\n");
+            return 0;
+        }
+        if ((strcmp(argv[argi], "--frames") == 0) && ((argi + 1) < argc)) {
+            Frame_Count = (uint32_t)strtoul(argv[++argi], NULL, 0);
+        } else if ((strcmp(argv[argi], "--npdu") == 0) &&
+            ((argi + 1) < argc)) {
+            PDU_Len = (unsigned)strtoul(argv[++argi], NULL, 0);
+        } else if ((argv[argi][0] != '-') && (ifcount < 2)) {
+            ifname[ifcount++] = argv[argi];
+        } else {
+            print_usage(argv[0]);
+            return 1;
+        }
+    }
+    if ((ifcount == 0) || (Frame_Count == 0) ||
+        (PDU_Len < ETHPERF_PDU_MIN) || (PDU_Len > MAX_PDU)) {
+        print_usage(argv[0]);
+        return 1;
+    }
+    if (ifcount == 1) {
+        ifname[1] = ifname[0];
+    }
+    if ((pipe(ready_pipe) != 0) || (pipe(result_pipe) != 0)) {
+        perror("ethperf: pipe");
+        return 1;
+    }
+    pid = fork();
+    if (pid < 0) {
+        perror("ethperf: fork");
+        return 1;
+    }
+    if (pid == 0) {
+        close(ready_pipe[0]);
+        close(result_pipe[0]);
+        exit(ethperf_receiver(ifname[1], ready_pipe[1], result_pipe[1]));
+    }
+    close(ready_pipe[1]);
+    close(result_pipe[1]);
+    status = ethperf_sender(ifname[0], ready_pipe[0], result_pipe[0]);
+    waitpid(pid, NULL, 0);
+
+    return status;
+}
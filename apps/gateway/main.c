@@ -82,8 +82,8 @@ int DNET_list[2] = {
 /* current version of the BACnet stack */
 static const char *BACnet_Version = BACNET_VERSION_TEXT;
 
-/* routed devices - I-Am on startup */
-static unsigned Routed_Device_Index;
+/* number of Devices, including the gateway */
+static unsigned Device_Total = MAX_NUM_DEVICES;
 
 /** Initialize the Device Objects and each of the child Object instances.
  * @param first_object_instance Set the first (gateway) Device to this
@@ -91,7 +91,7 @@ static unsigned Routed_Device_Index;
  */
 static void Devices_Init(uint32_t first_object_instance)
 {
-    int i;
+    unsigned i;
     char nameText[MAX_DEV_NAME_LEN];
     char descText[MAX_DEV_DESC_LEN];
     BACNET_CHARACTER_STRING name_string;
@@ -101,12 +101,16 @@ static void Devices_Init(uint32_t first_object_instance)
     Routed_Device_Set_Description(DEV_DESCR_GATEWAY, strlen(DEV_DESCR_GATEWAY));
 
     /* Now initialize the remote Device objects. */
-    for (i = 1; i < MAX_NUM_DEVICES; i++) {
-        snprintf(nameText, MAX_DEV_NAME_LEN, "%s %d", DEV_NAME_BASE, i + 1);
-        snprintf(descText, MAX_DEV_DESC_LEN, "%s %d", DEV_DESCR_REMOTE, i);
+    for (i = 1; i < Device_Total; i++) {
+        snprintf(nameText, MAX_DEV_NAME_LEN, "%s %u", DEV_NAME_BASE, i + 1);
+        snprintf(descText, MAX_DEV_DESC_LEN, "%s %u", DEV_DESCR_REMOTE, i);
         characterstring_init_ansi(&name_string, nameText);
 
-        Add_Routed_Device((first_object_instance + i), &name_string, descText);
+        if (Add_Routed_Device((first_object_instance + i), &name_string,
+                descText) == UINT16_MAX) {
+            printf("Error: only %u Devices could be added\n", i);
+            break;
+        }
     }
 }
 
@@ -123,9 +127,8 @@ static void Initialize_Device_Addresses(void)
     int i = 0; /* First entry is Gateway Device */
     uint32_t virtual_mac = 0;
     BACNET_ADDRESS virtual_address = { 0 };
+    BACNET_ADDRESS device_address = { 0 };
     DEVICE_OBJECT_DATA *pDev = NULL;
-    /* Setup info for the main gateway device first */
-    pDev = Get_Routed_Device_Object(i);
 
     /* we can't use datalink_get_my_address() since it is
        mapped to routed_get_my_address() in this app
@@ -140,26 +143,34 @@ static void Initialize_Device_Addresses(void)
     ethernet_get_my_address(&virtual_address);
 #elif defined(BACDL_BIP6)
     bip6_get_my_address(&virtual_address);
+#elif defined(BACDL_ALL)
+    datalink_port_get_my_address(0, &virtual_address);
 #else
 #error "No support for this Data Link Layer type "
 #endif
-    bacnet_address_copy(&pDev->bacDevAddr, &virtual_address);
+    /* Setup info for the main gateway device first */
+    Routed_Device_Set_Address(i, &virtual_address);
+    Get_Routed_Device_Object(i);
     /* broadcast an I-Am on startup */
     Send_I_Am(&Handler_Transmit_Buffer[0]);
 
-    for (i = 1; i < MAX_NUM_DEVICES; i++) {
+    for (i = 1; i < Routed_Device_Count(); i++) {
         pDev = Get_Routed_Device_Object(i);
         if (pDev == NULL) {
             continue;
         }
         /* start with the router address */
-        bacnet_address_copy(&pDev->bacDevAddr, &virtual_address);
+        bacnet_address_copy(&device_address, &virtual_address);
         /* add the network number to each gateway device */
-        pDev->bacDevAddr.net = VIRTUAL_DNET;
+        device_address.net = VIRTUAL_DNET;
         /* use a virtual MAC for each gateway device */
         virtual_mac = pDev->bacObj.Object_Instance_Number;
-        encode_unsigned24(&pDev->bacDevAddr.adr[0], virtual_mac);
-        pDev->bacDevAddr.len = 3;
+        encode_unsigned24(&device_address.adr[0], virtual_mac);
+        device_address.len = 3;
+        /* the virtual MAC is indexed for routing */
+        Routed_Device_Set_Address(i, &device_address);
+        /* broadcast a paced I-Am for each routed Device */
+        handler_who_is_i_am_queue(i, NULL);
     }
 }
 
@@ -175,10 +186,11 @@ static void Init_Service_Handlers(uint32_t first_object_instance)
      * For the gateway, we will use the unicast variety so we can
      * get back through switches to different subnets.
      * Don't need the routed versions, since the npdu handler calls
-     * each device in turn.
+     * each device in turn. The I-Am are paced, so that a Who-Is for
+     * many devices does not flood the network.
      */
     apdu_set_unconfirmed_handler(
-        SERVICE_UNCONFIRMED_WHO_IS, handler_who_is_unicast);
+        SERVICE_UNCONFIRMED_WHO_IS, handler_who_is_unicast_paced);
     apdu_set_unconfirmed_handler(SERVICE_UNCONFIRMED_WHO_HAS, handler_who_has);
     /* set the handler for all the services we don't implement */
     /* It is required to send the proper reject message... */
@@ -220,10 +232,12 @@ static void Init_Service_Handlers(uint32_t first_object_instance)
  *      datalink_receive, npdu_handler,
  *      dcc_timer_seconds, datalink_maintenance_timer,
  *      Load_Control_State_Machine_Handler, handler_cov_task,
+ *      handler_who_is_task,
  *      tsm_timer_milliseconds
  *
  * @param argc [in] Arg count.
- * @param argv [in] Takes one argument: the Device Instance #.
+ * @param argv [in] Takes two optional arguments: the Device Instance # of
+ *                  the gateway, and the number of Devices.
  * @return 0 on success.
  */
 int main(int argc, char *argv[])
@@ -231,6 +245,9 @@ int main(int argc, char *argv[])
     BACNET_ADDRESS src = { 0 }; /* address where message came from */
     uint16_t pdu_len = 0;
     unsigned timeout = 1000; /* milliseconds */
+#if defined(BACDL_ALL)
+    unsigned port = 0; /* datalink port where message came from */
+#endif
     time_t last_seconds = 0;
     time_t current_seconds = 0;
     uint32_t elapsed_seconds = 0;
@@ -253,12 +270,22 @@ int main(int argc, char *argv[])
             exit(1);
         }
     }
+    /* allow the number of Devices to be set */
+    if (argc > 2) {
+        Device_Total = strtoul(argv[2], NULL, 0);
+        if ((Device_Total < 1) || (Device_Total > MAX_ROUTED_DEVICES)) {
+            printf("Error: Invalid number of Devices %s \n", argv[2]);
+            printf("Provide a number from 1 to %u \n",
+                (unsigned)MAX_ROUTED_DEVICES);
+            exit(1);
+        }
+    }
     printf("BACnet Router Demo\n"
            "BACnet Stack Version %s\n"
            "BACnet Device ID: %u\n"
            "Max APDU: %d\n"
-           "Max Devices: %d\n",
-        BACnet_Version, first_object_instance, MAX_APDU, MAX_NUM_DEVICES);
+           "Devices: %u\n",
+        BACnet_Version, first_object_instance, MAX_APDU, Device_Total);
     Init_Service_Handlers(first_object_instance);
     dlenv_init();
     atexit(datalink_cleanup);
@@ -283,12 +310,35 @@ int main(int argc, char *argv[])
         current_seconds = time(NULL);
 
         /* returns 0 bytes on timeout */
+        if (handler_who_is_pending()) {
+            /* keep the I-Am flowing */
+            timeout = 1;
+        } else {
+            timeout = 1000;
+        }
+#if defined(BACDL_ALL)
+        if (datalink_port_count()) {
+            /* route between the datalink ports, too */
+            pdu_len = datalink_port_receive(
+                &port, &src, &Rx_Buf[0], MAX_MPDU, timeout);
+            if (pdu_len) {
+                routing_npdu_port_handler(
+                    port, &src, DNET_list, &Rx_Buf[0], pdu_len);
+            }
+        } else {
+            pdu_len = datalink_receive(&src, &Rx_Buf[0], MAX_MPDU, timeout);
+            if (pdu_len) {
+                routing_npdu_handler(&src, DNET_list, &Rx_Buf[0], pdu_len);
+            }
+        }
+#else
         pdu_len = datalink_receive(&src, &Rx_Buf[0], MAX_MPDU, timeout);
 
         /* process */
         if (pdu_len) {
             routing_npdu_handler(&src, DNET_list, &Rx_Buf[0], pdu_len);
         }
+#endif
         /* at least one second has passed */
         elapsed_seconds = current_seconds - last_seconds;
         if (elapsed_seconds) {
@@ -302,12 +352,7 @@ int main(int argc, char *argv[])
         }
         handler_cov_task();
         /* output */
-        if (Routed_Device_Index < MAX_NUM_DEVICES) {
-            Routed_Device_Index++;
-            Get_Routed_Device_Object(Routed_Device_Index);
-            /* broadcast an I-Am for each routed Device now */
-            Send_I_Am(&Handler_Transmit_Buffer[0]);
-        }
+        handler_who_is_task();
     }
     /* Dummy return */
     return 0;
@@ -0,0 +1,987 @@
+/**
+ * @file
+ * @date October 2026
+ * @brief MS/TP capture file writer for pcap and pcapng ring files
+ *
+ * Each receive thread hands its frames to a single writer thread
+ * through a lock-free single producer, single consumer ring. The
+ * writer merges the rings in time order, collects the records in a
+ * large buffer, and writes the buffer to the capture file once it
+ * is full or once it has waited CAPTURE_FLUSH_INTERVAL. A slow disk
+ * therefore stalls the writer and never the UART readers. A frame is
+ * only dropped when its ring is full, and the drop is counted.
+ *
+ * Files are written as libpcap, or as pcapng with one interface
+ * description block per serial port and interface statistics
+ * blocks (received and dropped counts) at the end of each file.
+ * The files can be rotated by packet count, size, or age, and the
+ * oldest files removed to keep a fixed number of ring files.
+ *
+ * @section LICENSE
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include "bacnet/version.h"
+#include "bacnet/datetime.h"
+#include "bacnet/basic/sys/mstimer.h"
+/* OS specific includes */
+#include "bacport.h"
+#include "capture.h"
+
+#if defined(_WIN32)
+/* frames are written from the receive loop */
+#define CAPTURE_WRITER_THREAD 0
+#define CAPTURE_LOAD(p) (*(p))
+#define CAPTURE_STORE(p, v) (*(p) = (v))
+#else
+#define CAPTURE_WRITER_THREAD 1
+#define CAPTURE_LOAD(p) __atomic_load_n((p), __ATOMIC_ACQUIRE)
+#define CAPTURE_STORE(p, v) __atomic_store_n((p), (v), __ATOMIC_RELEASE)
+#endif
+
+/* pcapng block types and options */
+#define PCAPNG_SECTION_HEADER_BLOCK 0x0A0D0D0AUL
+#define PCAPNG_INTERFACE_DESCRIPTION_BLOCK 0x00000001UL
+#define PCAPNG_INTERFACE_STATISTICS_BLOCK 0x00000005UL
+#define PCAPNG_ENHANCED_PACKET_BLOCK 0x00000006UL
+#define PCAPNG_BYTE_ORDER_MAGIC 0x1A2B3C4DUL
+#define PCAPNG_OPT_ENDOFOPT 0
+#define PCAPNG_SHB_USERAPPL 4
+#define PCAPNG_IF_NAME 2
+#define PCAPNG_IF_SPEED 8
+#define PCAPNG_ISB_IFRECV 4
+#define PCAPNG_ISB_IFDROP 5
+#define PCAPNG_PAD(n) (((n) + 3UL) & ~3UL)
+/* interface statistics block with received and dropped counts */
+#define PCAPNG_STATISTICS_SIZE 52
+
+/* record header of a frame waiting in an interface ring */
+struct capture_record {
+    /* octets of frame data that follow, or CAPTURE_RECORD_WRAP */
+    uint32_t length;
+    uint32_t ts_sec;
+    uint32_t ts_usec;
+    uint32_t reserved;
+};
+/* the rest of the ring is unused - continue at the start */
+#define CAPTURE_RECORD_WRAP UINT32_MAX
+/* records are multiples of the header size so a wrap marker always fits */
+#define CAPTURE_RECORD_SIZE(n)                                      \
+    ((sizeof(struct capture_record) + (n) + 15UL) & ~15UL)
+
+struct capture_interface {
+    char name[64];
+    uint32_t baud;
+    /* frames handed to the writer, and frames lost */
+    uint32_t received;
+    uint32_t dropped;
+#if CAPTURE_WRITER_THREAD
+    /* written by the receive thread only */
+    uint32_t head;
+    /* written by the writer thread only */
+    uint32_t tail;
+    uint8_t *ring;
+#endif
+};
+
+static struct capture_interface Capture_Interface[CAPTURE_INTERFACE_MAX];
+static unsigned Capture_Interface_Count;
+static bool Capture_Pcapng;
+static bool Capture_Quiet;
+/* ring file policy - zero disables each limit */
+static uint32_t Ring_Packets;
+static uint64_t Ring_Bytes;
+static uint32_t Ring_Seconds;
+static unsigned Ring_Files;
+/* names of the files kept when Ring_Files is set */
+static char (*Ring_Filename)[64];
+static unsigned Ring_File_Count;
+/* the capture file being written */
+static char Capture_Filename[64];
+static FILE *pFile = NULL;
+static uint64_t File_Bytes;
+static uint32_t File_Packets;
+static time_t File_Start;
+/* batch of records waiting to be written */
+static uint8_t Write_Buffer[CAPTURE_WRITE_BUFFER_SIZE];
+static size_t Write_Length;
+static unsigned long Flush_Time;
+/* the file header goes into the pipe only once */
+static bool Pipe_Header_Sent;
+#if CAPTURE_WRITER_THREAD
+static pthread_t Writer_Thread;
+static bool Writer_Running;
+static bool Writer_Stop;
+#endif
+
+#if defined(_WIN32)
+static HANDLE hPipe = INVALID_HANDLE_VALUE; /* pipe handle */
+
+/**
+ * @brief Connect to the named pipe that Wireshark reads
+ * @param name - name of the pipe
+ * @return true if the pipe was connected
+ */
+bool capture_pipe_create(const char *name)
+{
+    if (!Capture_Quiet) {
+        fprintf(stdout, "mstpcap: Creating Named Pipe \"%s\"\n", name);
+    }
+    /* create the pipe */
+    while (hPipe == INVALID_HANDLE_VALUE) {
+        /* use CreateFile rather than CreateNamedPipe */
+        hPipe = CreateFile(name, GENERIC_READ | GENERIC_WRITE, 0, NULL,
+            OPEN_EXISTING, 0, NULL);
+        if (hPipe != INVALID_HANDLE_VALUE) {
+            break;
+        }
+        /* if an error occured at handle creation */
+        if (!WaitNamedPipe(name, 20000)) {
+            printf("Could not open pipe: waited for 20sec!\n"
+                   "If this message was issued before the 20sec finished,\n"
+                   "then the pipe doesn't exist!\n");
+            return false;
+        }
+    }
+    ConnectNamedPipe(hPipe, NULL);
+
+    return true;
+}
+
+/**
+ * @brief Flush and close the named pipe
+ */
+void capture_pipe_close(void)
+{
+    if (hPipe != INVALID_HANDLE_VALUE) {
+        FlushFileBuffers(hPipe);
+        DisconnectNamedPipe(hPipe);
+        CloseHandle(hPipe);
+        hPipe = INVALID_HANDLE_VALUE;
+    }
+}
+
+static bool capture_pipe_open(void)
+{
+    return hPipe != INVALID_HANDLE_VALUE;
+}
+
+static void capture_pipe_write(const void *ptr, size_t size)
+{
+    DWORD cbWritten = 0;
+
+    if (hPipe != INVALID_HANDLE_VALUE) {
+        (void)WriteFile(hPipe, /* handle to pipe  */
+            ptr, /* buffer to write from  */
+            size, /* number of bytes to write  */
+            &cbWritten, /* number of bytes written  */
+            NULL); /* not overlapped I/O  */
+    }
+}
+#else
+static int FD_Pipe = -1;
+
+/**
+ * @brief Create and open the FIFO that Wireshark reads
+ * @param name - path and name of the FIFO
+ * @return true if the FIFO was opened
+ */
+bool capture_pipe_create(const char *name)
+{
+    int rv = 0;
+
+    rv = mkfifo(name, 0666);
+    if ((rv == -1) && (errno != EEXIST)) {
+        perror("Error creating named pipe");
+        return false;
+    }
+    FD_Pipe = open(name, O_WRONLY);
+    if (FD_Pipe == -1) {
+        perror("Error connecting to named pipe");
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * @brief Close the FIFO
+ */
+void capture_pipe_close(void)
+{
+    if (FD_Pipe != -1) {
+        close(FD_Pipe);
+        FD_Pipe = -1;
+    }
+}
+
+static bool capture_pipe_open(void)
+{
+    return FD_Pipe != -1;
+}
+
+static void capture_pipe_write(const void *ptr, size_t size)
+{
+    ssize_t bytes = 0;
+
+    if (FD_Pipe != -1) {
+        bytes = write(FD_Pipe, ptr, size);
+        (void)bytes;
+    }
+}
+#endif
+
+static size_t encode_u16(uint8_t *buffer, uint16_t value)
+{
+    memcpy(buffer, &value, sizeof(value));
+
+    return sizeof(value);
+}
+
+static size_t encode_u32(uint8_t *buffer, uint32_t value)
+{
+    memcpy(buffer, &value, sizeof(value));
+
+    return sizeof(value);
+}
+
+static size_t encode_u64(uint8_t *buffer, uint64_t value)
+{
+    memcpy(buffer, &value, sizeof(value));
+
+    return sizeof(value);
+}
+
+/**
+ * @brief Encode a pcapng option, padded to 32 bits
+ * @param buffer - where the option is encoded
+ * @param code - option code
+ * @param value - option value, or NULL
+ * @param length - length of the value in octets
+ * @return number of octets encoded
+ */
+static size_t pcapng_option_encode(
+    uint8_t *buffer, uint16_t code, const void *value, uint16_t length)
+{
+    size_t len = 0;
+
+    len += encode_u16(&buffer[len], code);
+    len += encode_u16(&buffer[len], length);
+    if (length) {
+        memcpy(&buffer[len], value, length);
+        memset(&buffer[len + length], 0, PCAPNG_PAD(length) - length);
+        len += PCAPNG_PAD(length);
+    }
+
+    return len;
+}
+
+/**
+ * @brief Set the total length at both ends of a pcapng block
+ * @param buffer - start of the block, with room for the trailing length
+ * @param len - octets of the block, not including the trailing length
+ * @return total length of the block
+ */
+static size_t pcapng_block_close(uint8_t *buffer, size_t len)
+{
+    uint32_t total = (uint32_t)(len + 4);
+
+    (void)encode_u32(&buffer[4], total);
+    (void)encode_u32(&buffer[len], total);
+
+    return total;
+}
+
+/**
+ * @brief Encode the libpcap global header
+ * @param buffer - where the header is encoded
+ * @return number of octets encoded
+ */
+static size_t pcap_header_encode(uint8_t *buffer)
+{
+    size_t len = 0;
+
+    /* magic number */
+    len += encode_u32(&buffer[len], 0xa1b2c3d4);
+    /* major and minor version number */
+    len += encode_u16(&buffer[len], 2);
+    len += encode_u16(&buffer[len], 4);
+    /* GMT to local correction */
+    len += encode_u32(&buffer[len], 0);
+    /* accuracy of timestamps */
+    len += encode_u32(&buffer[len], 0);
+    /* max length of captured packets, in octets */
+    len += encode_u32(&buffer[len], 65535);
+    /* data link type */
+    len += encode_u32(&buffer[len], DLT_BACNET_MS_TP);
+
+    return len;
+}
+
+/**
+ * @brief Encode the pcapng section header and interface descriptions
+ * @param buffer - where the header is encoded
+ * @return number of octets encoded
+ */
+static size_t pcapng_header_encode(uint8_t *buffer)
+{
+    const char *userappl = "mstpcap " BACNET_VERSION_TEXT;
+    struct capture_interface *iface;
+    uint8_t *block;
+    uint64_t speed;
+    size_t len = 0;
+    size_t block_len;
+    unsigned i;
+
+    block = &buffer[len];
+    block_len = encode_u32(&block[0], PCAPNG_SECTION_HEADER_BLOCK);
+    block_len += 4;
+    block_len += encode_u32(&block[block_len], PCAPNG_BYTE_ORDER_MAGIC);
+    block_len += encode_u16(&block[block_len], 1);
+    block_len += encode_u16(&block[block_len], 0);
+    /* section length is not known */
+    block_len += encode_u64(&block[block_len], UINT64_MAX);
+    block_len += pcapng_option_encode(&block[block_len], PCAPNG_SHB_USERAPPL,
+        userappl, (uint16_t)strlen(userappl));
+    block_len +=
+        pcapng_option_encode(&block[block_len], PCAPNG_OPT_ENDOFOPT, NULL, 0);
+    len += pcapng_block_close(block, block_len);
+    for (i = 0; i < Capture_Interface_Count; i++) {
+        iface = &Capture_Interface[i];
+        block = &buffer[len];
+        block_len = encode_u32(&block[0], PCAPNG_INTERFACE_DESCRIPTION_BLOCK);
+        block_len += 4;
+        block_len += encode_u16(&block[block_len], DLT_BACNET_MS_TP);
+        block_len += encode_u16(&block[block_len], 0);
+        block_len += encode_u32(&block[block_len], 65535);
+        block_len += pcapng_option_encode(&block[block_len], PCAPNG_IF_NAME,
+            iface->name, (uint16_t)strlen(iface->name));
+        speed = iface->baud;
+        block_len += pcapng_option_encode(
+            &block[block_len], PCAPNG_IF_SPEED, &speed, sizeof(speed));
+        block_len += pcapng_option_encode(
+            &block[block_len], PCAPNG_OPT_ENDOFOPT, NULL, 0);
+        len += pcapng_block_close(block, block_len);
+    }
+
+    return len;
+}
+
+/**
+ * @brief Encode a pcapng interface statistics block
+ * @param buffer - where the block is encoded
+ * @param index - interface index
+ * @return number of octets encoded
+ */
+static size_t pcapng_statistics_encode(uint8_t *buffer, unsigned index)
+{
+    struct capture_interface *iface = &Capture_Interface[index];
+    struct timeval tv;
+    uint64_t timestamp;
+    uint64_t counter;
+    size_t len = 0;
+
+    gettimeofday(&tv, NULL);
+    timestamp = ((uint64_t)tv.tv_sec * 1000000ULL) + (uint64_t)tv.tv_usec;
+    len += encode_u32(&buffer[len], PCAPNG_INTERFACE_STATISTICS_BLOCK);
+    len += 4;
+    len += encode_u32(&buffer[len], index);
+    len += encode_u32(&buffer[len], (uint32_t)(timestamp >> 32));
+    len += encode_u32(&buffer[len], (uint32_t)timestamp);
+    counter = CAPTURE_LOAD(&iface->received);
+    len += pcapng_option_encode(
+        &buffer[len], PCAPNG_ISB_IFRECV, &counter, sizeof(counter));
+    counter = CAPTURE_LOAD(&iface->dropped);
+    len += pcapng_option_encode(
+        &buffer[len], PCAPNG_ISB_IFDROP, &counter, sizeof(counter));
+    len += pcapng_option_encode(&buffer[len], PCAPNG_OPT_ENDOFOPT, NULL, 0);
+
+    return pcapng_block_close(buffer, len);
+}
+
+/**
+ * @brief Number of octets a frame needs in the capture file
+ * @param frame_len - number of octets in the frame
+ * @return number of octets of the record
+ */
+static size_t capture_record_size(uint16_t frame_len)
+{
+    if (Capture_Pcapng) {
+        return 28 + PCAPNG_PAD(frame_len) + 4;
+    }
+
+    return 16 + frame_len;
+}
+
+/**
+ * @brief Encode a frame as a pcap record or a pcapng enhanced packet block
+ * @return number of octets encoded
+ */
+static size_t capture_record_encode(uint8_t *buffer,
+    unsigned index,
+    uint32_t ts_sec,
+    uint32_t ts_usec,
+    const uint8_t *frame,
+    uint16_t frame_len)
+{
+    uint64_t timestamp;
+    size_t len = 0;
+
+    if (Capture_Pcapng) {
+        timestamp = ((uint64_t)ts_sec * 1000000ULL) + ts_usec;
+        len += encode_u32(&buffer[len], PCAPNG_ENHANCED_PACKET_BLOCK);
+        len += 4;
+        len += encode_u32(&buffer[len], index);
+        len += encode_u32(&buffer[len], (uint32_t)(timestamp >> 32));
+        len += encode_u32(&buffer[len], (uint32_t)timestamp);
+        len += encode_u32(&buffer[len], frame_len);
+        len += encode_u32(&buffer[len], frame_len);
+        memcpy(&buffer[len], frame, frame_len);
+        memset(&buffer[len + frame_len], 0,
+            PCAPNG_PAD(frame_len) - frame_len);
+        len += PCAPNG_PAD(frame_len);
+        len = pcapng_block_close(buffer, len);
+    } else {
+        len += encode_u32(&buffer[len], ts_sec);
+        len += encode_u32(&buffer[len], ts_usec);
+        len += encode_u32(&buffer[len], frame_len);
+        len += encode_u32(&buffer[len], frame_len);
+        memcpy(&buffer[len], frame, frame_len);
+        len += frame_len;
+    }
+
+    return len;
+}
+
+static void capture_filename_create(char *filename, size_t size)
+{
+    static char last_stamp[32];
+    static unsigned sequence;
+    char stamp[32];
+    BACNET_DATE bdate;
+    BACNET_TIME btime;
+
+    datetime_local(&bdate, &btime, NULL, NULL);
+    snprintf(stamp, sizeof(stamp), "mstp_%04d%02d%02d%02d%02d%02d",
+        (int)bdate.year, (int)bdate.month, (int)bdate.day, (int)btime.hour,
+        (int)btime.min, (int)btime.sec);
+    /* ring files may rotate more than once a second */
+    if (strcmp(stamp, last_stamp) == 0) {
+        sequence++;
+        snprintf(filename, size, "%s_%u.%s", stamp, sequence,
+            Capture_Pcapng ? "pcapng" : "cap");
+    } else {
+        sequence = 0;
+        strcpy(last_stamp, stamp);
+        snprintf(filename, size, "%s.%s", stamp,
+            Capture_Pcapng ? "pcapng" : "cap");
+    }
+}
+
+/**
+ * @brief Remember a new ring file, and remove the oldest one
+ *  once there are more than Ring_Files
+ */
+static void capture_ring_file_add(const char *filename)
+{
+    unsigned slot;
+
+    if (!Ring_Filename) {
+        return;
+    }
+    slot = Ring_File_Count % Ring_Files;
+    if (Ring_File_Count >= Ring_Files) {
+        if (remove(Ring_Filename[slot]) != 0) {
+            fprintf(stderr, "mstpcap: failed to remove %s: %s\n",
+                Ring_Filename[slot], strerror(errno));
+        }
+    }
+    snprintf(Ring_Filename[slot], sizeof(Ring_Filename[slot]), "%s", filename);
+    Ring_File_Count++;
+}
+
+/**
+ * @brief Write the batch of records to the file and to the pipe
+ */
+static void capture_flush(void)
+{
+    if (Write_Length) {
+        if (pFile && (fwrite(Write_Buffer, Write_Length, 1, pFile) != 1)) {
+            fprintf(stderr, "mstpcap[packet]: failed to write %s: %s\n",
+                Capture_Filename, strerror(errno));
+        }
+        capture_pipe_write(Write_Buffer, Write_Length);
+        Write_Length = 0;
+    }
+    Flush_Time = mstimer_now();
+}
+
+static bool capture_file_open(void)
+{
+    uint8_t header[128 + (CAPTURE_INTERFACE_MAX * 128)];
+    size_t len;
+
+    capture_filename_create(Capture_Filename, sizeof(Capture_Filename));
+    pFile = fopen(Capture_Filename, "wb");
+    if (!pFile) {
+        fprintf(stderr, "mstpcap[header]: failed to open %s: %s\n",
+            Capture_Filename, strerror(errno));
+        return false;
+    }
+    /* records are already collected in large batches */
+    setvbuf(pFile, NULL, _IONBF, 0);
+    if (Capture_Pcapng) {
+        len = pcapng_header_encode(header);
+    } else {
+        len = pcap_header_encode(header);
+    }
+    (void)fwrite(header, len, 1, pFile);
+    if (!Pipe_Header_Sent) {
+        capture_pipe_write(header, len);
+        Pipe_Header_Sent = true;
+    }
+    File_Bytes = len;
+    File_Packets = 0;
+    File_Start = time(NULL);
+    capture_ring_file_add(Capture_Filename);
+    if (!Capture_Quiet) {
+        fprintf(stdout, "mstpcap: saving capture to %s\n", Capture_Filename);
+    }
+
+    return true;
+}
+
+static void capture_file_close(void)
+{
+    uint8_t block[PCAPNG_STATISTICS_SIZE];
+    size_t len;
+    unsigned i;
+
+    capture_flush();
+    if (!pFile) {
+        return;
+    }
+    if (Capture_Pcapng) {
+        for (i = 0; i < Capture_Interface_Count; i++) {
+            len = pcapng_statistics_encode(block, i);
+            (void)fwrite(block, len, 1, pFile);
+        }
+    }
+    fflush(pFile);
+#if !defined(_WIN32)
+    (void)fdatasync(fileno(pFile));
+#endif
+    fclose(pFile);
+    pFile = NULL;
+}
+
+static void capture_file_rotate(void)
+{
+    capture_file_close();
+    (void)capture_file_open();
+}
+
+/**
+ * @brief Add a frame to the batch, starting a new file first if the
+ *  current one has reached its packet count or size limit
+ */
+static void capture_record_write(unsigned index,
+    uint32_t ts_sec,
+    uint32_t ts_usec,
+    const uint8_t *frame,
+    uint16_t frame_len)
+{
+    size_t len = capture_record_size(frame_len);
+
+    if (Capture_Pcapng) {
+        /* leave room for the statistics at the end of the file */
+        len += Capture_Interface_Count * PCAPNG_STATISTICS_SIZE;
+    }
+    if (File_Packets &&
+        ((Ring_Packets && (File_Packets >= Ring_Packets)) ||
+            (Ring_Bytes && ((File_Bytes + len) > Ring_Bytes)))) {
+        capture_file_rotate();
+    }
+    if ((Write_Length + len) > sizeof(Write_Buffer)) {
+        capture_flush();
+    }
+    len = capture_record_encode(
+        &Write_Buffer[Write_Length], index, ts_sec, ts_usec, frame, frame_len);
+    Write_Length += len;
+    File_Bytes += len;
+    File_Packets++;
+}
+
+/**
+ * @brief Start a new file once the current one is old enough,
+ *  and write out the batch once it has waited long enough
+ */
+static void capture_timers(void)
+{
+    if (Ring_Seconds && pFile &&
+        ((uint32_t)(time(NULL) - File_Start) >= Ring_Seconds)) {
+        capture_file_rotate();
+    }
+    if (capture_pipe_open()) {
+        /* Wireshark is watching live */
+        capture_flush();
+    } else if ((mstimer_now() - Flush_Time) >= CAPTURE_FLUSH_INTERVAL) {
+        capture_flush();
+    }
+}
+
+#if CAPTURE_WRITER_THREAD
+/**
+ * @brief Copy a frame into the ring of an interface
+ * @note Only called by the one receive thread of the interface
+ * @return true if the frame fit into the ring
+ */
+static bool capture_ring_put(struct capture_interface *iface,
+    uint32_t ts_sec,
+    uint32_t ts_usec,
+    const uint8_t *frame,
+    uint16_t frame_len)
+{
+    struct capture_record *record;
+    uint32_t head, tail, offset, size, wrap = 0;
+
+    size = CAPTURE_RECORD_SIZE(frame_len);
+    head = iface->head;
+    tail = CAPTURE_LOAD(&iface->tail);
+    offset = head & (CAPTURE_RING_SIZE - 1);
+    if ((CAPTURE_RING_SIZE - offset) < size) {
+        /* records are contiguous - skip the rest of the ring */
+        wrap = CAPTURE_RING_SIZE - offset;
+    }
+    if ((CAPTURE_RING_SIZE - (head - tail)) < (wrap + size)) {
+        return false;
+    }
+    if (wrap) {
+        record = (struct capture_record *)&iface->ring[offset];
+        record->length = CAPTURE_RECORD_WRAP;
+        head += wrap;
+        offset = 0;
+    }
+    record = (struct capture_record *)&iface->ring[offset];
+    record->length = frame_len;
+    record->ts_sec = ts_sec;
+    record->ts_usec = ts_usec;
+    memcpy(&record[1], frame, frame_len);
+    CAPTURE_STORE(&iface->head, head + size);
+
+    return true;
+}
+
+/**
+ * @brief Oldest frame in the ring of an interface
+ * @note Only called by the writer thread
+ * @return the record, or NULL if the ring is empty
+ */
+static struct capture_record *capture_ring_peek(
+    struct capture_interface *iface)
+{
+    struct capture_record *record;
+    uint32_t head, offset;
+
+    head = CAPTURE_LOAD(&iface->head);
+    while (iface->tail != head) {
+        offset = iface->tail & (CAPTURE_RING_SIZE - 1);
+        record = (struct capture_record *)&iface->ring[offset];
+        if (record->length != CAPTURE_RECORD_WRAP) {
+            return record;
+        }
+        CAPTURE_STORE(&iface->tail, iface->tail + (CAPTURE_RING_SIZE - offset));
+    }
+
+    return NULL;
+}
+
+static void capture_ring_pop(
+    struct capture_interface *iface, struct capture_record *record)
+{
+    CAPTURE_STORE(
+        &iface->tail, iface->tail + CAPTURE_RECORD_SIZE(record->length));
+}
+
+/**
+ * @brief Write out every frame waiting in the rings, in time order
+ * @return number of frames written
+ */
+static unsigned capture_ring_drain(void)
+{
+    struct capture_record *record, *oldest;
+    unsigned i, index = 0;
+    unsigned count = 0;
+
+    for (;;) {
+        oldest = NULL;
+        for (i = 0; i < Capture_Interface_Count; i++) {
+            record = capture_ring_peek(&Capture_Interface[i]);
+            if (!record) {
+                continue;
+            }
+            if (!oldest || (record->ts_sec < oldest->ts_sec) ||
+                ((record->ts_sec == oldest->ts_sec) &&
+                    (record->ts_usec < oldest->ts_usec))) {
+                oldest = record;
+                index = i;
+            }
+        }
+        if (!oldest) {
+            break;
+        }
+        capture_record_write(index, oldest->ts_sec, oldest->ts_usec,
+            (uint8_t *)&oldest[1], (uint16_t)oldest->length);
+        capture_ring_pop(&Capture_Interface[index], oldest);
+        count++;
+    }
+
+    return count;
+}
+
+static void *capture_writer_thread(void *arg)
+{
+    struct timespec idle = { 0, 5000000L };
+    bool stop;
+
+    (void)arg;
+    for (;;) {
+        /* once asked to stop, drain the rings one last time */
+        stop = CAPTURE_LOAD(&Writer_Stop);
+        if ((capture_ring_drain() == 0) && !stop) {
+            nanosleep(&idle, NULL);
+        }
+        capture_timers();
+        if (stop) {
+            break;
+        }
+    }
+
+    return NULL;
+}
+#endif
+
+/**
+ * @brief Add a serial interface to the capture
+ * @note Interfaces are added before capture_start()
+ * @param name - name of the serial interface
+ * @param baud - baud rate of the interface
+ * @return interface index, or -1 if no more interfaces can be added
+ */
+int capture_interface_add(const char *name, uint32_t baud)
+{
+    struct capture_interface *iface;
+
+    if (Capture_Interface_Count >= CAPTURE_INTERFACE_MAX) {
+        return -1;
+    }
+    iface = &Capture_Interface[Capture_Interface_Count];
+    snprintf(iface->name, sizeof(iface->name), "%s", name ? name : "");
+    iface->baud = baud;
+#if CAPTURE_WRITER_THREAD
+    iface->ring = malloc(CAPTURE_RING_SIZE);
+    if (!iface->ring) {
+        return -1;
+    }
+#endif
+
+    return (int)Capture_Interface_Count++;
+}
+
+/**
+ * @brief Number of serial interfaces in the capture
+ * @return number of interfaces
+ */
+unsigned capture_interface_count(void)
+{
+    return Capture_Interface_Count;
+}
+
+/**
+ * @brief Number of frames of an interface that were lost
+ *  because the writer could not keep up
+ * @param index - interface index
+ * @return number of frames dropped
+ */
+uint32_t capture_interface_dropped(unsigned index)
+{
+    if (index < Capture_Interface_Count) {
+        return CAPTURE_LOAD(&Capture_Interface[index].dropped);
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Write pcapng rather than libpcap files. More than one
+ *  interface always uses pcapng.
+ * @param enable - true for pcapng
+ */
+void capture_pcapng_set(bool enable)
+{
+    Capture_Pcapng = enable;
+}
+
+/**
+ * @brief Do not print progress to stdout, e.g. for Wireshark ExtCap
+ * @param enable - true for no output
+ */
+void capture_quiet_set(bool enable)
+{
+    Capture_Quiet = enable;
+}
+
+/**
+ * @brief Start a new file after this many packets
+ * @param packets - packets per file, or zero for no limit
+ */
+void capture_ring_packets_set(uint32_t packets)
+{
+    Ring_Packets = packets;
+}
+
+/**
+ * @brief Start a new file before it grows beyond this size
+ * @param bytes - maximum file size, or zero for no limit
+ */
+void capture_ring_size_set(uint64_t bytes)
+{
+    Ring_Bytes = bytes;
+}
+
+/**
+ * @brief Start a new file once the current one is this old
+ * @param seconds - maximum age of a file, or zero for no limit
+ */
+void capture_ring_time_set(uint32_t seconds)
+{
+    Ring_Seconds = seconds;
+}
+
+/**
+ * @brief Keep only this many of the newest files
+ * @param files - number of files, or zero to keep them all
+ */
+void capture_ring_files_set(unsigned files)
+{
+    Ring_Files = files;
+}
+
+/**
+ * @brief Open the first capture file and start the writer
+ * @return true if the capture was started
+ */
+bool capture_start(void)
+{
+    if (Capture_Interface_Count == 0) {
+        return false;
+    }
+    if (Capture_Interface_Count > 1) {
+        /* libpcap has no interface identifier */
+        Capture_Pcapng = true;
+    }
+    if (Ring_Files) {
+        Ring_Filename = calloc(Ring_Files, sizeof(*Ring_Filename));
+        if (!Ring_Filename) {
+            return false;
+        }
+    }
+    Flush_Time = mstimer_now();
+    if (!capture_file_open()) {
+        return false;
+    }
+#if CAPTURE_WRITER_THREAD
+    if (pthread_create(&Writer_Thread, NULL, capture_writer_thread, NULL) !=
+        0) {
+        perror("mstpcap: writer thread");
+        return false;
+    }
+    Writer_Running = true;
+#endif
+
+    return true;
+}
+
+/**
+ * @brief Hand a received frame to the writer
+ * @note Each interface may have its own receive thread,
+ *  but only one thread may use a given interface index.
+ * @param index - interface index
+ * @param ts_sec - time stamp of the frame, seconds
+ * @param ts_usec - time stamp of the frame, microseconds
+ * @param frame - frame as it was on the wire
+ * @param frame_len - number of octets in the frame
+ * @return true if the frame was queued, false if it was dropped
+ */
+bool capture_packet(unsigned index,
+    uint32_t ts_sec,
+    uint32_t ts_usec,
+    const uint8_t *frame,
+    uint16_t frame_len)
+{
+    struct capture_interface *iface;
+    bool status = false;
+
+    if (index >= Capture_Interface_Count) {
+        return false;
+    }
+    iface = &Capture_Interface[index];
+#if CAPTURE_WRITER_THREAD
+    if (Writer_Running) {
+        status = capture_ring_put(iface, ts_sec, ts_usec, frame, frame_len);
+    }
+#else
+    capture_record_write(index, ts_sec, ts_usec, frame, frame_len);
+    capture_timers();
+    status = true;
+#endif
+    if (status) {
+        CAPTURE_STORE(&iface->received, iface->received + 1);
+    } else {
+        CAPTURE_STORE(&iface->dropped, iface->dropped + 1);
+    }
+
+    return status;
+}
+
+/**
+ * @brief Write out every queued frame, close the capture file
+ *  and the pipe
+ */
+void capture_stop(void)
+{
+#if CAPTURE_WRITER_THREAD
+    if (Writer_Running) {
+        CAPTURE_STORE(&Writer_Stop, true);
+        pthread_join(Writer_Thread, NULL);
+        Writer_Running = false;
+    }
+#endif
+    capture_file_close();
+    capture_pipe_close();
+}
@@ -0,0 +1,100 @@
+/**
+ * @file
+ * @date October 2026
+ * @brief MS/TP capture file writer for pcap and pcapng ring files
+ *
+ * @section LICENSE
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#ifndef MSTPCAP_CAPTURE_H
+#define MSTPCAP_CAPTURE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+/* define our Data Link Type for libPCAP */
+#define DLT_BACNET_MS_TP 165
+
+/* number of serial interfaces that can be captured at once */
+#ifndef CAPTURE_INTERFACE_MAX
+#define CAPTURE_INTERFACE_MAX 8
+#endif
+/* receive thread to writer thread hand-off, per interface.
+   Must be a power of two. One MiB holds over a minute of
+   a 115200 bps trunk running flat out. */
+#ifndef CAPTURE_RING_SIZE
+#define CAPTURE_RING_SIZE (1UL << 20)
+#endif
+/* frames are collected and written to the file in batches */
+#ifndef CAPTURE_WRITE_BUFFER_SIZE
+#define CAPTURE_WRITE_BUFFER_SIZE (256UL * 1024UL)
+#endif
+/* milliseconds a frame may wait in the batch before it is written */
+#ifndef CAPTURE_FLUSH_INTERVAL
+#define CAPTURE_FLUSH_INTERVAL 1000
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+    int capture_interface_add(
+        const char *name,
+        uint32_t baud);
+    unsigned capture_interface_count(
+        void);
+    uint32_t capture_interface_dropped(
+        unsigned index);
+
+    void capture_pcapng_set(
+        bool enable);
+    void capture_quiet_set(
+        bool enable);
+    void capture_ring_packets_set(
+        uint32_t packets);
+    void capture_ring_size_set(
+        uint64_t bytes);
+    void capture_ring_time_set(
+        uint32_t seconds);
+    void capture_ring_files_set(
+        unsigned files);
+
+    bool capture_pipe_create(
+        const char *name);
+    void capture_pipe_close(
+        void);
+
+    bool capture_start(
+        void);
+    bool capture_packet(
+        unsigned index,
+        uint32_t ts_sec,
+        uint32_t ts_usec,
+        const uint8_t *frame,
+        uint16_t frame_len);
+    void capture_stop(
+        void);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+#endif
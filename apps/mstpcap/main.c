@@ -52,13 +52,15 @@
 /* OS specific includes */
 #include "bacport.h"
 #include "rs485.h"
+#include "capture.h"
+#if !defined(_WIN32)
+#include <termios.h>
+#endif
 
 #ifdef _WIN32
 #define strncasecmp(x, y, z) _strnicmp(x, y, z)
 #endif
 
-/* define our Data Link Type for libPCAP */
-#define DLT_BACNET_MS_TP 165
 /* local min/max macros */
 #ifndef max
 #define max(a, b) (((a)(b)) ? (a) : (b))
@@ -435,222 +437,116 @@ uint16_t MSTP_Get_Reply(
     return 0;
 }
 
-static char Capture_Filename[64] = "mstp_20090123091200.cap";
-static FILE *pFile = NULL; /* stream pointer */
-#if defined(_WIN32)
-static HANDLE hPipe = INVALID_HANDLE_VALUE; /* pipe handle */
-static void named_pipe_create(char *pipe_name)
-{
-    if (!Wireshark_Capture) {
-        fprintf(stdout, "mstpcap: Creating Named Pipe \"%s\"\n", pipe_name);
-    }
-    /* create the pipe */
-    while (hPipe == INVALID_HANDLE_VALUE) {
-        /* use CreateFile rather than CreateNamedPipe */
-        hPipe = CreateFile(pipe_name, GENERIC_READ | GENERIC_WRITE, 0, NULL,
-            OPEN_EXISTING, 0, NULL);
-        if (hPipe != INVALID_HANDLE_VALUE) {
-            break;
-        }
-        /* if an error occured at handle creation */
-        if (!WaitNamedPipe(pipe_name, 20000)) {
-            printf("Could not open pipe: waited for 20sec!\n"
-                   "If this message was issued before the 20sec finished,\n"
-                   "then the pipe doesn't exist!\n");
-            Exit_Requested = true;
-            return;
-        }
-    }
-    ConnectNamedPipe(hPipe, NULL);
-}
+static FILE *pFile = NULL; /* stream pointer of a scanned file */
 
-static size_t data_write(const void *ptr, size_t size, size_t nitems)
+static void write_received_packet(volatile struct mstp_port_struct_t *mstp_port,
+    size_t header_len,
+    unsigned interface)
 {
-    DWORD cbWritten = 0;
-    if (hPipe != INVALID_HANDLE_VALUE) {
-        (void)WriteFile(hPipe, /* handle to pipe  */
-            ptr, /* buffer to write from  */
-            size * nitems, /* number of bytes to write  */
-            &cbWritten, /* number of bytes written  */
-            NULL); /* not overlapped I/O  */
-    }
-
-    return fwrite(ptr, size, nitems, pFile);
-}
+    uint8_t frame[MSTP_HEADER_MAX + DLMSTP_MPDU_MAX + 2];
+    uint16_t frame_len = 0;
+    struct timeval tv;
+    size_t max_data = 0;
 
-static size_t data_write_header(
-    const void *ptr, size_t size, size_t nitems, bool pipe_enable)
-{
-    DWORD cbWritten = 0;
-    if (pipe_enable && (hPipe != INVALID_HANDLE_VALUE)) {
-        (void)WriteFile(hPipe, /* handle to pipe  */
-            ptr, /* buffer to write from  */
-            size * nitems, /* number of bytes to write  */
-            &cbWritten, /* number of bytes written  */
-            NULL); /* not overlapped I/O  */
+    gettimeofday(&tv, NULL);
+    if ((interface == 0) &&
+        ((mstp_port->ReceivedValidFrame) ||
+            (mstp_port->ReceivedValidFrameNotForUs))) {
+        packet_statistics(&tv, mstp_port);
     }
-
-    return fwrite(ptr, size, nitems, pFile);
-}
-#else
-static int FD_Pipe = -1;
-static void named_pipe_create(char *name)
-{
-    int rv = 0;
-    rv = mkfifo(name, 0666);
-    if ((rv == -1) && (errno != EEXIST)) {
-        perror("Error creating named pipe");
-        exit(1);
+    if ((mstp_port->ReceivedValidFrame) &&
+        (mstp_port->FrameType >= Nmin_COBS_type) &&
+        (mstp_port->FrameType <= Nmax_COBS_type)) {
+        /* extended frame data was decoded in place: capture the
+           frame as it was on the wire by encoding it again */
+        frame_len = MSTP_Create_Frame(frame, sizeof(frame),
+            mstp_port->FrameType, mstp_port->DestinationAddress,
+            mstp_port->SourceAddress, mstp_port->InputBuffer,
+            mstp_port->DataLength);
+        (void)capture_packet(interface, (uint32_t)tv.tv_sec,
+            (uint32_t)tv.tv_usec, frame, frame_len);
+        return;
     }
-    FD_Pipe = open(name, O_WRONLY);
-    if (FD_Pipe == -1) {
-        perror("Error connecting to named pipe");
-        exit(1);
+    if (mstp_port->ReceivedInvalidFrame) {
+        if (mstp_port->Index) {
+            max_data = min(mstp_port->InputBufferSize, mstp_port->Index);
+        }
+    } else if (mstp_port->DataLength) {
+        max_data = min(mstp_port->InputBufferSize, mstp_port->DataLength);
     }
-}
-
-static size_t data_write(const void *ptr, size_t size, size_t nitems)
-{
-    ssize_t bytes = 0;
-    if (FD_Pipe != -1) {
-        bytes = write(FD_Pipe, ptr, size * nitems);
-        (void)bytes;
+    max_data = min(max_data, DLMSTP_MPDU_MAX);
+    if (header_len == 1) {
+        frame[0] = mstp_port->DataRegister;
+    } else if (header_len == 2) {
+        frame[0] = 0x55;
+        frame[1] = mstp_port->DataRegister;
+    } else {
+        frame[0] = 0x55;
+        frame[1] = 0xFF;
+        frame[2] = mstp_port->FrameType;
+        frame[3] = mstp_port->DestinationAddress;
+        frame[4] = mstp_port->SourceAddress;
+        frame[5] = HI_BYTE(mstp_port->DataLength);
+        frame[6] = LO_BYTE(mstp_port->DataLength);
+        frame[7] = mstp_port->HeaderCRCActual;
     }
-    return fwrite(ptr, size, nitems, pFile);
-}
-
-static size_t data_write_header(
-    const void *ptr, size_t size, size_t nitems, bool pipe_enable)
-{
-    ssize_t bytes = 0;
-    if (pipe_enable && (FD_Pipe != -1)) {
-        bytes = write(FD_Pipe, ptr, size * nitems);
-        (void)bytes;
+    frame_len = header_len;
+    if (max_data) {
+        memcpy(&frame[frame_len], mstp_port->InputBuffer, max_data);
+        frame_len += max_data;
+        frame[frame_len++] = mstp_port->DataCRCActualMSB;
+        frame[frame_len++] = mstp_port->DataCRCActualLSB;
     }
-    return fwrite(ptr, size, nitems, pFile);
+    (void)capture_packet(
+        interface, (uint32_t)tv.tv_sec, (uint32_t)tv.tv_usec, frame, frame_len);
 }
-#endif
 
-static void filename_create(char *filename)
+/* pcapng blocks that the scan needs to know about */
+#define PCAPNG_SECTION_HEADER_BLOCK 0x0A0D0D0AUL
+#define PCAPNG_INTERFACE_DESCRIPTION_BLOCK 0x00000001UL
+#define PCAPNG_ENHANCED_PACKET_BLOCK 0x00000006UL
+#define PCAPNG_BYTE_ORDER_MAGIC 0x1A2B3C4DUL
+/* the scanned file is pcapng rather than libpcap */
+static bool Scan_Pcapng;
+
+/* skip the rest of a pcapng block */
+static bool skip_pcapng_block(long len)
 {
-    BACNET_DATE bdate;
-    BACNET_TIME btime;
-
-    if (filename) {
-        datetime_local(&bdate, &btime, NULL, NULL);
-        sprintf(filename, "mstp_%04d%02d%02d%02d%02d%02d.cap", (int)bdate.year,
-            (int)bdate.month, (int)bdate.day, (int)btime.hour, (int)btime.min,
-            (int)btime.sec);
+    if (len < 0) {
+        return false;
     }
+
+    return fseek(pFile, len, SEEK_CUR) == 0;
 }
 
-/* write packet to file in libpcap format */
-static void write_global_header(const char *filename)
+/* read the rest of a pcapng section header block */
+static bool test_pcapng_header(void)
 {
-    static bool pipe_enable = true; /* don't write more than one header */
-    uint32_t magic_number = 0xa1b2c3d4; /* magic number */
-    uint16_t version_major = 2; /* major version number */
-    uint16_t version_minor = 4; /* minor version number */
-    int32_t thiszone = 0; /* GMT to local correction */
-    uint32_t sigfigs = 0; /* accuracy of timestamps */
-    uint32_t snaplen = 65535; /* max length of captured packets, in octets */
-    uint32_t network = DLT_BACNET_MS_TP; /* data link type - BACNET_MS_TP */
+    uint32_t block_len = 0;
+    uint32_t byte_order = 0;
+    size_t count = 0;
 
-    /* create a new file. */
-    pFile = fopen(filename, "wb");
-    if (pFile) {
-        (void)data_write_header(
-            &magic_number, sizeof(magic_number), 1, pipe_enable);
-        (void)data_write_header(
-            &version_major, sizeof(version_major), 1, pipe_enable);
-        (void)data_write_header(
-            &version_minor, sizeof(version_minor), 1, pipe_enable);
-        (void)data_write_header(&thiszone, sizeof(thiszone), 1, pipe_enable);
-        (void)data_write_header(&sigfigs, sizeof(sigfigs), 1, pipe_enable);
-        (void)data_write_header(&snaplen, sizeof(snaplen), 1, pipe_enable);
-        (void)data_write_header(&network, sizeof(network), 1, pipe_enable);
-        fflush(pFile);
-        if (!Wireshark_Capture) {
-            fprintf(stdout, "mstpcap: saving capture to %s\n", filename);
-        }
-    } else {
-        fprintf(stderr, "mstpcap[header]: failed to open %s: %s\n", filename,
-            strerror(errno));
+    count = fread(&block_len, sizeof(block_len), 1, pFile);
+    if (count == 1) {
+        count = fread(&byte_order, sizeof(byte_order), 1, pFile);
     }
-    if (pipe_enable) {
-        pipe_enable = false;
+    if ((count != 1) || (byte_order != PCAPNG_BYTE_ORDER_MAGIC)) {
+        fprintf(stderr, "mstpcap: invalid pcapng byte order\n");
+        fclose(pFile);
+        pFile = NULL;
+        return false;
     }
-}
-
-static void write_received_packet(
-    volatile struct mstp_port_struct_t *mstp_port, size_t header_len)
-{
-    uint32_t ts_sec = 0; /* timestamp seconds */
-    uint32_t ts_usec = 0; /* timestamp microseconds */
-    uint32_t incl_len = 0; /* number of octets of packet saved in file */
-    uint32_t orig_len = 0; /* actual length of packet */
-    uint8_t header[MSTP_HEADER_MAX] = { 0 }; /* MS/TP header */
-    struct timeval tv;
-    size_t max_data = 0;
-
-    if (pFile) {
-        gettimeofday(&tv, NULL);
-        ts_sec = tv.tv_sec;
-        ts_usec = tv.tv_usec;
-        if ((mstp_port->ReceivedValidFrame) ||
-            (mstp_port->ReceivedValidFrameNotForUs)) {
-            packet_statistics(&tv, mstp_port);
-        }
-        (void)data_write(&ts_sec, sizeof(ts_sec), 1);
-        (void)data_write(&ts_usec, sizeof(ts_usec), 1);
-        if (mstp_port->ReceivedInvalidFrame) {
-            if (mstp_port->Index) {
-                max_data = min(mstp_port->InputBufferSize, mstp_port->Index);
-                incl_len = orig_len = header_len + max_data + 2 /* checksum*/;
-            } else {
-                /* header only */
-                incl_len = orig_len = header_len;
-            }
-        } else {
-            if (mstp_port->DataLength) {
-                max_data =
-                    min(mstp_port->InputBufferSize, mstp_port->DataLength);
-                incl_len = orig_len = header_len + max_data + 2 /* checksum*/;
-            } else {
-                /* header only - or at least some bytes of the header */
-                incl_len = orig_len = header_len;
-            }
-        }
-        (void)data_write(&incl_len, sizeof(incl_len), 1);
-        (void)data_write(&orig_len, sizeof(orig_len), 1);
-        if (header_len == 1) {
-            header[0] = mstp_port->DataRegister;
-        } else if (header_len == 2) {
-            header[0] = 0x55;
-            header[1] = mstp_port->DataRegister;
-        } else {
-            header[0] = 0x55;
-            header[1] = 0xFF;
-            header[2] = mstp_port->FrameType;
-            header[3] = mstp_port->DestinationAddress;
-            header[4] = mstp_port->SourceAddress;
-            header[5] = HI_BYTE(mstp_port->DataLength);
-            header[6] = LO_BYTE(mstp_port->DataLength);
-            header[7] = mstp_port->HeaderCRCActual;
-        }
-        (void)data_write(header, header_len, 1);
-        if (max_data) {
-            (void)data_write(mstp_port->InputBuffer, max_data, 1);
-            (void)data_write((char *)&mstp_port->DataCRCActualMSB, 1, 1);
-            (void)data_write((char *)&mstp_port->DataCRCActualLSB, 1, 1);
-        }
-    } else {
-        fprintf(stderr, "mstpcap[packet]: failed to open %s: %s\n",
-            Capture_Filename, strerror(errno));
+    if (!skip_pcapng_block((long)block_len - 12)) {
+        fclose(pFile);
+        pFile = NULL;
+        return false;
     }
+    Scan_Pcapng = true;
+
+    return true;
 }
 
-/* read header from file in libpcap format */
+/* read header from file in libpcap or pcapng format */
 static bool test_global_header(const char *filename)
 {
     uint32_t magic_number = 0; /* magic number */
@@ -666,6 +562,10 @@ static bool test_global_header(const char *filename)
     pFile = fopen(filename, "rb");
     if (pFile) {
         count = fread(&magic_number, sizeof(magic_number), 1, pFile);
+        if ((count == 1) && (magic_number == PCAPNG_SECTION_HEADER_BLOCK)) {
+            return test_pcapng_header();
+        }
+        Scan_Pcapng = false;
         if ((count != 1) || (magic_number != 0xa1b2c3d4)) {
             fprintf(stderr, "mstpcap: invalid magic number\n");
             fclose(pFile);
@@ -723,40 +623,74 @@ static bool test_global_header(const char *filename)
     return true;
 }
 
-static bool read_received_packet(volatile struct mstp_port_struct_t *mstp_port)
+/* read the fields of the next packet record - libpcap or pcapng */
+static bool read_packet_record(
+    struct timeval *tv, uint32_t *orig_len, long *block_remaining)
 {
-    uint32_t ts_sec = 0; /* timestamp seconds */
-    uint32_t ts_usec = 0; /* timestamp microseconds */
-    uint32_t incl_len = 0; /* number of octets of packet saved in file */
-    uint32_t orig_len = 0; /* actual length of packet */
-    uint8_t header[8] = { 0 }; /* MS/TP header */
-    struct timeval tv;
+    uint32_t record[5] = { 0 };
+    uint32_t block_type = 0;
+    uint32_t block_len = 0;
+    uint64_t timestamp = 0;
     size_t count = 0;
-    unsigned i = 0;
 
-    if (pFile) {
-        count = fread(&ts_sec, sizeof(ts_sec), 1, pFile);
-        if (count != 1) {
-            fclose(pFile);
-            pFile = NULL;
+    if (!Scan_Pcapng) {
+        /* ts_sec, ts_usec, incl_len, orig_len */
+        count = fread(record, sizeof(record[0]), 4, pFile);
+        if (count != 4) {
             return false;
         }
-        count = fread(&ts_usec, sizeof(ts_usec), 1, pFile);
-        if (count != 1) {
-            fclose(pFile);
-            pFile = NULL;
+        tv->tv_sec = record[0];
+        tv->tv_usec = record[1];
+        *orig_len = record[3];
+        *block_remaining = 0;
+        return true;
+    }
+    for (;;) {
+        count = fread(&block_type, sizeof(block_type), 1, pFile);
+        if (count == 1) {
+            count = fread(&block_len, sizeof(block_len), 1, pFile);
+        }
+        if ((count != 1) || (block_len < 12)) {
             return false;
         }
-        tv.tv_sec = ts_sec;
-        tv.tv_usec = ts_usec;
-        count = fread(&incl_len, sizeof(incl_len), 1, pFile);
-        if (count != 1) {
-            fclose(pFile);
-            pFile = NULL;
+        if (block_type == PCAPNG_ENHANCED_PACKET_BLOCK) {
+            /* interface, timestamp high and low, captured and
+               original length */
+            count = fread(record, sizeof(record[0]), 5, pFile);
+            if ((count != 5) || (block_len < 32)) {
+                return false;
+            }
+            if (record[0] == 0) {
+                /* statistics are kept for the first interface */
+                break;
+            }
+            if (!skip_pcapng_block((long)block_len - 28)) {
+                return false;
+            }
+        } else if (!skip_pcapng_block((long)block_len - 8)) {
             return false;
         }
-        count = fread(&orig_len, sizeof(orig_len), 1, pFile);
-        if (count != 1) {
+    }
+    timestamp = ((uint64_t)record[1] << 32) | record[2];
+    tv->tv_sec = (long)(timestamp / 1000000ULL);
+    tv->tv_usec = (long)(timestamp % 1000000ULL);
+    *orig_len = record[3];
+    *block_remaining = (long)block_len - 28;
+
+    return true;
+}
+
+static bool read_received_packet(volatile struct mstp_port_struct_t *mstp_port)
+{
+    uint32_t orig_len = 0; /* actual length of packet */
+    uint8_t header[8] = { 0 }; /* MS/TP header */
+    struct timeval tv;
+    long block_remaining = 0;
+    size_t count = 0;
+    unsigned i = 0;
+
+    if (pFile) {
+        if (!read_packet_record(&tv, &orig_len, &block_remaining)) {
             fclose(pFile);
             pFile = NULL;
             return false;
@@ -810,11 +744,8 @@ static bool read_received_packet(volatile struct mstp_port_struct_t *mstp_port)
                 pFile = NULL;
                 return false;
             }
-            mstp_port->DataCRC = 0xFFFF;
-            for (i = 0; i < mstp_port->DataLength; i++) {
-                mstp_port->DataCRC = CRC_Calc_Data(
-                    mstp_port->InputBuffer[i], mstp_port->DataCRC);
-            }
+            mstp_port->DataCRC = CRC_Calc_Data_Buffer(
+                mstp_port->InputBuffer, mstp_port->DataLength, 0xFFFF);
             mstp_port->DataCRC =
                 CRC_Calc_Data(mstp_port->DataCRCActualMSB, mstp_port->DataCRC);
             mstp_port->DataCRC =
@@ -831,6 +762,18 @@ static bool read_received_packet(volatile struct mstp_port_struct_t *mstp_port)
         } else {
             mstp_port->DataLength = 0;
         }
+        if (Scan_Pcapng) {
+            /* padding, options and the trailing block length */
+            block_remaining -= sizeof(header);
+            if (orig_len > 8) {
+                block_remaining -= orig_len - 8;
+            }
+            if (!skip_pcapng_block(block_remaining)) {
+                fclose(pFile);
+                pFile = NULL;
+                return false;
+            }
+        }
         if (mstp_port->ReceivedInvalidFrame) {
             Invalid_Frame_Count++;
         } else if ((mstp_port->ReceivedValidFrame) ||
@@ -844,29 +787,11 @@ static bool read_received_packet(volatile struct mstp_port_struct_t *mstp_port)
     return true;
 }
 
-static void cleanup(void)
-{
-    if (!Wireshark_Capture) {
-        packet_statistics_print();
-    }
-    if (pFile) {
-        fflush(pFile); /* stream pointer */
-        fclose(pFile); /* stream pointer */
-    }
-    pFile = NULL;
-}
-
 #if defined(_WIN32)
 static BOOL WINAPI CtrlCHandler(DWORD dwCtrlType)
 {
     dwCtrlType = dwCtrlType;
 
-    if (hPipe != INVALID_HANDLE_VALUE) {
-        FlushFileBuffers(hPipe);
-        DisconnectNamedPipe(hPipe);
-        CloseHandle(hPipe);
-        hPipe = INVALID_HANDLE_VALUE;
-    }
     /* signal to main loop to exit */
     Exit_Requested = true;
     while (Exit_Requested) {
@@ -880,9 +805,7 @@ static BOOL WINAPI CtrlCHandler(DWORD dwCtrlType)
 static void sig_int(int signo)
 {
     (void)signo;
-    if (FD_Pipe != -1) {
-        close(FD_Pipe);
-    }
+    /* the pipe is closed by cleanup() once the queued frames are written */
     Exit_Requested = true;
     exit(0);
 }
@@ -895,16 +818,6 @@ static void signal_init(void)
 }
 #endif
 
-static void filename_create_new(void)
-{
-    if (pFile) {
-        fclose(pFile);
-    }
-    pFile = NULL;
-    filename_create(&Capture_Filename[0]);
-    write_global_header(&Capture_Filename[0]);
-}
-
 static void print_usage(char *filename)
 {
     printf("Usage: %s", filename);
@@ -912,13 +825,16 @@ static void print_usage(char *filename)
     printf(" [--extcap-interface port]\n");
     printf(" [--extcap-interfaces][--extcap-dlts][--extcap-config]\n");
     printf(" [--capture][--baud baud][--fifo pipe]\n");
+    printf(" [--pcapng][--trunk port[,baud]]\n");
+    printf(" [--ring-size MB][--ring-time seconds][--ring-files count]\n");
     printf(" [--version][--help]\n");
 }
 
 static void print_help(char *filename)
 {
     printf("%s --scan <filename>\n"
-           "perform statistic analysis on MS/TP capture file.\n",
+           "perform statistic analysis on MS/TP capture file.\n"
+           "The first interface of a pcapng file is analyzed.\n",
         filename);
     printf("\n");
     printf("Captures MS/TP packets from a serial interface\n"
@@ -942,7 +858,18 @@ static void print_help(char *filename)
 #else
            "    Supported values: any file name\n"
 #endif
-           "    Use that name as the interface name in Wireshark.\n");
+           "    Use that name as the interface name in Wireshark.\n"
+           "[--pcapng] - save packets in pcapng rather than libpcap format.\n"
+#if !defined(_WIN32)
+           "[--trunk port[,baud]] - also capture another serial interface.\n"
+           "    May be repeated. The baud rate defaults to --baud, and\n"
+           "    76800 is not supported. Trunks are saved as pcapng, with\n"
+           "    one interface each. Statistics are for the first interface.\n"
+#endif
+           "[--ring-size MB] - start a new file when a file reaches MB.\n"
+           "[--ring-time seconds] - start a new file after seconds.\n"
+           "    Either one replaces the new file after 65535 packets.\n"
+           "[--ring-files count] - keep only the newest count files.\n");
     printf("\n");
     printf("%s [--extcap-interfaces][--extcap-dlts][--extcap-config]\n"
            "[--capture][--baud baud][--fifo pipe]\n"
@@ -969,15 +896,333 @@ static void mstp_structure_init(volatile struct mstp_port_struct_t *mstp_port)
     }
 }
 
+/**
+ * @brief Capture the frame, or the invalid octets, that the receive
+ *  state machine found
+ * @param mstp_port - port of the receive state machine
+ * @param receive_state - receive state of the previous call, updated
+ * @param interface - capture interface of the port
+ * @param invalid_count - invalid frame counter of the port
+ * @return true if a frame was counted as a packet
+ */
+static bool mstp_frame_capture(volatile struct mstp_port_struct_t *mstp_port,
+    MSTP_RECEIVE_STATE *receive_state,
+    unsigned interface,
+    uint32_t *invalid_count)
+{
+    uint32_t header_len = 0;
+    bool packet = false;
+
+    /* process the data portion of the frame */
+    if (mstp_port->ReceivedValidFrame) {
+        write_received_packet(mstp_port, MSTP_HEADER_MAX, interface);
+        mstp_structure_init(mstp_port);
+        packet = true;
+    } else if (mstp_port->ReceivedValidFrameNotForUs) {
+        write_received_packet(mstp_port, MSTP_HEADER_MAX, interface);
+        mstp_structure_init(mstp_port);
+        packet = true;
+    } else if (mstp_port->ReceivedInvalidFrame) {
+        if (*receive_state == MSTP_RECEIVE_STATE_HEADER) {
+            mstp_port->Index = 0;
+        }
+        write_received_packet(mstp_port, MSTP_HEADER_MAX, interface);
+        mstp_structure_init(mstp_port);
+        (*invalid_count)++;
+        packet = true;
+    } else if (mstp_port->receive_state == MSTP_RECEIVE_STATE_IDLE) {
+        if (*receive_state == MSTP_RECEIVE_STATE_IDLE) {
+            if ((mstp_port->EventCount == 1) &&
+                (mstp_port->DataRegister == 0xFF)) {
+                /* 0xFF padding at end of message is allowed */
+                mstp_structure_init(mstp_port);
+            } else if (mstp_port->EventCount > 1) {
+                write_received_packet(mstp_port, 1, interface);
+                mstp_structure_init(mstp_port);
+                (*invalid_count)++;
+            }
+        } else {
+            /* invalid byte or timeout */
+            if (*receive_state == MSTP_RECEIVE_STATE_PREAMBLE) {
+                if (mstp_port->EventCount) {
+                    header_len = 1;
+                } else {
+                    header_len = 2;
+                }
+            } else {
+                header_len = 3 + mstp_port->Index;
+            }
+            write_received_packet(mstp_port, header_len, interface);
+            mstp_structure_init(mstp_port);
+            (*invalid_count)++;
+        }
+    }
+    /* track the packetizer state */
+    *receive_state = mstp_port->receive_state;
+
+    return packet;
+}
+
+#if !defined(_WIN32)
+/* additional MS/TP trunks, each captured by its own receive thread */
+struct mstp_trunk {
+    volatile struct mstp_port_struct_t port;
+    uint8_t rx_buffer[DLMSTP_MPDU_MAX];
+    uint8_t tx_buffer[DLMSTP_MPDU_MAX];
+    struct mstimer silence_timer;
+    MSTP_RECEIVE_STATE receive_state;
+    char *name;
+    uint32_t baud;
+    unsigned interface;
+    int fd;
+    pthread_t thread;
+    uint32_t packet_count;
+    uint32_t invalid_count;
+};
+#define MSTP_TRUNK_MAX (CAPTURE_INTERFACE_MAX - 1)
+static struct mstp_trunk MSTP_Trunk[MSTP_TRUNK_MAX];
+static unsigned MSTP_Trunk_Count;
+
+static uint32_t Trunk_Silence(void *pArg)
+{
+    struct mstp_trunk *trunk = (struct mstp_trunk *)pArg;
+
+    return mstimer_elapsed(&trunk->silence_timer);
+}
+
+static void Trunk_Silence_Reset(void *pArg)
+{
+    struct mstp_trunk *trunk = (struct mstp_trunk *)pArg;
+
+    mstimer_set(&trunk->silence_timer, 0);
+}
+
+/**
+ * @brief Add a trunk from a "device[,baud]" command line argument
+ * @param arg - the argument, modified in place
+ * @return true if the trunk was added
+ */
+static bool mstp_trunk_add(char *arg)
+{
+    struct mstp_trunk *trunk;
+    char *baud;
+
+    if (MSTP_Trunk_Count >= MSTP_TRUNK_MAX) {
+        return false;
+    }
+    trunk = &MSTP_Trunk[MSTP_Trunk_Count];
+    baud = strchr(arg, ',');
+    if (baud) {
+        *baud = 0;
+        trunk->baud = strtoul(baud + 1, NULL, 0);
+    }
+    trunk->name = arg;
+    trunk->fd = -1;
+    MSTP_Trunk_Count++;
+
+    return true;
+}
+
+/**
+ * @brief Open a trunk serial port, read only, in raw mode
+ * @param trunk - trunk to open
+ * @return true if the port was opened
+ */
+static bool mstp_trunk_open(struct mstp_trunk *trunk)
+{
+    struct termios tio;
+    speed_t speed;
+
+    switch (trunk->baud) {
+        case 9600:
+            speed = B9600;
+            break;
+        case 19200:
+            speed = B19200;
+            break;
+        case 38400:
+            speed = B38400;
+            break;
+        case 57600:
+            speed = B57600;
+            break;
+        case 115200:
+            speed = B115200;
+            break;
+        default:
+            fprintf(stderr, "mstpcap: %s: %lu bps is not supported\n",
+                trunk->name, (unsigned long)trunk->baud);
+            return false;
+    }
+    trunk->fd = open(trunk->name, O_RDONLY | O_NOCTTY);
+    if (trunk->fd < 0) {
+        perror(trunk->name);
+        return false;
+    }
+    memset(&tio, 0, sizeof(tio));
+    tio.c_cflag = CS8 | CLOCAL | CREAD;
+    cfsetispeed(&tio, speed);
+    cfsetospeed(&tio, speed);
+    tio.c_cc[VMIN] = 0;
+    tio.c_cc[VTIME] = 0;
+    tcsetattr(trunk->fd, TCSAFLUSH, &tio);
+    tcflush(trunk->fd, TCIOFLUSH);
+    trunk->port.InputBuffer = &trunk->rx_buffer[0];
+    trunk->port.InputBufferSize = sizeof(trunk->rx_buffer);
+    trunk->port.OutputBuffer = &trunk->tx_buffer[0];
+    trunk->port.OutputBufferSize = sizeof(trunk->tx_buffer);
+    trunk->port.This_Station = 127;
+    trunk->port.Nmax_info_frames = 1;
+    trunk->port.Nmax_master = 127;
+    trunk->port.SilenceTimer = Trunk_Silence;
+    trunk->port.SilenceTimerReset = Trunk_Silence_Reset;
+    MSTP_Init(&trunk->port);
+    trunk->receive_state = MSTP_RECEIVE_STATE_IDLE;
+
+    return true;
+}
+
+/* receive thread of a trunk */
+static void *mstp_trunk_thread(void *arg)
+{
+    struct mstp_trunk *trunk = (struct mstp_trunk *)arg;
+    volatile struct mstp_port_struct_t *mstp_port = &trunk->port;
+    uint8_t buf[512];
+    struct timeval waiter;
+    fd_set input;
+    ssize_t count = 0;
+    ssize_t i = 0;
+
+    while (!Exit_Requested) {
+        if (i >= count) {
+            i = 0;
+            count = 0;
+            FD_ZERO(&input);
+            FD_SET(trunk->fd, &input);
+            waiter.tv_sec = 0;
+            waiter.tv_usec = 5000;
+            if (select(trunk->fd + 1, &input, NULL, NULL, &waiter) > 0) {
+                count = read(trunk->fd, buf, sizeof(buf));
+                if (count <= 0) {
+                    if ((count < 0) && (errno == EINTR)) {
+                        count = 0;
+                        continue;
+                    }
+                    fprintf(stderr, "mstpcap: %s: receive stopped\n",
+                        trunk->name);
+                    break;
+                }
+            }
+        }
+        if ((i < count) && (!mstp_port->DataAvailable)) {
+            mstp_port->DataRegister = buf[i++];
+            mstp_port->DataAvailable = true;
+        }
+        MSTP_Receive_Frame_FSM(mstp_port);
+        if (mstp_frame_capture(mstp_port, &trunk->receive_state,
+                trunk->interface, &trunk->invalid_count)) {
+            trunk->packet_count++;
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ * @brief Open each trunk and add it to the capture
+ * @param baud - baud rate of trunks that did not give one
+ * @return true if all the trunks were opened
+ */
+static bool mstp_trunk_init(uint32_t baud)
+{
+    struct mstp_trunk *trunk;
+    int interface;
+    unsigned i;
+
+    for (i = 0; i < MSTP_Trunk_Count; i++) {
+        trunk = &MSTP_Trunk[i];
+        if (trunk->baud == 0) {
+            trunk->baud = baud;
+        }
+        if (!mstp_trunk_open(trunk)) {
+            return false;
+        }
+        interface = capture_interface_add(trunk->name, trunk->baud);
+        if (interface < 0) {
+            return false;
+        }
+        trunk->interface = (unsigned)interface;
+        if (!Wireshark_Capture) {
+            fprintf(stdout, "mstpcap: Using %s for capture at %lu bps.\n",
+                trunk->name, (unsigned long)trunk->baud);
+        }
+    }
+
+    return true;
+}
+
+/**
+ * @brief Start the receive thread of each trunk, once the capture
+ *  has been started
+ * @return true if all the threads were started
+ */
+static bool mstp_trunk_start(void)
+{
+    unsigned i;
+
+    for (i = 0; i < MSTP_Trunk_Count; i++) {
+        if (pthread_create(&MSTP_Trunk[i].thread, NULL, mstp_trunk_thread,
+                &MSTP_Trunk[i]) != 0) {
+            perror("mstpcap: trunk thread");
+            return false;
+        }
+    }
+
+    return true;
+}
+#endif
+
+static void cleanup(void)
+{
+    unsigned i;
+
+    if (!Wireshark_Capture) {
+        packet_statistics_print();
+    }
+    /* write out the frames still waiting for the writer */
+    capture_stop();
+    if (!Wireshark_Capture) {
+        for (i = 0; i < capture_interface_count(); i++) {
+            if (capture_interface_dropped(i)) {
+                fprintf(stdout, "Interface %u Dropped Frame Count: %lu\n", i,
+                    (long unsigned int)capture_interface_dropped(i));
+            }
+        }
+#if !defined(_WIN32)
+        for (i = 0; i < MSTP_Trunk_Count; i++) {
+            fprintf(stdout, "%s: %lu packets, %lu invalid frames\n",
+                MSTP_Trunk[i].name,
+                (long unsigned int)MSTP_Trunk[i].packet_count,
+                (long unsigned int)MSTP_Trunk[i].invalid_count);
+        }
+#endif
+    }
+    if (pFile) {
+        fflush(pFile); /* stream pointer */
+        fclose(pFile); /* stream pointer */
+    }
+    pFile = NULL;
+}
+
 /* simple test to packetize the data and print it */
 int main(int argc, char *argv[])
 {
     volatile struct mstp_port_struct_t *mstp_port;
     long my_baud = 38400;
     uint32_t packet_count = 0;
-    uint32_t header_len = 0;
     int argi = 0;
     char *filename = NULL;
+    bool ring_limit = false;
 
     MSTP_Port.InputBuffer = &RxBuffer[0];
     MSTP_Port.InputBufferSize = sizeof(RxBuffer);
@@ -1111,7 +1356,55 @@ int main(int argc, char *argv[])
                 printf("A named pipe must be provided.\n");
                 return 0;
             }
-            named_pipe_create(argv[argi]);
+            if (!capture_pipe_create(argv[argi])) {
+                return 1;
+            }
+        }
+        if (strcmp(argv[argi], "--pcapng") == 0) {
+            capture_pcapng_set(true);
+        }
+        if (strcmp(argv[argi], "--ring-size") == 0) {
+            argi++;
+            if (argi >= argc) {
+                printf("A file size in megabytes must be provided.\n");
+                return 1;
+            }
+            capture_ring_size_set(
+                strtoull(argv[argi], NULL, 0) * 1024ULL * 1024ULL);
+            ring_limit = true;
+        }
+        if (strcmp(argv[argi], "--ring-time") == 0) {
+            argi++;
+            if (argi >= argc) {
+                printf("A file age in seconds must be provided.\n");
+                return 1;
+            }
+            capture_ring_time_set(strtoul(argv[argi], NULL, 0));
+            ring_limit = true;
+        }
+        if (strcmp(argv[argi], "--ring-files") == 0) {
+            argi++;
+            if (argi >= argc) {
+                printf("A number of files must be provided.\n");
+                return 1;
+            }
+            capture_ring_files_set(strtoul(argv[argi], NULL, 0));
+        }
+        if (strcmp(argv[argi], "--trunk") == 0) {
+            argi++;
+            if (argi >= argc) {
+                printf("A trunk interface must be provided.\n");
+                return 1;
+            }
+#if defined(_WIN32)
+            printf("Trunks are not supported on this platform.\n");
+            return 1;
+#else
+            if (!mstp_trunk_add(argv[argi])) {
+                printf("Up to %u trunks are supported.\n", MSTP_TRUNK_MAX);
+                return 1;
+            }
+#endif
         }
     }
     if (Exit_Requested) {
@@ -1134,54 +1427,32 @@ int main(int argc, char *argv[])
 #else
     signal_init();
 #endif
-    filename_create_new();
+    capture_quiet_set(Wireshark_Capture);
+    if (!Wireshark_Capture && !ring_limit) {
+        /* After receiving 65535 packets, a new file is created. */
+        capture_ring_packets_set(65535);
+    }
+    (void)capture_interface_add(RS485_Interface(), RS485_Get_Baud_Rate());
+#if !defined(_WIN32)
+    if (!mstp_trunk_init(RS485_Get_Baud_Rate())) {
+        return 1;
+    }
+#endif
+    if (!capture_start()) {
+        return 1;
+    }
+#if !defined(_WIN32)
+    if (!mstp_trunk_start()) {
+        return 1;
+    }
+#endif
     /* run forever */
     for (;;) {
         RS485_Check_UART_Data(mstp_port);
         MSTP_Receive_Frame_FSM(mstp_port);
-        /* process the data portion of the frame */
-        if (mstp_port->ReceivedValidFrame) {
-            write_received_packet(mstp_port, MSTP_HEADER_MAX);
-            mstp_structure_init(mstp_port);
-            packet_count++;
-        } else if (mstp_port->ReceivedValidFrameNotForUs) {
-            write_received_packet(mstp_port, MSTP_HEADER_MAX);
-            mstp_structure_init(mstp_port);
-            packet_count++;
-        } else if (mstp_port->ReceivedInvalidFrame) {
-            if (MSTP_Receive_State == MSTP_RECEIVE_STATE_HEADER) {
-                mstp_port->Index = 0;
-            }
-            write_received_packet(mstp_port, MSTP_HEADER_MAX);
-            mstp_structure_init(mstp_port);
-            Invalid_Frame_Count++;
+        if (mstp_frame_capture(
+                mstp_port, &MSTP_Receive_State, 0, &Invalid_Frame_Count)) {
             packet_count++;
-        } else if (mstp_port->receive_state == MSTP_RECEIVE_STATE_IDLE) {
-            if (MSTP_Receive_State == MSTP_RECEIVE_STATE_IDLE) {
-                if ((mstp_port->EventCount == 1) &&
-                    (mstp_port->DataRegister == 0xFF)) {
-                    /* 0xFF padding at end of message is allowed */
-                    mstp_structure_init(mstp_port);
-                } else if (mstp_port->EventCount > 1) {
-                    write_received_packet(mstp_port, 1);
-                    mstp_structure_init(mstp_port);
-                    Invalid_Frame_Count++;
-                }
-            } else {
-                /* invalid byte or timeout */
-                if (MSTP_Receive_State == MSTP_RECEIVE_STATE_PREAMBLE) {
-                    if (mstp_port->EventCount) {
-                        header_len = 1;
-                    } else {
-                        header_len = 2;
-                    }
-                } else {
-                    header_len = 3 + mstp_port->Index;
-                }
-                write_received_packet(mstp_port, header_len);
-                mstp_structure_init(mstp_port);
-                Invalid_Frame_Count++;
-            }
         }
         if (!Wireshark_Capture) {
             if (!(packet_count % 100)) {
@@ -1191,15 +1462,12 @@ int main(int argc, char *argv[])
             if (packet_count >= 65535) {
                 packet_statistics_print();
                 packet_statistics_clear();
-                filename_create_new();
                 packet_count = 0;
             }
         }
         if (Exit_Requested) {
             break;
         }
-        /* track the packetizer state */
-        MSTP_Receive_State = mstp_port->receive_state;
     }
     /* tell signal interrupts we are done */
     Exit_Requested = false;
@@ -47,6 +47,8 @@
 #include "bacnet/bytes.h"
 #include "bacnet/basic/sys/mstimer.h"
 #include "bacnet/datalink/crc.h"
+#include "bacnet/datalink/mstpdef.h"
+#include "bacnet/datalink/cobs.h"
 #include "bacnet/version.h"
 
 #ifndef max
@@ -63,6 +65,7 @@ static unsigned CRC_Size = 8;
 /* save to capture file for viewing in Wireshark */
 static bool MSTP_Cap = false;
 static bool MSTP_Text_File = false;
+static bool CRC_Benchmark = false;
 static char Capture_Filename[64] = "mstp_20090123091200.cap";
 static FILE *pFile = NULL; /* stream pointer */
 static FILE *pText_File = NULL; /* stream pointer */
@@ -138,6 +141,10 @@ static void Parse_Arguments(int argc, char *argv[])
                 case 'F':
                     MSTP_Text_File = true;
                     break;
+                case 'b':
+                case 'B':
+                    CRC_Benchmark = true;
+                    break;
                 default:
                     break;
             }
@@ -259,6 +266,74 @@ static void Process_Text_File(void)
     }
 }
 
+/******************************************************************
+ * DESCRIPTION:  Prints the throughput of one CRC loop
+ * RETURN:       nothing
+ * NOTES:        none
+ ******************************************************************/
+static void Benchmark_Print(
+    const char *name, clock_t ticks, unsigned long octets, uint32_t crc)
+{
+    double seconds = (double)ticks / CLOCKS_PER_SEC;
+
+    if (seconds > 0.0) {
+        printf("%-24s %8.1f MB/s (0x%08lX)\r\n", name,
+            (double)octets / seconds / 1000000.0, (unsigned long)crc);
+    } else {
+        printf("%-24s %8s MB/s (0x%08lX)\r\n", name, "-",
+            (unsigned long)crc);
+    }
+}
+
+/******************************************************************
+ * DESCRIPTION:  Times the per-octet and buffer CRC functions over
+ *               a maximum size extended frame.
+ * RETURN:       nothing
+ * NOTES:        the CRC values are printed so that the loops are
+ *               not optimized away, and should match per pair.
+ ******************************************************************/
+static void Benchmark_CRC(void)
+{
+    const unsigned long loops = 20000;
+    const unsigned length = MSTP_EXTENDED_FRAME_NPDU_MAX;
+    unsigned long octets = loops * length;
+    unsigned long n = 0;
+    unsigned i = 0;
+    uint16_t crc16 = 0xFFFF;
+    uint32_t crc32k = 0xFFFFFFFF;
+    clock_t start;
+
+    for (i = 0; i < length; i++) {
+        CRC_Buffer[i] = (uint8_t)rand();
+    }
+    start = clock();
+    for (n = 0; n < loops; n++) {
+        for (i = 0; i < length; i++) {
+            crc16 = CRC_Calc_Data(CRC_Buffer[i], crc16);
+        }
+    }
+    Benchmark_Print("CRC_Calc_Data", clock() - start, octets, crc16);
+    crc16 = 0xFFFF;
+    start = clock();
+    for (n = 0; n < loops; n++) {
+        crc16 = CRC_Calc_Data_Buffer(CRC_Buffer, length, crc16);
+    }
+    Benchmark_Print("CRC_Calc_Data_Buffer", clock() - start, octets, crc16);
+    start = clock();
+    for (n = 0; n < loops; n++) {
+        for (i = 0; i < length; i++) {
+            crc32k = cobs_crc32k(CRC_Buffer[i], crc32k);
+        }
+    }
+    Benchmark_Print("cobs_crc32k", clock() - start, octets, crc32k);
+    crc32k = 0xFFFFFFFF;
+    start = clock();
+    for (n = 0; n < loops; n++) {
+        crc32k = cobs_crc32k_buffer(CRC_Buffer, length, crc32k);
+    }
+    Benchmark_Print("cobs_crc32k_buffer", clock() - start, octets, crc32k);
+}
+
 /* simple program to CRC the data and print the CRC */
 int main(int argc, char *argv[])
 {
@@ -280,6 +355,7 @@ int main(int argc, char *argv[])
             "[-16] calculate the MS/TP 16-bit Data CRC\r\n"
             "[-32] calculate the MS/TP 32-bit Extended Frame CRC\r\n"
             "[-f filename] read MS/TP capture data from text file\r\n"
+            "[-b] benchmark the per-octet and buffer CRC functions\r\n"
             "Note: MS/TP Header CRC does not include the 55 FF preamble.\r\n");
         return 0;
     }
@@ -293,7 +369,9 @@ int main(int argc, char *argv[])
         return 0;
     }
     Parse_Arguments(argc, argv);
-    if (MSTP_Text_File) {
+    if (CRC_Benchmark) {
+        Benchmark_CRC();
+    } else if (MSTP_Text_File) {
         Process_Text_File();
     } else if (CRC_Buffer_Len) {
         if (MSTP_Cap) {
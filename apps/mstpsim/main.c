@@ -0,0 +1,762 @@
+/**
+ * @file
+ * @date October 2026
+ * @brief Virtual RS-485 bus for MS/TP throughput benchmarks.
+ *
+ * The default mode hosts many MS/TP master nodes from mstp.c in one
+ * process on a simulated bus with baud rate timing, and reports the
+ * token rotation time, frame rate and APDU round trip latency.
+ * The --pty mode relays octets between pseudo terminals at the baud
+ * rate, so that separate MS/TP processes can share a virtual bus.
+ *
+ * @section LICENSE
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <termios.h>
+#include <time.h>
+/* OS specific include*/
+#include "bacport.h"
+/* local includes */
+#include "bacnet/bacdef.h"
+#include "bacnet/bacenum.h"
+#include "bacnet/npdu.h"
+#include "bacnet/datalink/mstp.h"
+#include "bacnet/datalink/mstpdef.h"
+#include "bacnet/datalink/cobs.h"
+#include "bacnet/version.h"
+#include "rs485.h"
+
+/* MS/TP master MAC addresses are 0..127 */
+#ifndef MSTPSIM_NODES_MAX
+#define MSTPSIM_NODES_MAX 128
+#endif
+/* pseudo terminals on the --pty bus */
+#ifndef MSTPSIM_PTY_MAX
+#define MSTPSIM_PTY_MAX 32
+#endif
+/* frames queued on the simulated bus at one time */
+#define MSTPSIM_BUS_FRAMES 16
+/* largest frame: header, COBS encoded NPDU and encoded CRC-32K */
+#define MSTPSIM_FRAME_MAX                                    \
+    (8 + COBS_ENCODED_SIZE(MSTP_EXTENDED_FRAME_NPDU_MAX) + \
+        COBS_ENCODED_CRC_SIZE)
+/* virtual clock step while waiting for a frame or a timeout */
+#define MSTPSIM_STEP_NS 100000ULL
+/* a confirmed request without a reply is abandoned after 2 seconds */
+#define MSTPSIM_REQUEST_TIMEOUT_NS 2000000000ULL
+/* give up if the token ring has not formed after 5 minutes */
+#define MSTPSIM_RING_TIMEOUT_NS 300000000000ULL
+
+/* one frame on the simulated bus */
+struct mstpsim_frame {
+    uint64_t start_ns;
+    uint64_t end_ns;
+    unsigned sender;
+    uint16_t length;
+    uint8_t buffer[MSTPSIM_FRAME_MAX];
+};
+
+/* one MS/TP master node on the simulated bus */
+struct mstpsim_node {
+    struct mstp_port_struct_t port;
+    uint8_t input_buffer[MSTPSIM_FRAME_MAX];
+    uint8_t output_buffer[MSTPSIM_FRAME_MAX];
+    /* virtual time of the last line activity seen by this node */
+    uint64_t silence_start_ns;
+    /* a client keeps one confirmed request in flight to its server */
+    bool client;
+    uint8_t server;
+    bool request_ready;
+    bool request_outstanding;
+    uint8_t invoke_id;
+    uint64_t request_ns;
+    /* a server owes one reply to a confirmed request */
+    bool reply_pending;
+    uint8_t reply_mac;
+    uint8_t reply_invoke_id;
+};
+
+/* results of one simulation run */
+struct mstpsim_stats {
+    unsigned long frames;
+    unsigned long data_frames;
+    unsigned long poll_for_master;
+    unsigned long dropped;
+    uint64_t busy_ns;
+    unsigned long rotations;
+    uint64_t rotation_sum_ns;
+    uint64_t rotation_max_ns;
+    uint64_t token_ns;
+    unsigned long apdus;
+    uint64_t rtt_sum_ns;
+    uint64_t rtt_max_ns;
+    unsigned long timeouts;
+};
+
+static struct mstpsim_node Nodes[MSTPSIM_NODES_MAX];
+static struct mstpsim_frame Bus_Frames[MSTPSIM_BUS_FRAMES];
+static struct mstpsim_frame Bus_Delivery;
+static unsigned Bus_Head;
+static unsigned Bus_Count;
+/* end of the last frame queued on the bus */
+static uint64_t Bus_Free_ns;
+/* the virtual clock */
+static uint64_t Sim_Now_ns;
+/* measurement starts once the first token rotation has finished,
+   after the first Poll For Master sweep of every node */
+static bool Sim_Started;
+static uint64_t Sim_Start_ns;
+static struct mstpsim_stats Stats;
+/* settings */
+static unsigned Node_Count = 4;
+static unsigned Client_Count = 1;
+static uint32_t Sim_Baud = 38400;
+static unsigned Sim_Max_Master = 127;
+static unsigned Sim_Max_Info_Frames = 1;
+static unsigned Sim_NPDU_Len = 50;
+static unsigned Sim_Seconds = 60;
+
+/* time on the wire of one octet: a start bit, 8 data bits, a stop bit */
+static uint64_t octet_ns(void)
+{
+    return 10ULL * 1000000000ULL / Sim_Baud;
+}
+
+/* true while another node's frame is on the wire */
+static bool bus_active(unsigned index)
+{
+    struct mstpsim_frame *frame;
+
+    if (Bus_Count) {
+        frame = &Bus_Frames[Bus_Head];
+        if ((frame->start_ns <= Sim_Now_ns) && (frame->sender != index)) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static uint32_t Timer_Silence(void *pArg)
+{
+    struct mstp_port_struct_t *mstp_port = pArg;
+    struct mstpsim_node *node = mstp_port->UserData;
+
+    if (bus_active((unsigned)(node - &Nodes[0]))) {
+        return 0;
+    }
+    if (node->silence_start_ns >= Sim_Now_ns) {
+        /* still sending */
+        return 0;
+    }
+
+    return (uint32_t)((Sim_Now_ns - node->silence_start_ns) / 1000000ULL);
+}
+
+static void Timer_Silence_Reset(void *pArg)
+{
+    struct mstp_port_struct_t *mstp_port = pArg;
+    struct mstpsim_node *node = mstp_port->UserData;
+
+    if (node->silence_start_ns < Sim_Now_ns) {
+        node->silence_start_ns = Sim_Now_ns;
+    }
+}
+
+/* queue a frame on the bus after the frame ahead of it and the
+   turnaround time, and treat the sender as busy until it is sent */
+void RS485_Send_Frame(
+    volatile struct mstp_port_struct_t *mstp_port,
+    uint8_t *buffer,
+    uint16_t nbytes)
+{
+    struct mstpsim_node *node = mstp_port->UserData;
+    struct mstpsim_frame *frame;
+    uint64_t start_ns = Sim_Now_ns;
+    uint64_t turnaround_ns = Tturnaround * octet_ns() / 10ULL;
+
+    if ((Bus_Count >= MSTPSIM_BUS_FRAMES) || (nbytes > MSTPSIM_FRAME_MAX)) {
+        Stats.dropped++;
+        return;
+    }
+    if (Bus_Free_ns && (start_ns < (Bus_Free_ns + turnaround_ns))) {
+        start_ns = Bus_Free_ns + turnaround_ns;
+    }
+    frame = &Bus_Frames[(Bus_Head + Bus_Count) % MSTPSIM_BUS_FRAMES];
+    frame->start_ns = start_ns;
+    frame->end_ns = start_ns + (nbytes * octet_ns());
+    frame->sender = (unsigned)(node - &Nodes[0]);
+    frame->length = nbytes;
+    memcpy(frame->buffer, buffer, nbytes);
+    Bus_Count++;
+    Bus_Free_ns = frame->end_ns;
+    node->silence_start_ns = frame->end_ns;
+}
+
+/* encode a ReadProperty-like request or reply padded to Sim_NPDU_Len */
+static uint16_t mstpsim_pdu_encode(
+    uint8_t *pdu, bool request, uint8_t invoke_id)
+{
+    BACNET_NPDU_DATA npdu_data;
+    int len = 0;
+    unsigned i = 0;
+
+    npdu_encode_npdu_data(&npdu_data, request, MESSAGE_PRIORITY_NORMAL);
+    len = npdu_encode_pdu(pdu, NULL, NULL, &npdu_data);
+    if (request) {
+        pdu[len++] = PDU_TYPE_CONFIRMED_SERVICE_REQUEST;
+        pdu[len++] = 0x05;
+        pdu[len++] = invoke_id;
+        pdu[len++] = SERVICE_CONFIRMED_READ_PROPERTY;
+    } else {
+        pdu[len++] = PDU_TYPE_COMPLEX_ACK;
+        pdu[len++] = invoke_id;
+        pdu[len++] = SERVICE_CONFIRMED_READ_PROPERTY;
+    }
+    for (i = len; i < Sim_NPDU_Len; i++) {
+        pdu[i] = (uint8_t)i;
+    }
+    if (len < (int)Sim_NPDU_Len) {
+        len = (int)Sim_NPDU_Len;
+    }
+
+    return (uint16_t)len;
+}
+
+static uint16_t mstpsim_frame_create(volatile struct mstp_port_struct_t
+        *mstp_port, bool request, uint8_t destination, uint8_t invoke_id)
+{
+    uint8_t pdu[MSTP_EXTENDED_FRAME_NPDU_MAX];
+    uint16_t pdu_len;
+
+    pdu_len = mstpsim_pdu_encode(pdu, request, invoke_id);
+
+    return MSTP_Create_Frame((uint8_t *)mstp_port->OutputBuffer,
+        mstp_port->OutputBufferSize,
+        request ? FRAME_TYPE_BACNET_DATA_EXPECTING_REPLY
+                : FRAME_TYPE_BACNET_DATA_NOT_EXPECTING_REPLY,
+        destination, mstp_port->This_Station, pdu, pdu_len);
+}
+
+/* for the MS/TP state machine to use for putting received data */
+uint16_t MSTP_Put_Receive(volatile struct mstp_port_struct_t *mstp_port)
+{
+    struct mstpsim_node *node = mstp_port->UserData;
+    BACNET_NPDU_DATA npdu_data;
+    uint8_t *pdu = (uint8_t *)mstp_port->InputBuffer;
+    uint16_t pdu_len = mstp_port->DataLength;
+    uint64_t rtt_ns;
+    int offset;
+
+    offset = bacnet_npdu_decode(pdu, pdu_len, NULL, NULL, &npdu_data);
+    if ((offset <= 0) || ((offset + 3) > pdu_len)) {
+        return 0;
+    }
+    if ((pdu[offset] & 0xF0) == PDU_TYPE_CONFIRMED_SERVICE_REQUEST) {
+        node->reply_pending = true;
+        node->reply_mac = mstp_port->SourceAddress;
+        node->reply_invoke_id = pdu[offset + 2];
+    } else if (node->client && node->request_outstanding &&
+        (mstp_port->SourceAddress == node->server) &&
+        (pdu[offset + 1] == node->invoke_id)) {
+        rtt_ns = Sim_Now_ns - node->request_ns;
+        Stats.apdus++;
+        Stats.rtt_sum_ns += rtt_ns;
+        if (rtt_ns > Stats.rtt_max_ns) {
+            Stats.rtt_max_ns = rtt_ns;
+        }
+        node->request_outstanding = false;
+        node->invoke_id++;
+    }
+
+    return pdu_len;
+}
+
+/* for the MS/TP state machine to use for getting data to send */
+uint16_t MSTP_Get_Send(
+    volatile struct mstp_port_struct_t *mstp_port, unsigned timeout)
+{
+    struct mstpsim_node *node = mstp_port->UserData;
+
+    (void)timeout;
+    if (node->reply_pending) {
+        /* the reply was postponed */
+        node->reply_pending = false;
+        return mstpsim_frame_create(
+            mstp_port, false, node->reply_mac, node->reply_invoke_id);
+    }
+    if (node->client && node->request_ready) {
+        node->request_ready = false;
+        node->request_outstanding = true;
+        return mstpsim_frame_create(
+            mstp_port, true, node->server, node->invoke_id);
+    }
+
+    return 0;
+}
+
+/* for the MS/TP state machine to use for getting the reply to a DER */
+uint16_t MSTP_Get_Reply(
+    volatile struct mstp_port_struct_t *mstp_port, unsigned timeout)
+{
+    struct mstpsim_node *node = mstp_port->UserData;
+
+    (void)timeout;
+    if (node->reply_pending &&
+        (node->reply_mac == mstp_port->SourceAddress)) {
+        node->reply_pending = false;
+        return mstpsim_frame_create(
+            mstp_port, false, node->reply_mac, node->reply_invoke_id);
+    }
+
+    return 0;
+}
+
+/* run the master node state machine through its immediate transitions */
+static void mstpsim_node_run(struct mstpsim_node *node)
+{
+    unsigned limit = 255;
+
+    while (MSTP_Master_Node_FSM(&node->port) && --limit) {
+        /* do nothing while immediate transitioning */
+    }
+}
+
+/* hand the frame that just ended on the wire to every other node */
+static void mstpsim_bus_deliver(struct mstpsim_frame *frame)
+{
+    struct mstpsim_node *node;
+    uint64_t rotation_ns;
+    uint16_t offset, len;
+    unsigned i;
+
+    Stats.frames++;
+    Stats.busy_ns += frame->end_ns - frame->start_ns;
+    switch (frame->buffer[2]) {
+        case FRAME_TYPE_TOKEN:
+            /* token rotation is timed at the first node */
+            if ((frame->buffer[3] == 0) && !Sim_Started) {
+                if (Stats.token_ns) {
+                    memset(&Stats, 0, sizeof(Stats));
+                    Sim_Started = true;
+                    Sim_Start_ns = frame->end_ns;
+                }
+                Stats.token_ns = frame->end_ns;
+            } else if (frame->buffer[3] == 0) {
+                if (Stats.token_ns) {
+                    rotation_ns = frame->end_ns - Stats.token_ns;
+                    Stats.rotations++;
+                    Stats.rotation_sum_ns += rotation_ns;
+                    if (rotation_ns > Stats.rotation_max_ns) {
+                        Stats.rotation_max_ns = rotation_ns;
+                    }
+                }
+                Stats.token_ns = frame->end_ns;
+            }
+            break;
+        case FRAME_TYPE_POLL_FOR_MASTER:
+            Stats.poll_for_master++;
+            break;
+        case FRAME_TYPE_BACNET_DATA_EXPECTING_REPLY:
+        case FRAME_TYPE_BACNET_DATA_NOT_EXPECTING_REPLY:
+        case FRAME_TYPE_BACNET_EXTENDED_DATA_EXPECTING_REPLY:
+        case FRAME_TYPE_BACNET_EXTENDED_DATA_NOT_EXPECTING_REPLY:
+            Stats.data_frames++;
+            break;
+        default:
+            break;
+    }
+    for (i = 0; i < Node_Count; i++) {
+        if (i == frame->sender) {
+            continue;
+        }
+        node = &Nodes[i];
+        offset = 0;
+        while (offset < frame->length) {
+            len = MSTP_Receive_Frame_Buffer(
+                &node->port, &frame->buffer[offset], frame->length - offset);
+            /* let the node handle the frame before the next one */
+            mstpsim_node_run(node);
+            if (len == 0) {
+                break;
+            }
+            offset += len;
+        }
+    }
+}
+
+/* clients queue their next request as soon as the last one finished */
+static void mstpsim_clients_update(void)
+{
+    struct mstpsim_node *node;
+    unsigned i;
+
+    if (!Sim_Started) {
+        return;
+    }
+    for (i = 0; i < Node_Count; i++) {
+        node = &Nodes[i];
+        if (!node->client) {
+            continue;
+        }
+        if (node->request_outstanding &&
+            ((Sim_Now_ns - node->request_ns) > MSTPSIM_REQUEST_TIMEOUT_NS)) {
+            Stats.timeouts++;
+            node->request_outstanding = false;
+            node->invoke_id++;
+        }
+        if (!node->request_ready && !node->request_outstanding) {
+            node->request_ready = true;
+            node->request_ns = Sim_Now_ns;
+        }
+    }
+}
+
+static void mstpsim_init(void)
+{
+    struct mstpsim_node *node;
+    unsigned i;
+
+    memset(Nodes, 0, sizeof(Nodes));
+    memset(&Stats, 0, sizeof(Stats));
+    Bus_Head = 0;
+    Bus_Count = 0;
+    Bus_Free_ns = 0;
+    Sim_Now_ns = 0;
+    Sim_Started = false;
+    Sim_Start_ns = 0;
+    for (i = 0; i < Node_Count; i++) {
+        node = &Nodes[i];
+        node->port.UserData = node;
+        node->port.InputBuffer = node->input_buffer;
+        node->port.InputBufferSize = sizeof(node->input_buffer);
+        node->port.OutputBuffer = node->output_buffer;
+        node->port.OutputBufferSize = sizeof(node->output_buffer);
+        node->port.This_Station = (uint8_t)i;
+        node->port.Nmax_info_frames = (uint8_t)Sim_Max_Info_Frames;
+        node->port.Nmax_master = (uint8_t)Sim_Max_Master;
+        node->port.SilenceTimer = Timer_Silence;
+        node->port.SilenceTimerReset = Timer_Silence_Reset;
+        MSTP_Init(&node->port);
+        /* the first nodes each read from the node after them */
+        if (i < Client_Count) {
+            node->client = true;
+            node->server = (uint8_t)((i + 1) % Node_Count);
+        }
+    }
+}
+
+/* run the nodes on the simulated bus for Sim_Seconds of virtual time
+   after the token ring has formed */
+static bool mstpsim_run(void)
+{
+    uint64_t run_ns = (uint64_t)Sim_Seconds * 1000000000ULL;
+    unsigned i;
+
+    mstpsim_init();
+    for (;;) {
+        if (Sim_Started) {
+            if ((Sim_Now_ns - Sim_Start_ns) >= run_ns) {
+                break;
+            }
+        } else if (Sim_Now_ns >= MSTPSIM_RING_TIMEOUT_NS) {
+            return false;
+        }
+        if (Bus_Count &&
+            (Bus_Frames[Bus_Head].end_ns <= (Sim_Now_ns + MSTPSIM_STEP_NS))) {
+            /* advance to the end of the frame on the wire, and take it
+               off the bus before the receivers can queue a response */
+            memcpy(&Bus_Delivery, &Bus_Frames[Bus_Head],
+                sizeof(Bus_Delivery));
+            Bus_Head = (Bus_Head + 1) % MSTPSIM_BUS_FRAMES;
+            Bus_Count--;
+            if (Bus_Delivery.end_ns > Sim_Now_ns) {
+                Sim_Now_ns = Bus_Delivery.end_ns;
+            }
+            mstpsim_bus_deliver(&Bus_Delivery);
+        } else {
+            Sim_Now_ns += MSTPSIM_STEP_NS;
+        }
+        mstpsim_clients_update();
+        for (i = 0; i < Node_Count; i++) {
+            mstpsim_node_run(&Nodes[i]);
+        }
+    }
+
+    return true;
+}
+
+static void mstpsim_print_header(void)
+{
+    printf("nodes max_master info_frames baud   "
+           "token_ms(avg/max) frames/s bus%% apdu/s "
+           "rtt_ms(avg/max) timeouts\n");
+}
+
+static void mstpsim_print(void)
+{
+    double seconds = (double)Sim_Seconds;
+    double token_avg = 0.0, rtt_avg = 0.0;
+
+    if (Stats.rotations) {
+        token_avg = (double)Stats.rotation_sum_ns / Stats.rotations / 1e6;
+    }
+    if (Stats.apdus) {
+        rtt_avg = (double)Stats.rtt_sum_ns / Stats.apdus / 1e6;
+    }
+    printf("%5u %10u %11u %6lu %8.1f/%-8.1f %8.1f %4.0f %6.1f "
+           "%7.1f/%-7.1f %8lu\n",
+        Node_Count, Sim_Max_Master, Sim_Max_Info_Frames,
+        (unsigned long)Sim_Baud, token_avg, Stats.rotation_max_ns / 1e6,
+        Stats.frames / seconds, 100.0 * Stats.busy_ns / (seconds * 1e9),
+        Stats.apdus / seconds, rtt_avg, Stats.rtt_max_ns / 1e6,
+        Stats.timeouts + Stats.dropped);
+}
+
+/* sweep the node count, Max_Master and Max_Info_Frames */
+static void mstpsim_sweep(void)
+{
+    static const unsigned node_counts[] = { 2, 4, 8, 16, 32, 64 };
+    static const unsigned info_frames[] = { 1, 4 };
+    unsigned n, f, m;
+
+    mstpsim_print_header();
+    for (n = 0; n < sizeof(node_counts) / sizeof(node_counts[0]); n++) {
+        Node_Count = node_counts[n];
+        Client_Count = Node_Count;
+        for (f = 0; f < sizeof(info_frames) / sizeof(info_frames[0]); f++) {
+            Sim_Max_Info_Frames = info_frames[f];
+            for (m = 0; m < 2; m++) {
+                Sim_Max_Master = m ? 127 : (Node_Count - 1);
+                if (mstpsim_run()) {
+                    mstpsim_print();
+                }
+            }
+        }
+    }
+}
+
+/* relay octets written to any pseudo terminal to all the others,
+   holding the bus for the time the octets take at the baud rate */
+static int mstpsim_pty_bus(unsigned count)
+{
+    struct pollfd pfd[MSTPSIM_PTY_MAX];
+    int slave[MSTPSIM_PTY_MAX];
+    uint8_t buffer[512];
+    struct termios tio;
+    struct timespec delay;
+    uint64_t delay_ns;
+    ssize_t len;
+    unsigned i, j;
+
+    for (i = 0; i < count; i++) {
+        pfd[i].fd = posix_openpt(O_RDWR | O_NOCTTY);
+        if ((pfd[i].fd < 0) || (grantpt(pfd[i].fd) != 0) ||
+            (unlockpt(pfd[i].fd) != 0)) {
+            perror("posix_openpt");
+            return 1;
+        }
+        pfd[i].events = POLLIN;
+        /* keep the slave open, so the master does not hang up
+           before an MS/TP process opens it */
+        slave[i] = open(ptsname(pfd[i].fd), O_RDWR | O_NOCTTY);
+        if (slave[i] < 0) {
+            perror(ptsname(pfd[i].fd));
+            return 1;
+        }
+        tcgetattr(slave[i], &tio);
+        cfmakeraw(&tio);
+        tcsetattr(slave[i], TCSANOW, &tio);
+        printf("%s\n", ptsname(pfd[i].fd));
+    }
+    fflush(stdout);
+    for (;;) {
+        if (poll(pfd, count, -1) < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            perror("poll");
+            return 1;
+        }
+        for (i = 0; i < count; i++) {
+            if (!(pfd[i].revents & POLLIN)) {
+                continue;
+            }
+            len = read(pfd[i].fd, buffer, sizeof(buffer));
+            if (len <= 0) {
+                continue;
+            }
+            for (j = 0; j < count; j++) {
+                if (j != i) {
+                    (void)write(pfd[j].fd, buffer, (size_t)len);
+                }
+            }
+            delay_ns = (uint64_t)len * octet_ns();
+            delay.tv_sec = (time_t)(delay_ns / 1000000000ULL);
+            delay.tv_nsec = (long)(delay_ns % 1000000000ULL);
+            nanosleep(&delay, NULL);
+        }
+    }
+
+    return 0;
+}
+
+static void print_usage(const char *filename)
+{
+    printf("Usage: %s [--nodes N][--clients N][--max-master N]\n"
+           "       [--max-info-frames N][--baud N][--npdu N][--seconds N]\n"
+           "       [--sweep][--pty N]\n",
+        filename);
+    printf("       [--version][--help]\n");
+}
+
+static void print_help(const char *filename)
+{
+    printf("Simulate MS/TP master nodes on a virtual RS-485 bus and\n"
+           "report the token rotation time, frames per second and\n"
+           "confirmed request round trip latency.\n");
+    printf("\n");
+    printf("--nodes N\n"
+           "Number of master nodes, at MAC 0 to N-1. Default %u.\n",
+        Node_Count);
+    printf("--clients N\n"
+           "Number of nodes, from MAC 0, that keep a confirmed request\n"
+           "in flight to the next node. Default %u.\n",
+        Client_Count);
+    printf("--max-master N\n"
+           "Max_Master of every node. Default %u.\n", Sim_Max_Master);
+    printf("--max-info-frames N\n"
+           "Max_Info_Frames of every node. Default %u.\n",
+        Sim_Max_Info_Frames);
+    printf("--baud N\n"
+           "Bus baud rate. Default %lu.\n", (unsigned long)Sim_Baud);
+    printf("--npdu N\n"
+           "NPDU length of each request and reply. Default %u.\n",
+        Sim_NPDU_Len);
+    printf("--seconds N\n"
+           "Virtual time to simulate. Default %u.\n", Sim_Seconds);
+    printf("--sweep\n"
+           "Run the node count, Max_Master and Max_Info_Frames table.\n");
+    printf("--pty N\n"
+           "Create N pseudo terminals on one virtual bus for MS/TP\n"
+           "processes, relayed at the baud rate, and print their names.\n");
+    printf("\n");
+    printf("Example:\n"
+           "%s --nodes 16 --clients 4 --max-master 15 --baud 76800\n",
+        filename);
+}
+
+int main(int argc, char *argv[])
+{
+    bool sweep = false;
+    unsigned pty_count = 0;
+    unsigned long value;
+    int argi;
+
+    for (argi = 1; argi < argc; argi++) {
+        if (strcmp(argv[argi], "--help") == 0) {
+            print_usage(argv[0]);
+            print_help(argv[0]);
+            return 0;
+        }
+        if (strcmp(argv[argi], "--version") == 0) {
+            printf("mstpsim %s\n", BACNET_VERSION_TEXT);
+            printf("This is free software; see the source for copying "
+                   "conditions.\n"
+                   "There is NO warranty; not even for MERCHANTABILITY or\n"
+                   "FITNESS FOR A PARTICULAR PURPOSE.\n");
+            return 0;
+        }
+        if (strcmp(argv[argi], "--sweep") == 0) {
+            sweep = true;
+            continue;
+        }
+        if ((argi + 1) >= argc) {
+            print_usage(argv[0]);
+            return 1;
+        }
+        value = strtoul(argv[argi + 1], NULL, 0);
+        if (strcmp(argv[argi], "--nodes") == 0) {
+            Node_Count = (unsigned)value;
+        } else if (strcmp(argv[argi], "--clients") == 0) {
+            Client_Count = (unsigned)value;
+        } else if (strcmp(argv[argi], "--max-master") == 0) {
+            Sim_Max_Master = (unsigned)value;
+        } else if (strcmp(argv[argi], "--max-info-frames") == 0) {
+            Sim_Max_Info_Frames = (unsigned)value;
+        } else if (strcmp(argv[argi], "--baud") == 0) {
+            Sim_Baud = (uint32_t)value;
+        } else if (strcmp(argv[argi], "--npdu") == 0) {
+            Sim_NPDU_Len = (unsigned)value;
+        } else if (strcmp(argv[argi], "--seconds") == 0) {
+            Sim_Seconds = (unsigned)value;
+        } else if (strcmp(argv[argi], "--pty") == 0) {
+            pty_count = (unsigned)value;
+        } else {
+            print_usage(argv[0]);
+            return 1;
+        }
+        argi++;
+    }
+    if ((Sim_Baud == 0) || (Sim_Max_Info_Frames == 0) ||
+        (Sim_Max_Master > DEFAULT_MAX_MASTER) ||
+        (Sim_NPDU_Len > MSTP_EXTENDED_FRAME_NPDU_MAX)) {
+        fprintf(stderr, "mstpsim: invalid setting\n");
+        return 1;
+    }
+    if (pty_count) {
+        if ((pty_count < 2) || (pty_count > MSTPSIM_PTY_MAX)) {
+            fprintf(stderr, "mstpsim: --pty 2 to %u\n", MSTPSIM_PTY_MAX);
+            return 1;
+        }
+        return mstpsim_pty_bus(pty_count);
+    }
+    if (sweep) {
+        mstpsim_sweep();
+        return 0;
+    }
+    if ((Node_Count < 2) || (Node_Count > (Sim_Max_Master + 1)) ||
+        (Client_Count > Node_Count)) {
+        fprintf(stderr,
+            "mstpsim: --nodes 2 to Max_Master+1, --clients up to nodes\n");
+        return 1;
+    }
+    mstpsim_print_header();
+    if (!mstpsim_run()) {
+        fprintf(stderr, "mstpsim: the token ring did not form\n");
+        return 1;
+    }
+    mstpsim_print();
+
+    return 0;
+}
@@ -0,0 +1,279 @@
+/**
+ * @file
+ * @date October 2026
+ * @brief Route discovery with Who-Is-Router-To-Network for unknown DNETs
+ *
+ * Messages for the same unknown network share one search, and wait in a
+ * bounded queue until I-Am-Router-To-Network arrives. A network that does
+ * not answer is remembered as unreachable for a while, and messages for
+ * it are discarded without another search.
+ *
+ * @section LICENSE
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+#include <stdio.h>
+#include <string.h>
+#include "discovery.h"
+#include "portengine.h"
+#include "network_layer.h"
+
+typedef enum {
+    SEARCH_FREE = 0,
+    SEARCH_PENDING,     /* Who-Is-Router-To-Network sent */
+    SEARCH_FOUND,       /* parked messages wait to be released */
+    SEARCH_UNREACHABLE  /* negatively cached until the deadline */
+} SEARCH_STATE;
+
+typedef struct _search {
+    uint16_t net;
+    SEARCH_STATE state;
+    unsigned attempts;
+    uint64_t deadline;  /* milliseconds */
+    uint32_t backoff;   /* milliseconds, used when the search fails */
+    unsigned pending_head;
+    unsigned pending_count;
+    BACMSG pending[DISCOVERY_PENDING_MAX];
+} SEARCH;
+
+/* only a few networks are searched at a time, so a linear scan is fine */
+static SEARCH Searches[DISCOVERY_SEARCH_MAX];
+static unsigned Found_Count;
+
+static uint32_t Who_Is_Sent;
+static uint32_t Routes_Found;
+static uint32_t Messages_Parked;
+static uint32_t Messages_Unreachable;
+static uint32_t Messages_Dropped;
+
+static uint64_t discovery_clock(void)
+{
+    return port_engine_clock() / 1000ULL;
+}
+
+static SEARCH *search_find(uint16_t net)
+{
+    unsigned i;
+
+    for (i = 0; i < DISCOVERY_SEARCH_MAX; i++) {
+        if ((Searches[i].state != SEARCH_FREE) && (Searches[i].net == net)) {
+            return &Searches[i];
+        }
+    }
+
+    return NULL;
+}
+
+/* a free entry, or else the unreachable network cached the shortest */
+static SEARCH *search_new(uint16_t net)
+{
+    SEARCH *search = NULL;
+    unsigned i;
+
+    for (i = 0; i < DISCOVERY_SEARCH_MAX; i++) {
+        if (Searches[i].state == SEARCH_FREE) {
+            search = &Searches[i];
+            break;
+        }
+        if ((Searches[i].state == SEARCH_UNREACHABLE) &&
+            (!search || (Searches[i].deadline < search->deadline))) {
+            search = &Searches[i];
+        }
+    }
+    if (search) {
+        memset(search, 0, sizeof(SEARCH));
+        search->net = net;
+        search->backoff = DISCOVERY_BACKOFF_MIN;
+    }
+
+    return search;
+}
+
+static void search_send(SEARCH *search, uint64_t now)
+{
+    uint16_t net = search->net;
+
+    search->state = SEARCH_PENDING;
+    search->attempts++;
+    search->deadline = now + DISCOVERY_TIMEOUT;
+    Who_Is_Sent++;
+    send_network_message(NETWORK_MESSAGE_WHO_IS_ROUTER_TO_NETWORK, NULL, &net);
+}
+
+static void search_drop(SEARCH *search)
+{
+    BACMSG *msg;
+
+    while (search->pending_count) {
+        msg = &search->pending[search->pending_head];
+        free_data((MSG_DATA *)msg->data);
+        search->pending_head =
+            (search->pending_head + 1) % DISCOVERY_PENDING_MAX;
+        search->pending_count--;
+        Messages_Unreachable++;
+    }
+    search->pending_head = 0;
+}
+
+bool discovery_route(BACMSG *msg)
+{
+    MSG_DATA *data = (MSG_DATA *)msg->data;
+    uint16_t net = data->dest.net;
+    uint64_t now = discovery_clock();
+    SEARCH *search;
+    unsigned index;
+
+    search = search_find(net);
+    if (search && (search->state == SEARCH_UNREACHABLE)) {
+        if (now < search->deadline) {
+            Messages_Unreachable++;
+            return false;
+        }
+        /* cached long enough, so try again */
+        search->attempts = 0;
+        search_send(search, now);
+    } else if (!search) {
+        search = search_new(net);
+        if (!search) {
+            Messages_Dropped++;
+            return false;
+        }
+        PRINT(INFO, "Searching NET %hu...\n", net);
+        search_send(search, now);
+    }
+    if (search->pending_count >= DISCOVERY_PENDING_MAX) {
+        Messages_Dropped++;
+        return false;
+    }
+    index = (search->pending_head + search->pending_count) %
+        DISCOVERY_PENDING_MAX;
+    search->pending[index] = *msg;
+    search->pending_count++;
+    Messages_Parked++;
+
+    return true;
+}
+
+void discovery_found(uint16_t net)
+{
+    SEARCH *search = search_find(net);
+
+    if (!search || (search->state == SEARCH_FOUND)) {
+        return;
+    }
+    if (search->state == SEARCH_PENDING) {
+        Routes_Found++;
+    }
+    if (search->pending_count) {
+        search->state = SEARCH_FOUND;
+        Found_Count++;
+    } else {
+        search->state = SEARCH_FREE;
+    }
+}
+
+BACMSG *discovery_release(BACMSG *msg)
+{
+    SEARCH *search;
+    unsigned i;
+
+    if (Found_Count == 0) {
+        return NULL;
+    }
+    for (i = 0; i < DISCOVERY_SEARCH_MAX; i++) {
+        search = &Searches[i];
+        if (search->state != SEARCH_FOUND) {
+            continue;
+        }
+        *msg = search->pending[search->pending_head];
+        search->pending_head =
+            (search->pending_head + 1) % DISCOVERY_PENDING_MAX;
+        search->pending_count--;
+        if (search->pending_count == 0) {
+            search->state = SEARCH_FREE;
+            Found_Count--;
+        }
+        return msg;
+    }
+
+    return NULL;
+}
+
+int discovery_timeout(void)
+{
+    uint64_t now = discovery_clock();
+    uint64_t deadline = UINT64_MAX;
+    unsigned i;
+
+    /* only searches in progress have a timer; unreachable networks
+       are looked at when the next message for them arrives */
+    for (i = 0; i < DISCOVERY_SEARCH_MAX; i++) {
+        if ((Searches[i].state == SEARCH_PENDING) &&
+            (Searches[i].deadline < deadline)) {
+            deadline = Searches[i].deadline;
+        }
+    }
+    if (deadline == UINT64_MAX) {
+        return -1;
+    }
+    if (deadline <= now) {
+        return 0;
+    }
+
+    return (int)(deadline - now);
+}
+
+void discovery_timer(void)
+{
+    uint64_t now = discovery_clock();
+    SEARCH *search;
+    unsigned i;
+
+    for (i = 0; i < DISCOVERY_SEARCH_MAX; i++) {
+        search = &Searches[i];
+        if ((search->state != SEARCH_PENDING) || (now < search->deadline)) {
+            continue;
+        }
+        if (search->attempts < DISCOVERY_ATTEMPTS) {
+            search_send(search, now);
+            continue;
+        }
+        PRINT(INFO, "NET %hu unreachable for %lu s\n", search->net,
+            (unsigned long)(search->backoff / 1000));
+        search_drop(search);
+        search->state = SEARCH_UNREACHABLE;
+        search->deadline = now + search->backoff;
+        search->backoff *= 2;
+        if (search->backoff > DISCOVERY_BACKOFF_MAX) {
+            search->backoff = DISCOVERY_BACKOFF_MAX;
+        }
+    }
+}
+
+void discovery_print(void)
+{
+    PRINT(INFO,
+        "Route discovery: %lu Who-Is-Router-To-Network sent, %lu found, "
+        "%lu PDU parked, %lu unreachable, %lu dropped\n",
+        (unsigned long)Who_Is_Sent, (unsigned long)Routes_Found,
+        (unsigned long)Messages_Parked, (unsigned long)Messages_Unreachable,
+        (unsigned long)Messages_Dropped);
+}
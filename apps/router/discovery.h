@@ -0,0 +1,89 @@
+/**
+ * @file
+ * @date October 2026
+ * @brief Route discovery with Who-Is-Router-To-Network for unknown DNETs
+ *
+ * @section LICENSE
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+#ifndef DISCOVERY_H
+#define DISCOVERY_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "msgqueue.h"
+
+/* networks searched for, or remembered as unreachable, at the same time */
+#ifndef DISCOVERY_SEARCH_MAX
+#define DISCOVERY_SEARCH_MAX 32
+#endif
+
+/* messages parked for each network until a route is found */
+#ifndef DISCOVERY_PENDING_MAX
+#define DISCOVERY_PENDING_MAX 8
+#endif
+
+/* milliseconds to wait for I-Am-Router-To-Network */
+#ifndef DISCOVERY_TIMEOUT
+#define DISCOVERY_TIMEOUT 1000
+#endif
+
+/* Who-Is-Router-To-Network messages sent before giving up */
+#ifndef DISCOVERY_ATTEMPTS
+#define DISCOVERY_ATTEMPTS 3
+#endif
+
+/* milliseconds a network is remembered as unreachable. The time doubles
+   with every search that fails, up to the maximum. */
+#ifndef DISCOVERY_BACKOFF_MIN
+#define DISCOVERY_BACKOFF_MIN 5000
+#endif
+#ifndef DISCOVERY_BACKOFF_MAX
+#define DISCOVERY_BACKOFF_MAX 300000
+#endif
+
+/* find a route for a message whose DNET is unknown: the message is parked
+   and the network searched for. Returns false if the message was not
+   parked, and the caller frees it. */
+bool discovery_route(
+    BACMSG * msg);
+
+/* a route to the network was learned */
+void discovery_found(
+    uint16_t net);
+
+/* take a parked message whose network was found; returns NULL if none */
+BACMSG *discovery_release(
+    BACMSG * msg);
+
+/* milliseconds until discovery_timer() has work to do, or -1 */
+int discovery_timeout(
+    void);
+
+/* send Who-Is-Router-To-Network again, or give up on the network */
+void discovery_timer(
+    void);
+
+void discovery_print(
+    void);
+
+#endif /* end of DISCOVERY_H */
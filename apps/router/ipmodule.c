@@ -29,7 +29,6 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-#include <sys/ipc.h>
 #include "ipmodule.h"
 #include "bacnet/bacint.h"
 
@@ -40,105 +39,13 @@ uint8_t test_packet[] = { 0x81, 0x0a, 0x00, 0x16, /* BVLC header */
     0x55 }; /* APDU */
 #endif
 
-void *dl_ip_thread(void *pArgs)
-{
-    MSGBOX_ID msgboxid;
-    BACMSG msg_storage, *bacmsg = NULL;
-    MSG_DATA *msg_data;
-    ROUTER_PORT *port = (ROUTER_PORT *)pArgs;
-    IP_DATA ip_data; /* port specific parameters */
-    BACNET_ADDRESS address = { 0 };
-    int status;
-    uint8_t shutdown = 0;
-
-    /* initialize router port */
-    if (!dl_ip_init(port, &ip_data)) {
-        port->state = INIT_FAILED;
-        return NULL;
-    }
-
-    /* allocate buffer */
-    ip_data.max_buff = MAX_BIP_MPDU;
-    ip_data.buff = (uint8_t *)malloc(ip_data.max_buff);
-
-    if (ip_data.buff == NULL) {
-        port->state = INIT_FAILED;
-        return NULL;
-    }
-
-    msgboxid = create_msgbox();
-    if (msgboxid == INVALID_MSGBOX_ID) {
-        PRINT(ERROR, "Error: Failed to create message box");
-        port->state = INIT_FAILED;
-        return NULL;
-    }
-
-    port->port_id = msgboxid;
-    port->state = RUNNING;
-
-    while (!shutdown) {
-        /* check for incoming messages */
-        bacmsg = recv_from_msgbox(port->port_id, &msg_storage, IPC_NOWAIT);
-
-        if (bacmsg) {
-            switch (bacmsg->type) {
-                case DATA: {
-                    msg_data = (MSG_DATA *)bacmsg->data;
-                    memmove(&address.net, &msg_data->dest.net, 2);
-                    memmove(&address.mac_len, &msg_data->dest.len, 1);
-                    memmove(
-                        &address.mac[0], &msg_data->dest.adr[0], MAX_MAC_LEN);
-
-                    dl_ip_send(
-                        &ip_data, &address, msg_data->pdu, msg_data->pdu_len);
-
-                    check_data(msg_data);
-
-                    break;
-                }
-
-                case SERVICE: {
-                    switch (bacmsg->subtype) {
-                        case SHUTDOWN:
-                            del_msgbox(port->port_id);
-                            shutdown = 1;
-                            break;
-                        default:
-                            break;
-                    }
-                    break;
-                }
-
-                default:
-                    break;
-            }
-        } else {
-            status = dl_ip_recv(&ip_data, &msg_data, &address, 5);
-            if (status > 0) {
-                memmove(&msg_data->src.len, &address.mac_len, 1);
-                memmove(&msg_data->src.adr[0], &address.mac[0], MAX_MAC_LEN);
-                msg_storage.origin = port->port_id;
-                msg_storage.type = DATA;
-                msg_storage.data = msg_data;
-
-                if (!send_to_msgbox(port->main_id, &msg_storage)) {
-                    free_data(msg_data);
-                }
-            }
-        }
-    }
-
-    /* cleanup procedure */
-    dl_ip_cleanup(&ip_data);
-    port->state = FINISHED;
-    return NULL;
-}
-
 bool dl_ip_init(ROUTER_PORT *port, IP_DATA *ip_data)
 {
     struct sockaddr_in sin = { 0 };
     int socket_opt = 0;
     int status = 0; /* for error checking */
+    char ifname[IFNAMSIZ] = { 0 };
+    char *alias;
 
     /* setup port for later use */
     ip_data->port = htons(port->params.bip_params.port);
@@ -179,9 +86,15 @@ bool dl_ip_init(ROUTER_PORT *port, IP_DATA *ip_data)
     }
 
     /* Bind to device so we don't get routing loops between our
-       different ports. */
-    status = setsockopt(ip_data->socket, SOL_SOCKET, SO_BINDTODEVICE,
-        port->iface, strlen(port->iface));
+       different ports. An address alias, like eth0:1, is bound to its
+       device, and the ports on it use different UDP ports. */
+    strncpy(ifname, port->iface, sizeof(ifname) - 1);
+    alias = strchr(ifname, ':');
+    if (alias) {
+        *alias = 0;
+    }
+    status = setsockopt(ip_data->socket, SOL_SOCKET, SO_BINDTODEVICE, ifname,
+        strlen(ifname));
     if (status < 0) {
         close(ip_data->socket);
         return false;
@@ -201,6 +114,14 @@ bool dl_ip_init(ROUTER_PORT *port, IP_DATA *ip_data)
         return false;
     }
 
+    /* allocate buffer */
+    ip_data->max_buff = MAX_BIP_MPDU;
+    ip_data->buff = (uint8_t *)malloc(ip_data->max_buff);
+    if (ip_data->buff == NULL) {
+        close(ip_data->socket);
+        return false;
+    }
+
     /* add BIP address to router port structure */
     memcpy(&port->route_info.mac[0], &ip_data->local_addr.s_addr, 4);
     memcpy(&port->route_info.mac[4], &port->params.bip_params.port, 2);
@@ -229,8 +150,8 @@ int dl_ip_send(
 
     data->buff[0] = BVLL_TYPE_BACNET_IP;
     bip_dest.sin_family = AF_INET;
-    if (dest->net == BACNET_BROADCAST_NETWORK) {
-        /* broadcast */
+    if ((dest->net == BACNET_BROADCAST_NETWORK) || (dest->mac_len == 0)) {
+        /* global broadcast, or remote broadcast to this network */
         bip_dest.sin_addr.s_addr = data->broadcast_addr.s_addr;
         bip_dest.sin_port = data->port;
         data->buff[1] = BVLC_ORIGINAL_BROADCAST_NPDU;
@@ -267,6 +188,9 @@ int dl_ip_recv(
     struct timeval select_timeout;
     struct sockaddr_in sin = { 0 };
     socklen_t sin_len = sizeof(sin);
+    MSG_DATA *msg = NULL;
+    uint8_t *buff = data->buff;
+    size_t max_buff = data->max_buff;
 
     /* make sure the socket is open */
     if (data->socket < 0) {
@@ -285,34 +209,37 @@ int dl_ip_recv(
     FD_ZERO(&read_fds);
     FD_SET(data->socket, &read_fds);
 
+    int ret = select(data->socket + 1, &read_fds, NULL, NULL, &select_timeout);
+    if (ret <= 0) {
+        return 0;
+    }
+    /* receive straight into a packet buffer, with the original BVLC header
+       in the headroom; the datagram is dropped if the pool is empty */
+    msg = alloc_data();
+    if (msg) {
+        buff = &msg->buffer[MSG_DATA_HEADROOM - 4];
+        max_buff = sizeof(msg->buffer) - (MSG_DATA_HEADROOM - 4);
+    }
 #ifdef TEST_PACKET
     received_bytes = sizeof(test_packet);
-    memmove(data->buff, &test_packet, received_bytes);
+    memmove(buff, &test_packet, received_bytes);
     sin.sin_addr.s_addr = 0x7E1D40A;
     sin.sin_port = 0xC0BA;
 #else
-    int ret = select(data->socket + 1, &read_fds, NULL, NULL, &select_timeout);
-    /* see if there is a packet for us */
-    if (ret > 0) {
-        received_bytes = recvfrom(data->socket, (char *)&data->buff[0],
-            data->max_buff, 0, (struct sockaddr *)&sin, &sin_len);
-    } else {
-        return 0;
-    }
+    received_bytes = recvfrom(data->socket, (char *)&buff[0], max_buff, 0,
+        (struct sockaddr *)&sin, &sin_len);
 #endif
     PRINT(DEBUG, "received from %s\n", inet_ntoa(sin.sin_addr));
 
-    /* check for errors */
-    if (received_bytes <= 0) {
-        return 0;
-    }
-
-    /* the signature of a BACnet/IP packet */
-    if (data->buff[0] != BVLL_TYPE_BACNET_IP) {
+    /* check for errors, and the signature of a BACnet/IP packet */
+    if ((received_bytes <= 0) || !msg || (buff[0] != BVLL_TYPE_BACNET_IP)) {
+        if (msg) {
+            free_data(msg);
+        }
         return 0;
     }
 
-    switch (data->buff[1]) {
+    switch (buff[1]) {
         case BVLC_ORIGINAL_UNICAST_NPDU:
         case BVLC_ORIGINAL_BROADCAST_NPDU: {
             if ((sin.sin_addr.s_addr == data->local_addr.s_addr) &&
@@ -325,18 +252,14 @@ int dl_ip_recv(
                 memcpy(&src->mac[0], &sin.sin_addr.s_addr, 4);
                 memcpy(&src->mac[4], &sin.sin_port, 2);
 
-                (void)decode_unsigned16(&data->buff[2], &buff_len);
+                (void)decode_unsigned16(&buff[2], &buff_len);
                 /* subtract off the BVLC header */
                 buff_len -= 4;
-                if (buff_len < data->max_buff) {
-                    /* allocate data message stucture */
-                    (*msg_data) = (MSG_DATA *)malloc(sizeof(MSG_DATA));
-                    (*msg_data)->pdu_len = buff_len;
-                    (*msg_data)->pdu = (uint8_t *)malloc((*msg_data)->pdu_len);
+                if ((buff_len + 4) <= received_bytes) {
                     /* fill up data message structure */
-                    memmove(&(*msg_data)->pdu[0], &data->buff[4],
-                        (*msg_data)->pdu_len);
-                    memmove(&(*msg_data)->src, src, sizeof(BACNET_ADDRESS));
+                    msg->pdu = &buff[4];
+                    msg->pdu_len = buff_len;
+                    memmove(&msg->src, src, sizeof(BACNET_ADDRESS));
                 }
                 /* ignore packets that are too large */
                 else {
@@ -348,8 +271,8 @@ int dl_ip_recv(
         } break;
 
         case BVLC_FORWARDED_NPDU: {
-            memcpy(&sin.sin_addr.s_addr, &data->buff[4], 4);
-            memcpy(&sin.sin_port, &data->buff[8], 2);
+            memcpy(&sin.sin_addr.s_addr, &buff[4], 4);
+            memcpy(&sin.sin_port, &buff[8], 2);
             if ((sin.sin_addr.s_addr == data->local_addr.s_addr) &&
                 (sin.sin_port == data->port)) {
                 buff_len = 0;
@@ -358,18 +281,14 @@ int dl_ip_recv(
                 memcpy(&src->mac[0], &sin.sin_addr.s_addr, 4);
                 memcpy(&src->mac[4], &sin.sin_port, 2);
 
-                (void)decode_unsigned16(&data->buff[2], &buff_len);
+                (void)decode_unsigned16(&buff[2], &buff_len);
                 /* subtract off the BVLC header */
                 buff_len -= 10;
-                if (buff_len < data->max_buff) {
-                    /* allocate data message stucture */
-                    (*msg_data) = (MSG_DATA *)malloc(sizeof(MSG_DATA));
-                    (*msg_data)->pdu_len = buff_len;
-                    (*msg_data)->pdu = (uint8_t *)malloc((*msg_data)->pdu_len);
+                if ((buff_len + 10) <= received_bytes) {
                     /* fill up data message structure */
-                    memmove(&(*msg_data)->pdu[0], &data->buff[4 + 6],
-                        (*msg_data)->pdu_len);
-                    memmove(&(*msg_data)->src, src, sizeof(BACNET_ADDRESS));
+                    msg->pdu = &buff[4 + 6];
+                    msg->pdu_len = buff_len;
+                    memmove(&msg->src, src, sizeof(BACNET_ADDRESS));
                 } else {
                     /* ignore packets that are too large */
                     buff_len = 0;
@@ -382,6 +301,12 @@ int dl_ip_recv(
 
             break;
     }
+    if (buff_len > 0) {
+        (*msg_data) = msg;
+    } else {
+        free_data(msg);
+    }
+
     return buff_len;
 }
 
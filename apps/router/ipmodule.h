@@ -54,9 +54,6 @@ typedef struct ip_data {
 } IP_DATA;
 
 
-void *dl_ip_thread(
-    void *pArgs);
-
 bool dl_ip_init(
     ROUTER_PORT * port,
     IP_DATA * data);
@@ -46,12 +46,14 @@
 #include <sys/ioctl.h>
 #include <net/if.h>
 #include <pthread.h>
+#include <signal.h>
+#include <poll.h>
 #include <termios.h>
 #include "msgqueue.h"
 #include "portthread.h"
+#include "portengine.h"
 #include "network_layer.h"
-#include "ipmodule.h"
-#include "mstpmodule.h"
+#include "discovery.h"
 
 #define KEY_ESC 27
 
@@ -59,21 +61,25 @@ ROUTER_PORT *head = NULL; /* pointer to list of router ports */
 
 int port_count;
 
+/* wakes the routing core when a port passes it a message */
+static MSG_EVENT Router_Event = { -1, 0 };
+
+/* set by SIGUSR1 to print the port latency histograms */
+static volatile sig_atomic_t Print_Latency;
+
 void print_help();
 
 bool read_config(char *filepath);
 
 bool parse_cmd(int argc, char *argv[]);
 
-void init_port_threads(ROUTER_PORT *port_list);
-
 bool init_router();
 
 void cleanup();
 
 void print_msg(BACMSG *msg);
 
-uint16_t process_msg(BACMSG *msg, MSG_DATA *data, uint8_t **buff);
+uint16_t process_msg(BACMSG *msg);
 
 uint16_t get_next_free_dnet();
 
@@ -81,13 +87,126 @@ int kbhit();
 
 inline bool is_network_msg(BACMSG *msg);
 
+static void print_latency_handler(int signo)
+{
+    (void)signo;
+    Print_Latency = 1;
+}
+
+/* route one message received from a port; its packet buffer is
+   forwarded or answered in place, or freed */
+static void route_msg(BACMSG *bacmsg)
+{
+    ROUTER_PORT *port;
+    MSG_DATA *msg_data = (MSG_DATA *)bacmsg->data;
+    int16_t buff_len = 0;
+    unsigned targets = 0;
+
+    switch (bacmsg->type) {
+        case DATA: {
+            MSGBOX_ID msg_src = bacmsg->origin;
+
+            /* print_msg(bacmsg); */
+
+            if (is_network_msg(bacmsg)) {
+                buff_len = process_network_message(bacmsg);
+                if (buff_len == 0) {
+                    free_data(msg_data);
+                    break;
+                }
+            } else {
+                buff_len = process_msg(bacmsg);
+            }
+
+            /* if buff_len */
+            /* >0 - form new message and send */
+            /* =-1 - try to find next router */
+            /* other value - discard message */
+
+            if (buff_len > 0) {
+                /* form new message */
+                msg_data->pdu_len = buff_len;
+                msg_data->ref_count = 1;
+                bacmsg->origin = head->main_id;
+                bacmsg->type = DATA;
+
+                /* print_msg(bacmsg); */
+
+                if (is_network_msg(bacmsg)) {
+                    if (!send_to_msgbox(msg_src, bacmsg)) {
+                        check_data(msg_data);
+                    }
+                } else if (msg_data->dest.net != BACNET_BROADCAST_NETWORK) {
+                    port = find_dnet(msg_data->dest.net, &msg_data->dest);
+                    if (!send_to_msgbox(port->port_id, bacmsg)) {
+                        check_data(msg_data);
+                    }
+                } else {
+                    /* one shared copy for every port; the reference count
+                       is set before the first port can release it */
+                    for (port = head; port != NULL; port = port->next) {
+                        if (port->port_id != msg_src &&
+                            port->state == RUNNING) {
+                            targets++;
+                        }
+                    }
+                    if (targets == 0) {
+                        free_data(msg_data);
+                        break;
+                    }
+                    msg_data->ref_count = targets;
+                    for (port = head; port != NULL; port = port->next) {
+                        if (port->port_id == msg_src ||
+                            port->state != RUNNING) {
+                            continue;
+                        }
+                        if (!send_to_msgbox(port->port_id, bacmsg)) {
+                            check_data(msg_data);
+                        }
+                    }
+                }
+            } else if (buff_len == -1) {
+                /* park the message until the NET is found */
+                if (!discovery_route(bacmsg)) {
+                    free_data(msg_data);
+                }
+            } else {
+                /* if invalid message send Reject-Message-To-Network;
+                   -2 is a message discarded on purpose */
+                if (buff_len != -2) {
+                    PRINT(ERROR, "Error: Invalid message\n");
+                }
+                free_data(msg_data);
+            }
+        } break;
+        case SERVICE:
+        default:
+            break;
+    }
+}
+
+/* true if any port has passed messages to the routing core */
+static bool router_pending(void)
+{
+    ROUTER_PORT *port;
+
+    for (port = head; port != NULL; port = port->next) {
+        if (!msgbox_empty(port->main_id)) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
 int main(int argc, char *argv[])
 {
     ROUTER_PORT *port;
     BACMSG msg_storage, *bacmsg = NULL;
-    MSG_DATA *msg_data = NULL;
-    uint8_t *buff = NULL;
-    int16_t buff_len = 0;
+    struct pollfd fds[2];
+    nfds_t nfds = 1;
+    bool received;
+    int status;
 
     atexit(cleanup);
 
@@ -101,11 +220,18 @@ int main(int argc, char *argv[])
         return -1;
     }
 
-    send_network_message(
-        NETWORK_MESSAGE_I_AM_ROUTER_TO_NETWORK, msg_data, &buff, NULL);
+    send_network_message(NETWORK_MESSAGE_I_AM_ROUTER_TO_NETWORK, NULL, NULL);
 
+    fds[0].fd = Router_Event.fd;
+    fds[0].events = POLLIN;
+    if (isatty(STDIN_FILENO)) {
+        /* wake up for the escape key too */
+        fds[1].fd = STDIN_FILENO;
+        fds[1].events = POLLIN;
+        nfds = 2;
+    }
     while (true) {
-        if (kbhit()) {
+        if ((nfds > 1) && kbhit()) {
             char ch = getchar();
             if (ch == KEY_ESC) {
                 PRINT(INFO, "Received shutdown. Exiting...\n");
@@ -113,86 +239,37 @@ int main(int argc, char *argv[])
             }
         }
 
-        /* blocking dequeue here */
-        bacmsg = recv_from_msgbox(head->main_id, &msg_storage, 0);
-        if (bacmsg) {
-            switch (bacmsg->type) {
-                case DATA: {
-                    MSGBOX_ID msg_src = bacmsg->origin;
-
-                    /* allocate message structure */
-                    msg_data = malloc(sizeof(MSG_DATA));
-                    if (!msg_data) {
-                        PRINT(ERROR, "Error: Could not allocate memory\n");
-                        break;
-                    }
-
-                    /* print_msg(bacmsg); */
-
-                    if (is_network_msg(bacmsg)) {
-                        buff_len =
-                            process_network_message(bacmsg, msg_data, &buff);
-                        if (buff_len == 0) {
-                            free_data(bacmsg->data);
-                            break;
-                        }
-                    } else {
-                        buff_len = process_msg(bacmsg, msg_data, &buff);
-                    }
-
-                    /* if buff_len */
-                    /* >0 - form new message and send */
-                    /* =-1 - try to find next router */
-                    /* other value - discard message */
-
-                    if (buff_len > 0) {
-                        /* form new message */
-                        msg_data->pdu = buff;
-                        msg_data->pdu_len = buff_len;
-                        msg_storage.origin = head->main_id;
-                        msg_storage.type = DATA;
-                        msg_storage.data = msg_data;
-
-                        /* print_msg(bacmsg); */
-
-                        if (is_network_msg(bacmsg)) {
-                            msg_data->ref_count = 1;
-                            send_to_msgbox(msg_src, &msg_storage);
-                        } else if (msg_data->dest.net !=
-                            BACNET_BROADCAST_NETWORK) {
-                            msg_data->ref_count = 1;
-                            port =
-                                find_dnet(msg_data->dest.net, &msg_data->dest);
-                            send_to_msgbox(port->port_id, &msg_storage);
-                        } else {
-                            port = head;
-                            msg_data->ref_count = port_count - 1;
-                            while (port != NULL) {
-                                if (port->port_id == msg_src ||
-                                    port->state == FINISHED) {
-                                    port = port->next;
-                                    continue;
-                                }
-                                send_to_msgbox(port->port_id, &msg_storage);
-                                port = port->next;
-                            }
-                        }
-                    } else if (buff_len == -1) {
-                        uint16_t net = msg_data->dest.net; /* NET to find */
-                        PRINT(INFO, "Searching NET...\n");
-                        send_network_message(
-                            NETWORK_MESSAGE_WHO_IS_ROUTER_TO_NETWORK, msg_data,
-                            &buff, &net);
-                    } else {
-                        /* if invalid message send Reject-Message-To-Network */
-                        PRINT(ERROR, "Error: Invalid message\n");
-                        free_data(msg_data);
-                    }
-                } break;
-                case SERVICE:
-                default:
-                    break;
+        /* sleep until a port passes a message to us */
+        msg_event_sleep(&Router_Event);
+        fds[0].revents = 0;
+        status = 0;
+        if (!router_pending()) {
+            status = poll(fds, nfds, discovery_timeout());
+        }
+        msg_event_awake(
+            &Router_Event, (status > 0) && (fds[0].revents & POLLIN));
+        if (Print_Latency) {
+            Print_Latency = 0;
+            for (port = head; port != NULL; port = port->next) {
+                port_latency_print(port);
+            }
+            discovery_print();
+        }
+        discovery_timer();
+        /* take one message from each port in turn */
+        do {
+            received = false;
+            for (port = head; port != NULL; port = port->next) {
+                bacmsg = recv_from_msgbox(port->main_id, &msg_storage);
+                if (bacmsg) {
+                    route_msg(bacmsg);
+                    received = true;
+                }
             }
+        } while (received);
+        /* messages whose NET was found in the meantime */
+        while (discovery_release(&msg_storage)) {
+            route_msg(&msg_storage);
         }
     }
 
@@ -497,8 +574,9 @@ bool parse_cmd(int argc, char *argv[])
 
                     dev_opt =
                         getopt_long(argc, argv, bipString, Options, &index);
-                    while (dev_opt != -1 && dev_opt != 'd') {
+                    while (dev_opt != -1 && dev_opt != 'D') {
                         switch (dev_opt) {
+                            case 'p':
                             case 'P':
                                 result = atoi(optarg);
                                 if (result) {
@@ -635,49 +713,29 @@ bool parse_cmd(int argc, char *argv[])
     return true;
 }
 
-void init_port_threads(ROUTER_PORT *port_list)
-{
-    ROUTER_PORT *port = port_list;
-    pthread_t *thread;
-
-    while (port != NULL) {
-        switch (port->type) {
-            case BIP:
-                port->func = &dl_ip_thread;
-                break;
-            case MSTP:
-                port->func = &dl_mstp_thread;
-                break;
-        }
-
-        port->state = INIT;
-        thread = (pthread_t *)malloc(sizeof(pthread_t));
-        pthread_create(thread, NULL, port->func, port);
-
-        pthread_detach(*thread); /* for proper thread termination */
-
-        port = port->next;
-    }
-}
-
 bool init_router()
 {
-    MSGBOX_ID msgboxid;
     ROUTER_PORT *port;
 
-    msgboxid = create_msgbox();
-    if (msgboxid == INVALID_MSGBOX_ID) {
+    if (!msg_event_init(&Router_Event)) {
         return false;
     }
 
     port = head;
-    /* add main message box id to all ports */
+    /* every port passes messages to the routing core in its own box */
     while (port != NULL) {
-        port->main_id = msgboxid;
+        add_dnet(port, port->route_info.net, NULL);
+        port->main_id = create_msgbox(&Router_Event);
+        if (port->main_id == INVALID_MSGBOX_ID) {
+            return false;
+        }
         port = port->next;
     }
 
-    init_port_threads(head);
+    if (!port_engine_start(head)) {
+        return false;
+    }
+    signal(SIGUSR1, print_latency_handler);
 
     /* wait for port initialization */
     port = head;
@@ -711,8 +769,6 @@ void cleanup()
     msg.type = SERVICE;
     msg.subtype = SHUTDOWN;
 
-    del_msgbox(head->main_id); /* close routers message box */
-
     /* send shutdown message to all router ports */
     port = head;
     while (port != NULL) {
@@ -724,8 +780,10 @@ void cleanup()
 
     port = head;
     while (port != NULL) {
-        if (port->state == FINISHED) {
-            cleanup_dnets(port->route_info.dnets);
+        if (port->state == FINISHED || port->state == INIT_FAILED) {
+            port_latency_print(port);
+            del_msgbox(port->main_id);
+            del_msgbox(port->port_id);
             port = port->next;
             free(head->iface);
             free(head);
@@ -733,7 +791,8 @@ void cleanup()
         }
     }
 
-    pthread_mutex_destroy(&msg_lock);
+    discovery_print();
+    msg_event_cleanup(&Router_Event);
 }
 
 void print_msg(BACMSG *msg)
@@ -752,8 +811,11 @@ void print_msg(BACMSG *msg)
     }
 }
 
-uint16_t process_msg(BACMSG *msg, MSG_DATA *data, uint8_t **buff)
+/* rewrite the NPDU header of a received message in place for the
+   sending port; returns the new PDU length, or -1 to search the NET */
+uint16_t process_msg(BACMSG *msg)
 {
+    MSG_DATA *data = (MSG_DATA *)msg->data;
     BACNET_ADDRESS addr;
     BACNET_NPDU_DATA npdu_data;
     ROUTER_PORT *srcport;
@@ -764,8 +826,6 @@ uint16_t process_msg(BACMSG *msg, MSG_DATA *data, uint8_t **buff)
     int apdu_len;
     int npdu_len;
 
-    memmove(data, msg->data, sizeof(MSG_DATA));
-
     apdu_offset = npdu_decode(data->pdu, &data->dest, &addr, &npdu_data);
     apdu_len = data->pdu_len - apdu_offset;
 
@@ -774,6 +834,13 @@ uint16_t process_msg(BACMSG *msg, MSG_DATA *data, uint8_t **buff)
     assert(srcport);
 
     if (srcport && destport) {
+        if (data->dest.net) {
+            if (npdu_data.hop_count == 0) {
+                PRINT(INFO, "Message discarded: hop count exhausted\n");
+                return -2;
+            }
+            npdu_data.hop_count--;
+        }
         data->src.net = srcport->route_info.net;
 
         /* if received from another router save real source address (not other
@@ -793,21 +860,23 @@ uint16_t process_msg(BACMSG *msg, MSG_DATA *data, uint8_t **buff)
             npdu_len = npdu_encode_pdu(npdu, NULL, &data->src, &npdu_data);
         }
 
-        buff_len = npdu_len + data->pdu_len - apdu_offset;
+        buff_len = npdu_len + apdu_len;
 
-        *buff = (uint8_t *)malloc(buff_len);
-        memmove(*buff, npdu, npdu_len); /* copy newly formed NPDU */
-        memmove(*buff + npdu_len, &data->pdu[apdu_offset],
-            apdu_len); /* copy APDU */
+        /* the APDU stays where it is, and the newly formed NPDU goes in
+           front of it, into the headroom if it is longer than before */
+        data->pdu = &data->pdu[apdu_offset] - npdu_len;
+        memmove(data->pdu, npdu, npdu_len);
 
+    } else if (srcport &&
+        (get_dnet_state(data->dest.net) == DNET_BUSY)) {
+        /* the next router asked us to hold off */
+        PRINT(INFO, "Message discarded: NET busy\n");
+        return -2;
     } else {
         /* request net search */
         return -1;
     }
 
-    /* delete received message */
-    free_data((MSG_DATA *)msg->data);
-
     return buff_len;
 }
 
@@ -30,44 +30,127 @@
 #include <errno.h>
 #include <string.h>
 #include <stdlib.h>
-#include <pthread.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
 #include "msgqueue.h"
 
-pthread_mutex_t msg_lock = PTHREAD_MUTEX_INITIALIZER;
+#define MSGBOX_LOAD(p) __atomic_load_n((p), __ATOMIC_ACQUIRE)
+#define MSGBOX_STORE(p, v) __atomic_store_n((p), (v), __ATOMIC_RELEASE)
 
-MSGBOX_ID create_msgbox()
+/* producer and consumer indexes live on separate cache lines */
+struct _msgbox {
+    uint32_t head; /* written by the producer */
+    uint8_t head_pad[64 - sizeof(uint32_t)];
+    uint32_t tail; /* written by the consumer */
+    uint8_t tail_pad[64 - sizeof(uint32_t)];
+    MSG_EVENT *event;
+    BACMSG msgs[MSGBOX_SIZE];
+};
+
+/* the pool hands out buffers it never used before, then recycles the
+   freed ones through a lock-free list. The list head holds the index of
+   the first buffer plus one, and a tag that changes with every update
+   so that a stale compare-and-swap fails. */
+static MSG_DATA Data_Pool[MSG_DATA_POOL_SIZE];
+static uint32_t Data_Pool_Used;
+static uint64_t Data_Pool_Free;
+
+bool msg_event_init(MSG_EVENT *event)
 {
-    MSGBOX_ID msgboxid;
+    event->sleeping = 0;
+    event->fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
 
-    msgboxid = msgget(IPC_PRIVATE, 0666 | IPC_CREAT);
-    if (msgboxid == INVALID_MSGBOX_ID) {
-        return INVALID_MSGBOX_ID;
+    return event->fd >= 0;
+}
+
+void msg_event_cleanup(MSG_EVENT *event)
+{
+    if (event->fd >= 0) {
+        close(event->fd);
+        event->fd = -1;
+    }
+}
+
+void msg_event_sleep(MSG_EVENT *event)
+{
+    /* sequentially consistent, so that either the consumer sees the
+       message in its box or the producer sees the consumer sleeping */
+    __atomic_store_n(&event->sleeping, 1, __ATOMIC_SEQ_CST);
+}
+
+void msg_event_awake(MSG_EVENT *event, bool signalled)
+{
+    uint64_t value;
+
+    __atomic_store_n(&event->sleeping, 0, __ATOMIC_SEQ_CST);
+    if (signalled) {
+        (void)read(event->fd, &value, sizeof(value));
+    }
+}
+
+void msg_event_signal(MSG_EVENT *event)
+{
+    uint64_t value = 1;
+
+    if (event && __atomic_exchange_n(&event->sleeping, 0, __ATOMIC_SEQ_CST)) {
+        (void)write(event->fd, &value, sizeof(value));
+    }
+}
+
+MSGBOX_ID create_msgbox(MSG_EVENT *event)
+{
+    MSGBOX_ID msgbox;
+
+    msgbox = (MSGBOX_ID)calloc(1, sizeof(struct _msgbox));
+    if (msgbox) {
+        msgbox->event = event;
     }
 
-    return msgboxid;
+    return msgbox;
 }
 
 bool send_to_msgbox(MSGBOX_ID dest, BACMSG *msg)
 {
-    int err;
+    uint32_t head;
 
-    err = msgsnd(dest, msg, sizeof(BACMSG) - sizeof(MSGTYPE), 0);
-    if (err) {
+    if (dest == INVALID_MSGBOX_ID) {
+        return false;
+    }
+    head = dest->head;
+    if ((head - MSGBOX_LOAD(&dest->tail)) >= MSGBOX_SIZE) {
         return false;
     }
+    dest->msgs[head & (MSGBOX_SIZE - 1)] = *msg;
+    MSGBOX_STORE(&dest->head, head + 1);
+    msg_event_signal(dest->event);
+
     return true;
 }
 
-BACMSG *recv_from_msgbox(MSGBOX_ID src, BACMSG *msg, int flags)
+BACMSG *recv_from_msgbox(MSGBOX_ID src, BACMSG *msg)
 {
-    int recv_bytes;
+    uint32_t tail;
 
-    recv_bytes = msgrcv(src, msg, sizeof(BACMSG) - sizeof(MSGTYPE), 0, flags);
-    if (recv_bytes > 0) {
-        return msg;
-    } else {
+    if (src == INVALID_MSGBOX_ID) {
         return NULL;
     }
+    tail = src->tail;
+    if (tail == MSGBOX_LOAD(&src->head)) {
+        return NULL;
+    }
+    *msg = src->msgs[tail & (MSGBOX_SIZE - 1)];
+    MSGBOX_STORE(&src->tail, tail + 1);
+
+    return msg;
+}
+
+bool msgbox_empty(MSGBOX_ID src)
+{
+    if (src == INVALID_MSGBOX_ID) {
+        return true;
+    }
+
+    return src->tail == MSGBOX_LOAD(&src->head);
 }
 
 void del_msgbox(MSGBOX_ID msgboxid)
@@ -75,28 +158,65 @@ void del_msgbox(MSGBOX_ID msgboxid)
     if (msgboxid == INVALID_MSGBOX_ID) {
         return;
     } else {
-        msgctl(msgboxid, IPC_RMID, NULL);
+        free(msgboxid);
     }
 }
 
-void free_data(MSG_DATA *data)
+MSG_DATA *alloc_data(void)
 {
-    if (data->pdu) {
-        free(data->pdu);
-        data->pdu = NULL;
+    MSG_DATA *data = NULL;
+    uint64_t head, next;
+    uint32_t index;
+
+    head = __atomic_load_n(&Data_Pool_Free, __ATOMIC_ACQUIRE);
+    while ((uint32_t)head) {
+        index = (uint32_t)head - 1;
+        next = (((head >> 32) + 1) << 32) |
+            __atomic_load_n(&Data_Pool[index].next_free, __ATOMIC_RELAXED);
+        if (__atomic_compare_exchange_n(&Data_Pool_Free, &head, next, true,
+                __ATOMIC_ACQUIRE, __ATOMIC_ACQUIRE)) {
+            data = &Data_Pool[index];
+            break;
+        }
     }
-    if (data) {
-        free(data);
-        data = NULL;
+    if (!data) {
+        if (__atomic_load_n(&Data_Pool_Used, __ATOMIC_RELAXED) >=
+            MSG_DATA_POOL_SIZE) {
+            return NULL;
+        }
+        index = __atomic_fetch_add(&Data_Pool_Used, 1, __ATOMIC_RELAXED);
+        if (index >= MSG_DATA_POOL_SIZE) {
+            return NULL;
+        }
+        data = &Data_Pool[index];
     }
+    memset(&data->dest, 0, sizeof(data->dest));
+    memset(&data->src, 0, sizeof(data->src));
+    data->pdu = &data->buffer[MSG_DATA_HEADROOM];
+    data->pdu_len = 0;
+    data->ref_count = 1;
+    data->timestamp = 0;
+
+    return data;
+}
+
+void free_data(MSG_DATA *data)
+{
+    uint32_t index = (uint32_t)(data - Data_Pool);
+    uint64_t head, next;
+
+    head = __atomic_load_n(&Data_Pool_Free, __ATOMIC_RELAXED);
+    do {
+        __atomic_store_n(&data->next_free, (uint32_t)head, __ATOMIC_RELAXED);
+        next = (((head >> 32) + 1) << 32) | (index + 1);
+    } while (!__atomic_compare_exchange_n(&Data_Pool_Free, &head, next, true,
+        __ATOMIC_RELEASE, __ATOMIC_RELAXED));
 }
 
 void check_data(MSG_DATA *data)
 {
-    /* lock and decrement messages reference count */
-    pthread_mutex_lock(&msg_lock);
-    if (--data->ref_count == 0) {
+    /* decrement messages reference count */
+    if (__atomic_sub_fetch(&data->ref_count, 1, __ATOMIC_ACQ_REL) == 0) {
         free_data(data);
     }
-    pthread_mutex_unlock(&msg_lock);
 }
@@ -31,17 +31,35 @@
 
 #include <stdint.h>
 #include <stdbool.h>
-#include <sys/types.h>
-#include <sys/ipc.h>
-#include <sys/msg.h>
 #include "bacnet/bacdef.h"
 #include "bacnet/npdu.h"
 
-extern pthread_mutex_t msg_lock;
+/* messages each message box holds. Must be a power of two. */
+#ifndef MSGBOX_SIZE
+#define MSGBOX_SIZE 1024
+#endif
 
-#define INVALID_MSGBOX_ID -1
+/* packet buffers in the pool, enough for every message in flight */
+#ifndef MSG_DATA_POOL_SIZE
+#define MSG_DATA_POOL_SIZE 2048
+#endif
 
-typedef int MSGBOX_ID;
+/* room in front of a received PDU, so that the router can write a longer
+   NPDU header in place. Also holds the B/IP BVLC header on receive. */
+#define MSG_DATA_HEADROOM MAX_NPDU
+
+#define INVALID_MSGBOX_ID NULL
+
+/* a message box is a lock-free ring with a single producer thread
+   and a single consumer thread */
+typedef struct _msgbox *MSGBOX_ID;
+
+/* wakes the consumer of one or more message boxes. The producer writes
+   the eventfd only when the consumer has announced that it sleeps. */
+typedef struct _msg_event {
+    int fd;
+    int sleeping;
+} MSG_EVENT;
 
 typedef enum {
     DATA = 1,
@@ -59,35 +77,74 @@ typedef struct _message {
     MSGBOX_ID origin;
     MSGSUBTYPE subtype;
     void *data;
-    /* add timestamp */
 } BACMSG;
 
-/* specific message type data structures */
+/* specific message type data structures. The PDU is kept in the buffer
+   of the message, which comes from a pool, so no memory is allocated
+   while routing. */
 typedef struct _msg_data {
     BACNET_ADDRESS dest;
     BACNET_ADDRESS src;
-    uint8_t *pdu;
+    uint8_t *pdu;       /* somewhere in buffer */
     uint16_t pdu_len;
+    /* one reference for every message box the data was sent to;
+       changed atomically since ports run in other threads */
     uint8_t ref_count;
+    /* microseconds when the datalink received the PDU, or zero
+       for messages created by the router */
+    uint64_t timestamp;
+    uint32_t next_free;         /* pool free list */
+    uint8_t buffer[MSG_DATA_HEADROOM + MAX_PDU];
 } MSG_DATA;
 
+bool msg_event_init(
+    MSG_EVENT * event);
+
+void msg_event_cleanup(
+    MSG_EVENT * event);
+
+/* consumer is about to sleep on event->fd. It must look at its message
+   boxes once more afterwards, and not sleep if any of them has messages */
+void msg_event_sleep(
+    MSG_EVENT * event);
+
+/* consumer is awake again; drains the eventfd if it was signalled */
+void msg_event_awake(
+    MSG_EVENT * event,
+    bool signalled);
+
+/* producer wakes a sleeping consumer */
+void msg_event_signal(
+    MSG_EVENT * event);
+
+/* message box whose consumer sleeps on the given event */
 MSGBOX_ID create_msgbox(
-    );
+    MSG_EVENT * event);
 
-/* returns sent byte count */
+/* returns false if the message box is full. Called by the producer only. */
 bool send_to_msgbox(
     MSGBOX_ID dest,
     BACMSG * msg);
 
-/* returns received message */
+/* returns received message, or NULL if the message box is empty.
+   Never blocks. Called by the consumer only. */
 BACMSG *recv_from_msgbox(
     MSGBOX_ID src,
-    BACMSG * msg,
-    int flags);
+    BACMSG * msg);
+
+/* true if the message box has no messages. Called by the consumer only. */
+bool msgbox_empty(
+    MSGBOX_ID src);
 
 void del_msgbox(
     MSGBOX_ID msgboxid);
 
+/* take a message data structure from the pool, with the PDU at the end
+   of the headroom and one reference. Returns NULL if the pool is empty.
+   Any thread may allocate and free. */
+MSG_DATA *alloc_data(
+    void);
+
 /* free message data structure */
 void free_data(
     MSG_DATA * data);
@@ -29,149 +29,111 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-#include <sys/ipc.h>
 #include "mstpmodule.h"
 #include "bacnet/bacint.h"
-#include "dlmstp_linux.h"
 #include <termios.h>
 
-#define MSTP_THREAD_PRINT_ENABLED
-#ifdef MSTP_THREAD_PRINT_ENABLED
-#define mstp_thread_debug(...) fprintf(stderr, __VA_ARGS__)
-#else
-#define mstp_thread_debug(...)
-#endif
-
-void *dl_mstp_thread(void *pArgs)
+bool dl_mstp_init(ROUTER_PORT *port, MSTP_DATA *data)
 {
-    ROUTER_PORT *port = (ROUTER_PORT *)pArgs;
-    struct mstp_port_struct_t mstp_port = { (MSTP_RECEIVE_STATE)0 };
-    volatile SHARED_MSTP_DATA shared_port_data = { 0 };
-    uint16_t pdu_len;
-    uint8_t shutdown = 0;
+    struct mstp_port_struct_t *mstp_port = &data->mstp_port;
+    SHARED_MSTP_DATA *shared_port_data = &data->shared_port_data;
 
-    shared_port_data.Treply_timeout = 260;
-    shared_port_data.MSTP_Packets = 0;
-    shared_port_data.Tusage_timeout = 30;
-    shared_port_data.RS485_Handle = -1;
-    shared_port_data.RS485_Baud = B38400;
-    shared_port_data.RS485MOD = 0;
+    memset(data, 0, sizeof(MSTP_DATA));
+    shared_port_data->Treply_timeout = 260;
+    shared_port_data->MSTP_Packets = 0;
+    shared_port_data->Tusage_timeout = 30;
+    shared_port_data->RS485_Handle = -1;
+    shared_port_data->RS485_Baud = B38400;
+    shared_port_data->RS485MOD = 0;
 
     switch (port->params.mstp_params.databits) {
         case 5:
-            shared_port_data.RS485MOD = CS5;
+            shared_port_data->RS485MOD = CS5;
             break;
         case 6:
-            shared_port_data.RS485MOD = CS6;
+            shared_port_data->RS485MOD = CS6;
             break;
         case 7:
-            shared_port_data.RS485MOD = CS7;
+            shared_port_data->RS485MOD = CS7;
             break;
         default:
-            shared_port_data.RS485MOD = CS8;
+            shared_port_data->RS485MOD = CS8;
             break;
     }
 
     switch (port->params.mstp_params.parity) {
         case PARITY_EVEN:
-            shared_port_data.RS485MOD |= PARENB;
+            shared_port_data->RS485MOD |= PARENB;
             break;
         case PARITY_ODD:
-            shared_port_data.RS485MOD |= PARENB | PARODD;
+            shared_port_data->RS485MOD |= PARENB | PARODD;
             break;
         default:
             break;
     }
 
     if (port->params.mstp_params.stopbits == 2) {
-        shared_port_data.RS485MOD |= CSTOPB;
+        shared_port_data->RS485MOD |= CSTOPB;
     }
 
-    mstp_port.UserData = (void *)&shared_port_data;
-    dlmstp_set_baud_rate(&mstp_port, port->params.mstp_params.baudrate);
-    dlmstp_set_mac_address(&mstp_port, port->route_info.mac[0]);
-    dlmstp_set_max_info_frames(&mstp_port, port->params.mstp_params.max_frames);
-    dlmstp_set_max_master(&mstp_port, port->params.mstp_params.max_master);
-    if (!dlmstp_init(&mstp_port, port->iface)) {
-        printf("MSTP %s init failed. Stop.\n", port->iface);
+    mstp_port->UserData = (void *)shared_port_data;
+    dlmstp_set_baud_rate(mstp_port, port->params.mstp_params.baudrate);
+    dlmstp_set_mac_address(mstp_port, port->route_info.mac[0]);
+    dlmstp_set_max_info_frames(mstp_port, port->params.mstp_params.max_frames);
+    dlmstp_set_max_master(mstp_port, port->params.mstp_params.max_master);
+    if (!dlmstp_init(mstp_port, port->iface)) {
+        PRINT(ERROR, "MSTP %s init failed. Stop.\n", port->iface);
+        return false;
     }
 
-    port->port_id = create_msgbox();
-    if (port->port_id == INVALID_MSGBOX_ID) {
-        port->state = INIT_FAILED;
-        return NULL;
-    }
-
-    port->state = RUNNING;
-
-    while (!shutdown) {
-        /* message loop */
-        BACMSG msg_storage, *bacmsg;
-        MSG_DATA *msg_data;
-
-        bacmsg = recv_from_msgbox(port->port_id, &msg_storage, IPC_NOWAIT);
-
-        if (bacmsg) {
-            switch (bacmsg->type) {
-                case DATA:
-                    msg_data = (MSG_DATA *)bacmsg->data;
-
-                    if (msg_data->dest.net == BACNET_BROADCAST_NETWORK) {
-                        dlmstp_get_broadcast_address(&(msg_data->dest));
-                    } else {
-                        msg_data->dest.mac[0] = msg_data->dest.adr[0];
-                        msg_data->dest.mac_len = 1;
-                    }
-
-                    dlmstp_send_pdu(&mstp_port, &(msg_data->dest),
-                        msg_data->pdu, msg_data->pdu_len);
-
-                    check_data(msg_data);
+    return true;
+}
 
-                    break;
-                case SERVICE:
-                    switch (bacmsg->subtype) {
-                        case SHUTDOWN:
-                            shutdown = 1;
-                            break;
-                        default:
-                            break;
-                    }
-                    break;
-                default:
-                    continue;
-                    break;
-            }
-        } else {
-            pdu_len = dlmstp_receive(&mstp_port, NULL, NULL, 0, 5);
+int dl_mstp_send(
+    MSTP_DATA *data, BACNET_ADDRESS *dest, uint8_t *pdu, unsigned pdu_len)
+{
+    if (dest->net == BACNET_BROADCAST_NETWORK) {
+        dlmstp_get_broadcast_address(dest);
+    } else {
+        dest->mac[0] = dest->adr[0];
+        dest->mac_len = 1;
+    }
 
-            if (pdu_len > 0) {
-                msg_data = (MSG_DATA *)malloc(sizeof(MSG_DATA));
-                memmove(&(msg_data->src),
-                    (const void *)&(shared_port_data.Receive_Packet.address),
-                    sizeof(shared_port_data.Receive_Packet.address));
-                msg_data->src.adr[0] = msg_data->src.mac[0];
-                msg_data->src.len = 1;
-                msg_data->pdu = (uint8_t *)malloc(pdu_len);
-                memmove(msg_data->pdu,
-                    (const void *)&(shared_port_data.Receive_Packet.pdu),
-                    pdu_len);
-                msg_data->pdu_len = pdu_len;
+    return dlmstp_send_pdu(&data->mstp_port, dest, pdu, pdu_len);
+}
 
-                msg_storage.type = DATA;
-                msg_storage.subtype = (MSGSUBTYPE)0;
-                msg_storage.origin = port->port_id;
-                msg_storage.data = msg_data;
+int dl_mstp_recv(MSTP_DATA *data, MSG_DATA **msg_data, unsigned timeout)
+{
+    uint16_t pdu_len;
 
-                if (!send_to_msgbox(port->main_id, &msg_storage)) {
-                    free_data(msg_data);
-                }
-            }
-        }
+    /* the event loop sets ready before it posts the packet, so a buffer
+       is only taken from the pool when there is something to receive */
+    if ((timeout == 0) && !data->shared_port_data.Receive_Packet.ready) {
+        return 0;
+    }
+    (*msg_data) = alloc_data();
+    if (!(*msg_data)) {
+        /* take the frame off the trunk anyway, and drop it */
+        (void)dlmstp_receive(&data->mstp_port, &data->src, data->pdu,
+            sizeof(data->pdu), timeout);
+        return 0;
+    }
+    pdu_len = dlmstp_receive(&data->mstp_port, &(*msg_data)->src,
+        (*msg_data)->pdu, sizeof((*msg_data)->buffer) - MSG_DATA_HEADROOM,
+        timeout);
+    if (pdu_len > 0) {
+        (*msg_data)->src.adr[0] = (*msg_data)->src.mac[0];
+        (*msg_data)->src.len = 1;
+        (*msg_data)->pdu_len = pdu_len;
+    } else {
+        free_data(*msg_data);
+        (*msg_data) = NULL;
     }
 
-    dlmstp_cleanup(&mstp_port);
-    port->state = FINISHED;
+    return pdu_len;
+}
 
-    return NULL;
+void dl_mstp_cleanup(MSTP_DATA *data)
+{
+    dlmstp_cleanup(&data->mstp_port);
 }
@@ -29,9 +29,35 @@
 #ifndef MSTPMODULE_H
 #define MSTPMODULE_H
 
+#include <stdint.h>
+#include <stdbool.h>
 #include "portthread.h"
+#include "dlmstp_linux.h"
 
-void *dl_mstp_thread(
-    void *pArgs);
+typedef struct mstp_data {
+    struct mstp_port_struct_t mstp_port;
+    SHARED_MSTP_DATA shared_port_data;
+    /* frames are dropped here when the packet buffer pool is empty */
+    BACNET_ADDRESS src;
+    uint8_t pdu[MAX_PDU];
+} MSTP_DATA;
+
+bool dl_mstp_init(
+    ROUTER_PORT * port,
+    MSTP_DATA * data);
+
+int dl_mstp_send(
+    MSTP_DATA * data,
+    BACNET_ADDRESS * dest,
+    uint8_t * pdu,
+    unsigned pdu_len);
+
+int dl_mstp_recv(
+    MSTP_DATA * data,
+    MSG_DATA ** msg,    /* on recieve fill up message */
+    unsigned timeout);
+
+void dl_mstp_cleanup(
+    MSTP_DATA * data);
 
 #endif /* end of MSTPMODULE_H */
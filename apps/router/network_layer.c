@@ -30,10 +30,12 @@
 #include <stdlib.h>
 #include <string.h>
 #include "network_layer.h"
+#include "discovery.h"
 #include "bacnet/bacint.h"
 
-uint16_t process_network_message(BACMSG *msg, MSG_DATA *data, uint8_t **buff)
+uint16_t process_network_message(BACMSG *msg)
 {
+    MSG_DATA *data = (MSG_DATA *)msg->data;
     BACNET_NPDU_DATA npdu_data;
     ROUTER_PORT *srcport;
     ROUTER_PORT *destport;
@@ -43,8 +45,6 @@ uint16_t process_network_message(BACMSG *msg, MSG_DATA *data, uint8_t **buff)
     int apdu_offset;
     int apdu_len;
 
-    memmove(data, msg->data, sizeof(MSG_DATA));
-
     apdu_offset = npdu_decode(data->pdu, &data->dest, NULL, &npdu_data);
     apdu_len = data->pdu_len - apdu_offset;
 
@@ -67,8 +67,7 @@ uint16_t process_network_message(BACMSG *msg, MSG_DATA *data, uint8_t **buff)
                     /* if TRUE send reply */
                     PRINT(INFO, "Sending I-Am-Router-To-Network message\n");
                     buff_len = create_network_message(
-                        NETWORK_MESSAGE_I_AM_ROUTER_TO_NETWORK, data, buff,
-                        &net);
+                        NETWORK_MESSAGE_I_AM_ROUTER_TO_NETWORK, data, &net);
                 } else {
                     data->dest.net = net; /* NET to look for */
                     return -1; /* else initiate NET search procedure */
@@ -77,7 +76,7 @@ uint16_t process_network_message(BACMSG *msg, MSG_DATA *data, uint8_t **buff)
                 /* if NET is omitted (message sent with -1) */
                 PRINT(INFO, "Sending I-Am-Router-To-Network message\n");
                 buff_len = create_network_message(
-                    NETWORK_MESSAGE_I_AM_ROUTER_TO_NETWORK, data, buff, NULL);
+                    NETWORK_MESSAGE_I_AM_ROUTER_TO_NETWORK, data, NULL);
             }
 
             break;
@@ -89,8 +88,9 @@ uint16_t process_network_message(BACMSG *msg, MSG_DATA *data, uint8_t **buff)
             for (i = 0; i < net_count; i++) {
                 decode_unsigned16(&data->pdu[apdu_offset + 2 * i],
                     &net); /* decode received NET values */
-                add_dnet(&srcport->route_info, net,
-                    data->src); /* and update routing table */
+                add_dnet(srcport, net,
+                    &data->src); /* and update routing table */
+                discovery_found(net);
             }
             break;
         }
@@ -126,8 +126,9 @@ uint16_t process_network_message(BACMSG *msg, MSG_DATA *data, uint8_t **buff)
                     int i = 1;
                     decode_unsigned16(&data->pdu[apdu_offset + i],
                         &net); /* decode received NET values */
-                    add_dnet(&srcport->route_info, net,
-                        data->src); /* and update routing table */
+                    add_dnet(srcport, net,
+                        &data->src); /* and update routing table */
+                    discovery_found(net);
                     if (data->pdu[apdu_offset + i + 3] >
                         0) { /* find next NET value */
                         i = data->pdu[apdu_offset + i + 3] + 4;
@@ -136,10 +137,11 @@ uint16_t process_network_message(BACMSG *msg, MSG_DATA *data, uint8_t **buff)
                     }
                 }
                 buff_len = create_network_message(
-                    NETWORK_MESSAGE_INIT_RT_TABLE_ACK, data, buff, NULL);
+                    NETWORK_MESSAGE_INIT_RT_TABLE_ACK, data, NULL);
             } else {
+                /* any value asks for the routing table */
                 buff_len = create_network_message(
-                    NETWORK_MESSAGE_INIT_RT_TABLE_ACK, data, buff, &buff);
+                    NETWORK_MESSAGE_INIT_RT_TABLE_ACK, data, data);
             }
             break;
 
@@ -151,8 +153,9 @@ uint16_t process_network_message(BACMSG *msg, MSG_DATA *data, uint8_t **buff)
                     int i = 1;
                     decode_unsigned16(&data->pdu[apdu_offset + i],
                         &net); /* decode received NET values */
-                    add_dnet(&srcport->route_info, net,
-                        data->src); /* and update routing table */
+                    add_dnet(srcport, net,
+                        &data->src); /* and update routing table */
+                    discovery_found(net);
                     if (data->pdu[apdu_offset + i + 3] >
                         0) { /* find next NET value */
                         i = data->pdu[apdu_offset + i + 3] + 4;
@@ -163,10 +166,26 @@ uint16_t process_network_message(BACMSG *msg, MSG_DATA *data, uint8_t **buff)
             }
             break;
 
+        case NETWORK_MESSAGE_ROUTER_BUSY_TO_NETWORK:
+        case NETWORK_MESSAGE_ROUTER_AVAILABLE_TO_NETWORK: {
+            bool busy = (npdu_data.network_message_type ==
+                NETWORK_MESSAGE_ROUTER_BUSY_TO_NETWORK);
+            int net_count = apdu_len / 2;
+            int i;
+            PRINT(INFO, "Recieved Router-%s-To-Network message\n",
+                busy ? "Busy" : "Available");
+            if (net_count == 0) {
+                /* every network served by that router */
+                set_dnet_busy(srcport, 0, &data->src, busy);
+            }
+            for (i = 0; i < net_count; i++) {
+                decode_unsigned16(&data->pdu[apdu_offset + 2 * i], &net);
+                set_dnet_busy(srcport, net, &data->src, busy);
+            }
+            break;
+        }
         case NETWORK_MESSAGE_INVALID:
         case NETWORK_MESSAGE_I_COULD_BE_ROUTER_TO_NETWORK:
-        case NETWORK_MESSAGE_ROUTER_BUSY_TO_NETWORK:
-        case NETWORK_MESSAGE_ROUTER_AVAILABLE_TO_NETWORK:
         case NETWORK_MESSAGE_ESTABLISH_CONNECTION_TO_NETWORK:
         case NETWORK_MESSAGE_DISCONNECT_CONNECTION_TO_NETWORK:
             /* hell if I know what to do with these messages */
@@ -184,7 +203,7 @@ uint16_t process_network_message(BACMSG *msg, MSG_DATA *data, uint8_t **buff)
             break;
         case NETWORK_MESSAGE_WHAT_IS_NETWORK_NUMBER:
             buff_len = create_network_message(
-                NETWORK_MESSAGE_NETWORK_NUMBER_IS, data, buff, &buff);
+                NETWORK_MESSAGE_NETWORK_NUMBER_IS, data, data);
             break;
 
         default:
@@ -198,9 +217,9 @@ uint16_t process_network_message(BACMSG *msg, MSG_DATA *data, uint8_t **buff)
 uint16_t create_network_message(
     BACNET_NETWORK_MESSAGE_TYPE network_message_type,
     MSG_DATA *data,
-    uint8_t **buff,
     void *val)
 {
+    uint8_t *buff;
     int16_t buff_len;
     bool data_expecting_reply = false;
     BACNET_NPDU_DATA npdu_data;
@@ -210,18 +229,20 @@ uint16_t create_network_message(
     }
     init_npdu(&npdu_data, network_message_type, data_expecting_reply);
 
-    *buff = (uint8_t *)malloc(128); /* resolve different length */
+    /* the message replaces any PDU in the packet buffer */
+    data->pdu = &data->buffer[MSG_DATA_HEADROOM];
+    buff = data->pdu;
 
     /* manual destination setup for Init-RT-Table-Ack message */
     data->dest.net = BACNET_BROADCAST_NETWORK;
-    buff_len = npdu_encode_pdu(*buff, &data->dest, NULL, &npdu_data);
+    buff_len = npdu_encode_pdu(buff, &data->dest, NULL, &npdu_data);
 
     switch (network_message_type) {
         case NETWORK_MESSAGE_WHO_IS_ROUTER_TO_NETWORK:
             if (val != NULL) {
                 uint8_t *valptr = (uint8_t *)val;
                 uint16_t val16 = (valptr[0]) + (valptr[1] << 8);
-                buff_len += encode_unsigned16(*buff + buff_len, val16);
+                buff_len += encode_unsigned16(buff + buff_len, val16);
             }
             break;
 
@@ -229,30 +250,20 @@ uint16_t create_network_message(
             if (val != NULL) {
                 uint8_t *valptr = (uint8_t *)val;
                 uint16_t val16 = (valptr[0]) + (valptr[1] << 8);
-                buff_len += encode_unsigned16(*buff + buff_len, val16);
+                buff_len += encode_unsigned16(buff + buff_len, val16);
             } else {
-                ROUTER_PORT *port = head;
-                DNET *dnet;
-                while (port != NULL) {
-                    if (port->route_info.net != data->src.net) {
-                        buff_len += encode_unsigned16(
-                            *buff + buff_len, port->route_info.net);
-                        dnet = port->route_info.dnets;
-                        while (dnet != NULL) {
-                            buff_len +=
-                                encode_unsigned16(*buff + buff_len, dnet->net);
-                            dnet = dnet->next;
-                        }
-                        port = port->next;
-                    } else {
-                        dnet = port->route_info.dnets;
-                        while (dnet != NULL) {
-                            buff_len +=
-                                encode_unsigned16(*buff + buff_len, dnet->net);
-                            dnet = dnet->next;
-                        }
-                        port = port->next;
+                unsigned i;
+                uint16_t dnet;
+                for (i = 0; i < dnet_count(); i++) {
+                    dnet = dnet_index(i);
+                    if ((dnet == data->src.net) &&
+                        (get_dnet_state(dnet) == DNET_DIRECT)) {
+                        continue;
                     }
+                    if ((buff_len + 2) > MAX_PDU) {
+                        break;
+                    }
+                    buff_len += encode_unsigned16(buff + buff_len, dnet);
                 }
             }
             break;
@@ -260,13 +271,13 @@ uint16_t create_network_message(
         case NETWORK_MESSAGE_REJECT_MESSAGE_TO_NETWORK: {
             uint8_t *valptr = (uint8_t *)val;
             uint16_t val16 = (valptr[0]) + (valptr[1] << 8);
-            buff_len += encode_unsigned16(*buff + buff_len, val16);
+            buff_len += encode_unsigned16(buff + buff_len, val16);
             break;
         }
         case NETWORK_MESSAGE_INIT_RT_TABLE:
         case NETWORK_MESSAGE_INIT_RT_TABLE_ACK:
             if ((uint8_t *)val) {
-                (*buff)[buff_len++] = (uint8_t)port_count;
+                buff[buff_len++] = (uint8_t)port_count;
 
                 if (port_count > 0) {
                     ROUTER_PORT *port = head;
@@ -274,14 +285,14 @@ uint16_t create_network_message(
 
                     while (port != NULL) {
                         buff_len += encode_unsigned16(
-                            *buff + buff_len, port->route_info.net);
-                        (*buff)[buff_len++] = portID++;
-                        (*buff)[buff_len++] = 0;
+                            buff + buff_len, port->route_info.net);
+                        buff[buff_len++] = portID++;
+                        buff[buff_len++] = 0;
                         port = port->next;
                     }
                 }
             } else {
-                (*buff)[buff_len++] = (uint8_t)0;
+                buff[buff_len++] = (uint8_t)0;
             }
             break;
 
@@ -315,37 +326,51 @@ uint16_t create_network_message(
 
 void send_network_message(BACNET_NETWORK_MESSAGE_TYPE network_message_type,
     MSG_DATA *data,
-    uint8_t **buff,
     void *val)
 {
     BACMSG msg;
     ROUTER_PORT *port = head;
     int16_t buff_len;
+    unsigned targets = 0;
 
     if (!data) {
-        data = (MSG_DATA *)malloc(sizeof(MSG_DATA));
+        data = alloc_data();
+        if (!data) {
+            PRINT(ERROR, "Error: No free packet buffer\n");
+            return;
+        }
         data->dest.net = BACNET_BROADCAST_NETWORK;
-        data->dest.len = 0;
     }
 
-    buff_len = create_network_message(network_message_type, data, buff, val);
+    buff_len = create_network_message(network_message_type, data, val);
 
     /* form network message */
-    data->pdu = *buff;
     data->pdu_len = buff_len;
     msg.origin = head->main_id;
     msg.type = DATA;
     msg.data = data;
 
-    data->ref_count = port_count;
+    /* one shared copy for every port; the reference count
+       is set before the first port can release it */
     while (port != NULL) {
-        if (port->state == FINISHED) {
-            port = port->next;
-            continue;
+        if (port->state == RUNNING) {
+            targets++;
         }
-        send_to_msgbox(port->port_id, &msg);
         port = port->next;
     }
+    if (targets == 0) {
+        free_data(data);
+        return;
+    }
+    data->ref_count = targets;
+    for (port = head; port != NULL; port = port->next) {
+        if (port->state != RUNNING) {
+            continue;
+        }
+        if (!send_to_msgbox(port->port_id, &msg)) {
+            check_data(data);
+        }
+    }
 }
 
 void init_npdu(BACNET_NPDU_DATA *npdu_data,
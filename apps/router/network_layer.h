@@ -40,21 +40,22 @@
 #include "bacport.h"
 #include "portthread.h"
 
+/* handle a network layer message; a reply is written in place of the
+   received PDU and its length returned */
 uint16_t process_network_message(
-    BACMSG * msg,
-    MSG_DATA * data,
-    uint8_t ** buff);
+    BACMSG * msg);
 
+/* write a network layer message into the packet buffer of data */
 uint16_t create_network_message(
     BACNET_NETWORK_MESSAGE_TYPE network_message_type,
     MSG_DATA * data,
-    uint8_t ** buff,
     void *val);
 
+/* send a network layer message to every port, in data or in a new
+   packet buffer if data is NULL */
 void send_network_message(
     BACNET_NETWORK_MESSAGE_TYPE network_message_type,
     MSG_DATA * data,
-    uint8_t ** buff,
     void *val);
 
 void init_npdu(
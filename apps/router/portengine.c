@@ -0,0 +1,412 @@
+/**
+ * @file
+ * @date October 2026
+ * @brief One thread that drives every router port from a single event loop.
+ *
+ * The MS/TP state machines of all trunks already run in the dlmstp_linux
+ * event loop. The port engine waits in poll() for the B/IP sockets, for
+ * the dlmstp_linux receive event and for its own wakeup event, which is
+ * signalled when the routing core queues messages for a port. A box with
+ * many trunks therefore needs two threads for its datalinks, instead of
+ * one polling thread per port.
+ *
+ * @section LICENSE
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <poll.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include "portengine.h"
+#include "ipmodule.h"
+#include "mstpmodule.h"
+
+/* datalink state of one router port */
+typedef struct engine_port {
+    ROUTER_PORT *port;
+    bool active;
+    /* index into the poll set, or -1 if the port has no descriptor */
+    int poll_index;
+    union {
+        IP_DATA ip;
+        MSTP_DATA *mstp;
+    } dl;
+} ENGINE_PORT;
+
+static ENGINE_PORT Engine_Ports[PORT_ENGINE_PORTS_MAX];
+static unsigned Engine_Port_Count;
+static MSG_EVENT Engine_Event = { -1, 0 };
+
+uint64_t port_engine_clock(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return ((uint64_t)now.tv_sec * 1000000ULL) +
+        ((uint64_t)now.tv_nsec / 1000ULL);
+}
+
+void port_latency_record(PORT_LATENCY *latency, uint64_t usec)
+{
+    unsigned index = 0;
+
+    while ((index < (PORT_LATENCY_BUCKETS - 1)) && (usec >> index)) {
+        index++;
+    }
+    latency->bucket[index]++;
+    latency->count++;
+    latency->total += usec;
+    if (usec > latency->max) {
+        latency->max = (usec > UINT32_MAX) ? UINT32_MAX : (uint32_t)usec;
+    }
+}
+
+/* transmit queue counters of an MS/TP port, by network priority */
+static void port_queue_print(ROUTER_PORT *port)
+{
+    static const char *class_name[PRIOQ_CLASSES] = { "normal", "urgent",
+        "critical", "life safety" };
+    PRIOQ_STATS stats[PRIOQ_CLASSES];
+    MSTP_DATA *mstp = NULL;
+    unsigned i;
+
+    for (i = 0; i < Engine_Port_Count; i++) {
+        if ((Engine_Ports[i].port == port) && (port->type == MSTP)) {
+            mstp = Engine_Ports[i].dl.mstp;
+        }
+    }
+    if (!mstp || !dlmstp_fill_queue_statistics(&mstp->mstp_port, stats)) {
+        return;
+    }
+    for (i = 0; i < PRIOQ_CLASSES; i++) {
+        if ((stats[i].queued == 0) && (stats[i].dropped == 0)) {
+            continue;
+        }
+        PRINT(INFO,
+            "  %s: %lu queued, %lu sent, %lu dropped, depth %u max %u",
+            class_name[i], (unsigned long)stats[i].queued,
+            (unsigned long)stats[i].sent, (unsigned long)stats[i].dropped,
+            (unsigned)stats[i].depth, (unsigned)stats[i].depth_max);
+        if (stats[i].sent) {
+            PRINT(INFO, ", wait mean %lu ms, max %lu ms",
+                (unsigned long)(stats[i].latency_total / stats[i].sent),
+                (unsigned long)stats[i].latency_max);
+        }
+        PRINT(INFO, "\n");
+    }
+}
+
+void port_latency_print(ROUTER_PORT *port)
+{
+    PORT_LATENCY *latency = &port->latency;
+    unsigned index;
+
+    PRINT(INFO, "Port %s (NET %hu): %lu PDU sent", port->iface,
+        port->route_info.net, (unsigned long)latency->count);
+    if (latency->count == 0) {
+        PRINT(INFO, "\n");
+        port_queue_print(port);
+        return;
+    }
+    PRINT(INFO, ", latency mean %lu us, max %lu us\n",
+        (unsigned long)(latency->total / latency->count),
+        (unsigned long)latency->max);
+    for (index = 0; index < PORT_LATENCY_BUCKETS; index++) {
+        if (latency->bucket[index]) {
+            PRINT(INFO, "  < %lu us: %lu\n", 1UL << index,
+                (unsigned long)latency->bucket[index]);
+        }
+    }
+    port_queue_print(port);
+}
+
+static bool port_engine_port_init(ENGINE_PORT *engine_port)
+{
+    ROUTER_PORT *port = engine_port->port;
+    bool status = false;
+
+    switch (port->type) {
+        case BIP:
+            status = dl_ip_init(port, &engine_port->dl.ip);
+            break;
+        case MSTP:
+            engine_port->dl.mstp = (MSTP_DATA *)malloc(sizeof(MSTP_DATA));
+            if (engine_port->dl.mstp) {
+                status = dl_mstp_init(port, engine_port->dl.mstp);
+                if (!status) {
+                    free(engine_port->dl.mstp);
+                    engine_port->dl.mstp = NULL;
+                }
+            }
+            break;
+    }
+
+    return status;
+}
+
+static void port_engine_port_cleanup(ENGINE_PORT *engine_port)
+{
+    ROUTER_PORT *port = engine_port->port;
+
+    switch (port->type) {
+        case BIP:
+            dl_ip_cleanup(&engine_port->dl.ip);
+            break;
+        case MSTP:
+            dl_mstp_cleanup(engine_port->dl.mstp);
+            free(engine_port->dl.mstp);
+            engine_port->dl.mstp = NULL;
+            break;
+    }
+    engine_port->active = false;
+    /* the port may be freed by the router once it is finished */
+    port->state = FINISHED;
+}
+
+/* send the messages queued for a port; returns false on SHUTDOWN */
+static bool port_engine_transmit(ENGINE_PORT *engine_port)
+{
+    ROUTER_PORT *port = engine_port->port;
+    BACMSG msg_storage, *bacmsg;
+    MSG_DATA *msg_data;
+    BACNET_ADDRESS address;
+
+    for (;;) {
+        bacmsg = recv_from_msgbox(port->port_id, &msg_storage);
+        if (!bacmsg) {
+            break;
+        }
+        switch (bacmsg->type) {
+            case DATA:
+                msg_data = (MSG_DATA *)bacmsg->data;
+                memset(&address, 0, sizeof(address));
+                if (port->type == BIP) {
+                    memmove(&address.net, &msg_data->dest.net, 2);
+                    memmove(&address.mac_len, &msg_data->dest.len, 1);
+                    memmove(
+                        &address.mac[0], &msg_data->dest.adr[0], MAX_MAC_LEN);
+                    dl_ip_send(&engine_port->dl.ip, &address, msg_data->pdu,
+                        msg_data->pdu_len);
+                } else {
+                    /* the message may be shared with other ports */
+                    memmove(&address, &msg_data->dest, sizeof(address));
+                    dl_mstp_send(engine_port->dl.mstp, &address, msg_data->pdu,
+                        msg_data->pdu_len);
+                }
+                if (msg_data->timestamp) {
+                    port_latency_record(&port->latency,
+                        port_engine_clock() - msg_data->timestamp);
+                }
+                check_data(msg_data);
+                break;
+            case SERVICE:
+                if (bacmsg->subtype == SHUTDOWN) {
+                    return false;
+                }
+                break;
+            default:
+                break;
+        }
+    }
+
+    return true;
+}
+
+/* pass a PDU received on a port to the routing core */
+static void port_engine_receive(ENGINE_PORT *engine_port)
+{
+    ROUTER_PORT *port = engine_port->port;
+    BACNET_ADDRESS address = { 0 };
+    BACMSG msg_storage;
+    MSG_DATA *msg_data = NULL;
+    int status = 0;
+
+    if (port->type == BIP) {
+        status = dl_ip_recv(&engine_port->dl.ip, &msg_data, &address, 0);
+        if (status > 0) {
+            memmove(&msg_data->src.len, &address.mac_len, 1);
+            memmove(&msg_data->src.adr[0], &address.mac[0], MAX_MAC_LEN);
+        }
+    } else {
+        status = dl_mstp_recv(engine_port->dl.mstp, &msg_data, 0);
+    }
+    if (status > 0) {
+        msg_data->timestamp = port_engine_clock();
+        msg_storage.origin = port->port_id;
+        msg_storage.type = DATA;
+        msg_storage.subtype = (MSGSUBTYPE)0;
+        msg_storage.data = msg_data;
+        if (!send_to_msgbox(port->main_id, &msg_storage)) {
+            free_data(msg_data);
+        }
+    }
+}
+
+/* true if the routing core has queued messages for any port */
+static bool port_engine_pending(void)
+{
+    unsigned i;
+
+    for (i = 0; i < Engine_Port_Count; i++) {
+        if (Engine_Ports[i].active &&
+            !msgbox_empty(Engine_Ports[i].port->port_id)) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static void *port_engine_thread(void *pArgs)
+{
+    struct pollfd fds[PORT_ENGINE_PORTS_MAX + 2];
+    ENGINE_PORT *engine_port;
+    nfds_t nfds = 0;
+    unsigned running = 0;
+    unsigned i;
+    uint64_t value;
+    int mstp_index = -1;
+    int status;
+
+    (void)pArgs;
+    fds[nfds].fd = Engine_Event.fd;
+    fds[nfds].events = POLLIN;
+    nfds++;
+    for (i = 0; i < Engine_Port_Count; i++) {
+        engine_port = &Engine_Ports[i];
+        engine_port->poll_index = -1;
+        if (!port_engine_port_init(engine_port)) {
+            engine_port->port->state = INIT_FAILED;
+            continue;
+        }
+        if (engine_port->port->type == BIP) {
+            engine_port->poll_index = nfds;
+            fds[nfds].fd = engine_port->dl.ip.socket;
+            fds[nfds].events = POLLIN;
+            nfds++;
+        } else if (mstp_index < 0) {
+            /* one event for every MS/TP trunk */
+            mstp_index = nfds;
+            fds[nfds].fd = dlmstp_receive_event();
+            fds[nfds].events = POLLIN;
+            nfds++;
+        }
+        engine_port->active = true;
+        engine_port->port->state = RUNNING;
+        running++;
+    }
+
+    while (running > 0) {
+        msg_event_sleep(&Engine_Event);
+        status = poll(fds, nfds,
+            port_engine_pending() ? 0 : PORT_ENGINE_IDLE_TIMEOUT);
+        msg_event_awake(
+            &Engine_Event, (status > 0) && (fds[0].revents & POLLIN));
+        if (status < 0) {
+            if (errno != EINTR) {
+                PRINT(ERROR, "Error: port engine poll failed\n");
+                break;
+            }
+            continue;
+        }
+        /* clear the events before looking at the ports,
+           so that anything arriving later wakes us again */
+        if ((mstp_index >= 0) && (fds[mstp_index].revents & POLLIN)) {
+            (void)read(fds[mstp_index].fd, &value, sizeof(value));
+        }
+        for (i = 0; i < Engine_Port_Count; i++) {
+            engine_port = &Engine_Ports[i];
+            if (!engine_port->active) {
+                continue;
+            }
+            if (!port_engine_transmit(engine_port)) {
+                if (engine_port->poll_index >= 0) {
+                    fds[engine_port->poll_index].fd = -1;
+                }
+                port_engine_port_cleanup(engine_port);
+                running--;
+                continue;
+            }
+            if (engine_port->poll_index >= 0) {
+                if (fds[engine_port->poll_index].revents & POLLIN) {
+                    port_engine_receive(engine_port);
+                }
+            } else {
+                port_engine_receive(engine_port);
+            }
+        }
+    }
+
+    return NULL;
+}
+
+bool port_engine_start(ROUTER_PORT *port_list)
+{
+    ROUTER_PORT *port = port_list;
+    pthread_t thread;
+
+    Engine_Port_Count = 0;
+    while (port != NULL) {
+        if (Engine_Port_Count >= PORT_ENGINE_PORTS_MAX) {
+            PRINT(ERROR, "Error: Too many router ports\n");
+            goto failed;
+        }
+        port->state = INIT;
+        memset(&Engine_Ports[Engine_Port_Count], 0, sizeof(ENGINE_PORT));
+        Engine_Ports[Engine_Port_Count].port = port;
+        Engine_Port_Count++;
+        port = port->next;
+    }
+
+    if (!msg_event_init(&Engine_Event)) {
+        PRINT(ERROR, "Error: Failed to create the port engine event\n");
+        goto failed;
+    }
+    for (port = port_list; port != NULL; port = port->next) {
+        port->port_id = create_msgbox(&Engine_Event);
+        if (port->port_id == INVALID_MSGBOX_ID) {
+            PRINT(ERROR, "Error: Failed to create message box\n");
+            goto failed;
+        }
+    }
+    if (pthread_create(&thread, NULL, port_engine_thread, NULL) != 0) {
+        PRINT(ERROR, "Error: Failed to start the port engine\n");
+        goto failed;
+    }
+    pthread_detach(thread);
+
+    return true;
+
+failed:
+    for (port = port_list; port != NULL; port = port->next) {
+        del_msgbox(port->port_id);
+        port->port_id = INVALID_MSGBOX_ID;
+        port->state = INIT_FAILED;
+    }
+
+    return false;
+}
@@ -0,0 +1,62 @@
+/**
+ * @file
+ * @date October 2026
+ * @brief One thread that drives every router port from a single event loop
+ *
+ * @section LICENSE
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+#ifndef PORTENGINE_H
+#define PORTENGINE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "portthread.h"
+
+/* number of router ports served by the port engine. MS/TP trunks
+   are also limited by DLMSTP_LINUX_PORTS_MAX */
+#ifndef PORT_ENGINE_PORTS_MAX
+#define PORT_ENGINE_PORTS_MAX 32
+#endif
+
+/* milliseconds the port engine sleeps when nothing has happened */
+#ifndef PORT_ENGINE_IDLE_TIMEOUT
+#define PORT_ENGINE_IDLE_TIMEOUT 100
+#endif
+
+/* start the port engine thread for every port in the list. Creates the
+   message box of each port; sending to it wakes the port engine. */
+bool port_engine_start(
+    ROUTER_PORT * port_list);
+
+/* monotonic time in microseconds, as used for MSG_DATA timestamp */
+uint64_t port_engine_clock(
+    void);
+
+void port_latency_record(
+    PORT_LATENCY * latency,
+    uint64_t usec);
+
+void port_latency_print(
+    ROUTER_PORT * port);
+
+#endif /* end of PORTENGINE_H */
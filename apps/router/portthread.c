@@ -45,78 +45,156 @@ ROUTER_PORT *find_snet(MSGBOX_ID id)
     return NULL;
 }
 
+/* one routing table entry for every network number. The entries are
+   written by the routing core only, and read without a lock: the writer
+   makes the sequence number odd while it changes an entry, and a reader
+   tries again when the sequence number changed under it. */
+typedef struct _dnet {
+    uint32_t seq;
+    uint8_t state;
+    uint8_t mac_len;
+    uint8_t mac[MAX_MAC_LEN];
+    ROUTER_PORT *port;
+} DNET;
+
+static DNET Routing_Table[BACNET_BROADCAST_NETWORK];
+/* networks in the routing table, for building I-Am-Router-To-Network */
+static uint16_t Routing_Nets[BACNET_BROADCAST_NETWORK];
+static unsigned Routing_Net_Count;
+
+static void dnet_read(uint16_t net, DNET *copy)
+{
+    DNET *entry = &Routing_Table[net];
+    uint32_t seq;
+
+    for (;;) {
+        seq = __atomic_load_n(&entry->seq, __ATOMIC_ACQUIRE);
+        if (seq & 1) {
+            continue;
+        }
+        memcpy(copy, entry, sizeof(DNET));
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        if (__atomic_load_n(&entry->seq, __ATOMIC_RELAXED) == seq) {
+            break;
+        }
+    }
+}
+
+static void dnet_write(uint16_t net,
+    DNET_STATE state,
+    ROUTER_PORT *port,
+    BACNET_ADDRESS *addr)
+{
+    DNET *entry = &Routing_Table[net];
+    uint32_t seq = entry->seq;
+
+    if (entry->state == DNET_UNKNOWN) {
+        Routing_Nets[Routing_Net_Count++] = net;
+    }
+    __atomic_store_n(&entry->seq, seq + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    entry->state = (uint8_t)state;
+    entry->port = port;
+    if (addr) {
+        entry->mac_len = addr->len;
+        memmove(&entry->mac[0], &addr->adr[0], MAX_MAC_LEN);
+    } else {
+        entry->mac_len = 0;
+        memset(&entry->mac[0], 0, MAX_MAC_LEN);
+    }
+    __atomic_store_n(&entry->seq, seq + 2, __ATOMIC_RELEASE);
+}
+
 ROUTER_PORT *find_dnet(uint16_t net, BACNET_ADDRESS *addr)
 {
-    ROUTER_PORT *port = head;
-    DNET *dnet;
+    DNET dnet;
 
     /* for broadcast messages no search is needed */
     if (net == BACNET_BROADCAST_NETWORK) {
-        return port;
+        return head;
     }
 
-    while (port != NULL) {
-        /* check if DNET is directly connected to the router */
-        if (net == port->route_info.net) {
-            return port;
-
-            /* else search router ports DNET list */
-        } else if (port->route_info.dnets) {
-            dnet = port->route_info.dnets;
-            while (dnet != NULL) {
-                if (net == dnet->net) {
-                    if (addr) {
-                        memmove(&addr->len, &dnet->mac_len, 1);
-                        memmove(&addr->adr[0], &dnet->mac[0], MAX_MAC_LEN);
-                    }
-                    return port;
-                }
-                dnet = dnet->next;
-            }
+    dnet_read(net, &dnet);
+    if (dnet.state == DNET_DIRECT) {
+        return dnet.port;
+    } else if (dnet.state == DNET_REACHABLE) {
+        if (addr) {
+            addr->len = dnet.mac_len;
+            memmove(&addr->adr[0], &dnet.mac[0], MAX_MAC_LEN);
         }
-        port = port->next;
+        return dnet.port;
     }
 
     return NULL;
 }
 
-void add_dnet(RT_ENTRY *route_info, uint16_t net, BACNET_ADDRESS addr)
+DNET_STATE get_dnet_state(uint16_t net)
+{
+    DNET dnet;
+
+    if (net == BACNET_BROADCAST_NETWORK) {
+        return DNET_UNKNOWN;
+    }
+    dnet_read(net, &dnet);
+
+    return (DNET_STATE)dnet.state;
+}
+
+void add_dnet(ROUTER_PORT *port, uint16_t net, BACNET_ADDRESS *addr)
+{
+    if ((net == 0) || (net == BACNET_BROADCAST_NETWORK)) {
+        return;
+    }
+    if (addr == NULL) {
+        dnet_write(net, DNET_DIRECT, port, NULL);
+    } else if (Routing_Table[net].state != DNET_DIRECT) {
+        /* the latest I-Am-Router-To-Network wins */
+        dnet_write(net, DNET_REACHABLE, port, addr);
+    }
+}
+
+/* change the state of a route if it goes through the router at addr */
+static void dnet_busy(
+    uint16_t net, ROUTER_PORT *port, BACNET_ADDRESS *addr, bool busy)
 {
-    DNET *dnet = route_info->dnets;
-    DNET *tmp;
-
-    if (dnet == NULL) {
-        route_info->dnets = (DNET *)malloc(sizeof(DNET));
-        memmove(&route_info->dnets->mac_len, &addr.len, 1);
-        memmove(&route_info->dnets->mac[0], &addr.adr[0], MAX_MAC_LEN);
-        route_info->dnets->net = net;
-        route_info->dnets->state = true;
-        route_info->dnets->next = NULL;
+    DNET *entry = &Routing_Table[net];
+
+    if ((entry->state != DNET_REACHABLE) && (entry->state != DNET_BUSY)) {
+        return;
+    }
+    if ((entry->port != port) || (entry->mac_len != addr->len) ||
+        (memcmp(&entry->mac[0], &addr->adr[0], addr->len) != 0)) {
+        return;
+    }
+    dnet_write(net, busy ? DNET_BUSY : DNET_REACHABLE, port, addr);
+}
+
+void set_dnet_busy(
+    ROUTER_PORT *port, uint16_t net, BACNET_ADDRESS *addr, bool busy)
+{
+    unsigned i;
+
+    if (net == BACNET_BROADCAST_NETWORK) {
+        return;
+    } else if (net) {
+        dnet_busy(net, port, addr, busy);
     } else {
-        while (dnet != NULL) {
-            if (dnet->net == net) { /* make sure NETs are not repeated */
-                return;
-            }
-            tmp = dnet;
-            dnet = dnet->next;
+        for (i = 0; i < Routing_Net_Count; i++) {
+            dnet_busy(Routing_Nets[i], port, addr, busy);
         }
-
-        dnet = (DNET *)malloc(sizeof(DNET));
-        memmove(&dnet->mac_len, &addr.len, 1);
-        memmove(&dnet->mac[0], &addr.adr[0], MAX_MAC_LEN);
-        dnet->net = net;
-        dnet->state = true;
-        dnet->next = NULL;
-        tmp->next = dnet;
     }
 }
 
-void cleanup_dnets(DNET *dnets)
+unsigned dnet_count(void)
 {
-    DNET *dnet = dnets;
-    while (dnet != NULL) {
-        dnet = dnet->next;
-        free(dnets);
-        dnets = dnet;
+    return Routing_Net_Count;
+}
+
+uint16_t dnet_index(unsigned index)
+{
+    if (index < Routing_Net_Count) {
+        return Routing_Nets[index];
     }
+
+    return 0;
 }
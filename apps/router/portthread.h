@@ -59,11 +59,6 @@ typedef enum {
     FINISHED
 } PORT_STATE;
 
-/* router port thread function */
-typedef void *(
-    *PORT_FUNC) (
-    void *);
-
 typedef enum {
     PARITY_NONE,
     PARITY_EVEN,
@@ -85,32 +80,44 @@ typedef union _port_params {
     } mstp_params;
 } PORT_PARAMS;
 
-/* list node for reacheble networks */
-typedef struct _dnet {
-    uint8_t mac[MAX_MAC_LEN];
-    uint8_t mac_len;
-    uint16_t net;
-    bool state; /* enabled or disabled */
-    struct _dnet *next;
-} DNET;
+/* reachability of a network in the routing table */
+typedef enum {
+    DNET_UNKNOWN = 0,
+    DNET_DIRECT,        /* directly connected to a router port */
+    DNET_REACHABLE,     /* through the next router at the entry MAC */
+    DNET_BUSY   /* the next router sent Router-Busy-To-Network */
+} DNET_STATE;
 
 /* information for routing table */
 typedef struct _routing_table_entry {
     uint8_t mac[MAX_MAC_LEN];
     uint8_t mac_len;
     uint16_t net;
-    DNET *dnets;
 } RT_ENTRY;
 
+/* number of log2 buckets in the port latency histogram:
+   bucket n counts latencies from 2^(n-1) up to 2^n microseconds */
+#ifndef PORT_LATENCY_BUCKETS
+#define PORT_LATENCY_BUCKETS 24
+#endif
+
+/* time from datalink receive to hand-off to the sending datalink */
+typedef struct _port_latency {
+    uint32_t count;
+    uint32_t max;       /* microseconds */
+    uint64_t total;     /* microseconds */
+    uint32_t bucket[PORT_LATENCY_BUCKETS];
+} PORT_LATENCY;
+
 typedef struct _port {
     DL_TYPE type;
     PORT_STATE state;
-    MSGBOX_ID main_id;  /* same for every router port */
-    MSGBOX_ID port_id;  /* different for every router port */
+    MSGBOX_ID main_id;  /* from the port to the routing core */
+    MSGBOX_ID port_id;  /* from the routing core to the port */
     char *iface;
-    PORT_FUNC func;
     RT_ENTRY route_info;
     PORT_PARAMS params;
+    PORT_LATENCY latency;       /* written by the port engine only */
     struct _port *next; /* pointer to next list node */
 } ROUTER_PORT;
 
@@ -121,18 +128,39 @@ extern int port_count;
 ROUTER_PORT *find_snet(
     MSGBOX_ID id);
 
-/* get sending router port */
+/* get sending router port of a reachable network, and the MAC of the
+   next router if addr is given and the network is not directly connected.
+   Does not take a lock, so any thread may look up routes. */
 ROUTER_PORT *find_dnet(
     uint16_t net,
     BACNET_ADDRESS * addr);
 
-/* add reacheble network for specified router port */
+/* reachability of a network */
+DNET_STATE get_dnet_state(
+    uint16_t net);
+
+/* add reacheble network for specified router port. The network is
+   directly connected when addr is NULL, otherwise reached through the
+   router at addr. Called by the routing core only. */
 void add_dnet(
-    RT_ENTRY * route_info,
+    ROUTER_PORT * port,
+    uint16_t net,
+    BACNET_ADDRESS * addr);
+
+/* mark the networks reached through the router at addr as busy or
+   available again; every network of that router when net is zero */
+void set_dnet_busy(
+    ROUTER_PORT * port,
     uint16_t net,
-    BACNET_ADDRESS addr);
+    BACNET_ADDRESS * addr,
+    bool busy);
+
+/* number of networks in the routing table, and the network at an
+   index from 0 to dnet_count() - 1, in the order they were added */
+unsigned dnet_count(
+    void);
 
-void cleanup_dnets(
-    DNET * dnets);
+uint16_t dnet_index(
+    unsigned index);
 
 #endif /* end of PORTTHREAD_H */
@@ -0,0 +1,862 @@
+/**
+ * @file
+ * @date October 2026
+ * @brief Load generator and benchmark for the BACnet router.
+ *
+ * Starts apps/router with B/IP ports on loopback address aliases, so
+ * no external network is needed, and injects routed traffic from one
+ * generator thread per port. Reports the forwarded packets per second,
+ * the latency through the router and the drops for unicast, broadcast
+ * and network layer message mixes.
+ *
+ * @section LICENSE
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <net/if.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+/* local includes */
+#include "bacnet/bacdef.h"
+#include "bacnet/bacdcode.h"
+#include "bacnet/bacenum.h"
+#include "bacnet/npdu.h"
+#include "bacnet/datalink/bip.h"
+#include "bacnet/datalink/bvlc.h"
+#include "bacnet/version.h"
+
+/* router ports, each with a station of the generator */
+#ifndef ROUTERBENCH_PORTS_MAX
+#define ROUTERBENCH_PORTS_MAX 16
+#endif
+/* port N uses the alias lo:rbN with the subnet 127.0.(100+N).0/24:
+   the router at .1, the station at .2 */
+#define ROUTERBENCH_SUBNET 100
+/* latency histogram of 1 microsecond buckets */
+#define ROUTERBENCH_LATENCY_MAX_US 100000
+/* network layer requests waiting for their reply, per port */
+#define ROUTERBENCH_PENDING_MAX 4096
+/* marks the APDU of a benchmark packet */
+#define ROUTERBENCH_MAGIC 0x5242
+/* offsets in the benchmark APDU */
+#define ROUTERBENCH_APDU_MIX 4
+#define ROUTERBENCH_APDU_TIME 6
+#define ROUTERBENCH_APDU_MIN (ROUTERBENCH_APDU_TIME + 8)
+/* generators send at most this many packets before sleeping */
+#define ROUTERBENCH_BURST 64
+
+enum routerbench_mix {
+    MIX_UNICAST,
+    MIX_BROADCAST,
+    MIX_GLOBAL,
+    MIX_NETWORK,
+    MIX_MAX
+};
+
+static const char *Mix_Names[MIX_MAX] = { "unicast", "broadcast", "global",
+    "network" };
+
+/* one router port and the generator station on its network */
+struct routerbench_port {
+    unsigned index;
+    uint16_t net;
+    uint16_t udp_port;
+    struct sockaddr_in router;
+    struct sockaddr_in station;
+    struct sockaddr_in broadcast;
+    int unicast_fd;
+    int broadcast_fd;
+    bool alias_added;
+    pthread_t thread;
+    unsigned long sent;
+    unsigned long expected;
+    /* send times of network layer requests waiting for a reply */
+    pthread_mutex_t lock;
+    uint64_t pending_ns[ROUTERBENCH_PENDING_MAX];
+    unsigned pending_head;
+    unsigned pending_count;
+};
+
+/* packets received for one mix */
+struct routerbench_stats {
+    unsigned long received;
+    unsigned long latency_count;
+    uint64_t latency_max_ns;
+    uint32_t histogram[ROUTERBENCH_LATENCY_MAX_US + 1];
+};
+
+static struct routerbench_port Ports[ROUTERBENCH_PORTS_MAX];
+static unsigned Port_Count = 3;
+static uint16_t First_UDP_Port = 47900;
+static uint16_t First_Network = 1001;
+static unsigned Rate = 2000;
+static unsigned Seconds = 5;
+static unsigned APDU_Len = 50;
+static bool Verbose;
+static const char *Router_Path = "router";
+static pid_t Router_Pid;
+/* shared by the generator, receiver and main threads */
+static volatile bool Generating;
+static volatile bool Receiving;
+static volatile bool Interrupted;
+static volatile int Current_Mix;
+static pthread_mutex_t Stats_Lock = PTHREAD_MUTEX_INITIALIZER;
+static struct routerbench_stats Stats;
+
+static uint64_t clock_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((uint64_t)ts.tv_sec * 1000000000ULL) + (uint64_t)ts.tv_nsec;
+}
+
+static void sleep_ns(uint64_t ns)
+{
+    struct timespec delay;
+
+    delay.tv_sec = (time_t)(ns / 1000000000ULL);
+    delay.tv_nsec = (long)(ns % 1000000000ULL);
+    nanosleep(&delay, NULL);
+}
+
+static void interrupt_handler(int signo)
+{
+    (void)signo;
+    Interrupted = true;
+    Generating = false;
+}
+
+/* add the loopback alias of a port, unless it already exists */
+static bool alias_add(struct routerbench_port *port)
+{
+    struct ifreq ifr;
+    struct sockaddr_in *sin = (struct sockaddr_in *)&ifr.ifr_addr;
+    bool status = false;
+    int fd;
+
+    fd = socket(AF_INET, SOCK_DGRAM, 0);
+    if (fd < 0) {
+        return false;
+    }
+    memset(&ifr, 0, sizeof(ifr));
+    snprintf(ifr.ifr_name, sizeof(ifr.ifr_name), "lo:rb%u", port->index);
+    if ((ioctl(fd, SIOCGIFADDR, &ifr) == 0) &&
+        (sin->sin_addr.s_addr == port->router.sin_addr.s_addr)) {
+        close(fd);
+        return true;
+    }
+    sin->sin_family = AF_INET;
+    sin->sin_addr = port->router.sin_addr;
+    if (ioctl(fd, SIOCSIFADDR, &ifr) == 0) {
+        port->alias_added = true;
+        sin->sin_addr.s_addr = htonl(0xFFFFFF00UL);
+        if (ioctl(fd, SIOCSIFNETMASK, &ifr) == 0) {
+            sin->sin_addr = port->broadcast.sin_addr;
+            if (ioctl(fd, SIOCSIFBRDADDR, &ifr) == 0) {
+                status = true;
+            }
+        }
+    }
+    if (!status) {
+        perror(ifr.ifr_name);
+    }
+    close(fd);
+
+    return status;
+}
+
+/* remove the loopback alias of a port, if the benchmark added it */
+static void alias_remove(struct routerbench_port *port)
+{
+    struct ifreq ifr;
+    int fd;
+
+    if (!port->alias_added) {
+        return;
+    }
+    fd = socket(AF_INET, SOCK_DGRAM, 0);
+    if (fd < 0) {
+        return;
+    }
+    memset(&ifr, 0, sizeof(ifr));
+    snprintf(ifr.ifr_name, sizeof(ifr.ifr_name), "lo:rb%u", port->index);
+    if (ioctl(fd, SIOCGIFFLAGS, &ifr) == 0) {
+        ifr.ifr_flags &= ~IFF_UP;
+        (void)ioctl(fd, SIOCSIFFLAGS, &ifr);
+    }
+    port->alias_added = false;
+    close(fd);
+}
+
+static int station_socket(struct sockaddr_in *address)
+{
+    int sockopt = 1;
+    int fd;
+
+    fd = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    if (fd < 0) {
+        return -1;
+    }
+    /* the router port has the same UDP port on INADDR_ANY */
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &sockopt, sizeof(sockopt));
+    setsockopt(fd, SOL_SOCKET, SO_BROADCAST, &sockopt, sizeof(sockopt));
+    /* the benchmark must not be the one that drops */
+    sockopt = 4 * 1024 * 1024;
+    setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &sockopt, sizeof(sockopt));
+    if (bind(fd, (struct sockaddr *)address, sizeof(*address)) < 0) {
+        close(fd);
+        return -1;
+    }
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+
+    return fd;
+}
+
+static void port_init(struct routerbench_port *port, unsigned index)
+{
+    uint32_t subnet;
+
+    memset(port, 0, sizeof(*port));
+    port->index = index;
+    port->net = First_Network + index;
+    port->udp_port = First_UDP_Port + index;
+    subnet = (127UL << 24) | ((ROUTERBENCH_SUBNET + index) << 8);
+    port->router.sin_family = AF_INET;
+    port->router.sin_addr.s_addr = htonl(subnet | 1);
+    port->router.sin_port = htons(port->udp_port);
+    port->station = port->router;
+    port->station.sin_addr.s_addr = htonl(subnet | 2);
+    port->broadcast = port->router;
+    port->broadcast.sin_addr.s_addr = htonl(subnet | 255);
+    port->unicast_fd = -1;
+    port->broadcast_fd = -1;
+    pthread_mutex_init(&port->lock, NULL);
+}
+
+/* the B/IP MAC address of a station, as in the DADR of a packet */
+static void station_mac(struct routerbench_port *port, BACNET_ADDRESS *dest)
+{
+    memcpy(&dest->adr[0], &port->station.sin_addr.s_addr, 4);
+    memcpy(&dest->adr[4], &port->station.sin_port, 2);
+    dest->len = 6;
+}
+
+static void router_start(void)
+{
+    char *argv[2 + (ROUTERBENCH_PORTS_MAX * 7)];
+    char strings[ROUTERBENCH_PORTS_MAX][3][16];
+    unsigned argc = 0;
+    unsigned i;
+    int fd;
+
+    argv[argc++] = (char *)Router_Path;
+    for (i = 0; i < Port_Count; i++) {
+        snprintf(strings[i][0], sizeof(strings[i][0]), "lo:rb%u", i);
+        snprintf(strings[i][1], sizeof(strings[i][1]), "%u", Ports[i].udp_port);
+        snprintf(strings[i][2], sizeof(strings[i][2]), "%u", Ports[i].net);
+        argv[argc++] = "-D";
+        argv[argc++] = "bip";
+        argv[argc++] = strings[i][0];
+        argv[argc++] = "--port";
+        argv[argc++] = strings[i][1];
+        argv[argc++] = "-n";
+        argv[argc++] = strings[i][2];
+    }
+    argv[argc] = NULL;
+    Router_Pid = fork();
+    if (Router_Pid == 0) {
+        if (!Verbose) {
+            fd = open("/dev/null", O_WRONLY);
+            if (fd >= 0) {
+                dup2(fd, STDOUT_FILENO);
+                dup2(fd, STDERR_FILENO);
+                close(fd);
+            }
+        }
+        execvp(Router_Path, argv);
+        perror(Router_Path);
+        _exit(127);
+    }
+}
+
+static void router_stop(void)
+{
+    if (Router_Pid > 0) {
+        if (Verbose) {
+            /* the router prints its port latency histograms */
+            kill(Router_Pid, SIGUSR1);
+            sleep_ns(300000000ULL);
+        }
+        kill(Router_Pid, SIGTERM);
+        waitpid(Router_Pid, NULL, 0);
+        Router_Pid = 0;
+    }
+}
+
+/* encode a benchmark packet from a station to the router */
+static int packet_encode(uint8_t *mtu,
+    uint16_t mtu_size,
+    int mix,
+    struct routerbench_port *port,
+    struct routerbench_port *target)
+{
+    uint8_t npdu[MAX_PDU] = { 0 };
+    BACNET_NPDU_DATA npdu_data;
+    BACNET_ADDRESS dest = { 0 };
+    uint64_t now;
+    int len;
+
+    if (mix == MIX_NETWORK) {
+        npdu_encode_npdu_network(&npdu_data,
+            NETWORK_MESSAGE_WHO_IS_ROUTER_TO_NETWORK, false,
+            MESSAGE_PRIORITY_NORMAL);
+        len = npdu_encode_pdu(npdu, NULL, NULL, &npdu_data);
+        len += encode_unsigned16(&npdu[len], target->net);
+    } else {
+        npdu_encode_npdu_data(&npdu_data, false, MESSAGE_PRIORITY_NORMAL);
+        if (mix == MIX_GLOBAL) {
+            dest.net = BACNET_BROADCAST_NETWORK;
+        } else {
+            dest.net = target->net;
+            if (mix == MIX_UNICAST) {
+                station_mac(target, &dest);
+            }
+        }
+        len = npdu_encode_pdu(npdu, &dest, NULL, &npdu_data);
+        npdu[len] = PDU_TYPE_UNCONFIRMED_SERVICE_REQUEST;
+        npdu[len + 1] = SERVICE_UNCONFIRMED_PRIVATE_TRANSFER;
+        encode_unsigned16(&npdu[len + 2], ROUTERBENCH_MAGIC);
+        npdu[len + ROUTERBENCH_APDU_MIX] = (uint8_t)mix;
+        npdu[len + ROUTERBENCH_APDU_MIX + 1] = (uint8_t)port->index;
+        now = clock_ns();
+        memcpy(&npdu[len + ROUTERBENCH_APDU_TIME], &now, sizeof(now));
+        len += APDU_Len;
+    }
+
+    return bvlc_encode_original_unicast(mtu, mtu_size, npdu, (uint16_t)len);
+}
+
+static void pending_push(struct routerbench_port *port, uint64_t now)
+{
+    unsigned index;
+
+    pthread_mutex_lock(&port->lock);
+    if (port->pending_count < ROUTERBENCH_PENDING_MAX) {
+        index = (port->pending_head + port->pending_count) %
+            ROUTERBENCH_PENDING_MAX;
+        port->pending_ns[index] = now;
+        port->pending_count++;
+    }
+    pthread_mutex_unlock(&port->lock);
+}
+
+/* replies are matched to requests in order */
+static bool pending_pop(struct routerbench_port *port, uint64_t *sent_ns)
+{
+    bool status = false;
+
+    pthread_mutex_lock(&port->lock);
+    if (port->pending_count) {
+        *sent_ns = port->pending_ns[port->pending_head];
+        port->pending_head = (port->pending_head + 1) % ROUTERBENCH_PENDING_MAX;
+        port->pending_count--;
+        status = true;
+    }
+    pthread_mutex_unlock(&port->lock);
+
+    return status;
+}
+
+/* send the current mix from the station of one port to the others */
+static void *generator_thread(void *arg)
+{
+    struct routerbench_port *port = arg;
+    struct routerbench_port *target;
+    uint8_t mtu[BIP_MPDU_MAX];
+    uint64_t start_ns, now;
+    unsigned long due;
+    unsigned burst;
+    unsigned next = port->index;
+    int mix = Current_Mix;
+    int len;
+
+    start_ns = clock_ns();
+    while (Generating) {
+        now = clock_ns();
+        if (Rate) {
+            due = (unsigned long)(((now - start_ns) * Rate) / 1000000000ULL);
+        } else {
+            due = port->sent + ROUTERBENCH_BURST;
+        }
+        for (burst = 0; (port->sent < due) && (burst < ROUTERBENCH_BURST);
+             burst++) {
+            next = (next + 1) % Port_Count;
+            if (next == port->index) {
+                next = (next + 1) % Port_Count;
+            }
+            target = &Ports[next];
+            len = packet_encode(mtu, sizeof(mtu), mix, port, target);
+            if (mix == MIX_NETWORK) {
+                pending_push(port, clock_ns());
+            }
+            if (sendto(port->unicast_fd, mtu, (size_t)len, 0,
+                    (struct sockaddr *)&port->router,
+                    sizeof(port->router)) == len) {
+                port->sent++;
+                port->expected += (mix == MIX_GLOBAL) ? (Port_Count - 1) : 1;
+            } else if (mix == MIX_NETWORK) {
+                pthread_mutex_lock(&port->lock);
+                port->pending_count--;
+                pthread_mutex_unlock(&port->lock);
+            }
+        }
+        if (Rate) {
+            sleep_ns(100000ULL);
+        }
+    }
+
+    return NULL;
+}
+
+static void latency_record(uint64_t latency_ns)
+{
+    uint64_t us = latency_ns / 1000;
+
+    if (us > ROUTERBENCH_LATENCY_MAX_US) {
+        us = ROUTERBENCH_LATENCY_MAX_US;
+    }
+    Stats.histogram[us]++;
+    Stats.latency_count++;
+    if (latency_ns > Stats.latency_max_ns) {
+        Stats.latency_max_ns = latency_ns;
+    }
+}
+
+/* account for one packet that a station received from the router */
+static void packet_receive(
+    struct routerbench_port *port, uint8_t *mtu, uint16_t mtu_len)
+{
+    BACNET_NPDU_DATA npdu_data = { 0 };
+    BACNET_ADDRESS dest = { 0 };
+    BACNET_ADDRESS src = { 0 };
+    uint8_t message_type = 0;
+    uint16_t message_len = 0;
+    uint16_t magic = 0;
+    uint64_t sent_ns = 0;
+    uint8_t *npdu, *apdu;
+    uint16_t npdu_len;
+    int offset, len;
+
+    offset = bvlc_decode_header(mtu, mtu_len, &message_type, &message_len);
+    if ((offset <= 0) || (message_len > mtu_len) ||
+        ((message_type != BVLC_ORIGINAL_UNICAST_NPDU) &&
+            (message_type != BVLC_ORIGINAL_BROADCAST_NPDU))) {
+        return;
+    }
+    npdu = &mtu[offset];
+    npdu_len = message_len - offset;
+    len = bacnet_npdu_decode(npdu, npdu_len, &dest, &src, &npdu_data);
+    if (len <= 0) {
+        return;
+    }
+    pthread_mutex_lock(&Stats_Lock);
+    if (npdu_data.network_layer_message) {
+        if ((Current_Mix == MIX_NETWORK) &&
+            (npdu_data.network_message_type ==
+                NETWORK_MESSAGE_I_AM_ROUTER_TO_NETWORK) &&
+            pending_pop(port, &sent_ns)) {
+            Stats.received++;
+            latency_record(clock_ns() - sent_ns);
+        }
+    } else if ((npdu_len - len) >= ROUTERBENCH_APDU_MIN) {
+        apdu = &npdu[len];
+        decode_unsigned16(&apdu[2], &magic);
+        if ((magic == ROUTERBENCH_MAGIC) &&
+            (apdu[ROUTERBENCH_APDU_MIX] == Current_Mix)) {
+            memcpy(&sent_ns, &apdu[ROUTERBENCH_APDU_TIME], sizeof(sent_ns));
+            Stats.received++;
+            latency_record(clock_ns() - sent_ns);
+        }
+    }
+    pthread_mutex_unlock(&Stats_Lock);
+}
+
+static void *receiver_thread(void *arg)
+{
+    struct pollfd pfd[ROUTERBENCH_PORTS_MAX * 2];
+    uint8_t mtu[BIP_MPDU_MAX];
+    ssize_t len;
+    unsigned i;
+
+    (void)arg;
+    for (i = 0; i < Port_Count; i++) {
+        pfd[i * 2].fd = Ports[i].unicast_fd;
+        pfd[i * 2].events = POLLIN;
+        pfd[(i * 2) + 1].fd = Ports[i].broadcast_fd;
+        pfd[(i * 2) + 1].events = POLLIN;
+    }
+    while (Receiving) {
+        if (poll(pfd, Port_Count * 2, 50) <= 0) {
+            continue;
+        }
+        for (i = 0; i < (Port_Count * 2); i++) {
+            if (!(pfd[i].revents & POLLIN)) {
+                continue;
+            }
+            for (;;) {
+                len = recv(pfd[i].fd, mtu, sizeof(mtu), 0);
+                if (len <= 0) {
+                    break;
+                }
+                packet_receive(&Ports[i / 2], mtu, (uint16_t)len);
+            }
+        }
+    }
+
+    return NULL;
+}
+
+/* wait until the router answers a Who-Is-Router-To-Network */
+static bool router_ready(void)
+{
+    struct pollfd pfd[2];
+    uint8_t mtu[BIP_MPDU_MAX];
+    uint8_t npdu[8];
+    BACNET_NPDU_DATA npdu_data;
+    BACNET_ADDRESS dest, src;
+    int len, npdu_len, mtu_len, offset;
+    unsigned tries, i;
+
+    npdu_encode_npdu_network(&npdu_data,
+        NETWORK_MESSAGE_WHO_IS_ROUTER_TO_NETWORK, false,
+        MESSAGE_PRIORITY_NORMAL);
+    npdu_len = npdu_encode_pdu(npdu, NULL, NULL, &npdu_data);
+    mtu_len = bvlc_encode_original_unicast(
+        mtu, sizeof(mtu), npdu, (uint16_t)npdu_len);
+    pfd[0].fd = Ports[0].unicast_fd;
+    pfd[0].events = POLLIN;
+    pfd[1].fd = Ports[0].broadcast_fd;
+    pfd[1].events = POLLIN;
+    for (tries = 0; (tries < 50) && !Interrupted; tries++) {
+        if (waitpid(Router_Pid, NULL, WNOHANG) == Router_Pid) {
+            Router_Pid = 0;
+            return false;
+        }
+        sendto(Ports[0].unicast_fd, mtu, (size_t)mtu_len, 0,
+            (struct sockaddr *)&Ports[0].router, sizeof(Ports[0].router));
+        if (poll(pfd, 2, 100) <= 0) {
+            continue;
+        }
+        for (i = 0; i < 2; i++) {
+            while ((len = recv(pfd[i].fd, mtu, sizeof(mtu), 0)) > 0) {
+                offset = bvlc_decode_header(mtu, (uint16_t)len, NULL, NULL);
+                if ((offset > 0) &&
+                    (bacnet_npdu_decode(&mtu[offset],
+                         (uint16_t)(len - offset), &dest, &src,
+                         &npdu_data) > 0) &&
+                    npdu_data.network_layer_message &&
+                    (npdu_data.network_message_type ==
+                        NETWORK_MESSAGE_I_AM_ROUTER_TO_NETWORK)) {
+                    return true;
+                }
+            }
+        }
+        /* the request is encoded again into the same buffer */
+        mtu_len = bvlc_encode_original_unicast(
+            mtu, sizeof(mtu), npdu, (uint16_t)npdu_len);
+    }
+
+    return false;
+}
+
+static uint64_t latency_percentile(unsigned percent)
+{
+    unsigned long target, count = 0;
+    unsigned us;
+
+    if (Stats.latency_count == 0) {
+        return 0;
+    }
+    target = ((Stats.latency_count * percent) + 99) / 100;
+    for (us = 0; us <= ROUTERBENCH_LATENCY_MAX_US; us++) {
+        count += Stats.histogram[us];
+        if (count >= target) {
+            break;
+        }
+    }
+
+    return us;
+}
+
+static void routerbench_print_header(void)
+{
+    printf("router ports %u, rate %u pps per port, %u seconds per mix, "
+           "APDU %u octets\n",
+        Port_Count, Rate, Seconds, APDU_Len);
+    printf("%-10s %10s %10s %10s %8s %10s %7s %7s %7s %7s\n", "mix", "sent",
+        "expected", "received", "dropped", "pps", "p50-us", "p90-us",
+        "p99-us", "max-us");
+}
+
+/* run one traffic mix through the router and print its results */
+static void routerbench_mix(int mix)
+{
+    unsigned long sent = 0, expected = 0, dropped;
+    uint64_t start_ns, elapsed_ns;
+    unsigned i;
+
+    pthread_mutex_lock(&Stats_Lock);
+    memset(&Stats, 0, sizeof(Stats));
+    Current_Mix = mix;
+    pthread_mutex_unlock(&Stats_Lock);
+    for (i = 0; i < Port_Count; i++) {
+        Ports[i].sent = 0;
+        Ports[i].expected = 0;
+        Ports[i].pending_head = 0;
+        Ports[i].pending_count = 0;
+    }
+    Generating = true;
+    start_ns = clock_ns();
+    for (i = 0; i < Port_Count; i++) {
+        pthread_create(&Ports[i].thread, NULL, generator_thread, &Ports[i]);
+    }
+    while (Generating && ((clock_ns() - start_ns) < (Seconds * 1000000000ULL))) {
+        sleep_ns(10000000ULL);
+    }
+    Generating = false;
+    for (i = 0; i < Port_Count; i++) {
+        pthread_join(Ports[i].thread, NULL);
+        sent += Ports[i].sent;
+        expected += Ports[i].expected;
+    }
+    elapsed_ns = clock_ns() - start_ns;
+    /* packets still in the router are not dropped yet */
+    sleep_ns(500000000ULL);
+    pthread_mutex_lock(&Stats_Lock);
+    Current_Mix = MIX_MAX;
+    dropped = (expected > Stats.received) ? (expected - Stats.received) : 0;
+    printf("%-10s %10lu %10lu %10lu %8lu %10.0f %7lu %7lu %7lu %7lu\n",
+        Mix_Names[mix], sent, expected, Stats.received, dropped,
+        (double)Stats.received * 1000000000.0 / (double)elapsed_ns,
+        (unsigned long)latency_percentile(50),
+        (unsigned long)latency_percentile(90),
+        (unsigned long)latency_percentile(99),
+        (unsigned long)(Stats.latency_max_ns / 1000));
+    pthread_mutex_unlock(&Stats_Lock);
+    fflush(stdout);
+}
+
+static void routerbench_cleanup(void)
+{
+    unsigned i;
+
+    router_stop();
+    for (i = 0; i < Port_Count; i++) {
+        if (Ports[i].unicast_fd >= 0) {
+            close(Ports[i].unicast_fd);
+        }
+        if (Ports[i].broadcast_fd >= 0) {
+            close(Ports[i].broadcast_fd);
+        }
+        alias_remove(&Ports[i]);
+    }
+}
+
+static void print_usage(const char *filename)
+{
+    printf("Usage: %s [--ports N][--rate N][--seconds N][--apdu N]\n"
+           "       [--mix unicast|broadcast|global|network|all]\n"
+           "       [--udp-port N][--network N][--router PATH][--verbose]\n",
+        filename);
+    printf("       [--version][--help]\n");
+}
+
+static void print_help(const char *filename)
+{
+    printf("Start the BACnet router with B/IP ports on loopback address\n"
+           "aliases, send routed traffic between a station on each port\n"
+           "and report the forwarded packets per second, the latency\n"
+           "through the router and the drops. Needs root to add the\n"
+           "aliases lo:rb0 to lo:rbN-1 at 127.0.100.1 and up.\n");
+    printf("\n");
+    printf("--ports N\n"
+           "Number of router ports, 2 to %u. Default %u.\n",
+        ROUTERBENCH_PORTS_MAX, Port_Count);
+    printf("--rate N\n"
+           "Packets per second sent by the station of each port,\n"
+           "or 0 to send as fast as possible. Default %u.\n", Rate);
+    printf("--seconds N\n"
+           "Duration of each traffic mix. Default %u.\n", Seconds);
+    printf("--apdu N\n"
+           "APDU length of each packet, %u to %u. Default %u.\n",
+        ROUTERBENCH_APDU_MIN, MAX_APDU, APDU_Len);
+    printf("--mix name\n"
+           "unicast: to a station on another network.\n"
+           "broadcast: remote broadcast to another network.\n"
+           "global: global broadcast to every other network.\n"
+           "network: Who-Is-Router-To-Network, answered by the router.\n"
+           "all: every mix in turn. This is the default.\n");
+    printf("--udp-port N\n"
+           "UDP port of the first router port; the others follow.\n"
+           "Default %u.\n", First_UDP_Port);
+    printf("--network N\n"
+           "Network number of the first router port; the others follow.\n"
+           "Default %u.\n", First_Network);
+    printf("--router PATH\n"
+           "Router executable. Default %s.\n", Router_Path);
+    printf("--verbose\n"
+           "Show the router output, and its port latency at the end.\n");
+    printf("\n");
+    printf("Example:\n"
+           "%s --ports 4 --rate 0 --mix unicast --router bin/router\n",
+        filename);
+}
+
+int main(int argc, char *argv[])
+{
+    int mix_first = 0, mix_last = MIX_MAX - 1;
+    unsigned long value;
+    pthread_t receiver;
+    int argi, mix;
+    unsigned i;
+
+    for (argi = 1; argi < argc; argi++) {
+        if (strcmp(argv[argi], "--help") == 0) {
+            print_usage(argv[0]);
+            print_help(argv[0]);
+            return 0;
+        }
+        if (strcmp(argv[argi], "--version") == 0) {
+            printf("routerbench %s\n", BACNET_VERSION_TEXT);
+            printf("This is free software; see the source for copying "
+                   "conditions.\n"
+                   "There is NO warranty; not even for MERCHANTABILITY or\n"
+                   "FITNESS FOR A PARTICULAR PURPOSE.\n");
+            return 0;
+        }
+        if (strcmp(argv[argi], "--verbose") == 0) {
+            Verbose = true;
+            continue;
+        }
+        if ((argi + 1) >= argc) {
+            print_usage(argv[0]);
+            return 1;
+        }
+        value = strtoul(argv[argi + 1], NULL, 0);
+        if (strcmp(argv[argi], "--ports") == 0) {
+            Port_Count = (unsigned)value;
+        } else if (strcmp(argv[argi], "--rate") == 0) {
+            Rate = (unsigned)value;
+        } else if (strcmp(argv[argi], "--seconds") == 0) {
+            Seconds = (unsigned)value;
+        } else if (strcmp(argv[argi], "--apdu") == 0) {
+            APDU_Len = (unsigned)value;
+        } else if (strcmp(argv[argi], "--udp-port") == 0) {
+            First_UDP_Port = (uint16_t)value;
+        } else if (strcmp(argv[argi], "--network") == 0) {
+            First_Network = (uint16_t)value;
+        } else if (strcmp(argv[argi], "--router") == 0) {
+            Router_Path = argv[argi + 1];
+        } else if (strcmp(argv[argi], "--mix") == 0) {
+            mix_first = 0;
+            mix_last = MIX_MAX - 1;
+            for (mix = 0; mix < MIX_MAX; mix++) {
+                if (strcmp(argv[argi + 1], Mix_Names[mix]) == 0) {
+                    mix_first = mix_last = mix;
+                }
+            }
+            if ((mix_first != mix_last) &&
+                (strcmp(argv[argi + 1], "all") != 0)) {
+                print_usage(argv[0]);
+                return 1;
+            }
+        } else {
+            print_usage(argv[0]);
+            return 1;
+        }
+        argi++;
+    }
+    if ((Port_Count < 2) || (Port_Count > ROUTERBENCH_PORTS_MAX) ||
+        (Seconds == 0) || (APDU_Len < ROUTERBENCH_APDU_MIN) ||
+        (APDU_Len > MAX_APDU) || (First_UDP_Port == 0) ||
+        (First_Network == 0) ||
+        ((First_Network + Port_Count) > BACNET_BROADCAST_NETWORK)) {
+        fprintf(stderr, "routerbench: invalid setting\n");
+        return 1;
+    }
+    signal(SIGINT, interrupt_handler);
+    signal(SIGTERM, interrupt_handler);
+    signal(SIGPIPE, SIG_IGN);
+    for (i = 0; i < Port_Count; i++) {
+        port_init(&Ports[i], i);
+    }
+    for (i = 0; i < Port_Count; i++) {
+        if (!alias_add(&Ports[i])) {
+            fprintf(stderr, "routerbench: unable to add lo:rb%u\n", i);
+            routerbench_cleanup();
+            return 1;
+        }
+        Ports[i].unicast_fd = station_socket(&Ports[i].station);
+        Ports[i].broadcast_fd = station_socket(&Ports[i].broadcast);
+        if ((Ports[i].unicast_fd < 0) || (Ports[i].broadcast_fd < 0)) {
+            fprintf(stderr, "routerbench: unable to bind station %u: %s\n",
+                i, strerror(errno));
+            routerbench_cleanup();
+            return 1;
+        }
+    }
+    router_start();
+    if ((Router_Pid < 0) || !router_ready()) {
+        fprintf(stderr, "routerbench: %s did not answer\n", Router_Path);
+        routerbench_cleanup();
+        return 1;
+    }
+    Receiving = true;
+    pthread_create(&receiver, NULL, receiver_thread, NULL);
+    routerbench_print_header();
+    for (mix = mix_first; (mix <= mix_last) && !Interrupted; mix++) {
+        routerbench_mix(mix);
+    }
+    Receiving = false;
+    pthread_join(receiver, NULL);
+    routerbench_cleanup();
+
+    return 0;
+}
@@ -293,6 +293,34 @@ int bip_send_mpdu(BACNET_IP_ADDRESS *dest, uint8_t *mtu, uint16_t mtu_len)
         (struct sockaddr *)&bip_dest, sizeof(struct sockaddr));
 }
 
+/**
+ * The send function for a list of destinations that all get the
+ * same BACnet/IP datagram
+ *
+ * @param dest_list - array of destination addresses
+ * @param dest_count - number of destination addresses
+ * @param mtu - the bytes of data to send
+ * @param mtu_len - the number of bytes of data to send
+ *
+ * @return number of datagrams that were sent
+ */
+int bip_send_mpdu_list(BACNET_IP_ADDRESS *dest_list,
+    unsigned dest_count,
+    uint8_t *mtu,
+    uint16_t mtu_len)
+{
+    unsigned i = 0;
+    int sent = 0;
+
+    for (i = 0; i < dest_count; i++) {
+        if (bip_send_mpdu(&dest_list[i], mtu, mtu_len) > 0) {
+            sent++;
+        }
+    }
+
+    return sent;
+}
+
 /**
  * BACnet/IP Datalink Receive handler.
  *
@@ -31,6 +31,10 @@
  License.
  -------------------------------------------
 ####COPYRIGHTEND####*/
+/* for sendmmsg() */
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
 /* linux Ethernet/IP specific */
 #include <asm/types.h>
 #include <netinet/ether.h>
@@ -59,6 +63,11 @@
 
 /** @file linux/bip-init.c  Initializes BACnet/IP interface (Linux). */
 
+/* number of datagrams given to sendmmsg() at once */
+#ifndef BIP_SEND_BATCH_MAX
+#define BIP_SEND_BATCH_MAX 32
+#endif
+
 /* unix sockets */
 static int BIP_Socket = -1;
 static int BIP_Broadcast_Socket = -1;
@@ -309,6 +318,76 @@ int bip_send_mpdu(BACNET_IP_ADDRESS *dest, uint8_t *mtu, uint16_t mtu_len)
         (struct sockaddr *)&bip_dest, sizeof(struct sockaddr));
 }
 
+/**
+ * The send function for a list of destinations that all get the
+ * same BACnet/IP datagram.  The datagrams are handed to the kernel
+ * in batches with sendmmsg().
+ *
+ * @param dest_list - array of destination addresses
+ * @param dest_count - number of destination addresses
+ * @param mtu - the bytes of data to send
+ * @param mtu_len - the number of bytes of data to send
+ *
+ * @return number of datagrams that were sent
+ */
+int bip_send_mpdu_list(BACNET_IP_ADDRESS *dest_list,
+    unsigned dest_count,
+    uint8_t *mtu,
+    uint16_t mtu_len)
+{
+    struct sockaddr_in bip_dest[BIP_SEND_BATCH_MAX];
+    struct mmsghdr msgs[BIP_SEND_BATCH_MAX];
+    struct iovec iov = { 0 };
+    unsigned batch = 0;
+    unsigned offset = 0;
+    unsigned i = 0;
+    int sent = 0;
+    int rv = 0;
+
+    /* assumes that the driver has already been initialized */
+    if (BIP_Socket < 0) {
+        if (BIP_Debug) {
+            fprintf(stderr, "BIP: driver not initialized!\n");
+            fflush(stderr);
+        }
+        return BIP_Socket;
+    }
+    iov.iov_base = mtu;
+    iov.iov_len = mtu_len;
+    while (offset < dest_count) {
+        batch = dest_count - offset;
+        if (batch > BIP_SEND_BATCH_MAX) {
+            batch = BIP_SEND_BATCH_MAX;
+        }
+        memset(bip_dest, 0, sizeof(bip_dest));
+        memset(msgs, 0, sizeof(msgs));
+        for (i = 0; i < batch; i++) {
+            bip_dest[i].sin_family = AF_INET;
+            memcpy(&bip_dest[i].sin_addr.s_addr,
+                &dest_list[offset + i].address[0], 4);
+            bip_dest[i].sin_port = htons(dest_list[offset + i].port);
+            msgs[i].msg_hdr.msg_name = &bip_dest[i];
+            msgs[i].msg_hdr.msg_namelen = sizeof(struct sockaddr_in);
+            msgs[i].msg_hdr.msg_iov = &iov;
+            msgs[i].msg_hdr.msg_iovlen = 1;
+        }
+        rv = sendmmsg(BIP_Socket, msgs, batch, 0);
+        if (rv <= 0) {
+            /* the first datagram of the batch failed and is dropped */
+            offset++;
+        } else {
+            sent += rv;
+            offset += (unsigned)rv;
+        }
+    }
+    if (BIP_Debug) {
+        fprintf(stderr, "BIP: Sent %d of %u MPDU\n", sent, dest_count);
+        fflush(stderr);
+    }
+
+    return sent;
+}
+
 /**
  * BACnet/IP Datalink Receive handler.
  *
@@ -37,7 +37,7 @@
 #include "rs485.h"
 #include "bacnet/npdu.h"
 #include "bacnet/bits.h"
-#include "bacnet/basic/sys/ringbuf.h"
+#include "bacnet/basic/sys/prioq.h"
 #include "bacnet/basic/sys/debug.h"
 /* OS Specific include */
 #include "bacport.h"
@@ -67,7 +67,7 @@ static pthread_cond_t Received_Frame_Flag;
 static pthread_mutex_t Received_Frame_Mutex;
 static pthread_cond_t Master_Done_Flag;
 static pthread_mutex_t Master_Done_Mutex;
-static pthread_mutex_t Ring_Buffer_Mutex;
+static pthread_mutex_t PDU_Queue_Mutex;
 static pthread_mutex_t Thread_Mutex;
 
 static pthread_t hThread;
@@ -86,12 +86,22 @@ struct mstp_pdu_packet {
     uint16_t length;
     uint8_t buffer[DLMSTP_MPDU_MAX];
 };
-/* count must be a power of 2 for ringbuf library */
 #ifndef MSTP_PDU_PACKET_COUNT
 #define MSTP_PDU_PACKET_COUNT 8
 #endif
+/* milliseconds that a queued PDU waits to gain one network priority */
+#ifndef MSTP_PDU_AGING_TIME
+#define MSTP_PDU_AGING_TIME 1000
+#endif
+/* transmit queue by network priority, of PDU_Buffer slots */
 static struct mstp_pdu_packet PDU_Buffer[MSTP_PDU_PACKET_COUNT];
-static RING_BUFFER PDU_Queue;
+static struct prioq_slot PDU_Slot[MSTP_PDU_PACKET_COUNT];
+static PRIOQ PDU_Queue;
+/* transmit queue and token hold counters - protected by PDU_Queue_Mutex */
+static DLMSTP_STATISTICS Statistics;
+/* start of the previous token hold, for the token rotation time */
+static struct timespec Token_Hold_Start;
+static bool Token_Hold_Started;
 /* The minimum time without a DataAvailable or ReceiveError event */
 /* that a node must wait for a station to begin replying to a */
 /* confirmed request: 255 milliseconds. (Implementations may use */
@@ -199,7 +209,17 @@ void dlmstp_cleanup(void)
     pthread_mutex_destroy(&Received_Frame_Mutex);
     pthread_mutex_destroy(&Receive_Packet_Mutex);
     pthread_mutex_destroy(&Master_Done_Mutex);
-    pthread_mutex_destroy (&Ring_Buffer_Mutex);
+    pthread_mutex_destroy (&PDU_Queue_Mutex);
+}
+
+/* milliseconds clock for the age of queued PDU */
+static uint32_t dlmstp_queue_clock(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (uint32_t)((now.tv_sec * 1000) + (now.tv_nsec / 1000000));
 }
 
 /* returns number of bytes sent on success, zero on failure */
@@ -211,9 +231,23 @@ int dlmstp_send_pdu(BACNET_ADDRESS *dest, /* destination address */
     int bytes_sent = 0;
     struct mstp_pdu_packet *pkt;
     unsigned i = 0;
-    pthread_mutex_lock (&Ring_Buffer_Mutex);
-    pkt = (struct mstp_pdu_packet *)Ringbuf_Data_Peek(&PDU_Queue);
-    if (pkt) {
+    uint8_t priority;
+    bool evicted = false;
+    int slot;
+
+    if (pdu_len > sizeof(pkt->buffer)) {
+        return 0;
+    }
+    priority = (uint8_t)npdu_data->priority;
+    pthread_mutex_lock (&PDU_Queue_Mutex);
+    /* a full queue makes room by evicting the newest PDU
+       of a lower network priority */
+    slot = Prioq_Reserve(&PDU_Queue, priority, &evicted);
+    if (evicted) {
+        Statistics.transmit_queue_drop_counter++;
+    }
+    if (slot >= 0) {
+        pkt = &PDU_Buffer[slot];
         pkt->data_expecting_reply = npdu_data->data_expecting_reply;
         for (i = 0; i < pdu_len; i++) {
             pkt->buffer[i] = pdu[i];
@@ -225,11 +259,18 @@ int dlmstp_send_pdu(BACNET_ADDRESS *dest, /* destination address */
             /* mac_len = 0 is a broadcast address */
             pkt->destination_mac = MSTP_BROADCAST_ADDRESS;
         }
-        if (Ringbuf_Data_Put(&PDU_Queue, (uint8_t *)pkt)) {
-            bytes_sent = pdu_len;
+        Prioq_Put(&PDU_Queue, (unsigned)slot, priority, dlmstp_queue_clock());
+        bytes_sent = pdu_len;
+    }
+    if (bytes_sent) {
+        Statistics.transmit_queue_depth = Prioq_Count(&PDU_Queue);
+        if (Statistics.transmit_queue_peak < Statistics.transmit_queue_depth) {
+            Statistics.transmit_queue_peak = Statistics.transmit_queue_depth;
         }
+    } else {
+        Statistics.transmit_queue_drop_counter++;
     }
-    pthread_mutex_unlock (&Ring_Buffer_Mutex);
+    pthread_mutex_unlock (&PDU_Queue_Mutex);
 
     return bytes_sent;
 }
@@ -372,6 +413,7 @@ uint16_t MSTP_Put_Receive(volatile struct mstp_port_struct_t *mstp_port)
             &Receive_Packet.address, mstp_port->SourceAddress);
         Receive_Packet.pdu_len = mstp_port->DataLength;
         Receive_Packet.ready = true;
+        Statistics.receive_pdu_counter++;
         pthread_cond_signal(&Receive_Packet_Flag);
     }
     pthread_mutex_unlock(&Receive_Packet_Mutex);
@@ -379,6 +421,38 @@ uint16_t MSTP_Put_Receive(volatile struct mstp_port_struct_t *mstp_port)
     return pdu_len;
 }
 
+/****************************************************************************
+* DESCRIPTION: Start of a token hold: measures the token rotation time and,
+*              in adaptive mode, sets the per-token frame budget from the
+*              transmit queue depth.
+* RETURN:      none
+* NOTES:       called with PDU_Queue_Mutex locked
+*****************************************************************************/
+static void dlmstp_token_hold_start(
+    volatile struct mstp_port_struct_t *mstp_port)
+{
+    struct timespec now, diff;
+    uint32_t rotation_ms = 0;
+    uint8_t budget;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    if (Token_Hold_Started) {
+        timespec_subtract(&diff, &now, &Token_Hold_Start);
+        rotation_ms = (diff.tv_sec * 1000) + (diff.tv_nsec / 1000000);
+    }
+    Token_Hold_Start = now;
+    Token_Hold_Started = true;
+    budget = MSTP_Adaptive_Info_Frames(mstp_port,
+        Prioq_Count(&PDU_Queue), rotation_ms, MSTP_TOKEN_ROTATION_TARGET);
+    Statistics.token_hold_counter++;
+    Statistics.token_hold_budget_counter += budget;
+    Statistics.info_frames_budget = budget;
+    if (rotation_ms > UINT16_MAX) {
+        rotation_ms = UINT16_MAX;
+    }
+    Statistics.token_rotation_time = (uint16_t)rotation_ms;
+}
+
 /* for the MS/TP state machine to use for getting data to send */
 /* Return: amount of PDU data */
 uint16_t MSTP_Get_Send(
@@ -387,14 +461,23 @@ uint16_t MSTP_Get_Send(
     uint16_t pdu_len = 0;
     uint8_t frame_type = 0;
     struct mstp_pdu_packet *pkt;
+    uint32_t now;
+    int slot;
 
     (void)timeout;
-    pthread_mutex_lock (&Ring_Buffer_Mutex);
-    if (Ringbuf_Empty(&PDU_Queue)) {
-        pthread_mutex_unlock (&Ring_Buffer_Mutex);
+    pthread_mutex_lock (&PDU_Queue_Mutex);
+    if (mstp_port->FrameCount == 0) {
+        dlmstp_token_hold_start(mstp_port);
+    }
+    /* the oldest PDU of the highest network priority,
+       after aging lower priorities by the time they waited */
+    now = dlmstp_queue_clock();
+    slot = Prioq_Peek(&PDU_Queue, now);
+    if (slot < 0) {
+        pthread_mutex_unlock (&PDU_Queue_Mutex);
         return 0;
     }
-    pkt = (struct mstp_pdu_packet *)Ringbuf_Peek(&PDU_Queue);
+    pkt = &PDU_Buffer[slot];
     if (pkt->data_expecting_reply) {
         frame_type = FRAME_TYPE_BACNET_DATA_EXPECTING_REPLY;
     } else {
@@ -405,8 +488,11 @@ uint16_t MSTP_Get_Send(
         MSTP_Create_Frame(&mstp_port->OutputBuffer[0], /* <-- loading this */
             mstp_port->OutputBufferSize, frame_type, pkt->destination_mac,
             mstp_port->This_Station, (uint8_t *)&pkt->buffer[0], pkt->length);
-    (void)Ringbuf_Pop(&PDU_Queue, NULL);
-    pthread_mutex_unlock (&Ring_Buffer_Mutex);
+    Prioq_Remove(&PDU_Queue, (unsigned)slot, now);
+    Statistics.transmit_pdu_counter++;
+    Statistics.token_hold_frame_counter++;
+    Statistics.transmit_queue_depth = Prioq_Count(&PDU_Queue);
+    pthread_mutex_unlock (&PDU_Queue_Mutex);
 
     return pdu_len;
 }
@@ -573,17 +659,24 @@ uint16_t MSTP_Get_Reply(
     bool matched = false;
     uint8_t frame_type = 0;
     struct mstp_pdu_packet *pkt;
+    uint32_t now;
+    int slot;
 
     (void)timeout;
-    if (Ringbuf_Empty(&PDU_Queue)) {
+    pthread_mutex_lock (&PDU_Queue_Mutex);
+    now = dlmstp_queue_clock();
+    slot = Prioq_Peek(&PDU_Queue, now);
+    if (slot < 0) {
+        pthread_mutex_unlock (&PDU_Queue_Mutex);
         return 0;
     }
-    pkt = (struct mstp_pdu_packet *)Ringbuf_Peek(&PDU_Queue);
+    pkt = &PDU_Buffer[slot];
     /* is this the reply to the DER? */
     matched = dlmstp_compare_data_expecting_reply(&mstp_port->InputBuffer[0],
         mstp_port->DataLength, mstp_port->SourceAddress,
         (uint8_t *)&pkt->buffer[0], pkt->length, pkt->destination_mac);
     if (!matched) {
+        pthread_mutex_unlock (&PDU_Queue_Mutex);
         return 0;
     }
     if (pkt->data_expecting_reply) {
@@ -596,7 +689,10 @@ uint16_t MSTP_Get_Reply(
         MSTP_Create_Frame(&mstp_port->OutputBuffer[0], /* <-- loading this */
             mstp_port->OutputBufferSize, frame_type, pkt->destination_mac,
             mstp_port->This_Station, (uint8_t *)&pkt->buffer[0], pkt->length);
-    (void)Ringbuf_Pop(&PDU_Queue, NULL);
+    Prioq_Remove(&PDU_Queue, (unsigned)slot, now);
+    Statistics.transmit_pdu_counter++;
+    Statistics.transmit_queue_depth = Prioq_Count(&PDU_Queue);
+    pthread_mutex_unlock (&PDU_Queue_Mutex);
 
     return pdu_len;
 }
@@ -649,6 +745,64 @@ uint8_t dlmstp_max_info_frames(void)
     return MSTP_Port.Nmax_info_frames;
 }
 
+/* Adaptive Max_Info_Frames: while frames are queued, the node may send up */
+/* to this many frames per token hold, scaled back whenever the token */
+/* rotation time exceeds MSTP_TOKEN_ROTATION_TARGET. */
+void dlmstp_set_max_info_frames_adaptive(uint8_t limit)
+{
+    MSTP_Port.Nmax_info_frames_adaptive = limit;
+}
+
+uint8_t dlmstp_max_info_frames_adaptive(void)
+{
+    return MSTP_Port.Nmax_info_frames_adaptive;
+}
+
+/* Reset the statistics counters on the MS/TP datalink */
+void dlmstp_reset_statistics(void)
+{
+    pthread_mutex_lock(&PDU_Queue_Mutex);
+    memset(&Statistics, 0, sizeof(Statistics));
+    Statistics.transmit_queue_depth = Prioq_Count(&PDU_Queue);
+    Statistics.transmit_queue_peak = Statistics.transmit_queue_depth;
+    pthread_mutex_unlock(&PDU_Queue_Mutex);
+}
+
+/* Retrieve statistics counters from the MS/TP datalink */
+void dlmstp_fill_statistics(struct dlmstp_statistics *statistics)
+{
+    if (statistics) {
+        pthread_mutex_lock(&PDU_Queue_Mutex);
+        memcpy(statistics, &Statistics, sizeof(Statistics));
+        pthread_mutex_unlock(&PDU_Queue_Mutex);
+    }
+}
+
+/* Copy the transmit queue counters of each network priority */
+bool dlmstp_fill_queue_statistics(PRIOQ_STATS *stats)
+{
+    unsigned i;
+
+    if (!stats) {
+        return false;
+    }
+    pthread_mutex_lock(&PDU_Queue_Mutex);
+    for (i = 0; i < PRIOQ_CLASSES; i++) {
+        stats[i] = *Prioq_Stats(&PDU_Queue, (uint8_t)i);
+    }
+    pthread_mutex_unlock(&PDU_Queue_Mutex);
+
+    return true;
+}
+
+/* Reset the transmit queue counters of each network priority */
+void dlmstp_reset_queue_statistics(void)
+{
+    pthread_mutex_lock(&PDU_Queue_Mutex);
+    Prioq_Stats_Reset(&PDU_Queue);
+    pthread_mutex_unlock(&PDU_Queue_Mutex);
+}
+
 /* This parameter represents the value of the Max_Master property of the */
 /* node's Device object. The value of Max_Master specifies the highest */
 /* allowable address for master nodes. The value of Max_Master shall be */
@@ -731,12 +885,12 @@ bool dlmstp_init(char *ifname)
         exit(1);
     }
 
-    pthread_mutex_init (&Ring_Buffer_Mutex, NULL);
+    pthread_mutex_init (&PDU_Queue_Mutex, NULL);
     pthread_mutex_init (&Thread_Mutex, NULL);
 
     /* initialize PDU queue */
-    Ringbuf_Init(&PDU_Queue, (uint8_t *)&PDU_Buffer,
-        sizeof(struct mstp_pdu_packet), MSTP_PDU_PACKET_COUNT);
+    Prioq_Init(&PDU_Queue, PDU_Slot, MSTP_PDU_PACKET_COUNT,
+        MSTP_PDU_AGING_TIME);
     /* initialize packet queue */
     Receive_Packet.ready = false;
     Receive_Packet.pdu_len = 0;
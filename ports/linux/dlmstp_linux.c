@@ -28,7 +28,11 @@
 #include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
+#include <errno.h>
 #include <time.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
 #include "bacnet/bacdef.h"
 #include "bacnet/bacaddr.h"
 #include "bacnet/datalink/mstp.h"
@@ -39,7 +43,7 @@
 #include "bacnet/bits.h"
 /* OS Specific include */
 #include "bacport.h"
-#include "bacnet/basic/sys/ringbuf.h"
+#include "bacnet/basic/sys/prioq.h"
 
 /** @file linux/dlmstp.c  Provides Linux-specific DataLink functions for MS/TP.
  */
@@ -48,17 +52,46 @@
 #define BACNET_DATA_EXPECTING_REPLY_BIT 2
 #define BACNET_DATA_EXPECTING_REPLY(control) \
     ((control & (1 << BACNET_DATA_EXPECTING_REPLY_BIT)) > 0)
+/* network priority, bits 1..0 of the NPDU control octet */
+#define BACNET_NETWORK_PRIORITY(control) ((control) & 0x03)
 
 #define INCREMENT_AND_LIMIT_UINT16(x) \
     {                                 \
         if (x < 0xFFFF)               \
             x++;                      \
     }
+
+/* same defaults as the state machines in mstp.c */
+#ifndef Tframe_abort
+#define Tframe_abort 95
+#endif
+#ifndef Treply_delay
+#define Treply_delay 250
+#endif
+
+/* epoll_event data for the event loop: port index and event kind */
+#define DLMSTP_EVENT_SERIAL 0
+#define DLMSTP_EVENT_TIMER 1
+#define DLMSTP_EVENT_WAKEUP 2
+#define DLMSTP_EVENT_KIND_MASK 3
+#define DLMSTP_EVENT_PORT_SHIFT 2
+
+/* all of the MS/TP ports in the process are served by one thread */
+static struct mstp_port_struct_t *MSTP_Ports[DLMSTP_LINUX_PORTS_MAX];
+static unsigned MSTP_Port_Count;
+static int MSTP_Epoll_Handle = -1;
+static int MSTP_Wakeup_Handle = -1;
+static int MSTP_Receive_Handle = -1;
+static pthread_mutex_t MSTP_Port_Mutex = PTHREAD_MUTEX_INITIALIZER;
+static void dlmstp_event_loop_remove(struct mstp_port_struct_t *mstp_port);
+
 uint32_t Timer_Silence(void *poPort)
 {
-    struct timeval now, tmp_diff;
+    struct timespec now;
     SHARED_MSTP_DATA *poSharedData;
     struct mstp_port_struct_t *mstp_port = (struct mstp_port_struct_t *)poPort;
+    int64_t res;
+
     if (!mstp_port) {
         return -1;
     }
@@ -66,14 +99,19 @@ uint32_t Timer_Silence(void *poPort)
     if (!poSharedData) {
         return -1;
     }
+    /* the line is not silent while frames are waiting to be sent */
+    if (!FIFO_Empty(&poSharedData->Tx_FIFO)) {
+        return 0;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    res = ((int64_t)now.tv_sec - poSharedData->start.tv_sec) * 1000;
+    res += (now.tv_nsec - poSharedData->start.tv_nsec) / 1000000;
+    /* the start is in the future while a frame is still being sent */
+    if (res < 0) {
+        res = 0;
+    }
 
-    int32_t res;
-
-    gettimeofday(&now, NULL);
-    timersub(&poSharedData->start, &now, &tmp_diff);
-    res = ((tmp_diff.tv_sec) * 1000 + (tmp_diff.tv_usec) / 1000);
-
-    return (res >= 0 ? res : -res);
+    return (uint32_t)res;
 }
 
 void Timer_Silence_Reset(void *poPort)
@@ -88,7 +126,7 @@ void Timer_Silence_Reset(void *poPort)
         return;
     }
 
-    gettimeofday(&poSharedData->start, NULL);
+    clock_gettime(CLOCK_MONOTONIC, &poSharedData->start);
 }
 
 void get_abstime(struct timespec *abstime, unsigned long milliseconds)
@@ -115,15 +153,284 @@ void dlmstp_cleanup(void *poPort)
         return;
     }
 
+    dlmstp_event_loop_remove(mstp_port);
     /* restore the old port settings */
     tcsetattr(poSharedData->RS485_Handle, TCSANOW, &poSharedData->RS485_oldtio);
     close(poSharedData->RS485_Handle);
+    close(poSharedData->Timer_Handle);
 
     pthread_cond_destroy(&poSharedData->Received_Frame_Flag);
     sem_destroy(&poSharedData->Receive_Packet_Flag);
     pthread_cond_destroy(&poSharedData->Master_Done_Flag);
     pthread_mutex_destroy(&poSharedData->Received_Frame_Mutex);
     pthread_mutex_destroy(&poSharedData->Master_Done_Mutex);
+    pthread_mutex_destroy(&poSharedData->PDU_Queue_Mutex);
+}
+
+/**
+ * @brief Decode the reply matching key of a confirmed service request
+ * @param pdu - the NPDU received in a DATA_EXPECTING_REPLY frame
+ * @param pdu_len - number of octets in the NPDU
+ * @param src_address - MS/TP MAC address of the requesting station
+ * @param key - the decoded key
+ * @return true if the NPDU holds a confirmed service request
+ */
+static bool dlmstp_request_key_decode(
+    uint8_t *pdu, uint16_t pdu_len, uint8_t src_address, DLMSTP_REPLY_KEY *key)
+{
+    BACNET_NPDU_DATA npdu_data = { 0 };
+    int offset = 0;
+
+    memset(key, 0, sizeof(DLMSTP_REPLY_KEY));
+    key->mac = src_address;
+    key->address.mac[0] = src_address;
+    key->address.mac_len = 1;
+    offset = bacnet_npdu_decode(pdu, pdu_len, NULL, &key->address, &npdu_data);
+    if (offset <= 0) {
+        return false;
+    }
+    if (npdu_data.network_layer_message) {
+#if PRINT_ENABLED
+        fprintf(stderr,
+            "DLMSTP: DER Compare failed: "
+            "Request is Network message.\n");
+#endif
+        return false;
+    }
+    if ((offset + 4) > pdu_len) {
+        return false;
+    }
+    key->pdu_type = pdu[offset] & 0xF0;
+    if (key->pdu_type != PDU_TYPE_CONFIRMED_SERVICE_REQUEST) {
+#if PRINT_ENABLED
+        fprintf(stderr,
+            "DLMSTP: DER Compare failed: "
+            "Not Confirmed Request.\n");
+#endif
+        return false;
+    }
+    key->invoke_id = pdu[offset + 2];
+    /* segmented message? */
+    if (pdu[offset] & BIT(3)) {
+        if ((offset + 6) > pdu_len) {
+            return false;
+        }
+        key->service_choice = pdu[offset + 5];
+    } else {
+        key->service_choice = pdu[offset + 3];
+    }
+    key->protocol_version = npdu_data.protocol_version;
+
+    return true;
+}
+
+/**
+ * @brief Decode the reply matching key of a PDU queued for sending
+ * @param pdu - the NPDU to be sent
+ * @param pdu_len - number of octets in the NPDU
+ * @param dest_address - MS/TP MAC address of the destination station
+ * @param key - the decoded key
+ * @return true if the NPDU could be the reply to a confirmed request
+ */
+static bool dlmstp_reply_key_decode(
+    uint8_t *pdu, uint16_t pdu_len, uint8_t dest_address, DLMSTP_REPLY_KEY *key)
+{
+    BACNET_NPDU_DATA npdu_data = { 0 };
+    int offset = 0;
+    int apdu_len = 0;
+
+    memset(key, 0, sizeof(DLMSTP_REPLY_KEY));
+    key->mac = dest_address;
+    key->address.mac[0] = dest_address;
+    key->address.mac_len = 1;
+    offset = bacnet_npdu_decode(pdu, pdu_len, &key->address, NULL, &npdu_data);
+    if (offset <= 0) {
+        return false;
+    }
+    if (npdu_data.network_layer_message) {
+#if PRINT_ENABLED
+        fprintf(stderr,
+            "DLMSTP: DER Compare failed: "
+            "Reply is Network message.\n");
+#endif
+        return false;
+    }
+    if ((offset + 2) > pdu_len) {
+        return false;
+    }
+    /* reply could be a lot of things:
+       confirmed, simple ack, abort, reject, error */
+    key->pdu_type = pdu[offset] & 0xF0;
+    switch (key->pdu_type) {
+        case PDU_TYPE_SIMPLE_ACK:
+        case PDU_TYPE_ERROR:
+            apdu_len = 3;
+            break;
+        case PDU_TYPE_COMPLEX_ACK:
+            /* segmented message? */
+            if (pdu[offset] & BIT(3)) {
+                apdu_len = 5;
+            } else {
+                apdu_len = 3;
+            }
+            break;
+        case PDU_TYPE_REJECT:
+        case PDU_TYPE_ABORT:
+            /* these don't have service choice included */
+            apdu_len = 2;
+            break;
+        default:
+            return false;
+    }
+    if ((offset + apdu_len) > pdu_len) {
+        return false;
+    }
+    key->invoke_id = pdu[offset + 1];
+    if (apdu_len > 2) {
+        key->service_choice = pdu[offset + apdu_len - 1];
+    }
+    key->protocol_version = npdu_data.protocol_version;
+
+    return true;
+}
+
+/**
+ * @brief Compare the key of a received DER and a queued reply
+ * @param request - key of the confirmed request
+ * @param reply - key of the queued PDU
+ * @return true if the queued PDU is the reply to the request
+ */
+static bool dlmstp_reply_key_match(
+    DLMSTP_REPLY_KEY *request, DLMSTP_REPLY_KEY *reply)
+{
+    if ((request->mac != reply->mac) ||
+        (request->invoke_id != reply->invoke_id)) {
+#if PRINT_ENABLED
+        fprintf(stderr,
+            "DLMSTP: DER Compare failed: "
+            "Invoke ID mismatch.\n");
+#endif
+        return false;
+    }
+    if ((reply->pdu_type != PDU_TYPE_REJECT) &&
+        (reply->pdu_type != PDU_TYPE_ABORT) &&
+        (request->service_choice != reply->service_choice)) {
+#if PRINT_ENABLED
+        fprintf(stderr,
+            "DLMSTP: DER Compare failed: "
+            "Service choice mismatch.\n");
+#endif
+        return false;
+    }
+    if (request->protocol_version != reply->protocol_version) {
+#if PRINT_ENABLED
+        fprintf(stderr,
+            "DLMSTP: DER Compare failed: "
+            "NPDU Protocol Version mismatch.\n");
+#endif
+        return false;
+    }
+    /* the NDPU priority doesn't get passed through the stack, and
+       all outgoing messages have NORMAL priority */
+    if (!bacnet_address_same(&request->address, &reply->address)) {
+#if PRINT_ENABLED
+        fprintf(stderr,
+            "DLMSTP: DER Compare failed: "
+            "BACnet Address mismatch.\n");
+#endif
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * @brief Reply index bucket of a MAC address and invoke ID
+ */
+static unsigned dlmstp_reply_index_hash(uint8_t mac, uint8_t invoke_id)
+{
+    return (((unsigned)mac * 31U) + invoke_id) &
+        (MSTP_PDU_REPLY_INDEX_SIZE - 1);
+}
+
+/**
+ * @brief Link a queued PDU at the end of its reply index bucket
+ * @note the PDU_Queue_Mutex is held by the caller
+ */
+static void dlmstp_reply_index_add(
+    SHARED_MSTP_DATA *poSharedData, struct mstp_pdu_packet *pkt)
+{
+    uint16_t slot = (uint16_t)(pkt - &poSharedData->PDU_Buffer[0]);
+    uint16_t *next;
+
+    next = &poSharedData->Reply_Index[dlmstp_reply_index_hash(
+        pkt->reply_key.mac, pkt->reply_key.invoke_id)];
+    while (*next < MSTP_PDU_PACKET_COUNT) {
+        next = &poSharedData->PDU_Buffer[*next].reply_next;
+    }
+    pkt->reply_next = MSTP_PDU_PACKET_COUNT;
+    pkt->reply = true;
+    *next = slot;
+}
+
+/**
+ * @brief Unlink a queued PDU from its reply index bucket
+ * @note the PDU_Queue_Mutex is held by the caller
+ */
+static void dlmstp_reply_index_remove(
+    SHARED_MSTP_DATA *poSharedData, struct mstp_pdu_packet *pkt)
+{
+    uint16_t slot = (uint16_t)(pkt - &poSharedData->PDU_Buffer[0]);
+    uint16_t *next;
+
+    if (!pkt->reply) {
+        return;
+    }
+    next = &poSharedData->Reply_Index[dlmstp_reply_index_hash(
+        pkt->reply_key.mac, pkt->reply_key.invoke_id)];
+    while (*next < MSTP_PDU_PACKET_COUNT) {
+        if (*next == slot) {
+            *next = pkt->reply_next;
+            break;
+        }
+        next = &poSharedData->PDU_Buffer[*next].reply_next;
+    }
+    pkt->reply = false;
+}
+
+/**
+ * @brief Find the oldest queued PDU that is the reply to a request
+ * @note the PDU_Queue_Mutex is held by the caller
+ */
+static struct mstp_pdu_packet *dlmstp_reply_index_find(
+    SHARED_MSTP_DATA *poSharedData, DLMSTP_REPLY_KEY *request)
+{
+    struct mstp_pdu_packet *pkt;
+    uint16_t slot;
+
+    slot = poSharedData->Reply_Index[dlmstp_reply_index_hash(
+        request->mac, request->invoke_id)];
+    while (slot < MSTP_PDU_PACKET_COUNT) {
+        pkt = &poSharedData->PDU_Buffer[slot];
+        if (dlmstp_reply_key_match(request, &pkt->reply_key)) {
+            return pkt;
+        }
+        slot = pkt->reply_next;
+    }
+
+    return NULL;
+}
+
+/**
+ * @brief Milliseconds timestamp for the transmit queue
+ */
+static uint32_t dlmstp_queue_clock(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (uint32_t)((now.tv_sec * 1000) + (now.tv_nsec / 1000000));
 }
 
 /* returns number of bytes sent on success, zero on failure */
@@ -134,7 +441,9 @@ int dlmstp_send_pdu(void *poPort,
 { /* number of bytes of data */
     int bytes_sent = 0;
     struct mstp_pdu_packet *pkt;
-    unsigned i = 0;
+    uint8_t priority = MESSAGE_PRIORITY_NORMAL;
+    bool evicted = false;
+    int slot;
     SHARED_MSTP_DATA *poSharedData;
     struct mstp_port_struct_t *mstp_port = (struct mstp_port_struct_t *)poPort;
     if (!mstp_port) {
@@ -145,18 +454,42 @@ int dlmstp_send_pdu(void *poPort,
         return 0;
     }
 
-    pkt = (struct mstp_pdu_packet *)Ringbuf_Data_Peek(&poSharedData->PDU_Queue);
-    if (pkt) {
+    if (pdu_len > sizeof(pkt->buffer)) {
+        return 0;
+    }
+    if (pdu_len > BACNET_PDU_CONTROL_BYTE_OFFSET) {
+        priority =
+            BACNET_NETWORK_PRIORITY(pdu[BACNET_PDU_CONTROL_BYTE_OFFSET]);
+    }
+    pthread_mutex_lock(&poSharedData->PDU_Queue_Mutex);
+    /* a full queue makes room by evicting the newest PDU
+       of a lower network priority */
+    slot = Prioq_Reserve(&poSharedData->PDU_Queue, priority, &evicted);
+    if (slot >= 0) {
+        pkt = &poSharedData->PDU_Buffer[slot];
+        if (evicted) {
+            dlmstp_reply_index_remove(poSharedData, pkt);
+        }
         pkt->data_expecting_reply =
             BACNET_DATA_EXPECTING_REPLY(pdu[BACNET_PDU_CONTROL_BYTE_OFFSET]);
-        for (i = 0; i < pdu_len; i++) {
-            pkt->buffer[i] = pdu[i];
-        }
+        memcpy(pkt->buffer, pdu, pdu_len);
         pkt->length = pdu_len;
         pkt->destination_mac = dest->mac[0];
-        if (Ringbuf_Data_Put(&poSharedData->PDU_Queue, (uint8_t *)pkt)) {
-            bytes_sent = pdu_len;
+        pkt->reply = false;
+        Prioq_Put(&poSharedData->PDU_Queue, (unsigned)slot, priority,
+            dlmstp_queue_clock());
+        /* tag the PDU once here so that the reply to a DER
+           is found without decoding the queue */
+        if (!pkt->data_expecting_reply &&
+            dlmstp_reply_key_decode(pkt->buffer, pkt->length,
+                pkt->destination_mac, &pkt->reply_key)) {
+            dlmstp_reply_index_add(poSharedData, pkt);
         }
+        bytes_sent = pdu_len;
+    }
+    pthread_mutex_unlock(&poSharedData->PDU_Queue_Mutex);
+    if (bytes_sent) {
+        dlmstp_event_loop_wakeup();
     }
 
     return bytes_sent;
@@ -180,24 +513,23 @@ uint16_t dlmstp_receive(void *poPort,
     if (!poSharedData) {
         return 0;
     }
-    (void)max_pdu;
     /* see if there is a packet available, and a place
        to put the reply (if necessary) and process it */
     get_abstime(&abstime, timeout);
     rv = sem_timedwait(&poSharedData->Receive_Packet_Flag, &abstime);
     if (rv == 0) {
         if (poSharedData->Receive_Packet.ready) {
-            if (poSharedData->Receive_Packet.pdu_len) {
+            if (poSharedData->Receive_Packet.pdu_len &&
+                (poSharedData->Receive_Packet.pdu_len <= max_pdu)) {
                 poSharedData->MSTP_Packets++;
                 if (src) {
                     memmove(src, &poSharedData->Receive_Packet.address,
                         sizeof(poSharedData->Receive_Packet.address));
                 }
+                pdu_len = poSharedData->Receive_Packet.pdu_len;
                 if (pdu) {
-                    memmove(pdu, &poSharedData->Receive_Packet.pdu,
-                        sizeof(poSharedData->Receive_Packet.pdu));
+                    memmove(pdu, &poSharedData->Receive_Packet.pdu, pdu_len);
                 }
-                pdu_len = poSharedData->Receive_Packet.pdu_len;
             }
             poSharedData->Receive_Packet.ready = false;
         }
@@ -225,68 +557,129 @@ void *dlmstp_receive_fsm_task(void *pArg)
         /* only do receive state machine while we don't have a frame */
         if ((mstp_port->ReceivedValidFrame == false) &&
             (mstp_port->ReceivedInvalidFrame == false)) {
-            do {
-                RS485_Check_UART_Data(mstp_port);
-                MSTP_Receive_Frame_FSM(
-                    (volatile struct mstp_port_struct_t *)pArg);
-                received_frame = mstp_port->ReceivedValidFrame ||
-                    mstp_port->ReceivedInvalidFrame;
-                if (received_frame) {
-                    pthread_cond_signal(&poSharedData->Received_Frame_Flag);
-                    break;
-                }
-            } while (mstp_port->DataAvailable);
+            RS485_Check_UART_Buffer(mstp_port);
+            received_frame = mstp_port->ReceivedValidFrame ||
+                mstp_port->ReceivedInvalidFrame;
+            if (received_frame) {
+                pthread_cond_signal(&poSharedData->Received_Frame_Flag);
+            }
         }
     }
 
     return NULL;
 }
 
-void *dlmstp_master_fsm_task(void *pArg)
+/**
+ * @brief Determine how long the state machines of a port can wait for
+ *  line activity before one of their timeouts has to be evaluated
+ * @param mstp_port - port specific data
+ * @return milliseconds until the next deadline, or zero to run now
+ */
+static uint32_t dlmstp_port_timeout(struct mstp_port_struct_t *mstp_port)
 {
+    SHARED_MSTP_DATA *poSharedData = (SHARED_MSTP_DATA *)mstp_port->UserData;
     uint32_t silence = 0;
-    bool run_master = false;
-    SHARED_MSTP_DATA *poSharedData;
-    struct mstp_port_struct_t *mstp_port = (struct mstp_port_struct_t *)pArg;
-    if (!mstp_port) {
-        return NULL;
-    }
+    uint32_t deadline = 0;
 
-    poSharedData =
-        (SHARED_MSTP_DATA *)((struct mstp_port_struct_t *)pArg)->UserData;
-    if (!poSharedData) {
-        return NULL;
+    switch (mstp_port->master_state) {
+        case MSTP_MASTER_STATE_IDLE:
+            deadline = Tno_token;
+            break;
+        case MSTP_MASTER_STATE_WAIT_FOR_REPLY:
+            deadline = poSharedData->Treply_timeout;
+            break;
+        case MSTP_MASTER_STATE_PASS_TOKEN:
+        case MSTP_MASTER_STATE_POLL_FOR_MASTER:
+            deadline = poSharedData->Tusage_timeout + 1;
+            break;
+        case MSTP_MASTER_STATE_NO_TOKEN:
+            deadline = Tno_token + (Tslot * mstp_port->This_Station);
+            break;
+        case MSTP_MASTER_STATE_ANSWER_DATA_REQUEST:
+            /* or sooner, when the reply is queued */
+            deadline = Treply_delay + 1;
+            break;
+        default:
+            return 0;
+    }
+    if ((mstp_port->receive_state != MSTP_RECEIVE_STATE_IDLE) &&
+        (deadline > (Tframe_abort + 1))) {
+        deadline = Tframe_abort + 1;
+    }
+    silence = mstp_port->SilenceTimer(mstp_port);
+    if (silence >= deadline) {
+        return 0;
     }
 
-    for (;;) {
-        if (mstp_port->ReceivedValidFrame == false &&
-            mstp_port->ReceivedInvalidFrame == false) {
-            RS485_Check_UART_Data(mstp_port);
-            MSTP_Receive_Frame_FSM(mstp_port);
+    return deadline - silence;
+}
+
+/**
+ * @brief Write the frames that the state machines of a port have queued,
+ *  without blocking the other ports: the port timer waits out the
+ *  turnaround time, and EPOLLOUT waits for a full serial port to drain.
+ * @param mstp_port - port specific data
+ * @return nanoseconds until the turnaround time has passed, or zero
+ */
+static uint64_t dlmstp_port_transmit(struct mstp_port_struct_t *mstp_port)
+{
+    SHARED_MSTP_DATA *poSharedData = (SHARED_MSTP_DATA *)mstp_port->UserData;
+    struct epoll_event event = { 0 };
+    struct timespec now;
+    int64_t delay = 0;
+    bool output = false;
+
+    if (!FIFO_Empty(&poSharedData->Tx_FIFO)) {
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        delay = ((int64_t)poSharedData->Tx_Due.tv_sec - now.tv_sec) *
+            1000000000LL;
+        delay += poSharedData->Tx_Due.tv_nsec - now.tv_nsec;
+        if (delay > 0) {
+            return (uint64_t)delay;
         }
-        if (mstp_port->ReceivedValidFrame || mstp_port->ReceivedInvalidFrame) {
-            run_master = true;
+        output = !RS485_Write_UART_Buffer(mstp_port);
+    }
+    if (output != poSharedData->Serial_Event_Output) {
+        event.events = EPOLLIN;
+        if (output) {
+            event.events |= EPOLLOUT;
+        }
+        event.data.u64 = poSharedData->Serial_Event;
+        if (epoll_ctl(MSTP_Epoll_Handle, EPOLL_CTL_MOD,
+                poSharedData->RS485_Handle, &event) == 0) {
+            poSharedData->Serial_Event_Output = output;
         } else {
-            silence = mstp_port->SilenceTimer(NULL);
-            switch (mstp_port->master_state) {
-                case MSTP_MASTER_STATE_IDLE:
-                    if (silence >= Tno_token)
-                        run_master = true;
-                    break;
-                case MSTP_MASTER_STATE_WAIT_FOR_REPLY:
-                    if (silence >= poSharedData->Treply_timeout)
-                        run_master = true;
-                    break;
-                case MSTP_MASTER_STATE_POLL_FOR_MASTER:
-                    if (silence >= poSharedData->Tusage_timeout)
-                        run_master = true;
-                    break;
-                default:
-                    run_master = true;
-                    break;
-            }
+            fprintf(stderr, "MS/TP: cannot wait for the serial port: %s\n",
+                strerror(errno));
         }
-        if (run_master) {
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Run the receive and node state machines of one port on whatever
+ *  octets have arrived, write what they queued to send, then arm its
+ *  timer for the next deadline
+ * @param mstp_port - port specific data
+ */
+static void dlmstp_port_service(struct mstp_port_struct_t *mstp_port)
+{
+    SHARED_MSTP_DATA *poSharedData = (SHARED_MSTP_DATA *)mstp_port->UserData;
+    struct itimerspec timer = { 0 };
+    bool received_frame = false;
+    uint32_t timeout = 0;
+    uint64_t timeout_ns = 0;
+    uint64_t turnaround_ns = 0;
+
+    do {
+        if ((mstp_port->ReceivedValidFrame == false) &&
+            (mstp_port->ReceivedInvalidFrame == false)) {
+            RS485_Read_UART_Buffer(mstp_port);
+        }
+        received_frame =
+            mstp_port->ReceivedValidFrame || mstp_port->ReceivedInvalidFrame;
+        if (received_frame || (dlmstp_port_timeout(mstp_port) == 0)) {
             if (mstp_port->This_Station <= DEFAULT_MAX_MASTER) {
                 while (MSTP_Master_Node_FSM(mstp_port)) {
                     /* do nothing while immediate transitioning */
@@ -295,11 +688,237 @@ void *dlmstp_master_fsm_task(void *pArg)
                 MSTP_Slave_Node_FSM(mstp_port);
             }
         }
+        /* octets after the end of a frame are still in the FIFO */
+    } while (received_frame && !FIFO_Empty(&poSharedData->Rx_FIFO));
+    turnaround_ns = dlmstp_port_transmit(mstp_port);
+    timeout = dlmstp_port_timeout(mstp_port);
+    if (timeout == 0) {
+        /* a state that is not waiting on a timeout: check again soon */
+        timeout = 1;
+    }
+    timeout_ns = (uint64_t)timeout * 1000000ULL;
+    if (turnaround_ns && (turnaround_ns < timeout_ns)) {
+        timeout_ns = turnaround_ns;
+    }
+    timer.it_value.tv_sec = timeout_ns / 1000000000ULL;
+    timer.it_value.tv_nsec = timeout_ns % 1000000000ULL;
+    timerfd_settime(poSharedData->Timer_Handle, 0, &timer, NULL);
+}
+
+/**
+ * @brief One thread for every MS/TP port in the process. It sleeps in
+ *  epoll_wait() until a port has received octets or can take more
+ *  octets to send, a port timer for Tframe_abort, Tno_token,
+ *  Treply_timeout, the turnaround time, etc. has expired, or a PDU
+ *  has been queued for sending.
+ * @param pArg - not used
+ * @return NULL
+ */
+static void *dlmstp_event_loop_task(void *pArg)
+{
+    struct epoll_event events[(DLMSTP_LINUX_PORTS_MAX * 2) + 1];
+    struct mstp_port_struct_t *mstp_port = NULL;
+    uint64_t value = 0;
+    unsigned index = 0;
+    int count = 0;
+    int i = 0;
+
+    (void)pArg;
+    for (;;) {
+        count = epoll_wait(MSTP_Epoll_Handle, events,
+            sizeof(events) / sizeof(events[0]), -1);
+        pthread_mutex_lock(&MSTP_Port_Mutex);
+        for (i = 0; i < count; i++) {
+            index = events[i].data.u64 >> DLMSTP_EVENT_PORT_SHIFT;
+            switch (events[i].data.u64 & DLMSTP_EVENT_KIND_MASK) {
+                case DLMSTP_EVENT_WAKEUP:
+                    /* a PDU was queued: let every port look for it */
+                    if (read(MSTP_Wakeup_Handle, &value, sizeof(value)) > 0) {
+                        for (index = 0; index < MSTP_Port_Count; index++) {
+                            if (MSTP_Ports[index]) {
+                                dlmstp_port_service(MSTP_Ports[index]);
+                            }
+                        }
+                    }
+                    break;
+                case DLMSTP_EVENT_TIMER:
+                    mstp_port = MSTP_Ports[index];
+                    if (mstp_port) {
+                        (void)read(((SHARED_MSTP_DATA *)mstp_port->UserData)
+                                       ->Timer_Handle,
+                            &value, sizeof(value));
+                        dlmstp_port_service(mstp_port);
+                    }
+                    break;
+                case DLMSTP_EVENT_SERIAL:
+                default:
+                    if (MSTP_Ports[index]) {
+                        dlmstp_port_service(MSTP_Ports[index]);
+                    }
+                    break;
+            }
+        }
+        pthread_mutex_unlock(&MSTP_Port_Mutex);
     }
 
     return NULL;
 }
 
+/**
+ * @brief Wake the event loop thread, e.g. when a PDU has been queued
+ */
+void dlmstp_event_loop_wakeup(void)
+{
+    uint64_t value = 1;
+
+    if (MSTP_Wakeup_Handle >= 0) {
+        (void)write(MSTP_Wakeup_Handle, &value, sizeof(value));
+    }
+}
+
+/**
+ * @brief Get the event that is signalled each time any port served by
+ *  the event loop has a received PDU ready for dlmstp_receive(). This
+ *  lets one thread wait for many ports with poll() or epoll_wait()
+ *  instead of blocking in dlmstp_receive() on each port in turn.
+ * @return eventfd handle, or -1 until the first port is initialized
+ */
+int dlmstp_receive_event(void)
+{
+    return MSTP_Receive_Handle;
+}
+
+/**
+ * @brief Add an initialized port to the event loop, starting the
+ *  event loop thread for the first port
+ * @param mstp_port - port specific data
+ * @return true if the port was added
+ */
+static bool dlmstp_event_loop_add(struct mstp_port_struct_t *mstp_port)
+{
+    SHARED_MSTP_DATA *poSharedData = (SHARED_MSTP_DATA *)mstp_port->UserData;
+    struct epoll_event event = { 0 };
+    pthread_t hThread;
+    bool status = false;
+    uint64_t index = 0;
+
+    pthread_mutex_lock(&MSTP_Port_Mutex);
+    if (MSTP_Epoll_Handle < 0) {
+        MSTP_Epoll_Handle = epoll_create1(EPOLL_CLOEXEC);
+        MSTP_Wakeup_Handle = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        MSTP_Receive_Handle = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if ((MSTP_Epoll_Handle < 0) || (MSTP_Wakeup_Handle < 0) ||
+            (MSTP_Receive_Handle < 0)) {
+            fprintf(stderr, "MS/TP: cannot create the event loop\n");
+            goto exit_loop;
+        }
+        event.events = EPOLLIN;
+        event.data.u64 = DLMSTP_EVENT_WAKEUP;
+        if (epoll_ctl(
+                MSTP_Epoll_Handle, EPOLL_CTL_ADD, MSTP_Wakeup_Handle,
+                &event) != 0) {
+            fprintf(
+                stderr, "MS/TP: cannot add the wakeup event: %s\n",
+                strerror(errno));
+            goto exit_loop;
+        }
+        if (pthread_create(&hThread, NULL, dlmstp_event_loop_task, NULL) !=
+            0) {
+            fprintf(stderr, "Failed to start Master Node FSM task\n");
+            goto exit_loop;
+        }
+        pthread_detach(hThread);
+    }
+    if (MSTP_Port_Count >= DLMSTP_LINUX_PORTS_MAX) {
+        fprintf(stderr, "MS/TP: too many ports for the event loop\n");
+        goto exit;
+    }
+    poSharedData->Timer_Handle =
+        timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (poSharedData->Timer_Handle < 0) {
+        goto exit;
+    }
+    index = MSTP_Port_Count;
+    event.events = EPOLLIN;
+    event.data.u64 = (index << DLMSTP_EVENT_PORT_SHIFT) | DLMSTP_EVENT_SERIAL;
+    poSharedData->Serial_Event = event.data.u64;
+    poSharedData->Serial_Event_Output = false;
+    if (epoll_ctl(
+            MSTP_Epoll_Handle, EPOLL_CTL_ADD, poSharedData->RS485_Handle,
+            &event) != 0) {
+        fprintf(
+            stderr, "MS/TP: cannot add the serial port: %s\n",
+            strerror(errno));
+        goto exit_timer;
+    }
+    event.data.u64 = (index << DLMSTP_EVENT_PORT_SHIFT) | DLMSTP_EVENT_TIMER;
+    if (epoll_ctl(
+            MSTP_Epoll_Handle, EPOLL_CTL_ADD, poSharedData->Timer_Handle,
+            &event) != 0) {
+        fprintf(
+            stderr, "MS/TP: cannot add the port timer: %s\n",
+            strerror(errno));
+        epoll_ctl(
+            MSTP_Epoll_Handle, EPOLL_CTL_DEL, poSharedData->RS485_Handle,
+            NULL);
+        goto exit_timer;
+    }
+    MSTP_Ports[index] = mstp_port;
+    MSTP_Port_Count++;
+    /* evaluate the initial state and arm the port timer */
+    dlmstp_port_service(mstp_port);
+    status = true;
+    goto exit;
+
+exit_timer:
+    close(poSharedData->Timer_Handle);
+    poSharedData->Timer_Handle = -1;
+    goto exit;
+
+exit_loop:
+    /* release the partly created event loop so that a later port can
+       try again */
+    if (MSTP_Epoll_Handle >= 0) {
+        close(MSTP_Epoll_Handle);
+        MSTP_Epoll_Handle = -1;
+    }
+    if (MSTP_Wakeup_Handle >= 0) {
+        close(MSTP_Wakeup_Handle);
+        MSTP_Wakeup_Handle = -1;
+    }
+    if (MSTP_Receive_Handle >= 0) {
+        close(MSTP_Receive_Handle);
+        MSTP_Receive_Handle = -1;
+    }
+
+exit:
+    pthread_mutex_unlock(&MSTP_Port_Mutex);
+
+    return status;
+}
+
+/**
+ * @brief Stop serving a port from the event loop
+ * @param mstp_port - port specific data
+ */
+static void dlmstp_event_loop_remove(struct mstp_port_struct_t *mstp_port)
+{
+    SHARED_MSTP_DATA *poSharedData = (SHARED_MSTP_DATA *)mstp_port->UserData;
+    unsigned index = 0;
+
+    pthread_mutex_lock(&MSTP_Port_Mutex);
+    for (index = 0; index < MSTP_Port_Count; index++) {
+        if (MSTP_Ports[index] == mstp_port) {
+            epoll_ctl(MSTP_Epoll_Handle, EPOLL_CTL_DEL,
+                poSharedData->RS485_Handle, NULL);
+            epoll_ctl(MSTP_Epoll_Handle, EPOLL_CTL_DEL,
+                poSharedData->Timer_Handle, NULL);
+            MSTP_Ports[index] = NULL;
+        }
+    }
+    pthread_mutex_unlock(&MSTP_Port_Mutex);
+}
+
 void dlmstp_fill_bacnet_address(BACNET_ADDRESS *src, uint8_t mstp_address)
 {
     int i = 0;
@@ -345,6 +964,10 @@ uint16_t MSTP_Put_Receive(volatile struct mstp_port_struct_t *mstp_port)
         poSharedData->Receive_Packet.pdu_len = mstp_port->DataLength;
         poSharedData->Receive_Packet.ready = true;
         sem_post(&poSharedData->Receive_Packet_Flag);
+        if (MSTP_Receive_Handle >= 0) {
+            uint64_t value = 1;
+            (void)write(MSTP_Receive_Handle, &value, sizeof(value));
+        }
     }
 
     return pdu_len;
@@ -358,6 +981,8 @@ uint16_t MSTP_Get_Send(
     uint16_t pdu_len = 0;
     uint8_t frame_type = 0;
     struct mstp_pdu_packet *pkt;
+    uint32_t now;
+    int slot;
     SHARED_MSTP_DATA *poSharedData = (SHARED_MSTP_DATA *)mstp_port->UserData;
 
     if (!poSharedData) {
@@ -365,10 +990,19 @@ uint16_t MSTP_Get_Send(
     }
 
     (void)timeout;
-    if (Ringbuf_Empty(&poSharedData->PDU_Queue)) {
+    /* while the serial port is backed up, the PDU stay queued
+       by priority rather than overflow the transmit FIFO */
+    if (!FIFO_Available(&poSharedData->Tx_FIFO, mstp_port->OutputBufferSize)) {
         return 0;
     }
-    pkt = (struct mstp_pdu_packet *)Ringbuf_Peek(&poSharedData->PDU_Queue);
+    pthread_mutex_lock(&poSharedData->PDU_Queue_Mutex);
+    now = dlmstp_queue_clock();
+    slot = Prioq_Peek(&poSharedData->PDU_Queue, now);
+    if (slot < 0) {
+        pthread_mutex_unlock(&poSharedData->PDU_Queue_Mutex);
+        return 0;
+    }
+    pkt = &poSharedData->PDU_Buffer[slot];
     if (pkt->data_expecting_reply) {
         frame_type = FRAME_TYPE_BACNET_DATA_EXPECTING_REPLY;
     } else {
@@ -379,7 +1013,9 @@ uint16_t MSTP_Get_Send(
         MSTP_Create_Frame(&mstp_port->OutputBuffer[0], /* <-- loading this */
             mstp_port->OutputBufferSize, frame_type, pkt->destination_mac,
             mstp_port->This_Station, (uint8_t *)&pkt->buffer[0], pkt->length);
-    (void)Ringbuf_Pop(&poSharedData->PDU_Queue, NULL);
+    dlmstp_reply_index_remove(poSharedData, pkt);
+    Prioq_Remove(&poSharedData->PDU_Queue, (unsigned)slot, now);
+    pthread_mutex_unlock(&poSharedData->PDU_Queue_Mutex);
 
     return pdu_len;
 }
@@ -391,151 +1027,19 @@ bool dlmstp_compare_data_expecting_reply(uint8_t *request_pdu,
     uint16_t reply_pdu_len,
     uint8_t dest_address)
 {
-    uint16_t offset;
-    /* One way to check the message is to compare NPDU
-       src, dest, along with the APDU type, invoke id.
-       Seems a bit overkill */
-    struct DER_compare_t {
-        BACNET_NPDU_DATA npdu_data;
-        BACNET_ADDRESS address;
-        uint8_t pdu_type;
-        uint8_t invoke_id;
-        uint8_t service_choice;
-    };
-    struct DER_compare_t request;
-    struct DER_compare_t reply;
-
-    /* unused parameters */
-    request_pdu_len = request_pdu_len;
-    reply_pdu_len = reply_pdu_len;
-    /* decode the request data */
-    request.address.mac[0] = src_address;
-    request.address.mac_len = 1;
-    offset = npdu_decode(
-        &request_pdu[0], NULL, &request.address, &request.npdu_data);
-    if (request.npdu_data.network_layer_message) {
-#if PRINT_ENABLED
-        fprintf(stderr,
-            "DLMSTP: DER Compare failed: "
-            "Request is Network message.\n");
-#endif
-        return false;
-    }
-    request.pdu_type = request_pdu[offset] & 0xF0;
-    if (request.pdu_type != PDU_TYPE_CONFIRMED_SERVICE_REQUEST) {
-#if PRINT_ENABLED
-        fprintf(stderr,
-            "DLMSTP: DER Compare failed: "
-            "Not Confirmed Request.\n");
-#endif
-        return false;
-    }
-    request.invoke_id = request_pdu[offset + 2];
-    /* segmented message? */
-    if (request_pdu[offset] & BIT(3)) {
-        request.service_choice = request_pdu[offset + 5];
-    } else {
-        request.service_choice = request_pdu[offset + 3];
-    }
-    /* decode the reply data */
-    reply.address.mac[0] = dest_address;
-    reply.address.mac_len = 1;
-    offset = npdu_decode(&reply_pdu[0], &reply.address, NULL, &reply.npdu_data);
-    if (reply.npdu_data.network_layer_message) {
-#if PRINT_ENABLED
-        fprintf(stderr,
-            "DLMSTP: DER Compare failed: "
-            "Reply is Network message.\n");
-#endif
-        return false;
-    }
-    /* reply could be a lot of things:
-       confirmed, simple ack, abort, reject, error */
-    reply.pdu_type = reply_pdu[offset] & 0xF0;
-    switch (reply.pdu_type) {
-        case PDU_TYPE_SIMPLE_ACK:
-            reply.invoke_id = reply_pdu[offset + 1];
-            reply.service_choice = reply_pdu[offset + 2];
-            break;
-        case PDU_TYPE_COMPLEX_ACK:
-            reply.invoke_id = reply_pdu[offset + 1];
-            /* segmented message? */
-            if (reply_pdu[offset] & BIT(3)) {
-                reply.service_choice = reply_pdu[offset + 4];
-            } else {
-                reply.service_choice = reply_pdu[offset + 2];
-            }
-            break;
-        case PDU_TYPE_ERROR:
-            reply.invoke_id = reply_pdu[offset + 1];
-            reply.service_choice = reply_pdu[offset + 2];
-            break;
-        case PDU_TYPE_REJECT:
-        case PDU_TYPE_ABORT:
-            reply.invoke_id = reply_pdu[offset + 1];
-            break;
-        default:
-            return false;
-    }
-    /* these don't have service choice included */
-    if ((reply.pdu_type == PDU_TYPE_REJECT) ||
-        (reply.pdu_type == PDU_TYPE_ABORT)) {
-        if (request.invoke_id != reply.invoke_id) {
-#if PRINT_ENABLED
-            fprintf(stderr,
-                "DLMSTP: DER Compare failed: "
-                "Invoke ID mismatch.\n");
-#endif
-            return false;
-        }
-    } else {
-        if (request.invoke_id != reply.invoke_id) {
-#if PRINT_ENABLED
-            fprintf(stderr,
-                "DLMSTP: DER Compare failed: "
-                "Invoke ID mismatch.\n");
-#endif
-            return false;
-        }
-        if (request.service_choice != reply.service_choice) {
-#if PRINT_ENABLED
-            fprintf(stderr,
-                "DLMSTP: DER Compare failed: "
-                "Service choice mismatch.\n");
-#endif
-            return false;
-        }
-    }
-    if (request.npdu_data.protocol_version !=
-        reply.npdu_data.protocol_version) {
-#if PRINT_ENABLED
-        fprintf(stderr,
-            "DLMSTP: DER Compare failed: "
-            "NPDU Protocol Version mismatch.\n");
-#endif
-        return false;
-    }
-#if 0
-    /* the NDPU priority doesn't get passed through the stack, and
-       all outgoing messages have NORMAL priority */
-    if (request.npdu_data.priority != reply.npdu_data.priority) {
-#if PRINT_ENABLED
-        fprintf(stderr,
-            "DLMSTP: DER Compare failed: " "NPDU Priority mismatch.\n");
-#endif
+    DLMSTP_REPLY_KEY request;
+    DLMSTP_REPLY_KEY reply;
+
+    if (!dlmstp_request_key_decode(
+            request_pdu, request_pdu_len, src_address, &request)) {
         return false;
     }
-#endif
-    if (!bacnet_address_same(&request.address, &reply.address)) {
-#if PRINT_ENABLED
-        fprintf(stderr,
-            "DLMSTP: DER Compare failed: "
-            "BACnet Address mismatch.\n");
-#endif
+    if (!dlmstp_reply_key_decode(
+            reply_pdu, reply_pdu_len, dest_address, &reply)) {
         return false;
     }
 
-    return true;
+    return dlmstp_reply_key_match(&request, &reply);
 }
 
 /* Get the reply to a DATA_EXPECTING_REPLY frame, or nothing */
@@ -543,37 +1047,29 @@ uint16_t MSTP_Get_Reply(
     volatile struct mstp_port_struct_t *mstp_port, unsigned timeout)
 { /* milliseconds to wait for a packet */
     uint16_t pdu_len = 0; /* return value */
-    bool matched = false;
     uint8_t frame_type = 0;
-    struct mstp_pdu_packet *pkt;
+    struct mstp_pdu_packet *pkt = NULL;
+    DLMSTP_REPLY_KEY request;
     SHARED_MSTP_DATA *poSharedData = (SHARED_MSTP_DATA *)mstp_port->UserData;
 
     if (!poSharedData) {
         return 0;
     }
 
-    if (Ringbuf_Empty(&poSharedData->PDU_Queue)) {
+    (void)timeout;
+    if (!FIFO_Available(&poSharedData->Tx_FIFO, mstp_port->OutputBufferSize)) {
         return 0;
     }
-    pkt = (struct mstp_pdu_packet *)Ringbuf_Peek(&poSharedData->PDU_Queue);
-    /* is this the reply to the DER? */
-    matched = dlmstp_compare_data_expecting_reply(&mstp_port->InputBuffer[0],
-        mstp_port->DataLength, mstp_port->SourceAddress,
-        (uint8_t *)&pkt->buffer[0], pkt->length, pkt->destination_mac);
-    if (!matched) {
-        /* Walk the rest of the ring buffer to see if we can find a match */
-        while (!matched &&
-            (pkt = (struct mstp_pdu_packet *)Ringbuf_Peek_Next(
-                 &poSharedData->PDU_Queue, (uint8_t *)pkt)) != NULL) {
-            matched = dlmstp_compare_data_expecting_reply(
-                &mstp_port->InputBuffer[0], mstp_port->DataLength,
-                mstp_port->SourceAddress, (uint8_t *)&pkt->buffer[0],
-                pkt->length, pkt->destination_mac);
-        }
-        if (!matched) {
-            /* Still didn't find a match so just bail out */
-            return 0;
-        }
+    /* decode the DER once, then probe the index of queued replies */
+    if (!dlmstp_request_key_decode(&mstp_port->InputBuffer[0],
+            mstp_port->DataLength, mstp_port->SourceAddress, &request)) {
+        return 0;
+    }
+    pthread_mutex_lock(&poSharedData->PDU_Queue_Mutex);
+    pkt = dlmstp_reply_index_find(poSharedData, &request);
+    if (!pkt) {
+        pthread_mutex_unlock(&poSharedData->PDU_Queue_Mutex);
+        return 0;
     }
     if (pkt->data_expecting_reply) {
         frame_type = FRAME_TYPE_BACNET_DATA_EXPECTING_REPLY;
@@ -585,8 +1081,11 @@ uint16_t MSTP_Get_Reply(
         MSTP_Create_Frame(&mstp_port->OutputBuffer[0], /* <-- loading this */
             mstp_port->OutputBufferSize, frame_type, pkt->destination_mac,
             mstp_port->This_Station, (uint8_t *)&pkt->buffer[0], pkt->length);
-    /* This will pop the element no matter where we found it */
-    (void)Ringbuf_Pop_Element(&poSharedData->PDU_Queue, (uint8_t *)pkt, NULL);
+    /* the reply leaves the queue ahead of its turn */
+    dlmstp_reply_index_remove(poSharedData, pkt);
+    Prioq_Remove(&poSharedData->PDU_Queue,
+        (unsigned)(pkt - &poSharedData->PDU_Buffer[0]), dlmstp_queue_clock());
+    pthread_mutex_unlock(&poSharedData->PDU_Queue_Mutex);
 
     return pdu_len;
 }
@@ -838,10 +1337,50 @@ void dlmstp_get_broadcast_address(BACNET_ADDRESS *dest)
     return;
 }
 
+/* Copy the transmit queue counters of each network priority */
+bool dlmstp_fill_queue_statistics(void *poPort, PRIOQ_STATS *stats)
+{
+    SHARED_MSTP_DATA *poSharedData;
+    struct mstp_port_struct_t *mstp_port = (struct mstp_port_struct_t *)poPort;
+    unsigned i;
+
+    if (!mstp_port || !stats) {
+        return false;
+    }
+    poSharedData = (SHARED_MSTP_DATA *)mstp_port->UserData;
+    if (!poSharedData) {
+        return false;
+    }
+    pthread_mutex_lock(&poSharedData->PDU_Queue_Mutex);
+    for (i = 0; i < PRIOQ_CLASSES; i++) {
+        stats[i] = *Prioq_Stats(&poSharedData->PDU_Queue, (uint8_t)i);
+    }
+    pthread_mutex_unlock(&poSharedData->PDU_Queue_Mutex);
+
+    return true;
+}
+
+void dlmstp_reset_queue_statistics(void *poPort)
+{
+    SHARED_MSTP_DATA *poSharedData;
+    struct mstp_port_struct_t *mstp_port = (struct mstp_port_struct_t *)poPort;
+
+    if (!mstp_port) {
+        return;
+    }
+    poSharedData = (SHARED_MSTP_DATA *)mstp_port->UserData;
+    if (!poSharedData) {
+        return;
+    }
+    pthread_mutex_lock(&poSharedData->PDU_Queue_Mutex);
+    Prioq_Stats_Reset(&poSharedData->PDU_Queue);
+    pthread_mutex_unlock(&poSharedData->PDU_Queue_Mutex);
+}
+
 bool dlmstp_init(void *poPort, char *ifname)
 {
-    unsigned long hThread = 0;
     int rv = 0;
+    unsigned i = 0;
     SHARED_MSTP_DATA *poSharedData;
     struct mstp_port_struct_t *mstp_port = (struct mstp_port_struct_t *)poPort;
     if (!mstp_port) {
@@ -856,8 +1395,12 @@ bool dlmstp_init(void *poPort, char *ifname)
 
     poSharedData->RS485_Port_Name = ifname;
     /* initialize PDU queue */
-    Ringbuf_Init(&poSharedData->PDU_Queue, (uint8_t *)&poSharedData->PDU_Buffer,
-        sizeof(struct mstp_pdu_packet), MSTP_PDU_PACKET_COUNT);
+    Prioq_Init(&poSharedData->PDU_Queue, poSharedData->PDU_Slot,
+        MSTP_PDU_PACKET_COUNT, MSTP_PDU_AGING_TIME);
+    for (i = 0; i < MSTP_PDU_REPLY_INDEX_SIZE; i++) {
+        poSharedData->Reply_Index[i] = MSTP_PDU_PACKET_COUNT;
+    }
+    pthread_mutex_init(&poSharedData->PDU_Queue_Mutex, NULL);
     /* initialize packet queue */
     poSharedData->Receive_Packet.ready = false;
     poSharedData->Receive_Packet.pdu_len = 0;
@@ -881,13 +1424,8 @@ bool dlmstp_init(void *poPort, char *ifname)
         perror(poSharedData->RS485_Port_Name);
         exit(-1);
     }
-#if 0
-    /* non blocking for the read */
-    fcntl(poSharedData->RS485_Handle, F_SETFL, FNDELAY);
-#else
-    /* efficient blocking for the read */
-    fcntl(poSharedData->RS485_Handle, F_SETFL, 0);
-#endif
+    /* non blocking for the read: the event loop waits in epoll_wait()
+       and then reads whatever is available */
     /* save current serial port settings */
     tcgetattr(poSharedData->RS485_Handle, &poSharedData->RS485_oldtio);
     /* clear struct for new port settings */
@@ -907,6 +1445,9 @@ bool dlmstp_init(void *poPort, char *ifname)
     newtio.c_oflag = 0;
     /* no processing */
     newtio.c_lflag = 0;
+    /* read() returns at once with whatever octets have arrived */
+    newtio.c_cc[VMIN] = 0;
+    newtio.c_cc[VTIME] = 0;
     /* activate the settings for the port after flushing I/O */
     tcsetattr(poSharedData->RS485_Handle, TCSAFLUSH, &newtio);
     /* flush any data waiting */
@@ -915,12 +1456,14 @@ bool dlmstp_init(void *poPort, char *ifname)
     /* ringbuffer */
     FIFO_Init(&poSharedData->Rx_FIFO, poSharedData->Rx_Buffer,
         sizeof(poSharedData->Rx_Buffer));
+    FIFO_Init(&poSharedData->Tx_FIFO, poSharedData->Tx_Buffer,
+        sizeof(poSharedData->Tx_Buffer));
     printf("=success!\n");
     mstp_port->InputBuffer = &poSharedData->RxBuffer[0];
     mstp_port->InputBufferSize = sizeof(poSharedData->RxBuffer);
     mstp_port->OutputBuffer = &poSharedData->TxBuffer[0];
     mstp_port->OutputBufferSize = sizeof(poSharedData->TxBuffer);
-    gettimeofday(&poSharedData->start, NULL);
+    clock_gettime(CLOCK_MONOTONIC, &poSharedData->start);
     mstp_port->SilenceTimer = Timer_Silence;
     mstp_port->SilenceTimerReset = Timer_Silence_Reset;
     MSTP_Init(mstp_port);
@@ -930,10 +1473,5 @@ bool dlmstp_init(void *poPort, char *ifname)
     fprintf(stderr, "MS/TP Max_Info_Frames: %u\n", mstp_port->Nmax_info_frames);
 #endif
 
-    rv = pthread_create(&hThread, NULL, dlmstp_master_fsm_task, mstp_port);
-    if (rv != 0) {
-        fprintf(stderr, "Failed to start Master Node FSM task\n");
-    }
-
-    return true;
+    return dlmstp_event_loop_add(mstp_port);
 }
@@ -28,6 +28,7 @@
 /*#include "bacnet/datalink/dlmstp.h" */
 #include <sys/types.h>
 #include <semaphore.h>
+#include <time.h>
 
 #include <stdbool.h>
 #include <stdint.h>
@@ -35,19 +36,33 @@
 #include "bacnet/bacnet_stack_exports.h"
 #include "bacnet/bacdef.h"
 #include "bacnet/npdu.h"
+#include "bacnet/datalink/cobs.h"
 #include <termios.h>
 #include "bacnet/basic/sys/fifo.h"
-#include "bacnet/basic/sys/ringbuf.h"
+#include "bacnet/basic/sys/prioq.h"
 /* defines specific to MS/TP */
 /* preamble+type+dest+src+len+crc8+crc16 */
 #define DLMSTP_HEADER_MAX (2+1+1+1+2+1+2)
-#define DLMSTP_MPDU_MAX (DLMSTP_HEADER_MAX+MAX_PDU)
+/* extended frames are COBS encoded, with an encoded CRC-32K */
+#define DLMSTP_MPDU_MAX (DLMSTP_HEADER_MAX+COBS_ENCODED_SIZE(MAX_PDU)+\
+    COBS_ENCODED_CRC_SIZE)
 
-/* count must be a power of 2 for ringbuf library */
+/* number of ports served by the MS/TP event loop thread */
+#ifndef DLMSTP_LINUX_PORTS_MAX
+#define DLMSTP_LINUX_PORTS_MAX 16
+#endif
+
+/* number of PDU in the transmit queue of each port */
 #ifndef MSTP_PDU_PACKET_COUNT
 #define MSTP_PDU_PACKET_COUNT 8
 #endif
 
+/* milliseconds a queued PDU waits before it counts as one network
+   priority higher, so that lower priorities are not starved */
+#ifndef MSTP_PDU_AGING_TIME
+#define MSTP_PDU_AGING_TIME 1000
+#endif
+
 typedef struct dlmstp_packet {
     bool ready; /* true if ready to be sent or received */
     BACNET_ADDRESS address;     /* source address */
@@ -56,11 +71,35 @@ typedef struct dlmstp_packet {
     uint8_t pdu[DLMSTP_MPDU_MAX];      /* packet */
 } DLMSTP_PACKET;
 
+/* number of reply index buckets - must be a power of 2 */
+#ifndef MSTP_PDU_REPLY_INDEX_SIZE
+#define MSTP_PDU_REPLY_INDEX_SIZE 32
+#endif
+
+/* the decoded fields used to match a reply to a DATA_EXPECTING_REPLY */
+typedef struct dlmstp_reply_key {
+    /* MAC of the station that sent the request and gets the reply */
+    uint8_t mac;
+    uint8_t pdu_type;
+    uint8_t invoke_id;
+    uint8_t service_choice;
+    uint8_t protocol_version;
+    /* NPDU source of the request, or NPDU destination of the reply */
+    BACNET_ADDRESS address;
+} DLMSTP_REPLY_KEY;
+
 /* data structure for MS/TP PDU Queue */
 struct mstp_pdu_packet {
     bool data_expecting_reply;
     uint8_t destination_mac;
     uint16_t length;
+    /* true if this PDU could answer a DATA_EXPECTING_REPLY,
+       and is linked in the reply index using reply_key */
+    bool reply;
+    /* next slot in the same reply index bucket,
+       or MSTP_PDU_PACKET_COUNT at the end of the list */
+    uint16_t reply_next;
+    DLMSTP_REPLY_KEY reply_key;
     uint8_t buffer[DLMSTP_MPDU_MAX];
 };
 
@@ -116,11 +155,32 @@ typedef struct shared_mstp_data {
     FIFO_BUFFER Rx_FIFO;
     /* buffer size needs to be a power of 2 */
     uint8_t Rx_Buffer[4096];
-    struct timeval start;
-
-    RING_BUFFER PDU_Queue;
+    /* CLOCK_MONOTONIC time of the last line activity */
+    struct timespec start;
+    /* timerfd for the next state machine deadline */
+    int Timer_Handle;
+    /* Frames from the state machines wait here until the turnaround
+       time has passed and the serial port can take them, so that the
+       event loop never blocks on one port. */
+    FIFO_BUFFER Tx_FIFO;
+    /* buffer size needs to be a power of 2 */
+    uint8_t Tx_Buffer[4096];
+    /* CLOCK_MONOTONIC time when the turnaround time has passed */
+    struct timespec Tx_Due;
+    /* epoll_event data of RS485_Handle, and whether EPOLLOUT is set */
+    uint64_t Serial_Event;
+    bool Serial_Event_Output;
 
+    /* transmit queue by network priority, of PDU_Buffer slots */
+    PRIOQ PDU_Queue;
+    struct prioq_slot PDU_Slot[MSTP_PDU_PACKET_COUNT];
     struct mstp_pdu_packet PDU_Buffer[MSTP_PDU_PACKET_COUNT];
+    /* first PDU_Buffer slot of each reply index bucket,
+       hashed by the MAC and invoke ID of the reply */
+    uint16_t Reply_Index[MSTP_PDU_REPLY_INDEX_SIZE];
+    /* PDU_Queue and Reply_Index are shared by the application
+       thread and the event loop */
+    pthread_mutex_t PDU_Queue_Mutex;
 
 } SHARED_MSTP_DATA;
 
@@ -219,6 +279,22 @@ extern "C" {
     bool dlmstp_sole_master(
         void);
 
+    /* transmit queue counters for each network priority */
+    BACNET_STACK_EXPORT
+    bool dlmstp_fill_queue_statistics(
+        void *poShared,
+        PRIOQ_STATS * stats);   /* array of PRIOQ_CLASSES */
+    BACNET_STACK_EXPORT
+    void dlmstp_reset_queue_statistics(
+        void *poShared);
+
+    BACNET_STACK_EXPORT
+    void dlmstp_event_loop_wakeup(
+        void);
+    BACNET_STACK_EXPORT
+    int dlmstp_receive_event(
+        void);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
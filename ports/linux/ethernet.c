@@ -36,6 +36,9 @@
 #include <stdbool.h> /* for the standard bool type. */
 
 #include "bacport.h"
+#include <poll.h>
+#include <sys/mman.h>
+#include <linux/if_packet.h>
 #include "bacnet/bacdef.h"
 #include "bacnet/datalink/ethernet.h"
 #include "bacnet/bacint.h"
@@ -52,8 +55,52 @@ uint8_t Ethernet_Empty_MAC[MAX_MAC_LEN] = { 0, 0, 0, 0, 0, 0 };
 /* my local device data - MAC address */
 uint8_t Ethernet_MAC_Address[MAX_MAC_LEN] = { 0 };
 
+/* The 802.2 frames are received and sent through memory mapped rings
+   shared with the kernel (PACKET_MMAP, TPACKET_V3). The kernel fills
+   the receive ring a block at a time, and all of the frames of a block
+   are processed before the block is handed back, so a busy segment costs
+   one poll() per block instead of one read() per frame. The transmit
+   ring takes a frame without a copy through the socket layer. When the
+   rings cannot be set up, one read() or send() per frame is used. */
+
+/* receive ring block size, a multiple of the page size */
+#ifndef ETHERNET_RING_BLOCK_SIZE
+#define ETHERNET_RING_BLOCK_SIZE (1 << 16)
+#endif
+/* number of blocks in the receive ring */
+#ifndef ETHERNET_RX_RING_BLOCKS
+#define ETHERNET_RX_RING_BLOCKS 16
+#endif
+/* number of blocks in the transmit ring */
+#ifndef ETHERNET_TX_RING_BLOCKS
+#define ETHERNET_TX_RING_BLOCKS 4
+#endif
+/* milliseconds until the kernel hands over a block that is not full.
+   This is the added receive latency on a quiet segment. */
+#ifndef ETHERNET_RING_RETIRE_TIMEOUT
+#define ETHERNET_RING_RETIRE_TIMEOUT 2
+#endif
+/* transmit ring slot: frame header, address and the largest frame */
+#define ETHERNET_TX_FRAME_SIZE 2048
+/* offset of the frame data in a transmit ring slot */
+#define ETHERNET_TX_DATA_OFFSET \
+    (TPACKET3_HDRLEN - sizeof(struct sockaddr_ll))
+
 static int eth802_sockfd = -1; /* 802.2 file handle */
-static struct sockaddr eth_addr = { 0 }; /* used for binding 802.2 */
+static struct sockaddr_ll eth_addr = { 0 }; /* used for binding 802.2 */
+
+/* memory mapped receive and transmit rings */
+static uint8_t *Ring_Buffer = NULL;
+static size_t Ring_Buffer_Size = 0;
+static uint8_t *Tx_Ring = NULL;
+static unsigned Tx_Frame_Count = 0;
+static unsigned Tx_Frame_Index = 0;
+/* receive block being processed, and its next frame */
+static unsigned Rx_Block_Count = 0;
+static unsigned Rx_Block_Index = 0;
+static struct tpacket_block_desc *Rx_Block = NULL;
+static struct tpacket3_hdr *Rx_Frame = NULL;
+static uint32_t Rx_Frames_Left = 0;
 
 bool ethernet_valid(void)
 {
@@ -62,6 +109,16 @@ bool ethernet_valid(void)
 
 void ethernet_cleanup(void)
 {
+    if (Ring_Buffer) {
+        munmap(Ring_Buffer, Ring_Buffer_Size);
+    }
+    Ring_Buffer = NULL;
+    Ring_Buffer_Size = 0;
+    Tx_Ring = NULL;
+    Tx_Frame_Count = 0;
+    Rx_Block_Count = 0;
+    Rx_Block = NULL;
+    Rx_Frames_Left = 0;
     if (ethernet_valid())
         close(eth802_sockfd);
     eth802_sockfd = -1;
@@ -90,13 +147,75 @@ int setNonblocking(
 }
 #endif
 
+/* sets up the memory mapped rings; returns false if the
+   socket has to be used one frame at a time */
+static bool ethernet_ring_setup(int sock_fd)
+{
+    int version = TPACKET_V3;
+    struct tpacket_req3 rx_req = { 0 };
+    struct tpacket_req3 tx_req = { 0 };
+    size_t rx_size = 0;
+    size_t tx_size = 0;
+    void *ring = NULL;
+
+    if (setsockopt(sock_fd, SOL_PACKET, PACKET_VERSION, &version,
+            sizeof(version)) < 0) {
+        return false;
+    }
+    rx_req.tp_block_size = ETHERNET_RING_BLOCK_SIZE;
+    rx_req.tp_block_nr = ETHERNET_RX_RING_BLOCKS;
+    /* frames are variable sized in a TPACKET_V3 receive block */
+    rx_req.tp_frame_size = ETHERNET_TX_FRAME_SIZE;
+    rx_req.tp_frame_nr = (ETHERNET_RING_BLOCK_SIZE / ETHERNET_TX_FRAME_SIZE) *
+        ETHERNET_RX_RING_BLOCKS;
+    rx_req.tp_retire_blk_tov = ETHERNET_RING_RETIRE_TIMEOUT;
+    if (setsockopt(sock_fd, SOL_PACKET, PACKET_RX_RING, &rx_req,
+            sizeof(rx_req)) < 0) {
+        fprintf(stderr, "ethernet: no receive ring: %s\n", strerror(errno));
+        return false;
+    }
+    rx_size = (size_t)rx_req.tp_block_size * rx_req.tp_block_nr;
+    tx_req.tp_block_size = ETHERNET_RING_BLOCK_SIZE;
+    tx_req.tp_block_nr = ETHERNET_TX_RING_BLOCKS;
+    tx_req.tp_frame_size = ETHERNET_TX_FRAME_SIZE;
+    tx_req.tp_frame_nr = (ETHERNET_RING_BLOCK_SIZE / ETHERNET_TX_FRAME_SIZE) *
+        ETHERNET_TX_RING_BLOCKS;
+    /* kernels before 4.11 have no TPACKET_V3 transmit ring */
+    if (setsockopt(sock_fd, SOL_PACKET, PACKET_TX_RING, &tx_req,
+            sizeof(tx_req)) == 0) {
+        tx_size = (size_t)tx_req.tp_block_size * tx_req.tp_block_nr;
+    }
+    ring = mmap(NULL, rx_size + tx_size, PROT_READ | PROT_WRITE,
+        MAP_SHARED | MAP_LOCKED | MAP_POPULATE, sock_fd, 0);
+    if (ring == MAP_FAILED) {
+        /* MAP_LOCKED may exceed RLIMIT_MEMLOCK */
+        ring = mmap(NULL, rx_size + tx_size, PROT_READ | PROT_WRITE,
+            MAP_SHARED | MAP_POPULATE, sock_fd, 0);
+    }
+    if (ring == MAP_FAILED) {
+        fprintf(stderr, "ethernet: unable to map the rings: %s\n",
+            strerror(errno));
+        return false;
+    }
+    Ring_Buffer = (uint8_t *)ring;
+    Ring_Buffer_Size = rx_size + tx_size;
+    Rx_Block_Count = rx_req.tp_block_nr;
+    Rx_Block_Index = 0;
+    Rx_Block = NULL;
+    Rx_Frames_Left = 0;
+    if (tx_size) {
+        Tx_Ring = Ring_Buffer + rx_size;
+        Tx_Frame_Count = tx_req.tp_frame_nr;
+        Tx_Frame_Index = 0;
+    }
+
+    return true;
+}
+
 /* opens an 802.2 socket to receive and send packets */
-static int ethernet_bind(struct sockaddr *eth_addr, char *interface_name)
+static int ethernet_bind(struct sockaddr_ll *eth_addr, char *interface_name)
 {
     int sock_fd = -1; /* return value */
-#if 0
-    int sockopt = 0;
-#endif
     int uid = 0;
 
     fprintf(stderr, "ethernet: opening \"%s\"\n", interface_name);
@@ -112,11 +231,9 @@ static int ethernet_bind(struct sockaddr *eth_addr, char *interface_name)
     /* modules.conf (or in modutils/alias on Debian with update-modules) */
     /* alias net-pf-17 af_packet */
     /* Then follow it by: # modprobe af_packet */
-    /* Note: PF_INET/SOCK_PACKET has been replaced with
-       PF_PACKET/(SOCK_PACKET, SOCK_DGRAM, SOCK_RAW). */
 
     /* Attempt to open the socket for 802.2 ethernet frames */
-    if ((sock_fd = socket(PF_INET, SOCK_PACKET, htons(ETH_P_802_2))) < 0) {
+    if ((sock_fd = socket(PF_PACKET, SOCK_RAW, htons(ETH_P_802_2))) < 0) {
         /* Error occured */
         fprintf(
             stderr, "ethernet: Error opening socket: %s\n", strerror(errno));
@@ -129,36 +246,25 @@ static int ethernet_bind(struct sockaddr *eth_addr, char *interface_name)
             "# modprobe af_packet\n");
         exit(-1);
     }
-#if 0
-    /* It is very advisable to do a IP_HDRINCL call, to make sure
-       that the kernel knows the header is included in the data,
-       and doesn't insert its own header into the packet before our data */
-    if (setsockopt(sock_fd, IPPROTO_IP, IP_HDRINCL, &sockopt,
-            sizeof(sockopt)) < 0) {
-        printf("Warning: Cannot set HDRINCL!\n");
+    if (!ethernet_ring_setup(sock_fd)) {
+        fprintf(stderr, "ethernet: using one system call per frame\n");
     }
-#endif
-    /* Bind the socket to an address */
-    eth_addr->sa_family = PF_INET;
-    /* Clear the memory before copying */
-    memset(eth_addr->sa_data, '\0', sizeof(eth_addr->sa_data));
-    /* Strcpy the interface name into the address */
-    strncpy(eth_addr->sa_data, interface_name, sizeof(eth_addr->sa_data) - 1);
-    fprintf(stderr, "ethernet: binding \"%s\"\n", eth_addr->sa_data);
+    /* Bind the socket to the interface */
+    memset(eth_addr, 0, sizeof(struct sockaddr_ll));
+    eth_addr->sll_family = AF_PACKET;
+    eth_addr->sll_protocol = htons(ETH_P_802_2);
+    eth_addr->sll_ifindex = if_nametoindex(interface_name);
+    fprintf(stderr, "ethernet: binding \"%s\"\n", interface_name);
     /* Attempt to bind the socket to the interface */
-    if (bind(sock_fd, eth_addr, sizeof(struct sockaddr)) != 0) {
+    if ((eth_addr->sll_ifindex == 0) ||
+        (bind(sock_fd, (struct sockaddr *)eth_addr,
+             sizeof(struct sockaddr_ll)) != 0)) {
         /* Bind problem, close socket and return */
         fprintf(stderr, "ethernet: Unable to bind 802.2 socket : %s\n",
             strerror(errno));
-        fprintf(stderr,
-            "You might need to add the following to modules.conf\n"
-            "(or in /etc/modutils/alias on Debian with update-modules):\n"
-            "alias net-pf-17 af_packet\n"
-            "Also, add af_packet to /etc/modules.\n"
-            "Then follow it by:\n"
-            "# modprobe af_packet\n");
         /* Close the socket */
-        close(sock_fd);
+        eth802_sockfd = sock_fd;
+        ethernet_cleanup();
         exit(-1);
     }
 
@@ -201,13 +307,56 @@ bool ethernet_init(char *interface_name)
     return ethernet_valid();
 }
 
+/* places a frame in the transmit ring and asks the kernel to send it */
+static int ethernet_ring_send(uint8_t *mtu, int mtu_len)
+{
+    struct tpacket3_hdr *frame;
+    struct pollfd fds;
+
+    if ((mtu_len <= 0) ||
+        (mtu_len > (int)(ETHERNET_TX_FRAME_SIZE - ETHERNET_TX_DATA_OFFSET))) {
+        return -1;
+    }
+    frame = (struct tpacket3_hdr *)(Tx_Ring +
+        ((size_t)Tx_Frame_Index * ETHERNET_TX_FRAME_SIZE));
+    if (frame->tp_status & (TP_STATUS_SEND_REQUEST | TP_STATUS_SENDING)) {
+        /* the ring is full: wait for the kernel to drain it */
+        (void)send(eth802_sockfd, NULL, 0, MSG_DONTWAIT);
+        fds.fd = eth802_sockfd;
+        fds.events = POLLOUT;
+        fds.revents = 0;
+        (void)poll(&fds, 1, 10);
+        if (frame->tp_status & (TP_STATUS_SEND_REQUEST | TP_STATUS_SENDING)) {
+            errno = EAGAIN;
+            return -1;
+        }
+    }
+    memcpy((uint8_t *)frame + ETHERNET_TX_DATA_OFFSET, mtu, mtu_len);
+    frame->tp_len = mtu_len;
+    frame->tp_snaplen = mtu_len;
+    frame->tp_next_offset = 0;
+    __sync_synchronize();
+    frame->tp_status = TP_STATUS_SEND_REQUEST;
+    Tx_Frame_Index = (Tx_Frame_Index + 1) % Tx_Frame_Count;
+    if (send(eth802_sockfd, NULL, 0, MSG_DONTWAIT) < 0) {
+        if (errno != EAGAIN) {
+            return -1;
+        }
+    }
+
+    return mtu_len;
+}
+
 int ethernet_send(uint8_t *mtu, int mtu_len)
 {
     int bytes = 0;
 
     /* Send the packet */
-    bytes = sendto(eth802_sockfd, &mtu, mtu_len, 0,
-        (struct sockaddr *)&eth_addr, sizeof(struct sockaddr));
+    if (Tx_Ring) {
+        bytes = ethernet_ring_send(mtu, mtu_len);
+    } else {
+        bytes = send(eth802_sockfd, mtu, mtu_len, 0);
+    }
     /* did it get sent? */
     if (bytes < 0)
         fprintf(
@@ -224,7 +373,6 @@ int ethernet_send_pdu(BACNET_ADDRESS *dest, /* destination address */
     unsigned pdu_len)
 { /* number of bytes of data */
     int i = 0; /* counter */
-    int bytes = 0;
     BACNET_ADDRESS src = { 0 }; /* source address for npdu */
     uint8_t mtu[ETHERNET_MPDU_MAX] = { 0 }; /* our buffer */
     int mtu_len = 0;
@@ -274,15 +422,113 @@ int ethernet_send_pdu(BACNET_ADDRESS *dest, /* destination address */
     /* packet length - only the logical portion, not the address */
     encode_unsigned16(&mtu[12], 3 + pdu_len);
 
-    /* Send the packet */
-    bytes = sendto(eth802_sockfd, &mtu, mtu_len, 0,
-        (struct sockaddr *)&eth_addr, sizeof(struct sockaddr));
-    /* did it get sent? */
-    if (bytes < 0)
-        fprintf(
-            stderr, "ethernet: Error sending packet: %s\n", strerror(errno));
+    return ethernet_send(mtu, mtu_len);
+}
 
-    return bytes;
+/* decodes a received 802.2 frame */
+/* returns the number of octets in the PDU, or zero if not for us */
+static uint16_t ethernet_frame_pdu(uint8_t *buf,
+    unsigned frame_len,
+    BACNET_ADDRESS *src,
+    uint8_t *pdu,
+    uint16_t max_pdu)
+{
+    uint16_t pdu_len = 0;
+
+    if (frame_len < ETHERNET_HEADER_MAX)
+        return 0;
+
+    /* the signature of an 802.2 BACnet packet */
+    if ((buf[14] != 0x82) && (buf[15] != 0x82)) {
+        /*fprintf(stderr,"ethernet: Non-BACnet packet\n"); */
+        return 0;
+    }
+    /* copy the source address */
+    src->mac_len = 6;
+    memmove(src->mac, &buf[6], 6);
+
+    /* check destination address for when */
+    /* the Ethernet card is in promiscious mode */
+    if ((memcmp(&buf[0], Ethernet_MAC_Address, 6) != 0) &&
+        (memcmp(&buf[0], Ethernet_Broadcast, 6) != 0)) {
+        /*fprintf(stderr, "ethernet: This packet isn't for us\n"); */
+        return 0;
+    }
+
+    (void)decode_unsigned16(&buf[12], &pdu_len);
+    if ((pdu_len < 3) || (pdu_len > (frame_len - 14)))
+        return 0;
+    pdu_len -= 3 /* DSAP, SSAP, LLC Control */;
+    /* copy the buffer into the PDU */
+    if (pdu_len < max_pdu)
+        memmove(&pdu[0], &buf[17], pdu_len);
+    /* ignore packets that are too large */
+    else
+        pdu_len = 0;
+
+    return pdu_len;
+}
+
+/* receives the next 802.2 frame from the receive ring, processing
+   a whole block before it is returned to the kernel */
+static uint16_t ethernet_ring_receive(BACNET_ADDRESS *src,
+    uint8_t *pdu,
+    uint16_t max_pdu,
+    unsigned timeout)
+{
+    struct tpacket_block_desc *block;
+    struct tpacket3_hdr *frame;
+    struct sockaddr_ll *sll;
+    struct pollfd fds;
+    bool waited = false;
+    uint16_t pdu_len = 0;
+
+    for (;;) {
+        if (!Rx_Block) {
+            block = (struct tpacket_block_desc *)(Ring_Buffer +
+                ((size_t)Rx_Block_Index * ETHERNET_RING_BLOCK_SIZE));
+            if (!(block->hdr.bh1.block_status & TP_STATUS_USER)) {
+                if (waited) {
+                    break;
+                }
+                fds.fd = eth802_sockfd;
+                fds.events = POLLIN | POLLERR;
+                fds.revents = 0;
+                (void)poll(&fds, 1, timeout);
+                waited = true;
+                continue;
+            }
+            __sync_synchronize();
+            Rx_Block = block;
+            Rx_Frames_Left = block->hdr.bh1.num_pkts;
+            Rx_Frame = (struct tpacket3_hdr *)((uint8_t *)block +
+                block->hdr.bh1.offset_to_first_pkt);
+        }
+        while (Rx_Frames_Left) {
+            frame = Rx_Frame;
+            Rx_Frames_Left--;
+            Rx_Frame =
+                (struct tpacket3_hdr *)((uint8_t *)frame + frame->tp_next_offset);
+            sll = (struct sockaddr_ll *)((uint8_t *)frame +
+                TPACKET_ALIGN(sizeof(struct tpacket3_hdr)));
+            if (sll->sll_pkttype == PACKET_OUTGOING) {
+                /* our own frame */
+                continue;
+            }
+            pdu_len = ethernet_frame_pdu((uint8_t *)frame + frame->tp_mac,
+                frame->tp_snaplen, src, pdu, max_pdu);
+            if (pdu_len) {
+                return pdu_len;
+            }
+        }
+        /* hand the block back to the kernel */
+        __sync_synchronize();
+        Rx_Block->hdr.bh1.block_status = TP_STATUS_KERNEL;
+        Rx_Block = NULL;
+        Rx_Block_Index = (Rx_Block_Index + 1) % Rx_Block_Count;
+    }
+
+    return 0;
 }
 
 /* receives an 802.2 framed packet */
@@ -294,15 +540,19 @@ uint16_t ethernet_receive(BACNET_ADDRESS *src, /* source address */
 { /* number of milliseconds to wait for a packet */
     int received_bytes;
     uint8_t buf[ETHERNET_MPDU_MAX] = { 0 }; /* data */
-    uint16_t pdu_len = 0; /* return value */
     fd_set read_fds;
     int max;
     struct timeval select_timeout;
+    struct sockaddr_ll sll = { 0 };
+    socklen_t sll_len = sizeof(sll);
 
     /* Make sure the socket is open */
     if (eth802_sockfd <= 0)
         return 0;
 
+    if (Ring_Buffer)
+        return ethernet_ring_receive(src, pdu, max_pdu, timeout);
+
     /* we could just use a non-blocking socket, but that consumes all
        the CPU time.  We can use a timeout; it is only supported as
        a select. */
@@ -319,7 +569,8 @@ uint16_t ethernet_receive(BACNET_ADDRESS *src, /* source address */
     max = eth802_sockfd;
 
     if (select(max + 1, &read_fds, NULL, NULL, &select_timeout) > 0)
-        received_bytes = read(eth802_sockfd, &buf[0], sizeof(buf));
+        received_bytes = recvfrom(eth802_sockfd, &buf[0], sizeof(buf), 0,
+            (struct sockaddr *)&sll, &sll_len);
     else
         return 0;
 
@@ -334,36 +585,10 @@ uint16_t ethernet_receive(BACNET_ADDRESS *src, /* source address */
         return 0;
     }
 
-    if (received_bytes == 0)
+    if ((received_bytes == 0) || (sll.sll_pkttype == PACKET_OUTGOING))
         return 0;
 
-    /* the signature of an 802.2 BACnet packet */
-    if ((buf[14] != 0x82) && (buf[15] != 0x82)) {
-        /*fprintf(stderr,"ethernet: Non-BACnet packet\n"); */
-        return 0;
-    }
-    /* copy the source address */
-    src->mac_len = 6;
-    memmove(src->mac, &buf[6], 6);
-
-    /* check destination address for when */
-    /* the Ethernet card is in promiscious mode */
-    if ((memcmp(&buf[0], Ethernet_MAC_Address, 6) != 0) &&
-        (memcmp(&buf[0], Ethernet_Broadcast, 6) != 0)) {
-        /*fprintf(stderr, "ethernet: This packet isn't for us\n"); */
-        return 0;
-    }
-
-    (void)decode_unsigned16(&buf[12], &pdu_len);
-    pdu_len -= 3 /* DSAP, SSAP, LLC Control */;
-    /* copy the buffer into the PDU */
-    if (pdu_len < max_pdu)
-        memmove(&pdu[0], &buf[17], pdu_len);
-    /* ignore packets that are too large */
-    else
-        pdu_len = 0;
-
-    return pdu_len;
+    return ethernet_frame_pdu(buf, received_bytes, src, pdu, max_pdu);
 }
 
 void ethernet_set_my_address(BACNET_ADDRESS *my_address)
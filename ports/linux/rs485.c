@@ -375,6 +375,69 @@ bool RS485_Set_Baud_Rate(uint32_t baud)
     return valid;
 }
 
+/* add nanoseconds to a CLOCK_MONOTONIC time */
+static void timespec_add_ns(struct timespec *ts, uint64_t ns)
+{
+    ns += ts->tv_nsec;
+    ts->tv_sec += ns / 1000000000ULL;
+    ts->tv_nsec = ns % 1000000000ULL;
+}
+
+/* true if time a is before time b */
+static bool timespec_before(const struct timespec *a, const struct timespec *b)
+{
+    if (a->tv_sec != b->tv_sec) {
+        return a->tv_sec < b->tv_sec;
+    }
+
+    return a->tv_nsec < b->tv_nsec;
+}
+
+/****************************************************************************
+ * DESCRIPTION: Write all of a buffer to the non-blocking port handle
+ * RETURN:      number of bytes written, or -1 on error
+ * ALGORITHM:   none
+ * NOTES:       write() may return a partial count or EAGAIN when the
+ *              UART transmit buffer is full; wait until the handle is
+ *              writable and continue with the rest of the buffer.
+ *              Blocks, so only for a port that has a thread of its own.
+ *****************************************************************************/
+static ssize_t RS485_Write_All(int handle, const uint8_t *buffer, size_t nbytes)
+{
+    fd_set output;
+    struct timeval waiter;
+    size_t total = 0;
+    ssize_t written;
+    int n;
+
+    while (total < nbytes) {
+        written = write(handle, buffer + total, nbytes - total);
+        if (written > 0) {
+            total += (size_t)written;
+        } else if ((written < 0) && (errno == EINTR)) {
+            continue;
+        } else if (
+            (written == 0) ||
+            ((written < 0) && ((errno == EAGAIN) || (errno == EWOULDBLOCK)))) {
+            FD_ZERO(&output);
+            FD_SET(handle, &output);
+            waiter.tv_sec = 1;
+            waiter.tv_usec = 0;
+            n = select(handle + 1, NULL, &output, NULL, &waiter);
+            if (n == 0) {
+                errno = ETIMEDOUT;
+                return -1;
+            } else if ((n < 0) && (errno != EINTR)) {
+                return -1;
+            }
+        } else {
+            return -1;
+        }
+    }
+
+    return (ssize_t)total;
+}
+
 /****************************************************************************
  * DESCRIPTION: Transmit a frame on the wire
  * RETURN:      none
@@ -408,9 +471,9 @@ void RS485_Send_Frame(
            causing any other effect.  For a special file, the results are not
            portable.
          */
-        written = write(RS485_Handle, buffer, nbytes);
+        written = RS485_Write_All(RS485_Handle, buffer, nbytes);
         greska = errno;
-        if (written <= 0) {
+        if (written < 0) {
             printf("write error: %s\n", strerror(greska));
         } else {
             /* wait until all output has been transmitted. */
@@ -422,30 +485,22 @@ void RS485_Send_Frame(
             mstp_port->SilenceTimerReset((void *)mstp_port);
         }
     } else {
-        baud = RS485_Get_Port_Baud_Rate(mstp_port);
-        /* sleeping for turnaround time is necessary to give other devices
-           time to change from sending to receiving state. */
-        usleep(turnaround_time / baud);
-        /*
-           On  success,  the  number of bytes written are returned (zero
-           indicates nothing was written).  On error, -1  is  returned,  and
-           errno  is  set appropriately.   If  count  is zero and the file
-           descriptor refers to a regular file, 0 will be returned without
-           causing any other effect.  For a special file, the results are not
-           portable.
-         */
-        written = write(poSharedData->RS485_Handle, buffer, nbytes);
-        greska = errno;
-        if (written <= 0) {
-            printf("write error: %s\n", strerror(greska));
-        } else {
-            /* wait until all output has been transmitted. */
-            tcdrain(poSharedData->RS485_Handle);
+        /* The event loop serves every port from one thread, so nothing
+           here may wait: the frame is queued, and the event loop writes
+           it with RS485_Write_UART_Buffer() once the turnaround time has
+           passed and the port can take it. */
+        if (FIFO_Empty(&poSharedData->Tx_FIFO)) {
+            /* give the other devices time to change from sending
+               to receiving state */
+            baud = RS485_Get_Port_Baud_Rate(mstp_port);
+            clock_gettime(CLOCK_MONOTONIC, &poSharedData->Tx_Due);
+            if (baud) {
+                timespec_add_ns(&poSharedData->Tx_Due,
+                    (Tturnaround * 1000000000ULL) / baud);
+            }
         }
-        /*  tcdrain(RS485_Handle); */
-        /* per MSTP spec, sort of */
-        if (mstp_port) {
-            mstp_port->SilenceTimerReset((void *)mstp_port);
+        if (!FIFO_Add(&poSharedData->Tx_FIFO, buffer, nbytes)) {
+            printf("write error: transmit FIFO full\n");
         }
     }
 
@@ -533,6 +588,138 @@ void RS485_Check_UART_Data(volatile struct mstp_port_struct_t *mstp_port)
     }
 }
 
+/****************************************************************************
+ * DESCRIPTION: Read the receive data that is already available and run the
+ *              MS/TP receive state machine over it as a block
+ * RETURN:      none
+ * ALGORITHM:   none
+ * NOTES:       Does not wait. Used by an event loop once the handle is
+ *              readable, or once one of the MS/TP timeouts has expired.
+ *              Octets that are not consumed because a frame was completed
+ *              stay in the FIFO for the next call.
+ *****************************************************************************/
+void RS485_Read_UART_Buffer(volatile struct mstp_port_struct_t *mstp_port)
+{
+    uint8_t buf[2048];
+    FIFO_BUFFER *fifo;
+    int handle;
+    unsigned count;
+    uint16_t consumed;
+    int n;
+
+    SHARED_MSTP_DATA *poSharedData = (SHARED_MSTP_DATA *)mstp_port->UserData;
+    if (!poSharedData) {
+        handle = RS485_Handle;
+        fifo = &Rx_FIFO;
+    } else {
+        handle = poSharedData->RS485_Handle;
+        fifo = &poSharedData->Rx_FIFO;
+    }
+    count = fifo->buffer_len - FIFO_Count(fifo);
+    if (count > sizeof(buf)) {
+        count = sizeof(buf);
+    }
+    if (count > 0) {
+        /* VMIN=0 and VTIME=0: returns at once */
+        n = read(handle, buf, count);
+        if (n > 0) {
+            FIFO_Add(fifo, &buf[0], n);
+        }
+    }
+    count = FIFO_Peek_Ahead(fifo, &buf[0], sizeof(buf));
+    consumed = MSTP_Receive_Frame_Buffer(mstp_port, &buf[0], count);
+    FIFO_Pull(fifo, NULL, consumed);
+}
+
+/****************************************************************************
+ * DESCRIPTION: Write the queued frames of an event loop port
+ * RETURN:      true if the transmit FIFO is empty, false if the port
+ *              cannot take more octets yet
+ * ALGORITHM:   none
+ * NOTES:       Does not wait. The event loop calls this once the
+ *              turnaround time has passed, and again when the handle
+ *              becomes writable if it returned false.
+ *              Rather than blocking in tcdrain(), the silence timer
+ *              starts when the last octet written will have been sent.
+ *****************************************************************************/
+bool RS485_Write_UART_Buffer(volatile struct mstp_port_struct_t *mstp_port)
+{
+    uint8_t buf[2048];
+    struct timespec now;
+    uint32_t baud;
+    unsigned count;
+    ssize_t written;
+
+    SHARED_MSTP_DATA *poSharedData = (SHARED_MSTP_DATA *)mstp_port->UserData;
+    if (!poSharedData) {
+        return true;
+    }
+    baud = RS485_Get_Port_Baud_Rate(mstp_port);
+    while (!FIFO_Empty(&poSharedData->Tx_FIFO)) {
+        count = FIFO_Peek_Ahead(&poSharedData->Tx_FIFO, &buf[0], sizeof(buf));
+        written = write(poSharedData->RS485_Handle, &buf[0], count);
+        if (written > 0) {
+            FIFO_Pull(&poSharedData->Tx_FIFO, NULL, (unsigned)written);
+            /* 10 bit times per octet, after the octets before them */
+            clock_gettime(CLOCK_MONOTONIC, &now);
+            if (timespec_before(&poSharedData->start, &now)) {
+                poSharedData->start = now;
+            }
+            if (baud) {
+                timespec_add_ns(&poSharedData->start,
+                    ((uint64_t)written * 10 * 1000000000ULL) / baud);
+            }
+        } else if ((written < 0) && (errno == EINTR)) {
+            continue;
+        } else if ((written == 0) || (errno == EAGAIN) ||
+            (errno == EWOULDBLOCK)) {
+            return false;
+        } else {
+            printf("write error: %s\n", strerror(errno));
+            FIFO_Flush(&poSharedData->Tx_FIFO);
+        }
+    }
+
+    return true;
+}
+
+/****************************************************************************
+ * DESCRIPTION: Wait up to 5ms for receive data and run the MS/TP receive
+ *              state machine over it as a block
+ * RETURN:      none
+ * ALGORITHM:   none
+ * NOTES:       Replaces the RS485_Check_UART_Data() and
+ *              MSTP_Receive_Frame_FSM() pair in a thread receive loop.
+ *****************************************************************************/
+void RS485_Check_UART_Buffer(volatile struct mstp_port_struct_t *mstp_port)
+{
+    fd_set input;
+    struct timeval waiter;
+    FIFO_BUFFER *fifo;
+    int handle;
+
+    SHARED_MSTP_DATA *poSharedData = (SHARED_MSTP_DATA *)mstp_port->UserData;
+    if (!poSharedData) {
+        handle = RS485_Handle;
+        fifo = &Rx_FIFO;
+    } else {
+        handle = poSharedData->RS485_Handle;
+        fifo = &poSharedData->Rx_FIFO;
+    }
+    waiter.tv_sec = 0;
+    if (FIFO_Empty(fifo)) {
+        /* FIFO is empty - wait a longer time */
+        waiter.tv_usec = 5000;
+    } else {
+        /* FIFO is giving data - just poll */
+        waiter.tv_usec = 0;
+    }
+    FD_ZERO(&input);
+    FD_SET(handle, &input);
+    (void)select(handle + 1, &input, NULL, NULL, &waiter);
+    RS485_Read_UART_Buffer(mstp_port);
+}
+
 void RS485_Cleanup(void)
 {
     /* restore the old port settings */
@@ -65,6 +65,15 @@ extern "C" {
     void RS485_Check_UART_Data(
         volatile struct mstp_port_struct_t *mstp_port); /* port specific data */
     BACNET_STACK_EXPORT
+    void RS485_Read_UART_Buffer(
+        volatile struct mstp_port_struct_t *mstp_port); /* port specific data */
+    BACNET_STACK_EXPORT
+    bool RS485_Write_UART_Buffer(
+        volatile struct mstp_port_struct_t *mstp_port); /* port specific data */
+    BACNET_STACK_EXPORT
+    void RS485_Check_UART_Buffer(
+        volatile struct mstp_port_struct_t *mstp_port); /* port specific data */
+    BACNET_STACK_EXPORT
     uint32_t RS485_Get_Port_Baud_Rate(
         volatile struct mstp_port_struct_t *mstp_port);
     BACNET_STACK_EXPORT
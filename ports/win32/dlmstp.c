@@ -67,6 +67,8 @@ static uint16_t Treply_timeout = 260;
 static uint8_t Tusage_timeout = 30;
 /* local timer for tracking silence on the wire */
 static struct mstimer Silence_Timer;
+/* transmit and token hold counters */
+static DLMSTP_STATISTICS Statistics;
 
 /* Timer that indicates line silence - and functions */
 static uint32_t Timer_Silence(void *pArg)
@@ -113,6 +115,10 @@ int dlmstp_send_pdu(BACNET_ADDRESS *dest, /* destination address */
         bacnet_address_copy(&Transmit_Packet.address, dest);
         bytes_sent = pdu_len + DLMSTP_HEADER_MAX;
         Transmit_Packet.ready = true;
+        Statistics.transmit_queue_depth = 1;
+        Statistics.transmit_queue_peak = 1;
+    } else {
+        Statistics.transmit_queue_drop_counter++;
     }
 
     return bytes_sent;
@@ -242,6 +248,7 @@ uint16_t MSTP_Put_Receive(volatile struct mstp_port_struct_t *mstp_port)
             &Receive_Packet.address, mstp_port->SourceAddress);
         Receive_Packet.pdu_len = mstp_port->DataLength;
         Receive_Packet.ready = true;
+        Statistics.receive_pdu_counter++;
         rc = ReleaseSemaphore(Receive_Packet_Flag, 1, NULL);
         (void)rc;
     }
@@ -258,6 +265,13 @@ uint16_t MSTP_Get_Send(
     uint8_t destination = 0; /* destination address */
 
     (void)timeout;
+    if (mstp_port->FrameCount == 0) {
+        /* single transmit packet: the budget stays at Max_Info_Frames */
+        Statistics.info_frames_budget = MSTP_Adaptive_Info_Frames(
+            mstp_port, Transmit_Packet.ready ? 1 : 0, 0, 0);
+        Statistics.token_hold_counter++;
+        Statistics.token_hold_budget_counter += Statistics.info_frames_budget;
+    }
     if (!Transmit_Packet.ready) {
         return 0;
     }
@@ -277,6 +291,9 @@ uint16_t MSTP_Get_Send(
             destination, mstp_port->This_Station, &Transmit_Packet.pdu[0],
             Transmit_Packet.pdu_len);
     Transmit_Packet.ready = false;
+    Statistics.transmit_pdu_counter++;
+    Statistics.token_hold_frame_counter++;
+    Statistics.transmit_queue_depth = 0;
 
     return pdu_len;
 }
@@ -476,6 +493,32 @@ uint8_t dlmstp_max_info_frames(void)
     return MSTP_Port.Nmax_info_frames;
 }
 
+/* Adaptive Max_Info_Frames: only the limit is kept, since this datalink */
+/* holds a single transmit packet and never has frames queued behind it. */
+void dlmstp_set_max_info_frames_adaptive(uint8_t limit)
+{
+    MSTP_Port.Nmax_info_frames_adaptive = limit;
+}
+
+uint8_t dlmstp_max_info_frames_adaptive(void)
+{
+    return MSTP_Port.Nmax_info_frames_adaptive;
+}
+
+/* Reset the statistics counters on the MS/TP datalink */
+void dlmstp_reset_statistics(void)
+{
+    memset(&Statistics, 0, sizeof(Statistics));
+}
+
+/* Retrieve statistics counters from the MS/TP datalink */
+void dlmstp_fill_statistics(struct dlmstp_statistics *statistics)
+{
+    if (statistics) {
+        memcpy(statistics, &Statistics, sizeof(Statistics));
+    }
+}
+
 /* This parameter represents the value of the Max_Master property of the */
 /* node's Device object. The value of Max_Master specifies the highest */
 /* allowable address for master nodes. The value of Max_Master shall be */
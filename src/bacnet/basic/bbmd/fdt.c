@@ -0,0 +1,447 @@
+/**
+ * @file
+ * @date October 2026
+ * @brief BBMD Foreign Device Table (FDT) with an
+ *  address index, for BBMDs that accept many foreign devices.
+ *
+ * @section LICENSE
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include "bacnet/datalink/bvlc.h"
+#include "bacnet/basic/bbmd/fdt.h"
+
+/* The FDT entries stay in the BACNET_IP_FOREIGN_DEVICE_TABLE_ENTRY linked
+   list that the Read-FDT service and the Network Port object encode.
+   Registered entries are also kept in a dense array, so that forwarding
+   and timer maintenance only touch registered foreign devices, and in an
+   open addressing hash table of indexes into that dense array, so that
+   registrations and deletions do not scan the table. */
+typedef struct BBMD_FDT_Active {
+    BACNET_IP_ADDRESS dest_address;
+    BACNET_IP_FOREIGN_DEVICE_TABLE_ENTRY *entry;
+} BBMD_FDT_ACTIVE;
+
+/* statically allocated table */
+static BACNET_IP_FOREIGN_DEVICE_TABLE_ENTRY FDT_Table[MAX_FD_ENTRIES];
+static BBMD_FDT_ACTIVE FDT_Table_Active[MAX_FD_ENTRIES];
+static BACNET_IP_FOREIGN_DEVICE_TABLE_ENTRY *FDT_Table_Free[MAX_FD_ENTRIES];
+static unsigned FDT_Table_Hash[MAX_FD_ENTRIES * 2];
+/* current table - grows beyond the static table if enabled */
+static BBMD_FDT_ACTIVE *FDT_Active = FDT_Table_Active;
+static BACNET_IP_FOREIGN_DEVICE_TABLE_ENTRY **FDT_Free = FDT_Table_Free;
+/* hash slots hold the dense array index plus one, zero is an empty slot */
+static unsigned *FDT_Hash = FDT_Table_Hash;
+static unsigned FDT_Hash_Size = MAX_FD_ENTRIES * 2;
+static unsigned FDT_Size = MAX_FD_ENTRIES;
+static unsigned FDT_Count;
+static unsigned FDT_Free_Count;
+#if BBMD_FDT_GROW_ENTRIES
+/* dynamically allocated blocks of entries appended to the list */
+struct BBMD_FDT_Block {
+    struct BBMD_FDT_Block *next;
+    BACNET_IP_FOREIGN_DEVICE_TABLE_ENTRY entry[BBMD_FDT_GROW_ENTRIES];
+};
+static struct BBMD_FDT_Block *FDT_Blocks;
+static BACNET_IP_FOREIGN_DEVICE_TABLE_ENTRY *FDT_Tail;
+#endif
+
+/**
+ * @brief Compute the home hash slot of a B/IPv4 address
+ * @param addr - B/IPv4 address
+ * @return hash slot index
+ */
+static unsigned fdt_hash_slot(const BACNET_IP_ADDRESS *addr)
+{
+    /* FNV-1a over the 4-octet address and the 2-octet port */
+    uint32_t hash = 2166136261UL;
+    unsigned i = 0;
+
+    for (i = 0; i < IP_ADDRESS_MAX; i++) {
+        hash ^= addr->address[i];
+        hash *= 16777619UL;
+    }
+    hash ^= (uint8_t)(addr->port >> 8);
+    hash *= 16777619UL;
+    hash ^= (uint8_t)(addr->port & 0xFF);
+    hash *= 16777619UL;
+
+    return (unsigned)(hash % FDT_Hash_Size);
+}
+
+/**
+ * @brief Find the hash slot that holds a B/IPv4 address
+ * @param addr - B/IPv4 address
+ * @return hash slot index, or FDT_Hash_Size if not found
+ */
+static unsigned fdt_hash_find(const BACNET_IP_ADDRESS *addr)
+{
+    unsigned slot = fdt_hash_slot(addr);
+    unsigned index = 0;
+
+    while (FDT_Hash[slot]) {
+        index = FDT_Hash[slot] - 1;
+        if (!bvlc_address_different(&FDT_Active[index].dest_address, addr)) {
+            return slot;
+        }
+        slot = (slot + 1) % FDT_Hash_Size;
+    }
+
+    return FDT_Hash_Size;
+}
+
+/**
+ * @brief Store a dense array index in the hash table
+ * @param index - dense array index of a registered foreign device
+ */
+static void fdt_hash_insert(unsigned index)
+{
+    unsigned slot = fdt_hash_slot(&FDT_Active[index].dest_address);
+
+    while (FDT_Hash[slot]) {
+        slot = (slot + 1) % FDT_Hash_Size;
+    }
+    FDT_Hash[slot] = index + 1;
+}
+
+/**
+ * @brief Remove a slot from the hash table, and shift the following
+ *  slots of the probe sequence back so that no tombstones are needed.
+ * @param slot - hash slot index to remove
+ */
+static void fdt_hash_remove(unsigned slot)
+{
+    unsigned next = slot;
+    unsigned home = 0;
+
+    FDT_Hash[slot] = 0;
+    for (;;) {
+        next = (next + 1) % FDT_Hash_Size;
+        if (!FDT_Hash[next]) {
+            break;
+        }
+        home = fdt_hash_slot(&FDT_Active[FDT_Hash[next] - 1].dest_address);
+        /* move the slot back unless its home lies cyclically
+           within (slot, next] */
+        if ((slot <= next) ? ((home <= slot) || (home > next))
+                           : ((home <= slot) && (home > next))) {
+            FDT_Hash[slot] = FDT_Hash[next];
+            FDT_Hash[next] = 0;
+            slot = next;
+        }
+    }
+}
+
+/**
+ * @brief Remove a registered foreign device from the dense array
+ *  and the hash table, and return its entry to the free list.
+ * @param slot - hash slot index of the foreign device
+ */
+static void fdt_active_remove(unsigned slot)
+{
+    unsigned index = FDT_Hash[slot] - 1;
+    unsigned last = FDT_Count - 1;
+    unsigned last_slot = 0;
+    BACNET_IP_FOREIGN_DEVICE_TABLE_ENTRY *entry = FDT_Active[index].entry;
+
+    entry->valid = false;
+    entry->ttl_seconds_remaining = 0;
+    FDT_Free[FDT_Free_Count] = entry;
+    FDT_Free_Count++;
+    fdt_hash_remove(slot);
+    if (index != last) {
+        /* keep the array dense by moving the last element into the gap */
+        last_slot = fdt_hash_find(&FDT_Active[last].dest_address);
+        FDT_Active[index] = FDT_Active[last];
+        FDT_Hash[last_slot] = index + 1;
+    }
+    FDT_Count--;
+}
+
+/**
+ * @brief Load the time-to-live of an FDT entry
+ * @param entry - FDT entry
+ * @param ttl_seconds - Time-to-Live T, in seconds
+ */
+static void fdt_entry_ttl_set(
+    BACNET_IP_FOREIGN_DEVICE_TABLE_ENTRY *entry, uint16_t ttl_seconds)
+{
+    entry->ttl_seconds = ttl_seconds;
+    /* Upon receipt of a BVLL Register-Foreign-Device message,
+       a BBMD shall start a timer with a value equal to the
+       Time-to-Live parameter supplied plus a fixed grace
+       period of 30 seconds. */
+    if (ttl_seconds < (UINT16_MAX - 30)) {
+        entry->ttl_seconds_remaining = ttl_seconds + 30;
+    } else {
+        entry->ttl_seconds_remaining = UINT16_MAX;
+    }
+}
+
+#if BBMD_FDT_GROW_ENTRIES
+/**
+ * @brief Add a block of entries to the FDT, and enlarge the dense
+ *  array, the free list and the hash table to match.
+ * @return true if the table was enlarged
+ */
+static bool fdt_grow(void)
+{
+    struct BBMD_FDT_Block *block = NULL;
+    BBMD_FDT_ACTIVE *active = NULL;
+    BACNET_IP_FOREIGN_DEVICE_TABLE_ENTRY **free_list = NULL;
+    unsigned *hash = NULL;
+    unsigned size = FDT_Size + BBMD_FDT_GROW_ENTRIES;
+    unsigned i = 0;
+
+    if (size > BBMD_FDT_ENTRIES_LIMIT) {
+        return false;
+    }
+    block = calloc(1, sizeof(struct BBMD_FDT_Block));
+    active = calloc(size, sizeof(BBMD_FDT_ACTIVE));
+    free_list = calloc(size, sizeof(BACNET_IP_FOREIGN_DEVICE_TABLE_ENTRY *));
+    hash = calloc(size * 2, sizeof(unsigned));
+    if (!block || !active || !free_list || !hash) {
+        free(block);
+        free(active);
+        free(free_list);
+        free(hash);
+        return false;
+    }
+    /* append the block to the linked list */
+    bvlc_foreign_device_table_link_array(
+        &block->entry[0], BBMD_FDT_GROW_ENTRIES);
+    FDT_Tail->next = &block->entry[0];
+    FDT_Tail = &block->entry[BBMD_FDT_GROW_ENTRIES - 1];
+    block->next = FDT_Blocks;
+    FDT_Blocks = block;
+    /* move the dense array and free list */
+    memcpy(active, FDT_Active, FDT_Count * sizeof(BBMD_FDT_ACTIVE));
+    memcpy(free_list, FDT_Free,
+        FDT_Free_Count * sizeof(BACNET_IP_FOREIGN_DEVICE_TABLE_ENTRY *));
+    for (i = BBMD_FDT_GROW_ENTRIES; i > 0; i--) {
+        free_list[FDT_Free_Count] = &block->entry[i - 1];
+        FDT_Free_Count++;
+    }
+    if (FDT_Active != FDT_Table_Active) {
+        free(FDT_Active);
+        free(FDT_Free);
+        free(FDT_Hash);
+    }
+    FDT_Active = active;
+    FDT_Free = free_list;
+    FDT_Hash = hash;
+    FDT_Hash_Size = size * 2;
+    FDT_Size = size;
+    /* rebuild the hash for the new size */
+    for (i = 0; i < FDT_Count; i++) {
+        fdt_hash_insert(i);
+    }
+
+    return true;
+}
+
+/**
+ * @brief Release the dynamically allocated part of the FDT
+ */
+static void fdt_release(void)
+{
+    struct BBMD_FDT_Block *block = NULL;
+
+    while (FDT_Blocks) {
+        block = FDT_Blocks;
+        FDT_Blocks = block->next;
+        free(block);
+    }
+    if (FDT_Active != FDT_Table_Active) {
+        free(FDT_Active);
+        free(FDT_Free);
+        free(FDT_Hash);
+    }
+    FDT_Tail = &FDT_Table[MAX_FD_ENTRIES - 1];
+}
+#endif
+
+/**
+ * @brief Initialize the Foreign Device Table to empty, and release
+ *  any entries that were added when the table grew.
+ */
+void bbmd_fdt_init(void)
+{
+    unsigned i = 0;
+
+#if BBMD_FDT_GROW_ENTRIES
+    fdt_release();
+#endif
+    memset(FDT_Table, 0, sizeof(FDT_Table));
+    memset(FDT_Table_Hash, 0, sizeof(FDT_Table_Hash));
+    bvlc_foreign_device_table_link_array(&FDT_Table[0], MAX_FD_ENTRIES);
+    FDT_Active = FDT_Table_Active;
+    FDT_Free = FDT_Table_Free;
+    FDT_Hash = FDT_Table_Hash;
+    FDT_Hash_Size = MAX_FD_ENTRIES * 2;
+    FDT_Size = MAX_FD_ENTRIES;
+    FDT_Count = 0;
+    /* hand out the entries from the front of the list first */
+    FDT_Free_Count = 0;
+    for (i = MAX_FD_ENTRIES; i > 0; i--) {
+        FDT_Free[FDT_Free_Count] = &FDT_Table[i - 1];
+        FDT_Free_Count++;
+    }
+}
+
+/**
+ * @brief Get the Foreign Device Table as a linked list
+ * @return pointer to first entry of foreign device table
+ */
+BACNET_IP_FOREIGN_DEVICE_TABLE_ENTRY *bbmd_fdt_list(void)
+{
+    return &FDT_Table[0];
+}
+
+/**
+ * @brief Find the FDT entry of a registered foreign device
+ * @param addr - B/IPv4 address of the foreign device
+ * @return FDT entry, or NULL if the foreign device is not registered
+ */
+BACNET_IP_FOREIGN_DEVICE_TABLE_ENTRY *bbmd_fdt_entry(
+    const BACNET_IP_ADDRESS *addr)
+{
+    unsigned slot = fdt_hash_find(addr);
+
+    if (slot < FDT_Hash_Size) {
+        return FDT_Active[FDT_Hash[slot] - 1].entry;
+    }
+
+    return NULL;
+}
+
+/**
+ * @brief Add an entry to the Foreign-Device-Table, or restart the
+ *  timer of an existing entry.
+ * @param addr - B/IPv4 address to be added
+ * @param ttl_seconds - Time-to-Live T, in seconds
+ * @return true if the Foreign Device entry was added or already exists
+ */
+bool bbmd_fdt_entry_add(const BACNET_IP_ADDRESS *addr, uint16_t ttl_seconds)
+{
+    BACNET_IP_FOREIGN_DEVICE_TABLE_ENTRY *entry = NULL;
+
+    entry = bbmd_fdt_entry(addr);
+    if (entry) {
+        fdt_entry_ttl_set(entry, ttl_seconds);
+        return true;
+    }
+#if BBMD_FDT_GROW_ENTRIES
+    if (FDT_Free_Count == 0) {
+        (void)fdt_grow();
+    }
+#endif
+    if (FDT_Free_Count == 0) {
+        return false;
+    }
+    FDT_Free_Count--;
+    entry = FDT_Free[FDT_Free_Count];
+    bvlc_address_copy(&entry->dest_address, addr);
+    fdt_entry_ttl_set(entry, ttl_seconds);
+    entry->valid = true;
+    bvlc_address_copy(&FDT_Active[FDT_Count].dest_address, addr);
+    FDT_Active[FDT_Count].entry = entry;
+    fdt_hash_insert(FDT_Count);
+    FDT_Count++;
+
+    return true;
+}
+
+/**
+ * @brief Delete an entry in the Foreign-Device-Table
+ * @param addr - B/IPv4 address to be deleted
+ * @return true if the Foreign Device entry was found and removed.
+ */
+bool bbmd_fdt_entry_delete(const BACNET_IP_ADDRESS *addr)
+{
+    unsigned slot = fdt_hash_find(addr);
+
+    if (slot < FDT_Hash_Size) {
+        fdt_active_remove(slot);
+        return true;
+    }
+
+    return false;
+}
+
+/**
+ * @brief Foreign-Device-Table timer maintenance
+ * @param seconds - number of elapsed seconds since the last call
+ */
+void bbmd_fdt_maintenance_timer(uint16_t seconds)
+{
+    BACNET_IP_FOREIGN_DEVICE_TABLE_ENTRY *entry = NULL;
+    unsigned index = 0;
+
+    while (index < FDT_Count) {
+        entry = FDT_Active[index].entry;
+        if (entry->ttl_seconds_remaining > seconds) {
+            entry->ttl_seconds_remaining -= seconds;
+            index++;
+        } else {
+            /* the last element moves into this index */
+            fdt_active_remove(
+                fdt_hash_find(&FDT_Active[index].dest_address));
+        }
+    }
+}
+
+/**
+ * @brief Get the number of registered foreign devices
+ * @return number of registered foreign devices
+ */
+unsigned bbmd_fdt_count(void)
+{
+    return FDT_Count;
+}
+
+/**
+ * @brief Get the number of entries in the Foreign Device Table
+ * @return number of entries, registered or not
+ */
+unsigned bbmd_fdt_size(void)
+{
+    return FDT_Size;
+}
+
+/**
+ * @brief Get the address of a registered foreign device.  The order
+ *  changes when foreign devices are removed.
+ * @param index - 0..bbmd_fdt_count()-1
+ * @return B/IPv4 address, or NULL if the index is out of range
+ */
+const BACNET_IP_ADDRESS *bbmd_fdt_address(unsigned index)
+{
+    if (index < FDT_Count) {
+        return &FDT_Active[index].dest_address;
+    }
+
+    return NULL;
+}
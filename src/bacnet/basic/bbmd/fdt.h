@@ -0,0 +1,87 @@
+/**
+ * @file
+ * @date October 2026
+ * @brief Header file for a BBMD Foreign Device Table (FDT) with an
+ *  address index, for BBMDs that accept many foreign devices.
+ *
+ * @section LICENSE
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#ifndef BACNET_BASIC_BBMD_FDT_H
+#define BACNET_BASIC_BBMD_FDT_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "bacnet/bacnet_stack_exports.h"
+#include "bacnet/datalink/bvlc.h"
+
+/* Number of FDT entries that are statically allocated */
+#ifndef MAX_FD_ENTRIES
+#define MAX_FD_ENTRIES 128
+#endif
+/* Number of FDT entries added to the table each time it fills up.
+   Zero keeps the table at MAX_FD_ENTRIES and avoids malloc() */
+#ifndef BBMD_FDT_GROW_ENTRIES
+#define BBMD_FDT_GROW_ENTRIES 0
+#endif
+/* Upper limit of the FDT size when growing */
+#ifndef BBMD_FDT_ENTRIES_LIMIT
+#define BBMD_FDT_ENTRIES_LIMIT 8192
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+    BACNET_STACK_EXPORT
+    void bbmd_fdt_init(void);
+
+    BACNET_STACK_EXPORT
+    BACNET_IP_FOREIGN_DEVICE_TABLE_ENTRY *bbmd_fdt_list(void);
+
+    BACNET_STACK_EXPORT
+    BACNET_IP_FOREIGN_DEVICE_TABLE_ENTRY *bbmd_fdt_entry(
+        const BACNET_IP_ADDRESS *addr);
+
+    BACNET_STACK_EXPORT
+    bool bbmd_fdt_entry_add(
+        const BACNET_IP_ADDRESS *addr, uint16_t ttl_seconds);
+
+    BACNET_STACK_EXPORT
+    bool bbmd_fdt_entry_delete(const BACNET_IP_ADDRESS *addr);
+
+    BACNET_STACK_EXPORT
+    void bbmd_fdt_maintenance_timer(uint16_t seconds);
+
+    BACNET_STACK_EXPORT
+    unsigned bbmd_fdt_count(void);
+
+    BACNET_STACK_EXPORT
+    unsigned bbmd_fdt_size(void);
+
+    BACNET_STACK_EXPORT
+    const BACNET_IP_ADDRESS *bbmd_fdt_address(unsigned index);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+#endif
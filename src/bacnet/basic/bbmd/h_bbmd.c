@@ -41,8 +41,10 @@
 #include "bacnet/datalink/bip.h"
 #include "bacnet/datalink/bvlc.h"
 #include "bacnet/basic/sys/debug.h"
+#include "bacnet/basic/sys/mstimer.h"
 #include "bacnet/basic/object/device.h"
 #include "bacnet/basic/bbmd/h_bbmd.h"
+#include "bacnet/basic/bbmd/fdt.h"
 
 /* Define BBMD_ENABLED to get the functions that a
  * BBMD needs to handle its services.
@@ -77,6 +79,26 @@ static bool BVLC_NAT_Handling = false;
 static BACNET_IP_ADDRESS Remote_BBMD;
 /** if we are a foreign device, store the Time-To-Live Seconds here */
 static uint16_t Remote_BBMD_TTL_Seconds;
+/* recently received broadcast NPDU, to detect the copies that arrive
+   directly and as a Forwarded-NPDU */
+#ifndef BVLC_DUPLICATE_CACHE_SIZE
+#define BVLC_DUPLICATE_CACHE_SIZE 16
+#endif
+/* default window in milliseconds - 0 disables the detection */
+#ifndef BVLC_DUPLICATE_WINDOW_MS
+#define BVLC_DUPLICATE_WINDOW_MS 0
+#endif
+struct BVLC_Duplicate_Entry {
+    uint8_t mac[BIP_ADDRESS_MAX];
+    uint16_t npdu_len;
+    uint32_t npdu_hash;
+    unsigned long timestamp;
+};
+static struct BVLC_Duplicate_Entry
+    BVLC_Duplicate_Cache[BVLC_DUPLICATE_CACHE_SIZE];
+static unsigned BVLC_Duplicate_Index;
+static uint16_t BVLC_Duplicate_Window_ms = BVLC_DUPLICATE_WINDOW_MS;
+static BVLC_DUPLICATE_STATISTICS BVLC_Duplicate_Statistics;
 #if BBMD_ENABLED
 /* local buffer & length for sending */
 static uint8_t BVLC_Buffer[BIP_MPDU_MAX];
@@ -87,11 +109,14 @@ static uint16_t BVLC_Buffer_Len;
 #endif
 static BACNET_IP_BROADCAST_DISTRIBUTION_TABLE_ENTRY
     BBMD_Table[MAX_BBMD_ENTRIES];
-/* Foreign Device Table */
-#ifndef MAX_FD_ENTRIES
-#define MAX_FD_ENTRIES 128
+/* Foreign Device Table - see fdt.c */
+/* Forwarded-NPDU fan-out destinations, sent in batches */
+#ifndef BBMD_FAN_OUT_BATCH
+#define BBMD_FAN_OUT_BATCH 32
 #endif
-static BACNET_IP_FOREIGN_DEVICE_TABLE_ENTRY FD_Table[MAX_FD_ENTRIES];
+static BACNET_IP_ADDRESS BBMD_Fan_Out_Dest[BBMD_FAN_OUT_BATCH];
+static unsigned BBMD_Fan_Out_Count;
+static BVLC_FAN_OUT_STATISTICS BVLC_Fan_Out_Statistics;
 #endif
 
 /**
@@ -254,7 +279,7 @@ void bvlc_bdt_restore_local(void)
 void bvlc_maintenance_timer(uint16_t seconds)
 {
 #if BBMD_ENABLED
-    bvlc_foreign_device_table_maintenance_timer(&FD_Table[0], seconds);
+    bbmd_fdt_maintenance_timer(seconds);
 #endif
 }
 
@@ -314,159 +339,195 @@ static bool bbmd_bdt_member_mask_is_unicast(BACNET_IP_ADDRESS *addr)
     return unicast;
 }
 
-/** Send a BVLL Forwarded-NPDU message on its local IP subnet using
- * the local B/IP broadcast address as the destination address.
+/** Encode a BVLL Forwarded-NPDU message
  *
+ * @param mtu - buffer for the Forwarded-NPDU
+ * @param mtu_size - size of the buffer
  * @param bip_src - source IP address and UDP port
- * @param npdu - returns the NPDU
- * @param max_npdu - amount of space available in the NPDU
+ * @param npdu - the NPDU
  * @param npdu_length - reported length of the NPDU
+ * @param original - was the message an original (not forwarded)
  * @return number of bytes encoded in the Forwarded NPDU
  */
-static uint16_t bbmd_forward_npdu(
-    BACNET_IP_ADDRESS *bip_src, uint8_t *npdu, uint16_t npdu_length)
+static uint16_t bbmd_forwarded_npdu_encode(uint8_t *mtu,
+    uint16_t mtu_size,
+    BACNET_IP_ADDRESS *bip_src,
+    uint8_t *npdu,
+    uint16_t npdu_length,
+    bool original)
 {
-    BACNET_IP_ADDRESS broadcast_address = { 0 };
-    uint8_t mtu[BIP_MPDU_MAX] = { 0 };
-    uint16_t mtu_len = 0;
+    /* If we are forwarding an original broadcast message and the NAT
+     * handling is enabled, change the source address to NAT routers
+     * global IP address so the recipient can reply (local IP address
+     * is not accessible from internet side.
+     *
+     * If we are forwarding a message from peer BBMD or foreign device
+     * or the NAT handling is disabled, leave the source address as is.
+     */
+    if (BVLC_NAT_Handling && original) {
+        return (uint16_t)bvlc_encode_forwarded_npdu(
+            mtu, mtu_size, &BVLC_Global_Address, npdu, npdu_length);
+    }
 
-    mtu_len = (uint16_t)bvlc_encode_forwarded_npdu(
-        &mtu[0], (uint16_t)sizeof(mtu), bip_src, npdu, npdu_length);
-    if (mtu_len > 0) {
-        bip_get_broadcast_addr(&broadcast_address);
-        bip_send_mpdu(&broadcast_address, mtu, mtu_len);
-        debug_printf("BVLC: Sent Forwarded-NPDU as local broadcast.\n");
+    return (uint16_t)bvlc_encode_forwarded_npdu(
+        mtu, mtu_size, bip_src, npdu, npdu_length);
+}
+
+/** Send the queued fan-out destinations the same Forwarded-NPDU
+ *
+ * @param mtu - the Forwarded-NPDU
+ * @param mtu_len - number of bytes in the Forwarded-NPDU
+ */
+static void bbmd_fan_out_flush(uint8_t *mtu, uint16_t mtu_len)
+{
+    int sent = 0;
+
+    if (BBMD_Fan_Out_Count == 0) {
+        return;
+    }
+    sent = bip_send_mpdu_list(
+        &BBMD_Fan_Out_Dest[0], BBMD_Fan_Out_Count, mtu, mtu_len);
+    if (sent < 0) {
+        sent = 0;
     }
+    BVLC_Fan_Out_Statistics.datagrams += (unsigned)sent;
+    BVLC_Fan_Out_Statistics.drops += BBMD_Fan_Out_Count - (unsigned)sent;
+    BBMD_Fan_Out_Count = 0;
+}
 
-    return mtu_len;
+/** Queue a fan-out destination for the Forwarded-NPDU
+ *
+ * @param dest - BDT or FDT destination IP address and UDP port
+ * @param bip_src - source IP address and UDP port
+ * @param my_addr - IP address and UDP port of this BBMD
+ * @param mtu - the Forwarded-NPDU
+ * @param mtu_len - number of bytes in the Forwarded-NPDU
+ */
+static void bbmd_fan_out_add(BACNET_IP_ADDRESS *dest,
+    BACNET_IP_ADDRESS *bip_src,
+    BACNET_IP_ADDRESS *my_addr,
+    uint8_t *mtu,
+    uint16_t mtu_len)
+{
+    if (!bvlc_address_different(dest, my_addr)) {
+        /* don't forward to our selves */
+        return;
+    }
+    if (!bvlc_address_different(dest, bip_src)) {
+        /* don't forward back to origin */
+        return;
+    }
+    if (BVLC_NAT_Handling) {
+        if (bvlc_address_different(dest, &BVLC_Global_Address)) {
+            /* NAT router port forwards BACnet packets from global IP.
+               Packets sent to that global IP by us would end up back,
+               creating a loop. */
+            return;
+        }
+    }
+    bvlc_address_copy(&BBMD_Fan_Out_Dest[BBMD_Fan_Out_Count], dest);
+    BBMD_Fan_Out_Count++;
+    debug_print_bip("Send Forwarded-NPDU", dest);
+    if (BBMD_Fan_Out_Count >= BBMD_FAN_OUT_BATCH) {
+        bbmd_fan_out_flush(mtu, mtu_len);
+    }
 }
 
-/** Sends all Broadcast Devices a Forwarded NPDU
+/** Sends a Forwarded-NPDU, already encoded, to all Foreign Devices
+ * and optionally to all Broadcast Devices.
  *
  * @param bip_src - source IP address and UDP port
- * @param npdu - returns the NPDU
- * @param max_npdu - amount of space available in the NPDU
- * @param npdu_length - reported length of the NPDU
- * @param original - was the message an original (not forwarded)
- * @return number of bytes encoded in the Forwarded NPDU
+ * @param mtu - the Forwarded-NPDU
+ * @param mtu_len - number of bytes in the Forwarded-NPDU
+ * @param bdt - true if the BDT entries are sent the message too
  */
-static uint16_t bbmd_bdt_forward_npdu(BACNET_IP_ADDRESS *bip_src,
-    uint8_t *npdu,
-    uint16_t npdu_length,
-    bool original)
+static void bbmd_fan_out(BACNET_IP_ADDRESS *bip_src,
+    uint8_t *mtu,
+    uint16_t mtu_len,
+    bool bdt)
 {
-    uint8_t mtu[BIP_MPDU_MAX] = { 0 };
-    uint16_t mtu_len = 0;
     unsigned i = 0; /* loop counter */
+    unsigned count = 0;
     BACNET_IP_ADDRESS bip_dest = { 0 };
     BACNET_IP_ADDRESS my_addr = { 0 };
+    unsigned long start = mstimer_now();
+    unsigned long latency = 0;
 
+    if (mtu_len == 0) {
+        return;
+    }
     bip_get_addr(&my_addr);
-    /* If we are forwarding an original broadcast message and the NAT
-     * handling is enabled, change the source address to NAT routers
-     * global IP address so the recipient can reply (local IP address
-     * is not accessible from internet side.
-     *
-     * If we are forwarding a message from peer BBMD or foreign device
-     * or the NAT handling is disabled, leave the source address as is.
-     */
-    if (BVLC_NAT_Handling && original) {
-        mtu_len = (uint16_t)bvlc_encode_forwarded_npdu(&mtu[0],
-            (uint16_t)sizeof(mtu), &BVLC_Global_Address, npdu, npdu_length);
-    } else {
-        mtu_len = (uint16_t)bvlc_encode_forwarded_npdu(
-            &mtu[0], (uint16_t)sizeof(mtu), bip_src, npdu, npdu_length);
+    /* the registered foreign devices */
+    count = bbmd_fdt_count();
+    for (i = 0; i < count; i++) {
+        bvlc_address_copy(&bip_dest, bbmd_fdt_address(i));
+        bbmd_fan_out_add(&bip_dest, bip_src, &my_addr, mtu, mtu_len);
     }
-    /* loop through the BDT and send one to each entry */
-    for (i = 0; i < MAX_BBMD_ENTRIES; i++) {
-        if (BBMD_Table[i].valid) {
-            bvlc_broadcast_distribution_table_entry_forward_address(
-                &bip_dest, &BBMD_Table[i]);
-            if (!bvlc_address_different(&bip_dest, &my_addr)) {
-                /* don't forward to our selves */
-                continue;
-            }
-            if (!bvlc_address_different(&bip_dest, bip_src)) {
-                /* don't forward back to origin */
-                continue;
-            }
-            if (BVLC_NAT_Handling) {
-                if (bvlc_address_different(&bip_dest, &BVLC_Global_Address)) {
-                    /* NAT router port forwards BACnet packets from global IP.
-                       Packets sent to that global IP by us would end up back,
-                       creating a loop. */
-                    continue;
-                }
+    if (bdt) {
+        for (i = 0; i < MAX_BBMD_ENTRIES; i++) {
+            if (BBMD_Table[i].valid) {
+                bvlc_broadcast_distribution_table_entry_forward_address(
+                    &bip_dest, &BBMD_Table[i]);
+                bbmd_fan_out_add(&bip_dest, bip_src, &my_addr, mtu, mtu_len);
             }
-            bip_send_mpdu(&bip_dest, mtu, mtu_len);
-            debug_print_bip("BDT Send Forwarded-NPDU", &bip_dest);
         }
     }
+    bbmd_fan_out_flush(mtu, mtu_len);
+    latency = mstimer_now() - start;
+    BVLC_Fan_Out_Statistics.broadcasts++;
+    BVLC_Fan_Out_Statistics.latency_ms = latency;
+    if (latency > BVLC_Fan_Out_Statistics.latency_max_ms) {
+        BVLC_Fan_Out_Statistics.latency_max_ms = latency;
+    }
+}
+
+/** Send a BVLL Forwarded-NPDU message on its local IP subnet using
+ * the local B/IP broadcast address as the destination address,
+ * and to all Broadcast Devices and Foreign Devices.
+ *
+ * @param bip_src - source IP address and UDP port
+ * @param npdu - the NPDU
+ * @param npdu_length - reported length of the NPDU
+ * @return number of bytes encoded in the Forwarded NPDU
+ */
+static uint16_t bbmd_forward_npdu(
+    BACNET_IP_ADDRESS *bip_src, uint8_t *npdu, uint16_t npdu_length)
+{
+    BACNET_IP_ADDRESS broadcast_address = { 0 };
+    uint8_t mtu[BIP_MPDU_MAX] = { 0 };
+    uint16_t mtu_len = 0;
+
+    mtu_len = bbmd_forwarded_npdu_encode(
+        &mtu[0], (uint16_t)sizeof(mtu), bip_src, npdu, npdu_length, false);
+    if (mtu_len > 0) {
+        bip_get_broadcast_addr(&broadcast_address);
+        bip_send_mpdu(&broadcast_address, mtu, mtu_len);
+        debug_printf("BVLC: Sent Forwarded-NPDU as local broadcast.\n");
+        bbmd_fan_out(bip_src, mtu, mtu_len, true);
+    }
 
     return mtu_len;
 }
 
-/** Sends all Foreign Devices a Forwarded NPDU
+/** Sends all Broadcast Devices and Foreign Devices a Forwarded NPDU
  *
  * @param bip_src - source IP address and UDP port
- * @param npdu - returns the NPDU
- * @param max_npdu - amount of space available in the NPDU
+ * @param npdu - the NPDU
  * @param npdu_length - reported length of the NPDU
  * @param original - was the message an original (not forwarded)
  * @return number of bytes encoded in the Forwarded NPDU
  */
-static uint16_t bbmd_fdt_forward_npdu(BACNET_IP_ADDRESS *bip_src,
+static uint16_t bbmd_bdt_fdt_forward_npdu(BACNET_IP_ADDRESS *bip_src,
     uint8_t *npdu,
     uint16_t npdu_length,
     bool original)
 {
     uint8_t mtu[BIP_MPDU_MAX] = { 0 };
     uint16_t mtu_len = 0;
-    unsigned i = 0; /* loop counter */
-    BACNET_IP_ADDRESS bip_dest = { 0 };
-    BACNET_IP_ADDRESS my_addr = { 0 };
-
-    bip_get_addr(&my_addr);
-    /* If we are forwarding an original broadcast message and the NAT
-     * handling is enabled, change the source address to NAT routers
-     * global IP address so the recipient can reply (local IP address
-     * is not accessible from internet side.
-     *
-     * If we are forwarding a message from peer BBMD or foreign device
-     * or the NAT handling is disabled, leave the source address as is.
-     */
-    if (BVLC_NAT_Handling && original) {
-        mtu_len = (uint16_t)bvlc_encode_forwarded_npdu(&mtu[0],
-            (uint16_t)sizeof(mtu), &BVLC_Global_Address, npdu, npdu_length);
-    } else {
-        mtu_len = (uint16_t)bvlc_encode_forwarded_npdu(
-            &mtu[0], (uint16_t)sizeof(mtu), bip_src, npdu, npdu_length);
-    }
 
-    /* loop through the FDT and send one to each entry */
-    for (i = 0; i < MAX_FD_ENTRIES; i++) {
-        if (FD_Table[i].valid && FD_Table[i].ttl_seconds_remaining) {
-            bvlc_address_copy(&bip_dest, &FD_Table[i].dest_address);
-            if (!bvlc_address_different(&bip_dest, &my_addr)) {
-                /* don't forward to our selves */
-                continue;
-            }
-            if (!bvlc_address_different(&bip_dest, bip_src)) {
-                /* don't forward back to origin */
-                continue;
-            }
-            if (BVLC_NAT_Handling) {
-                if (bvlc_address_different(&bip_dest, &BVLC_Global_Address)) {
-                    /* NAT router port forwards BACnet packets from global IP.
-                       Packets sent to that global IP by us would end up back,
-                       creating a loop. */
-                    continue;
-                }
-            }
-            bip_send_mpdu(&bip_dest, mtu, mtu_len);
-            debug_print_bip("FDT Send Forwarded-NPDU", &bip_dest);
-        }
-    }
+    mtu_len = bbmd_forwarded_npdu_encode(
+        &mtu[0], (uint16_t)sizeof(mtu), bip_src, npdu, npdu_length, original);
+    bbmd_fan_out(bip_src, mtu, mtu_len, true);
 
     return mtu_len;
 }
@@ -602,8 +663,8 @@ int bvlc_send_pdu(BACNET_ADDRESS *dest,
 #if BBMD_ENABLED
             if (mtu_len > 0) {
                 bip_get_addr(&bip_src);
-                (void)bbmd_fdt_forward_npdu(&bip_src, pdu, pdu_len, true);
-                (void)bbmd_bdt_forward_npdu(&bip_src, pdu, pdu_len, true);
+                (void)bbmd_bdt_fdt_forward_npdu(
+                    &bip_src, pdu, pdu_len, true);
             }
 #endif
         }
@@ -939,7 +1000,8 @@ int bvlc_bbmd_enabled_handler(BACNET_IP_ADDRESS *addr,
                     the BBMD's FDT. */
                 offset = header_len + function_len - npdu_len;
                 npdu = &mtu[offset];
-                (void)bbmd_fdt_forward_npdu(&fwd_address, npdu, npdu_len, false);
+                bbmd_fan_out(&fwd_address, mtu,
+                    (uint16_t)(header_len + function_len), false);
                 /* prepare the message for me! */
                 bvlc_ip_address_to_bacnet_local(src, &fwd_address);
                 debug_print_npdu("Forwarded-NPDU", offset, npdu_len);
@@ -959,8 +1021,7 @@ int bvlc_bbmd_enabled_handler(BACNET_IP_ADDRESS *addr,
             function_len =
                 bvlc_decode_register_foreign_device(pdu, pdu_len, &ttl_seconds);
             if (function_len) {
-                if (bvlc_foreign_device_table_entry_add(
-                        &FD_Table[0], addr, ttl_seconds)) {
+                if (bbmd_fdt_entry_add(addr, ttl_seconds)) {
                     result_code = BVLC_RESULT_SUCCESSFUL_COMPLETION;
                     send_result = true;
                 } else {
@@ -981,7 +1042,7 @@ int bvlc_bbmd_enabled_handler(BACNET_IP_ADDRESS *addr,
                with a result code of X'0040' indicating that the read attempt
                has failed. */
             BVLC_Buffer_Len = bvlc_encode_read_foreign_device_table_ack(
-                BVLC_Buffer, sizeof(BVLC_Buffer), &FD_Table[0]);
+                BVLC_Buffer, sizeof(BVLC_Buffer), bbmd_fdt_list());
             if (BVLC_Buffer_Len > 0) {
                 bip_send_mpdu(addr, BVLC_Buffer, BVLC_Buffer_Len);
             } else {
@@ -1010,8 +1071,7 @@ int bvlc_bbmd_enabled_handler(BACNET_IP_ADDRESS *addr,
             function_len =
                 bvlc_decode_delete_foreign_device(pdu, pdu_len, &fwd_address);
             if (function_len > 0) {
-                if (bvlc_foreign_device_table_entry_delete(
-                        &FD_Table[0], &fwd_address)) {
+                if (bbmd_fdt_entry_delete(&fwd_address)) {
                     result_code = BVLC_RESULT_SUCCESSFUL_COMPLETION;
                     send_result = true;
                 } else {
@@ -1041,10 +1101,7 @@ int bvlc_bbmd_enabled_handler(BACNET_IP_ADDRESS *addr,
                with a result code of X'0060' indicating that the forwarding
                attempt was unsuccessful */
             npdu_len = bbmd_forward_npdu(addr, pdu, pdu_len);
-            if (npdu_len > 0) {
-                (void)bbmd_fdt_forward_npdu(addr, pdu, pdu_len, false);
-                (void)bbmd_bdt_forward_npdu(addr, pdu, pdu_len, false);
-            } else {
+            if (npdu_len == 0) {
                 result_code = BVLC_RESULT_DISTRIBUTE_BROADCAST_TO_NETWORK_NAK;
                 send_result = true;
             }
@@ -1108,8 +1165,8 @@ int bvlc_bbmd_enabled_handler(BACNET_IP_ADDRESS *addr,
                     debug_print_string("Original-Broadcast-NPDU: "
                                        "Confirmed Service! Discard!");
                 } else {
-                    (void)bbmd_fdt_forward_npdu(addr, npdu, npdu_len, true);
-                    (void)bbmd_bdt_forward_npdu(addr, npdu, npdu_len, true);
+                    (void)bbmd_bdt_fdt_forward_npdu(
+                        addr, npdu, npdu_len, true);
                     debug_print_npdu(
                         "Original-Broadcast-NPDU", offset, npdu_len);
                 }
@@ -1134,6 +1191,60 @@ int bvlc_bbmd_enabled_handler(BACNET_IP_ADDRESS *addr,
 }
 #endif
 
+/**
+ * @brief Determine if a broadcast NPDU was already received from the
+ *  same source within the duplicate window, and remember it if not.
+ * @param src - BACnet source address of the NPDU
+ * @param npdu - the NPDU
+ * @param npdu_len - number of bytes in the NPDU
+ * @return true if the NPDU is a duplicate
+ */
+static bool bvlc_duplicate_npdu(
+    BACNET_ADDRESS *src, uint8_t *npdu, uint16_t npdu_len)
+{
+    struct BVLC_Duplicate_Entry *entry = NULL;
+    unsigned long now = 0;
+    uint32_t hash = 2166136261UL;
+    unsigned i = 0;
+
+    if ((BVLC_Duplicate_Window_ms == 0) || (src->mac_len != 6)) {
+        return false;
+    }
+    if ((BVLC_Function_Code != BVLC_ORIGINAL_BROADCAST_NPDU) &&
+        (BVLC_Function_Code != BVLC_FORWARDED_NPDU)) {
+        return false;
+    }
+    BVLC_Duplicate_Statistics.checked++;
+    /* FNV-1a */
+    for (i = 0; i < npdu_len; i++) {
+        hash ^= npdu[i];
+        hash *= 16777619UL;
+    }
+    now = mstimer_now();
+    for (i = 0; i < BVLC_DUPLICATE_CACHE_SIZE; i++) {
+        entry = &BVLC_Duplicate_Cache[i];
+        if ((entry->npdu_len == npdu_len) && (entry->npdu_hash == hash) &&
+            (memcmp(entry->mac, src->mac, BIP_ADDRESS_MAX) == 0) &&
+            ((now - entry->timestamp) < BVLC_Duplicate_Window_ms)) {
+            BVLC_Duplicate_Statistics.dropped++;
+            debug_print_string("Duplicate broadcast NPDU dropped.");
+            return true;
+        }
+    }
+    /* replace the oldest entry */
+    entry = &BVLC_Duplicate_Cache[BVLC_Duplicate_Index];
+    memcpy(entry->mac, src->mac, BIP_ADDRESS_MAX);
+    entry->npdu_len = npdu_len;
+    entry->npdu_hash = hash;
+    entry->timestamp = now;
+    BVLC_Duplicate_Index++;
+    if (BVLC_Duplicate_Index >= BVLC_DUPLICATE_CACHE_SIZE) {
+        BVLC_Duplicate_Index = 0;
+    }
+
+    return false;
+}
+
 /**
  * Use this handler for BACnet/IPv4 BVLC
  *
@@ -1149,13 +1260,63 @@ int bvlc_handler(BACNET_IP_ADDRESS *addr,
     uint8_t *npdu,
     uint16_t npdu_len)
 {
+    int offset = 0;
+
 #if BBMD_ENABLED
     debug_print_bip("Received BVLC (BBMD Enabled)", addr);
-    return bvlc_bbmd_enabled_handler(addr, src, npdu, npdu_len);
+    offset = bvlc_bbmd_enabled_handler(addr, src, npdu, npdu_len);
 #else
     debug_print_bip("Received BVLC (BBMD Disabled)", addr);
-    return bvlc_bbmd_disabled_handler(addr, src, npdu, npdu_len);
+    offset = bvlc_bbmd_disabled_handler(addr, src, npdu, npdu_len);
 #endif
+    if ((offset > 0) && (offset < npdu_len)) {
+        /* the BBMD forwarding is already done - only the local
+           processing of a duplicate broadcast is skipped */
+        if (bvlc_duplicate_npdu(
+                src, &npdu[offset], (uint16_t)(npdu_len - offset))) {
+            offset = 0;
+        }
+    }
+
+    return offset;
+}
+
+/**
+ * @brief Set the window for broadcast NPDU duplicate detection
+ * @param milliseconds - window, or 0 to disable the detection
+ */
+void bvlc_duplicate_window_set(uint16_t milliseconds)
+{
+    BVLC_Duplicate_Window_ms = milliseconds;
+    memset(BVLC_Duplicate_Cache, 0, sizeof(BVLC_Duplicate_Cache));
+}
+
+/**
+ * @brief Get the window for broadcast NPDU duplicate detection
+ * @return window in milliseconds, or 0 if the detection is disabled
+ */
+uint16_t bvlc_duplicate_window(void)
+{
+    return BVLC_Duplicate_Window_ms;
+}
+
+/**
+ * @brief Get the broadcast NPDU duplicate detection counters
+ * @param statistics - [out] copy of the counters
+ */
+void bvlc_duplicate_statistics(BVLC_DUPLICATE_STATISTICS *statistics)
+{
+    if (statistics) {
+        *statistics = BVLC_Duplicate_Statistics;
+    }
+}
+
+/**
+ * @brief Reset the broadcast NPDU duplicate detection counters
+ */
+void bvlc_duplicate_statistics_clear(void)
+{
+    memset(&BVLC_Duplicate_Statistics, 0, sizeof(BVLC_Duplicate_Statistics));
 }
 
 int bvlc_broadcast_handler(BACNET_IP_ADDRESS *addr,
@@ -1320,7 +1481,7 @@ void bvlc_set_function_code(uint8_t function_code)
  */
 BACNET_IP_FOREIGN_DEVICE_TABLE_ENTRY *bvlc_fdt_list(void)
 {
-    return &FD_Table[0];
+    return bbmd_fdt_list();
 }
 
 /**
@@ -1341,6 +1502,25 @@ void bvlc_bdt_list_clear(void)
     /* BDT changed! Save backup to file */
     bvlc_bdt_backup_local();
 }
+
+/**
+ * @brief Get the Forwarded-NPDU fan-out counters
+ * @param statistics - [out] copy of the counters
+ */
+void bvlc_fan_out_statistics(BVLC_FAN_OUT_STATISTICS *statistics)
+{
+    if (statistics) {
+        *statistics = BVLC_Fan_Out_Statistics;
+    }
+}
+
+/**
+ * @brief Reset the Forwarded-NPDU fan-out counters
+ */
+void bvlc_fan_out_statistics_clear(void)
+{
+    memset(&BVLC_Fan_Out_Statistics, 0, sizeof(BVLC_Fan_Out_Statistics));
+}
 #endif
 
 /**
@@ -1380,7 +1560,7 @@ void bvlc_init(void)
     debug_print_string("Initializing (BBMD Enabled).");
     bvlc_broadcast_distribution_table_link_array(
         &BBMD_Table[0], MAX_BBMD_ENTRIES);
-    bvlc_foreign_device_table_link_array(&FD_Table[0], MAX_FD_ENTRIES);
+    bbmd_fdt_init();
 #else
     debug_print_string("Initializing (BBMD Disabled).");
 #endif
@@ -36,6 +36,34 @@
 #include "bacnet/bacdef.h"
 #include "bacnet/datalink/bvlc.h"
 
+/**
+ * Counters for the Forwarded-NPDU fan-out of a BBMD to its
+ * BDT and FDT entries
+ */
+typedef struct BVLC_Fan_Out_Statistics {
+    /* number of fan-outs */
+    unsigned long broadcasts;
+    /* number of Forwarded-NPDU datagrams sent */
+    unsigned long datagrams;
+    /* number of Forwarded-NPDU datagrams that could not be sent */
+    unsigned long drops;
+    /* milliseconds taken by the last fan-out */
+    unsigned long latency_ms;
+    /* milliseconds taken by the slowest fan-out */
+    unsigned long latency_max_ms;
+} BVLC_FAN_OUT_STATISTICS;
+
+/**
+ * Counters for the detection of duplicate broadcast NPDU that arrive
+ * both directly and as a Forwarded-NPDU
+ */
+typedef struct BVLC_Duplicate_Statistics {
+    /* number of broadcast NPDU that were checked */
+    unsigned long checked;
+    /* number of duplicate broadcast NPDU that were dropped */
+    unsigned long dropped;
+} BVLC_DUPLICATE_STATISTICS;
+
 #ifdef __cplusplus
 extern "C" {
 #endif /* __cplusplus */
@@ -154,6 +182,28 @@ void bvlc_set_global_address_for_nat(const BACNET_IP_ADDRESS *addr);
 BACNET_STACK_EXPORT
 void bvlc_disable_nat(void);
 
+/* Get the Forwarded-NPDU fan-out counters */
+BACNET_STACK_EXPORT
+void bvlc_fan_out_statistics(BVLC_FAN_OUT_STATISTICS *statistics);
+
+/* Reset the Forwarded-NPDU fan-out counters */
+BACNET_STACK_EXPORT
+void bvlc_fan_out_statistics_clear(void);
+
+/* Set the duplicate broadcast NPDU detection window.
+ * Zero milliseconds disables the detection.
+ */
+BACNET_STACK_EXPORT
+void bvlc_duplicate_window_set(uint16_t milliseconds);
+BACNET_STACK_EXPORT
+uint16_t bvlc_duplicate_window(void);
+
+/* Get or reset the duplicate broadcast NPDU detection counters */
+BACNET_STACK_EXPORT
+void bvlc_duplicate_statistics(BVLC_DUPLICATE_STATISTICS *statistics);
+BACNET_STACK_EXPORT
+void bvlc_duplicate_statistics_clear(void);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
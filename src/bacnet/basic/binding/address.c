@@ -36,6 +36,7 @@
 #include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include "bacnet/bits.h"
 #include "bacnet/config.h"
 #include "bacnet/bacaddr.h"
@@ -44,6 +45,7 @@
 #include "bacnet/readrange.h"
 #include "bacnet/basic/binding/address.h"
 #include "bacnet/basic/binding/address.h"
+#include "bacnet/basic/npdu/npdu_cache.h"
 
 /* we are likely compiling the demo command line tools if print enabled */
 #if !defined(BACNET_ADDRESS_CACHE_FILE)
@@ -58,25 +60,10 @@
 /* occurs in BACnet.  A device id is bound to a MAC address. */
 /* The normal method is using Who-Is, and using the data from I-Am */
 
-static uint32_t Top_Protected_Entry;
-static uint32_t Own_Device_ID = 0xFFFFFFFF;
-
-/* The address cache is used for binding to BACnet devices */
-/* The number of entries corresponds to the number of */
-/* devices that might respond to an I-Am on the network. */
-/* If your device is a simple server and does not need to bind, */
-/* then you don't need to use this. */
-#if !defined(MAX_ADDRESS_CACHE)
-#define MAX_ADDRESS_CACHE 255
-#endif
-
-static struct Address_Cache_Entry {
-    uint8_t Flags;
-    uint32_t device_id;
-    unsigned max_apdu;
-    BACNET_ADDRESS address;
-    uint32_t TimeToLive;
-} Address_Cache[MAX_ADDRESS_CACHE];
+/* The default context is used until another one is selected. */
+static BACNET_ADDRESS_CACHE_CONTEXT Default_Cache = { { { 0 } }, 0,
+    0xFFFFFFFF };
+static BACNET_ADDRESS_CACHE_CONTEXT *Cache = &Default_Cache;
 
 /* State flags for cache entries */
 
@@ -98,6 +85,43 @@ static struct Address_Cache_Entry {
 #define BAC_ADDR_SHORT_TIME BAC_ADDR_SECS_1HOUR
 #define BAC_ADDR_FOREVER 0xFFFFFFFF /* Permanent entry */
 
+/**
+ * @brief Initialize an address cache context to an empty cache.
+ *
+ * @param context  the address cache context to initialize
+ */
+void address_context_init(BACNET_ADDRESS_CACHE_CONTEXT *context)
+{
+    if (context) {
+        memset(context, 0, sizeof(BACNET_ADDRESS_CACHE_CONTEXT));
+        context->Own_Device_ID = 0xFFFFFFFF;
+    }
+}
+
+/**
+ * @brief Select the address cache context used by the address_ functions.
+ *
+ * @param context  the address cache context, or NULL to use the default
+ */
+void address_context_set(BACNET_ADDRESS_CACHE_CONTEXT *context)
+{
+    if (context) {
+        Cache = context;
+    } else {
+        Cache = &Default_Cache;
+    }
+}
+
+/**
+ * @brief Get the address cache context used by the address_ functions.
+ *
+ * @return the current address cache context
+ */
+BACNET_ADDRESS_CACHE_CONTEXT *address_context(void)
+{
+    return Cache;
+}
+
 /**
  * @brief Set the index of the first (top) address being protected.
  *
@@ -106,7 +130,7 @@ static struct Address_Cache_Entry {
 void address_protected_entry_index_set(uint32_t top_protected_entry_index)
 {
     if (top_protected_entry_index <= (MAX_ADDRESS_CACHE - 1)) {
-        Top_Protected_Entry = top_protected_entry_index;
+        Cache->Top_Protected_Entry = top_protected_entry_index;
     }
 }
 
@@ -117,7 +141,7 @@ void address_protected_entry_index_set(uint32_t top_protected_entry_index)
  */
 void address_own_device_id_set(uint32_t own_id)
 {
-    Own_Device_ID = own_id;
+    Cache->Own_Device_ID = own_id;
 }
 
 /**
@@ -185,12 +209,13 @@ void address_remove_device(uint32_t device_id)
     uint32_t index = 0;
 
     for (index = 0; index < MAX_ADDRESS_CACHE; index++) {
-        pMatch = &Address_Cache[index];
+        pMatch = &Cache->Entries[index];
         if (((pMatch->Flags & BAC_ADDR_IN_USE) != 0) &&
             (pMatch->device_id == device_id)) {
             pMatch->Flags = 0;
-            if (index < Top_Protected_Entry) {
-                Top_Protected_Entry--;
+            npdu_cache_invalidate();
+            if (index < Cache->Top_Protected_Entry) {
+                Cache->Top_Protected_Entry--;
             }
             break;
         }
@@ -216,7 +241,7 @@ static struct Address_Cache_Entry *address_remove_oldest(void)
     unsigned index;
 
     pCandidate = NULL;
-    if (Top_Protected_Entry > (MAX_ADDRESS_CACHE - 1)) {
+    if (Cache->Top_Protected_Entry > (MAX_ADDRESS_CACHE - 1)) {
         return pCandidate;
     }
     /* Longest possible non static time to live */
@@ -224,8 +249,9 @@ static struct Address_Cache_Entry *address_remove_oldest(void)
 
     /* First pass - try only in use and bound entries */
 
-    for (index = Top_Protected_Entry; index < MAX_ADDRESS_CACHE; index++) {
-        pMatch = &Address_Cache[index];
+    for (index = Cache->Top_Protected_Entry; index < MAX_ADDRESS_CACHE;
+         index++) {
+        pMatch = &Cache->Entries[index];
         if ((pMatch->Flags &
                 (BAC_ADDR_IN_USE | BAC_ADDR_BIND_REQ | BAC_ADDR_STATIC)) ==
             BAC_ADDR_IN_USE) {
@@ -242,12 +268,13 @@ static struct Address_Cache_Entry *address_remove_oldest(void)
         pCandidate->Flags = BAC_ADDR_RESERVED;
         /* only reserve it for a short while */
         pCandidate->TimeToLive = BAC_ADDR_SHORT_TIME;
+        npdu_cache_invalidate();
         return (pCandidate);
     }
 
     /* Second pass - try in use and un bound as last resort */
     for (index = 0; index < MAX_ADDRESS_CACHE; index++) {
-        pMatch = &Address_Cache[index];
+        pMatch = &Cache->Entries[index];
         if ((pMatch->Flags &
                 (BAC_ADDR_IN_USE | BAC_ADDR_BIND_REQ | BAC_ADDR_STATIC)) ==
             ((uint8_t)(BAC_ADDR_IN_USE | BAC_ADDR_BIND_REQ))) {
@@ -409,9 +436,10 @@ void address_init(void)
     struct Address_Cache_Entry *pMatch;
     unsigned index;
 
-    Top_Protected_Entry = 0;
+    Cache->Top_Protected_Entry = 0;
+    npdu_cache_invalidate();
     for (index = 0; index < MAX_ADDRESS_CACHE; index++) {
-        pMatch = &Address_Cache[index];
+        pMatch = &Cache->Entries[index];
         pMatch->Flags = 0;
     }
 #ifdef BACNET_ADDRESS_CACHE_FILE
@@ -432,8 +460,9 @@ void address_init_partial(void)
     struct Address_Cache_Entry *pMatch;
     unsigned index;
 
+    npdu_cache_invalidate();
     for (index = 0; index < MAX_ADDRESS_CACHE; index++) {
-        pMatch = &Address_Cache[index];
+        pMatch = &Cache->Entries[index];
         if ((pMatch->Flags & BAC_ADDR_IN_USE) != 0) {
             /* It's in use so let's check further */
             if (((pMatch->Flags & BAC_ADDR_BIND_REQ) != 0) ||
@@ -471,7 +500,7 @@ void address_set_device_TTL(
     unsigned index;
 
     for (index = 0; index < MAX_ADDRESS_CACHE; index++) {
-        pMatch = &Address_Cache[index];
+        pMatch = &Cache->Entries[index];
         if (((pMatch->Flags & BAC_ADDR_IN_USE) != 0) &&
             (pMatch->device_id == device_id)) {
             if ((pMatch->Flags & BAC_ADDR_BIND_REQ) == 0) {
@@ -507,7 +536,7 @@ bool address_get_by_device(
     unsigned index;
 
     for (index = 0; index < MAX_ADDRESS_CACHE; index++) {
-        pMatch = &Address_Cache[index];
+        pMatch = &Cache->Entries[index];
         if (((pMatch->Flags & BAC_ADDR_IN_USE) != 0) &&
             (pMatch->device_id == device_id)) {
             if ((pMatch->Flags & BAC_ADDR_BIND_REQ) == 0) {
@@ -542,7 +571,7 @@ bool address_get_device_id(BACNET_ADDRESS *src, uint32_t *device_id)
     unsigned index;
 
     for (index = 0; index < MAX_ADDRESS_CACHE; index++) {
-        pMatch = &Address_Cache[index];
+        pMatch = &Cache->Entries[index];
         if ((pMatch->Flags & (BAC_ADDR_IN_USE | BAC_ADDR_BIND_REQ)) ==
             BAC_ADDR_IN_USE) {
             /* If bound */
@@ -572,7 +601,7 @@ void address_add(uint32_t device_id, unsigned max_apdu, BACNET_ADDRESS *src)
     struct Address_Cache_Entry *pMatch;
     unsigned index;
 
-    if (Own_Device_ID == device_id) {
+    if (Cache->Own_Device_ID == device_id) {
         return;
     }
 
@@ -584,10 +613,13 @@ void address_add(uint32_t device_id, unsigned max_apdu, BACNET_ADDRESS *src)
 
     /* existing device or bind request outstanding - update address */
     for (index = 0; index < MAX_ADDRESS_CACHE; index++) {
-        pMatch = &Address_Cache[index];
+        pMatch = &Cache->Entries[index];
         /* Device already in the list, then update the values. */
         if (((pMatch->Flags & BAC_ADDR_IN_USE) != 0) &&
             (pMatch->device_id == device_id)) {
+            if (!bacnet_address_same(&pMatch->address, src)) {
+                npdu_cache_invalidate();
+            }
             bacnet_address_copy(&pMatch->address, src);
             pMatch->max_apdu = max_apdu;
             /* Pick the right time to live */
@@ -613,7 +645,7 @@ void address_add(uint32_t device_id, unsigned max_apdu, BACNET_ADDRESS *src)
     /* New device - add to cache if there is room. */
     if (!found) {
         for (index = 0; index < MAX_ADDRESS_CACHE; index++) {
-            pMatch = &Address_Cache[index];
+            pMatch = &Cache->Entries[index];
             if ((pMatch->Flags & BAC_ADDR_IN_USE) == 0) {
                 pMatch->Flags = BAC_ADDR_IN_USE;
                 pMatch->device_id = device_id;
@@ -666,7 +698,7 @@ bool address_device_bind_request(uint32_t device_id,
 
     /* existing device - update address info if currently bound */
     for (index = 0; index < MAX_ADDRESS_CACHE; index++) {
-        pMatch = &Address_Cache[index];
+        pMatch = &Cache->Entries[index];
         if (((pMatch->Flags & BAC_ADDR_IN_USE) != 0) &&
             (pMatch->device_id == device_id)) {
             if ((pMatch->Flags & BAC_ADDR_BIND_REQ) == 0) {
@@ -697,7 +729,7 @@ bool address_device_bind_request(uint32_t device_id,
     /* Not there already so look for a free entry to put it in */
     /* existing device - update address info if currently bound */
     for (index = 0; index < MAX_ADDRESS_CACHE; index++) {
-        pMatch = &Address_Cache[index];
+        pMatch = &Cache->Entries[index];
         if ((pMatch->Flags & (BAC_ADDR_IN_USE | BAC_ADDR_RESERVED)) == 0) {
             /* In use and awaiting binding */
             pMatch->Flags = (uint8_t)(BAC_ADDR_IN_USE | BAC_ADDR_BIND_REQ);
@@ -754,9 +786,12 @@ void address_add_binding(
 
     /* existing device or bind request - update address */
     for (index = 0; index < MAX_ADDRESS_CACHE; index++) {
-        pMatch = &Address_Cache[index];
+        pMatch = &Cache->Entries[index];
         if (((pMatch->Flags & BAC_ADDR_IN_USE) != 0) &&
             (pMatch->device_id == device_id)) {
+            if (!bacnet_address_same(&pMatch->address, src)) {
+                npdu_cache_invalidate();
+            }
             bacnet_address_copy(&pMatch->address, src);
             pMatch->max_apdu = max_apdu;
             /* Clear bind request flag in case it was set */
@@ -795,7 +830,7 @@ bool address_device_get_by_index(unsigned index,
     bool found = false; /* return value */
 
     if (index < MAX_ADDRESS_CACHE) {
-        pMatch = &Address_Cache[index];
+        pMatch = &Cache->Entries[index];
         if ((pMatch->Flags & (BAC_ADDR_IN_USE | BAC_ADDR_BIND_REQ)) ==
             BAC_ADDR_IN_USE) {
             if (src) {
@@ -848,7 +883,7 @@ unsigned address_count(void)
     unsigned index;
 
     for (index = 0; index < MAX_ADDRESS_CACHE; index++) {
-        pMatch = &Address_Cache[index];
+        pMatch = &Cache->Entries[index];
         /* Only count bound entries */
         if ((pMatch->Flags & (BAC_ADDR_IN_USE | BAC_ADDR_BIND_REQ)) ==
             BAC_ADDR_IN_USE) {
@@ -877,7 +912,7 @@ int address_list_encode(uint8_t *apdu, unsigned apdu_len)
 
     /* Look for matching address. */
     for (index = 0; index < MAX_ADDRESS_CACHE; index++) {
-        pMatch = &Address_Cache[index];
+        pMatch = &Cache->Entries[index];
         if ((pMatch->Flags & (BAC_ADDR_IN_USE | BAC_ADDR_BIND_REQ)) ==
             BAC_ADDR_IN_USE) {
             iLen += encode_application_object_id(
@@ -1029,13 +1064,13 @@ int rr_address_list_encode(uint8_t *apdu, BACNET_READ_RANGE_DATA *pRequest)
         uiTarget = uiTotal;
     }
 
-    pMatch = Address_Cache;
+    pMatch = Cache->Entries;
     uiIndex = 1;
     while ((pMatch->Flags & (BAC_ADDR_IN_USE | BAC_ADDR_BIND_REQ)) !=
         BAC_ADDR_IN_USE) { /* Find first bound entry */
         pMatch++;
         /* Shall not happen as the count has been checked first. */
-        if (pMatch > &Address_Cache[MAX_ADDRESS_CACHE - 1]) {
+        if (pMatch > &Cache->Entries[MAX_ADDRESS_CACHE - 1]) {
             /* Issue with the table. */
             return (0);
         }
@@ -1052,7 +1087,7 @@ int rr_address_list_encode(uint8_t *apdu, BACNET_READ_RANGE_DATA *pRequest)
             pMatch++;
         }
         /* Shall not happen as the count has been checked first. */
-        if (pMatch > &Address_Cache[MAX_ADDRESS_CACHE - 1]) {
+        if (pMatch > &Cache->Entries[MAX_ADDRESS_CACHE - 1]) {
             /* Issue with the table. */
             return (0);
         }
@@ -1103,7 +1138,7 @@ int rr_address_list_encode(uint8_t *apdu, BACNET_READ_RANGE_DATA *pRequest)
             /* Find next bound entry */
             pMatch++;
             /* Can normally not happen. */
-            if (pMatch > &Address_Cache[MAX_ADDRESS_CACHE - 1]) {
+            if (pMatch > &Cache->Entries[MAX_ADDRESS_CACHE - 1]) {
                 /* Issue with the table. */
                 return (0);
             }
@@ -1136,7 +1171,7 @@ void address_cache_timer(uint16_t uSeconds)
     unsigned index;
 
     for (index = 0; index < MAX_ADDRESS_CACHE; index++) {
-        pMatch = &Address_Cache[index];
+        pMatch = &Cache->Entries[index];
         if (((pMatch->Flags & (BAC_ADDR_IN_USE | BAC_ADDR_RESERVED)) != 0) &&
             ((pMatch->Flags & BAC_ADDR_STATIC) ==
                 0)) { /* Check all entries holding a slot except statics
@@ -1145,6 +1180,7 @@ void address_cache_timer(uint16_t uSeconds)
                 pMatch->TimeToLive -= uSeconds;
             } else {
                 pMatch->Flags = 0;
+                npdu_cache_invalidate();
             }
         }
     }
@@ -28,13 +28,49 @@
 #include <stdint.h>
 #include <stdbool.h>
 #include "bacnet/bacnet_stack_exports.h"
+#include "bacnet/config.h"
 #include "bacnet/bacdef.h"
 #include "bacnet/readrange.h"
 
+/* The address cache is used for binding to BACnet devices */
+/* The number of entries corresponds to the number of */
+/* devices that might respond to an I-Am on the network. */
+/* If your device is a simple server and does not need to bind, */
+/* then you don't need to use this. */
+#if !defined(MAX_ADDRESS_CACHE)
+#define MAX_ADDRESS_CACHE 255
+#endif
+
+typedef struct Address_Cache_Entry {
+    uint8_t Flags;
+    uint32_t device_id;
+    unsigned max_apdu;
+    BACNET_ADDRESS address;
+    uint32_t TimeToLive;
+} BACNET_ADDRESS_CACHE_ENTRY;
+
+/* The address cache of one BACnet device. Several devices in one
+   process each use their own context, selected with address_context_set() */
+typedef struct BACnet_Address_Cache_Context {
+    BACNET_ADDRESS_CACHE_ENTRY Entries[MAX_ADDRESS_CACHE];
+    uint32_t Top_Protected_Entry;
+    uint32_t Own_Device_ID;
+} BACNET_ADDRESS_CACHE_CONTEXT;
+
 #ifdef __cplusplus
 extern "C" {
 #endif /* __cplusplus */
 
+    BACNET_STACK_EXPORT
+    void address_context_init(
+        BACNET_ADDRESS_CACHE_CONTEXT * context);
+    BACNET_STACK_EXPORT
+    void address_context_set(
+        BACNET_ADDRESS_CACHE_CONTEXT * context);
+    BACNET_STACK_EXPORT
+    BACNET_ADDRESS_CACHE_CONTEXT *address_context(
+        void);
+
     BACNET_STACK_EXPORT
     void address_init(
         void);
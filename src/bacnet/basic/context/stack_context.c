@@ -0,0 +1,117 @@
+/**
+ * @file
+ * @date October 2026
+ * @brief A BACnet stack context that holds the state of one BACnet device,
+ *  so that many devices can share one process.
+ *
+ * @section LICENSE
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "bacnet/config.h"
+#include "bacnet/bacdef.h"
+#include "bacnet/basic/npdu/h_npdu.h"
+#include "bacnet/basic/context/stack_context.h"
+
+/* the selected context, or NULL when the defaults are used */
+static BACNET_STACK_CONTEXT *Stack_Context;
+
+/**
+ * @brief Initialize a stack context for a device. The context is empty:
+ *  no transactions, no address bindings and no COV subscriptions.
+ * @param context - the stack context to initialize
+ * @param device_instance - Device Object instance number of the device
+ * @param object_table - object table of the device, or NULL for the
+ *  default object table of device.c
+ */
+void stack_context_init(BACNET_STACK_CONTEXT *context,
+    uint32_t device_instance,
+    object_functions_t *object_table)
+{
+    if (context) {
+        Device_Context_Init(&context->Device, object_table);
+        context->Device.Object_Instance_Number = device_instance;
+#if (MAX_TSM_TRANSACTIONS)
+        tsm_context_init(&context->TSM);
+#endif
+        address_context_init(&context->Address_Cache);
+        context->Address_Cache.Own_Device_ID = device_instance;
+        npdu_cache_context_init(&context->NPDU_Cache);
+        handler_cov_context_init(&context->COV);
+    }
+}
+
+/**
+ * @brief Select the stack context used by the basic services.
+ * @param context - the stack context, or NULL to use the defaults
+ */
+void stack_context_set(BACNET_STACK_CONTEXT *context)
+{
+    Stack_Context = context;
+    if (context) {
+        Device_Context_Set(&context->Device);
+#if (MAX_TSM_TRANSACTIONS)
+        tsm_context_set(&context->TSM);
+#endif
+        address_context_set(&context->Address_Cache);
+        npdu_cache_context_set(&context->NPDU_Cache);
+        handler_cov_context_set(&context->COV);
+    } else {
+        Device_Context_Set(NULL);
+#if (MAX_TSM_TRANSACTIONS)
+        tsm_context_set(NULL);
+#endif
+        address_context_set(NULL);
+        npdu_cache_context_set(NULL);
+        handler_cov_context_set(NULL);
+    }
+}
+
+/**
+ * @brief Get the stack context used by the basic services.
+ * @return the selected stack context, or NULL if the defaults are used
+ */
+BACNET_STACK_CONTEXT *stack_context(void)
+{
+    return Stack_Context;
+}
+
+/**
+ * @brief Handle a received NPDU on behalf of the device of a context.
+ *  The context that was selected before is selected again afterwards.
+ * @param context - the stack context of the device the NPDU is for
+ * @param src - source address of the NPDU
+ * @param pdu - the received NPDU
+ * @param pdu_len - number of bytes in the NPDU
+ */
+void stack_context_npdu_handler(BACNET_STACK_CONTEXT *context,
+    BACNET_ADDRESS *src,
+    uint8_t *pdu,
+    uint16_t pdu_len)
+{
+    BACNET_STACK_CONTEXT *previous = Stack_Context;
+
+    stack_context_set(context);
+    npdu_handler(src, pdu, pdu_len);
+    stack_context_set(previous);
+}
@@ -0,0 +1,104 @@
+/**
+ * @file
+ * @date October 2026
+ * @brief Header file for a BACnet stack context that holds the state of
+ *  one BACnet device, so that many devices can share one process.
+ *
+ * @section LICENSE
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#ifndef BACNET_BASIC_CONTEXT_STACK_CONTEXT_H
+#define BACNET_BASIC_CONTEXT_STACK_CONTEXT_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "bacnet/bacnet_stack_exports.h"
+#include "bacnet/config.h"
+#include "bacnet/bacdef.h"
+#include "bacnet/basic/object/device.h"
+#include "bacnet/basic/binding/address.h"
+#include "bacnet/basic/npdu/npdu_cache.h"
+#include "bacnet/basic/service/h_cov.h"
+#include "bacnet/basic/tsm/tsm.h"
+
+/**
+ * The state of one BACnet device: its identity and object table,
+ * its transactions, its address cache and its COV subscriptions.
+ *
+ * The basic services work on the selected context, so a process
+ * serving several devices selects the context of a device with
+ * stack_context_set() (or uses stack_context_npdu_handler()) before
+ * handling that device's traffic or running its timers and tasks.
+ * The devices share the process, the event loop and the datalink.
+ *
+ * The object table only lists the object functions.  The objects behind
+ * them (Analog Inputs, Binary Values and so on) keep their instances in
+ * the static data of their own modules, so two contexts using the same
+ * table, such as the default table of device.c, serve the same objects.
+ * Devices that need their own objects need their own object table, with
+ * object functions that look at the selected context.
+ *
+ * The size of a context follows MAX_TSM_TRANSACTIONS, MAX_ADDRESS_CACHE,
+ * NPDU_CACHE_SIZE, MAX_COV_SUBCRIPTIONS and MAX_COV_ADDRESSES, which are
+ * set for the whole build.  Each TSM transaction holds a copy of its APDU,
+ * so with the defaults a context takes about 400 KB, most of it for the
+ * 255 transactions.  A process with many devices should build with small
+ * values, for example MAX_TSM_TRANSACTIONS=4, MAX_ADDRESS_CACHE=16,
+ * NPDU_CACHE_SIZE=4, MAX_COV_SUBCRIPTIONS=8 and MAX_COV_ADDRESSES=4,
+ * which take about 9 KB per context, or about 4 KB with MAX_APDU=480.
+ */
+typedef struct BACnet_Stack_Context {
+    BACNET_DEVICE_CONTEXT Device;
+#if (MAX_TSM_TRANSACTIONS)
+    BACNET_TSM_CONTEXT TSM;
+#endif
+    BACNET_ADDRESS_CACHE_CONTEXT Address_Cache;
+    BACNET_NPDU_CACHE_CONTEXT NPDU_Cache;
+    BACNET_COV_CONTEXT COV;
+} BACNET_STACK_CONTEXT;
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+    BACNET_STACK_EXPORT
+    void stack_context_init(
+        BACNET_STACK_CONTEXT * context,
+        uint32_t device_instance,
+        object_functions_t * object_table);
+    BACNET_STACK_EXPORT
+    void stack_context_set(
+        BACNET_STACK_CONTEXT * context);
+    BACNET_STACK_EXPORT
+    BACNET_STACK_CONTEXT *stack_context(
+        void);
+    BACNET_STACK_EXPORT
+    void stack_context_npdu_handler(
+        BACNET_STACK_CONTEXT * context,
+        BACNET_ADDRESS * src,
+        uint8_t * pdu,
+        uint16_t pdu_len);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+#endif
@@ -43,6 +43,7 @@
 #if PRINT_ENABLED
 #include <stdio.h>
 #endif
+#include <string.h>
 
 /** @file h_routed_npdu.c  Handles messages at the NPDU level of the BACnet
  * stack, including routing and network control messages. */
@@ -310,3 +311,235 @@ void routing_npdu_handler(
 
     return;
 }
+
+#if defined(BACDL_ALL)
+/* NPDU forwarded from one datalink port to another */
+static uint8_t Routed_Port_Buffer[MAX_MPDU];
+
+/** Send I-Am-Router-To-Network out one datalink port, listing either one
+ * network or every network reached through the other ports and DNET_list.
+ *
+ * @param port [in] The datalink port to send the message out.
+ * @param net [in] The network to announce, or 0 for all of them.
+ * @param DNET_list [in] Our virtual networks; terminated with a -1 value.
+ */
+static void routed_port_i_am_router(unsigned port, uint16_t net, int *DNET_list)
+{
+    BACNET_ADDRESS dest = { 0 };
+    BACNET_NPDU_DATA npdu_data = { 0 };
+    uint16_t net_list[DATALINK_PORTS_MAX + DATALINK_ROUTES_MAX];
+    unsigned count, i;
+    int len;
+
+    npdu_encode_npdu_network(&npdu_data, NETWORK_MESSAGE_I_AM_ROUTER_TO_NETWORK,
+        false, MESSAGE_PRIORITY_NORMAL);
+    len = npdu_encode_pdu(&Routed_Port_Buffer[0], NULL, NULL, &npdu_data);
+    if (net) {
+        len += encode_unsigned16(&Routed_Port_Buffer[len], net);
+    } else {
+        count = datalink_port_route_list(
+            port, net_list, sizeof(net_list) / sizeof(net_list[0]));
+        for (i = 0; i < count; i++) {
+            len += encode_unsigned16(&Routed_Port_Buffer[len], net_list[i]);
+        }
+        for (i = 0; DNET_list && (DNET_list[i] >= 0); i++) {
+            if ((unsigned)len + 2 > sizeof(Routed_Port_Buffer)) {
+                break;
+            }
+            len += encode_unsigned16(
+                &Routed_Port_Buffer[len], (uint16_t)DNET_list[i]);
+        }
+    }
+    datalink_port_get_broadcast_address(port, &dest);
+    datalink_port_send_pdu(
+        port, &dest, &npdu_data, &Routed_Port_Buffer[0], (unsigned)len);
+}
+
+/** Forward an NPDU out another datalink port, as in 6.5.4.  On the port
+ * of the destination network the DNET and DADR are removed, and the PDU
+ * goes to DADR or to the broadcast MAC address.  For a remote network it
+ * goes to the next router, and a global broadcast goes to the broadcast
+ * MAC address with the DNET kept.
+ *
+ * @param port [in] The datalink port to send the NPDU out.
+ * @param src [in] The SNET and SADR of the NPDU.
+ * @param dest [in] The DNET and DADR of the NPDU.
+ * @param npdu_data [in] The NPCI with the decremented hop count.
+ * @param apdu [in] The APDU or network message following the NPCI.
+ * @param apdu_len [in] The length of apdu[].
+ */
+static void routed_port_forward(unsigned port,
+    BACNET_ADDRESS *src,
+    BACNET_ADDRESS *dest,
+    BACNET_NPDU_DATA *npdu_data,
+    uint8_t *apdu,
+    uint16_t apdu_len)
+{
+    BACNET_ADDRESS mac_dest = { 0 };
+    int len;
+
+    if (dest->net == datalink_port_network(port)) {
+        len = npdu_encode_pdu(&Routed_Port_Buffer[0], NULL, src, npdu_data);
+        if (dest->len == 0) {
+            datalink_port_get_broadcast_address(port, &mac_dest);
+        } else {
+            mac_dest.mac_len = dest->len;
+            memcpy(&mac_dest.mac[0], &dest->adr[0], MAX_MAC_LEN);
+        }
+    } else if (dest->net == BACNET_BROADCAST_NETWORK) {
+        len = npdu_encode_pdu(&Routed_Port_Buffer[0], dest, src, npdu_data);
+        datalink_port_get_broadcast_address(port, &mac_dest);
+    } else {
+        len = npdu_encode_pdu(&Routed_Port_Buffer[0], dest, src, npdu_data);
+        if (datalink_port_route_find(dest->net, &mac_dest) !=
+            (int)port) {
+            return;
+        }
+    }
+    if (((unsigned)len + apdu_len) > sizeof(Routed_Port_Buffer)) {
+        Send_Reject_Message_To_Network(
+            src, NETWORK_REJECT_MESSAGE_TOO_LONG, dest->net);
+        return;
+    }
+    memmove(&Routed_Port_Buffer[len], apdu, apdu_len);
+    datalink_port_send_pdu(port, &mac_dest, npdu_data, &Routed_Port_Buffer[0],
+        (unsigned)len + apdu_len);
+}
+
+/** Handler for the NPDU of a packet received on one of several datalink
+ * ports that are active together (see datalink_port_add()).  The device
+ * is a router between the ports, so NPDUs for the networks of the other
+ * ports, or for remote networks learned from I-Am-Router-To-Network, are
+ * forwarded without leaving this process.  Global broadcasts are
+ * forwarded out every other port, and also handled here like an NPDU
+ * for this device.
+ *
+ * The source of an NPDU without SNET is given the network number of the
+ * port, so that the reply goes back out the same port.
+ * @ingroup NMRC
+ *
+ * @param port [in] The datalink port the packet was received on.
+ * @param src [in] The source MAC address of the packet; returned with
+ *                 its routing source information.
+ * @param DNET_list [in] List of our virtual BACnet Network numbers, if
+ * any; terminated with a -1 value, and not NULL.
+ * @param pdu [in]  Buffer containing the NPDU and APDU of the received packet.
+ * @param pdu_len [in] The size of the received message in the pdu[] buffer.
+ */
+void routing_npdu_port_handler(unsigned port,
+    BACNET_ADDRESS *src,
+    int *DNET_list,
+    uint8_t *pdu,
+    uint16_t pdu_len)
+{
+    int apdu_offset = 0;
+    int dest_port;
+    BACNET_ADDRESS dest = { 0 };
+    BACNET_ADDRESS my_address = { 0 };
+    BACNET_NPDU_DATA npdu_data = { 0 };
+    uint16_t port_net = datalink_port_network(port);
+    uint16_t npdu_len, dnet;
+    unsigned i;
+    bool for_me = false;
+    bool forward = false;
+
+    if ((port_net == 0) || (pdu_len == 0) ||
+        (pdu[0] != BACNET_PROTOCOL_VERSION)) {
+        return;
+    }
+    apdu_offset = bacnet_npdu_decode(pdu, pdu_len, &dest, src, &npdu_data);
+    if ((apdu_offset <= 0) || (apdu_offset > pdu_len)) {
+        debug_printf("NPDU: Decoding failed; Discarded!\n");
+        return;
+    }
+    npdu_len = (uint16_t)(pdu_len - apdu_offset);
+    if (src->net == 0) {
+        /* from a node on this port */
+        src->net = port_net;
+        src->len = src->mac_len;
+        memcpy(&src->adr[0], &src->mac[0], MAX_MAC_LEN);
+    } else if (src->net != port_net) {
+        /* from a node behind the router that sent it */
+        datalink_port_route_add(port, src->net, src);
+    }
+    if (dest.net == port_net) {
+        /* addressed to the network of the port it came in on */
+        dest.net = 0;
+    }
+    if (npdu_data.network_layer_message &&
+        ((dest.net == 0) || (dest.net == BACNET_BROADCAST_NETWORK))) {
+        switch (npdu_data.network_message_type) {
+            case NETWORK_MESSAGE_WHO_IS_ROUTER_TO_NETWORK:
+                if (npdu_len >= 2) {
+                    decode_unsigned16(&pdu[apdu_offset], &dnet);
+                    dest_port = datalink_port_route_find(dnet, NULL);
+                    if ((dest_port != DATALINK_PORT_NONE) &&
+                        (dest_port != (int)port)) {
+                        routed_port_i_am_router(port, dnet, NULL);
+                    } else if (DNET_list && (DNET_list[0] == dnet)) {
+                        routed_port_i_am_router(port, dnet, NULL);
+                    }
+                } else {
+                    routed_port_i_am_router(port, 0, DNET_list);
+                }
+                break;
+            case NETWORK_MESSAGE_I_AM_ROUTER_TO_NETWORK:
+                for (i = 0; (i + 2) <= npdu_len; i += 2) {
+                    decode_unsigned16(&pdu[apdu_offset + i], &dnet);
+                    datalink_port_route_add(port, dnet, src);
+                }
+                break;
+            default:
+                network_control_handler(
+                    src, DNET_list, &npdu_data, &pdu[apdu_offset], npdu_len);
+                break;
+        }
+        return;
+    }
+    if (dest.net == BACNET_BROADCAST_NETWORK) {
+        if (npdu_data.hop_count > 1) {
+            npdu_data.hop_count--;
+            for (i = 0; i < datalink_port_count(); i++) {
+                if (i != port) {
+                    routed_port_forward(i, src, &dest, &npdu_data,
+                        &pdu[apdu_offset], npdu_len);
+                }
+            }
+        }
+        for_me = true;
+    } else if (dest.net == 0) {
+        for_me = true;
+    } else {
+        dest_port = datalink_port_route_find(dest.net, NULL);
+        if (dest_port == DATALINK_PORT_NONE) {
+            /* our virtual network, or rejected as unknown */
+            for_me = true;
+        } else if (dest_port != (int)port) {
+            forward = true;
+            if (dest.net == datalink_port_network((unsigned)dest_port)) {
+                datalink_port_get_my_address((unsigned)dest_port, &my_address);
+                if (dest.len == 0) {
+                    /* a remote broadcast reaches us too */
+                    for_me = true;
+                } else if ((dest.len == my_address.mac_len) &&
+                    (memcmp(&dest.adr[0], &my_address.mac[0], dest.len) ==
+                        0)) {
+                    /* addressed to us on the other port */
+                    for_me = true;
+                    forward = false;
+                }
+            }
+            if (forward && (npdu_data.hop_count > 1)) {
+                npdu_data.hop_count--;
+                routed_port_forward((unsigned)dest_port, src, &dest,
+                    &npdu_data, &pdu[apdu_offset], npdu_len);
+            }
+            dest.net = 0;
+        }
+    }
+    if (for_me && !npdu_data.network_layer_message) {
+        routed_apdu_handler(
+            src, &dest, DNET_list, &pdu[apdu_offset], npdu_len);
+    }
+}
+#endif
@@ -48,6 +48,16 @@ extern "C" {
         uint8_t * pdu,
         uint16_t pdu_len);
 
+#if defined(BACDL_ALL)
+    BACNET_STACK_EXPORT
+    void routing_npdu_port_handler(
+        unsigned port,
+        BACNET_ADDRESS * src,
+        int *DNET_list,
+        uint8_t * pdu,
+        uint16_t pdu_len);
+#endif
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
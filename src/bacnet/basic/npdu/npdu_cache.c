@@ -0,0 +1,170 @@
+/**
+ * @file
+ * @date October 2026
+ * @brief A cache of encoded NPDU headers, so that a reply to a recent
+ *  destination copies its NPDU header instead of encoding it.
+ *
+ * @section LICENSE
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include "bacnet/bacdef.h"
+#include "bacnet/bits.h"
+#include "bacnet/npdu.h"
+#include "bacnet/basic/npdu/npdu_cache.h"
+
+#if (NPDU_CACHE_SIZE & (NPDU_CACHE_SIZE - 1))
+#error "NPDU_CACHE_SIZE must be a power of two"
+#endif
+
+/* The default context is used until another one is selected. */
+static BACNET_NPDU_CACHE_CONTEXT Default_Cache;
+static BACNET_NPDU_CACHE_CONTEXT *Cache = &Default_Cache;
+
+/**
+ * @brief Initialize an NPDU header cache context to an empty cache.
+ * @param context - the NPDU header cache context to initialize
+ */
+void npdu_cache_context_init(BACNET_NPDU_CACHE_CONTEXT *context)
+{
+    if (context) {
+        memset(context, 0, sizeof(BACNET_NPDU_CACHE_CONTEXT));
+    }
+}
+
+/**
+ * @brief Select the NPDU header cache context used by npdu_cache_ functions.
+ * @param context - the NPDU header cache context, or NULL for the default
+ */
+void npdu_cache_context_set(BACNET_NPDU_CACHE_CONTEXT *context)
+{
+    if (context) {
+        Cache = context;
+    } else {
+        Cache = &Default_Cache;
+    }
+}
+
+/**
+ * @brief Get the NPDU header cache context used by npdu_cache_ functions.
+ * @return the current NPDU header cache context
+ */
+BACNET_NPDU_CACHE_CONTEXT *npdu_cache_context(void)
+{
+    return Cache;
+}
+
+/**
+ * @brief Empty the NPDU header cache. The address cache calls this when
+ *  a bound address changes or is removed.
+ */
+void npdu_cache_invalidate(void)
+{
+#if NPDU_CACHE_SIZE
+    unsigned i;
+
+    for (i = 0; i < NPDU_CACHE_SIZE; i++) {
+        Cache->Entries[i].header_len = 0;
+    }
+#endif
+}
+
+/**
+ * @brief Encode the NPDU header of an APDU, copying it from the cache
+ *  when the same destination, source, expecting reply and priority were
+ *  encoded before. Network layer messages are encoded every time.
+ * @param npdu - buffer for the encoded NPDU header
+ * @param dest - routing destination, or NULL
+ * @param src - routing source (our address), or NULL
+ * @param npdu_data - NPDU parameters, see npdu_encode_npdu_data()
+ * @return number of bytes encoded, as npdu_encode_pdu()
+ */
+int npdu_cache_encode_pdu(uint8_t *npdu,
+    BACNET_ADDRESS *dest,
+    BACNET_ADDRESS *src,
+    BACNET_NPDU_DATA *npdu_data)
+{
+#if NPDU_CACHE_SIZE
+    NPDU_CACHE_ENTRY key = { 0 };
+    NPDU_CACHE_ENTRY *entry;
+    unsigned hash;
+    unsigned i;
+    int len;
+
+    if (!npdu || !npdu_data || npdu_data->network_layer_message ||
+        (npdu_data->protocol_version != BACNET_PROTOCOL_VERSION) ||
+        (npdu_data->hop_count != HOP_COUNT_DEFAULT)) {
+        return npdu_encode_pdu(npdu, dest, src, npdu_data);
+    }
+    /* the key holds only what npdu_encode_pdu() encodes */
+    if (dest && dest->net) {
+        if (dest->len > MAX_MAC_LEN) {
+            return npdu_encode_pdu(npdu, dest, src, npdu_data);
+        }
+        key.dnet = dest->net;
+        key.dlen = dest->len;
+        memcpy(key.dadr, dest->adr, dest->len);
+    }
+    if (src && src->net && src->len) {
+        if (src->len > MAX_MAC_LEN) {
+            return npdu_encode_pdu(npdu, dest, src, npdu_data);
+        }
+        key.snet = src->net;
+        key.slen = src->len;
+        memcpy(key.sadr, src->adr, src->len);
+    }
+    key.control = (npdu_data->priority & 0x03);
+    if (npdu_data->data_expecting_reply) {
+        key.control |= BIT(2);
+    }
+    hash = key.dnet ^ key.snet ^ key.control;
+    for (i = 0; i < key.dlen; i++) {
+        hash = (hash * 31) + key.dadr[i];
+    }
+    for (i = 0; i < key.slen; i++) {
+        hash = (hash * 31) + key.sadr[i];
+    }
+    entry = &Cache->Entries[(hash ^ (hash >> 8)) & (NPDU_CACHE_SIZE - 1)];
+    if (entry->header_len && (entry->control == key.control) &&
+        (entry->dnet == key.dnet) && (entry->dlen == key.dlen) &&
+        (entry->snet == key.snet) && (entry->slen == key.slen) &&
+        (memcmp(entry->dadr, key.dadr, key.dlen) == 0) &&
+        (memcmp(entry->sadr, key.sadr, key.slen) == 0)) {
+        Cache->Hits++;
+        memcpy(npdu, entry->header, entry->header_len);
+        return entry->header_len;
+    }
+    Cache->Misses++;
+    len = npdu_encode_pdu(npdu, dest, src, npdu_data);
+    if ((len > 0) && (len <= NPDU_CACHE_HEADER_MAX)) {
+        *entry = key;
+        memcpy(entry->header, npdu, (size_t)len);
+        entry->header_len = (uint8_t)len;
+    }
+
+    return len;
+#else
+    return npdu_encode_pdu(npdu, dest, src, npdu_data);
+#endif
+}
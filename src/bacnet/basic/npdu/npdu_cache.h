@@ -0,0 +1,101 @@
+/**
+ * @file
+ * @date October 2026
+ * @brief Header file for a cache of encoded NPDU headers, so that a reply
+ *  to a recent destination copies its NPDU header instead of encoding it.
+ *
+ * @section LICENSE
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#ifndef BACNET_BASIC_NPDU_NPDU_CACHE_H
+#define BACNET_BASIC_NPDU_NPDU_CACHE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "bacnet/bacnet_stack_exports.h"
+#include "bacnet/bacdef.h"
+#include "bacnet/npdu.h"
+
+/* number of encoded NPDU headers kept - a power of two,
+   or 0 to encode every NPDU header */
+#ifndef NPDU_CACHE_SIZE
+#define NPDU_CACHE_SIZE 16
+#endif
+
+/* largest NPDU header of an APDU: version, control, DNET, DLEN, DADR,
+   SNET, SLEN, SADR and hop count */
+#define NPDU_CACHE_HEADER_MAX (2 + 3 + MAX_MAC_LEN + 3 + MAX_MAC_LEN + 1)
+
+typedef struct NPDU_Cache_Entry {
+    /* key: routing addresses, expecting reply and priority */
+    uint16_t dnet;
+    uint16_t snet;
+    uint8_t dlen;
+    uint8_t slen;
+    uint8_t dadr[MAX_MAC_LEN];
+    uint8_t sadr[MAX_MAC_LEN];
+    uint8_t control;
+    /* the encoded header, 0 length when the entry is empty */
+    uint8_t header_len;
+    uint8_t header[NPDU_CACHE_HEADER_MAX];
+} NPDU_CACHE_ENTRY;
+
+/* The NPDU header cache of one BACnet device. Several devices in one
+   process each use their own context, selected with
+   npdu_cache_context_set() */
+typedef struct BACnet_NPDU_Cache_Context {
+#if NPDU_CACHE_SIZE
+    NPDU_CACHE_ENTRY Entries[NPDU_CACHE_SIZE];
+#endif
+    uint32_t Hits;
+    uint32_t Misses;
+} BACNET_NPDU_CACHE_CONTEXT;
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+    BACNET_STACK_EXPORT
+    void npdu_cache_context_init(
+        BACNET_NPDU_CACHE_CONTEXT * context);
+    BACNET_STACK_EXPORT
+    void npdu_cache_context_set(
+        BACNET_NPDU_CACHE_CONTEXT * context);
+    BACNET_STACK_EXPORT
+    BACNET_NPDU_CACHE_CONTEXT *npdu_cache_context(
+        void);
+
+    BACNET_STACK_EXPORT
+    void npdu_cache_invalidate(
+        void);
+
+    BACNET_STACK_EXPORT
+    int npdu_cache_encode_pdu(
+        uint8_t * npdu,
+        BACNET_ADDRESS * dest,
+        BACNET_ADDRESS * src,
+        BACNET_NPDU_DATA * npdu_data);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+#endif
@@ -101,8 +101,10 @@ extern int Routed_Device_Read_Property_Local(BACNET_READ_PROPERTY_DATA *rpdata);
 extern bool Routed_Device_Write_Property_Local(
     BACNET_WRITE_PROPERTY_DATA *wp_data);
 
-/* may be overridden by outside table */
-static object_functions_t *Object_Table;
+/* The default context is used until another one is selected.
+   Its object table may be overridden by an outside table. */
+static BACNET_DEVICE_CONTEXT Default_Device;
+static BACNET_DEVICE_CONTEXT *My_Device = &Default_Device;
 
 //! Array of supported objects and their functions
 static object_functions_t supportedObjectTable[] = {
@@ -312,11 +314,11 @@ static struct object_functions *Device_Objects_Find_Functions(
 {
     struct object_functions *pObject = NULL;
 
-    pObject = Object_Table;
+    pObject = My_Device->Object_Table;
     if(!pObject)
         return (NULL);
 
-    pObject = Object_Table;
+    pObject = My_Device->Object_Table;
     while (pObject->Object_Type < MAX_BACNET_OBJECT_TYPE) {
         /* handle each object type */
         if (pObject->Object_Type == Object_Type) {
@@ -443,8 +445,7 @@ void Device_Property_Lists(
    The properties that are constant can be hard coded
    into the read-property encoding. */
 
-static BACNET_CHARACTER_STRING My_Object_Name;
-static uint32_t Object_Instance_Number                          = 0;
+/* Object_Identifier and Object_Name - in the device context */
 static BACNET_DEVICE_STATUS System_Status                       = STATUS_NON_OPERATIONAL;
 static uint16_t Vendor_Identifier                               = BACNET_VENDOR_ID;
 static char* Vendor_Name                                        = BACNET_VENDOR_NAME;
@@ -483,7 +484,7 @@ static uint32_t Interval_Offset_Minutes;
 /* Max_Master - rely on MS/TP subsystem, if there is one */
 /* Max_Info_Frames - rely on MS/TP subsystem, if there is one */
 /* Device_Address_Binding - required, but relies on binding cache */
-static uint32_t Database_Revision = 0;
+/* Database_Revision - in the device context */
 /* Configuration_Files */
 /* Last_Restore_Time */
 /* Backup_Failure_Timeout */
@@ -574,7 +575,7 @@ bool Device_Set_Reinit_Password(char* reinitPassword, size_t length){
 uint32_t Device_Index_To_Instance(unsigned index)
 {
     (void)index;
-    return Object_Instance_Number;
+    return My_Device->Object_Instance_Number;
 }
 
 /* methods to manipulate the data */
@@ -590,7 +591,7 @@ uint32_t Device_Object_Instance_Number(void)
 #ifdef BAC_ROUTING
     return Routed_Device_Object_Instance_Number();
 #else
-    return Object_Instance_Number;
+    return My_Device->Object_Instance_Number;
 #endif
 }
 
@@ -600,7 +601,7 @@ bool Device_Set_Object_Instance_Number(uint32_t object_id)
 
     if (object_id <= BACNET_MAX_INSTANCE) {
         /* Make the change and update the database revision */
-        Object_Instance_Number = object_id;
+        My_Device->Object_Instance_Number = object_id;
         Device_Inc_Database_Revision();
     } else {
         status = false;
@@ -611,7 +612,7 @@ bool Device_Set_Object_Instance_Number(uint32_t object_id)
 
 bool Device_Valid_Object_Instance_Number(uint32_t object_id)
 {
-    return (Object_Instance_Number == object_id);
+    return (My_Device->Object_Instance_Number == object_id);
 }
 
 bool Device_Object_Name(
@@ -619,8 +620,9 @@ bool Device_Object_Name(
 {
     bool status = false;
 
-    if (object_instance == Object_Instance_Number) {
-        status = characterstring_copy_(object_name, &My_Object_Name);
+    if (object_instance == My_Device->Object_Instance_Number) {
+        status =
+            characterstring_copy_(object_name, &My_Device->Object_Name);
     }
 
     return status;
@@ -630,9 +632,10 @@ bool Device_Set_Object_Name(BACNET_CHARACTER_STRING *object_name)
 {
     bool status = false; /*return value */
 
-    if (!characterstring_same(&My_Object_Name, object_name)) {
+    if (!characterstring_same(&My_Device->Object_Name, object_name)) {
         /* Make the change and update the database revision */
-        status = characterstring_copy_(&My_Object_Name, object_name);
+        status =
+            characterstring_copy_(&My_Device->Object_Name, object_name);
         Device_Inc_Database_Revision();
     }
 
@@ -641,7 +644,7 @@ bool Device_Set_Object_Name(BACNET_CHARACTER_STRING *object_name)
 
 bool Device_Object_Name_ANSI_Init(const char *value)
 {
-    return characterstring_init_ansi(&My_Object_Name, value);
+    return characterstring_init_ansi(&My_Device->Object_Name, value);
 }
 
 BACNET_DEVICE_STATUS Device_System_Status(void)
@@ -826,12 +829,12 @@ BACNET_SEGMENTATION Device_Segmentation_Supported(void)
 
 uint32_t Device_Database_Revision(void)
 {
-    return Database_Revision;
+    return My_Device->Database_Revision;
 }
 
 void Device_Set_Database_Revision(uint32_t revision)
 {
-    Database_Revision = revision;
+    My_Device->Database_Revision = revision;
 }
 
 /*
@@ -841,7 +844,7 @@ void Device_Set_Database_Revision(uint32_t revision)
  */
 void Device_Inc_Database_Revision(void)
 {
-    Database_Revision++;
+    My_Device->Database_Revision++;
 }
 
 /** Get the total count of objects supported by this Device Object.
@@ -855,7 +858,7 @@ unsigned Device_Object_List_Count(void)
     struct object_functions *pObject = NULL;
 
     /* initialize the default return values */
-    pObject = Object_Table;
+    pObject = My_Device->Object_Table;
     while (pObject->Object_Type < MAX_BACNET_OBJECT_TYPE) {
         if (pObject->Object_Count) {
             count += pObject->Object_Count();
@@ -891,7 +894,7 @@ bool Device_Object_List_Identifier(
     }
     object_index = array_index - 1;
     /* initialize the default return values */
-    pObject = Object_Table;
+    pObject = My_Device->Object_Table;
     while (pObject->Object_Type < MAX_BACNET_OBJECT_TYPE) {
         if (pObject->Object_Count) {
             object_index -= count;
@@ -1140,11 +1143,12 @@ int Device_Read_Property_Local(BACNET_READ_PROPERTY_DATA *rpdata)
     switch (rpdata->object_property) {
         case PROP_OBJECT_IDENTIFIER:
             apdu_len = encode_application_object_id(
-                &apdu[0], OBJECT_DEVICE, Object_Instance_Number);
+                &apdu[0], OBJECT_DEVICE, My_Device->Object_Instance_Number);
             break;
         case PROP_OBJECT_NAME:
             apdu_len =
-                encode_application_character_string(&apdu[0], &My_Object_Name);
+                encode_application_character_string(
+                    &apdu[0], &My_Device->Object_Name);
             break;
         case PROP_OBJECT_TYPE:
             apdu_len = encode_application_enumerated(&apdu[0], OBJECT_DEVICE);
@@ -1231,7 +1235,7 @@ int Device_Read_Property_Local(BACNET_READ_PROPERTY_DATA *rpdata)
             }
             /* set the object types with objects to supported */
 
-            pObject = Object_Table;
+            pObject = My_Device->Object_Table;
             while (pObject->Object_Type < MAX_BACNET_OBJECT_TYPE) {
                 if ((pObject->Object_Count) && (pObject->Object_Count() > 0)) {
                     bitstring_set_bit(
@@ -1308,7 +1312,8 @@ int Device_Read_Property_Local(BACNET_READ_PROPERTY_DATA *rpdata)
             apdu_len = address_list_encode(&apdu[0], apdu_max);
             break;
         case PROP_DATABASE_REVISION:
-            apdu_len = encode_application_unsigned(&apdu[0], Database_Revision);
+            apdu_len = encode_application_unsigned(
+                &apdu[0], My_Device->Database_Revision);
             break;
 #if defined(BACDL_MSTP)
         case PROP_MAX_INFO_FRAMES:
@@ -1386,7 +1391,7 @@ static int Read_Property_Common(
     apdu = rpdata->application_data;
     if (property_list_common(rpdata->object_property)) {
         apdu_len = property_list_common_encode(rpdata,
-            Object_Instance_Number);
+            My_Device->Object_Instance_Number);
     } else if (rpdata->object_property == PROP_OBJECT_NAME) {
         /*  only array properties can have array options */
         if (rpdata->array_index != BACNET_ARRAY_ALL) {
@@ -1543,7 +1548,7 @@ bool Device_Write_Property_Local(BACNET_WRITE_PROPERTY_DATA *wp_data)
             break;
         case PROP_OBJECT_NAME:
             status = write_property_string_valid(wp_data, &value,
-                characterstring_capacity(&My_Object_Name));
+                characterstring_capacity(&My_Device->Object_Name));
             if (status) {
                 /* All the object names in a device must be unique */
                 if (Device_Valid_Object_Name(&value.type.Character_String,
@@ -1890,6 +1895,49 @@ bool Device_Value_List_Supported(BACNET_OBJECT_TYPE object_type)
     return (status);
 }
 
+/** Initialize a Device context with an object table.
+ * The context is not selected; use Device_Context_Set() for that,
+ * followed by Device_Init() to initialize the objects in its table.
+ * @ingroup ObjIntf
+ * @param context [out] the Device context to initialize
+ * @param object_table [in] array of structure with object functions,
+ *  or NULL to use the default table of this file.
+ */
+void Device_Context_Init(
+    BACNET_DEVICE_CONTEXT *context, object_functions_t *object_table)
+{
+    if (context) {
+        memset(context, 0, sizeof(BACNET_DEVICE_CONTEXT));
+        if (object_table) {
+            context->Object_Table = object_table;
+        } else {
+            context->Object_Table = &supportedObjectTable[0];
+        }
+    }
+}
+
+/** Select the Device context used by the Device Object functions.
+ * @ingroup ObjIntf
+ * @param context [in] the Device context, or NULL to use the default
+ */
+void Device_Context_Set(BACNET_DEVICE_CONTEXT *context)
+{
+    if (context) {
+        My_Device = context;
+    } else {
+        My_Device = &Default_Device;
+    }
+}
+
+/** Get the Device context used by the Device Object functions.
+ * @ingroup ObjIntf
+ * @return the current Device context
+ */
+BACNET_DEVICE_CONTEXT *Device_Context(void)
+{
+    return My_Device;
+}
+
 /** Initialize the Device Object.
  Initialize the group of object helper functions for any supported Object.
  Initialize each of the Device Object child Object instances.
@@ -1901,14 +1949,14 @@ bool Device_Value_List_Supported(BACNET_OBJECT_TYPE object_type)
 void Device_Init(object_functions_t *object_table)
 {
     struct object_functions *pObject = NULL;
-    //characterstring_init_ansi(&My_Object_Name, ServerName);
+    //characterstring_init_ansi(&My_Device->Object_Name, ServerName);
     datetime_init();
     if (object_table) {
-        Object_Table = object_table;
+        My_Device->Object_Table = object_table;
     } else {
-        Object_Table = &supportedObjectTable[0];
+        My_Device->Object_Table = &supportedObjectTable[0];
     }
-    pObject = Object_Table;
+    pObject = My_Device->Object_Table;
     while (pObject->Object_Type < MAX_BACNET_OBJECT_TYPE) {
         if (pObject->Object_Init) {
             pObject->Object_Init();
@@ -1980,10 +2028,11 @@ void Routing_Device_Init(uint32_t first_object_instance)
     struct object_functions *pDevObject = NULL;
 
     /* Initialize with our preset strings */
-    Add_Routed_Device(first_object_instance, &My_Object_Name, Description);
+    Add_Routed_Device(
+        first_object_instance, &My_Device->Object_Name, Description);
 
     /* Now substitute our routed versions of the main object functions. */
-    pDevObject = Object_Table;
+    pDevObject = My_Device->Object_Table;
     pDevObject->Object_Index_To_Instance = Routed_Device_Index_To_Instance;
     pDevObject->Object_Valid_Instance =
         Routed_Device_Valid_Object_Instance_Number;
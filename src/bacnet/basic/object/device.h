@@ -223,8 +223,27 @@ typedef struct devObj_s {
 
     /** The upcounter that shows if the Device ID or object structure has changed. */
     uint32_t Database_Revision;
+
+    /** The object table of this Device, or NULL to share the gateway's. */
+    object_functions_t *Object_Table;
 } DEVICE_OBJECT_DATA;
 
+/** Structure for the identity and object table of the Device Object that
+ *  is currently served by the handlers.
+ *  Several Devices may share one process by each having a context that is
+ *  selected with Device_Context_Set() before their requests are handled.
+ */
+typedef struct BACnet_Device_Context {
+    /** The object table; may be overridden by an outside table. */
+    object_functions_t *Object_Table;
+    /** The Device Object instance number. */
+    uint32_t Object_Instance_Number;
+    /** The Device Object name. */
+    BACNET_CHARACTER_STRING Object_Name;
+    /** The upcounter that shows if the Device ID or object structure has changed. */
+    uint32_t Database_Revision;
+} BACNET_DEVICE_CONTEXT;
+
 
 #ifdef __cplusplus
 extern "C" {
@@ -234,6 +253,17 @@ extern "C" {
     void Device_Init(
         object_functions_t * object_table);
 
+    BACNET_STACK_EXPORT
+    void Device_Context_Init(
+        BACNET_DEVICE_CONTEXT * context,
+        object_functions_t * object_table);
+    BACNET_STACK_EXPORT
+    void Device_Context_Set(
+        BACNET_DEVICE_CONTEXT * context);
+    BACNET_STACK_EXPORT
+    BACNET_DEVICE_CONTEXT *Device_Context(
+        void);
+
     BACNET_STACK_EXPORT
     bool Device_Reinitialize(
         BACNET_REINITIALIZE_DEVICE_DATA * rd_data);
@@ -475,6 +505,20 @@ extern "C" {
     BACNET_STACK_EXPORT
     BACNET_ADDRESS *Get_Routed_Device_Address(
         int idx);
+    BACNET_STACK_EXPORT
+    uint16_t Routed_Device_Count(
+        void);
+    BACNET_STACK_EXPORT
+    uint16_t Routed_Device_Current_Index(
+        void);
+    BACNET_STACK_EXPORT
+    bool Routed_Device_Set_Address(
+        int idx,
+        BACNET_ADDRESS * address);
+    BACNET_STACK_EXPORT
+    bool Routed_Device_Set_Object_Table(
+        int idx,
+        object_functions_t * object_table);
 
     BACNET_STACK_EXPORT
     void routed_get_my_address(
@@ -28,8 +28,10 @@
 
 #include <stdbool.h>
 #include <stdint.h>
+#include <stdlib.h>
 #include <string.h> /* for memmove */
 #include "bacnet/bacdef.h"
+#include "bacnet/bacaddr.h"
 #include "bacnet/bacdcode.h"
 #include "bacnet/bacenum.h"
 #include "bacnet/bacapp.h"
@@ -84,10 +86,29 @@ bool Routed_Device_Write_Property_Local(BACNET_WRITE_PROPERTY_DATA *wp_data);
  * and extending the regular Device Object functionality.
  ****************************************************************************/
 
-/** Model the gateway as the main Device, with (two) remote
- * Devices that are reached via its routing capabilities.
+/** Model the gateway as the main Device, with the remote Devices that
+ * are reached via its routing capabilities.
+ * The first MAX_NUM_DEVICES Devices are statically allocated, and more
+ * are allocated as they are added, up to MAX_ROUTED_DEVICES. A Device
+ * never moves once added, so pointers to it stay valid.
  */
-DEVICE_OBJECT_DATA Devices[MAX_NUM_DEVICES];
+static DEVICE_OBJECT_DATA Devices_Table[MAX_NUM_DEVICES];
+/* the gateway entry is valid, if empty, before any Device is added */
+static DEVICE_OBJECT_DATA *Devices_Table_List[MAX_NUM_DEVICES] = {
+    &Devices_Table[0]
+};
+static DEVICE_OBJECT_DATA **Devices = Devices_Table_List;
+static unsigned Devices_Size = MAX_NUM_DEVICES;
+/* Open addressing hash tables of Device index plus one, where zero is an
+   empty slot: one keyed by the virtual MAC address of the routed Devices,
+   and one keyed by the Device instance number of all the Devices.
+   They are kept at least twice the size of the Devices list, so that
+   the routing of a PDU does not depend on the number of Devices. */
+static unsigned Devices_Table_MAC_Hash[MAX_NUM_DEVICES * 2];
+static unsigned Devices_Table_Instance_Hash[MAX_NUM_DEVICES * 2];
+static unsigned *MAC_Hash = Devices_Table_MAC_Hash;
+static unsigned *Instance_Hash = Devices_Table_Instance_Hash;
+static unsigned Hash_Size = MAX_NUM_DEVICES * 2;
 /** Keep track of the number of managed devices, including the gateway */
 uint16_t Num_Managed_Devices = 0;
 /** Which Device entry are we currently managing.
@@ -101,6 +122,223 @@ uint16_t iCurrent_Device_Idx = 0;
  * found in device.c
  */
 
+/**
+ * @brief Compute the home hash slot of a virtual MAC address
+ */
+static unsigned routed_mac_hash_slot(uint8_t len, const uint8_t *adr)
+{
+    uint32_t hash = 2166136261UL;
+    uint8_t i;
+
+    for (i = 0; i < len; i++) {
+        hash ^= adr[i];
+        hash *= 16777619UL;
+    }
+    hash ^= len;
+    hash *= 16777619UL;
+
+    return (unsigned)(hash % Hash_Size);
+}
+
+/**
+ * @brief Compute the home hash slot of a Device instance number
+ */
+static unsigned routed_instance_hash_slot(uint32_t instance)
+{
+    return (unsigned)((instance * 2654435761UL) % Hash_Size);
+}
+
+/**
+ * @brief Compute the home hash slot of a Device in one of the hash tables
+ */
+static unsigned routed_hash_slot(unsigned *hash, unsigned idx)
+{
+    DEVICE_OBJECT_DATA *pDev = Devices[idx];
+
+    if (hash == MAC_Hash) {
+        return routed_mac_hash_slot(pDev->bacDevAddr.len, pDev->bacDevAddr.adr);
+    }
+
+    return routed_instance_hash_slot(pDev->bacObj.Object_Instance_Number);
+}
+
+/**
+ * @brief Determine if a Device belongs in the virtual MAC hash table.
+ *  The gateway Device is reached without routing, and a routed Device
+ *  without an address cannot be addressed.
+ */
+static bool routed_mac_hashed(unsigned idx)
+{
+    return (idx > 0) && (Devices[idx]->bacDevAddr.len > 0) &&
+        (Devices[idx]->bacDevAddr.len <= MAX_MAC_LEN);
+}
+
+/**
+ * @brief Store a Device index in a hash table
+ */
+static void routed_hash_insert(unsigned *hash, unsigned idx)
+{
+    unsigned slot = routed_hash_slot(hash, idx);
+
+    while (hash[slot]) {
+        slot = (slot + 1) % Hash_Size;
+    }
+    hash[slot] = idx + 1;
+}
+
+/**
+ * @brief Remove a Device index from a hash table, and shift the
+ *  following entries of the cluster back so no tombstone is needed
+ */
+static void routed_hash_remove(unsigned *hash, unsigned idx)
+{
+    unsigned slot = routed_hash_slot(hash, idx);
+    unsigned next;
+    unsigned home;
+
+    while (hash[slot] && (hash[slot] != (idx + 1))) {
+        slot = (slot + 1) % Hash_Size;
+    }
+    if (!hash[slot]) {
+        return;
+    }
+    hash[slot] = 0;
+    next = slot;
+    for (;;) {
+        next = (next + 1) % Hash_Size;
+        if (!hash[next]) {
+            break;
+        }
+        home = routed_hash_slot(hash, hash[next] - 1);
+        /* move the entry if its home is not cyclically in (slot, next] */
+        if ((slot <= next) ? ((home <= slot) || (home > next))
+                           : ((home <= slot) && (home > next))) {
+            hash[slot] = hash[next];
+            hash[next] = 0;
+            slot = next;
+        }
+    }
+}
+
+/**
+ * @brief Find the routed Device with a virtual MAC address
+ * @return Device index, or 0 if not found
+ */
+static unsigned routed_mac_find(uint8_t len, const uint8_t *adr)
+{
+    unsigned slot = routed_mac_hash_slot(len, adr);
+    DEVICE_OBJECT_DATA *pDev;
+
+    while (MAC_Hash[slot]) {
+        pDev = Devices[MAC_Hash[slot] - 1];
+        if ((pDev->bacDevAddr.len == len) &&
+            (memcmp(pDev->bacDevAddr.adr, adr, len) == 0)) {
+            return MAC_Hash[slot] - 1;
+        }
+        slot = (slot + 1) % Hash_Size;
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Grow the hash tables to twice their size, and rebuild them
+ * @return true if the hash tables have room for one more Device
+ */
+static bool routed_hash_grow(void)
+{
+    unsigned *mac_hash;
+    unsigned *instance_hash;
+    unsigned size = Hash_Size * 2;
+    unsigned i;
+
+    mac_hash = calloc(size, sizeof(unsigned));
+    instance_hash = calloc(size, sizeof(unsigned));
+    if (!mac_hash || !instance_hash) {
+        free(mac_hash);
+        free(instance_hash);
+        return false;
+    }
+    if (MAC_Hash != Devices_Table_MAC_Hash) {
+        free(MAC_Hash);
+        free(Instance_Hash);
+    }
+    MAC_Hash = mac_hash;
+    Instance_Hash = instance_hash;
+    Hash_Size = size;
+    for (i = 0; i < Num_Managed_Devices; i++) {
+        routed_hash_insert(Instance_Hash, i);
+        if (routed_mac_hashed(i)) {
+            routed_hash_insert(MAC_Hash, i);
+        }
+    }
+
+    return true;
+}
+
+/**
+ * @brief Make room in the Devices list for one more Device
+ * @return the storage of the new Device, or NULL if there is no room
+ */
+static DEVICE_OBJECT_DATA *routed_device_alloc(void)
+{
+    DEVICE_OBJECT_DATA **list;
+    DEVICE_OBJECT_DATA *pDev;
+    unsigned size;
+
+    if (Num_Managed_Devices >= MAX_ROUTED_DEVICES) {
+        return NULL;
+    }
+    if (((unsigned)Num_Managed_Devices + 1) * 2 > Hash_Size) {
+        if (!routed_hash_grow()) {
+            return NULL;
+        }
+    }
+    if (Num_Managed_Devices >= Devices_Size) {
+        size = Devices_Size * 2;
+        if (size > MAX_ROUTED_DEVICES) {
+            size = MAX_ROUTED_DEVICES;
+        }
+        if (Devices == Devices_Table_List) {
+            list = malloc(size * sizeof(DEVICE_OBJECT_DATA *));
+            if (list) {
+                memcpy(list, Devices_Table_List, sizeof(Devices_Table_List));
+            }
+        } else {
+            list = realloc(Devices, size * sizeof(DEVICE_OBJECT_DATA *));
+        }
+        if (!list) {
+            return NULL;
+        }
+        Devices = list;
+        Devices_Size = size;
+    }
+    if (Num_Managed_Devices < MAX_NUM_DEVICES) {
+        pDev = &Devices_Table[Num_Managed_Devices];
+        memset(pDev, 0, sizeof(DEVICE_OBJECT_DATA));
+    } else {
+        pDev = calloc(1, sizeof(DEVICE_OBJECT_DATA));
+    }
+
+    return pDev;
+}
+
+/**
+ * @brief Make a Device the current one, with its object table
+ */
+static void routed_device_select(unsigned idx)
+{
+    object_functions_t *object_table = Devices[idx]->Object_Table;
+
+    iCurrent_Device_Idx = idx;
+    if (!object_table) {
+        object_table = Devices[0]->Object_Table;
+    }
+    if (object_table) {
+        Device_Context()->Object_Table = object_table;
+    }
+}
+
 /** Add a Device to our table of Devices[].
  * The first entry must be the gateway device.
  * @param Object_Instance [in] Set the new Device to this instance number.
@@ -114,12 +352,19 @@ uint16_t Add_Routed_Device(uint32_t Object_Instance,
     const char *sDescription)
 {
     int i = Num_Managed_Devices;
-    if (i < MAX_NUM_DEVICES) {
-        DEVICE_OBJECT_DATA *pDev = &Devices[i];
+    DEVICE_OBJECT_DATA *pDev = routed_device_alloc();
+
+    if (pDev) {
+        Devices[i] = pDev;
         Num_Managed_Devices++;
-        iCurrent_Device_Idx = i;
+        if (i == 0) {
+            /* the gateway keeps the object table of the Device context */
+            pDev->Object_Table = Device_Context()->Object_Table;
+        }
+        routed_device_select(i);
         pDev->bacObj.mObject_Type = OBJECT_DEVICE;
         pDev->bacObj.Object_Instance_Number = Object_Instance;
+        routed_hash_insert(Instance_Hash, i);
         if (sObject_Name != NULL) {
             Routed_Device_Set_Object_Name(sObject_Name->encoding,
                 sObject_Name->value, sObject_Name->length);
@@ -139,6 +384,23 @@ uint16_t Add_Routed_Device(uint32_t Object_Instance,
     }
 }
 
+/** Return the number of Devices in our table, including the gateway.
+ * @return The number of Devices.
+ */
+uint16_t Routed_Device_Count(void)
+{
+    return Num_Managed_Devices;
+}
+
+/** Return the index of the current Device, as selected by
+ * Get_Routed_Device_Object() or Routed_Device_GetNext().
+ * @return The index into Devices[], 0 for the gateway Device.
+ */
+uint16_t Routed_Device_Current_Index(void)
+{
+    return iCurrent_Device_Idx;
+}
+
 /** Return the Device Object descriptive data for the indicated entry.
  * @param idx [in] Index into Devices[] array being requested.
  *                 0 is for the main, gateway Device entry.
@@ -147,14 +409,19 @@ uint16_t Add_Routed_Device(uint32_t Object_Instance,
  *                 If valid idx, will set iCurrent_Device_Idx with the idx
  * @return Pointer to the requested Device Object data, or NULL if the idx
  *         is for an invalid row entry (eg, after the last good Device).
+ * @note Use Routed_Device_Set_Address() and
+ *       Routed_Device_Set_Object_Instance_Number() to change the address
+ *       or the instance number, so that the Device can be found by them.
  */
 DEVICE_OBJECT_DATA *Get_Routed_Device_Object(int idx)
 {
-    if (idx == -1) {
-        return &Devices[iCurrent_Device_Idx];
-    } else if ((idx >= 0) && (idx < MAX_NUM_DEVICES)) {
-        iCurrent_Device_Idx = idx;
-        return &Devices[idx];
+    if (Num_Managed_Devices == 0) {
+        return NULL;
+    } else if (idx == -1) {
+        return Devices[iCurrent_Device_Idx];
+    } else if ((idx >= 0) && (idx < Num_Managed_Devices)) {
+        routed_device_select(idx);
+        return Devices[idx];
     } else {
         return NULL;
     }
@@ -171,14 +438,77 @@ DEVICE_OBJECT_DATA *Get_Routed_Device_Object(int idx)
  */
 BACNET_ADDRESS *Get_Routed_Device_Address(int idx)
 {
-    if (idx == -1) {
-        return &Devices[iCurrent_Device_Idx].bacDevAddr;
-    } else if ((idx >= 0) && (idx < MAX_NUM_DEVICES)) {
-        iCurrent_Device_Idx = idx;
-        return &Devices[idx].bacDevAddr;
-    } else {
-        return NULL;
+    DEVICE_OBJECT_DATA *pDev = Get_Routed_Device_Object(idx);
+
+    if (pDev) {
+        return &pDev->bacDevAddr;
+    }
+
+    return NULL;
+}
+
+/** Set the BACnet address of the indicated entry, and index its virtual
+ * MAC address for routing.
+ * @param idx [in] Index into Devices[] array; 0 is the gateway Device.
+ * @param address [in] The new BACnet address of the Device.
+ * @return True if the address was set.
+ */
+bool Routed_Device_Set_Address(int idx, BACNET_ADDRESS *address)
+{
+    if ((idx < 0) || (idx >= Num_Managed_Devices) || !address) {
+        return false;
+    }
+    if (routed_mac_hashed(idx)) {
+        routed_hash_remove(MAC_Hash, idx);
+    }
+    bacnet_address_copy(&Devices[idx]->bacDevAddr, address);
+    if (routed_mac_hashed(idx)) {
+        routed_hash_insert(MAC_Hash, idx);
     }
+
+    return true;
+}
+
+/** Give a Device its own object table, instead of sharing the object
+ * table of the gateway Device. The Device object entry of the table is
+ * replaced by the routed versions of its functions, as done by
+ * Routing_Device_Init() for the gateway, and the table is selected
+ * whenever the Device is addressed. The caller initializes the objects.
+ * @param idx [in] Index into Devices[] array; 0 is the gateway Device.
+ * @param object_table [in] writable array of object functions, or NULL to
+ *  share the object table of the gateway Device again.
+ * @return True if the object table was set.
+ */
+bool Routed_Device_Set_Object_Table(int idx, object_functions_t *object_table)
+{
+    object_functions_t *pObject = object_table;
+
+    if ((idx < 0) || (idx >= Num_Managed_Devices)) {
+        return false;
+    }
+    while (pObject && (pObject->Object_Type < MAX_BACNET_OBJECT_TYPE)) {
+        if (pObject->Object_Type == OBJECT_DEVICE) {
+            pObject->Object_Index_To_Instance =
+                Routed_Device_Index_To_Instance;
+            pObject->Object_Valid_Instance =
+                Routed_Device_Valid_Object_Instance_Number;
+            pObject->Object_Name = Routed_Device_Name;
+            pObject->Object_Read_Property = Routed_Device_Read_Property_Local;
+            pObject->Object_Write_Property =
+                Routed_Device_Write_Property_Local;
+            break;
+        }
+        pObject++;
+    }
+    if ((idx == 0) && !object_table) {
+        return false;
+    }
+    Devices[idx]->Object_Table = object_table;
+    if (idx == iCurrent_Device_Idx) {
+        routed_device_select(idx);
+    }
+
+    return true;
 }
 
 /** Get the currently active BACnet address.
@@ -190,8 +520,8 @@ BACNET_ADDRESS *Get_Routed_Device_Address(int idx)
  */
 void routed_get_my_address(BACNET_ADDRESS *my_address)
 {
-    if (my_address) {
-        memcpy(my_address, &Devices[iCurrent_Device_Idx].bacDevAddr,
+    if (my_address && (iCurrent_Device_Idx < Num_Managed_Devices)) {
+        memcpy(my_address, &Devices[iCurrent_Device_Idx]->bacDevAddr,
             sizeof(BACNET_ADDRESS));
     }
 }
@@ -219,11 +549,11 @@ bool Routed_Device_Address_Lookup(int idx, uint8_t dlen, uint8_t *dadr)
     DEVICE_OBJECT_DATA *pDev;
     int i;
 
-    if ((idx >= 0) && (idx < MAX_NUM_DEVICES)) {
-        pDev = &Devices[idx];
+    if ((idx >= 0) && (idx < Num_Managed_Devices)) {
+        pDev = Devices[idx];
         if (dlen == 0) {
             /* Automatic match */
-            iCurrent_Device_Idx = idx;
+            routed_device_select(idx);
             result = true;
         } else if (dadr != NULL) {
             for (i = 0; i < dlen; i++) {
@@ -232,7 +562,7 @@ bool Routed_Device_Address_Lookup(int idx, uint8_t dlen, uint8_t *dadr)
                 }
             }
             if (i == dlen) { /* Success! */
-                iCurrent_Device_Idx = idx;
+                routed_device_select(idx);
                 result = true;
             }
         }
@@ -275,7 +605,7 @@ bool Routed_Device_GetNext(BACNET_ADDRESS *dest, int *DNET_list, int *cursor)
     /* First, see if the index is out of range.
      * Eg, last call to GetNext may have been the last successful one.
      */
-    if ((idx < 0) || (idx >= MAX_NUM_DEVICES)) {
+    if ((idx < 0) || (idx >= Num_Managed_Devices)) {
         idx = -1;
 
         /* Next, see if it's a BACnet broadcast.
@@ -296,27 +626,33 @@ bool Routed_Device_GetNext(BACNET_ADDRESS *dest, int *DNET_list, int *cursor)
         /* Next step: no more matches: */
         idx = -1;
     }
-    /* Or if is our virtual DNET, check
-     * against each of our virtually routed Devices.
-     * If we get a match, have it handle the APDU.
-     * For broadcasts, all Devices get a chance at it.
+    /* Or if is our virtual DNET, a broadcast goes to each of our
+     * virtually routed Devices in turn, and a unicast goes to the one
+     * Device with that virtual MAC address, found in the hash table.
      */
     else if (dest->net == dnet) {
         if (idx == 0) { /* Step over this case (starting point) */
             idx = 1;
         }
-        while (idx < MAX_NUM_DEVICES) {
-            bSuccess =
-                Routed_Device_Address_Lookup(idx++, dest->len, dest->adr);
-            if (bSuccess) {
-                break; /* We don't need to keep looking */
+        if (dest->len == 0) {
+            if (idx < Num_Managed_Devices) {
+                bSuccess = Routed_Device_Address_Lookup(idx++, 0, NULL);
             }
+        } else if (dest->len <= MAX_MAC_LEN) {
+            idx = routed_mac_find(dest->len, dest->adr);
+            if (idx > 0) {
+                routed_device_select(idx);
+                bSuccess = true;
+            }
+            /* a virtual MAC address is unique */
+            idx = -1;
         }
     }
 
     if (!bSuccess) {
         *cursor = -1;
-    } else if (idx == MAX_NUM_DEVICES) { /* No more to GetNext */
+    } else if ((idx < 0) || (idx >= Num_Managed_Devices)) {
+        /* No more to GetNext */
         *cursor = -1;
     } else {
         *cursor = idx;
@@ -362,25 +698,31 @@ bool Routed_Device_Is_Valid_Network(uint16_t dest_net, int *DNET_list)
 uint32_t Routed_Device_Index_To_Instance(unsigned index)
 {
     index = index;
-    return Devices[iCurrent_Device_Idx].bacObj.Object_Instance_Number;
+    return Devices[iCurrent_Device_Idx]->bacObj.Object_Instance_Number;
 }
 
 /**
- * For a given object instance-number, determines a 1..N-1 index
- * of Device objects where N is MAX_NUM_DEVICES
+ * For a given object instance-number, determines a 0..N-1 index
+ * of Device objects where N is the number of Devices
  *
  * @param  object_instance - object-instance number of the object
  * @return  index for the given instance-number, or 0 if not valid.
  */
 static uint32_t Routed_Device_Instance_To_Index(uint32_t Instance_Number)
 {
-    int i;
+    unsigned slot;
 
-    for (i = 0; i < MAX_NUM_DEVICES; i++) {
-        if (Devices[i].bacObj.Object_Instance_Number == Instance_Number) {
+    if (Num_Managed_Devices == 0) {
+        return 0;
+    }
+    slot = routed_instance_hash_slot(Instance_Number);
+    while (Instance_Hash[slot]) {
+        if (Devices[Instance_Hash[slot] - 1]->bacObj.Object_Instance_Number ==
+            Instance_Number) {
             /* Found Instance, so return the Device Index Number */
-            return i;
+            return Instance_Hash[slot] - 1;
         }
+        slot = (slot + 1) % Hash_Size;
     }
 
     /* We did not find instance... so simply return an Index of 0
@@ -399,8 +741,11 @@ bool Routed_Device_Valid_Object_Instance_Number(uint32_t object_id)
     bool valid = false;
     DEVICE_OBJECT_DATA *pDev = NULL;
 
-    iCurrent_Device_Idx = Routed_Device_Instance_To_Index(object_id);
-    pDev = &Devices[iCurrent_Device_Idx];
+    if (Num_Managed_Devices == 0) {
+        return false;
+    }
+    routed_device_select(Routed_Device_Instance_To_Index(object_id));
+    pDev = Devices[iCurrent_Device_Idx];
     if (pDev->bacObj.Object_Instance_Number == object_id) {
         valid = true;
     }
@@ -411,7 +756,7 @@ bool Routed_Device_Valid_Object_Instance_Number(uint32_t object_id)
 bool Routed_Device_Name(
     uint32_t object_instance, BACNET_CHARACTER_STRING *object_name)
 {
-    DEVICE_OBJECT_DATA *pDev = &Devices[iCurrent_Device_Idx];
+    DEVICE_OBJECT_DATA *pDev = Devices[iCurrent_Device_Idx];
     if (object_instance == pDev->bacObj.Object_Instance_Number) {
         return characterstring_init_ansi(object_name, pDev->bacObj.Object_Name);
     }
@@ -430,7 +775,7 @@ int Routed_Device_Read_Property_Local(BACNET_READ_PROPERTY_DATA *rpdata)
     int apdu_len = 0; /* return value */
     BACNET_CHARACTER_STRING char_string;
     uint8_t *apdu = NULL;
-    DEVICE_OBJECT_DATA *pDev = &Devices[iCurrent_Device_Idx];
+    DEVICE_OBJECT_DATA *pDev = Devices[iCurrent_Device_Idx];
 
     if ((rpdata == NULL) || (rpdata->application_data == NULL) ||
         (rpdata->application_data_len == 0)) {
@@ -531,7 +876,7 @@ bool Routed_Device_Write_Property_Local(BACNET_WRITE_PROPERTY_DATA *wp_data)
  */
 uint32_t Routed_Device_Object_Instance_Number(void)
 {
-    return Devices[iCurrent_Device_Idx].bacObj.Object_Instance_Number;
+    return Devices[iCurrent_Device_Idx]->bacObj.Object_Instance_Number;
 }
 
 bool Routed_Device_Set_Object_Instance_Number(uint32_t object_id)
@@ -540,7 +885,13 @@ bool Routed_Device_Set_Object_Instance_Number(uint32_t object_id)
 
     if (object_id <= BACNET_MAX_INSTANCE) {
         /* Make the change and update the database revision */
-        Devices[iCurrent_Device_Idx].bacObj.Object_Instance_Number = object_id;
+        if (iCurrent_Device_Idx < Num_Managed_Devices) {
+            routed_hash_remove(Instance_Hash, iCurrent_Device_Idx);
+        }
+        Devices[iCurrent_Device_Idx]->bacObj.Object_Instance_Number = object_id;
+        if (iCurrent_Device_Idx < Num_Managed_Devices) {
+            routed_hash_insert(Instance_Hash, iCurrent_Device_Idx);
+        }
         Routed_Device_Inc_Database_Revision();
     } else {
         status = false;
@@ -559,7 +910,7 @@ bool Routed_Device_Set_Object_Name(
     uint8_t encoding, const char *value, size_t length)
 {
     bool status = false; /*return value */
-    DEVICE_OBJECT_DATA *pDev = &Devices[iCurrent_Device_Idx];
+    DEVICE_OBJECT_DATA *pDev = Devices[iCurrent_Device_Idx];
 
     if ((encoding == CHARACTER_UTF8) && (length < MAX_DEV_NAME_LEN)) {
         /* Make the change and update the database revision */
@@ -575,7 +926,7 @@ bool Routed_Device_Set_Object_Name(
 bool Routed_Device_Set_Description(const char *name, size_t length)
 {
     bool status = false; /*return value */
-    DEVICE_OBJECT_DATA *pDev = &Devices[iCurrent_Device_Idx];
+    DEVICE_OBJECT_DATA *pDev = Devices[iCurrent_Device_Idx];
 
     if (length < MAX_DEV_DESC_LEN) {
         memmove(pDev->Description, name, length);
@@ -593,7 +944,7 @@ bool Routed_Device_Set_Description(const char *name, size_t length)
  */
 void Routed_Device_Inc_Database_Revision(void)
 {
-    DEVICE_OBJECT_DATA *pDev = &Devices[iCurrent_Device_Idx];
+    DEVICE_OBJECT_DATA *pDev = Devices[iCurrent_Device_Idx];
     pDev->Database_Revision++;
 }
 
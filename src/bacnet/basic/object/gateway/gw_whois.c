@@ -0,0 +1,280 @@
+/**
+ * @file
+ * @date October 2026
+ * @brief Paces the I-Am responses of the routed Devices of a gateway,
+ *  so that a Who-Is is not answered in one burst
+ *
+ * @section LICENSE
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+#include <stdbool.h>
+#include <stdint.h>
+#include "bacnet/bacdef.h"
+#include "bacnet/bacaddr.h"
+#include "bacnet/config.h"
+#include "bacnet/whois.h"
+#include "bacnet/basic/object/device.h"
+#include "bacnet/basic/services.h"
+#include "bacnet/basic/tsm/tsm.h"
+#include "bacnet/basic/sys/mstimer.h"
+
+#if !defined(BAC_ROUTING)
+#ifdef _MSC_VER
+#pragma message This file should not be included in the build unless \
+    BAC_ROUTING is enabled.
+#else
+#warning This file should not be included in the build unless BAC_ROUTING is enabled.
+#endif
+#endif
+
+/* I-Am responses waiting to be sent to one destination.
+   A bit is set for each pending Device index, so a repeated Who-Is
+   does not queue a Device twice. */
+struct who_is_i_am_dest {
+    bool used;
+    BACNET_ADDRESS address;
+    unsigned count;
+    unsigned cursor;
+    uint8_t pending[(MAX_ROUTED_DEVICES + 7) / 8];
+};
+/* entry 0 is for broadcast I-Am, the rest for unicast */
+static struct who_is_i_am_dest I_Am_Dest[1 + WHO_IS_I_AM_DEST_MAX];
+static unsigned I_Am_Dest_Next;
+static unsigned I_Am_Pending;
+/* pacing: I-Am per second, and tokens in thousandths of an I-Am */
+static uint32_t I_Am_Window = WHO_IS_I_AM_WINDOW;
+static uint32_t I_Am_Rate_Max = WHO_IS_I_AM_RATE;
+static uint32_t I_Am_Rate;
+static uint32_t I_Am_Tokens;
+static unsigned long I_Am_Time;
+
+/** Set the pacing of queued I-Am responses. The rate is a limit for
+ * the datalink, so it is usually lower for MS/TP than for B/IP.
+ * @param window_ms [in] Milliseconds to spread a burst of I-Am over
+ * @param rate [in] Maximum number of I-Am sent per second
+ */
+void handler_who_is_pacing_set(uint32_t window_ms, uint32_t rate)
+{
+    I_Am_Window = window_ms;
+    if (rate) {
+        I_Am_Rate_Max = rate;
+    }
+}
+
+/** Queue an I-Am from a routed Device, to be sent by handler_who_is_task().
+ * @param device_index [in] Index of the routed Device, 0 for the gateway.
+ * @param dest [in] The address to unicast the I-Am to,
+ *                  or NULL to broadcast the I-Am.
+ * @return true if the I-Am is pending, even from an earlier Who-Is.
+ */
+bool handler_who_is_i_am_queue(unsigned device_index, BACNET_ADDRESS *dest)
+{
+    struct who_is_i_am_dest *entry = NULL;
+    unsigned i;
+    uint8_t mask;
+    uint32_t rate;
+
+    if (device_index >= MAX_ROUTED_DEVICES) {
+        return false;
+    }
+    if (dest) {
+        for (i = 1; i <= WHO_IS_I_AM_DEST_MAX; i++) {
+            if (I_Am_Dest[i].used &&
+                bacnet_address_same(&I_Am_Dest[i].address, dest)) {
+                entry = &I_Am_Dest[i];
+                break;
+            }
+            if (!entry && !I_Am_Dest[i].used) {
+                entry = &I_Am_Dest[i];
+            }
+        }
+        if (entry && !entry->used) {
+            bacnet_address_copy(&entry->address, dest);
+            entry->used = true;
+        }
+    }
+    if (!entry) {
+        /* too many clients at once: a broadcast I-Am reaches them too */
+        entry = &I_Am_Dest[0];
+        entry->used = true;
+    }
+    mask = 1 << (device_index & 7);
+    if (entry->pending[device_index / 8] & mask) {
+        return true;
+    }
+    entry->pending[device_index / 8] |= mask;
+    entry->count++;
+    if (I_Am_Pending == 0) {
+        /* the first I-Am of a burst goes out on the next task */
+        I_Am_Tokens = 1000;
+        I_Am_Time = mstimer_now();
+    }
+    I_Am_Pending++;
+    /* fast enough to empty the queue within the window */
+    rate = I_Am_Rate_Max;
+    if (I_Am_Window) {
+        rate = (I_Am_Pending * 1000UL) / I_Am_Window + 1;
+        if (rate > I_Am_Rate_Max) {
+            rate = I_Am_Rate_Max;
+        }
+    }
+    if (rate > I_Am_Rate) {
+        I_Am_Rate = rate;
+    }
+
+    return true;
+}
+
+/** Take the next pending Device index from a destination.
+ * @param entry [in] The destination with pending I-Am
+ * @return The index of the Device
+ */
+static unsigned who_is_i_am_next(struct who_is_i_am_dest *entry)
+{
+    unsigned index = entry->cursor;
+    uint8_t mask;
+
+    for (;;) {
+        if (index >= MAX_ROUTED_DEVICES) {
+            index = 0;
+        }
+        if (entry->pending[index / 8] == 0) {
+            index = (index | 7) + 1;
+            continue;
+        }
+        mask = 1 << (index & 7);
+        if (entry->pending[index / 8] & mask) {
+            entry->pending[index / 8] &= ~mask;
+            break;
+        }
+        index++;
+    }
+    entry->cursor = index + 1;
+    entry->count--;
+    if (entry->count == 0) {
+        entry->used = false;
+        entry->cursor = 0;
+    }
+
+    return index;
+}
+
+/** Send the queued I-Am responses that are due. Each call sends up to
+ * WHO_IS_I_AM_BATCH of them back to back from one transmit buffer.
+ * Call it often from the main loop while handler_who_is_pending().
+ */
+void handler_who_is_task(void)
+{
+    BACNET_TRANSMIT_CONTEXT *tx = NULL;
+    struct who_is_i_am_dest *entry = NULL;
+    unsigned long now;
+    unsigned long elapsed;
+    uint16_t current_index;
+    unsigned index;
+    unsigned i;
+
+    if (I_Am_Pending == 0) {
+        return;
+    }
+    now = mstimer_now();
+    elapsed = now - I_Am_Time;
+    I_Am_Time = now;
+    if (elapsed > WHO_IS_I_AM_BATCH * 1000UL) {
+        elapsed = WHO_IS_I_AM_BATCH * 1000UL;
+    }
+    I_Am_Tokens += elapsed * I_Am_Rate;
+    if (I_Am_Tokens > WHO_IS_I_AM_BATCH * 1000UL) {
+        I_Am_Tokens = WHO_IS_I_AM_BATCH * 1000UL;
+    }
+    if (I_Am_Tokens < 1000) {
+        return;
+    }
+    tx = tsm_transmit_context_acquire();
+    if (!tx) {
+        return;
+    }
+    current_index = Routed_Device_Current_Index();
+    while ((I_Am_Tokens >= 1000) && (I_Am_Pending > 0)) {
+        /* take turns between the destinations */
+        for (i = 0; i <= WHO_IS_I_AM_DEST_MAX; i++) {
+            entry = &I_Am_Dest[I_Am_Dest_Next];
+            I_Am_Dest_Next++;
+            if (I_Am_Dest_Next > WHO_IS_I_AM_DEST_MAX) {
+                I_Am_Dest_Next = 0;
+            }
+            if (entry->count) {
+                break;
+            }
+        }
+        index = who_is_i_am_next(entry);
+        I_Am_Pending--;
+        I_Am_Tokens -= 1000;
+        if (Get_Routed_Device_Object(index)) {
+            if (entry == &I_Am_Dest[0]) {
+                Send_I_Am(&tx->pdu[0]);
+            } else {
+                Send_I_Am_Unicast(&tx->pdu[0], &entry->address);
+            }
+        }
+    }
+    tsm_transmit_context_release(tx);
+    Get_Routed_Device_Object(current_index);
+    if (I_Am_Pending == 0) {
+        I_Am_Rate = 0;
+    }
+}
+
+/** Return the number of queued I-Am responses.
+ * @return The number of I-Am waiting for handler_who_is_task()
+ */
+unsigned handler_who_is_pending(void)
+{
+    return I_Am_Pending;
+}
+
+/** Handler for Who-Is requests to one routed Device at a time, as
+ * routing_npdu_handler() calls it for each Device of a broadcast,
+ * with a paced unicast I-Am response from the current Device.
+ * The I-Am is only sent when the main loop calls handler_who_is_task().
+ *
+ * @ingroup DMDDB
+ * @param service_request [in] The received message to be handled.
+ * @param service_len [in] Length of the service_request message.
+ * @param src [in] The BACNET_ADDRESS of the message's source that the
+ *                 response will be sent back to.
+ */
+void handler_who_is_unicast_paced(
+    uint8_t *service_request, uint16_t service_len, BACNET_ADDRESS *src)
+{
+    int len = 0;
+    int32_t low_limit = 0;
+    int32_t high_limit = 0;
+
+    len = whois_decode_service_request(
+        service_request, service_len, &low_limit, &high_limit);
+    if ((len == 0) ||
+        ((len != BACNET_STATUS_ERROR) &&
+            (Device_Object_Instance_Number() >= (uint32_t)low_limit) &&
+            (Device_Object_Instance_Number() <= (uint32_t)high_limit))) {
+        handler_who_is_i_am_queue(Routed_Device_Current_Index(), src);
+    }
+}
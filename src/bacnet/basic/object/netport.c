@@ -45,6 +45,7 @@
 #include "bacnet/npdu.h"
 #include "bacnet/apdu.h"
 #include "bacnet/datalink/datalink.h"
+#include "bacnet/datalink/dlmstp.h"
 #include "bacnet/basic/object/device.h"
 /* me */
 #include "bacnet/basic/object/netport.h"
@@ -99,6 +100,8 @@ struct mstp_port {
     uint8_t MAC_Address;
     uint8_t Max_Master;
     uint8_t Max_Info_Frames;
+    uint8_t Max_Info_Frames_Adaptive;
+    struct dlmstp_statistics Statistics;
 };
 
 struct object_data {
@@ -156,6 +159,12 @@ static const int BIP6_Port_Properties_Optional[] = { PROP_MAC_ADDRESS,
 
 static const int Network_Port_Properties_Proprietary[] = { -1 };
 
+static const int MSTP_Port_Properties_Proprietary[] = {
+    PROP_MSTP_MAX_INFO_FRAMES_ADAPTIVE, PROP_MSTP_TRANSMIT_QUEUE_DEPTH,
+    PROP_MSTP_TRANSMIT_QUEUE_PEAK, PROP_MSTP_TRANSMIT_QUEUE_DROPS,
+    PROP_MSTP_TOKEN_HOLDS, PROP_MSTP_TOKEN_UTILIZATION,
+    PROP_MSTP_TOKEN_ROTATION_TIME, PROP_MSTP_INFO_FRAMES_BUDGET, -1 };
+
 /**
  * Returns the list of required, optional, and proprietary properties.
  * Used by ReadPropertyMultiple service.
@@ -200,6 +209,11 @@ void Network_Port_Property_List(uint32_t object_instance,
     }
     if (pProprietary) {
         *pProprietary = Network_Port_Properties_Proprietary;
+        index = Network_Port_Instance_To_Index(object_instance);
+        if ((index < BACNET_NETWORK_PORTS_MAX) &&
+            (Object_List[index].Network_Type == PORT_TYPE_MSTP)) {
+            *pProprietary = MSTP_Port_Properties_Proprietary;
+        }
     }
 
     return;
@@ -2160,6 +2174,139 @@ bool Network_Port_MSTP_Max_Info_Frames_Set(
     return status;
 }
 
+/**
+ * For a given object instance-number, gets the adaptive Max_Info_Frames
+ * limit of an MS/TP port
+ * Note: depends on Network_Type being set to PORT_TYPE_MSTP for this object
+ *
+ * @param  object_instance - object-instance number of the object
+ *
+ * @return adaptive Max_Info_Frames limit, or 0 when disabled
+ */
+uint8_t Network_Port_MSTP_Max_Info_Frames_Adaptive(uint32_t object_instance)
+{
+    uint8_t value = 0;
+    unsigned index = 0;
+
+    index = Network_Port_Instance_To_Index(object_instance);
+    if (index < BACNET_NETWORK_PORTS_MAX) {
+        if (Object_List[index].Network_Type == PORT_TYPE_MSTP) {
+            value = Object_List[index].Network.MSTP.Max_Info_Frames_Adaptive;
+        }
+    }
+
+    return value;
+}
+
+/**
+ * For a given object instance-number, sets the adaptive Max_Info_Frames
+ * limit of an MS/TP port
+ * Note: depends on Network_Type being set to PORT_TYPE_MSTP for this object
+ *
+ * @param  object_instance - object-instance number of the object
+ * @param  value - adaptive Max_Info_Frames limit 0..255, 0=disabled
+ *
+ * @return  true if values are within range and property is set.
+ */
+bool Network_Port_MSTP_Max_Info_Frames_Adaptive_Set(
+    uint32_t object_instance, uint8_t value)
+{
+    bool status = false;
+    unsigned index = 0;
+
+    index = Network_Port_Instance_To_Index(object_instance);
+    if (index < BACNET_NETWORK_PORTS_MAX) {
+        if (Object_List[index].Network_Type == PORT_TYPE_MSTP) {
+            if (Object_List[index].Network.MSTP.Max_Info_Frames_Adaptive !=
+                value) {
+                Object_List[index].Changes_Pending = true;
+            }
+            Object_List[index].Network.MSTP.Max_Info_Frames_Adaptive = value;
+            status = true;
+        }
+    }
+
+    return status;
+}
+
+/**
+ * For a given object instance-number, gets the MS/TP datalink transmit
+ * queue and token hold counters
+ * Note: depends on Network_Type being set to PORT_TYPE_MSTP for this object
+ *
+ * @param  object_instance - object-instance number of the object
+ * @param  statistics - MS/TP datalink counters are copied here
+ *
+ * @return  true if the counters were copied
+ */
+bool Network_Port_MSTP_Statistics(
+    uint32_t object_instance, struct dlmstp_statistics *statistics)
+{
+    bool status = false;
+    unsigned index = 0;
+
+    index = Network_Port_Instance_To_Index(object_instance);
+    if ((index < BACNET_NETWORK_PORTS_MAX) && statistics) {
+        if (Object_List[index].Network_Type == PORT_TYPE_MSTP) {
+            memcpy(statistics, &Object_List[index].Network.MSTP.Statistics,
+                sizeof(struct dlmstp_statistics));
+            status = true;
+        }
+    }
+
+    return status;
+}
+
+/**
+ * For a given object instance-number, sets the MS/TP datalink transmit
+ * queue and token hold counters, typically from dlmstp_fill_statistics()
+ * Note: depends on Network_Type being set to PORT_TYPE_MSTP for this object
+ *
+ * @param  object_instance - object-instance number of the object
+ * @param  statistics - MS/TP datalink counters
+ *
+ * @return  true if the counters were set
+ */
+bool Network_Port_MSTP_Statistics_Set(
+    uint32_t object_instance, const struct dlmstp_statistics *statistics)
+{
+    bool status = false;
+    unsigned index = 0;
+
+    index = Network_Port_Instance_To_Index(object_instance);
+    if ((index < BACNET_NETWORK_PORTS_MAX) && statistics) {
+        if (Object_List[index].Network_Type == PORT_TYPE_MSTP) {
+            memcpy(&Object_List[index].Network.MSTP.Statistics, statistics,
+                sizeof(struct dlmstp_statistics));
+            status = true;
+        }
+    }
+
+    return status;
+}
+
+/**
+ * For a given object instance-number, gets the percentage of the
+ * per-token frame budget used by the MS/TP port
+ *
+ * @param  object_instance - object-instance number of the object
+ *
+ * @return token utilization in percent
+ */
+static float Network_Port_MSTP_Token_Utilization(uint32_t object_instance)
+{
+    struct dlmstp_statistics statistics = { 0 };
+    float value = 0.0;
+
+    if (Network_Port_MSTP_Statistics(object_instance, &statistics) &&
+        (statistics.token_hold_budget_counter > 0)) {
+        value = (float)statistics.token_hold_frame_counter * 100.0f /
+            (float)statistics.token_hold_budget_counter;
+    }
+
+    return value;
+}
+
 /**
  * ReadProperty handler for this object.  For the given ReadProperty
  * data, the application_data is loaded or the error flags are set.
@@ -2174,6 +2321,7 @@ int Network_Port_Read_Property(BACNET_READ_PROPERTY_DATA *rpdata)
 {
     int apdu_len = 0;
     int apdu_size = 0;
+    struct dlmstp_statistics statistics = { 0 };
     BACNET_BIT_STRING bit_string;
     BACNET_OCTET_STRING octet_string;
     BACNET_CHARACTER_STRING char_string;
@@ -2200,7 +2348,7 @@ int Network_Port_Read_Property(BACNET_READ_PROPERTY_DATA *rpdata)
     }
     apdu = rpdata->application_data;
     apdu_size = rpdata->application_data_len;
-    switch (rpdata->object_property) {
+    switch ((uint32_t)rpdata->object_property) {
         case PROP_OBJECT_IDENTIFIER:
             apdu_len = encode_application_object_id(
                 &apdu[0], OBJECT_NETWORK_PORT, rpdata->object_instance);
@@ -2281,6 +2429,45 @@ int Network_Port_Read_Property(BACNET_READ_PROPERTY_DATA *rpdata)
             apdu_len = encode_application_unsigned(&apdu[0],
                 Network_Port_MSTP_Max_Info_Frames(rpdata->object_instance));
             break;
+        case PROP_MSTP_MAX_INFO_FRAMES_ADAPTIVE:
+            apdu_len = encode_application_unsigned(&apdu[0],
+                Network_Port_MSTP_Max_Info_Frames_Adaptive(
+                    rpdata->object_instance));
+            break;
+        case PROP_MSTP_TRANSMIT_QUEUE_DEPTH:
+            Network_Port_MSTP_Statistics(rpdata->object_instance, &statistics);
+            apdu_len = encode_application_unsigned(
+                &apdu[0], statistics.transmit_queue_depth);
+            break;
+        case PROP_MSTP_TRANSMIT_QUEUE_PEAK:
+            Network_Port_MSTP_Statistics(rpdata->object_instance, &statistics);
+            apdu_len = encode_application_unsigned(
+                &apdu[0], statistics.transmit_queue_peak);
+            break;
+        case PROP_MSTP_TRANSMIT_QUEUE_DROPS:
+            Network_Port_MSTP_Statistics(rpdata->object_instance, &statistics);
+            apdu_len = encode_application_unsigned(
+                &apdu[0], statistics.transmit_queue_drop_counter);
+            break;
+        case PROP_MSTP_TOKEN_HOLDS:
+            Network_Port_MSTP_Statistics(rpdata->object_instance, &statistics);
+            apdu_len = encode_application_unsigned(
+                &apdu[0], statistics.token_hold_counter);
+            break;
+        case PROP_MSTP_TOKEN_UTILIZATION:
+            apdu_len = encode_application_real(&apdu[0],
+                Network_Port_MSTP_Token_Utilization(rpdata->object_instance));
+            break;
+        case PROP_MSTP_TOKEN_ROTATION_TIME:
+            Network_Port_MSTP_Statistics(rpdata->object_instance, &statistics);
+            apdu_len = encode_application_unsigned(
+                &apdu[0], statistics.token_rotation_time);
+            break;
+        case PROP_MSTP_INFO_FRAMES_BUDGET:
+            Network_Port_MSTP_Statistics(rpdata->object_instance, &statistics);
+            apdu_len = encode_application_unsigned(
+                &apdu[0], statistics.info_frames_budget);
+            break;
         case PROP_BACNET_IP_MODE:
             apdu_len = encode_application_enumerated(
                 &apdu[0], Network_Port_BIP_Mode(rpdata->object_instance));
@@ -2489,7 +2676,7 @@ bool Network_Port_Write_Property(BACNET_WRITE_PROPERTY_DATA *wp_data)
         return false;
     }
     /* FIXME: len < application_data_len: more data? */
-    switch (wp_data->object_property) {
+    switch ((uint32_t)wp_data->object_property) {
         case PROP_MAX_MASTER:
             status = write_property_type_valid(
                 wp_data, &value, BACNET_APPLICATION_TAG_UNSIGNED_INT);
@@ -2525,6 +2712,24 @@ bool Network_Port_Write_Property(BACNET_WRITE_PROPERTY_DATA *wp_data)
                 }
             }
             break;
+        case PROP_MSTP_MAX_INFO_FRAMES_ADAPTIVE:
+            status = write_property_type_valid(
+                wp_data, &value, BACNET_APPLICATION_TAG_UNSIGNED_INT);
+            if (status) {
+                if (value.type.Unsigned_Int <= 255) {
+                    status = Network_Port_MSTP_Max_Info_Frames_Adaptive_Set(
+                        wp_data->object_instance, value.type.Unsigned_Int);
+                    if (!status) {
+                        wp_data->error_class = ERROR_CLASS_PROPERTY;
+                        wp_data->error_code = ERROR_CODE_UNKNOWN_PROPERTY;
+                    }
+                } else {
+                    status = false;
+                    wp_data->error_class = ERROR_CLASS_PROPERTY;
+                    wp_data->error_code = ERROR_CODE_VALUE_OUT_OF_RANGE;
+                }
+            }
+            break;
         case PROP_OBJECT_IDENTIFIER:
         case PROP_OBJECT_NAME:
         case PROP_OBJECT_TYPE:
@@ -2539,6 +2744,13 @@ bool Network_Port_Write_Property(BACNET_WRITE_PROPERTY_DATA *wp_data)
         case PROP_LINK_SPEED:
         case PROP_CHANGES_PENDING:
         case PROP_APDU_LENGTH:
+        case PROP_MSTP_TRANSMIT_QUEUE_DEPTH:
+        case PROP_MSTP_TRANSMIT_QUEUE_PEAK:
+        case PROP_MSTP_TRANSMIT_QUEUE_DROPS:
+        case PROP_MSTP_TOKEN_HOLDS:
+        case PROP_MSTP_TOKEN_UTILIZATION:
+        case PROP_MSTP_TOKEN_ROTATION_TIME:
+        case PROP_MSTP_INFO_FRAMES_BUDGET:
             wp_data->error_class = ERROR_CLASS_PROPERTY;
             wp_data->error_code = ERROR_CODE_WRITE_ACCESS_DENIED;
             break;
@@ -2583,7 +2795,7 @@ bool Network_Port_Read_Range(
     /* return value */
     bool status = false;
 
-    switch (pRequest->object_property) {
+    switch ((uint32_t)pRequest->object_property) {
         /* required properties */
         case PROP_OBJECT_IDENTIFIER:
         case PROP_OBJECT_NAME:
@@ -2603,6 +2815,14 @@ bool Network_Port_Read_Range(
 #if defined(BACDL_MSTP)
         case PROP_MAX_MASTER:
         case PROP_MAX_INFO_FRAMES:
+        case PROP_MSTP_MAX_INFO_FRAMES_ADAPTIVE:
+        case PROP_MSTP_TRANSMIT_QUEUE_DEPTH:
+        case PROP_MSTP_TRANSMIT_QUEUE_PEAK:
+        case PROP_MSTP_TRANSMIT_QUEUE_DROPS:
+        case PROP_MSTP_TOKEN_HOLDS:
+        case PROP_MSTP_TOKEN_UTILIZATION:
+        case PROP_MSTP_TOKEN_ROTATION_TIME:
+        case PROP_MSTP_INFO_FRAMES_BUDGET:
 #endif
 #if defined(BACDL_BIP)
         case PROP_BACNET_IP_MODE:
@@ -43,6 +43,35 @@
 #include "bacnet/rp.h"
 #include "bacnet/wp.h"
 
+/* proprietary properties of MS/TP ports: the adaptive Max_Info_Frames */
+/* limit, and the transmit queue and token hold counters of the datalink */
+#ifndef PROP_MSTP_MAX_INFO_FRAMES_ADAPTIVE
+#define PROP_MSTP_MAX_INFO_FRAMES_ADAPTIVE 512
+#endif
+#ifndef PROP_MSTP_TRANSMIT_QUEUE_DEPTH
+#define PROP_MSTP_TRANSMIT_QUEUE_DEPTH 513
+#endif
+#ifndef PROP_MSTP_TRANSMIT_QUEUE_PEAK
+#define PROP_MSTP_TRANSMIT_QUEUE_PEAK 514
+#endif
+#ifndef PROP_MSTP_TRANSMIT_QUEUE_DROPS
+#define PROP_MSTP_TRANSMIT_QUEUE_DROPS 515
+#endif
+#ifndef PROP_MSTP_TOKEN_HOLDS
+#define PROP_MSTP_TOKEN_HOLDS 516
+#endif
+#ifndef PROP_MSTP_TOKEN_UTILIZATION
+#define PROP_MSTP_TOKEN_UTILIZATION 517
+#endif
+#ifndef PROP_MSTP_TOKEN_ROTATION_TIME
+#define PROP_MSTP_TOKEN_ROTATION_TIME 518
+#endif
+#ifndef PROP_MSTP_INFO_FRAMES_BUDGET
+#define PROP_MSTP_INFO_FRAMES_BUDGET 519
+#endif
+
+struct dlmstp_statistics;
+
 #ifdef __cplusplus
 extern "C" {
 #endif /* __cplusplus */
@@ -150,6 +179,23 @@ extern "C" {
         uint32_t object_instance,
         uint8_t value);
 
+    BACNET_STACK_EXPORT
+    uint8_t Network_Port_MSTP_Max_Info_Frames_Adaptive(
+        uint32_t object_instance);
+    BACNET_STACK_EXPORT
+    bool Network_Port_MSTP_Max_Info_Frames_Adaptive_Set(
+        uint32_t object_instance,
+        uint8_t value);
+
+    BACNET_STACK_EXPORT
+    bool Network_Port_MSTP_Statistics(
+        uint32_t object_instance,
+        struct dlmstp_statistics *statistics);
+    BACNET_STACK_EXPORT
+    bool Network_Port_MSTP_Statistics_Set(
+        uint32_t object_instance,
+        const struct dlmstp_statistics *statistics);
+
     BACNET_STACK_EXPORT
     float Network_Port_Link_Speed(
         uint32_t object_instance);
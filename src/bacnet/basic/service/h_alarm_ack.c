@@ -42,6 +42,7 @@
 #include "bacnet/basic/object/device.h"
 #include "bacnet/basic/tsm/tsm.h"
 #include "bacnet/basic/services.h"
+#include "bacnet/basic/npdu/npdu_cache.h"
 #include "bacnet/datalink/datalink.h"
 
 /** @file h_alarm_ack.c  Handles Alarm Acknowledgment. */
@@ -77,6 +78,7 @@ void handler_alarm_ack(uint8_t *service_request,
     BACNET_ADDRESS *src,
     BACNET_CONFIRMED_SERVICE_DATA *service_data)
 {
+    BACNET_TRANSMIT_CONTEXT *tx = NULL;
     int len = 0;
     int pdu_len = 0;
 #if PRINT_ENABLED
@@ -88,14 +90,18 @@ void handler_alarm_ack(uint8_t *service_request,
     BACNET_ALARM_ACK_DATA data;
     BACNET_ERROR_CODE error_code;
 
+    tx = tsm_transmit_context_acquire();
+    if (!tx) {
+        /* no transmit buffer available - the client will retry */
+        return;
+    }
     /* encode the NPDU portion of the packet */
     datalink_get_my_address(&my_address);
     npdu_encode_npdu_data(&npdu_data, false, MESSAGE_PRIORITY_NORMAL);
-    pdu_len = npdu_encode_pdu(
-        &Handler_Transmit_Buffer[0], src, &my_address, &npdu_data);
+    pdu_len = npdu_cache_encode_pdu(&tx->pdu[0], src, &my_address, &npdu_data);
     if (service_data->segmented_message) {
         /* we don't support segmentation - send an abort */
-        len = abort_encode_apdu(&Handler_Transmit_Buffer[pdu_len],
+        len = abort_encode_apdu(&tx->pdu[pdu_len],
             service_data->invoke_id, ABORT_REASON_SEGMENTATION_NOT_SUPPORTED,
             true);
 #if PRINT_ENABLED
@@ -111,7 +117,7 @@ void handler_alarm_ack(uint8_t *service_request,
 #endif
     if (len < 0) {
         /* bad decoding - send an abort */
-        len = abort_encode_apdu(&Handler_Transmit_Buffer[pdu_len],
+        len = abort_encode_apdu(&tx->pdu[pdu_len],
             service_data->invoke_id, ABORT_REASON_OTHER, true);
 #if PRINT_ENABLED
         fprintf(stderr, "Alarm Ack: Bad Encoding.  Sending Abort!\n");
@@ -134,7 +140,7 @@ void handler_alarm_ack(uint8_t *service_request,
        discussions can be directed to edward@bac-test.com */
     if (!Device_Valid_Object_Id(data.eventObjectIdentifier.type,
             data.eventObjectIdentifier.instance)) {
-        len = bacerror_encode_apdu(&Handler_Transmit_Buffer[pdu_len],
+        len = bacerror_encode_apdu(&tx->pdu[pdu_len],
             service_data->invoke_id, SERVICE_CONFIRMED_ACKNOWLEDGE_ALARM,
             ERROR_CLASS_OBJECT, ERROR_CODE_UNKNOWN_OBJECT);
     } else if (Alarm_Ack[data.eventObjectIdentifier.type]) {
@@ -143,7 +149,7 @@ void handler_alarm_ack(uint8_t *service_request,
 
         switch (ack_result) {
             case 1:
-                len = encode_simple_ack(&Handler_Transmit_Buffer[pdu_len],
+                len = encode_simple_ack(&tx->pdu[pdu_len],
                     service_data->invoke_id,
                     SERVICE_CONFIRMED_ACKNOWLEDGE_ALARM);
 #if PRINT_ENABLED
@@ -154,7 +160,7 @@ void handler_alarm_ack(uint8_t *service_request,
                 break;
 
             case -1:
-                len = bacerror_encode_apdu(&Handler_Transmit_Buffer[pdu_len],
+                len = bacerror_encode_apdu(&tx->pdu[pdu_len],
                     service_data->invoke_id,
                     SERVICE_CONFIRMED_ACKNOWLEDGE_ALARM, ERROR_CLASS_OBJECT,
                     error_code);
@@ -165,7 +171,7 @@ void handler_alarm_ack(uint8_t *service_request,
                 break;
 
             default:
-                len = abort_encode_apdu(&Handler_Transmit_Buffer[pdu_len],
+                len = abort_encode_apdu(&tx->pdu[pdu_len],
                     service_data->invoke_id, ABORT_REASON_OTHER, true);
 #if PRINT_ENABLED
                 fprintf(stderr, "Alarm Acknowledge: abort other!\n");
@@ -173,7 +179,7 @@ void handler_alarm_ack(uint8_t *service_request,
                 break;
         }
     } else {
-        len = bacerror_encode_apdu(&Handler_Transmit_Buffer[pdu_len],
+        len = bacerror_encode_apdu(&tx->pdu[pdu_len],
             service_data->invoke_id, SERVICE_CONFIRMED_ACKNOWLEDGE_ALARM,
             ERROR_CLASS_OBJECT, ERROR_CODE_NO_ALARM_CONFIGURED);
 #if PRINT_ENABLED
@@ -187,8 +193,8 @@ AA_ABORT:
 #if PRINT_ENABLED
     bytes_sent =
 #endif
-        datalink_send_pdu(
-            src, &npdu_data, &Handler_Transmit_Buffer[0], pdu_len);
+        datalink_send_pdu(src, &npdu_data, &tx->pdu[0], pdu_len);
+    tsm_transmit_context_release(tx);
 #if PRINT_ENABLED
     if (bytes_sent <= 0)
         fprintf(stderr,
@@ -41,6 +41,7 @@
 #endif
 #include "bacnet/basic/tsm/tsm.h"
 #include "bacnet/basic/services.h"
+#include "bacnet/basic/npdu/npdu_cache.h"
 #include "bacnet/datalink/datalink.h"
 
 /** @file h_arf.c  Handles Atomic Read File request. */
@@ -102,6 +103,7 @@ void handler_atomic_read_file(uint8_t *service_request,
     BACNET_ADDRESS *src,
     BACNET_CONFIRMED_SERVICE_DATA *service_data)
 {
+    BACNET_TRANSMIT_CONTEXT *tx = NULL;
     BACNET_ATOMIC_READ_FILE_DATA data;
     int len = 0;
     int pdu_len = 0;
@@ -115,13 +117,17 @@ void handler_atomic_read_file(uint8_t *service_request,
 #if PRINT_ENABLED
     fprintf(stderr, "Received Atomic-Read-File Request!\n");
 #endif
+    tx = tsm_transmit_context_acquire();
+    if (!tx) {
+        /* no transmit buffer available - the client will retry */
+        return;
+    }
     /* encode the NPDU portion of the packet */
     datalink_get_my_address(&my_address);
     npdu_encode_npdu_data(&npdu_data, false, MESSAGE_PRIORITY_NORMAL);
-    pdu_len = npdu_encode_pdu(
-        &Handler_Transmit_Buffer[0], src, &my_address, &npdu_data);
+    pdu_len = npdu_cache_encode_pdu(&tx->pdu[0], src, &my_address, &npdu_data);
     if (service_data->segmented_message) {
-        len = abort_encode_apdu(&Handler_Transmit_Buffer[pdu_len],
+        len = abort_encode_apdu(&tx->pdu[pdu_len],
             service_data->invoke_id, ABORT_REASON_SEGMENTATION_NOT_SUPPORTED,
             true);
 #if PRINT_ENABLED
@@ -132,7 +138,7 @@ void handler_atomic_read_file(uint8_t *service_request,
     len = arf_decode_service_request(service_request, service_len, &data);
     /* bad decoding - send an abort */
     if (len < 0) {
-        len = abort_encode_apdu(&Handler_Transmit_Buffer[pdu_len],
+        len = abort_encode_apdu(&tx->pdu[pdu_len],
             service_data->invoke_id, ABORT_REASON_OTHER, true);
 #if PRINT_ENABLED
         fprintf(stderr, "Bad Encoding. Sending Abort!\n");
@@ -151,10 +157,10 @@ void handler_atomic_read_file(uint8_t *service_request,
                     (int)data.type.stream.fileStartPosition,
                     (int)data.type.stream.requestedOctetCount);
 #endif
-                len = arf_ack_encode_apdu(&Handler_Transmit_Buffer[pdu_len],
+                len = arf_ack_encode_apdu(&tx->pdu[pdu_len],
                     service_data->invoke_id, &data);
             } else {
-                len = abort_encode_apdu(&Handler_Transmit_Buffer[pdu_len],
+                len = abort_encode_apdu(&tx->pdu[pdu_len],
                     service_data->invoke_id,
                     ABORT_REASON_SEGMENTATION_NOT_SUPPORTED, true);
 #if PRINT_ENABLED
@@ -175,7 +181,7 @@ void handler_atomic_read_file(uint8_t *service_request,
                     (int)data.type.record.fileStartRecord,
                     (unsigned)data.type.record.RecordCount);
 #endif
-                len = arf_ack_encode_apdu(&Handler_Transmit_Buffer[pdu_len],
+                len = arf_ack_encode_apdu(&tx->pdu[pdu_len],
                     service_data->invoke_id, &data);
             } else {
                 error = true;
@@ -196,14 +202,14 @@ void handler_atomic_read_file(uint8_t *service_request,
         error_code = ERROR_CODE_INCONSISTENT_OBJECT_TYPE;
     }
     if (error) {
-        len = bacerror_encode_apdu(&Handler_Transmit_Buffer[pdu_len],
+        len = bacerror_encode_apdu(&tx->pdu[pdu_len],
             service_data->invoke_id, SERVICE_CONFIRMED_ATOMIC_READ_FILE,
             error_class, error_code);
     }
 ARF_ABORT:
     pdu_len += len;
-    bytes_sent = datalink_send_pdu(
-        src, &npdu_data, &Handler_Transmit_Buffer[0], pdu_len);
+    bytes_sent = datalink_send_pdu(src, &npdu_data, &tx->pdu[0], pdu_len);
+    tsm_transmit_context_release(tx);
 #if PRINT_ENABLED
     if (bytes_sent <= 0) {
         fprintf(stderr, "Failed to send PDU (%s)!\n", strerror(errno));
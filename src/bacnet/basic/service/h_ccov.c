@@ -38,6 +38,7 @@
 /* basic services, TSM, and datalink */
 #include "bacnet/basic/services.h"
 #include "bacnet/basic/tsm/tsm.h"
+#include "bacnet/basic/npdu/npdu_cache.h"
 #include "bacnet/datalink/datalink.h"
 
 /** @file h_ccov.c  Handles Confirmed COV Notifications. */
@@ -114,6 +115,7 @@ void handler_ccov_notification(uint8_t *service_request,
     BACNET_ADDRESS *src,
     BACNET_CONFIRMED_SERVICE_DATA *service_data)
 {
+    BACNET_TRANSMIT_CONTEXT *tx = NULL;
     BACNET_NPDU_DATA npdu_data;
     BACNET_COV_DATA cov_data;
     BACNET_PROPERTY_VALUE property_value[MAX_COV_PROPERTIES];
@@ -127,14 +129,18 @@ void handler_ccov_notification(uint8_t *service_request,
        than one property value is expected */
     bacapp_property_value_list_init(&property_value[0], MAX_COV_PROPERTIES);
     cov_data.listOfValues = &property_value[0];
+    tx = tsm_transmit_context_acquire();
+    if (!tx) {
+        /* no transmit buffer available - the client will retry */
+        return;
+    }
     /* encode the NPDU portion of the packet */
     datalink_get_my_address(&my_address);
     npdu_encode_npdu_data(&npdu_data, false, MESSAGE_PRIORITY_NORMAL);
-    pdu_len = npdu_encode_pdu(
-        &Handler_Transmit_Buffer[0], src, &my_address, &npdu_data);
+    pdu_len = npdu_cache_encode_pdu(&tx->pdu[0], src, &my_address, &npdu_data);
     PRINTF("CCOV: Received Notification!\n");
     if (service_data->segmented_message) {
-        len = abort_encode_apdu(&Handler_Transmit_Buffer[pdu_len],
+        len = abort_encode_apdu(&tx->pdu[pdu_len],
             service_data->invoke_id, ABORT_REASON_SEGMENTATION_NOT_SUPPORTED,
             true);
         PRINTF("CCOV: Segmented message.  Sending Abort!\n");
@@ -170,19 +176,19 @@ void handler_ccov_notification(uint8_t *service_request,
     }
     /* bad decoding or something we didn't understand - send an abort */
     if (len <= 0) {
-        len = abort_encode_apdu(&Handler_Transmit_Buffer[pdu_len],
+        len = abort_encode_apdu(&tx->pdu[pdu_len],
             service_data->invoke_id, ABORT_REASON_OTHER, true);
         PRINTF("CCOV: Bad Encoding. Sending Abort!\n");
         goto CCOV_ABORT;
     } else {
-        len = encode_simple_ack(&Handler_Transmit_Buffer[pdu_len],
+        len = encode_simple_ack(&tx->pdu[pdu_len],
             service_data->invoke_id, SERVICE_CONFIRMED_COV_NOTIFICATION);
         PRINTF("CCOV: Sending Simple Ack!\n");
     }
 CCOV_ABORT:
     pdu_len += len;
-    bytes_sent = datalink_send_pdu(
-        src, &npdu_data, &Handler_Transmit_Buffer[0], pdu_len);
+    bytes_sent = datalink_send_pdu(src, &npdu_data, &tx->pdu[0], pdu_len);
+    tsm_transmit_context_release(tx);
     if (bytes_sent <= 0) {
         PRINTF("CCOV: Failed to send PDU (%s)!\n", strerror(errno));
     }
@@ -45,44 +45,50 @@
 #include "bacnet/basic/tsm/tsm.h"
 #include "bacnet/basic/object/device.h"
 #include "bacnet/basic/services.h"
+#include "bacnet/basic/npdu/npdu_cache.h"
 #include "bacnet/datalink/datalink.h"
 
-#ifndef MAX_COV_PROPERTIES
-#define MAX_COV_PROPERTIES 2
-#endif
-
 /** @file h_cov.c  Handles Change of Value (COV) services. */
 
-typedef struct BACnet_COV_Address {
-    bool valid : 1;
-    BACNET_ADDRESS dest;
-} BACNET_COV_ADDRESS;
-
-/* note: This COV service only monitors the properties
-   of an object that have been specified in the standard.  */
-typedef struct BACnet_COV_Subscription_Flags {
-    bool valid : 1;
-    bool issueConfirmedNotifications : 1; /* optional */
-    bool send_requested : 1;
-} BACNET_COV_SUBSCRIPTION_FLAGS;
-
-typedef struct BACnet_COV_Subscription {
-    BACNET_COV_SUBSCRIPTION_FLAGS flag;
-    unsigned dest_index;
-    uint8_t invokeID; /* for confirmed COV */
-    uint32_t subscriberProcessIdentifier;
-    uint32_t lifetime; /* optional */
-    BACNET_OBJECT_ID monitoredObjectIdentifier;
-} BACNET_COV_SUBSCRIPTION;
-
-#ifndef MAX_COV_SUBCRIPTIONS
-#define MAX_COV_SUBCRIPTIONS 128
-#endif
-static BACNET_COV_SUBSCRIPTION COV_Subscriptions[MAX_COV_SUBCRIPTIONS];
-#ifndef MAX_COV_ADDRESSES
-#define MAX_COV_ADDRESSES 16
-#endif
-static BACNET_COV_ADDRESS COV_Addresses[MAX_COV_ADDRESSES];
+/* The default context is used until another one is selected. */
+static BACNET_COV_CONTEXT COV_Default_Context;
+static BACNET_COV_CONTEXT *COV = &COV_Default_Context;
+
+/**
+ * Initialize a COV context to have no subscriptions.
+ *
+ * @param  context - the COV context to initialize
+ */
+void handler_cov_context_init(BACNET_COV_CONTEXT *context)
+{
+    if (context) {
+        memset(context, 0, sizeof(BACNET_COV_CONTEXT));
+    }
+}
+
+/**
+ * Select the COV context used by the COV handler, FSM and task.
+ *
+ * @param  context - the COV context, or NULL to use the default
+ */
+void handler_cov_context_set(BACNET_COV_CONTEXT *context)
+{
+    if (context) {
+        COV = context;
+    } else {
+        COV = &COV_Default_Context;
+    }
+}
+
+/**
+ * Get the COV context used by the COV handler, FSM and task.
+ *
+ * @return the current COV context
+ */
+BACNET_COV_CONTEXT *handler_cov_context(void)
+{
+    return COV;
+}
 
 /**
  * Gets the address from the list of COV addresses
@@ -97,8 +103,8 @@ static BACNET_ADDRESS *cov_address_get(unsigned index)
     BACNET_ADDRESS *cov_dest = NULL;
 
     if (index < MAX_COV_ADDRESSES) {
-        if (COV_Addresses[index].valid) {
-            cov_dest = &COV_Addresses[index].dest;
+        if (COV->Addresses[index].valid) {
+            cov_dest = &COV->Addresses[index].dest;
         }
     }
 
@@ -116,17 +122,17 @@ static void cov_address_remove_unused(void)
     bool found = false;
 
     for (cov_index = 0; cov_index < MAX_COV_ADDRESSES; cov_index++) {
-        if (COV_Addresses[cov_index].valid) {
+        if (COV->Addresses[cov_index].valid) {
             found = false;
             for (index = 0; index < MAX_COV_SUBCRIPTIONS; index++) {
-                if ((COV_Subscriptions[index].flag.valid) &&
-                    (COV_Subscriptions[index].dest_index == cov_index)) {
+                if ((COV->Subscriptions[index].flag.valid) &&
+                    (COV->Subscriptions[index].dest_index == cov_index)) {
                     found = true;
                     break;
                 }
             }
             if (!found) {
-                COV_Addresses[cov_index].valid = false;
+                COV->Addresses[cov_index].valid = false;
             }
         }
     }
@@ -149,9 +155,9 @@ static int cov_address_add(BACNET_ADDRESS *dest)
 
     if (dest) {
         for (i = 0; i < MAX_COV_ADDRESSES; i++) {
-            valid = COV_Addresses[i].valid;
+            valid = COV->Addresses[i].valid;
             if (valid) {
-                cov_dest = &COV_Addresses[i].dest;
+                cov_dest = &COV->Addresses[i].dest;
                 found = bacnet_address_same(dest, cov_dest);
                 if (found) {
                     index = i;
@@ -162,12 +168,12 @@ static int cov_address_add(BACNET_ADDRESS *dest)
         if (!found) {
             /* find a free place to add a new address */
             for (i = 0; i < MAX_COV_ADDRESSES; i++) {
-                valid = COV_Addresses[i].valid;
+                valid = COV->Addresses[i].valid;
                 if (!valid) {
                     index = i;
-                    cov_dest = &COV_Addresses[i].dest;
+                    cov_dest = &COV->Addresses[i].dest;
                     bacnet_address_copy(cov_dest, dest);
-                    COV_Addresses[i].valid = true;
+                    COV->Addresses[i].valid = true;
                     break;
                 }
             }
@@ -301,9 +307,9 @@ int handler_cov_encode_subscriptions(uint8_t *apdu, int max_apdu)
 
     if (apdu) {
         for (index = 0; index < MAX_COV_SUBCRIPTIONS; index++) {
-            if (COV_Subscriptions[index].flag.valid) {
+            if (COV->Subscriptions[index].flag.valid) {
                 len = cov_encode_subscription(&apdu[apdu_len],
-                    max_apdu - apdu_len, &COV_Subscriptions[index]);
+                    max_apdu - apdu_len, &COV->Subscriptions[index]);
                 apdu_len += len;
                 /* TODO: too late here to notice that we overran the buffer */
                 if (apdu_len > max_apdu) {
@@ -325,19 +331,19 @@ void handler_cov_init(void)
 
     for (index = 0; index < MAX_COV_SUBCRIPTIONS; index++) {
         /* initialize with invalid COV address */
-        COV_Subscriptions[index].flag.valid = false;
-        COV_Subscriptions[index].dest_index = MAX_COV_ADDRESSES;
-        COV_Subscriptions[index].subscriberProcessIdentifier = 0;
-        COV_Subscriptions[index].monitoredObjectIdentifier.type =
+        COV->Subscriptions[index].flag.valid = false;
+        COV->Subscriptions[index].dest_index = MAX_COV_ADDRESSES;
+        COV->Subscriptions[index].subscriberProcessIdentifier = 0;
+        COV->Subscriptions[index].monitoredObjectIdentifier.type =
             OBJECT_ANALOG_INPUT;
-        COV_Subscriptions[index].monitoredObjectIdentifier.instance = 0;
-        COV_Subscriptions[index].flag.issueConfirmedNotifications = false;
-        COV_Subscriptions[index].invokeID = 0;
-        COV_Subscriptions[index].lifetime = 0;
-        COV_Subscriptions[index].flag.send_requested = false;
+        COV->Subscriptions[index].monitoredObjectIdentifier.instance = 0;
+        COV->Subscriptions[index].flag.issueConfirmedNotifications = false;
+        COV->Subscriptions[index].invokeID = 0;
+        COV->Subscriptions[index].lifetime = 0;
+        COV->Subscriptions[index].flag.send_requested = false;
     }
     for (index = 0; index < MAX_COV_ADDRESSES; index++) {
-        COV_Addresses[index].valid = false;
+        COV->Addresses[index].valid = false;
     }
 }
 
@@ -358,37 +364,37 @@ static bool cov_list_subscribe(BACNET_ADDRESS *src,
 
     /* existing? - match Object ID and Process ID and address */
     for (index = 0; index < MAX_COV_SUBCRIPTIONS; index++) {
-        if (COV_Subscriptions[index].flag.valid) {
-            dest = cov_address_get(COV_Subscriptions[index].dest_index);
+        if (COV->Subscriptions[index].flag.valid) {
+            dest = cov_address_get(COV->Subscriptions[index].dest_index);
             if (dest) {
                 address_match = bacnet_address_same(src, dest);
             } else {
                 /* skip address matching - we don't have an address */
                 address_match = true;
             }
-            if ((COV_Subscriptions[index].monitoredObjectIdentifier.type ==
+            if ((COV->Subscriptions[index].monitoredObjectIdentifier.type ==
                     cov_data->monitoredObjectIdentifier.type) &&
-                (COV_Subscriptions[index].monitoredObjectIdentifier.instance ==
+                (COV->Subscriptions[index].monitoredObjectIdentifier.instance ==
                     cov_data->monitoredObjectIdentifier.instance) &&
-                (COV_Subscriptions[index].subscriberProcessIdentifier ==
+                (COV->Subscriptions[index].subscriberProcessIdentifier ==
                     cov_data->subscriberProcessIdentifier) &&
                 address_match) {
                 existing_entry = true;
                 if (cov_data->cancellationRequest) {
                     /* initialize with invalid COV address */
-                    COV_Subscriptions[index].flag.valid = false;
-                    COV_Subscriptions[index].dest_index = MAX_COV_ADDRESSES;
+                    COV->Subscriptions[index].flag.valid = false;
+                    COV->Subscriptions[index].dest_index = MAX_COV_ADDRESSES;
                     cov_address_remove_unused();
                 } else {
-                    COV_Subscriptions[index].dest_index = cov_address_add(src);
-                    COV_Subscriptions[index].flag.issueConfirmedNotifications =
+                    COV->Subscriptions[index].dest_index = cov_address_add(src);
+                    COV->Subscriptions[index].flag.issueConfirmedNotifications =
                         cov_data->issueConfirmedNotifications;
-                    COV_Subscriptions[index].lifetime = cov_data->lifetime;
-                    COV_Subscriptions[index].flag.send_requested = true;
+                    COV->Subscriptions[index].lifetime = cov_data->lifetime;
+                    COV->Subscriptions[index].flag.send_requested = true;
                 }
-                if (COV_Subscriptions[index].invokeID) {
-                    tsm_free_invoke_id(COV_Subscriptions[index].invokeID);
-                    COV_Subscriptions[index].invokeID = 0;
+                if (COV->Subscriptions[index].invokeID) {
+                    tsm_free_invoke_id(COV->Subscriptions[index].invokeID);
+                    COV->Subscriptions[index].invokeID = 0;
                 }
                 break;
             }
@@ -402,19 +408,19 @@ static bool cov_list_subscribe(BACNET_ADDRESS *src,
         (!cov_data->cancellationRequest)) {
         index = first_invalid_index;
         found = true;
-        COV_Subscriptions[index].flag.valid = true;
-        COV_Subscriptions[index].dest_index = cov_address_add(src);
-        COV_Subscriptions[index].monitoredObjectIdentifier.type =
+        COV->Subscriptions[index].flag.valid = true;
+        COV->Subscriptions[index].dest_index = cov_address_add(src);
+        COV->Subscriptions[index].monitoredObjectIdentifier.type =
             cov_data->monitoredObjectIdentifier.type;
-        COV_Subscriptions[index].monitoredObjectIdentifier.instance =
+        COV->Subscriptions[index].monitoredObjectIdentifier.instance =
             cov_data->monitoredObjectIdentifier.instance;
-        COV_Subscriptions[index].subscriberProcessIdentifier =
+        COV->Subscriptions[index].subscriberProcessIdentifier =
             cov_data->subscriberProcessIdentifier;
-        COV_Subscriptions[index].flag.issueConfirmedNotifications =
+        COV->Subscriptions[index].flag.issueConfirmedNotifications =
             cov_data->issueConfirmedNotifications;
-        COV_Subscriptions[index].invokeID = 0;
-        COV_Subscriptions[index].lifetime = cov_data->lifetime;
-        COV_Subscriptions[index].flag.send_requested = true;
+        COV->Subscriptions[index].invokeID = 0;
+        COV->Subscriptions[index].lifetime = cov_data->lifetime;
+        COV->Subscriptions[index].flag.send_requested = true;
     } else if (!existing_entry) {
         if (first_invalid_index < 0) {
             /* Out of resources */
@@ -437,6 +443,7 @@ static bool cov_list_subscribe(BACNET_ADDRESS *src,
 static bool cov_send_request(BACNET_COV_SUBSCRIPTION *cov_subscription,
     BACNET_PROPERTY_VALUE *value_list)
 {
+    BACNET_TRANSMIT_CONTEXT *tx = NULL;
     int len = 0;
     int pdu_len = 0;
     BACNET_NPDU_DATA npdu_data;
@@ -463,10 +470,13 @@ static bool cov_send_request(BACNET_COV_SUBSCRIPTION *cov_subscription,
 #endif
         return status;
     }
+    tx = tsm_transmit_context_acquire();
+    if (!tx) {
+        return status;
+    }
     datalink_get_my_address(&my_address);
     npdu_encode_npdu_data(&npdu_data, false, MESSAGE_PRIORITY_NORMAL);
-    pdu_len = npdu_encode_pdu(
-        &Handler_Transmit_Buffer[0], dest, &my_address, &npdu_data);
+    pdu_len = npdu_cache_encode_pdu(&tx->pdu[0], dest, &my_address, &npdu_data);
     /* load the COV data structure for outgoing message */
     cov_data.subscriberProcessIdentifier =
         cov_subscription->subscriberProcessIdentifier;
@@ -482,23 +492,22 @@ static bool cov_send_request(BACNET_COV_SUBSCRIPTION *cov_subscription,
         invoke_id = tsm_next_free_invokeID();
         if (invoke_id) {
             cov_subscription->invokeID = invoke_id;
-            len = ccov_notify_encode_apdu(&Handler_Transmit_Buffer[pdu_len],
-                sizeof(Handler_Transmit_Buffer) - pdu_len, invoke_id,
+            len = ccov_notify_encode_apdu(&tx->pdu[pdu_len],
+                MAX_PDU - pdu_len, invoke_id,
                 &cov_data);
         } else {
             goto COV_FAILED;
         }
     } else {
-        len = ucov_notify_encode_apdu(&Handler_Transmit_Buffer[pdu_len],
-            sizeof(Handler_Transmit_Buffer) - pdu_len, &cov_data);
+        len = ucov_notify_encode_apdu(&tx->pdu[pdu_len],
+            MAX_PDU - pdu_len, &cov_data);
     }
     pdu_len += len;
     if (cov_subscription->flag.issueConfirmedNotifications) {
         tsm_set_confirmed_unsegmented_transaction(invoke_id, dest, &npdu_data,
-            &Handler_Transmit_Buffer[0], (uint16_t)pdu_len);
+            &tx->pdu[0], (uint16_t)pdu_len);
     }
-    bytes_sent = datalink_send_pdu(
-        dest, &npdu_data, &Handler_Transmit_Buffer[0], pdu_len);
+    bytes_sent = datalink_send_pdu(dest, &npdu_data, &tx->pdu[0], pdu_len);
     if (bytes_sent > 0) {
         status = true;
 #if PRINT_ENABLED
@@ -507,6 +516,7 @@ static bool cov_send_request(BACNET_COV_SUBSCRIPTION *cov_subscription,
     }
 
 COV_FAILED:
+    tsm_transmit_context_release(tx);
 
     return status;
 }
@@ -517,35 +527,35 @@ static void cov_lifetime_expiration_handler(
     if (index < MAX_COV_SUBCRIPTIONS) {
         /* handle lifetime expiration */
         if (lifetime_seconds >= elapsed_seconds) {
-            COV_Subscriptions[index].lifetime -= elapsed_seconds;
+            COV->Subscriptions[index].lifetime -= elapsed_seconds;
 #if 0
             fprintf(stderr, "COVtimer: subscription[%d].lifetime=%lu\n", index,
-                (unsigned long) COV_Subscriptions[index].lifetime);
+                (unsigned long) COV->Subscriptions[index].lifetime);
 #endif
         } else {
-            COV_Subscriptions[index].lifetime = 0;
+            COV->Subscriptions[index].lifetime = 0;
         }
-        if (COV_Subscriptions[index].lifetime == 0) {
+        if (COV->Subscriptions[index].lifetime == 0) {
             /* expire the subscription */
 #if PRINT_ENABLED
             fprintf(stderr, "COVtimer: PID=%u ",
-                COV_Subscriptions[index].subscriberProcessIdentifier);
+                COV->Subscriptions[index].subscriberProcessIdentifier);
             fprintf(stderr, "%s %u ",
                 bactext_object_type_name(
-                    COV_Subscriptions[index].monitoredObjectIdentifier.type),
-                COV_Subscriptions[index].monitoredObjectIdentifier.instance);
+                    COV->Subscriptions[index].monitoredObjectIdentifier.type),
+                COV->Subscriptions[index].monitoredObjectIdentifier.instance);
             fprintf(stderr, "time remaining=%u seconds ",
-                COV_Subscriptions[index].lifetime);
+                COV->Subscriptions[index].lifetime);
             fprintf(stderr, "\n");
 #endif
             /* initialize with invalid COV address */
-            COV_Subscriptions[index].flag.valid = false;
-            COV_Subscriptions[index].dest_index = MAX_COV_ADDRESSES;
+            COV->Subscriptions[index].flag.valid = false;
+            COV->Subscriptions[index].dest_index = MAX_COV_ADDRESSES;
             cov_address_remove_unused();
-            if (COV_Subscriptions[index].flag.issueConfirmedNotifications) {
-                if (COV_Subscriptions[index].invokeID) {
-                    tsm_free_invoke_id(COV_Subscriptions[index].invokeID);
-                    COV_Subscriptions[index].invokeID = 0;
+            if (COV->Subscriptions[index].flag.issueConfirmedNotifications) {
+                if (COV->Subscriptions[index].invokeID) {
+                    tsm_free_invoke_id(COV->Subscriptions[index].invokeID);
+                    COV->Subscriptions[index].invokeID = 0;
                 }
             }
         }
@@ -581,8 +591,8 @@ void handler_cov_timer_seconds(uint32_t elapsed_seconds)
     if (elapsed_seconds) {
         /* handle the subscription timeouts */
         for (index = 0; index < MAX_COV_SUBCRIPTIONS; index++) {
-            if (COV_Subscriptions[index].flag.valid) {
-                lifetime_seconds = COV_Subscriptions[index].lifetime;
+            if (COV->Subscriptions[index].flag.valid) {
+                lifetime_seconds = COV->Subscriptions[index].lifetime;
                 if (lifetime_seconds) {
                     /* only expire COV with definite lifetimes */
                     cov_lifetime_expiration_handler(
@@ -595,20 +605,14 @@ void handler_cov_timer_seconds(uint32_t elapsed_seconds)
 
 bool handler_cov_fsm(void)
 {
-    static int index = 0;
+    int index = COV->Task_Index;
     BACNET_OBJECT_TYPE object_type = MAX_BACNET_OBJECT_TYPE;
     uint32_t object_instance = 0;
     bool status = false;
     bool send = false;
     BACNET_PROPERTY_VALUE value_list[MAX_COV_PROPERTIES];
     /* states for transmitting */
-    static enum {
-        COV_STATE_IDLE = 0,
-        COV_STATE_MARK,
-        COV_STATE_CLEAR,
-        COV_STATE_FREE,
-        COV_STATE_SEND
-    } cov_task_state = COV_STATE_IDLE;
+    BACNET_COV_TASK_STATE cov_task_state = COV->Task_State;
 
     switch (cov_task_state) {
         case COV_STATE_IDLE:
@@ -617,14 +621,14 @@ bool handler_cov_fsm(void)
             break;
         case COV_STATE_MARK:
             /* mark any subscriptions where the value has changed */
-            if (COV_Subscriptions[index].flag.valid) {
-                object_type = (BACNET_OBJECT_TYPE)COV_Subscriptions[index]
+            if (COV->Subscriptions[index].flag.valid) {
+                object_type = (BACNET_OBJECT_TYPE)COV->Subscriptions[index]
                                   .monitoredObjectIdentifier.type;
                 object_instance =
-                    COV_Subscriptions[index].monitoredObjectIdentifier.instance;
+                    COV->Subscriptions[index].monitoredObjectIdentifier.instance;
                 status = Device_COV(object_type, object_instance);
                 if (status) {
-                    COV_Subscriptions[index].flag.send_requested = true;
+                    COV->Subscriptions[index].flag.send_requested = true;
 #if PRINT_ENABLED
                     fprintf(stderr, "COVtask: Marking...\n");
 #endif
@@ -638,12 +642,12 @@ bool handler_cov_fsm(void)
             break;
         case COV_STATE_CLEAR:
             /* clear the COV flag after checking all subscriptions */
-            if ((COV_Subscriptions[index].flag.valid) &&
-                (COV_Subscriptions[index].flag.send_requested)) {
-                object_type = (BACNET_OBJECT_TYPE)COV_Subscriptions[index]
+            if ((COV->Subscriptions[index].flag.valid) &&
+                (COV->Subscriptions[index].flag.send_requested)) {
+                object_type = (BACNET_OBJECT_TYPE)COV->Subscriptions[index]
                                   .monitoredObjectIdentifier.type;
                 object_instance =
-                    COV_Subscriptions[index].monitoredObjectIdentifier.instance;
+                    COV->Subscriptions[index].monitoredObjectIdentifier.instance;
                 Device_COV_Clear(object_type, object_instance);
             }
             index++;
@@ -654,15 +658,15 @@ bool handler_cov_fsm(void)
             break;
         case COV_STATE_FREE:
             /* confirmed notification house keeping */
-            if ((COV_Subscriptions[index].flag.valid) &&
-                (COV_Subscriptions[index].flag.issueConfirmedNotifications) &&
-                (COV_Subscriptions[index].invokeID)) {
-                if (tsm_invoke_id_free(COV_Subscriptions[index].invokeID)) {
-                    COV_Subscriptions[index].invokeID = 0;
+            if ((COV->Subscriptions[index].flag.valid) &&
+                (COV->Subscriptions[index].flag.issueConfirmedNotifications) &&
+                (COV->Subscriptions[index].invokeID)) {
+                if (tsm_invoke_id_free(COV->Subscriptions[index].invokeID)) {
+                    COV->Subscriptions[index].invokeID = 0;
                 } else if (tsm_invoke_id_failed(
-                               COV_Subscriptions[index].invokeID)) {
-                    tsm_free_invoke_id(COV_Subscriptions[index].invokeID);
-                    COV_Subscriptions[index].invokeID = 0;
+                               COV->Subscriptions[index].invokeID)) {
+                    tsm_free_invoke_id(COV->Subscriptions[index].invokeID);
+                    COV->Subscriptions[index].invokeID = 0;
                 }
             }
             index++;
@@ -673,11 +677,11 @@ bool handler_cov_fsm(void)
             break;
         case COV_STATE_SEND:
             /* send any COVs that are requested */
-            if ((COV_Subscriptions[index].flag.valid) &&
-                (COV_Subscriptions[index].flag.send_requested)) {
+            if ((COV->Subscriptions[index].flag.valid) &&
+                (COV->Subscriptions[index].flag.send_requested)) {
                 send = true;
-                if (COV_Subscriptions[index].flag.issueConfirmedNotifications) {
-                    if (COV_Subscriptions[index].invokeID != 0) {
+                if (COV->Subscriptions[index].flag.issueConfirmedNotifications) {
+                    if (COV->Subscriptions[index].invokeID != 0) {
                         /* already sending */
                         send = false;
                     }
@@ -687,9 +691,9 @@ bool handler_cov_fsm(void)
                     }
                 }
                 if (send) {
-                    object_type = (BACNET_OBJECT_TYPE)COV_Subscriptions[index]
+                    object_type = (BACNET_OBJECT_TYPE)COV->Subscriptions[index]
                                       .monitoredObjectIdentifier.type;
-                    object_instance = COV_Subscriptions[index]
+                    object_instance = COV->Subscriptions[index]
                                           .monitoredObjectIdentifier.instance;
 #if PRINT_ENABLED
                     fprintf(stderr, "COVtask: Sending...\n");
@@ -701,10 +705,10 @@ bool handler_cov_fsm(void)
                         object_type, object_instance, &value_list[0]);
                     if (status) {
                         status = cov_send_request(
-                            &COV_Subscriptions[index], &value_list[0]);
+                            &COV->Subscriptions[index], &value_list[0]);
                     }
                     if (status) {
-                        COV_Subscriptions[index].flag.send_requested = false;
+                        COV->Subscriptions[index].flag.send_requested = false;
                     }
                 }
             }
@@ -719,6 +723,9 @@ bool handler_cov_fsm(void)
             cov_task_state = COV_STATE_IDLE;
             break;
     }
+    COV->Task_Index = index;
+    COV->Task_State = cov_task_state;
+
     return (cov_task_state == COV_STATE_IDLE);
 }
 
@@ -777,6 +784,7 @@ void handler_cov_subscribe(uint8_t *service_request,
     BACNET_ADDRESS *src,
     BACNET_CONFIRMED_SERVICE_DATA *service_data)
 {
+    BACNET_TRANSMIT_CONTEXT *tx = NULL;
     BACNET_SUBSCRIBE_COV_DATA cov_data;
     int len = 0;
     int pdu_len = 0;
@@ -790,11 +798,15 @@ void handler_cov_subscribe(uint8_t *service_request,
 
     /* initialize a common abort code */
     cov_data.error_code = ERROR_CODE_ABORT_SEGMENTATION_NOT_SUPPORTED;
+    tx = tsm_transmit_context_acquire();
+    if (!tx) {
+        /* no transmit buffer available - the client will retry */
+        return;
+    }
     /* encode the NPDU portion of the packet */
     datalink_get_my_address(&my_address);
     npdu_encode_npdu_data(&npdu_data, false, MESSAGE_PRIORITY_NORMAL);
-    npdu_len = npdu_encode_pdu(
-        &Handler_Transmit_Buffer[0], src, &my_address, &npdu_data);
+    npdu_len = npdu_cache_encode_pdu(&tx->pdu[0], src, &my_address, &npdu_data);
     if (service_data->segmented_message) {
         /* we don't support segmentation - send an abort */
         len = BACNET_STATUS_ABORT;
@@ -817,7 +829,7 @@ void handler_cov_subscribe(uint8_t *service_request,
             success = cov_subscribe(
                 src, &cov_data, &cov_data.error_class, &cov_data.error_code);
             if (success) {
-                apdu_len = encode_simple_ack(&Handler_Transmit_Buffer[npdu_len],
+                apdu_len = encode_simple_ack(&tx->pdu[npdu_len],
                     service_data->invoke_id, SERVICE_CONFIRMED_SUBSCRIBE_COV);
 #if PRINT_ENABLED
                 fprintf(stderr, "SubscribeCOV: Sending Simple Ack!\n");
@@ -835,21 +847,21 @@ void handler_cov_subscribe(uint8_t *service_request,
     /* Error? */
     if (error) {
         if (len == BACNET_STATUS_ABORT) {
-            apdu_len = abort_encode_apdu(&Handler_Transmit_Buffer[npdu_len],
+            apdu_len = abort_encode_apdu(&tx->pdu[npdu_len],
                 service_data->invoke_id,
                 abort_convert_error_code(cov_data.error_code), true);
 #if PRINT_ENABLED
             fprintf(stderr, "SubscribeCOV: Sending Abort!\n");
 #endif
         } else if (len == BACNET_STATUS_ERROR) {
-            apdu_len = bacerror_encode_apdu(&Handler_Transmit_Buffer[npdu_len],
+            apdu_len = bacerror_encode_apdu(&tx->pdu[npdu_len],
                 service_data->invoke_id, SERVICE_CONFIRMED_SUBSCRIBE_COV,
                 cov_data.error_class, cov_data.error_code);
 #if PRINT_ENABLED
             fprintf(stderr, "SubscribeCOV: Sending Error!\n");
 #endif
         } else if (len == BACNET_STATUS_REJECT) {
-            apdu_len = reject_encode_apdu(&Handler_Transmit_Buffer[npdu_len],
+            apdu_len = reject_encode_apdu(&tx->pdu[npdu_len],
                 service_data->invoke_id,
                 reject_convert_error_code(cov_data.error_code));
 #if PRINT_ENABLED
@@ -858,8 +870,8 @@ void handler_cov_subscribe(uint8_t *service_request,
         }
     }
     pdu_len = npdu_len + apdu_len;
-    bytes_sent = datalink_send_pdu(
-        src, &npdu_data, &Handler_Transmit_Buffer[0], pdu_len);
+    bytes_sent = datalink_send_pdu(src, &npdu_data, &tx->pdu[0], pdu_len);
+    tsm_transmit_context_release(tx);
     if (bytes_sent <= 0) {
 #if PRINT_ENABLED
         fprintf(stderr, "SubscribeCOV: Failed to send PDU (%s)!\n",
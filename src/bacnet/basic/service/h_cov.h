@@ -37,10 +37,72 @@
 #include "bacnet/bacenum.h"
 #include "bacnet/apdu.h"
 
+#ifndef MAX_COV_PROPERTIES
+#define MAX_COV_PROPERTIES 2
+#endif
+
+typedef struct BACnet_COV_Address {
+    bool valid : 1;
+    BACNET_ADDRESS dest;
+} BACNET_COV_ADDRESS;
+
+/* note: This COV service only monitors the properties
+   of an object that have been specified in the standard.  */
+typedef struct BACnet_COV_Subscription_Flags {
+    bool valid : 1;
+    bool issueConfirmedNotifications : 1; /* optional */
+    bool send_requested : 1;
+} BACNET_COV_SUBSCRIPTION_FLAGS;
+
+typedef struct BACnet_COV_Subscription {
+    BACNET_COV_SUBSCRIPTION_FLAGS flag;
+    unsigned dest_index;
+    uint8_t invokeID; /* for confirmed COV */
+    uint32_t subscriberProcessIdentifier;
+    uint32_t lifetime; /* optional */
+    BACNET_OBJECT_ID monitoredObjectIdentifier;
+} BACNET_COV_SUBSCRIPTION;
+
+/* states for transmitting */
+typedef enum BACnet_COV_Task_State {
+    COV_STATE_IDLE = 0,
+    COV_STATE_MARK,
+    COV_STATE_CLEAR,
+    COV_STATE_FREE,
+    COV_STATE_SEND
+} BACNET_COV_TASK_STATE;
+
+#ifndef MAX_COV_SUBCRIPTIONS
+#define MAX_COV_SUBCRIPTIONS 128
+#endif
+#ifndef MAX_COV_ADDRESSES
+#define MAX_COV_ADDRESSES 16
+#endif
+
+/* The COV subscriptions of one BACnet device. Several devices in one
+   process each use their own context, selected with
+   handler_cov_context_set() */
+typedef struct BACnet_COV_Context {
+    BACNET_COV_SUBSCRIPTION Subscriptions[MAX_COV_SUBCRIPTIONS];
+    BACNET_COV_ADDRESS Addresses[MAX_COV_ADDRESSES];
+    int Task_Index;
+    BACNET_COV_TASK_STATE Task_State;
+} BACNET_COV_CONTEXT;
+
 #ifdef __cplusplus
 extern "C" {
 #endif /* __cplusplus */
 
+    BACNET_STACK_EXPORT
+    void handler_cov_context_init(
+        BACNET_COV_CONTEXT * context);
+    BACNET_STACK_EXPORT
+    void handler_cov_context_set(
+        BACNET_COV_CONTEXT * context);
+    BACNET_STACK_EXPORT
+    BACNET_COV_CONTEXT *handler_cov_context(
+        void);
+
     BACNET_STACK_EXPORT
     void handler_cov_subscribe(
         uint8_t * service_request,
@@ -40,6 +40,7 @@
 #include "bacnet/basic/object/device.h"
 #include "bacnet/basic/tsm/tsm.h"
 #include "bacnet/basic/services.h"
+#include "bacnet/basic/npdu/npdu_cache.h"
 #include "bacnet/datalink/datalink.h"
 
 /** @file h_dcc.c  Handles Device Communication Control request. */
@@ -100,6 +101,7 @@ void handler_device_communication_control(uint8_t *service_request,
     BACNET_ADDRESS *src,
     BACNET_CONFIRMED_SERVICE_DATA *service_data)
 {
+    BACNET_TRANSMIT_CONTEXT *tx = NULL;
     uint16_t timeDuration = 0;
     BACNET_COMMUNICATION_ENABLE_DISABLE state = COMMUNICATION_ENABLE;
     BACNET_CHARACTER_STRING password;
@@ -108,16 +110,20 @@ void handler_device_communication_control(uint8_t *service_request,
     BACNET_NPDU_DATA npdu_data;
     BACNET_ADDRESS my_address;
 
+    tx = tsm_transmit_context_acquire();
+    if (!tx) {
+        /* no transmit buffer available - the client will retry */
+        return;
+    }
     /* encode the NPDU portion of the reply packet */
     datalink_get_my_address(&my_address);
     npdu_encode_npdu_data(&npdu_data, false, MESSAGE_PRIORITY_NORMAL);
-    pdu_len = npdu_encode_pdu(
-        &Handler_Transmit_Buffer[0], src, &my_address, &npdu_data);
+    pdu_len = npdu_cache_encode_pdu(&tx->pdu[0], src, &my_address, &npdu_data);
 #if PRINT_ENABLED
     fprintf(stderr, "DeviceCommunicationControl!\n");
 #endif
     if (service_data->segmented_message) {
-        len = abort_encode_apdu(&Handler_Transmit_Buffer[pdu_len],
+        len = abort_encode_apdu(&tx->pdu[pdu_len],
             service_data->invoke_id, ABORT_REASON_SEGMENTATION_NOT_SUPPORTED,
             true);
 #if PRINT_ENABLED
@@ -142,13 +148,13 @@ void handler_device_communication_control(uint8_t *service_request,
        send an abort or reject */
     if (len < 0) {
         if (len == BACNET_STATUS_ABORT) {
-            len = abort_encode_apdu(&Handler_Transmit_Buffer[pdu_len],
+            len = abort_encode_apdu(&tx->pdu[pdu_len],
                 service_data->invoke_id, ABORT_REASON_OTHER, true);
 #if PRINT_ENABLED
             fprintf(stderr, "DCC: Sending Abort!\n");
 #endif
         } else if (len == BACNET_STATUS_REJECT) {
-            len = reject_encode_apdu(&Handler_Transmit_Buffer[pdu_len],
+            len = reject_encode_apdu(&tx->pdu[pdu_len],
                 service_data->invoke_id, REJECT_REASON_PARAMETER_OUT_OF_RANGE);
 #if PRINT_ENABLED
             fprintf(stderr, "DCC: Sending Reject!\n");
@@ -157,7 +163,7 @@ void handler_device_communication_control(uint8_t *service_request,
         goto DCC_ABORT;
     }
     if (state >= MAX_BACNET_COMMUNICATION_ENABLE_DISABLE) {
-        len = reject_encode_apdu(&Handler_Transmit_Buffer[pdu_len],
+        len = reject_encode_apdu(&tx->pdu[pdu_len],
             service_data->invoke_id, REJECT_REASON_UNDEFINED_ENUMERATION);
 #if PRINT_ENABLED
         fprintf(stderr,
@@ -169,13 +175,13 @@ void handler_device_communication_control(uint8_t *service_request,
         /* Check to see if the current Device supports this service. */
         len = Routed_Device_Service_Approval(
             SERVICE_SUPPORTED_DEVICE_COMMUNICATION_CONTROL, (int)state,
-            &Handler_Transmit_Buffer[pdu_len], service_data->invoke_id);
+            &tx->pdu[pdu_len], service_data->invoke_id);
         if (len > 0)
             goto DCC_ABORT;
 #endif
 
         if (characterstring_ansi_same(&password, My_Password)) {
-            len = encode_simple_ack(&Handler_Transmit_Buffer[pdu_len],
+            len = encode_simple_ack(&tx->pdu[pdu_len],
                 service_data->invoke_id,
                 SERVICE_CONFIRMED_DEVICE_COMMUNICATION_CONTROL);
 #if PRINT_ENABLED
@@ -185,7 +191,7 @@ void handler_device_communication_control(uint8_t *service_request,
 #endif
             dcc_set_status_duration(state, timeDuration);
         } else {
-            len = bacerror_encode_apdu(&Handler_Transmit_Buffer[pdu_len],
+            len = bacerror_encode_apdu(&tx->pdu[pdu_len],
                 service_data->invoke_id,
                 SERVICE_CONFIRMED_DEVICE_COMMUNICATION_CONTROL,
                 ERROR_CLASS_SECURITY, ERROR_CODE_PASSWORD_FAILURE);
@@ -198,8 +204,8 @@ void handler_device_communication_control(uint8_t *service_request,
     }
 DCC_ABORT:
     pdu_len += len;
-    len = datalink_send_pdu(
-        src, &npdu_data, &Handler_Transmit_Buffer[0], pdu_len);
+    len = datalink_send_pdu(src, &npdu_data, &tx->pdu[0], pdu_len);
+    tsm_transmit_context_release(tx);
     if (len <= 0) {
 #if PRINT_ENABLED
         fprintf(stderr,
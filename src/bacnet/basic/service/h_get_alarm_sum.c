@@ -36,6 +36,7 @@
 /* basic services, TSM, and datalink */
 #include "bacnet/basic/tsm/tsm.h"
 #include "bacnet/basic/services.h"
+#include "bacnet/basic/npdu/npdu_cache.h"
 #include "bacnet/datalink/datalink.h"
 
 /** @file h_alarm_sum.c  Handles Get Alarm Summary request. */
@@ -55,6 +56,7 @@ void handler_get_alarm_summary(uint8_t *service_request,
     BACNET_ADDRESS *src,
     BACNET_CONFIRMED_SERVICE_DATA *service_data)
 {
+    BACNET_TRANSMIT_CONTEXT *tx = NULL;
     int len = 0;
     int pdu_len = 0;
     int apdu_len = 0;
@@ -67,14 +69,18 @@ void handler_get_alarm_summary(uint8_t *service_request,
     BACNET_NPDU_DATA npdu_data;
     BACNET_GET_ALARM_SUMMARY_DATA getalarm_data;
 
+    tx = tsm_transmit_context_acquire();
+    if (!tx) {
+        /* no transmit buffer available - the client will retry */
+        return;
+    }
     /* encode the NPDU portion of the packet */
     datalink_get_my_address(&my_address);
     npdu_encode_npdu_data(&npdu_data, false, MESSAGE_PRIORITY_NORMAL);
-    pdu_len = npdu_encode_pdu(
-        &Handler_Transmit_Buffer[0], src, &my_address, &npdu_data);
+    pdu_len = npdu_cache_encode_pdu(&tx->pdu[0], src, &my_address, &npdu_data);
     if (service_data->segmented_message) {
         /* we don't support segmentation - send an abort */
-        apdu_len = abort_encode_apdu(&Handler_Transmit_Buffer[pdu_len],
+        apdu_len = abort_encode_apdu(&tx->pdu[pdu_len],
             service_data->invoke_id, ABORT_REASON_SEGMENTATION_NOT_SUPPORTED,
             true);
 #if PRINT_ENABLED
@@ -85,7 +91,7 @@ void handler_get_alarm_summary(uint8_t *service_request,
 
     /* init header */
     apdu_len = get_alarm_summary_ack_encode_apdu_init(
-        &Handler_Transmit_Buffer[pdu_len], service_data->invoke_id);
+        &tx->pdu[pdu_len], service_data->invoke_id);
 
     for (i = 0; i < MAX_BACNET_OBJECT_TYPE; i++) {
         if (Get_Alarm_Summary[i]) {
@@ -93,7 +99,7 @@ void handler_get_alarm_summary(uint8_t *service_request,
                 alarm_value = Get_Alarm_Summary[i](j, &getalarm_data);
                 if (alarm_value > 0) {
                     len = get_alarm_summary_ack_encode_apdu_data(
-                        &Handler_Transmit_Buffer[pdu_len + apdu_len],
+                        &tx->pdu[pdu_len + apdu_len],
                         service_data->max_resp - apdu_len, &getalarm_data);
                     if (len <= 0) {
                         error = true;
@@ -116,7 +122,7 @@ GET_ALARM_SUMMARY_ERROR:
     if (error) {
         if (len == BACNET_STATUS_ABORT) {
             /* BACnet APDU too small to fit data, so proper response is Abort */
-            apdu_len = abort_encode_apdu(&Handler_Transmit_Buffer[pdu_len],
+            apdu_len = abort_encode_apdu(&tx->pdu[pdu_len],
                 service_data->invoke_id,
                 ABORT_REASON_SEGMENTATION_NOT_SUPPORTED, true);
 #if PRINT_ENABLED
@@ -124,7 +130,7 @@ GET_ALARM_SUMMARY_ERROR:
                 stderr, "GetAlarmSummary: Reply too big to fit into APDU!\n");
 #endif
         } else {
-            apdu_len = bacerror_encode_apdu(&Handler_Transmit_Buffer[pdu_len],
+            apdu_len = bacerror_encode_apdu(&tx->pdu[pdu_len],
                 service_data->invoke_id, SERVICE_CONFIRMED_GET_ALARM_SUMMARY,
                 ERROR_CLASS_PROPERTY, ERROR_CODE_OTHER);
 #if PRINT_ENABLED
@@ -135,8 +141,8 @@ GET_ALARM_SUMMARY_ERROR:
 
 GET_ALARM_SUMMARY_ABORT:
     pdu_len += apdu_len;
-    bytes_sent = datalink_send_pdu(
-        src, &npdu_data, &Handler_Transmit_Buffer[0], pdu_len);
+    bytes_sent = datalink_send_pdu(src, &npdu_data, &tx->pdu[0], pdu_len);
+    tsm_transmit_context_release(tx);
 #if PRINT_ENABLED
     if (bytes_sent <= 0) {
         /*fprintf(stderr, "Failed to send PDU (%s)!\n", strerror(errno)); */
@@ -37,6 +37,7 @@
 /* basic objects, services, TSM, and datalink */
 #include "bacnet/basic/services.h"
 #include "bacnet/basic/tsm/tsm.h"
+#include "bacnet/basic/npdu/npdu_cache.h"
 #include "bacnet/basic/object/device.h"
 #include "bacnet/datalink/datalink.h"
 
@@ -47,6 +48,7 @@ void handler_lso(uint8_t *service_request,
     BACNET_ADDRESS *src,
     BACNET_CONFIRMED_SERVICE_DATA *service_data)
 {
+    BACNET_TRANSMIT_CONTEXT *tx = NULL;
     BACNET_LSO_DATA data;
     int len = 0;
     int pdu_len = 0;
@@ -56,14 +58,18 @@ void handler_lso(uint8_t *service_request,
 #endif
     BACNET_ADDRESS my_address;
 
+    tx = tsm_transmit_context_acquire();
+    if (!tx) {
+        /* no transmit buffer available - the client will retry */
+        return;
+    }
     /* encode the NPDU portion of the packet */
     datalink_get_my_address(&my_address);
     npdu_encode_npdu_data(&npdu_data, false, MESSAGE_PRIORITY_NORMAL);
-    pdu_len = npdu_encode_pdu(
-        &Handler_Transmit_Buffer[0], src, &my_address, &npdu_data);
+    pdu_len = npdu_cache_encode_pdu(&tx->pdu[0], src, &my_address, &npdu_data);
     if (service_data->segmented_message) {
         /* we don't support segmentation - send an abort */
-        len = abort_encode_apdu(&Handler_Transmit_Buffer[pdu_len],
+        len = abort_encode_apdu(&tx->pdu[pdu_len],
             service_data->invoke_id, ABORT_REASON_SEGMENTATION_NOT_SUPPORTED,
             true);
 #if PRINT_ENABLED
@@ -79,7 +85,7 @@ void handler_lso(uint8_t *service_request,
 #endif
     if (len < 0) {
         /* bad decoding - send an abort */
-        len = abort_encode_apdu(&Handler_Transmit_Buffer[pdu_len],
+        len = abort_encode_apdu(&tx->pdu[pdu_len],
             service_data->invoke_id, ABORT_REASON_OTHER, true);
 #if PRINT_ENABLED
         fprintf(stderr, "LSO: Bad Encoding.  Sending Abort!\n");
@@ -98,7 +104,7 @@ void handler_lso(uint8_t *service_request,
         (unsigned long)data.targetObject.instance);
 #endif
 
-    len = encode_simple_ack(&Handler_Transmit_Buffer[pdu_len],
+    len = encode_simple_ack(&tx->pdu[pdu_len],
         service_data->invoke_id, SERVICE_CONFIRMED_LIFE_SAFETY_OPERATION);
 #if PRINT_ENABLED
     fprintf(stderr,
@@ -111,8 +117,8 @@ LSO_ABORT:
 #if PRINT_ENABLED
     bytes_sent =
 #endif
-        datalink_send_pdu(
-            src, &npdu_data, &Handler_Transmit_Buffer[0], pdu_len);
+        datalink_send_pdu(src, &npdu_data, &tx->pdu[0], pdu_len);
+    tsm_transmit_context_release(tx);
 #if PRINT_ENABLED
     if (bytes_sent <= 0)
         fprintf(stderr,
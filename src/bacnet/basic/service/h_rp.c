@@ -44,6 +44,7 @@
 #endif
 #include "bacnet/basic/tsm/tsm.h"
 #include "bacnet/basic/services.h"
+#include "bacnet/basic/npdu/npdu_cache.h"
 #include "bacnet/datalink/datalink.h"
 
 /** @file h_rp.c  Handles Read Property requests. */
@@ -72,6 +73,7 @@ void handler_read_property(uint8_t *service_request,
     BACNET_ADDRESS *src,
     BACNET_CONFIRMED_SERVICE_DATA *service_data)
 {
+    BACNET_TRANSMIT_CONTEXT *tx = NULL;
     BACNET_READ_PROPERTY_DATA rpdata;
     int len = 0;
     int pdu_len = 0;
@@ -84,11 +86,15 @@ void handler_read_property(uint8_t *service_request,
 
     /* configure default error code as an abort since it is common */
     rpdata.error_code = ERROR_CODE_ABORT_SEGMENTATION_NOT_SUPPORTED;
+    tx = tsm_transmit_context_acquire();
+    if (!tx) {
+        /* no transmit buffer available - the client will retry */
+        return;
+    }
     /* encode the NPDU portion of the packet */
     datalink_get_my_address(&my_address);
     npdu_encode_npdu_data(&npdu_data, false, MESSAGE_PRIORITY_NORMAL);
-    npdu_len = npdu_encode_pdu(
-        &Handler_Transmit_Buffer[0], src, &my_address, &npdu_data);
+    npdu_len = npdu_cache_encode_pdu(&tx->pdu[0], src, &my_address, &npdu_data);
     if (npdu_len <= 0) {
         /* If 0 or negative, there were problems with the data or encoding. */
         len = BACNET_STATUS_ABORT;
@@ -141,18 +147,18 @@ void handler_read_property(uint8_t *service_request,
             }
 #endif
             apdu_len =
-                rp_ack_encode_apdu_init(&Handler_Transmit_Buffer[npdu_len],
+                rp_ack_encode_apdu_init(&tx->pdu[npdu_len],
                     service_data->invoke_id, &rpdata);
             /* configure our storage */
             rpdata.application_data =
-                &Handler_Transmit_Buffer[npdu_len + apdu_len];
+                &tx->pdu[npdu_len + apdu_len];
             rpdata.application_data_len =
-                sizeof(Handler_Transmit_Buffer) - (npdu_len + apdu_len);
+                MAX_PDU - (npdu_len + apdu_len);
             len = Device_Read_Property(&rpdata);
             if (len >= 0) {
                 apdu_len += len;
                 len = rp_ack_encode_apdu_object_property_end(
-                    &Handler_Transmit_Buffer[npdu_len + apdu_len]);
+                    &tx->pdu[npdu_len + apdu_len]);
                 apdu_len += len;
                 if (apdu_len > service_data->max_resp) {
                     /* too big for the sender - send an abort!
@@ -190,21 +196,21 @@ void handler_read_property(uint8_t *service_request,
 
     if (error) {
         if (len == BACNET_STATUS_ABORT) {
-            apdu_len = abort_encode_apdu(&Handler_Transmit_Buffer[npdu_len],
+            apdu_len = abort_encode_apdu(&tx->pdu[npdu_len],
                 service_data->invoke_id,
                 abort_convert_error_code(rpdata.error_code), true);
 #if PRINT_ENABLED
             fprintf(stderr, "RP: Sending Abort!\n");
 #endif
         } else if (len == BACNET_STATUS_ERROR) {
-            apdu_len = bacerror_encode_apdu(&Handler_Transmit_Buffer[npdu_len],
+            apdu_len = bacerror_encode_apdu(&tx->pdu[npdu_len],
                 service_data->invoke_id, SERVICE_CONFIRMED_READ_PROPERTY,
                 rpdata.error_class, rpdata.error_code);
 #if PRINT_ENABLED
             fprintf(stderr, "RP: Sending Error!\n");
 #endif
         } else if (len == BACNET_STATUS_REJECT) {
-            apdu_len = reject_encode_apdu(&Handler_Transmit_Buffer[npdu_len],
+            apdu_len = reject_encode_apdu(&tx->pdu[npdu_len],
                 service_data->invoke_id,
                 reject_convert_error_code(rpdata.error_code));
 #if PRINT_ENABLED
@@ -214,8 +220,8 @@ void handler_read_property(uint8_t *service_request,
     }
 
     pdu_len = npdu_len + apdu_len;
-    bytes_sent = datalink_send_pdu(
-        src, &npdu_data, &Handler_Transmit_Buffer[0], pdu_len);
+    bytes_sent = datalink_send_pdu(src, &npdu_data, &tx->pdu[0], pdu_len);
+    tsm_transmit_context_release(tx);
     if (bytes_sent <= 0) {
 #if PRINT_ENABLED
         fprintf(stderr, "Failed to send PDU (%s)!\n", strerror(errno));
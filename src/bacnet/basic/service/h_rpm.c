@@ -46,6 +46,7 @@
 #endif
 #include "bacnet/basic/tsm/tsm.h"
 #include "bacnet/basic/services.h"
+#include "bacnet/basic/npdu/npdu_cache.h"
 #include "bacnet/datalink/datalink.h"
 
 /** @file h_rpm.c  Handles Read Property Multiple requests. */
@@ -194,6 +195,7 @@ void handler_read_property_multiple(uint8_t *service_request,
     BACNET_ADDRESS *src,
     BACNET_CONFIRMED_SERVICE_DATA *service_data)
 {
+    BACNET_TRANSMIT_CONTEXT *tx = NULL;
     bool berror = false;
     int len = 0;
     uint16_t copy_len = 0;
@@ -208,14 +210,18 @@ void handler_read_property_multiple(uint8_t *service_request,
     int error = 0;
 
     if (service_data && (service_len > 0)) {
+        tx = tsm_transmit_context_acquire();
+        if (!tx) {
+            /* no transmit buffer available - the client will retry */
+            return;
+        }
         /* jps_debug - see if we are utilizing all the buffer */
-        /* memset(&Handler_Transmit_Buffer[0], 0xff,
-         * sizeof(Handler_Transmit_Buffer)); */
+        /* memset(&tx->pdu[0], 0xff, MAX_PDU); */
         /* encode the NPDU portion of the packet */
         datalink_get_my_address(&my_address);
         npdu_encode_npdu_data(&npdu_data, false, MESSAGE_PRIORITY_NORMAL);
-        npdu_len = npdu_encode_pdu(
-            &Handler_Transmit_Buffer[0], src, &my_address, &npdu_data);
+        npdu_len =
+            npdu_cache_encode_pdu(&tx->pdu[0], src, &my_address, &npdu_data);
 
         if (service_data->segmented_message) {
             rpmdata.error_code = ERROR_CODE_ABORT_SEGMENTATION_NOT_SUPPORTED;
@@ -227,7 +233,7 @@ void handler_read_property_multiple(uint8_t *service_request,
             /* decode apdu request & encode apdu reply
                encode complex ack, invoke id, service choice */
             apdu_len = rpm_ack_encode_apdu_init(
-                &Handler_Transmit_Buffer[npdu_len], service_data->invoke_id);
+                &tx->pdu[npdu_len], service_data->invoke_id);
 
             for (;;) {
                 /* Start by looking for an object ID */
@@ -269,7 +275,7 @@ void handler_read_property_multiple(uint8_t *service_request,
 
                 /* Stick this object id into the reply - if it will fit */
                 len = rpm_ack_encode_apdu_object_begin(&Temp_Buf[0], &rpmdata);
-                copy_len = memcopy(&Handler_Transmit_Buffer[npdu_len],
+                copy_len = memcopy(&tx->pdu[npdu_len],
                     &Temp_Buf[0], apdu_len, len, MAX_APDU);
                 if (copy_len == 0) {
 #if PRINT_ENABLED
@@ -313,7 +319,7 @@ void handler_read_property_multiple(uint8_t *service_request,
                         if (!Device_Valid_Object_Id(rpmdata.object_type,
                                                     rpmdata.object_instance)) {
                             len = RPM_Encode_Property(
-                                &Handler_Transmit_Buffer[npdu_len],
+                                &tx->pdu[npdu_len],
                                 (uint16_t)apdu_len, MAX_APDU, &rpmdata);
                             if (len > 0) {
                                 apdu_len += len;
@@ -337,7 +343,7 @@ void handler_read_property_multiple(uint8_t *service_request,
                                 rpmdata.array_index);
 
                             copy_len =
-                                memcopy(&Handler_Transmit_Buffer[npdu_len],
+                                memcopy(&tx->pdu[npdu_len],
                                     &Temp_Buf[0], apdu_len, len, MAX_APDU);
 
                             if (copy_len == 0) {
@@ -359,7 +365,7 @@ void handler_read_property_multiple(uint8_t *service_request,
                                 ERROR_CODE_PROPERTY_IS_NOT_AN_ARRAY);
 
                             copy_len =
-                                memcopy(&Handler_Transmit_Buffer[npdu_len],
+                                memcopy(&tx->pdu[npdu_len],
                                     &Temp_Buf[0], apdu_len, len, MAX_APDU);
 
                             if (copy_len == 0) {
@@ -394,7 +400,7 @@ void handler_read_property_multiple(uint8_t *service_request,
                                 if (!Device_Valid_Object_Id(rpmdata.object_type,
                                   rpmdata.object_instance)) {
                                     len = RPM_Encode_Property(
-                                        &Handler_Transmit_Buffer[npdu_len],
+                                        &tx->pdu[npdu_len],
                                         (uint16_t)apdu_len, MAX_APDU, &rpmdata);
                                     if (len > 0) {
                                         apdu_len += len;
@@ -417,7 +423,7 @@ void handler_read_property_multiple(uint8_t *service_request,
                                         RPM_Object_Property(&property_list,
                                             special_object_property, index);
                                     len = RPM_Encode_Property(
-                                        &Handler_Transmit_Buffer[npdu_len],
+                                        &tx->pdu[npdu_len],
                                         (uint16_t)apdu_len, MAX_APDU, &rpmdata);
                                     if (len > 0) {
                                         apdu_len += len;
@@ -438,7 +444,7 @@ void handler_read_property_multiple(uint8_t *service_request,
                     } else {
                         /* handle an individual property */
                         len = RPM_Encode_Property(
-                            &Handler_Transmit_Buffer[npdu_len],
+                            &tx->pdu[npdu_len],
                             (uint16_t)apdu_len, MAX_APDU, &rpmdata);
                         if (len > 0) {
                             apdu_len += len;
@@ -460,7 +466,7 @@ void handler_read_property_multiple(uint8_t *service_request,
                          */
                         decode_len++;
                         len = rpm_ack_encode_apdu_object_end(&Temp_Buf[0]);
-                        copy_len = memcopy(&Handler_Transmit_Buffer[npdu_len],
+                        copy_len = memcopy(&tx->pdu[npdu_len],
                             &Temp_Buf[0], apdu_len, len, MAX_APDU);
                         if (copy_len == 0) {
 #if PRINT_ENABLED
@@ -506,7 +512,7 @@ void handler_read_property_multiple(uint8_t *service_request,
         /* Error fallback. */
         if (error) {
             if (error == BACNET_STATUS_ABORT) {
-                apdu_len = abort_encode_apdu(&Handler_Transmit_Buffer[npdu_len],
+                apdu_len = abort_encode_apdu(&tx->pdu[npdu_len],
                     service_data->invoke_id,
                     abort_convert_error_code(rpmdata.error_code), true);
 #if PRINT_ENABLED
@@ -514,7 +520,7 @@ void handler_read_property_multiple(uint8_t *service_request,
 #endif
             } else if (error == BACNET_STATUS_ERROR) {
                 apdu_len = bacerror_encode_apdu(
-                    &Handler_Transmit_Buffer[npdu_len], service_data->invoke_id,
+                    &tx->pdu[npdu_len], service_data->invoke_id,
                     SERVICE_CONFIRMED_READ_PROP_MULTIPLE, rpmdata.error_class,
                     rpmdata.error_code);
 #if PRINT_ENABLED
@@ -522,7 +528,7 @@ void handler_read_property_multiple(uint8_t *service_request,
 #endif
             } else if (error == BACNET_STATUS_REJECT) {
                 apdu_len = reject_encode_apdu(
-                    &Handler_Transmit_Buffer[npdu_len], service_data->invoke_id,
+                    &tx->pdu[npdu_len], service_data->invoke_id,
                     reject_convert_error_code(rpmdata.error_code));
 #if PRINT_ENABLED
                 fprintf(stderr, "RPM: Sending Reject!\n");
@@ -531,8 +537,8 @@ void handler_read_property_multiple(uint8_t *service_request,
         }
 
         pdu_len = apdu_len + npdu_len;
-        bytes_sent = datalink_send_pdu(
-            src, &npdu_data, &Handler_Transmit_Buffer[0], pdu_len);
+        bytes_sent = datalink_send_pdu(src, &npdu_data, &tx->pdu[0], pdu_len);
+        tsm_transmit_context_release(tx);
         if (bytes_sent <= 0) {
 #if PRINT_ENABLED
             fprintf(stderr, "RPM: Failed to send PDU (%s)!\n", strerror(errno));
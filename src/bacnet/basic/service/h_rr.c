@@ -39,6 +39,7 @@
 #include "bacnet/basic/object/device.h"
 #include "bacnet/basic/tsm/tsm.h"
 #include "bacnet/basic/services.h"
+#include "bacnet/basic/npdu/npdu_cache.h"
 #include "bacnet/datalink/datalink.h"
 
 /** @file h_rr.c  Handles Read Range requests. */
@@ -125,6 +126,7 @@ void handler_read_range(uint8_t *service_request,
     BACNET_ADDRESS *src,
     BACNET_CONFIRMED_SERVICE_DATA *service_data)
 {
+    BACNET_TRANSMIT_CONTEXT *tx = NULL;
     BACNET_READ_RANGE_DATA data;
     int len = 0;
     int pdu_len = 0;
@@ -137,14 +139,18 @@ void handler_read_range(uint8_t *service_request,
 
     data.error_class = ERROR_CLASS_OBJECT;
     data.error_code = ERROR_CODE_UNKNOWN_OBJECT;
+    tx = tsm_transmit_context_acquire();
+    if (!tx) {
+        /* no transmit buffer available - the client will retry */
+        return;
+    }
     /* encode the NPDU portion of the packet */
     datalink_get_my_address(&my_address);
     npdu_encode_npdu_data(&npdu_data, false, MESSAGE_PRIORITY_NORMAL);
-    pdu_len = npdu_encode_pdu(
-        &Handler_Transmit_Buffer[0], src, &my_address, &npdu_data);
+    pdu_len = npdu_cache_encode_pdu(&tx->pdu[0], src, &my_address, &npdu_data);
     if (service_data->segmented_message) {
         /* we don't support segmentation - send an abort */
-        len = abort_encode_apdu(&Handler_Transmit_Buffer[pdu_len],
+        len = abort_encode_apdu(&tx->pdu[pdu_len],
             service_data->invoke_id, ABORT_REASON_SEGMENTATION_NOT_SUPPORTED,
             true);
 #if PRINT_ENABLED
@@ -159,7 +165,7 @@ void handler_read_range(uint8_t *service_request,
 #endif
         if (len < 0) {
             /* bad decoding - send an abort */
-            len = abort_encode_apdu(&Handler_Transmit_Buffer[pdu_len],
+            len = abort_encode_apdu(&tx->pdu[pdu_len],
                 service_data->invoke_id, ABORT_REASON_OTHER, true);
 #if PRINT_ENABLED
             fprintf(stderr, "RR: Bad Encoding.  Sending Abort!\n");
@@ -173,7 +179,7 @@ void handler_read_range(uint8_t *service_request,
                 data.application_data = &Temp_Buf[0];
                 data.application_data_len = len;
                 /* FIXME: probably need a length limitation sent with encode */
-                len = rr_ack_encode_apdu(&Handler_Transmit_Buffer[pdu_len],
+                len = rr_ack_encode_apdu(&tx->pdu[pdu_len],
                     service_data->invoke_id, &data);
 #if PRINT_ENABLED
                 fprintf(stderr, "RR: Sending Ack!\n");
@@ -184,7 +190,7 @@ void handler_read_range(uint8_t *service_request,
                 if (len == -2) {
                     /* BACnet APDU too small to fit data, so proper response is
                      * Abort */
-                    len = abort_encode_apdu(&Handler_Transmit_Buffer[pdu_len],
+                    len = abort_encode_apdu(&tx->pdu[pdu_len],
                         service_data->invoke_id,
                         ABORT_REASON_SEGMENTATION_NOT_SUPPORTED, true);
 #if PRINT_ENABLED
@@ -192,7 +198,7 @@ void handler_read_range(uint8_t *service_request,
 #endif
                 } else {
                     len = bacerror_encode_apdu(
-                        &Handler_Transmit_Buffer[pdu_len],
+                        &tx->pdu[pdu_len],
                         service_data->invoke_id, SERVICE_CONFIRMED_READ_RANGE,
                         data.error_class, data.error_code);
 #if PRINT_ENABLED
@@ -207,8 +213,8 @@ void handler_read_range(uint8_t *service_request,
 #if PRINT_ENABLED
     bytes_sent =
 #endif
-        datalink_send_pdu(
-            src, &npdu_data, &Handler_Transmit_Buffer[0], pdu_len);
+        datalink_send_pdu(src, &npdu_data, &tx->pdu[0], pdu_len);
+    tsm_transmit_context_release(tx);
 #if PRINT_ENABLED
     if (bytes_sent <= 0)
         fprintf(stderr, "Failed to send PDU (%s)!\n", strerror(errno));
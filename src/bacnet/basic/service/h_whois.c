@@ -38,6 +38,25 @@
 
 /** @file h_whois.c  Handles Who-Is requests. */
 
+/** Send an I-Am using a transmit context from the TSM pool.
+ * @param dest [in] The address to unicast the I-Am to,
+ *                  or NULL to broadcast the I-Am.
+ */
+static void who_is_send_i_am(BACNET_ADDRESS *dest)
+{
+    BACNET_TRANSMIT_CONTEXT *tx = NULL;
+
+    tx = tsm_transmit_context_acquire();
+    if (tx) {
+        if (dest) {
+            Send_I_Am_Unicast(&tx->pdu[0], dest);
+        } else {
+            Send_I_Am(&tx->pdu[0]);
+        }
+        tsm_transmit_context_release(tx);
+    }
+}
+
 /** Handler for Who-Is requests, with broadcast I-Am response.
  * @ingroup DMDDB
  * @param service_request [in] The received message to be handled.
@@ -55,12 +74,12 @@ void handler_who_is(
     len = whois_decode_service_request(
         service_request, service_len, &low_limit, &high_limit);
     if (len == 0) {
-        Send_I_Am(&Handler_Transmit_Buffer[0]);
+        who_is_send_i_am(NULL);
     } else if (len != BACNET_STATUS_ERROR) {
         /* is my device id within the limits? */
         if ((Device_Object_Instance_Number() >= (uint32_t)low_limit) &&
             (Device_Object_Instance_Number() <= (uint32_t)high_limit)) {
-            Send_I_Am(&Handler_Transmit_Buffer[0]);
+            who_is_send_i_am(NULL);
         }
     }
 
@@ -86,12 +105,12 @@ void handler_who_is_unicast(
         service_request, service_len, &low_limit, &high_limit);
     /* If no limits, then always respond */
     if (len == 0) {
-        Send_I_Am_Unicast(&Handler_Transmit_Buffer[0], src);
+        who_is_send_i_am(src);
     } else if (len != BACNET_STATUS_ERROR) {
         /* is my device id within the limits? */
         if ((Device_Object_Instance_Number() >= (uint32_t)low_limit) &&
             (Device_Object_Instance_Number() <= (uint32_t)high_limit)) {
-            Send_I_Am_Unicast(&Handler_Transmit_Buffer[0], src);
+            who_is_send_i_am(src);
         }
     }
 
@@ -107,7 +126,9 @@ void handler_who_is_unicast(
 
 /** Local function to check Who-Is requests against our Device IDs.
  * Will check the gateway (root Device) and all virtual routed
- * Devices against the range and respond for each that matches.
+ * Devices against the range and queue a response for each that matches.
+ * The responses are paced by handler_who_is_task() so that a gateway
+ * with many Devices does not answer in one burst.
  *
  * @param service_request [in] The received message to be handled.
  * @param service_len [in] Length of the service_request message.
@@ -144,10 +165,8 @@ static void check_who_is_for_routing(uint8_t *service_request,
         /* If len == 0, no limits and always respond */
         if ((len == 0) ||
             ((dev_instance >= low_limit) && (dev_instance <= high_limit))) {
-            if (is_unicast)
-                Send_I_Am_Unicast(&Handler_Transmit_Buffer[0], src);
-            else
-                Send_I_Am(&Handler_Transmit_Buffer[0]);
+            handler_who_is_i_am_queue(
+                Routed_Device_Current_Index(), is_unicast ? src : NULL);
         }
     }
 }
@@ -156,7 +175,8 @@ static void check_who_is_for_routing(uint8_t *service_request,
  * with broadcast I-Am response(s).
  * @ingroup DMDDB
  * Will check the gateway (root Device) and all virtual routed
- * Devices against the range and respond for each that matches.
+ * Devices against the range and queues an I-Am for each that matches.
+ * The I-Am are only sent when the main loop calls handler_who_is_task().
  *
  * @ingroup DMDDB
  * @param service_request [in] The received message to be handled.
@@ -172,7 +192,8 @@ void handler_who_is_bcast_for_routing(
 /** Handler for Who-Is requests in the virtual routing setup,
  * with unicast I-Am response(s) returned to the src.
  * Will check the gateway (root Device) and all virtual routed
- * Devices against the range and respond for each that matches.
+ * Devices against the range and queues an I-Am for each that matches.
+ * The I-Am are only sent when the main loop calls handler_who_is_task().
  *
  * @ingroup DMDDB
  * @param service_request [in] The received message to be handled.
@@ -185,4 +206,5 @@ void handler_who_is_unicast_for_routing(
 {
     check_who_is_for_routing(service_request, service_len, src, true);
 }
+
 #endif /* BAC_ROUTING */
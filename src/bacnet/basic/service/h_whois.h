@@ -37,6 +37,29 @@
 #include "bacnet/bacenum.h"
 #include "bacnet/apdu.h"
 
+#ifdef BAC_ROUTING
+/* milliseconds to spread the I-Am responses of a gateway over */
+#ifndef WHO_IS_I_AM_WINDOW
+#define WHO_IS_I_AM_WINDOW 2000
+#endif
+/* maximum number of I-Am sent per second on the datalink */
+#ifndef WHO_IS_I_AM_RATE
+#if defined(BACDL_MSTP) && !defined(BACDL_BIP) && !defined(BACDL_BIP6)
+#define WHO_IS_I_AM_RATE 20
+#else
+#define WHO_IS_I_AM_RATE 500
+#endif
+#endif
+/* maximum number of I-Am sent by one call of handler_who_is_task() */
+#ifndef WHO_IS_I_AM_BATCH
+#define WHO_IS_I_AM_BATCH 32
+#endif
+/* number of clients with pending unicast I-Am responses */
+#ifndef WHO_IS_I_AM_DEST_MAX
+#define WHO_IS_I_AM_DEST_MAX 4
+#endif
+#endif
+
 #ifdef __cplusplus
 extern "C" {
 #endif /* __cplusplus */
@@ -65,6 +88,34 @@ extern "C" {
         uint16_t service_len,
         BACNET_ADDRESS * src);
 
+/* Pacing of the I-Am responses of routed Devices.
+ * Enable by defining BAC_ROUTING and including gateway/gw_whois.c
+ * in the build, as the gateway application does.
+ */
+    BACNET_STACK_EXPORT
+    void handler_who_is_unicast_paced(
+        uint8_t * service_request,
+        uint16_t service_len,
+        BACNET_ADDRESS * src);
+
+    BACNET_STACK_EXPORT
+    bool handler_who_is_i_am_queue(
+        unsigned device_index,
+        BACNET_ADDRESS * dest);
+
+    BACNET_STACK_EXPORT
+    void handler_who_is_task(
+        void);
+
+    BACNET_STACK_EXPORT
+    unsigned handler_who_is_pending(
+        void);
+
+    BACNET_STACK_EXPORT
+    void handler_who_is_pacing_set(
+        uint32_t window_ms,
+        uint32_t rate);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
@@ -39,6 +39,7 @@
 #include "bacnet/basic/object/device.h"
 #include "bacnet/basic/tsm/tsm.h"
 #include "bacnet/basic/services.h"
+#include "bacnet/basic/npdu/npdu_cache.h"
 #include "bacnet/datalink/datalink.h"
 
 /** @file h_wp.c  Handles Write Property requests. */
@@ -66,6 +67,7 @@ void handler_write_property(uint8_t *service_request,
     BACNET_ADDRESS *src,
     BACNET_CONFIRMED_SERVICE_DATA *service_data)
 {
+    BACNET_TRANSMIT_CONTEXT *tx = NULL;
     BACNET_WRITE_PROPERTY_DATA wp_data;
     int len = 0;
     bool bcontinue = true;
@@ -74,16 +76,20 @@ void handler_write_property(uint8_t *service_request,
     int bytes_sent = 0;
     BACNET_ADDRESS my_address;
 
+    tx = tsm_transmit_context_acquire();
+    if (!tx) {
+        /* no transmit buffer available - the client will retry */
+        return;
+    }
     /* encode the NPDU portion of the packet */
     datalink_get_my_address(&my_address);
     npdu_encode_npdu_data(&npdu_data, false, MESSAGE_PRIORITY_NORMAL);
-    pdu_len = npdu_encode_pdu(
-        &Handler_Transmit_Buffer[0], src, &my_address, &npdu_data);
+    pdu_len = npdu_cache_encode_pdu(&tx->pdu[0], src, &my_address, &npdu_data);
 #if PRINT_ENABLED
     fprintf(stderr, "WP: Received Request!\n");
 #endif
     if (service_data->segmented_message) {
-        len = abort_encode_apdu(&Handler_Transmit_Buffer[pdu_len],
+        len = abort_encode_apdu(&tx->pdu[pdu_len],
             service_data->invoke_id, ABORT_REASON_SEGMENTATION_NOT_SUPPORTED,
             true);
 #if PRINT_ENABLED
@@ -109,7 +115,7 @@ void handler_write_property(uint8_t *service_request,
 #endif
         /* bad decoding or something we didn't understand - send an abort */
         if (len <= 0) {
-            len = abort_encode_apdu(&Handler_Transmit_Buffer[pdu_len],
+            len = abort_encode_apdu(&tx->pdu[pdu_len],
                 service_data->invoke_id, ABORT_REASON_OTHER, true);
 #if PRINT_ENABLED
             fprintf(stderr, "WP: Bad Encoding. Sending Abort!\n");
@@ -119,13 +125,13 @@ void handler_write_property(uint8_t *service_request,
 
         if (bcontinue) {
             if (Device_Write_Property(&wp_data)) {
-                len = encode_simple_ack(&Handler_Transmit_Buffer[pdu_len],
+                len = encode_simple_ack(&tx->pdu[pdu_len],
                     service_data->invoke_id, SERVICE_CONFIRMED_WRITE_PROPERTY);
 #if PRINT_ENABLED
                 fprintf(stderr, "WP: Sending Simple Ack!\n");
 #endif
             } else {
-                len = bacerror_encode_apdu(&Handler_Transmit_Buffer[pdu_len],
+                len = bacerror_encode_apdu(&tx->pdu[pdu_len],
                     service_data->invoke_id, SERVICE_CONFIRMED_WRITE_PROPERTY,
                     wp_data.error_class, wp_data.error_code);
 #if PRINT_ENABLED
@@ -137,8 +143,8 @@ void handler_write_property(uint8_t *service_request,
 
     /* Send PDU */
     pdu_len += len;
-    bytes_sent = datalink_send_pdu(
-        src, &npdu_data, &Handler_Transmit_Buffer[0], pdu_len);
+    bytes_sent = datalink_send_pdu(src, &npdu_data, &tx->pdu[0], pdu_len);
+    tsm_transmit_context_release(tx);
     if (bytes_sent <= 0) {
 #if PRINT_ENABLED
         fprintf(stderr, "WP: Failed to send PDU (%s)!\n", strerror(errno));
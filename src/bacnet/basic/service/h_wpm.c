@@ -41,6 +41,7 @@
 #include "bacnet/basic/object/device.h"
 #include "bacnet/basic/tsm/tsm.h"
 #include "bacnet/basic/services.h"
+#include "bacnet/basic/npdu/npdu_cache.h"
 #include "bacnet/datalink/datalink.h"
 
 /** @file h_wpm.c  Handles Write Property Multiple requests. */
@@ -145,6 +146,7 @@ void handler_write_property_multiple(uint8_t *service_request,
     BACNET_ADDRESS *src,
     BACNET_CONFIRMED_SERVICE_DATA *service_data)
 {
+    BACNET_TRANSMIT_CONTEXT *tx = NULL;
     int len = 0;
     int apdu_len = 0;
     int npdu_len = 0;
@@ -168,36 +170,40 @@ void handler_write_property_multiple(uint8_t *service_request,
         }
     }
     /* encode the confirmed reply */
+    tx = tsm_transmit_context_acquire();
+    if (!tx) {
+        /* no transmit buffer available - the client will retry */
+        return;
+    }
     datalink_get_my_address(&my_address);
     npdu_encode_npdu_data(&npdu_data, false, MESSAGE_PRIORITY_NORMAL);
-    npdu_len = npdu_encode_pdu(
-        &Handler_Transmit_Buffer[0], src, &my_address, &npdu_data);
+    npdu_len = npdu_cache_encode_pdu(&tx->pdu[0], src, &my_address, &npdu_data);
     if (len > 0) {
         apdu_len = wpm_ack_encode_apdu_init(
-            &Handler_Transmit_Buffer[npdu_len], service_data->invoke_id);
+            &tx->pdu[npdu_len], service_data->invoke_id);
         PRINTF("WPM: Sending Ack!\n");
     } else {
         /* handle any errors */
         if (len == BACNET_STATUS_ABORT) {
-            apdu_len = abort_encode_apdu(&Handler_Transmit_Buffer[npdu_len],
+            apdu_len = abort_encode_apdu(&tx->pdu[npdu_len],
                 service_data->invoke_id,
                 abort_convert_error_code(wp_data.error_code), true);
             PRINTF("WPM: Sending Abort!\n");
         } else if (len == BACNET_STATUS_ERROR) {
             apdu_len =
-                wpm_error_ack_encode_apdu(&Handler_Transmit_Buffer[npdu_len],
+                wpm_error_ack_encode_apdu(&tx->pdu[npdu_len],
                     service_data->invoke_id, &wp_data);
             PRINTF("WPM: Sending Error!\n");
         } else if (len == BACNET_STATUS_REJECT) {
-            apdu_len = reject_encode_apdu(&Handler_Transmit_Buffer[npdu_len],
+            apdu_len = reject_encode_apdu(&tx->pdu[npdu_len],
                 service_data->invoke_id,
                 reject_convert_error_code(wp_data.error_code));
             PRINTF("WPM: Sending Reject!\n");
         }
     }
     pdu_len = npdu_len + apdu_len;
-    bytes_sent = datalink_send_pdu(
-        src, &npdu_data, &Handler_Transmit_Buffer[0], pdu_len);
+    bytes_sent = datalink_send_pdu(src, &npdu_data, &tx->pdu[0], pdu_len);
+    tsm_transmit_context_release(tx);
     if (bytes_sent <= 0) {
         PRINTF("Failed to send PDU (%s)!\n", strerror(errno));
     }
@@ -172,6 +172,40 @@ uint8_t FIFO_Peek(FIFO_BUFFER const *b)
     return 0;
 }
 
+/**
+ * Copies one or more bytes from the front of the FIFO without
+ * removing them.  If less bytes are available, only the available
+ * bytes are copied.  Use FIFO_Pull() with a NULL buffer to remove
+ * the bytes once they have been consumed.
+ *
+ * @param b - pointer to FIFO_BUFFER structure
+ * @param buffer - buffer to hold the copied bytes
+ * @param length - number of bytes to copy
+ *
+ * @return the number of bytes actually copied
+ */
+unsigned FIFO_Peek_Ahead(
+    FIFO_BUFFER const *b, uint8_t *buffer, unsigned length)
+{
+    unsigned count;
+    unsigned tail;
+    unsigned i;
+
+    if (!b || !buffer) {
+        return 0;
+    }
+    count = FIFO_Count(b);
+    if (count > length) {
+        count = length;
+    }
+    tail = b->tail;
+    for (i = 0; i < count; i++) {
+        buffer[i] = b->buffer[(tail + i) % b->buffer_len];
+    }
+
+    return count;
+}
+
 /**
  * Gets a byte from the front of the FIFO, and removes it.
  * Use FIFO_Empty() or FIFO_Available() function to see if there is
@@ -221,6 +255,11 @@ unsigned FIFO_Pull(FIFO_BUFFER *b, uint8_t *buffer, unsigned length)
         /* adjust the return value */
         length = count;
     }
+    if (!buffer) {
+        /* discard without copying */
+        b->tail += count;
+        return length;
+    }
     while (count) {
         index = b->tail % b->buffer_len;
         data_byte = b->buffer[index];
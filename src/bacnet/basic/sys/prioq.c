@@ -0,0 +1,315 @@
+/**
+ * @file
+ * @date October 2026
+ * @brief Transmit queue with one FIFO for each of the four BACnet
+ *  network priorities, served by strict priority with aging.
+ *
+ * @section LICENSE
+ *
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include "bacnet/basic/sys/prioq.h"
+
+/* The queue only manages slot indexes. The caller keeps the PDU of
+   slot N in element N of its own array, so a queued PDU is never copied
+   or moved. Each priority class is a doubly linked FIFO of slots, and
+   unused slots are kept in a singly linked free list.
+
+   The next slot to send is the oldest PDU of the class with the highest
+   score, where the score is the class times the aging time plus the
+   milliseconds the PDU has waited. A PDU that waited for longer than
+   the aging time is therefore served ahead of newer PDU one class above
+   it, and a busy high priority class cannot starve the others. */
+
+static void prioq_unlink(PRIOQ *q, unsigned slot)
+{
+    struct prioq_slot *s = &q->slots[slot];
+
+    if (s->prev != PRIOQ_NONE) {
+        q->slots[s->prev].next = s->next;
+    } else {
+        q->head[s->priority] = s->next;
+    }
+    if (s->next != PRIOQ_NONE) {
+        q->slots[s->next].prev = s->prev;
+    } else {
+        q->tail[s->priority] = s->prev;
+    }
+    q->stats[s->priority].depth--;
+    q->count--;
+}
+
+/**
+ * @brief Initialize a priority queue
+ * @param q - queue to initialize
+ * @param slots - array of slots for the queue
+ * @param slot_count - number of slots in the array
+ * @param aging - milliseconds of waiting that count as one priority
+ *  class, or zero for strict priority
+ * @return true if the queue was initialized
+ */
+bool Prioq_Init(
+    PRIOQ *q, struct prioq_slot *slots, unsigned slot_count, uint32_t aging)
+{
+    unsigned i;
+
+    if (!q || !slots || (slot_count == 0) || (slot_count >= PRIOQ_NONE)) {
+        return false;
+    }
+    memset(q, 0, sizeof(PRIOQ));
+    q->slots = slots;
+    q->slot_count = (uint16_t)slot_count;
+    q->aging = aging;
+    for (i = 0; i < PRIOQ_CLASSES; i++) {
+        q->head[i] = PRIOQ_NONE;
+        q->tail[i] = PRIOQ_NONE;
+    }
+    for (i = 0; i < slot_count; i++) {
+        slots[i].next = (i + 1 < slot_count) ? (uint16_t)(i + 1) : PRIOQ_NONE;
+        slots[i].prev = PRIOQ_NONE;
+        slots[i].priority = 0;
+        slots[i].time = 0;
+    }
+    q->free = 0;
+
+    return true;
+}
+
+/**
+ * @brief Reserve a slot for a PDU of the given priority. When the queue
+ *  is full, the newest PDU of the lowest class below the given priority
+ *  is evicted and counted as dropped, and its slot is reused.
+ * @param q - priority queue
+ * @param priority - BACNET_MESSAGE_PRIORITY of the new PDU
+ * @param evicted - set true if a queued PDU was evicted, in which case
+ *  the caller discards whatever it kept for the returned slot
+ * @return slot index to be filled and queued with Prioq_Put(),
+ *  or -1 if the queue is full and the PDU is dropped
+ */
+int Prioq_Reserve(PRIOQ *q, uint8_t priority, bool *evicted)
+{
+    unsigned slot;
+    unsigned i;
+
+    if (evicted) {
+        *evicted = false;
+    }
+    if (!q) {
+        return -1;
+    }
+    priority %= PRIOQ_CLASSES;
+    if (q->free != PRIOQ_NONE) {
+        slot = q->free;
+        q->free = q->slots[slot].next;
+        return (int)slot;
+    }
+    for (i = 0; i < priority; i++) {
+        if (q->tail[i] != PRIOQ_NONE) {
+            slot = q->tail[i];
+            prioq_unlink(q, slot);
+            q->stats[i].dropped++;
+            if (evicted) {
+                *evicted = true;
+            }
+            return (int)slot;
+        }
+    }
+    q->stats[priority].dropped++;
+
+    return -1;
+}
+
+/**
+ * @brief Queue a reserved slot at the end of its priority class
+ * @param q - priority queue
+ * @param slot - slot index from Prioq_Reserve()
+ * @param priority - BACNET_MESSAGE_PRIORITY of the PDU
+ * @param now - milliseconds timestamp
+ */
+void Prioq_Put(PRIOQ *q, unsigned slot, uint8_t priority, uint32_t now)
+{
+    struct prioq_slot *s;
+    PRIOQ_STATS *stats;
+
+    if (!q || (slot >= q->slot_count)) {
+        return;
+    }
+    priority %= PRIOQ_CLASSES;
+    s = &q->slots[slot];
+    s->priority = priority;
+    s->time = now;
+    s->next = PRIOQ_NONE;
+    s->prev = q->tail[priority];
+    if (s->prev != PRIOQ_NONE) {
+        q->slots[s->prev].next = (uint16_t)slot;
+    } else {
+        q->head[priority] = (uint16_t)slot;
+    }
+    q->tail[priority] = (uint16_t)slot;
+    q->count++;
+    stats = &q->stats[priority];
+    stats->queued++;
+    stats->depth++;
+    if (stats->depth > stats->depth_max) {
+        stats->depth_max = stats->depth;
+    }
+}
+
+/**
+ * @brief Return a reserved slot that was not queued to the free list
+ * @param q - priority queue
+ * @param slot - slot index from Prioq_Reserve()
+ */
+void Prioq_Release(PRIOQ *q, unsigned slot)
+{
+    if (!q || (slot >= q->slot_count)) {
+        return;
+    }
+    q->slots[slot].next = q->free;
+    q->free = (uint16_t)slot;
+}
+
+/**
+ * @brief Find the next slot to send, without removing it
+ * @param q - priority queue
+ * @param now - milliseconds timestamp
+ * @return slot index, or -1 if the queue is empty
+ */
+int Prioq_Peek(PRIOQ const *q, uint32_t now)
+{
+    int best = -1;
+    uint64_t best_score = 0;
+    uint64_t score;
+    unsigned slot;
+    unsigned i;
+
+    if (!q) {
+        return -1;
+    }
+    for (i = PRIOQ_CLASSES; i > 0; i--) {
+        slot = q->head[i - 1];
+        if (slot == PRIOQ_NONE) {
+            continue;
+        }
+        if (q->aging == 0) {
+            return (int)slot;
+        }
+        score = ((uint64_t)(i - 1) * q->aging) +
+            (uint32_t)(now - q->slots[slot].time);
+        /* on a tie, the higher class found first wins */
+        if ((best < 0) || (score > best_score)) {
+            best = (int)slot;
+            best_score = score;
+        }
+    }
+
+    return best;
+}
+
+/**
+ * @brief Remove a queued slot once its PDU was sent, and count it.
+ *  The slot need not be the one returned by Prioq_Peek(), for example
+ *  when a reply is sent ahead of its turn.
+ * @param q - priority queue
+ * @param slot - queued slot index
+ * @param now - milliseconds timestamp
+ */
+void Prioq_Remove(PRIOQ *q, unsigned slot, uint32_t now)
+{
+    struct prioq_slot *s;
+    PRIOQ_STATS *stats;
+    uint32_t latency;
+
+    if (!q || (slot >= q->slot_count)) {
+        return;
+    }
+    s = &q->slots[slot];
+    prioq_unlink(q, slot);
+    latency = now - s->time;
+    stats = &q->stats[s->priority];
+    stats->sent++;
+    stats->latency_total += latency;
+    if (latency > stats->latency_max) {
+        stats->latency_max = latency;
+    }
+    s->next = q->free;
+    q->free = (uint16_t)slot;
+}
+
+/**
+ * @brief Number of queued PDU in all classes
+ * @param q - priority queue
+ * @return number of queued PDU
+ */
+unsigned Prioq_Count(PRIOQ const *q)
+{
+    return q ? q->count : 0;
+}
+
+/**
+ * @brief Determine if the queue is empty
+ * @param q - priority queue
+ * @return true if no PDU is queued
+ */
+bool Prioq_Empty(PRIOQ const *q)
+{
+    return (Prioq_Count(q) == 0);
+}
+
+/**
+ * @brief Counters of one priority class
+ * @param q - priority queue
+ * @param priority - BACNET_MESSAGE_PRIORITY
+ * @return pointer to the counters, or NULL
+ */
+const PRIOQ_STATS *Prioq_Stats(PRIOQ const *q, uint8_t priority)
+{
+    if (!q || (priority >= PRIOQ_CLASSES)) {
+        return NULL;
+    }
+
+    return &q->stats[priority];
+}
+
+/**
+ * @brief Reset the counters of every class. The current depth is kept,
+ *  and becomes the maximum depth.
+ * @param q - priority queue
+ */
+void Prioq_Stats_Reset(PRIOQ *q)
+{
+    uint16_t depth;
+    unsigned i;
+
+    if (!q) {
+        return;
+    }
+    for (i = 0; i < PRIOQ_CLASSES; i++) {
+        depth = q->stats[i].depth;
+        memset(&q->stats[i], 0, sizeof(PRIOQ_STATS));
+        q->stats[i].depth = depth;
+        q->stats[i].depth_max = depth;
+    }
+}
@@ -0,0 +1,121 @@
+/**
+ * @file
+ * @date October 2026
+ * @brief Transmit queue with one FIFO for each of the four BACnet
+ *  network priorities, served by strict priority with aging.
+ *
+ * @section LICENSE
+ *
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#ifndef BACNET_BASIC_SYS_PRIOQ_H
+#define BACNET_BASIC_SYS_PRIOQ_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "bacnet/bacnet_stack_exports.h"
+
+/* one class for each BACNET_MESSAGE_PRIORITY, NPDU control bits 1..0 */
+#define PRIOQ_CLASSES 4
+/* slot index used to mark the end of a list */
+#define PRIOQ_NONE UINT16_MAX
+
+/* one slot of the queue. The caller keeps the data of slot N
+   in element N of its own array. */
+struct prioq_slot {
+    uint16_t next;
+    uint16_t prev;
+    uint8_t priority;
+    /* milliseconds timestamp when the slot was queued */
+    uint32_t time;
+};
+
+/* counters kept for each priority class */
+typedef struct prioq_stats {
+    /* PDU queued, sent, and dropped or evicted */
+    uint32_t queued;
+    uint32_t sent;
+    uint32_t dropped;
+    /* current and maximum number of queued PDU */
+    uint16_t depth;
+    uint16_t depth_max;
+    /* milliseconds from queued to sent */
+    uint32_t latency_max;
+    uint64_t latency_total;
+} PRIOQ_STATS;
+
+typedef struct prioq {
+    struct prioq_slot *slots;
+    uint16_t slot_count;
+    /* oldest and newest queued slot of each class */
+    uint16_t head[PRIOQ_CLASSES];
+    uint16_t tail[PRIOQ_CLASSES];
+    uint16_t free;
+    uint16_t count;
+    /* milliseconds of waiting that count as one priority class,
+       or zero for strict priority */
+    uint32_t aging;
+    PRIOQ_STATS stats[PRIOQ_CLASSES];
+} PRIOQ;
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+    BACNET_STACK_EXPORT
+    bool Prioq_Init(PRIOQ * q,
+        struct prioq_slot *slots,
+        unsigned slot_count,
+        uint32_t aging);
+    BACNET_STACK_EXPORT
+    int Prioq_Reserve(PRIOQ * q,
+        uint8_t priority,
+        bool * evicted);
+    BACNET_STACK_EXPORT
+    void Prioq_Put(PRIOQ * q,
+        unsigned slot,
+        uint8_t priority,
+        uint32_t now);
+    BACNET_STACK_EXPORT
+    void Prioq_Release(PRIOQ * q,
+        unsigned slot);
+    BACNET_STACK_EXPORT
+    int Prioq_Peek(PRIOQ const *q,
+        uint32_t now);
+    BACNET_STACK_EXPORT
+    void Prioq_Remove(PRIOQ * q,
+        unsigned slot,
+        uint32_t now);
+    BACNET_STACK_EXPORT
+    unsigned Prioq_Count(PRIOQ const *q);
+    BACNET_STACK_EXPORT
+    bool Prioq_Empty(PRIOQ const *q);
+    BACNET_STACK_EXPORT
+    const PRIOQ_STATS *Prioq_Stats(PRIOQ const *q,
+        uint8_t priority);
+    BACNET_STACK_EXPORT
+    void Prioq_Stats_Reset(PRIOQ * q);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+#endif
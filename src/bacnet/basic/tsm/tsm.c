@@ -35,6 +35,8 @@
 #include <stdbool.h>
 #include <stdint.h>
 #include <stddef.h>
+#include <stdio.h>
+#include <string.h>
 #include "bacnet/bits.h"
 #include "bacnet/apdu.h"
 #include "bacnet/bacaddr.h"
@@ -48,9 +50,91 @@
 #include "bacnet/basic/binding/address.h"
 
 /** @file tsm.c  BACnet Transaction State Machine operations  */
-/* FIXME: modify basic service handlers to use TSM rather than this buffer! */
+/* Note: the basic service handlers use a transmit context from
+   the pool below, and the first one is this buffer.  It remains
+   for client requests and apps outside of the service handlers. */
 uint8_t Handler_Transmit_Buffer[MAX_PDU];
 
+/* pool of transmit contexts for building replies */
+static BACNET_TRANSMIT_CONTEXT
+    TSM_Transmit_Context[MAX_TSM_TRANSMIT_CONTEXTS];
+#if (MAX_TSM_TRANSMIT_CONTEXTS > 1)
+/* buffers of the contexts after the first one */
+static uint8_t TSM_Transmit_Buffer[MAX_TSM_TRANSMIT_CONTEXTS - 1][MAX_PDU];
+#endif
+
+/** Take a free transmit context from the pool.
+ *
+ * The pool itself is not locked: callers that build replies from
+ * several threads shall serialize acquire and release.
+ *
+ * @return pointer to an empty transmit context, or NULL if all
+ *  the contexts are in use.  The reply is then dropped, and the
+ *  client retries a confirmed request after its APDU timeout.
+ */
+BACNET_TRANSMIT_CONTEXT *tsm_transmit_context_acquire(void)
+{
+    BACNET_TRANSMIT_CONTEXT *context = NULL;
+    unsigned i = 0;
+
+    for (i = 0; i < MAX_TSM_TRANSMIT_CONTEXTS; i++) {
+        if (!TSM_Transmit_Context[i].in_use) {
+            context = &TSM_Transmit_Context[i];
+            if (!context->pdu) {
+#if (MAX_TSM_TRANSMIT_CONTEXTS > 1)
+                if (i > 0) {
+                    context->pdu = &TSM_Transmit_Buffer[i - 1][0];
+                } else
+#endif
+                {
+                    context->pdu = &Handler_Transmit_Buffer[0];
+                }
+            }
+            context->in_use = true;
+            context->pdu_len = 0;
+            break;
+        }
+    }
+#if PRINT_ENABLED
+    if (!context) {
+        fprintf(stderr, "TSM: no transmit context - reply dropped!\n");
+    }
+#endif
+
+    return context;
+}
+
+/** Give a transmit context back to the pool.
+ *
+ * @param context - context from tsm_transmit_context_acquire(),
+ *  or NULL which is ignored.
+ */
+void tsm_transmit_context_release(BACNET_TRANSMIT_CONTEXT *context)
+{
+    if (context) {
+        context->pdu_len = 0;
+        context->in_use = false;
+    }
+}
+
+/** Return the count of transmit contexts that are not in use.
+ *
+ * @return number of idle transmit contexts
+ */
+unsigned tsm_transmit_context_idle_count(void)
+{
+    unsigned count = 0;
+    unsigned i = 0;
+
+    for (i = 0; i < MAX_TSM_TRANSMIT_CONTEXTS; i++) {
+        if (!TSM_Transmit_Context[i].in_use) {
+            count++;
+        }
+    }
+
+    return count;
+}
+
 #if (MAX_TSM_TRANSACTIONS)
 /* Really only needed for segmented messages */
 /* and a little for sending confirmed messages */
@@ -61,16 +145,47 @@ uint8_t Handler_Transmit_Buffer[MAX_PDU];
 
 /* declare space for the TSM transactions, and set it up in the init. */
 /* table rules: an Invoke ID = 0 is an unused spot in the table */
-static BACNET_TSM_DATA TSM_List[MAX_TSM_TRANSACTIONS];
+/* The default context is used until another one is selected. */
+static BACNET_TSM_CONTEXT TSM_Default_Context = { { { 0 } }, 1, NULL };
+static BACNET_TSM_CONTEXT *TSM = &TSM_Default_Context;
 
-/* invoke ID for incrementing between subsequent calls. */
-static uint8_t Current_Invoke_ID = 1;
+/** Initialize a TSM context to an empty transaction table.
+ *
+ * @param context - the TSM context to initialize
+ */
+void tsm_context_init(BACNET_TSM_CONTEXT *context)
+{
+    if (context) {
+        memset(context, 0, sizeof(BACNET_TSM_CONTEXT));
+        context->Current_Invoke_ID = 1;
+    }
+}
 
-static tsm_timeout_function Timeout_Function;
+/** Select the TSM context used by the tsm_ functions.
+ *
+ * @param context - the TSM context to use, or NULL to use the default
+ */
+void tsm_context_set(BACNET_TSM_CONTEXT *context)
+{
+    if (context) {
+        TSM = context;
+    } else {
+        TSM = &TSM_Default_Context;
+    }
+}
+
+/** Get the TSM context used by the tsm_ functions.
+ *
+ * @return the current TSM context
+ */
+BACNET_TSM_CONTEXT *tsm_context(void)
+{
+    return TSM;
+}
 
 void tsm_set_timeout_handler(tsm_timeout_function pFunction)
 {
-    Timeout_Function = pFunction;
+    TSM->Timeout_Function = pFunction;
 }
 
 /** Find the given Invoke-Id in the list and
@@ -86,7 +201,7 @@ static uint8_t tsm_find_invokeID_index(uint8_t invokeID)
     unsigned i = 0; /* counter */
     uint8_t index = MAX_TSM_TRANSACTIONS; /* return value */
 
-    const BACNET_TSM_DATA *plist = TSM_List;
+    const BACNET_TSM_DATA *plist = TSM->List;
 
     for (i = 0; i < MAX_TSM_TRANSACTIONS; i++, plist++) {
         if (plist->InvokeID == invokeID) {
@@ -108,7 +223,7 @@ static uint8_t tsm_find_first_free_index(void)
     unsigned i = 0; /* counter */
     uint8_t index = MAX_TSM_TRANSACTIONS; /* return value */
 
-    const BACNET_TSM_DATA *plist = TSM_List;
+    const BACNET_TSM_DATA *plist = TSM->List;
 
     for (i = 0; i < MAX_TSM_TRANSACTIONS; i++, plist++) {
         if (plist->InvokeID == 0) {
@@ -129,7 +244,7 @@ bool tsm_transaction_available(void)
     bool status = false; /* return value */
     unsigned i = 0; /* counter */
 
-    const BACNET_TSM_DATA *plist = TSM_List;
+    const BACNET_TSM_DATA *plist = TSM->List;
 
     for (i = 0; i < MAX_TSM_TRANSACTIONS; i++, plist++) {
         if (plist->InvokeID == 0) {
@@ -151,7 +266,7 @@ uint8_t tsm_transaction_idle_count(void)
     uint8_t count = 0; /* return value */
     unsigned i = 0; /* counter */
 
-    const BACNET_TSM_DATA *plist = TSM_List;
+    const BACNET_TSM_DATA *plist = TSM->List;
 
     for (i = 0; i < MAX_TSM_TRANSACTIONS; i++, plist++) {
         if ((plist->InvokeID == 0) && (plist->state == TSM_STATE_IDLE)) {
@@ -173,7 +288,7 @@ void tsm_invokeID_set(uint8_t invokeID)
     if (invokeID == 0) {
         invokeID = 1;
     }
-    Current_Invoke_ID = invokeID;
+    TSM->Current_Invoke_ID = invokeID;
 }
 
 /** Gets the next free invokeID,
@@ -192,32 +307,32 @@ uint8_t tsm_next_free_invokeID(void)
     /* Is there even space available? */
     if (tsm_transaction_available()) {
         while (!found) {
-            index = tsm_find_invokeID_index(Current_Invoke_ID);
+            index = tsm_find_invokeID_index(TSM->Current_Invoke_ID);
             if (index == MAX_TSM_TRANSACTIONS) {
                 /* Not found, so this invokeID is not used */
                 found = true;
                 /* set this id into the table */
                 index = tsm_find_first_free_index();
                 if (index != MAX_TSM_TRANSACTIONS) {
-                    plist = &TSM_List[index];
-                    plist->InvokeID = invokeID = Current_Invoke_ID;
+                    plist = &TSM->List[index];
+                    plist->InvokeID = invokeID = TSM->Current_Invoke_ID;
                     plist->state = TSM_STATE_IDLE;
                     plist->RequestTimer = apdu_timeout();
                     /* update for the next call or check */
-                    Current_Invoke_ID++;
+                    TSM->Current_Invoke_ID++;
                     /* skip zero - we treat that internally as invalid or no
                      * free */
-                    if (Current_Invoke_ID == 0) {
-                        Current_Invoke_ID = 1;
+                    if (TSM->Current_Invoke_ID == 0) {
+                        TSM->Current_Invoke_ID = 1;
                     }
                 }
             } else {
                 /* found! This invokeID is already used */
                 /* try next one */
-                Current_Invoke_ID++;
+                TSM->Current_Invoke_ID++;
                 /* skip zero - we treat that internally as invalid or no free */
-                if (Current_Invoke_ID == 0) {
-                    Current_Invoke_ID = 1;
+                if (TSM->Current_Invoke_ID == 0) {
+                    TSM->Current_Invoke_ID = 1;
                 }
             }
         }
@@ -248,7 +363,7 @@ void tsm_set_confirmed_unsegmented_transaction(uint8_t invokeID,
     if (invokeID && ndpu_data && apdu && (apdu_len > 0)) {
         index = tsm_find_invokeID_index(invokeID);
         if (index < MAX_TSM_TRANSACTIONS) {
-            plist = &TSM_List[index];
+            plist = &TSM->List[index];
             /* SendConfirmedUnsegmented */
             plist->state = TSM_STATE_AWAIT_CONFIRMATION;
             plist->RetryCount = 0;
@@ -297,7 +412,7 @@ bool tsm_get_transaction_pdu(uint8_t invokeID,
             /* FIXME: we may want to free the transaction so it doesn't timeout
              */
             /* retrieve the transaction */
-            plist = &TSM_List[index];
+            plist = &TSM->List[index];
             *apdu_len = (uint16_t)plist->apdu_len;
             if (*apdu_len > MAX_PDU) {
                 *apdu_len = MAX_PDU;
@@ -324,7 +439,7 @@ void tsm_timer_milliseconds(uint16_t milliseconds)
 {
     unsigned i = 0; /* counter */
 
-    BACNET_TSM_DATA *plist = &TSM_List[0];
+    BACNET_TSM_DATA *plist = &TSM->List[0];
 
     for (i = 0; i < MAX_TSM_TRANSACTIONS; i++, plist++) {
         if (plist->state == TSM_STATE_AWAIT_CONFIRMATION) {
@@ -346,8 +461,8 @@ void tsm_timer_milliseconds(uint16_t milliseconds)
                        IDLE and a valid invoke id */
                     plist->state = TSM_STATE_IDLE;
                     if (plist->InvokeID != 0) {
-                        if (Timeout_Function) {
-                            Timeout_Function(plist->InvokeID);
+                        if (TSM->Timeout_Function) {
+                            TSM->Timeout_Function(plist->InvokeID);
                         }
                     }
                 }
@@ -367,7 +482,7 @@ void tsm_free_invoke_id(uint8_t invokeID)
 
     index = tsm_find_invokeID_index(invokeID);
     if (index < MAX_TSM_TRANSACTIONS) {
-        plist = &TSM_List[index];
+        plist = &TSM->List[index];
         plist->state = TSM_STATE_IDLE;
         plist->InvokeID = 0;
     }
@@ -407,7 +522,7 @@ bool tsm_invoke_id_failed(uint8_t invokeID)
     if (index < MAX_TSM_TRANSACTIONS) {
         /* a valid invoke ID and the state is IDLE is a
            message that failed to confirm */
-        if (TSM_List[index].state == TSM_STATE_IDLE) {
+        if (TSM->List[index].state == TSM_STATE_IDLE) {
             status = true;
         }
     }
@@ -39,10 +39,40 @@
 extern "C" {
 #endif /* __cplusplus */
 
-    /* FIXME: modify basic service handlers to use TSM rather than this buffer! */
+    /* Note: the basic service handlers use a transmit context from
+       the pool below, and the first one is this buffer.  It remains
+       for client requests and apps outside of the service handlers. */
     BACNET_STACK_EXPORT extern 
     uint8_t Handler_Transmit_Buffer[MAX_PDU];
 
+/* A transmit context holds one outgoing PDU while a service handler
+   encodes it.  Contexts are taken from a fixed pool with
+   tsm_transmit_context_acquire() and given back with
+   tsm_transmit_context_release() once datalink_send_pdu() returns.
+   The first context of the pool uses Handler_Transmit_Buffer, and each
+   of the other MAX_TSM_TRANSMIT_CONTEXTS - 1 contexts has its own
+   buffer of MAX_PDU bytes.
+   The pool is not thread-safe: it is not locked, so a threaded
+   application shall serialize acquire and release itself. */
+typedef struct BACnet_TSM_Transmit_Context {
+    /* the encoded NPDU and APDU, MAX_PDU bytes */
+    uint8_t *pdu;
+    /* number of valid bytes in pdu */
+    uint16_t pdu_len;
+    /* true while owned by a handler */
+    bool in_use;
+} BACNET_TRANSMIT_CONTEXT;
+
+    BACNET_STACK_EXPORT
+    BACNET_TRANSMIT_CONTEXT *tsm_transmit_context_acquire(
+        void);
+    BACNET_STACK_EXPORT
+    void tsm_transmit_context_release(
+        BACNET_TRANSMIT_CONTEXT * context);
+    BACNET_STACK_EXPORT
+    unsigned tsm_transmit_context_idle_count(
+        void);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
@@ -100,11 +130,30 @@ typedef void (
     *tsm_timeout_function) (
     uint8_t invoke_id);
 
+/* All the transactions of one BACnet device. Several devices in one
+   process each use their own context, selected with tsm_context_set() */
+typedef struct BACnet_TSM_Context {
+    BACNET_TSM_DATA List[MAX_TSM_TRANSACTIONS];
+    /* invoke ID for incrementing between subsequent calls. */
+    uint8_t Current_Invoke_ID;
+    tsm_timeout_function Timeout_Function;
+} BACNET_TSM_CONTEXT;
+
 
 #ifdef __cplusplus
 extern "C" {
 #endif /* __cplusplus */
 
+    BACNET_STACK_EXPORT
+    void tsm_context_init(
+        BACNET_TSM_CONTEXT * context);
+    BACNET_STACK_EXPORT
+    void tsm_context_set(
+        BACNET_TSM_CONTEXT * context);
+    BACNET_STACK_EXPORT
+    BACNET_TSM_CONTEXT *tsm_context(
+        void);
+
     BACNET_STACK_EXPORT
     void tsm_set_timeout_handler(
         tsm_timeout_function pFunction);
@@ -68,6 +68,15 @@
 #define MAX_NUM_DEVICES 1       /* Just the one normal BACnet Device Object */
 #endif
 #endif
+/* Routed Devices beyond MAX_NUM_DEVICES are allocated as they are added,
+   up to this many Devices. Set it to MAX_NUM_DEVICES to avoid malloc() */
+#if !defined(MAX_ROUTED_DEVICES)
+#ifdef BAC_ROUTING
+#define MAX_ROUTED_DEVICES 4096
+#else
+#define MAX_ROUTED_DEVICES MAX_NUM_DEVICES
+#endif
+#endif
 
 /* Define your Vendor Identifier assigned by ASHRAE */
 #if !defined(BACNET_VENDOR_ID)
@@ -114,6 +123,14 @@
 #if !defined(MAX_TSM_TRANSACTIONS)
 #define MAX_TSM_TRANSACTIONS 255
 #endif
+/* Service handlers encode their replies into a transmit context that */
+/* is taken from a small pool and given back after the PDU is sent. */
+/* Configure from 1..N for the number of replies that may be built */
+/* at the same time, i.e. by concurrent service handlers. The first */
+/* context uses Handler_Transmit_Buffer, each other one adds MAX_PDU. */
+#if !defined(MAX_TSM_TRANSMIT_CONTEXTS)
+#define MAX_TSM_TRANSMIT_CONTEXTS 1
+#endif
 /* The address cache is used for binding to BACnet devices */
 /* The number of entries corresponds to the number of */
 /* devices that might respond to an I-Am on the network. */
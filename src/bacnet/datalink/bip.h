@@ -71,6 +71,11 @@ extern "C" {
     /* implement in ports module */
     BACNET_STACK_EXPORT
     int bip_send_mpdu(BACNET_IP_ADDRESS *dest, uint8_t *mtu, uint16_t mtu_len);
+    BACNET_STACK_EXPORT
+    int bip_send_mpdu_list(BACNET_IP_ADDRESS *dest_list,
+        unsigned dest_count,
+        uint8_t *mtu,
+        uint16_t mtu_len);
 
     BACNET_STACK_EXPORT
     uint16_t bip_receive(BACNET_ADDRESS *src,
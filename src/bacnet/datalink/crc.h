@@ -28,6 +28,19 @@
 #include <stdint.h>
 #include "bacnet/bacnet_stack_exports.h"
 
+/* The buffer CRC functions use slice-by-8 lookup tables (4K octets for
+   the data CRC, 8K octets for the CRC-32K) to process eight octets per
+   step.  Small targets can define CRC_USE_SLICE_BY_8=0 to use the
+   per-octet functions instead. */
+#ifndef CRC_USE_SLICE_BY_8
+#if defined(__linux__) || defined(_WIN32) || defined(__APPLE__) || \
+    defined(__FreeBSD__)
+#define CRC_USE_SLICE_BY_8 1
+#else
+#define CRC_USE_SLICE_BY_8 0
+#endif
+#endif
+
 #ifdef __cplusplus
 extern "C" {
 #endif /* __cplusplus */
@@ -40,6 +53,11 @@ extern "C" {
     uint16_t CRC_Calc_Data(
         uint8_t dataValue,
         uint16_t crcValue);
+    BACNET_STACK_EXPORT
+    uint16_t CRC_Calc_Data_Buffer(
+        const uint8_t *data,
+        size_t length,
+        uint16_t crcValue);
 
 #ifdef __cplusplus
 }
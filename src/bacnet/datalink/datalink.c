@@ -44,39 +44,73 @@
 #include "bacnet/basic/bbmd6/h_bbmd6.h"
 #include "bacnet/datalink/arcnet.h"
 #include "bacnet/datalink/dlmstp.h"
+#include <string.h>
 #include <strings.h> /* for strcasecmp() */
 
-static enum {
+#if defined(BAC_ROUTING)
+/* datalink.h maps it to the current routed Device for the gateway */
+#undef datalink_get_my_address
+#endif
+
+enum datalink_transport {
     DATALINK_NONE = 0,
     DATALINK_ARCNET,
     DATALINK_ETHERNET,
     DATALINK_BIP,
     DATALINK_BIP6,
     DATALINK_MSTP
-} Datalink_Transport;
-
-void datalink_set(char *datalink_string)
+};
+
+static enum datalink_transport Datalink_Transport;
+
+/* a datalink port that is active together with the other ports */
+struct datalink_port {
+    enum datalink_transport transport;
+    uint16_t net;
+};
+
+/* a remote network and the router on a port that reaches it */
+struct datalink_route {
+    uint16_t net;
+    uint8_t port;
+    uint8_t mac_len;
+    uint8_t mac[MAX_MAC_LEN];
+};
+
+static struct datalink_port Datalink_Ports[DATALINK_PORTS_MAX];
+static unsigned Datalink_Port_Count;
+/* the port that is polled first by the next receive */
+static unsigned Datalink_Port_Next;
+static struct datalink_route Datalink_Routes[DATALINK_ROUTES_MAX];
+static unsigned Datalink_Route_Count;
+/* NPDU of an application PDU sent to a directly connected network */
+static uint8_t Datalink_Tx_Buffer[MAX_MPDU];
+
+static enum datalink_transport datalink_transport_from_string(
+    char *datalink_string)
 {
-    if (strcasecmp("bip", datalink_string) == 0) {
-        Datalink_Transport = DATALINK_BIP;
+    if (!datalink_string) {
+        return DATALINK_NONE;
+    } else if (strcasecmp("bip", datalink_string) == 0) {
+        return DATALINK_BIP;
     } else if (strcasecmp("bip6", datalink_string) == 0) {
-        Datalink_Transport = DATALINK_BIP6;
+        return DATALINK_BIP6;
     } else if (strcasecmp("ethernet", datalink_string) == 0) {
-        Datalink_Transport = DATALINK_ETHERNET;
+        return DATALINK_ETHERNET;
     } else if (strcasecmp("arcnet", datalink_string) == 0) {
-        Datalink_Transport = DATALINK_ARCNET;
+        return DATALINK_ARCNET;
     } else if (strcasecmp("mstp", datalink_string) == 0) {
-        Datalink_Transport = DATALINK_MSTP;
-    } else if (strcasecmp("none", datalink_string) == 0) {
-        Datalink_Transport = DATALINK_NONE;
+        return DATALINK_MSTP;
     }
+
+    return DATALINK_NONE;
 }
 
-bool datalink_init(char *ifname)
+static bool transport_init(enum datalink_transport transport, char *ifname)
 {
     bool status = false;
 
-    switch (Datalink_Transport) {
+    switch (transport) {
         case DATALINK_NONE:
             status = true;
             break;
@@ -102,14 +136,15 @@ bool datalink_init(char *ifname)
     return status;
 }
 
-int datalink_send_pdu(BACNET_ADDRESS *dest,
+static int transport_send_pdu(enum datalink_transport transport,
+    BACNET_ADDRESS *dest,
     BACNET_NPDU_DATA *npdu_data,
     uint8_t *pdu,
     unsigned pdu_len)
 {
     int bytes = 0;
 
-    switch (Datalink_Transport) {
+    switch (transport) {
         case DATALINK_NONE:
             bytes = pdu_len;
             break;
@@ -135,12 +170,15 @@ int datalink_send_pdu(BACNET_ADDRESS *dest,
     return bytes;
 }
 
-uint16_t datalink_receive(
-    BACNET_ADDRESS *src, uint8_t *pdu, uint16_t max_pdu, unsigned timeout)
+static uint16_t transport_receive(enum datalink_transport transport,
+    BACNET_ADDRESS *src,
+    uint8_t *pdu,
+    uint16_t max_pdu,
+    unsigned timeout)
 {
     uint16_t bytes = 0;
 
-    switch (Datalink_Transport) {
+    switch (transport) {
         case DATALINK_NONE:
             break;
         case DATALINK_ARCNET:
@@ -165,9 +203,9 @@ uint16_t datalink_receive(
     return bytes;
 }
 
-void datalink_cleanup(void)
+static void transport_cleanup(enum datalink_transport transport)
 {
-    switch (Datalink_Transport) {
+    switch (transport) {
         case DATALINK_NONE:
             break;
         case DATALINK_ARCNET:
@@ -190,9 +228,10 @@ void datalink_cleanup(void)
     }
 }
 
-void datalink_get_broadcast_address(BACNET_ADDRESS *dest)
+static void transport_get_broadcast_address(
+    enum datalink_transport transport, BACNET_ADDRESS *dest)
 {
-    switch (Datalink_Transport) {
+    switch (transport) {
         case DATALINK_NONE:
             break;
         case DATALINK_ARCNET:
@@ -215,9 +254,10 @@ void datalink_get_broadcast_address(BACNET_ADDRESS *dest)
     }
 }
 
-void datalink_get_my_address(BACNET_ADDRESS *my_address)
+static void transport_get_my_address(
+    enum datalink_transport transport, BACNET_ADDRESS *my_address)
 {
-    switch (Datalink_Transport) {
+    switch (transport) {
         case DATALINK_NONE:
             break;
         case DATALINK_ARCNET:
@@ -240,52 +280,549 @@ void datalink_get_my_address(BACNET_ADDRESS *my_address)
     }
 }
 
-void datalink_set_interface(char *ifname)
+static void transport_maintenance_timer(
+    enum datalink_transport transport, uint16_t seconds)
 {
-    switch (Datalink_Transport) {
+    switch (transport) {
         case DATALINK_NONE:
-            (void)ifname;
             break;
         case DATALINK_ARCNET:
-            (void)ifname;
             break;
         case DATALINK_ETHERNET:
-            (void)ifname;
             break;
         case DATALINK_BIP:
-            (void)ifname;
+            bvlc_maintenance_timer(seconds);
             break;
         case DATALINK_BIP6:
-            (void)ifname;
+            bvlc6_maintenance_timer(seconds);
             break;
         case DATALINK_MSTP:
-            (void)ifname;
             break;
         default:
             break;
     }
 }
 
+void datalink_set(char *datalink_string)
+{
+    enum datalink_transport transport;
+
+    transport = datalink_transport_from_string(datalink_string);
+    if (transport != DATALINK_NONE) {
+        Datalink_Transport = transport;
+    } else if (datalink_string && (strcasecmp("none", datalink_string) == 0)) {
+        Datalink_Transport = DATALINK_NONE;
+    }
+}
+
+bool datalink_init(char *ifname)
+{
+    return transport_init(Datalink_Transport, ifname);
+}
+
+/**
+ * Send a PDU of the application layer.  When datalink ports are added,
+ * a global broadcast goes out every port, and a PDU for a directly
+ * connected network goes out its port without the DNET, since that
+ * port is a router port of this device.  A PDU for a remote network
+ * goes to the router learned on a port, and any other PDU goes out
+ * the first port.
+ * @ingroup DLTemplates
+ */
+int datalink_send_pdu(BACNET_ADDRESS *dest,
+    BACNET_NPDU_DATA *npdu_data,
+    uint8_t *pdu,
+    unsigned pdu_len)
+{
+    BACNET_ADDRESS npdu_dest = { 0 };
+    BACNET_ADDRESS npdu_src = { 0 };
+    BACNET_NPDU_DATA npdu_local = { 0 };
+    BACNET_ADDRESS local_dest = { 0 };
+    int npdu_len, apdu_offset;
+    int bytes = 0;
+    int port;
+    unsigned i;
+
+    if (Datalink_Port_Count == 0) {
+        return transport_send_pdu(
+            Datalink_Transport, dest, npdu_data, pdu, pdu_len);
+    }
+    if (dest->net == BACNET_BROADCAST_NETWORK) {
+        for (i = 0; i < Datalink_Port_Count; i++) {
+            bytes = datalink_port_send_pdu(i, dest, npdu_data, pdu, pdu_len);
+        }
+        return bytes;
+    }
+    /* a route sets the MAC of the next router */
+    local_dest = *dest;
+    port = datalink_port_route_find(dest->net, &local_dest);
+    if ((port == DATALINK_PORT_NONE) || (dest->net == 0)) {
+        return datalink_port_send_pdu(0, dest, npdu_data, pdu, pdu_len);
+    }
+    if (Datalink_Ports[port].net != dest->net) {
+        return datalink_port_send_pdu(
+            (unsigned)port, &local_dest, npdu_data, pdu, pdu_len);
+    }
+    /* remove the DNET and DADR that only a router would use */
+    apdu_offset = bacnet_npdu_decode(
+        pdu, (uint16_t)pdu_len, &npdu_dest, &npdu_src, &npdu_local);
+    if ((apdu_offset <= 0) || ((unsigned)apdu_offset > pdu_len)) {
+        return 0;
+    }
+    npdu_len = npdu_encode_pdu(&Datalink_Tx_Buffer[0], NULL,
+        npdu_src.net ? &npdu_src : NULL, &npdu_local);
+    if ((npdu_len + pdu_len - apdu_offset) > sizeof(Datalink_Tx_Buffer)) {
+        return 0;
+    }
+    memmove(&Datalink_Tx_Buffer[npdu_len], &pdu[apdu_offset],
+        pdu_len - apdu_offset);
+    memset(&local_dest, 0, sizeof(local_dest));
+    if (dest->len == 0) {
+        datalink_port_get_broadcast_address((unsigned)port, &local_dest);
+    } else {
+        local_dest.mac_len = dest->len;
+        memcpy(&local_dest.mac[0], &dest->adr[0], MAX_MAC_LEN);
+    }
+    bytes = datalink_port_send_pdu((unsigned)port, &local_dest, &npdu_local,
+        &Datalink_Tx_Buffer[0], npdu_len + pdu_len - apdu_offset);
+
+    return bytes;
+}
+
+/**
+ * Give a PDU received on a datalink port the source that a router would
+ * give it.  A PDU from a node on a port other than the first one gets
+ * the network number of the port as SNET and the MAC of the node as
+ * SADR, so that npdu_handler() passes a source that datalink_send_pdu()
+ * sends the reply back to, out the same port.  A PDU that already has
+ * an SNET came through a router on the port, which is learned as the
+ * route to that network.
+ *
+ * @param port - port number the PDU was received on
+ * @param src - source MAC address of the PDU
+ * @param pdu - the received PDU, rewritten in place
+ * @param pdu_len - number of bytes in the PDU
+ * @param max_pdu - size of the PDU buffer
+ * @return number of bytes in the PDU, or 0 if it no longer fits
+ */
+static uint16_t datalink_port_source_set(unsigned port,
+    BACNET_ADDRESS *src,
+    uint8_t *pdu,
+    uint16_t pdu_len,
+    uint16_t max_pdu)
+{
+    BACNET_ADDRESS npdu_dest = { 0 };
+    BACNET_ADDRESS npdu_src = { 0 };
+    BACNET_NPDU_DATA npdu_data = { 0 };
+    uint8_t npdu[MAX_NPDU] = { 0 };
+    int npdu_len, apdu_offset;
+    uint16_t apdu_len;
+
+    if ((pdu_len == 0) || (pdu[0] != BACNET_PROTOCOL_VERSION)) {
+        return pdu_len;
+    }
+    apdu_offset =
+        bacnet_npdu_decode(pdu, pdu_len, &npdu_dest, &npdu_src, &npdu_data);
+    if ((apdu_offset <= 0) || (apdu_offset > pdu_len)) {
+        return pdu_len;
+    }
+    if (npdu_src.net) {
+        if (npdu_src.net != Datalink_Ports[port].net) {
+            datalink_port_route_add(port, npdu_src.net, src);
+        }
+        return pdu_len;
+    }
+    if ((port == 0) || (src->mac_len == 0) || (src->mac_len > MAX_MAC_LEN)) {
+        return pdu_len;
+    }
+    npdu_src.net = Datalink_Ports[port].net;
+    npdu_src.len = src->mac_len;
+    memcpy(&npdu_src.adr[0], &src->mac[0], src->mac_len);
+    npdu_len = npdu_encode_pdu(&npdu[0], npdu_dest.net ? &npdu_dest : NULL,
+        &npdu_src, &npdu_data);
+    apdu_len = pdu_len - (uint16_t)apdu_offset;
+    if ((npdu_len + apdu_len) > max_pdu) {
+        return 0;
+    }
+    memmove(&pdu[npdu_len], &pdu[apdu_offset], apdu_len);
+    memcpy(&pdu[0], &npdu[0], (size_t)npdu_len);
+
+    return (uint16_t)(npdu_len + apdu_len);
+}
+
+/**
+ * Receive a PDU for the application layer.  When datalink ports are
+ * added, the PDU comes from any of the ports, and a PDU from a node on
+ * a port other than the first one has the SNET and SADR of that node,
+ * so that the reply goes out the same port.
+ * @ingroup DLTemplates
+ */
+uint16_t datalink_receive(
+    BACNET_ADDRESS *src, uint8_t *pdu, uint16_t max_pdu, unsigned timeout)
+{
+    unsigned port = 0;
+    uint16_t pdu_len;
+
+    if (Datalink_Port_Count) {
+        pdu_len = datalink_port_receive(&port, src, pdu, max_pdu, timeout);
+        if (pdu_len) {
+            pdu_len =
+                datalink_port_source_set(port, src, pdu, pdu_len, max_pdu);
+        }
+        return pdu_len;
+    }
+
+    return transport_receive(Datalink_Transport, src, pdu, max_pdu, timeout);
+}
+
+void datalink_cleanup(void)
+{
+    unsigned i;
+
+    if (Datalink_Port_Count == 0) {
+        transport_cleanup(Datalink_Transport);
+    }
+    for (i = 0; i < Datalink_Port_Count; i++) {
+        transport_cleanup(Datalink_Ports[i].transport);
+    }
+    Datalink_Port_Count = 0;
+    Datalink_Route_Count = 0;
+}
+
+void datalink_get_broadcast_address(BACNET_ADDRESS *dest)
+{
+    if (Datalink_Port_Count) {
+        datalink_port_get_broadcast_address(0, dest);
+    } else {
+        transport_get_broadcast_address(Datalink_Transport, dest);
+    }
+}
+
+void datalink_get_my_address(BACNET_ADDRESS *my_address)
+{
+    if (Datalink_Port_Count) {
+        datalink_port_get_my_address(0, my_address);
+    } else {
+        transport_get_my_address(Datalink_Transport, my_address);
+    }
+}
+
+void datalink_set_interface(char *ifname)
+{
+    (void)ifname;
+}
+
 void datalink_maintenance_timer(uint16_t seconds)
 {
-    switch (Datalink_Transport) {
-        case DATALINK_NONE:
-            break;
-        case DATALINK_ARCNET:
-            break;
-        case DATALINK_ETHERNET:
-            break;
-        case DATALINK_BIP:
-            bvlc_maintenance_timer(seconds);
-            break;
-        case DATALINK_BIP6:
-            bvlc6_maintenance_timer(seconds);
-            break;
-        case DATALINK_MSTP:
-            break;
-        default:
+    unsigned i;
+
+    if (Datalink_Port_Count == 0) {
+        transport_maintenance_timer(Datalink_Transport, seconds);
+    }
+    for (i = 0; i < Datalink_Port_Count; i++) {
+        transport_maintenance_timer(Datalink_Ports[i].transport, seconds);
+    }
+}
+
+/**
+ * Initialize a datalink and add it as a port that is active together
+ * with the ports added before it.  The port number is also the index of
+ * its Network Port object.  Each datalink type can be added once.
+ * @ingroup DLTemplates
+ *
+ * @param datalink_string - bip, bip6, mstp, ethernet or arcnet
+ * @param ifname - interface of the datalink, or NULL for its default
+ * @param net - network number of the directly connected network, 1..65534
+ * @return the port number, or DATALINK_PORT_NONE if it was not added
+ */
+int datalink_port_add(char *datalink_string, char *ifname, uint16_t net)
+{
+    enum datalink_transport transport;
+    unsigned i;
+
+    transport = datalink_transport_from_string(datalink_string);
+    if ((transport == DATALINK_NONE) ||
+        (Datalink_Port_Count >= DATALINK_PORTS_MAX) || (net == 0) ||
+        (net == BACNET_BROADCAST_NETWORK)) {
+        return DATALINK_PORT_NONE;
+    }
+    for (i = 0; i < Datalink_Port_Count; i++) {
+        if ((Datalink_Ports[i].transport == transport) ||
+            (Datalink_Ports[i].net == net)) {
+            return DATALINK_PORT_NONE;
+        }
+    }
+    if (!transport_init(transport, ifname)) {
+        return DATALINK_PORT_NONE;
+    }
+    Datalink_Ports[Datalink_Port_Count].transport = transport;
+    Datalink_Ports[Datalink_Port_Count].net = net;
+    Datalink_Port_Count++;
+
+    return (int)(Datalink_Port_Count - 1);
+}
+
+/**
+ * @return the number of datalink ports that were added
+ */
+unsigned datalink_port_count(void)
+{
+    return Datalink_Port_Count;
+}
+
+/**
+ * @param port - port number
+ * @return the network number of the directly connected network, or 0
+ */
+uint16_t datalink_port_network(unsigned port)
+{
+    if (port < Datalink_Port_Count) {
+        return Datalink_Ports[port].net;
+    }
+
+    return 0;
+}
+
+/**
+ * @param port - port number
+ * @return the Network_Type of the Network Port object of the port
+ */
+BACNET_PORT_TYPE datalink_port_type(unsigned port)
+{
+    BACNET_PORT_TYPE type = PORT_TYPE_NON_BACNET;
+
+    if (port < Datalink_Port_Count) {
+        switch (Datalink_Ports[port].transport) {
+            case DATALINK_ARCNET:
+                type = PORT_TYPE_ARCNET;
+                break;
+            case DATALINK_ETHERNET:
+                type = PORT_TYPE_ETHERNET;
+                break;
+            case DATALINK_BIP:
+                type = PORT_TYPE_BIP;
+                break;
+            case DATALINK_BIP6:
+                type = PORT_TYPE_BIP6;
+                break;
+            case DATALINK_MSTP:
+                type = PORT_TYPE_MSTP;
+                break;
+            default:
+                break;
+        }
+    }
+
+    return type;
+}
+
+/**
+ * Receive a PDU from any datalink port.  The ports are polled in turn
+ * from the one after the port of the last PDU, so that a busy port does
+ * not starve the others.  If no port has a PDU, the timeout is shared
+ * between the ports while waiting for one.
+ * @ingroup DLTemplates
+ *
+ * @param port - filled with the port number of the PDU, if not NULL
+ * @param src - filled with the source MAC address of the PDU
+ * @param pdu - buffer for the PDU
+ * @param max_pdu - size of the buffer
+ * @param timeout - milliseconds to wait for a PDU
+ * @return number of bytes in the PDU, or 0 if none was received
+ */
+uint16_t datalink_port_receive(unsigned *port,
+    BACNET_ADDRESS *src,
+    uint8_t *pdu,
+    uint16_t max_pdu,
+    unsigned timeout)
+{
+    uint16_t bytes = 0;
+    unsigned wait = 0;
+    unsigned pass, i, index;
+
+    if (Datalink_Port_Count == 0) {
+        return 0;
+    }
+    for (pass = 0; pass < 2; pass++) {
+        for (i = 0; i < Datalink_Port_Count; i++) {
+            index = (Datalink_Port_Next + i) % Datalink_Port_Count;
+            bytes = transport_receive(
+                Datalink_Ports[index].transport, src, pdu, max_pdu, wait);
+            if (bytes) {
+                Datalink_Port_Next = (index + 1) % Datalink_Port_Count;
+                if (port) {
+                    *port = index;
+                }
+                return bytes;
+            }
+        }
+        if (timeout == 0) {
+            break;
+        }
+        wait = timeout / Datalink_Port_Count;
+        if (wait == 0) {
+            wait = 1;
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * Send a PDU out one datalink port, as it is.  A global broadcast is
+ * sent to the broadcast address of the port.
+ * @ingroup DLTemplates
+ *
+ * @return number of bytes sent, or 0 if the port does not exist
+ */
+int datalink_port_send_pdu(unsigned port,
+    BACNET_ADDRESS *dest,
+    BACNET_NPDU_DATA *npdu_data,
+    uint8_t *pdu,
+    unsigned pdu_len)
+{
+    BACNET_ADDRESS broadcast = { 0 };
+
+    if (port >= Datalink_Port_Count) {
+        return 0;
+    }
+    if (dest->net == BACNET_BROADCAST_NETWORK) {
+        transport_get_broadcast_address(
+            Datalink_Ports[port].transport, &broadcast);
+        dest = &broadcast;
+    }
+
+    return transport_send_pdu(
+        Datalink_Ports[port].transport, dest, npdu_data, pdu, pdu_len);
+}
+
+/**
+ * Get the broadcast MAC address of a datalink port.  Until ports are
+ * added, port 0 is the datalink chosen with datalink_set().
+ */
+void datalink_port_get_broadcast_address(unsigned port, BACNET_ADDRESS *dest)
+{
+    if (port < Datalink_Port_Count) {
+        transport_get_broadcast_address(Datalink_Ports[port].transport, dest);
+    } else if ((port == 0) && (Datalink_Port_Count == 0)) {
+        transport_get_broadcast_address(Datalink_Transport, dest);
+    }
+}
+
+/**
+ * Get the MAC address of this device on a datalink port.  Until ports
+ * are added, port 0 is the datalink chosen with datalink_set().
+ */
+void datalink_port_get_my_address(unsigned port, BACNET_ADDRESS *my_address)
+{
+    if (port < Datalink_Port_Count) {
+        transport_get_my_address(Datalink_Ports[port].transport, my_address);
+    } else if ((port == 0) && (Datalink_Port_Count == 0)) {
+        transport_get_my_address(Datalink_Transport, my_address);
+    }
+}
+
+/**
+ * Add or update the router on a port that reaches a remote network.
+ * The directly connected networks of the ports are not added.
+ *
+ * @param port - port number where the router was heard
+ * @param net - remote network number
+ * @param router - address with the MAC of the router on the port
+ */
+void datalink_port_route_add(
+    unsigned port, uint16_t net, BACNET_ADDRESS *router)
+{
+    struct datalink_route *route = NULL;
+    unsigned i;
+
+    if ((port >= Datalink_Port_Count) || (net == 0) ||
+        (net == BACNET_BROADCAST_NETWORK) || !router ||
+        (router->mac_len > MAX_MAC_LEN)) {
+        return;
+    }
+    for (i = 0; i < Datalink_Port_Count; i++) {
+        if (Datalink_Ports[i].net == net) {
+            return;
+        }
+    }
+    for (i = 0; i < Datalink_Route_Count; i++) {
+        if (Datalink_Routes[i].net == net) {
+            route = &Datalink_Routes[i];
             break;
+        }
     }
+    if (!route) {
+        if (Datalink_Route_Count >= DATALINK_ROUTES_MAX) {
+            return;
+        }
+        route = &Datalink_Routes[Datalink_Route_Count];
+        Datalink_Route_Count++;
+    }
+    route->net = net;
+    route->port = (uint8_t)port;
+    route->mac_len = router->mac_len;
+    memcpy(&route->mac[0], &router->mac[0], router->mac_len);
+}
+
+/**
+ * Find the port that reaches a network.
+ *
+ * @param net - network number
+ * @param router - if not NULL, and the network is reached through
+ *  a router, its MAC address is copied into the MAC of this address
+ * @return the port number, or DATALINK_PORT_NONE if the network is unknown
+ */
+int datalink_port_route_find(uint16_t net, BACNET_ADDRESS *router)
+{
+    unsigned i;
+
+    for (i = 0; i < Datalink_Port_Count; i++) {
+        if (Datalink_Ports[i].net == net) {
+            return (int)i;
+        }
+    }
+    for (i = 0; i < Datalink_Route_Count; i++) {
+        if (Datalink_Routes[i].net == net) {
+            if (router) {
+                router->mac_len = Datalink_Routes[i].mac_len;
+                memcpy(&router->mac[0], &Datalink_Routes[i].mac[0],
+                    Datalink_Routes[i].mac_len);
+            }
+            return (int)Datalink_Routes[i].port;
+        }
+    }
+
+    return DATALINK_PORT_NONE;
+}
+
+/**
+ * List the networks that are reached through the ports other than one,
+ * as announced by I-Am-Router-To-Network on that port.
+ *
+ * @param port - port number to leave out
+ * @param net_list - filled with the network numbers
+ * @param net_list_size - number of entries in net_list
+ * @return the number of network numbers in the list
+ */
+unsigned datalink_port_route_list(
+    unsigned port, uint16_t *net_list, unsigned net_list_size)
+{
+    unsigned count = 0;
+    unsigned i;
+
+    for (i = 0; (i < Datalink_Port_Count) && (count < net_list_size); i++) {
+        if (i != port) {
+            net_list[count++] = Datalink_Ports[i].net;
+        }
+    }
+    for (i = 0; (i < Datalink_Route_Count) && (count < net_list_size); i++) {
+        if (Datalink_Routes[i].port != port) {
+            net_list[count++] = Datalink_Routes[i].net;
+        }
+    }
+
+    return count;
 }
 #endif
 
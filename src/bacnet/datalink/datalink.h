@@ -149,6 +149,87 @@ extern "C" {
     BACNET_STACK_EXPORT
     void datalink_maintenance_timer(uint16_t seconds);
 
+#if defined(BACDL_ALL)
+/* datalink ports that are active together, at most one of each
+   datalink type since each datalink driver is a single instance */
+#ifndef DATALINK_PORTS_MAX
+#define DATALINK_PORTS_MAX 4
+#endif
+/* remote networks learned from routers on the ports */
+#ifndef DATALINK_ROUTES_MAX
+#define DATALINK_ROUTES_MAX 32
+#endif
+#define DATALINK_PORT_NONE (-1)
+
+    BACNET_STACK_EXPORT
+    int datalink_port_add(
+        char *datalink_string,
+        char *ifname,
+        uint16_t net);
+
+    BACNET_STACK_EXPORT
+    unsigned datalink_port_count(
+        void);
+
+    BACNET_STACK_EXPORT
+    uint16_t datalink_port_network(
+        unsigned port);
+
+    BACNET_STACK_EXPORT
+    BACNET_PORT_TYPE datalink_port_type(
+        unsigned port);
+
+    BACNET_STACK_EXPORT
+    uint16_t datalink_port_receive(
+        unsigned *port,
+        BACNET_ADDRESS * src,
+        uint8_t * pdu,
+        uint16_t max_pdu,
+        unsigned timeout);
+
+    BACNET_STACK_EXPORT
+    int datalink_port_send_pdu(
+        unsigned port,
+        BACNET_ADDRESS * dest,
+        BACNET_NPDU_DATA * npdu_data,
+        uint8_t * pdu,
+        unsigned pdu_len);
+
+    BACNET_STACK_EXPORT
+    void datalink_port_get_broadcast_address(
+        unsigned port,
+        BACNET_ADDRESS * dest);
+
+    BACNET_STACK_EXPORT
+    void datalink_port_get_my_address(
+        unsigned port,
+        BACNET_ADDRESS * my_address);
+
+    BACNET_STACK_EXPORT
+    void datalink_port_route_add(
+        unsigned port,
+        uint16_t net,
+        BACNET_ADDRESS * router);
+
+    BACNET_STACK_EXPORT
+    int datalink_port_route_find(
+        uint16_t net,
+        BACNET_ADDRESS * router);
+
+    BACNET_STACK_EXPORT
+    unsigned datalink_port_route_list(
+        unsigned port,
+        uint16_t * net_list,
+        unsigned net_list_size);
+
+#ifdef BAC_ROUTING
+    BACNET_STACK_EXPORT
+    void routed_get_my_address(
+        BACNET_ADDRESS * my_address);
+#define datalink_get_my_address routed_get_my_address
+#endif
+#endif
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
@@ -28,6 +28,7 @@
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include "bacnet/config.h"
 #include "bacnet/bacdef.h"
 #include "bacnet/apdu.h"
@@ -316,6 +317,8 @@ void dlenv_network_port_init(void)
     Network_Port_Type_Set(instance, PORT_TYPE_MSTP);
     Network_Port_MSTP_Max_Master_Set(instance, dlmstp_max_master());
     Network_Port_MSTP_Max_Info_Frames_Set(instance, dlmstp_max_info_frames());
+    Network_Port_MSTP_Max_Info_Frames_Adaptive_Set(
+        instance, dlmstp_max_info_frames_adaptive());
     Network_Port_Link_Speed_Set(instance, dlmstp_baud_rate());
     mac[0] = dlmstp_mac_address();
     Network_Port_MAC_Address_Set(instance, &mac[0], 1);
@@ -362,6 +365,44 @@ void dlenv_network_port_init(void)
        since they are already set */
     Network_Port_Changes_Pending_Set(instance, false);
 }
+#elif defined(BACDL_ALL)
+/**
+ * Datalink network port object settings, one object for each datalink
+ * port that was added, up to the number of Network Port objects
+ */
+void dlenv_network_port_init(void)
+{
+    static const char *port_names[] = { "Ethernet Port", "ARCNET Port",
+        "MS/TP Port", "PTP Port", "LonTalk Port", "BACnet/IP Port",
+        "Zigbee Port", "Virtual Port", "Non-BACnet Port",
+        "BACnet/IPv6 Port" };
+    BACNET_PORT_TYPE type;
+    BACNET_ADDRESS addr = { 0 };
+    uint32_t instance;
+    unsigned port;
+
+    for (port = 0;
+         (port < datalink_port_count()) && (port < Network_Port_Count());
+         port++) {
+        instance = port + 1;
+        type = datalink_port_type(port);
+        Network_Port_Object_Instance_Number_Set(port, instance);
+        if (type <= PORT_TYPE_BIP6) {
+            Network_Port_Name_Set(instance, (char *)port_names[type]);
+        }
+        Network_Port_Type_Set(instance, type);
+        datalink_port_get_my_address(port, &addr);
+        Network_Port_MAC_Address_Set(instance, &addr.mac[0], addr.mac_len);
+        Network_Port_Reliability_Set(instance, RELIABILITY_NO_FAULT_DETECTED);
+        Network_Port_Link_Speed_Set(instance, 0.0);
+        Network_Port_Out_Of_Service_Set(instance, false);
+        Network_Port_Quality_Set(instance, PORT_QUALITY_UNKNOWN);
+        Network_Port_APDU_Length_Set(instance, MAX_APDU);
+        Network_Port_Network_Number_Set(
+            instance, datalink_port_network(port));
+        Network_Port_Changes_Pending_Set(instance, false);
+    }
+}
 #else
 /**
  * Datalink network port object settings
@@ -396,9 +437,64 @@ void dlenv_maintenance_timer(uint16_t elapsed_seconds)
             BBMD_Timer_Seconds = (uint16_t)BBMD_TTL_Seconds;
         }
     }
+#elif defined(BACDL_MSTP)
+    DLMSTP_STATISTICS statistics = { 0 };
+
+    (void)elapsed_seconds;
+    /* refresh the transmit queue and token hold counters */
+    dlmstp_fill_statistics(&statistics);
+    Network_Port_MSTP_Statistics_Set(
+        Network_Port_Index_To_Instance(0), &statistics);
 #endif
 }
 
+#if defined(BACDL_ALL)
+/**
+ * Add the datalink ports listed in a string like
+ * "bip,eth0,1;mstp,/dev/ttyUSB0,2" - datalink, interface and
+ * network number of each port, with the ports separated by ';'
+ *
+ * @param ports - list of ports
+ * @return true if every port was added
+ */
+static bool dlenv_datalink_ports(const char *ports)
+{
+    char entry[80];
+    char *datalink, *ifname, *net;
+    size_t len;
+
+    while (ports && *ports) {
+        len = strcspn(ports, ";");
+        if (len >= sizeof(entry)) {
+            return false;
+        }
+        memcpy(entry, ports, len);
+        entry[len] = 0;
+        ports += len;
+        if (*ports) {
+            ports++;
+        }
+        datalink = entry;
+        ifname = strchr(datalink, ',');
+        net = ifname ? strchr(ifname + 1, ',') : NULL;
+        if (!net) {
+            fprintf(stderr, "BACNET_DATALINK_PORTS: %s?\n", entry);
+            return false;
+        }
+        *ifname++ = 0;
+        *net++ = 0;
+        if (datalink_port_add(datalink, *ifname ? ifname : NULL,
+                (uint16_t)strtol(net, NULL, 0)) == DATALINK_PORT_NONE) {
+            fprintf(stderr, "BACNET_DATALINK_PORTS: unable to add %s %s\n",
+                datalink, ifname);
+            return false;
+        }
+    }
+
+    return (datalink_port_count() > 0);
+}
+#endif
+
 /** Initialize the DataLink configuration from Environment variables,
  * or else to defaults.
  * @ingroup DataLink
@@ -412,6 +508,10 @@ void dlenv_maintenance_timer(uint16_t elapsed_seconds)
  * The Environment Variables, by BACDL_ type, are:
  * - BACDL_ALL: (the general-purpose solution)
  *   - BACNET_DATALINK to set which BACDL_ type we are using.
+ *   - BACNET_DATALINK_PORTS to use several datalinks together instead,
+ *     as "datalink,interface,network;..." - for example
+ *     "bip,eth0,1;mstp,/dev/ttyUSB0,2". Each datalink type can be
+ *     listed once, and BACNET_IFACE is not used.
  * - (Any):
  *   - BACNET_APDU_TIMEOUT - set this value in milliseconds to change
  *     the APDU timeout.  APDU Timeout is how much time a client
@@ -439,8 +539,14 @@ void dlenv_maintenance_timer(uint16_t elapsed_seconds)
  *   - BACNET_BDT_MASK_1 - dotted IPv4 mask of the BBMD table
  *       entry 1..128 (optional)
  *   - BACNET_IP_NAT_ADDR - dotted IPv4 address of the public facing router
+ *   - BACNET_IP_DUPLICATE_WINDOW - milliseconds (0..65535) during which
+ *       a broadcast NPDU received again, directly or as a Forwarded-NPDU,
+ *       is dropped.  Defaults to 0 (disabled).
  * - BACDL_MSTP: (BACnet MS/TP)
  *   - BACNET_MAX_INFO_FRAMES
+ *   - BACNET_MAX_INFO_FRAMES_ADAPTIVE - upper bound of the per-token frame
+ *     budget of a router or gateway while its transmit queue is backed up.
+ *     Defaults to 0 (disabled).
  *   - BACNET_MAX_MASTER
  *   - BACNET_MSTP_BAUD
  *   - BACNET_MSTP_MAC
@@ -518,6 +624,10 @@ void dlenv_init(void)
             bvlc_set_global_address_for_nat(&addr);
         }
     }
+    pEnv = getenv("BACNET_IP_DUPLICATE_WINDOW");
+    if (pEnv) {
+        bvlc_duplicate_window_set((uint16_t)strtol(pEnv, NULL, 0));
+    }
 #elif defined(BACDL_MSTP)
     pEnv = getenv("BACNET_MAX_INFO_FRAMES");
     if (pEnv) {
@@ -525,6 +635,10 @@ void dlenv_init(void)
     } else {
         dlmstp_set_max_info_frames(1);
     }
+    pEnv = getenv("BACNET_MAX_INFO_FRAMES_ADAPTIVE");
+    if (pEnv) {
+        dlmstp_set_max_info_frames_adaptive(strtol(pEnv, NULL, 0));
+    }
     pEnv = getenv("BACNET_MAX_MASTER");
     if (pEnv) {
         dlmstp_set_max_master(strtol(pEnv, NULL, 0));
@@ -557,6 +671,14 @@ void dlenv_init(void)
         apdu_retries_set((uint8_t)strtol(pEnv, NULL, 0));
     }
     /* === Initialize the Datalink Here === */
+#if defined(BACDL_ALL)
+    pEnv = getenv("BACNET_DATALINK_PORTS");
+    if (pEnv) {
+        if (!dlenv_datalink_ports(pEnv)) {
+            exit(1);
+        }
+    } else
+#endif
     if (!datalink_init(getenv("BACNET_IFACE"))) {
         exit(1);
     }
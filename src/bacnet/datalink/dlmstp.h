@@ -30,11 +30,15 @@
 #include "bacnet/bacnet_stack_exports.h"
 #include "bacnet/bacdef.h"
 #include "bacnet/npdu.h"
+#include "bacnet/datalink/cobs.h"
+#include "bacnet/basic/sys/prioq.h"
 
 /* defines specific to MS/TP */
 /* preamble+type+dest+src+len+crc8+crc16 */
 #define DLMSTP_HEADER_MAX (2+1+1+1+2+1+2)
-#define DLMSTP_MPDU_MAX (DLMSTP_HEADER_MAX+MAX_PDU)
+/* extended frames are COBS encoded, with an encoded CRC-32K */
+#define DLMSTP_MPDU_MAX (DLMSTP_HEADER_MAX+COBS_ENCODED_SIZE(MAX_PDU)+\
+    COBS_ENCODED_CRC_SIZE)
 
 typedef struct dlmstp_packet {
     bool ready; /* true if ready to be sent or received */
@@ -52,6 +56,15 @@ typedef struct dlmstp_statistics {
     uint32_t transmit_pdu_counter;
     uint32_t receive_pdu_counter;
     uint32_t lost_token_counter;
+    /* transmit queue and token hold counters */
+    uint32_t transmit_queue_drop_counter;
+    uint32_t token_hold_counter;
+    uint32_t token_hold_frame_counter;
+    uint32_t token_hold_budget_counter;
+    uint16_t transmit_queue_depth;
+    uint16_t transmit_queue_peak;
+    uint16_t token_rotation_time;
+    uint8_t info_frames_budget;
 } DLMSTP_STATISTICS;
 
 /* callback to signify the receipt of a preamble */
@@ -159,6 +172,16 @@ extern "C" {
 
     BACNET_STACK_EXPORT
     uint8_t dlmstp_max_info_frames_limit(void);
+
+    /* Adaptive Max_Info_Frames for routers and gateways: while frames are */
+    /* queued, the node may send up to this many frames per token hold. */
+    /* Zero, or a value not greater than Max_Info_Frames, disables it. */
+    BACNET_STACK_EXPORT
+    void dlmstp_set_max_info_frames_adaptive(
+        uint8_t limit);
+    BACNET_STACK_EXPORT
+    uint8_t dlmstp_max_info_frames_adaptive(
+        void);
     BACNET_STACK_EXPORT
     uint8_t dlmstp_max_master_limit(void);
 
@@ -192,6 +215,13 @@ extern "C" {
     BACNET_STACK_EXPORT
     void dlmstp_fill_statistics(struct dlmstp_statistics * statistics);
 
+    /* Transmit queue counters for each network priority, */
+    /* in an array of PRIOQ_CLASSES, from a prioritized transmit queue */
+    BACNET_STACK_EXPORT
+    bool dlmstp_fill_queue_statistics(PRIOQ_STATS * stats);
+    BACNET_STACK_EXPORT
+    void dlmstp_reset_queue_statistics(void);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
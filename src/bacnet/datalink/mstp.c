@@ -48,11 +48,13 @@
 
 #include <stddef.h>
 #include <stdint.h>
+#include <string.h>
 #if PRINT_ENABLED
 #include <stdio.h>
 #endif
 #include "bacnet/datalink/mstp.h"
 #include "crc.h"
+#include "bacnet/datalink/cobs.h"
 #include "rs485.h"
 #include "bacnet/datalink/mstptext.h"
 #include "bacnet/npdu.h"
@@ -163,6 +165,9 @@ static inline void printf_master(const char *format, ...)
 #define Tusage_timeout 30
 #endif
 
+/* extended frames are COBS encoded, with a CRC-32K */
+#define MSTP_COBS_FRAME(t) (((t) >= Nmin_COBS_type) && ((t) <= Nmax_COBS_type))
+
 /* we need to be able to increment without rolling over */
 #define INCREMENT_AND_LIMIT_UINT8(x) \
     {                                \
@@ -175,6 +180,61 @@ bool MSTP_Line_Active(volatile struct mstp_port_struct_t *mstp_port)
     return (mstp_port->EventCount > Nmin_octets);
 }
 
+/**
+ * @brief The number of information frames this node may send before
+ *  it must pass the token: Nmax_info_frames, or a larger budget set
+ *  by the datalink for the current token hold.
+ * @param mstp_port - port specific data
+ * @return number of information frames for this token hold
+ */
+static uint8_t MSTP_Info_Frames(volatile struct mstp_port_struct_t *mstp_port)
+{
+    if (mstp_port->InfoFramesBudget > mstp_port->Nmax_info_frames) {
+        return mstp_port->InfoFramesBudget;
+    }
+
+    return mstp_port->Nmax_info_frames;
+}
+
+/**
+ * @brief Set the per-token frame budget for adaptive Max_Info_Frames.
+ *  Called by the datalink at the start of a token hold, i.e. from
+ *  MSTP_Get_Send() when FrameCount is zero. The budget grows with the
+ *  number of queued frames, from Nmax_info_frames up to
+ *  Nmax_info_frames_adaptive, and is scaled back while the observed token
+ *  rotation time exceeds the target.
+ * @param mstp_port - port specific data
+ * @param queued - number of frames waiting in the transmit queue
+ * @param rotation_ms - most recent token rotation time in milliseconds
+ * @param target_ms - token rotation time not to push beyond, or zero
+ * @return the number of information frames for this token hold
+ */
+uint8_t MSTP_Adaptive_Info_Frames(
+    volatile struct mstp_port_struct_t *mstp_port,
+    unsigned queued,
+    uint32_t rotation_ms,
+    uint32_t target_ms)
+{
+    uint32_t budget = mstp_port->Nmax_info_frames;
+
+    if ((mstp_port->Nmax_info_frames_adaptive > mstp_port->Nmax_info_frames) &&
+        (queued > budget)) {
+        budget = queued;
+        if (budget > mstp_port->Nmax_info_frames_adaptive) {
+            budget = mstp_port->Nmax_info_frames_adaptive;
+        }
+        if (target_ms && (rotation_ms > target_ms)) {
+            budget = (budget * target_ms) / rotation_ms;
+            if (budget < mstp_port->Nmax_info_frames) {
+                budget = mstp_port->Nmax_info_frames;
+            }
+        }
+    }
+    mstp_port->InfoFramesBudget = (uint8_t)budget;
+
+    return mstp_port->InfoFramesBudget;
+}
+
 void MSTP_Fill_BACnet_Address(BACNET_ADDRESS *src, uint8_t mstp_address)
 {
     int i = 0;
@@ -205,15 +265,38 @@ uint16_t MSTP_Create_Frame(uint8_t *buffer, /* where frame is loaded */
     uint8_t source, /* source address */
     uint8_t *data, /* any data to be sent - may be null */
     uint16_t data_len)
-{ /* number of bytes of data (up to 501) */
+{ /* number of bytes of data (up to 501, or 1497 in an extended frame) */
     uint8_t crc8 = 0xFF; /* used to calculate the crc value */
     uint16_t crc16 = 0xFFFF; /* used to calculate the crc value */
     uint16_t index = 0; /* used to load the data portion of the frame */
+    size_t cobs_len = 0; /* length of the COBS encoded data and CRC-32K */
 
     /* not enough to do a header */
     if (buffer_len < 8) {
         return 0;
     }
+    /* BACnet data too big for a frame is sent as an extended frame */
+    if (data_len > MSTP_FRAME_NPDU_MAX) {
+        if (frame_type == FRAME_TYPE_BACNET_DATA_EXPECTING_REPLY) {
+            frame_type = FRAME_TYPE_BACNET_EXTENDED_DATA_EXPECTING_REPLY;
+        } else if (frame_type == FRAME_TYPE_BACNET_DATA_NOT_EXPECTING_REPLY) {
+            frame_type = FRAME_TYPE_BACNET_EXTENDED_DATA_NOT_EXPECTING_REPLY;
+        }
+    }
+    if ((frame_type >= Nmin_COBS_type) && (frame_type <= Nmax_COBS_type)) {
+        if ((data_len == 0) || (data_len > MSTP_EXTENDED_FRAME_NPDU_MAX) ||
+            !data) {
+            return 0;
+        }
+        cobs_len =
+            cobs_frame_encode(&buffer[8], buffer_len - 8, data, data_len);
+        if (cobs_len == 0) {
+            return 0;
+        }
+        /* the last two octets of the encoded CRC-32K take the place of
+           the data CRC, and are not included in the Length field */
+        data_len = (uint16_t)(cobs_len - 2);
+    }
 
     buffer[0] = 0x55;
     buffer[1] = 0xFF;
@@ -228,14 +311,18 @@ uint16_t MSTP_Create_Frame(uint8_t *buffer, /* where frame is loaded */
     buffer[6] = data_len & 0xFF;
     crc8 = CRC_Calc_Header(buffer[6], crc8);
     buffer[7] = ~crc8;
+    if (cobs_len) {
+        return (uint16_t)(8 + cobs_len);
+    }
 
     index = 8;
-    while (data_len && data && (index < buffer_len)) {
-        buffer[index] = *data;
-        crc16 = CRC_Calc_Data(buffer[index], crc16);
-        data++;
-        index++;
-        data_len--;
+    if (data_len && data && (index < buffer_len)) {
+        if (data_len > (buffer_len - index)) {
+            data_len = buffer_len - index;
+        }
+        memcpy(&buffer[index], data, data_len);
+        crc16 = CRC_Calc_Data_Buffer(&buffer[index], data_len, crc16);
+        index += data_len;
     }
     /* append the data CRC if necessary */
     if (index > 8) {
@@ -271,6 +358,55 @@ void MSTP_Create_And_Send_Frame(
     /* FIXME: be sure to reset SilenceTimer() after each octet is sent! */
 }
 
+/**
+ * @brief Check that the data of the frame being received fits in the
+ *  InputBuffer. Extended frames are decoded in place, so the two octets
+ *  of the encoded CRC-32K that follow the data are kept as well.
+ * @param mstp_port - port specific data
+ * @return true if the data fits
+ */
+static bool MSTP_Frame_Fits(volatile struct mstp_port_struct_t *mstp_port)
+{
+    uint32_t length = mstp_port->DataLength;
+
+    if (MSTP_COBS_FRAME(mstp_port->FrameType)) {
+        length += 2;
+    }
+
+    return (length <= mstp_port->InputBufferSize);
+}
+
+/**
+ * @brief Finish the reception of an extended (COBS encoded) frame:
+ *  check the CRC-32K and decode the data in place, so that the rest
+ *  of the stack sees the same InputBuffer and DataLength that it would
+ *  for a BACnet Data frame.
+ * @param mstp_port - port specific data
+ */
+static void MSTP_Receive_COBS_Frame(
+    volatile struct mstp_port_struct_t *mstp_port)
+{
+    size_t data_len = 0;
+
+    if (mstp_port->receive_state == MSTP_RECEIVE_STATE_SKIP_DATA) {
+        /* NotForUs - or too long to decode */
+        mstp_port->ReceivedValidFrameNotForUs = true;
+        return;
+    }
+    mstp_port->InputBuffer[mstp_port->Index] = mstp_port->DataRegister;
+    data_len = cobs_frame_decode(mstp_port->InputBuffer,
+        mstp_port->InputBufferSize, mstp_port->InputBuffer,
+        mstp_port->DataLength + 2);
+    if (data_len > 0) {
+        /* ForUs */
+        mstp_port->DataLength = (uint16_t)data_len;
+        mstp_port->ReceivedValidFrame = true;
+    } else {
+        mstp_port->ReceivedInvalidFrame = true;
+        printf_receive_error("MSTP: Rx Data: BadCRC32K\n");
+    }
+}
+
 void MSTP_Receive_Frame_FSM(volatile struct mstp_port_struct_t *mstp_port)
 {
     MSTP_RECEIVE_STATE receive_state = mstp_port->receive_state;
@@ -450,8 +586,7 @@ void MSTP_Receive_Frame_FSM(volatile struct mstp_port_struct_t *mstp_port)
                                     mstp_port->This_Station) ||
                                 (mstp_port->DestinationAddress ==
                                     MSTP_BROADCAST_ADDRESS)) {
-                                if (mstp_port->DataLength <=
-                                    mstp_port->InputBufferSize) {
+                                if (MSTP_Frame_Fits(mstp_port)) {
                                     /* Data */
                                     mstp_port->receive_state =
                                         MSTP_RECEIVE_STATE_DATA;
@@ -532,6 +667,12 @@ void MSTP_Receive_Frame_FSM(volatile struct mstp_port_struct_t *mstp_port)
                     mstp_port->DataCRC = CRC_Calc_Data(
                         mstp_port->DataRegister, mstp_port->DataCRC);
                     mstp_port->DataCRCActualMSB = mstp_port->DataRegister;
+                    if (MSTP_COBS_FRAME(mstp_port->FrameType) &&
+                        (mstp_port->Index < mstp_port->InputBufferSize)) {
+                        /* part of the encoded CRC-32K */
+                        mstp_port->InputBuffer[mstp_port->Index] =
+                            mstp_port->DataRegister;
+                    }
                     mstp_port->Index++;
                     /* SKIP_DATA or DATA - no change in state */
                 } else if (mstp_port->Index == (mstp_port->DataLength + 1)) {
@@ -543,7 +684,9 @@ void MSTP_Receive_Frame_FSM(volatile struct mstp_port_struct_t *mstp_port)
                         mstptext_frame_type((unsigned)mstp_port->FrameType));
                     /* STATE DATA CRC - no need for new state */
                     /* indicate the complete reception of a valid frame */
-                    if (mstp_port->DataCRC == 0xF0B8) {
+                    if (MSTP_COBS_FRAME(mstp_port->FrameType)) {
+                        MSTP_Receive_COBS_Frame(mstp_port);
+                    } else if (mstp_port->DataCRC == 0xF0B8) {
                         if (mstp_port->receive_state ==
                             MSTP_RECEIVE_STATE_DATA) {
                             /* ForUs */
@@ -579,6 +722,85 @@ void MSTP_Receive_Frame_FSM(volatile struct mstp_port_struct_t *mstp_port)
     return;
 }
 
+/**
+ * @brief Run the Receive State Machine over a block of received octets
+ *  rather than one octet at a time through DataRegister and DataAvailable.
+ *  Octets between frames and the data portion of a frame are consumed
+ *  as whole spans; the preamble and header use MSTP_Receive_Frame_FSM().
+ *  The octet at a time FSM remains for ports that receive in an ISR.
+ *
+ *  Consumption stops once a valid or invalid frame is indicated, so that
+ *  the Master or Slave Node state machine can handle it before the next
+ *  frame overwrites the InputBuffer.
+ *
+ * @param mstp_port - port specific data
+ * @param data - received octets
+ * @param data_len - number of received octets
+ * @return number of octets consumed
+ */
+uint16_t MSTP_Receive_Frame_Buffer(
+    volatile struct mstp_port_struct_t *mstp_port,
+    const uint8_t *data,
+    uint16_t data_len)
+{
+    const uint8_t *preamble = NULL;
+    uint16_t index = 0;
+    uint16_t span = 0;
+    uint16_t i = 0;
+
+    /* handle any timeout since the last octet */
+    if (!mstp_port->DataAvailable) {
+        MSTP_Receive_Frame_FSM(mstp_port);
+    }
+    while ((index < data_len) && !mstp_port->ReceivedValidFrame &&
+        !mstp_port->ReceivedInvalidFrame && !mstp_port->ReceiveError) {
+        span = 0;
+        if (mstp_port->receive_state == MSTP_RECEIVE_STATE_IDLE) {
+            /* EatAnOctet until Preamble1 */
+            preamble = memchr(&data[index], 0x55, data_len - index);
+            if (preamble) {
+                span = (uint16_t)(preamble - &data[index]);
+            } else {
+                span = data_len - index;
+            }
+            for (i = 0; (i < span) && (mstp_port->EventCount < 0xFF); i++) {
+                mstp_port->EventCount++;
+            }
+        } else if (((mstp_port->receive_state == MSTP_RECEIVE_STATE_DATA) ||
+                       (mstp_port->receive_state ==
+                           MSTP_RECEIVE_STATE_SKIP_DATA)) &&
+            (mstp_port->Index < mstp_port->DataLength)) {
+            /* DataOctet */
+            span = data_len - index;
+            if (span > (mstp_port->DataLength - mstp_port->Index)) {
+                span = mstp_port->DataLength - mstp_port->Index;
+            }
+            mstp_port->DataCRC = CRC_Calc_Data_Buffer(
+                &data[index], span, mstp_port->DataCRC);
+            if (mstp_port->Index < mstp_port->InputBufferSize) {
+                i = span;
+                if (i > (mstp_port->InputBufferSize - mstp_port->Index)) {
+                    i = mstp_port->InputBufferSize - mstp_port->Index;
+                }
+                memcpy(&mstp_port->InputBuffer[mstp_port->Index],
+                    &data[index], i);
+            }
+            mstp_port->Index += span;
+        }
+        if (span) {
+            index += span;
+            mstp_port->SilenceTimerReset((void *)mstp_port);
+        } else {
+            mstp_port->DataRegister = data[index];
+            mstp_port->DataAvailable = true;
+            MSTP_Receive_Frame_FSM(mstp_port);
+            index++;
+        }
+    }
+
+    return index;
+}
+
 /* returns true if we need to transition immediately */
 bool MSTP_Master_Node_FSM(volatile struct mstp_port_struct_t *mstp_port)
 {
@@ -657,6 +879,7 @@ bool MSTP_Master_Node_FSM(volatile struct mstp_port_struct_t *mstp_port)
                             }
                             break;
                         case FRAME_TYPE_BACNET_DATA_NOT_EXPECTING_REPLY:
+                        case FRAME_TYPE_BACNET_EXTENDED_DATA_NOT_EXPECTING_REPLY:
                             if ((mstp_port->DestinationAddress ==
                                     MSTP_BROADCAST_ADDRESS) &&
                                 (npdu_confirmed_service(mstp_port->InputBuffer,
@@ -673,6 +896,7 @@ bool MSTP_Master_Node_FSM(volatile struct mstp_port_struct_t *mstp_port)
                             }
                             break;
                         case FRAME_TYPE_BACNET_DATA_EXPECTING_REPLY:
+                        case FRAME_TYPE_BACNET_EXTENDED_DATA_EXPECTING_REPLY:
                             if (mstp_port->DestinationAddress ==
                                 MSTP_BROADCAST_ADDRESS) {
                                 /* broadcast DER just remains IDLE */
@@ -723,7 +947,7 @@ bool MSTP_Master_Node_FSM(volatile struct mstp_port_struct_t *mstp_port)
             length = (unsigned)MSTP_Get_Send(mstp_port, 0);
             if (length < 1) {
                 /* NothingToSend */
-                mstp_port->FrameCount = mstp_port->Nmax_info_frames;
+                mstp_port->FrameCount = MSTP_Info_Frames(mstp_port);
                 mstp_port->master_state = MSTP_MASTER_STATE_DONE_WITH_TOKEN;
                 transition_now = true;
             } else {
@@ -734,6 +958,7 @@ bool MSTP_Master_Node_FSM(volatile struct mstp_port_struct_t *mstp_port)
                 mstp_port->FrameCount++;
                 switch (frame_type) {
                     case FRAME_TYPE_BACNET_DATA_EXPECTING_REPLY:
+                    case FRAME_TYPE_BACNET_EXTENDED_DATA_EXPECTING_REPLY:
                         if (destination == MSTP_BROADCAST_ADDRESS) {
                             /* SendNoWait */
                             mstp_port->master_state =
@@ -765,7 +990,7 @@ bool MSTP_Master_Node_FSM(volatile struct mstp_port_struct_t *mstp_port)
             if (mstp_port->SilenceTimer((void *)mstp_port) >= Treply_timeout) {
                 /* ReplyTimeout */
                 /* assume that the request has failed */
-                mstp_port->FrameCount = mstp_port->Nmax_info_frames;
+                mstp_port->FrameCount = MSTP_Info_Frames(mstp_port);
                 mstp_port->master_state = MSTP_MASTER_STATE_DONE_WITH_TOKEN;
                 /* Any retry of the data frame shall await the next entry */
                 /* to the USE_TOKEN state. (Because of the length of the
@@ -795,6 +1020,7 @@ bool MSTP_Master_Node_FSM(volatile struct mstp_port_struct_t *mstp_port)
                                     MSTP_MASTER_STATE_DONE_WITH_TOKEN;
                                 break;
                             case FRAME_TYPE_BACNET_DATA_NOT_EXPECTING_REPLY:
+                            case FRAME_TYPE_BACNET_EXTENDED_DATA_NOT_EXPECTING_REPLY:
                                 /* ReceivedReply */
                                 /* or a proprietary type that indicates a reply
                                  */
@@ -828,7 +1054,7 @@ bool MSTP_Master_Node_FSM(volatile struct mstp_port_struct_t *mstp_port)
             /* The DONE_WITH_TOKEN state either sends another data frame,  */
             /* passes the token, or initiates a Poll For Master cycle. */
             /* SendAnotherFrame */
-            if (mstp_port->FrameCount < mstp_port->Nmax_info_frames) {
+            if (mstp_port->FrameCount < MSTP_Info_Frames(mstp_port)) {
                 /* then this node may send another information frame  */
                 /* before passing the token.  */
                 mstp_port->master_state = MSTP_MASTER_STATE_USE_TOKEN;
@@ -1164,6 +1390,7 @@ void MSTP_Slave_Node_FSM(volatile struct mstp_port_struct_t *mstp_port)
     } else if (mstp_port->ReceivedValidFrame) {
         switch (mstp_port->FrameType) {
             case FRAME_TYPE_BACNET_DATA_EXPECTING_REPLY:
+            case FRAME_TYPE_BACNET_EXTENDED_DATA_EXPECTING_REPLY:
                 if (mstp_port->DestinationAddress != MSTP_BROADCAST_ADDRESS) {
                     /* The ANSWER_DATA_REQUEST state is entered when a  */
                     /* BACnet Data Expecting Reply, a Test_Request, or  */
@@ -1250,6 +1477,7 @@ void MSTP_Init(volatile struct mstp_port_struct_t *mstp_port)
         mstp_port->EventCount = 0;
         mstp_port->FrameType = FRAME_TYPE_TOKEN;
         mstp_port->FrameCount = 0;
+        mstp_port->InfoFramesBudget = 0;
         mstp_port->HeaderCRC = 0;
         mstp_port->Index = 0;
         mstp_port->Next_Station = mstp_port->This_Station;
@@ -148,6 +148,16 @@ struct mstp_port_struct_t {
     /* node, its value shall be 1. */
     uint8_t Nmax_info_frames;
 
+    /* Adaptive Max_Info_Frames for routers and gateways. When greater than */
+    /* Nmax_info_frames, the datalink may raise the per-token frame budget */
+    /* up to this value while its transmit queue is backed up. Zero, or a */
+    /* value not greater than Nmax_info_frames, disables the adaptive mode. */
+    uint8_t Nmax_info_frames_adaptive;
+    /* The number of information frames this node may send during the */
+    /* current token hold, as set by MSTP_Adaptive_Info_Frames. Values */
+    /* below Nmax_info_frames are ignored. */
+    uint8_t InfoFramesBudget;
+
     /* This parameter represents the value of the Max_Master property of the */
     /* node's Device object. The value of Max_Master specifies the highest */
     /* allowable address for master nodes. The value of Max_Master shall be */
@@ -182,6 +192,11 @@ extern "C" {
         volatile struct mstp_port_struct_t
         *mstp_port);
     BACNET_STACK_EXPORT
+    uint16_t MSTP_Receive_Frame_Buffer(
+        volatile struct mstp_port_struct_t *mstp_port,
+        const uint8_t *data,
+        uint16_t data_len);
+    BACNET_STACK_EXPORT
     bool MSTP_Master_Node_FSM(
         volatile struct mstp_port_struct_t
         *mstp_port);
@@ -189,6 +204,13 @@ extern "C" {
     void MSTP_Slave_Node_FSM(
         volatile struct mstp_port_struct_t *mstp_port);
 
+    BACNET_STACK_EXPORT
+    uint8_t MSTP_Adaptive_Info_Frames(
+        volatile struct mstp_port_struct_t *mstp_port,
+        unsigned queued,
+        uint32_t rotation_ms,
+        uint32_t target_ms);
+
     /* returns true if line is active */
     BACNET_STACK_EXPORT
     bool MSTP_Line_Active(
@@ -62,6 +62,11 @@
 #define CRC32K_RESIDUE (0x0843323B)
 #define MSTP_PREAMBLE_X55 (0x55)
 #define MSTP_EXTENDED_FRAME_NPDU_MAX 1497
+/* largest data field of a frame that is not COBS encoded */
+#define MSTP_FRAME_NPDU_MAX 501
+/* range of frame types that are COBS encoded with a CRC-32K */
+#define Nmin_COBS_type 32
+#define Nmax_COBS_type 127
 
 /* receive FSM states */
 typedef enum {
@@ -130,6 +135,13 @@ typedef enum {
 #define DEFAULT_MAX_MASTER 127
 #define DEFAULT_MAC_ADDRESS 127
 
+/* The token rotation time, in milliseconds, above which a router or */
+/* gateway node using adaptive Max_Info_Frames scales back its per-token */
+/* frame budget so that other nodes still get the token promptly. */
+#ifndef MSTP_TOKEN_ROTATION_TARGET
+#define MSTP_TOKEN_ROTATION_TARGET 250
+#endif
+
 #ifdef __cplusplus
 extern "C" {
 #endif /* __cplusplus */
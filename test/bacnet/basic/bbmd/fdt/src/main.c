@@ -0,0 +1,147 @@
+/*
+ * Copyright (c) 2026 Legrand North America, LLC.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+/* @file
+ * @brief test BBMD Foreign Device Table APIs
+ */
+
+#include <ztest.h>
+#include <bacnet/datalink/bvlc.h>
+#include <bacnet/basic/bbmd/fdt.h>
+
+/**
+ * @addtogroup bacnet_tests
+ * @{
+ */
+
+static void test_fdt_address(BACNET_IP_ADDRESS *addr, unsigned n)
+{
+    addr->address[0] = 10;
+    addr->address[1] = 0;
+    addr->address[2] = (uint8_t)(n >> 8);
+    addr->address[3] = (uint8_t)n;
+    addr->port = 0xBAC0;
+}
+
+/**
+ * @brief Test
+ */
+static void testFDTAddDelete(void)
+{
+    BACNET_IP_ADDRESS addr = { 0 };
+    BACNET_IP_FOREIGN_DEVICE_TABLE_ENTRY *entry = NULL;
+    unsigned i = 0;
+    bool status = false;
+
+    bbmd_fdt_init();
+    zassert_equal(bbmd_fdt_count(), 0, NULL);
+    zassert_equal(bbmd_fdt_size(), MAX_FD_ENTRIES, NULL);
+    /* fill past the static entries and up to the limit */
+    for (i = 0; i < BBMD_FDT_ENTRIES_LIMIT; i++) {
+        test_fdt_address(&addr, i);
+        status = bbmd_fdt_entry_add(&addr, 60);
+        zassert_true(status, NULL);
+    }
+    zassert_equal(bbmd_fdt_count(), BBMD_FDT_ENTRIES_LIMIT, NULL);
+    zassert_equal(bbmd_fdt_size(), BBMD_FDT_ENTRIES_LIMIT, NULL);
+    zassert_equal(bvlc_foreign_device_table_count(bbmd_fdt_list()),
+        BBMD_FDT_ENTRIES_LIMIT, NULL);
+    zassert_equal(bvlc_foreign_device_table_valid_count(bbmd_fdt_list()),
+        BBMD_FDT_ENTRIES_LIMIT, NULL);
+    test_fdt_address(&addr, BBMD_FDT_ENTRIES_LIMIT);
+    status = bbmd_fdt_entry_add(&addr, 60);
+    zassert_false(status, NULL);
+    /* all of them can be found */
+    for (i = 0; i < BBMD_FDT_ENTRIES_LIMIT; i++) {
+        test_fdt_address(&addr, i);
+        entry = bbmd_fdt_entry(&addr);
+        zassert_not_null(entry, NULL);
+        zassert_false(bvlc_address_different(&entry->dest_address, &addr),
+            NULL);
+        zassert_equal(entry->ttl_seconds, 60, NULL);
+        zassert_equal(entry->ttl_seconds_remaining, 90, NULL);
+    }
+    /* re-register */
+    test_fdt_address(&addr, 5);
+    status = bbmd_fdt_entry_add(&addr, 120);
+    zassert_true(status, NULL);
+    zassert_equal(bbmd_fdt_count(), BBMD_FDT_ENTRIES_LIMIT, NULL);
+    entry = bbmd_fdt_entry(&addr);
+    zassert_equal(entry->ttl_seconds_remaining, 150, NULL);
+    /* delete every other one */
+    for (i = 0; i < BBMD_FDT_ENTRIES_LIMIT; i += 2) {
+        test_fdt_address(&addr, i);
+        status = bbmd_fdt_entry_delete(&addr);
+        zassert_true(status, NULL);
+        status = bbmd_fdt_entry_delete(&addr);
+        zassert_false(status, NULL);
+    }
+    zassert_equal(bbmd_fdt_count(), BBMD_FDT_ENTRIES_LIMIT / 2, NULL);
+    zassert_equal(bvlc_foreign_device_table_valid_count(bbmd_fdt_list()),
+        BBMD_FDT_ENTRIES_LIMIT / 2, NULL);
+    for (i = 0; i < BBMD_FDT_ENTRIES_LIMIT; i++) {
+        test_fdt_address(&addr, i);
+        entry = bbmd_fdt_entry(&addr);
+        if (i % 2) {
+            zassert_not_null(entry, NULL);
+        } else {
+            zassert_is_null(entry, NULL);
+        }
+    }
+    /* every registered address is in the dense array */
+    for (i = 0; i < bbmd_fdt_count(); i++) {
+        zassert_not_null(bbmd_fdt_entry(bbmd_fdt_address(i)), NULL);
+    }
+    zassert_is_null(bbmd_fdt_address(bbmd_fdt_count()), NULL);
+    bbmd_fdt_init();
+    zassert_equal(bbmd_fdt_count(), 0, NULL);
+    zassert_equal(bbmd_fdt_size(), MAX_FD_ENTRIES, NULL);
+}
+
+/**
+ * @brief Test
+ */
+static void testFDTTimer(void)
+{
+    BACNET_IP_ADDRESS addr = { 0 };
+    unsigned i = 0;
+
+    bbmd_fdt_init();
+    for (i = 0; i < 8; i++) {
+        test_fdt_address(&addr, i);
+        zassert_true(bbmd_fdt_entry_add(&addr, (uint16_t)(i * 10)), NULL);
+    }
+    /* 30 second grace period */
+    bbmd_fdt_maintenance_timer(30);
+    zassert_equal(bbmd_fdt_count(), 7, NULL);
+    bbmd_fdt_maintenance_timer(25);
+    zassert_equal(bbmd_fdt_count(), 5, NULL);
+    for (i = 0; i < 8; i++) {
+        test_fdt_address(&addr, i);
+        if (i < 3) {
+            zassert_is_null(bbmd_fdt_entry(&addr), NULL);
+        } else {
+            zassert_not_null(bbmd_fdt_entry(&addr), NULL);
+        }
+    }
+    bbmd_fdt_maintenance_timer(UINT16_MAX);
+    zassert_equal(bbmd_fdt_count(), 0, NULL);
+    zassert_equal(bvlc_foreign_device_table_valid_count(bbmd_fdt_list()),
+        0, NULL);
+}
+/**
+ * @}
+ */
+
+void test_main(void)
+{
+    ztest_test_suite(fdt_tests,
+     ztest_unit_test(testFDTAddDelete),
+     ztest_unit_test(testFDTTimer)
+     );
+
+    ztest_run_test_suite(fdt_tests);
+}
@@ -0,0 +1,226 @@
+/*
+ * Copyright (c) 2026 Legrand North America, LLC.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+/* @file
+ * @brief test the duplicate broadcast NPDU detection of the BVLC handler
+ */
+
+#include <string.h>
+#include <ztest.h>
+#include <bacnet/npdu.h>
+#include <bacnet/datalink/bip.h>
+#include <bacnet/datalink/bvlc.h>
+#include <bacnet/basic/bbmd/h_bbmd.h>
+
+static unsigned long Test_Milliseconds;
+static BACNET_IP_ADDRESS Test_BIP_Addr;
+static BACNET_IP_ADDRESS Test_BIP_Broadcast_Addr;
+
+unsigned long mstimer_now(void)
+{
+    return Test_Milliseconds;
+}
+
+bool bip_get_addr(BACNET_IP_ADDRESS *addr)
+{
+    return bvlc_address_copy(addr, &Test_BIP_Addr);
+}
+
+bool bip_get_broadcast_addr(BACNET_IP_ADDRESS *addr)
+{
+    return bvlc_address_copy(addr, &Test_BIP_Broadcast_Addr);
+}
+
+int bip_send_mpdu(BACNET_IP_ADDRESS *dest, uint8_t *mtu, uint16_t mtu_len)
+{
+    (void)dest;
+    (void)mtu;
+    return mtu_len;
+}
+
+int bip_send_mpdu_list(BACNET_IP_ADDRESS *dest_list,
+    unsigned dest_count,
+    uint8_t *mtu,
+    uint16_t mtu_len)
+{
+    (void)dest_list;
+    (void)mtu;
+    (void)mtu_len;
+    return (int)dest_count;
+}
+
+/**
+ * @addtogroup bacnet_tests
+ * @{
+ */
+
+/* encode an unconfirmed Who-Is NPDU with a Device instance range */
+static uint16_t test_npdu(uint8_t *npdu, uint8_t low_limit)
+{
+    BACNET_NPDU_DATA npdu_data = { 0 };
+    int len;
+
+    npdu_encode_npdu_data(&npdu_data, false, MESSAGE_PRIORITY_NORMAL);
+    len = npdu_encode_pdu(npdu, NULL, NULL, &npdu_data);
+    npdu[len++] = PDU_TYPE_UNCONFIRMED_SERVICE_REQUEST;
+    npdu[len++] = SERVICE_UNCONFIRMED_WHO_IS;
+    npdu[len++] = 0x09;
+    npdu[len++] = low_limit;
+    npdu[len++] = 0x19;
+    npdu[len++] = 0xFF;
+
+    return (uint16_t)len;
+}
+
+static void test_setup(uint16_t window)
+{
+    bvlc_init();
+    bvlc_address_set(&Test_BIP_Addr, 192, 168, 1, 10);
+    bvlc_address_set(&Test_BIP_Broadcast_Addr, 192, 168, 1, 255);
+    bvlc_duplicate_window_set(window);
+    bvlc_duplicate_statistics_clear();
+    Test_Milliseconds = 1000;
+}
+
+/**
+ * @brief Test that a broadcast NPDU is only handled the first time it
+ *  arrives within the window, directly or forwarded by a BBMD
+ */
+static void testBVLCDuplicateHit(void)
+{
+    BACNET_IP_ADDRESS addr = { 0 };
+    BACNET_IP_ADDRESS bbmd_addr = { 0 };
+    BACNET_ADDRESS src = { 0 };
+    BACNET_ADDRESS test_src = { 0 };
+    BVLC_DUPLICATE_STATISTICS statistics = { 0 };
+    uint8_t npdu[MAX_NPDU + 8] = { 0 };
+    uint8_t mtu[BIP_MPDU_MAX] = { 0 };
+    uint16_t npdu_len, mtu_len;
+    int offset;
+
+    test_setup(100);
+    zassert_equal(bvlc_duplicate_window(), 100, NULL);
+    bvlc_address_set(&addr, 192, 168, 1, 100);
+    bvlc_address_set(&bbmd_addr, 10, 0, 0, 1);
+    npdu_len = test_npdu(npdu, 1);
+    mtu_len = bvlc_encode_original_broadcast(
+        mtu, sizeof(mtu), npdu, npdu_len);
+    offset = bvlc_handler(&addr, &src, mtu, mtu_len);
+    zassert_equal(offset, mtu_len - npdu_len, NULL);
+    zassert_mem_equal(&mtu[offset], npdu, npdu_len, NULL);
+    /* the same NPDU from the same node */
+    Test_Milliseconds += 99;
+    offset = bvlc_handler(&addr, &test_src, mtu, mtu_len);
+    zassert_equal(offset, 0, NULL);
+    /* the same NPDU from that node, forwarded by a BBMD */
+    mtu_len = bvlc_encode_forwarded_npdu(
+        mtu, sizeof(mtu), &addr, npdu, npdu_len);
+    offset = bvlc_handler(&bbmd_addr, &test_src, mtu, mtu_len);
+    zassert_equal(offset, 0, NULL);
+    bvlc_duplicate_statistics(&statistics);
+    zassert_equal(statistics.checked, 3, NULL);
+    zassert_equal(statistics.dropped, 2, NULL);
+    bvlc_duplicate_statistics_clear();
+    bvlc_duplicate_statistics(&statistics);
+    zassert_equal(statistics.checked, 0, NULL);
+    zassert_equal(statistics.dropped, 0, NULL);
+}
+
+/**
+ * @brief Test that other broadcast NPDU are not taken as duplicates
+ */
+static void testBVLCDuplicateMiss(void)
+{
+    BACNET_IP_ADDRESS addr = { 0 };
+    BACNET_IP_ADDRESS other_addr = { 0 };
+    BACNET_ADDRESS src = { 0 };
+    BVLC_DUPLICATE_STATISTICS statistics = { 0 };
+    uint8_t npdu[MAX_NPDU + 8] = { 0 };
+    uint8_t mtu[BIP_MPDU_MAX] = { 0 };
+    uint16_t npdu_len, mtu_len;
+    unsigned i;
+
+    test_setup(100);
+    bvlc_address_set(&addr, 192, 168, 1, 100);
+    bvlc_address_set(&other_addr, 192, 168, 1, 101);
+    npdu_len = test_npdu(npdu, 1);
+    mtu_len = bvlc_encode_original_broadcast(
+        mtu, sizeof(mtu), npdu, npdu_len);
+    zassert_true(bvlc_handler(&addr, &src, mtu, mtu_len) > 0, NULL);
+    /* the same NPDU from another node */
+    zassert_true(bvlc_handler(&other_addr, &src, mtu, mtu_len) > 0, NULL);
+    /* another NPDU from the same node */
+    npdu_len = test_npdu(npdu, 2);
+    mtu_len = bvlc_encode_original_broadcast(
+        mtu, sizeof(mtu), npdu, npdu_len);
+    zassert_true(bvlc_handler(&addr, &src, mtu, mtu_len) > 0, NULL);
+    /* the same NPDU as a unicast is not checked */
+    mtu_len =
+        bvlc_encode_original_unicast(mtu, sizeof(mtu), npdu, npdu_len);
+    zassert_true(bvlc_handler(&addr, &src, mtu, mtu_len) > 0, NULL);
+    bvlc_duplicate_statistics(&statistics);
+    zassert_equal(statistics.checked, 3, NULL);
+    zassert_equal(statistics.dropped, 0, NULL);
+    /* the oldest NPDU is forgotten when the cache is full */
+    for (i = 0; i < BVLC_DUPLICATE_CACHE_SIZE; i++) {
+        npdu_len = test_npdu(npdu, (uint8_t)(10 + i));
+        mtu_len = bvlc_encode_original_broadcast(
+            mtu, sizeof(mtu), npdu, npdu_len);
+        zassert_true(bvlc_handler(&addr, &src, mtu, mtu_len) > 0, NULL);
+    }
+    npdu_len = test_npdu(npdu, 1);
+    mtu_len = bvlc_encode_original_broadcast(
+        mtu, sizeof(mtu), npdu, npdu_len);
+    zassert_true(bvlc_handler(&addr, &src, mtu, mtu_len) > 0, NULL);
+    /* no detection without a window */
+    test_setup(0);
+    zassert_true(bvlc_handler(&addr, &src, mtu, mtu_len) > 0, NULL);
+    zassert_true(bvlc_handler(&addr, &src, mtu, mtu_len) > 0, NULL);
+    bvlc_duplicate_statistics(&statistics);
+    zassert_equal(statistics.checked, 0, NULL);
+}
+
+/**
+ * @brief Test that a broadcast NPDU is handled again after the window
+ */
+static void testBVLCDuplicateExpiry(void)
+{
+    BACNET_IP_ADDRESS addr = { 0 };
+    BACNET_ADDRESS src = { 0 };
+    BVLC_DUPLICATE_STATISTICS statistics = { 0 };
+    uint8_t npdu[MAX_NPDU + 8] = { 0 };
+    uint8_t mtu[BIP_MPDU_MAX] = { 0 };
+    uint16_t npdu_len, mtu_len;
+
+    test_setup(100);
+    bvlc_address_set(&addr, 192, 168, 1, 100);
+    npdu_len = test_npdu(npdu, 1);
+    mtu_len = bvlc_encode_original_broadcast(
+        mtu, sizeof(mtu), npdu, npdu_len);
+    zassert_true(bvlc_handler(&addr, &src, mtu, mtu_len) > 0, NULL);
+    Test_Milliseconds += 100;
+    zassert_true(bvlc_handler(&addr, &src, mtu, mtu_len) > 0, NULL);
+    /* remembered again from the second arrival */
+    Test_Milliseconds += 50;
+    zassert_equal(bvlc_handler(&addr, &src, mtu, mtu_len), 0, NULL);
+    bvlc_duplicate_statistics(&statistics);
+    zassert_equal(statistics.checked, 3, NULL);
+    zassert_equal(statistics.dropped, 1, NULL);
+}
+/**
+ * @}
+ */
+
+void test_main(void)
+{
+    ztest_test_suite(h_bbmd_tests,
+     ztest_unit_test(testBVLCDuplicateHit),
+     ztest_unit_test(testBVLCDuplicateMiss),
+     ztest_unit_test(testBVLCDuplicateExpiry)
+     );
+
+    ztest_run_test_suite(h_bbmd_tests);
+}
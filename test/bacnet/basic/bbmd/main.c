@@ -106,6 +106,40 @@ int bip_send_mpdu(BACNET_IP_ADDRESS *dest, uint8_t *mtu, uint16_t mtu_len)
     return 0;
 }
 
+/**
+ * The send function for a list of destinations
+ *
+ * @param dest_list - array of destination addresses
+ * @param dest_count - number of destination addresses
+ * @param mtu - the bytes of data to send
+ * @param mtu_len - the number of bytes of data to send
+ *
+ * @return number of datagrams that were sent
+ */
+int bip_send_mpdu_list(BACNET_IP_ADDRESS *dest_list,
+    unsigned dest_count,
+    uint8_t *mtu,
+    uint16_t mtu_len)
+{
+    unsigned i = 0;
+
+    for (i = 0; i < dest_count; i++) {
+        bip_send_mpdu(&dest_list[i], mtu, mtu_len);
+    }
+
+    return (int)dest_count;
+}
+
+/**
+ * Get the millisecond timer value
+ *
+ * @return milliseconds
+ */
+unsigned long mstimer_now(void)
+{
+    return 0;
+}
+
 /** Return the Object Instance number for our (single) Device Object.
  * This is a key function, widely invoked by the handler code, since
  * it provides "our" (ie, local) address.
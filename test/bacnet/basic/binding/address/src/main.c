@@ -186,6 +186,40 @@ static void testAddress(void)
         zassert_equal(count, (MAX_ADDRESS_CACHE - i - 1), NULL);
     }
 }
+
+/**
+ * @brief Test that address cache contexts are independent
+ */
+static void testAddressContext(void)
+{
+    static BACNET_ADDRESS_CACHE_CONTEXT context_a;
+    static BACNET_ADDRESS_CACHE_CONTEXT context_b;
+    BACNET_ADDRESS src;
+    BACNET_ADDRESS test_address;
+    unsigned test_max_apdu = 0;
+
+    address_context_init(&context_a);
+    address_context_init(&context_b);
+    address_context_set(&context_a);
+    zassert_equal(address_context(), &context_a, NULL);
+    address_init();
+    set_address(1, &src);
+    address_add(1234, 480, &src);
+    zassert_equal(address_count(), 1, NULL);
+    address_context_set(&context_b);
+    zassert_equal(address_count(), 0, NULL);
+    zassert_false(
+        address_get_by_device(1234, &test_max_apdu, &test_address), NULL);
+    address_context_set(&context_a);
+    zassert_true(
+        address_get_by_device(1234, &test_max_apdu, &test_address), NULL);
+    zassert_true(bacnet_address_same(&test_address, &src), NULL);
+    address_remove_device(1234);
+    /* back to the default context */
+    address_context_set(NULL);
+    zassert_not_equal(address_context(), &context_a, NULL);
+    zassert_not_equal(address_context(), &context_b, NULL);
+}
 /**
  * @}
  */
@@ -196,13 +230,15 @@ void test_main(void)
 #ifdef BACNET_ADDRESS_CACHE_FILE
     ztest_test_suite(address_tests,
      ztest_unit_test(testAddressFile),
-     ztest_unit_test(testAddress)
+     ztest_unit_test(testAddress),
+     ztest_unit_test(testAddressContext)
      );
 
     ztest_run_test_suite(address_tests);
 #else
     ztest_test_suite(address_tests,
-     ztest_unit_test(testAddress)
+     ztest_unit_test(testAddress),
+     ztest_unit_test(testAddressContext)
      );
 
     ztest_run_test_suite(address_tests);
@@ -0,0 +1,219 @@
+/*
+ * Copyright (c) 2026 Legrand North America, LLC.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+/* @file
+ * @brief test BACnet stack context APIs
+ */
+
+#include <ztest.h>
+#include <bacnet/bacdef.h>
+#include <bacnet/basic/context/stack_context.h>
+#include <bacnet/basic/npdu/h_npdu.h>
+#include <bacnet/basic/service/h_apdu.h>
+
+/* contexts of the modules that are not linked into the test */
+static BACNET_DEVICE_CONTEXT *Test_Device_Context;
+static BACNET_COV_CONTEXT *Test_COV_Context;
+/* the selected contexts during the last npdu_handler() call */
+static BACNET_STACK_CONTEXT *Test_Handler_Context;
+static BACNET_TSM_CONTEXT *Test_Handler_TSM_Context;
+static BACNET_ADDRESS_CACHE_CONTEXT *Test_Handler_Address_Context;
+static BACNET_DEVICE_CONTEXT *Test_Handler_Device_Context;
+static unsigned Test_Handler_Count;
+
+void Device_Context_Init(
+    BACNET_DEVICE_CONTEXT *context, object_functions_t *object_table)
+{
+    memset(context, 0, sizeof(BACNET_DEVICE_CONTEXT));
+    context->Object_Table = object_table;
+}
+
+void Device_Context_Set(BACNET_DEVICE_CONTEXT *context)
+{
+    Test_Device_Context = context;
+}
+
+void handler_cov_context_init(BACNET_COV_CONTEXT *context)
+{
+    memset(context, 0, sizeof(BACNET_COV_CONTEXT));
+}
+
+void handler_cov_context_set(BACNET_COV_CONTEXT *context)
+{
+    Test_COV_Context = context;
+}
+
+uint16_t apdu_timeout(void)
+{
+    return 3000;
+}
+
+uint8_t apdu_retries(void)
+{
+    return 3;
+}
+
+int bip_send_pdu(BACNET_ADDRESS *dest,
+    BACNET_NPDU_DATA *npdu_data,
+    uint8_t *pdu,
+    unsigned pdu_len)
+{
+    (void)dest;
+    (void)npdu_data;
+    (void)pdu;
+    return (int)pdu_len;
+}
+
+void npdu_handler(BACNET_ADDRESS *src, uint8_t *pdu, uint16_t pdu_len)
+{
+    (void)src;
+    (void)pdu;
+    (void)pdu_len;
+    Test_Handler_Context = stack_context();
+    Test_Handler_TSM_Context = tsm_context();
+    Test_Handler_Address_Context = address_context();
+    Test_Handler_Device_Context = Test_Device_Context;
+    Test_Handler_Count++;
+}
+
+/**
+ * @addtogroup bacnet_tests
+ * @{
+ */
+
+static void test_stack_context_selected(BACNET_STACK_CONTEXT *context)
+{
+    zassert_equal(stack_context(), context, NULL);
+    if (context) {
+        zassert_equal(tsm_context(), &context->TSM, NULL);
+        zassert_equal(address_context(), &context->Address_Cache, NULL);
+        zassert_equal(npdu_cache_context(), &context->NPDU_Cache, NULL);
+        zassert_equal(Test_Device_Context, &context->Device, NULL);
+        zassert_equal(Test_COV_Context, &context->COV, NULL);
+    } else {
+        zassert_not_null(tsm_context(), NULL);
+        zassert_not_null(address_context(), NULL);
+        zassert_not_null(npdu_cache_context(), NULL);
+        zassert_is_null(Test_Device_Context, NULL);
+        zassert_is_null(Test_COV_Context, NULL);
+    }
+}
+
+/**
+ * @brief Test that a new context is empty and has the device identity
+ */
+static void testStackContextCreate(void)
+{
+    static BACNET_STACK_CONTEXT context;
+    object_functions_t object_table[1] = {
+        { .Object_Type = MAX_BACNET_OBJECT_TYPE }
+    };
+
+    memset(&context, 0xFF, sizeof(context));
+    stack_context_init(&context, 1234, object_table);
+    zassert_equal(context.Device.Object_Instance_Number, 1234, NULL);
+    zassert_equal(context.Device.Object_Table, object_table, NULL);
+    zassert_equal(context.Address_Cache.Own_Device_ID, 1234, NULL);
+    zassert_equal(context.TSM.Current_Invoke_ID, 1, NULL);
+    zassert_equal(context.TSM.List[0].InvokeID, 0, NULL);
+    /* initializing does not select the context */
+    test_stack_context_selected(NULL);
+    stack_context_init(NULL, 1234, NULL);
+}
+
+/**
+ * @brief Test that the selected context holds the state of its device
+ */
+static void testStackContextSelect(void)
+{
+    static BACNET_STACK_CONTEXT context_a;
+    static BACNET_STACK_CONTEXT context_b;
+    BACNET_ADDRESS addr = { 0 };
+    BACNET_ADDRESS test_addr = { 0 };
+    BACNET_TSM_CONTEXT *default_tsm;
+    BACNET_ADDRESS_CACHE_CONTEXT *default_address;
+    unsigned max_apdu = 0;
+
+    default_tsm = tsm_context();
+    default_address = address_context();
+    stack_context_init(&context_a, 1, NULL);
+    stack_context_init(&context_b, 2, NULL);
+    stack_context_set(&context_a);
+    test_stack_context_selected(&context_a);
+    addr.mac_len = 1;
+    addr.mac[0] = 0x05;
+    address_add(100, MAX_APDU, &addr);
+    zassert_equal(tsm_next_free_invokeID(), 1, NULL);
+    zassert_equal(tsm_next_free_invokeID(), 2, NULL);
+    stack_context_set(&context_b);
+    test_stack_context_selected(&context_b);
+    zassert_false(address_get_by_device(100, &max_apdu, &test_addr), NULL);
+    zassert_equal(tsm_next_free_invokeID(), 1, NULL);
+    stack_context_set(&context_a);
+    zassert_true(address_get_by_device(100, &max_apdu, &test_addr), NULL);
+    zassert_equal(test_addr.mac[0], 0x05, NULL);
+    zassert_equal(tsm_transaction_idle_count(), MAX_TSM_TRANSACTIONS - 2,
+        NULL);
+    /* back to the defaults */
+    stack_context_set(NULL);
+    test_stack_context_selected(NULL);
+    zassert_equal(tsm_context(), default_tsm, NULL);
+    zassert_equal(address_context(), default_address, NULL);
+    zassert_false(address_get_by_device(100, &max_apdu, &test_addr), NULL);
+}
+
+/**
+ * @brief Test that a PDU is handled with the context of its device,
+ *  and that the context selected before is restored afterwards
+ */
+static void testStackContextDispatch(void)
+{
+    static BACNET_STACK_CONTEXT context_a;
+    static BACNET_STACK_CONTEXT context_b;
+    BACNET_ADDRESS src = { 0 };
+    uint8_t pdu[4] = { 0x01, 0x00, 0x10, 0x08 };
+
+    stack_context_init(&context_a, 1, NULL);
+    stack_context_init(&context_b, 2, NULL);
+    Test_Handler_Count = 0;
+    /* from the defaults */
+    stack_context_set(NULL);
+    stack_context_npdu_handler(&context_b, &src, pdu, sizeof(pdu));
+    zassert_equal(Test_Handler_Count, 1, NULL);
+    zassert_equal(Test_Handler_Context, &context_b, NULL);
+    zassert_equal(Test_Handler_TSM_Context, &context_b.TSM, NULL);
+    zassert_equal(
+        Test_Handler_Address_Context, &context_b.Address_Cache, NULL);
+    zassert_equal(Test_Handler_Device_Context, &context_b.Device, NULL);
+    test_stack_context_selected(NULL);
+    /* from another context */
+    stack_context_set(&context_a);
+    stack_context_npdu_handler(&context_b, &src, pdu, sizeof(pdu));
+    zassert_equal(Test_Handler_Count, 2, NULL);
+    zassert_equal(Test_Handler_Context, &context_b, NULL);
+    zassert_equal(Test_Handler_TSM_Context, &context_b.TSM, NULL);
+    test_stack_context_selected(&context_a);
+    /* for the selected context */
+    stack_context_npdu_handler(&context_a, &src, pdu, sizeof(pdu));
+    zassert_equal(Test_Handler_Count, 3, NULL);
+    zassert_equal(Test_Handler_Context, &context_a, NULL);
+    test_stack_context_selected(&context_a);
+    stack_context_set(NULL);
+}
+/**
+ * @}
+ */
+
+void test_main(void)
+{
+    ztest_test_suite(stack_context_tests,
+     ztest_unit_test(testStackContextCreate),
+     ztest_unit_test(testStackContextSelect),
+     ztest_unit_test(testStackContextDispatch)
+     );
+
+    ztest_run_test_suite(stack_context_tests);
+}
@@ -0,0 +1,113 @@
+/*
+ * Copyright (c) 2026 Legrand North America, LLC.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+/* @file
+ * @brief test encoded NPDU header cache APIs
+ */
+
+#include <ztest.h>
+#include <bacnet/bacdef.h>
+#include <bacnet/npdu.h>
+#include <bacnet/basic/npdu/npdu_cache.h>
+
+/**
+ * @addtogroup bacnet_tests
+ * @{
+ */
+
+/**
+ * @brief Encode with the cache and compare with npdu_encode_pdu()
+ */
+static void testNpduCacheEncode(BACNET_ADDRESS *dest,
+    BACNET_ADDRESS *src,
+    BACNET_NPDU_DATA *npdu_data)
+{
+    uint8_t pdu[MAX_NPDU] = { 0 };
+    uint8_t test_pdu[MAX_NPDU] = { 0 };
+    int len, test_len;
+
+    len = npdu_encode_pdu(pdu, dest, src, npdu_data);
+    test_len = npdu_cache_encode_pdu(test_pdu, dest, src, npdu_data);
+    zassert_true(len > 0, NULL);
+    zassert_equal(len, test_len, NULL);
+    zassert_mem_equal(pdu, test_pdu, len, NULL);
+}
+
+/**
+ * @brief Test that cached NPDU headers match encoded ones
+ */
+static void testNpduCache(void)
+{
+    BACNET_NPDU_CACHE_CONTEXT context;
+    BACNET_NPDU_DATA npdu_data = { 0 };
+    BACNET_ADDRESS dest = { 0 };
+    BACNET_ADDRESS src = { 0 };
+    BACNET_ADDRESS other = { 0 };
+
+    npdu_cache_context_init(&context);
+    npdu_cache_context_set(&context);
+    zassert_equal(npdu_cache_context(), &context, NULL);
+    /* local destination */
+    npdu_encode_npdu_data(&npdu_data, false, MESSAGE_PRIORITY_NORMAL);
+    testNpduCacheEncode(&dest, &src, &npdu_data);
+    testNpduCacheEncode(&dest, &src, &npdu_data);
+    zassert_equal(context.Misses, 1, NULL);
+    zassert_equal(context.Hits, 1, NULL);
+    /* routed destination and source */
+    dest.net = 2001;
+    dest.len = 1;
+    dest.adr[0] = 0x7F;
+    src.net = 2709;
+    src.len = 3;
+    src.adr[0] = 0x03;
+    src.adr[1] = 0xF7;
+    src.adr[2] = 0xA1;
+    testNpduCacheEncode(&dest, &src, &npdu_data);
+    testNpduCacheEncode(&dest, &src, &npdu_data);
+    zassert_equal(context.Hits, 2, NULL);
+    /* the key includes the addresses, expecting reply and priority */
+    other = dest;
+    other.adr[0] = 0x7E;
+    testNpduCacheEncode(&other, &src, &npdu_data);
+    other = src;
+    other.adr[2] = 0xA2;
+    testNpduCacheEncode(&dest, &other, &npdu_data);
+    npdu_encode_npdu_data(&npdu_data, true, MESSAGE_PRIORITY_URGENT);
+    testNpduCacheEncode(&dest, &src, &npdu_data);
+    zassert_equal(context.Hits, 2, NULL);
+    testNpduCacheEncode(&dest, &src, &npdu_data);
+    zassert_equal(context.Hits, 3, NULL);
+    /* a remote broadcast */
+    dest.len = 0;
+    testNpduCacheEncode(&dest, NULL, &npdu_data);
+    testNpduCacheEncode(&dest, NULL, &npdu_data);
+    zassert_equal(context.Hits, 4, NULL);
+    /* network layer messages are not cached */
+    npdu_encode_npdu_network(&npdu_data, NETWORK_MESSAGE_WHAT_IS_NETWORK_NUMBER,
+        false, MESSAGE_PRIORITY_NORMAL);
+    testNpduCacheEncode(&dest, NULL, &npdu_data);
+    testNpduCacheEncode(&dest, NULL, &npdu_data);
+    zassert_equal(context.Hits, 4, NULL);
+    /* an empty cache encodes again */
+    npdu_encode_npdu_data(&npdu_data, true, MESSAGE_PRIORITY_URGENT);
+    npdu_cache_invalidate();
+    testNpduCacheEncode(&dest, NULL, &npdu_data);
+    zassert_equal(context.Hits, 4, NULL);
+    npdu_cache_context_set(NULL);
+    zassert_not_equal(npdu_cache_context(), &context, NULL);
+}
+/**
+ * @}
+ */
+
+void test_main(void)
+{
+    ztest_test_suite(npdu_cache_tests,
+     ztest_unit_test(testNpduCache)
+     );
+
+    ztest_run_test_suite(npdu_cache_tests);
+}
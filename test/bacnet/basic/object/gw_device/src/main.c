@@ -0,0 +1,276 @@
+/*
+ * Copyright (c) 2026 Legrand North America, LLC.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+/* @file
+ * @brief test the lookup of routed Devices by MAC address and instance
+ */
+
+#include <ztest.h>
+#include <bacnet/bacapp.h>
+#include <bacnet/reject.h>
+#include <bacnet/wp.h>
+#include <bacnet/basic/object/device.h>
+
+/* the DNET of the virtual network of the routed Devices */
+#define TEST_DNET 5
+/* instance numbers that are a multiple of the largest hash table size
+   all have the same home slot in the instance hash table */
+#define TEST_INSTANCE_COLLIDE 1024UL
+
+static BACNET_DEVICE_CONTEXT Test_Device_Context;
+static int Test_DNET_List[2] = { TEST_DNET, -1 };
+static uint32_t Test_Instance[MAX_ROUTED_DEVICES];
+static uint8_t Test_MAC[MAX_ROUTED_DEVICES][2];
+static uint8_t Test_MAC_Len[MAX_ROUTED_DEVICES];
+
+BACNET_DEVICE_CONTEXT *Device_Context(void)
+{
+    return &Test_Device_Context;
+}
+
+int Device_Read_Property_Local(BACNET_READ_PROPERTY_DATA *rpdata)
+{
+    (void)rpdata;
+    return BACNET_STATUS_ERROR;
+}
+
+bool Device_Write_Property_Local(BACNET_WRITE_PROPERTY_DATA *wp_data)
+{
+    (void)wp_data;
+    return false;
+}
+
+int bacapp_decode_application_data(uint8_t *apdu,
+    unsigned max_apdu_len,
+    BACNET_APPLICATION_DATA_VALUE *value)
+{
+    (void)apdu;
+    (void)max_apdu_len;
+    (void)value;
+    return BACNET_STATUS_ERROR;
+}
+
+bool write_property_type_valid(BACNET_WRITE_PROPERTY_DATA *wp_data,
+    BACNET_APPLICATION_DATA_VALUE *value,
+    uint8_t expected_tag)
+{
+    (void)wp_data;
+    (void)value;
+    (void)expected_tag;
+    return false;
+}
+
+bool write_property_string_valid(BACNET_WRITE_PROPERTY_DATA *wp_data,
+    BACNET_APPLICATION_DATA_VALUE *value,
+    int len_max)
+{
+    (void)wp_data;
+    (void)value;
+    (void)len_max;
+    return false;
+}
+
+int reject_encode_apdu(uint8_t *apdu, uint8_t invoke_id, uint8_t reject_reason)
+{
+    (void)apdu;
+    (void)invoke_id;
+    (void)reject_reason;
+    return 0;
+}
+
+/**
+ * @addtogroup bacnet_tests
+ * @{
+ */
+
+/* the size of the hash tables once a number of Devices are added */
+static unsigned test_hash_size(unsigned count)
+{
+    unsigned size = MAX_NUM_DEVICES * 2;
+
+    while ((count * 2) > size) {
+        size *= 2;
+    }
+
+    return size;
+}
+
+/* the home slot of a virtual MAC address, as gw_device.c computes it */
+static unsigned test_mac_slot(uint8_t len, const uint8_t *adr, unsigned size)
+{
+    uint32_t hash = 2166136261UL;
+    unsigned i;
+
+    for (i = 0; i < len; i++) {
+        hash ^= adr[i];
+        hash *= 16777619UL;
+    }
+    hash ^= len;
+    hash *= 16777619UL;
+
+    return (unsigned)(hash % size);
+}
+
+static void test_set_address(unsigned idx, uint8_t len, uint16_t mac)
+{
+    BACNET_ADDRESS address = { 0 };
+
+    address.net = TEST_DNET;
+    address.len = len;
+    address.adr[0] = (uint8_t)(mac >> 8);
+    address.adr[1] = (uint8_t)mac;
+    zassert_true(Routed_Device_Set_Address((int)idx, &address), NULL);
+    Test_MAC_Len[idx] = len;
+    Test_MAC[idx][0] = address.adr[0];
+    Test_MAC[idx][1] = address.adr[1];
+}
+
+static void test_set_instance(unsigned idx, uint32_t instance)
+{
+    zassert_not_null(Get_Routed_Device_Object((int)idx), NULL);
+    zassert_true(Routed_Device_Set_Object_Instance_Number(instance), NULL);
+    Test_Instance[idx] = instance;
+}
+
+/* find a Device by its virtual MAC address, as the routing does */
+static int test_mac_find(uint8_t len, const uint8_t *adr)
+{
+    BACNET_ADDRESS dest = { 0 };
+    int cursor = 0;
+
+    dest.net = TEST_DNET;
+    dest.len = len;
+    memcpy(dest.adr, adr, len);
+    if (!Routed_Device_GetNext(&dest, Test_DNET_List, &cursor)) {
+        return -1;
+    }
+    zassert_equal(cursor, -1, NULL);
+
+    return Routed_Device_Current_Index();
+}
+
+/* check that every Device is found by its instance and its MAC address */
+static void test_lookup_all(void)
+{
+    unsigned i;
+
+    zassert_equal(Routed_Device_Count(), MAX_ROUTED_DEVICES, NULL);
+    for (i = 0; i < MAX_ROUTED_DEVICES; i++) {
+        zassert_true(
+            Routed_Device_Valid_Object_Instance_Number(Test_Instance[i]),
+            NULL);
+        zassert_equal(Routed_Device_Current_Index(), i, NULL);
+        if ((i > 0) && Test_MAC_Len[i]) {
+            zassert_equal(
+                test_mac_find(Test_MAC_Len[i], &Test_MAC[i][0]), (int)i,
+                NULL);
+        }
+    }
+}
+
+/**
+ * @brief Test adding Devices past the static tables, and their lookup
+ */
+static void testRoutedDeviceAdd(void)
+{
+    uint16_t idx;
+    uint16_t mac = 0x0100;
+    unsigned i, slot;
+
+    for (i = 0; i < MAX_ROUTED_DEVICES; i++) {
+        if ((i % 2) == 0) {
+            Test_Instance[i] = TEST_INSTANCE_COLLIDE * (i + 1);
+        } else {
+            Test_Instance[i] = 1000 + i;
+        }
+        idx = Add_Routed_Device(Test_Instance[i], NULL, NULL);
+        zassert_equal(idx, i, NULL);
+        zassert_equal(Routed_Device_Current_Index(), i, NULL);
+    }
+    zassert_true(MAX_ROUTED_DEVICES > MAX_NUM_DEVICES, NULL);
+    zassert_equal(
+        Add_Routed_Device(1, NULL, NULL), UINT16_MAX, NULL);
+    /* the first three routed Devices have the same home slot in the
+       MAC hash table, so that they make one probe chain */
+    slot = test_mac_slot(2, (uint8_t[]){ 0x01, 0x00 },
+        test_hash_size(MAX_ROUTED_DEVICES));
+    for (i = 1; i < 4; i++) {
+        while (test_mac_slot(2, (uint8_t[]){ mac >> 8, mac & 0xFF },
+                   test_hash_size(MAX_ROUTED_DEVICES)) != slot) {
+            mac++;
+        }
+        test_set_address(i, 2, mac);
+        mac++;
+    }
+    zassert_true(mac < 0x1000, NULL);
+    for (i = 4; i < MAX_ROUTED_DEVICES; i++) {
+        test_set_address(i, 2, (uint16_t)(0x1000 + i));
+    }
+    test_lookup_all();
+    /* unknown instance and address */
+    zassert_false(Routed_Device_Valid_Object_Instance_Number(999999), NULL);
+    zassert_equal(test_mac_find(2, (uint8_t[]){ 0x0F, 0xFF }), -1, NULL);
+}
+
+/**
+ * @brief Test changing the instance of a Device in the middle of a probe
+ *  chain, and that the rest of the chain is still found
+ */
+static void testRoutedDeviceInstanceRekey(void)
+{
+    uint32_t old_instance = Test_Instance[10];
+
+    test_set_instance(10, 777777);
+    zassert_false(
+        Routed_Device_Valid_Object_Instance_Number(old_instance), NULL);
+    test_lookup_all();
+    /* the start of the chain, then back */
+    old_instance = Test_Instance[2];
+    test_set_instance(2, 888888);
+    zassert_false(
+        Routed_Device_Valid_Object_Instance_Number(old_instance), NULL);
+    test_lookup_all();
+    test_set_instance(2, old_instance);
+    test_set_instance(10, TEST_INSTANCE_COLLIDE * 11);
+    test_lookup_all();
+}
+
+/**
+ * @brief Test changing the address of a Device in the middle of a probe
+ *  chain, and that the rest of the chain is still found
+ */
+static void testRoutedDeviceAddressRekey(void)
+{
+    uint8_t old_mac[2];
+
+    memcpy(old_mac, &Test_MAC[2][0], sizeof(old_mac));
+    test_set_address(2, 2, 0x2000);
+    zassert_equal(test_mac_find(2, old_mac), -1, NULL);
+    test_lookup_all();
+    /* a Device without an address is not found by one */
+    memcpy(old_mac, &Test_MAC[1][0], sizeof(old_mac));
+    test_set_address(1, 0, 0);
+    zassert_equal(test_mac_find(2, old_mac), -1, NULL);
+    test_lookup_all();
+    /* the same address again */
+    test_set_address(1, 2, (uint16_t)((old_mac[0] << 8) | old_mac[1]));
+    test_set_address(1, 2, (uint16_t)((old_mac[0] << 8) | old_mac[1]));
+    test_lookup_all();
+}
+/**
+ * @}
+ */
+
+void test_main(void)
+{
+    ztest_test_suite(gw_device_tests,
+     ztest_unit_test(testRoutedDeviceAdd),
+     ztest_unit_test(testRoutedDeviceInstanceRekey),
+     ztest_unit_test(testRoutedDeviceAddressRekey)
+     );
+
+    ztest_run_test_suite(gw_device_tests);
+}
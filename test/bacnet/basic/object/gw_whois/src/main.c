@@ -0,0 +1,311 @@
+/*
+ * Copyright (c) 2026 Legrand North America, LLC.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+/* @file
+ * @brief test pacing of the I-Am responses of routed Devices
+ */
+
+#include <ztest.h>
+#include <bacnet/whois.h>
+#include <bacnet/basic/object/device.h>
+#include <bacnet/basic/services.h>
+#include <bacnet/basic/tsm/tsm.h>
+#include <bacnet/basic/sys/mstimer.h>
+
+/* number of routed Devices in the stub gateway */
+#define TEST_DEVICES 200
+
+/* I-Am sent, as Device index and MAC of the destination (0 for broadcast) */
+struct test_i_am {
+    uint16_t index;
+    uint8_t mac;
+};
+static struct test_i_am Test_I_Am[TEST_DEVICES * 4];
+static unsigned Test_I_Am_Count;
+static unsigned long Test_Time;
+static uint16_t Test_Current_Index;
+static DEVICE_OBJECT_DATA Test_Device;
+static BACNET_TRANSMIT_CONTEXT Test_Transmit_Context;
+
+unsigned long mstimer_now(void)
+{
+    return Test_Time;
+}
+
+BACNET_TRANSMIT_CONTEXT *tsm_transmit_context_acquire(void)
+{
+    return &Test_Transmit_Context;
+}
+
+void tsm_transmit_context_release(BACNET_TRANSMIT_CONTEXT *context)
+{
+    (void)context;
+}
+
+DEVICE_OBJECT_DATA *Get_Routed_Device_Object(int idx)
+{
+    if ((idx >= 0) && (idx < TEST_DEVICES)) {
+        Test_Current_Index = (uint16_t)idx;
+        return &Test_Device;
+    }
+
+    return NULL;
+}
+
+uint16_t Routed_Device_Current_Index(void)
+{
+    return Test_Current_Index;
+}
+
+uint32_t Device_Object_Instance_Number(void)
+{
+    return 1000 + Test_Current_Index;
+}
+
+static void test_i_am_record(uint8_t mac)
+{
+    if (Test_I_Am_Count < (sizeof(Test_I_Am) / sizeof(Test_I_Am[0]))) {
+        Test_I_Am[Test_I_Am_Count].index = Test_Current_Index;
+        Test_I_Am[Test_I_Am_Count].mac = mac;
+        Test_I_Am_Count++;
+    }
+}
+
+void Send_I_Am(uint8_t *buffer)
+{
+    (void)buffer;
+    test_i_am_record(0);
+}
+
+void Send_I_Am_Unicast(uint8_t *buffer, BACNET_ADDRESS *src)
+{
+    (void)buffer;
+    test_i_am_record(src->mac[0]);
+}
+
+static void test_setup(void)
+{
+    Test_I_Am_Count = 0;
+    Test_Current_Index = 0;
+    handler_who_is_pacing_set(WHO_IS_I_AM_WINDOW, WHO_IS_I_AM_RATE);
+}
+
+/* run the task every 10ms until nothing is pending */
+static unsigned long test_drain(unsigned long limit)
+{
+    while (handler_who_is_pending() && (Test_Time < limit)) {
+        handler_who_is_task();
+        if (handler_who_is_pending()) {
+            Test_Time += 10;
+        }
+    }
+
+    return Test_Time;
+}
+
+static void test_dest(BACNET_ADDRESS *dest, uint8_t mac)
+{
+    memset(dest, 0, sizeof(*dest));
+    dest->mac_len = 1;
+    dest->mac[0] = mac;
+}
+
+/**
+ * @addtogroup bacnet_tests
+ * @{
+ */
+
+/**
+ * @brief Test that a burst of I-Am is spread over the window
+ */
+static void testWhoIsPacingWindow(void)
+{
+    unsigned i;
+
+    test_setup();
+    Test_Time = 1000;
+    for (i = 0; i < 100; i++) {
+        zassert_true(handler_who_is_i_am_queue(i, NULL), NULL);
+    }
+    zassert_equal(handler_who_is_pending(), 100, NULL);
+    /* the first I-Am goes out at once */
+    handler_who_is_task();
+    zassert_equal(Test_I_Am_Count, 1, NULL);
+    zassert_equal(Test_I_Am[0].index, 0, NULL);
+    zassert_equal(Test_I_Am[0].mac, 0, NULL);
+    /* the rest take most of the window, but not more */
+    test_drain(1000 + 1500);
+    zassert_not_equal(handler_who_is_pending(), 0, NULL);
+    test_drain(1000 + WHO_IS_I_AM_WINDOW);
+    zassert_equal(handler_who_is_pending(), 0, NULL);
+    zassert_equal(Test_I_Am_Count, 100, NULL);
+    for (i = 0; i < 100; i++) {
+        zassert_equal(Test_I_Am[i].index, i, NULL);
+    }
+    /* the current Device is restored */
+    zassert_equal(Test_Current_Index, 0, NULL);
+}
+
+/**
+ * @brief Test the token bucket at the datalink rate limit
+ */
+static void testWhoIsPacingRate(void)
+{
+    unsigned i;
+
+    test_setup();
+    handler_who_is_pacing_set(WHO_IS_I_AM_WINDOW, 10);
+    Test_Time = 5000;
+    for (i = 0; i < 100; i++) {
+        handler_who_is_i_am_queue(i, NULL);
+    }
+    handler_who_is_task();
+    zassert_equal(Test_I_Am_Count, 1, NULL);
+    /* not enough tokens for the next one */
+    Test_Time += 50;
+    handler_who_is_task();
+    zassert_equal(Test_I_Am_Count, 1, NULL);
+    Test_Time += 50;
+    handler_who_is_task();
+    zassert_equal(Test_I_Am_Count, 2, NULL);
+    /* 10 per second */
+    Test_Time += 1000;
+    handler_who_is_task();
+    zassert_equal(Test_I_Am_Count, 12, NULL);
+    /* a late task sends at most one batch */
+    Test_Time += 60000;
+    handler_who_is_task();
+    zassert_equal(Test_I_Am_Count, 12 + WHO_IS_I_AM_BATCH, NULL);
+    Test_Time += 60000;
+    handler_who_is_task();
+    Test_Time += 60000;
+    handler_who_is_task();
+    zassert_equal(handler_who_is_pending(), 0, NULL);
+    zassert_equal(Test_I_Am_Count, 100, NULL);
+    /* a new burst starts with a full token */
+    handler_who_is_i_am_queue(7, NULL);
+    handler_who_is_task();
+    zassert_equal(Test_I_Am_Count, 101, NULL);
+    zassert_equal(Test_I_Am[100].index, 7, NULL);
+}
+
+/**
+ * @brief Test that repeated Who-Is coalesce per destination
+ */
+static void testWhoIsCoalesce(void)
+{
+    BACNET_ADDRESS dest = { 0 };
+    unsigned count[4] = { 0 };
+    unsigned i;
+
+    test_setup();
+    Test_Time = 200000;
+    zassert_false(handler_who_is_i_am_queue(MAX_ROUTED_DEVICES, NULL), NULL);
+    test_dest(&dest, 1);
+    zassert_true(handler_who_is_i_am_queue(3, &dest), NULL);
+    zassert_true(handler_who_is_i_am_queue(3, &dest), NULL);
+    zassert_true(handler_who_is_i_am_queue(5, &dest), NULL);
+    zassert_equal(handler_who_is_pending(), 2, NULL);
+    test_dest(&dest, 2);
+    handler_who_is_i_am_queue(3, &dest);
+    handler_who_is_i_am_queue(3, NULL);
+    handler_who_is_i_am_queue(3, NULL);
+    zassert_equal(handler_who_is_pending(), 4, NULL);
+    test_drain(Test_Time + WHO_IS_I_AM_WINDOW);
+    zassert_equal(handler_who_is_pending(), 0, NULL);
+    zassert_equal(Test_I_Am_Count, 4, NULL);
+    for (i = 0; i < Test_I_Am_Count; i++) {
+        count[Test_I_Am[i].mac]++;
+        if (Test_I_Am[i].mac == 1) {
+            zassert_true((Test_I_Am[i].index == 3) ||
+                (Test_I_Am[i].index == 5), NULL);
+        } else {
+            zassert_equal(Test_I_Am[i].index, 3, NULL);
+        }
+    }
+    zassert_equal(count[0], 1, NULL);
+    zassert_equal(count[1], 2, NULL);
+    zassert_equal(count[2], 1, NULL);
+    /* a sent I-Am can be queued again */
+    test_dest(&dest, 1);
+    handler_who_is_i_am_queue(3, &dest);
+    zassert_equal(handler_who_is_pending(), 1, NULL);
+    test_drain(Test_Time + WHO_IS_I_AM_WINDOW);
+    zassert_equal(Test_I_Am_Count, 5, NULL);
+}
+
+/**
+ * @brief Test that too many clients share the broadcast I-Am
+ */
+static void testWhoIsCoalesceOverflow(void)
+{
+    BACNET_ADDRESS dest = { 0 };
+    unsigned broadcast = 0;
+    unsigned i;
+
+    test_setup();
+    Test_Time = 300000;
+    for (i = 1; i <= WHO_IS_I_AM_DEST_MAX + 2; i++) {
+        test_dest(&dest, i);
+        handler_who_is_i_am_queue(9, &dest);
+    }
+    /* the extra clients coalesce into one broadcast */
+    zassert_equal(handler_who_is_pending(), WHO_IS_I_AM_DEST_MAX + 1, NULL);
+    test_drain(Test_Time + WHO_IS_I_AM_WINDOW);
+    for (i = 0; i < Test_I_Am_Count; i++) {
+        if (Test_I_Am[i].mac == 0) {
+            broadcast++;
+        }
+    }
+    zassert_equal(broadcast, 1, NULL);
+    zassert_equal(Test_I_Am_Count, WHO_IS_I_AM_DEST_MAX + 1, NULL);
+}
+
+/**
+ * @brief Test the Who-Is handler of the current routed Device
+ */
+static void testWhoIsUnicastPaced(void)
+{
+    BACNET_ADDRESS src = { 0 };
+    uint8_t apdu[MAX_APDU] = { 0 };
+    int len;
+
+    test_setup();
+    Test_Time = 400000;
+    test_dest(&src, 4);
+    len = whois_encode_apdu(&apdu[0], 1010, 1020);
+    Test_Current_Index = 9;
+    handler_who_is_unicast_paced(&apdu[2], len - 2, &src);
+    zassert_equal(handler_who_is_pending(), 0, NULL);
+    Test_Current_Index = 12;
+    handler_who_is_unicast_paced(&apdu[2], len - 2, &src);
+    zassert_equal(handler_who_is_pending(), 1, NULL);
+    /* no limits */
+    Test_Current_Index = 30;
+    handler_who_is_unicast_paced(&apdu[2], 0, &src);
+    zassert_equal(handler_who_is_pending(), 2, NULL);
+    test_drain(Test_Time + WHO_IS_I_AM_WINDOW);
+    zassert_equal(Test_I_Am_Count, 2, NULL);
+    zassert_equal(Test_I_Am[0].index, 12, NULL);
+    zassert_equal(Test_I_Am[0].mac, 4, NULL);
+    zassert_equal(Test_I_Am[1].index, 30, NULL);
+}
+/**
+ * @}
+ */
+
+void test_main(void)
+{
+    ztest_test_suite(gw_whois_tests,
+     ztest_unit_test(testWhoIsPacingWindow),
+     ztest_unit_test(testWhoIsPacingRate),
+     ztest_unit_test(testWhoIsCoalesce),
+     ztest_unit_test(testWhoIsCoalesceOverflow),
+     ztest_unit_test(testWhoIsUnicastPaced)
+     );
+
+    ztest_run_test_suite(gw_whois_tests);
+}
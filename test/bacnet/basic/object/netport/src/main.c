@@ -11,6 +11,7 @@
 #include <ztest.h>
 #include <bacnet/readrange.h>
 #include <bacnet/basic/object/netport.h>
+#include <bacnet/datalink/dlmstp.h>
 
 /**
  * @addtogroup bacnet_tests
@@ -86,11 +87,99 @@ static void test_network_port(void)
             }
             pOptional++;
         }
+        while ((*pProprietary) != -1) {
+            rpdata.object_property = *pProprietary;
+            rpdata.array_index = BACNET_ARRAY_ALL;
+            len = Network_Port_Read_Property(&rpdata);
+            zassert_not_equal(len, BACNET_STATUS_ERROR, NULL);
+            if (len > 0) {
+                test_len = bacapp_decode_application_data(
+                    rpdata.application_data,
+                    (uint8_t)rpdata.application_data_len, &value);
+                zassert_true(test_len >= 0, NULL);
+            }
+            pProprietary++;
+        }
         port++;
     }
 
     return;
 }
+/**
+ * @brief Test the MS/TP adaptive Max_Info_Frames and datalink counters
+ */
+static void test_network_port_mstp_statistics(void)
+{
+    uint8_t apdu[MAX_APDU] = { 0 };
+    int len = 0;
+    BACNET_READ_PROPERTY_DATA rpdata = { 0 };
+    BACNET_WRITE_PROPERTY_DATA wpdata = { 0 };
+    BACNET_APPLICATION_DATA_VALUE value = { 0 };
+    DLMSTP_STATISTICS statistics = { 0 };
+    DLMSTP_STATISTICS test_statistics = { 0 };
+    uint32_t object_instance = 1234;
+    bool status = false;
+
+    status = Network_Port_Object_Instance_Number_Set(0, object_instance);
+    zassert_true(status, NULL);
+    status = Network_Port_Type_Set(object_instance, PORT_TYPE_BIP);
+    zassert_true(status, NULL);
+    status = Network_Port_MSTP_Statistics_Set(object_instance, &statistics);
+    zassert_false(status, NULL);
+    status = Network_Port_Type_Set(object_instance, PORT_TYPE_MSTP);
+    zassert_true(status, NULL);
+    statistics.transmit_queue_depth = 12;
+    statistics.transmit_queue_peak = 30;
+    statistics.transmit_queue_drop_counter = 2;
+    statistics.token_hold_counter = 100;
+    statistics.token_hold_frame_counter = 150;
+    statistics.token_hold_budget_counter = 200;
+    statistics.token_rotation_time = 85;
+    statistics.info_frames_budget = 16;
+    status = Network_Port_MSTP_Statistics_Set(object_instance, &statistics);
+    zassert_true(status, NULL);
+    status = Network_Port_MSTP_Statistics(object_instance, &test_statistics);
+    zassert_true(status, NULL);
+    zassert_equal(test_statistics.transmit_queue_peak, 30, NULL);
+    zassert_equal(test_statistics.info_frames_budget, 16, NULL);
+    rpdata.application_data = &apdu[0];
+    rpdata.application_data_len = sizeof(apdu);
+    rpdata.object_type = OBJECT_NETWORK_PORT;
+    rpdata.object_instance = object_instance;
+    rpdata.array_index = BACNET_ARRAY_ALL;
+    rpdata.object_property = PROP_MSTP_TRANSMIT_QUEUE_DROPS;
+    len = Network_Port_Read_Property(&rpdata);
+    zassert_true(len > 0, NULL);
+    len = bacapp_decode_application_data(apdu, len, &value);
+    zassert_true(len > 0, NULL);
+    zassert_equal(value.tag, BACNET_APPLICATION_TAG_UNSIGNED_INT, NULL);
+    zassert_equal(value.type.Unsigned_Int, 2, NULL);
+    rpdata.object_property = PROP_MSTP_TOKEN_UTILIZATION;
+    len = Network_Port_Read_Property(&rpdata);
+    zassert_true(len > 0, NULL);
+    len = bacapp_decode_application_data(apdu, len, &value);
+    zassert_true(len > 0, NULL);
+    zassert_equal(value.tag, BACNET_APPLICATION_TAG_REAL, NULL);
+    zassert_true(value.type.Real > 74.9f, NULL);
+    zassert_true(value.type.Real < 75.1f, NULL);
+    /* the adaptive limit is writable, the counters are not */
+    wpdata.object_type = OBJECT_NETWORK_PORT;
+    wpdata.object_instance = object_instance;
+    wpdata.array_index = BACNET_ARRAY_ALL;
+    wpdata.object_property = PROP_MSTP_MAX_INFO_FRAMES_ADAPTIVE;
+    value.tag = BACNET_APPLICATION_TAG_UNSIGNED_INT;
+    value.type.Unsigned_Int = 32;
+    wpdata.application_data_len =
+        bacapp_encode_application_data(wpdata.application_data, &value);
+    status = Network_Port_Write_Property(&wpdata);
+    zassert_true(status, NULL);
+    zassert_equal(
+        Network_Port_MSTP_Max_Info_Frames_Adaptive(object_instance), 32, NULL);
+    wpdata.object_property = PROP_MSTP_TRANSMIT_QUEUE_DEPTH;
+    status = Network_Port_Write_Property(&wpdata);
+    zassert_false(status, NULL);
+    zassert_equal(wpdata.error_code, ERROR_CODE_WRITE_ACCESS_DENIED, NULL);
+}
 /**
  * @}
  */
@@ -99,7 +188,8 @@ static void test_network_port(void)
 void test_main(void)
 {
     ztest_test_suite(netport_tests,
-     ztest_unit_test(test_network_port)
+     ztest_unit_test(test_network_port),
+     ztest_unit_test(test_network_port_mstp_statistics)
      );
 
     ztest_run_test_suite(netport_tests);
@@ -9,6 +9,7 @@
  */
 
 #include <limits.h>
+#include <string.h>
 #include <ztest.h>
 #include <bacnet/basic/sys/fifo.h>
 
@@ -123,6 +124,27 @@ static void testFIFOBuffer(void)
         zassert_equal(test_add_data[0], add_data[index], NULL);
     }
     zassert_true(FIFO_Empty(&test_buffer), NULL);
+    /* test Peek Ahead across the end of the ring */
+    status = FIFO_Add(&test_buffer, add_data, sizeof(add_data));
+    zassert_true(status, NULL);
+    memset(test_add_data, 0, sizeof(test_add_data));
+    count = FIFO_Peek_Ahead(&test_buffer, &test_add_data[0], 10);
+    zassert_equal(count, 10, NULL);
+    zassert_equal(FIFO_Count(&test_buffer), sizeof(add_data), NULL);
+    for (index = 0; index < count; index++) {
+        zassert_equal(test_add_data[index], add_data[index], NULL);
+    }
+    count = FIFO_Pull(&test_buffer, NULL, 10);
+    zassert_equal(count, 10, NULL);
+    count = FIFO_Peek_Ahead(&test_buffer, &test_add_data[0],
+        sizeof(test_add_data));
+    zassert_equal(count, sizeof(add_data) - 10, NULL);
+    for (index = 0; index < count; index++) {
+        zassert_equal(test_add_data[index], add_data[index + 10], NULL);
+    }
+    count = FIFO_Pull(&test_buffer, NULL, sizeof(test_add_data));
+    zassert_equal(count, sizeof(add_data) - 10, NULL);
+    zassert_true(FIFO_Empty(&test_buffer), NULL);
     /* test flush */
     status = FIFO_Add(&test_buffer, test_add_data, sizeof(test_add_data));
     zassert_true(status, NULL);
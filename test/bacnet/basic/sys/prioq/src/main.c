@@ -0,0 +1,167 @@
+/*
+ * Copyright (c) 2026 Legrand North America, LLC.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+/* @file
+ * @brief test priority transmit queue APIs
+ */
+
+#include <ztest.h>
+#include <bacnet/bacenum.h>
+#include <bacnet/basic/sys/prioq.h>
+
+/**
+ * @addtogroup bacnet_tests
+ * @{
+ */
+
+static int testPrioqPut(PRIOQ *q, uint8_t priority, uint32_t now)
+{
+    int slot;
+    bool evicted = true;
+
+    slot = Prioq_Reserve(q, priority, &evicted);
+    if (slot >= 0) {
+        Prioq_Put(q, (unsigned)slot, priority, now);
+    }
+
+    return slot;
+}
+
+static int testPrioqGet(PRIOQ *q, uint32_t now)
+{
+    int slot;
+
+    slot = Prioq_Peek(q, now);
+    if (slot >= 0) {
+        Prioq_Remove(q, (unsigned)slot, now);
+    }
+
+    return slot;
+}
+
+/**
+ * @brief Test strict priority and FIFO order within a class
+ */
+static void testPrioqStrict(void)
+{
+    PRIOQ q;
+    struct prioq_slot slots[8];
+    int a, b, c, d;
+    const PRIOQ_STATS *stats;
+
+    zassert_false(Prioq_Init(&q, slots, 0, 0), NULL);
+    zassert_true(Prioq_Init(&q, slots, 8, 0), NULL);
+    zassert_true(Prioq_Empty(&q), NULL);
+    zassert_equal(Prioq_Peek(&q, 0), -1, NULL);
+    a = testPrioqPut(&q, MESSAGE_PRIORITY_NORMAL, 0);
+    b = testPrioqPut(&q, MESSAGE_PRIORITY_NORMAL, 1);
+    c = testPrioqPut(&q, MESSAGE_PRIORITY_LIFE_SAFETY, 2);
+    d = testPrioqPut(&q, MESSAGE_PRIORITY_URGENT, 3);
+    zassert_equal(Prioq_Count(&q), 4, NULL);
+    /* waiting does not matter without aging */
+    zassert_equal(testPrioqGet(&q, 100000), c, NULL);
+    zassert_equal(testPrioqGet(&q, 100000), d, NULL);
+    zassert_equal(testPrioqGet(&q, 100000), a, NULL);
+    zassert_equal(testPrioqGet(&q, 100000), b, NULL);
+    zassert_true(Prioq_Empty(&q), NULL);
+    stats = Prioq_Stats(&q, MESSAGE_PRIORITY_NORMAL);
+    zassert_not_null(stats, NULL);
+    zassert_equal(stats->queued, 2, NULL);
+    zassert_equal(stats->sent, 2, NULL);
+    zassert_equal(stats->depth, 0, NULL);
+    zassert_equal(stats->depth_max, 2, NULL);
+    zassert_equal(stats->latency_max, 100000, NULL);
+    zassert_equal(stats->latency_total, 199999, NULL);
+    zassert_is_null(Prioq_Stats(&q, PRIOQ_CLASSES), NULL);
+}
+
+/**
+ * @brief Test that a waiting PDU gains one class per aging time
+ */
+static void testPrioqAging(void)
+{
+    PRIOQ q;
+    struct prioq_slot slots[8];
+    int a, b, c;
+
+    zassert_true(Prioq_Init(&q, slots, 8, 100), NULL);
+    a = testPrioqPut(&q, MESSAGE_PRIORITY_NORMAL, 0);
+    b = testPrioqPut(&q, MESSAGE_PRIORITY_URGENT, 100);
+    c = testPrioqPut(&q, MESSAGE_PRIORITY_URGENT, 101);
+    /* urgent queued one aging time later: a tie goes to the higher class */
+    zassert_equal(Prioq_Peek(&q, 100), b, NULL);
+    zassert_equal(testPrioqGet(&q, 150), b, NULL);
+    /* urgent queued more than one aging time later */
+    zassert_equal(testPrioqGet(&q, 200), a, NULL);
+    zassert_equal(testPrioqGet(&q, 200), c, NULL);
+    a = testPrioqPut(&q, MESSAGE_PRIORITY_NORMAL, 200);
+    b = testPrioqPut(&q, MESSAGE_PRIORITY_CRITICAL_EQUIPMENT, 350);
+    /* two classes need two aging times */
+    zassert_equal(testPrioqGet(&q, 400), b, NULL);
+    zassert_equal(testPrioqGet(&q, 400), a, NULL);
+    /* timestamps that wrap around */
+    a = testPrioqPut(&q, MESSAGE_PRIORITY_NORMAL, UINT32_MAX - 200);
+    b = testPrioqPut(&q, MESSAGE_PRIORITY_URGENT, UINT32_MAX - 10);
+    zassert_equal(testPrioqGet(&q, 10), a, NULL);
+    zassert_equal(testPrioqGet(&q, 10), b, NULL);
+}
+
+/**
+ * @brief Test that a full queue evicts the newest lower priority PDU
+ */
+static void testPrioqFull(void)
+{
+    PRIOQ q;
+    struct prioq_slot slots[3];
+    int a, b, c, d, e;
+    bool evicted = false;
+
+    zassert_true(Prioq_Init(&q, slots, 3, 0), NULL);
+    a = testPrioqPut(&q, MESSAGE_PRIORITY_NORMAL, 0);
+    b = testPrioqPut(&q, MESSAGE_PRIORITY_NORMAL, 0);
+    c = testPrioqPut(&q, MESSAGE_PRIORITY_URGENT, 0);
+    zassert_true(c >= 0, NULL);
+    /* no lower class to evict */
+    zassert_equal(Prioq_Reserve(&q, MESSAGE_PRIORITY_NORMAL, &evicted), -1,
+        NULL);
+    zassert_false(evicted, NULL);
+    zassert_equal(
+        Prioq_Stats(&q, MESSAGE_PRIORITY_NORMAL)->dropped, 1, NULL);
+    /* the newest normal PDU makes room */
+    d = Prioq_Reserve(&q, MESSAGE_PRIORITY_LIFE_SAFETY, &evicted);
+    zassert_equal(d, b, NULL);
+    zassert_true(evicted, NULL);
+    zassert_equal(Prioq_Count(&q), 2, NULL);
+    zassert_equal(
+        Prioq_Stats(&q, MESSAGE_PRIORITY_NORMAL)->dropped, 2, NULL);
+    Prioq_Put(&q, (unsigned)d, MESSAGE_PRIORITY_LIFE_SAFETY, 0);
+    /* a reserved slot can be given back */
+    e = Prioq_Reserve(&q, MESSAGE_PRIORITY_LIFE_SAFETY, &evicted);
+    zassert_equal(e, a, NULL);
+    Prioq_Release(&q, (unsigned)e);
+    zassert_equal(Prioq_Count(&q), 2, NULL);
+    /* a reply sent out of turn */
+    Prioq_Remove(&q, (unsigned)c, 5);
+    zassert_equal(testPrioqGet(&q, 5), d, NULL);
+    zassert_true(Prioq_Empty(&q), NULL);
+    Prioq_Stats_Reset(&q);
+    zassert_equal(
+        Prioq_Stats(&q, MESSAGE_PRIORITY_NORMAL)->dropped, 0, NULL);
+}
+/**
+ * @}
+ */
+
+void test_main(void)
+{
+    ztest_test_suite(prioq_tests,
+     ztest_unit_test(testPrioqStrict),
+     ztest_unit_test(testPrioqAging),
+     ztest_unit_test(testPrioqFull)
+     );
+
+    ztest_run_test_suite(prioq_tests);
+}
@@ -47,6 +47,44 @@ static void test_COBS_Encode_Decode(void)
     zassert_true(test_buffer_length == sizeof(buffer),
         "COBS encode/decode length fail");
 }
+
+/**
+ * @brief Test the buffer CRC-32K against the per-octet CRC-32K
+ */
+static void test_COBS_CRC32K_Buffer(void)
+{
+    uint8_t buffer[64] = { 0 };
+    uint32_t crc32k, crc32k_buffer;
+    unsigned i, offset, length;
+
+    /* every octet value at every slice position */
+    for (offset = 0; offset < 8; offset++) {
+        for (i = 0; i < 256; i++) {
+            memset(buffer, 0, sizeof(buffer));
+            buffer[offset] = (uint8_t)i;
+            crc32k = 0;
+            for (length = 0; length < 8; length++) {
+                crc32k = cobs_crc32k(buffer[length], crc32k);
+            }
+            zassert_equal(cobs_crc32k_buffer(buffer, 8, 0), crc32k, NULL);
+        }
+    }
+    /* every length and alignment */
+    for (i = 0; i < sizeof(buffer); i++) {
+        buffer[i] = (uint8_t)(i * 37 + 0x55);
+    }
+    for (offset = 0; offset < 8; offset++) {
+        for (length = 0; length <= (sizeof(buffer) - offset); length++) {
+            crc32k = 0xFFFFFFFF;
+            for (i = 0; i < length; i++) {
+                crc32k = cobs_crc32k(buffer[offset + i], crc32k);
+            }
+            crc32k_buffer =
+                cobs_crc32k_buffer(&buffer[offset], length, 0xFFFFFFFF);
+            zassert_equal(crc32k_buffer, crc32k, NULL);
+        }
+    }
+}
 /**
  * @}
  */
@@ -55,7 +93,8 @@ static void test_COBS_Encode_Decode(void)
 void test_main(void)
 {
     ztest_test_suite(cobs_tests,
-     ztest_unit_test(test_COBS_Encode_Decode)
+     ztest_unit_test(test_COBS_Encode_Decode),
+     ztest_unit_test(test_COBS_CRC32K_Buffer)
      );
 
     ztest_run_test_suite(cobs_tests);
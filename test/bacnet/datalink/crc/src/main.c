@@ -115,6 +115,52 @@ static void testCRC16CreateTable(void)
     }
     printf("};\n");
 }
+
+/**
+ * @brief Test the buffer CRC16 against the per-octet CRC16
+ */
+static void testCRC16Buffer(void)
+{
+    uint8_t buffer[64] = { 0 };
+    uint16_t crc16, crc16_buffer;
+    unsigned i, offset, length;
+
+    /* every octet value at every slice position */
+    for (offset = 0; offset < 8; offset++) {
+        for (i = 0; i < 256; i++) {
+            memset(buffer, 0, sizeof(buffer));
+            buffer[offset] = (uint8_t)i;
+            crc16 = 0;
+            for (length = 0; length < 8; length++) {
+                crc16 = CRC_Calc_Data(buffer[length], crc16);
+            }
+            zassert_equal(CRC_Calc_Data_Buffer(buffer, 8, 0), crc16, NULL);
+        }
+    }
+    /* every length and alignment */
+    for (i = 0; i < sizeof(buffer); i++) {
+        buffer[i] = (uint8_t)(i * 37 + 0x55);
+    }
+    for (offset = 0; offset < 8; offset++) {
+        for (length = 0; length <= (sizeof(buffer) - offset); length++) {
+            crc16 = 0xFFFF;
+            for (i = 0; i < length; i++) {
+                crc16 = CRC_Calc_Data(buffer[offset + i], crc16);
+            }
+            crc16_buffer =
+                CRC_Calc_Data_Buffer(&buffer[offset], length, 0xFFFF);
+            zassert_equal(crc16_buffer, crc16, NULL);
+        }
+    }
+    /* Annex G example: 01 22 30 then the CRC gives the residue */
+    buffer[0] = 0x01;
+    buffer[1] = 0x22;
+    buffer[2] = 0x30;
+    crc16 = ~CRC_Calc_Data_Buffer(buffer, 3, 0xFFFF);
+    buffer[3] = crc16 & 0xFF;
+    buffer[4] = crc16 >> 8;
+    zassert_equal(CRC_Calc_Data_Buffer(buffer, 5, 0xFFFF), 0xF0B8, NULL);
+}
 /**
  * @}
  */
@@ -126,7 +172,8 @@ void test_main(void)
      ztest_unit_test(testCRC8),
      ztest_unit_test(testCRC16),
      ztest_unit_test(testCRC8CreateTable),
-     ztest_unit_test(testCRC16CreateTable)
+     ztest_unit_test(testCRC16CreateTable),
+     ztest_unit_test(testCRC16Buffer)
      );
 
     ztest_run_test_suite(crc_tests);
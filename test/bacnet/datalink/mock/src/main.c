@@ -422,6 +422,105 @@ static void test_datalink_ethernet(void)
     datalink_maintenance_timer(42);
 }
 
+static void test_datalink_ports(void)
+{
+    char *iface = "bla-bla-bla";
+    char *iface2 = "/dev/bla-bla";
+    uint8_t expected_data[] = { 0x5A, 0xA5, 0xDE, 0xAD };
+    uint8_t data[] = { 0xFF, 0xFF, 0xFF, 0xFF };
+    BACNET_ADDRESS addr = { 0 };
+    BACNET_ADDRESS router = {
+        .mac_len = 1,
+        .mac = { 0x7F },
+    };
+    BACNET_ADDRESS addr2 = { 0 };
+    uint16_t net_list[4] = { 0 };
+    unsigned port = 0;
+
+    zassert_equal(z_cleanup_mock(), 0, NULL);
+    zassert_equal(datalink_port_count(), 0, NULL);
+
+    // add
+    ztest_expect_value(bip_init, ifname, iface);
+    ztest_returns_value(bip_init, true);
+    zassert_equal(datalink_port_add("bip", iface, 1), 0, NULL);
+    zassert_equal(z_cleanup_mock(), 0, NULL);
+    ztest_expect_value(dlmstp_init, ifname, iface2);
+    ztest_returns_value(dlmstp_init, true);
+    zassert_equal(datalink_port_add("mstp", iface2, 2), 1, NULL);
+    zassert_equal(z_cleanup_mock(), 0, NULL);
+    // one port per datalink type and per network
+    zassert_equal(datalink_port_add("bip", iface, 3), DATALINK_PORT_NONE,
+        NULL);
+    zassert_equal(datalink_port_add("bip6", iface, 2), DATALINK_PORT_NONE,
+        NULL);
+    zassert_equal(datalink_port_add("ethernet", iface, 0),
+        DATALINK_PORT_NONE, NULL);
+    zassert_equal(datalink_port_add("bla-bla", iface, 4),
+        DATALINK_PORT_NONE, NULL);
+    ztest_expect_value(ethernet_init, interface_name, iface);
+    ztest_returns_value(ethernet_init, false);
+    zassert_equal(datalink_port_add("ethernet", iface, 4),
+        DATALINK_PORT_NONE, NULL);
+    zassert_equal(z_cleanup_mock(), 0, NULL);
+    zassert_equal(datalink_port_count(), 2, NULL);
+    zassert_equal(datalink_port_network(0), 1, NULL);
+    zassert_equal(datalink_port_network(1), 2, NULL);
+    zassert_equal(datalink_port_network(2), 0, NULL);
+    zassert_equal(datalink_port_type(0), PORT_TYPE_BIP, NULL);
+    zassert_equal(datalink_port_type(1), PORT_TYPE_MSTP, NULL);
+
+    // routes
+    zassert_equal(datalink_port_route_find(2, NULL), 1, NULL);
+    zassert_equal(datalink_port_route_find(5, NULL), DATALINK_PORT_NONE,
+        NULL);
+    datalink_port_route_add(1, 1, &router);
+    datalink_port_route_add(1, 5, &router);
+    router.mac[0] = 0x10;
+    datalink_port_route_add(0, 6, &router);
+    zassert_equal(datalink_port_route_find(1, &addr2), 0, NULL);
+    zassert_equal(addr2.mac_len, 0, NULL);
+    zassert_equal(datalink_port_route_find(5, &addr2), 1, NULL);
+    zassert_equal(addr2.mac_len, 1, NULL);
+    zassert_equal(addr2.mac[0], 0x7F, NULL);
+    zassert_equal(datalink_port_route_list(0, net_list, 4), 2, NULL);
+    zassert_equal(net_list[0], 2, NULL);
+    zassert_equal(net_list[1], 5, NULL);
+    zassert_equal(datalink_port_route_list(1, net_list, 4), 2, NULL);
+    zassert_equal(net_list[0], 1, NULL);
+    zassert_equal(net_list[1], 6, NULL);
+    zassert_equal(datalink_port_route_list(1, net_list, 1), 1, NULL);
+
+    // receive from any port
+    ztest_expect_value(bip_receive, src, &addr);
+    ztest_expect_value(bip_receive, timeout, 0);
+    ztest_expect_data(bip_receive, pdu, expected_data);
+    ztest_returns_value(bip_receive, 0);
+    ztest_expect_value(dlmstp_receive, src, &addr);
+    ztest_expect_value(dlmstp_receive, timeout, 0);
+    ztest_expect_data(dlmstp_receive, pdu, expected_data);
+    ztest_returns_value(dlmstp_receive, 4);
+    zassert_equal(datalink_port_receive(&port, &addr, data, sizeof(data), 0),
+        4, NULL);
+    zassert_equal(port, 1, NULL);
+    zassert_mem_equal(expected_data, data, sizeof(data), NULL);
+    zassert_equal(z_cleanup_mock(), 0, NULL);
+
+    // the port after the last PDU is polled first
+    ztest_expect_value(bip_receive, src, &addr);
+    ztest_expect_value(bip_receive, timeout, 0);
+    ztest_expect_data(bip_receive, pdu, expected_data);
+    ztest_returns_value(bip_receive, 4);
+    zassert_equal(datalink_port_receive(&port, &addr, data, sizeof(data), 0),
+        4, NULL);
+    zassert_equal(port, 0, NULL);
+    zassert_equal(z_cleanup_mock(), 0, NULL);
+
+    datalink_cleanup();
+    zassert_equal(datalink_port_count(), 0, NULL);
+    zassert_equal(datalink_port_route_find(5, NULL), DATALINK_PORT_NONE,
+        NULL);
+}
 
 /**
  * @}
@@ -434,7 +533,8 @@ void test_main(void)
      ztest_unit_test(test_datalink_bip),
      ztest_unit_test(test_datalink_bip6),
      ztest_unit_test(test_datalink_dlmstp),
-     ztest_unit_test(test_datalink_ethernet)
+     ztest_unit_test(test_datalink_ethernet),
+     ztest_unit_test(test_datalink_ports)
      );
 
     ztest_run_test_suite(datalink_tests);
@@ -0,0 +1,333 @@
+/*
+ * Copyright (c) 2026 Legrand North America, LLC.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+/* @file
+ * @brief test the MS/TP receive state machine with a buffer of octets
+ */
+
+#include <string.h>
+#include <ztest.h>
+#include <bacnet/datalink/mstp.h>
+#include <bacnet/datalink/mstpdef.h>
+#include "rs485.h"
+
+#define TEST_STATION 0x05
+#define TEST_OTHER_STATION 0x09
+#define TEST_SOURCE 0x07
+/* room for an extended frame */
+#define TEST_MPDU_MAX 2048
+
+/* one port is fed an octet at a time, the other a buffer at a time */
+static volatile struct mstp_port_struct_t Test_Port_Octet;
+static volatile struct mstp_port_struct_t Test_Port_Buffer;
+static uint8_t Test_Input_Octet[TEST_MPDU_MAX];
+static uint8_t Test_Input_Buffer[TEST_MPDU_MAX];
+static uint8_t Test_Output[TEST_MPDU_MAX];
+static uint8_t Test_Stream[TEST_MPDU_MAX * 2];
+
+void RS485_Send_Frame(
+    volatile struct mstp_port_struct_t *mstp_port,
+    uint8_t *buffer,
+    uint16_t nbytes)
+{
+    (void)mstp_port;
+    (void)buffer;
+    (void)nbytes;
+}
+
+uint16_t MSTP_Put_Receive(volatile struct mstp_port_struct_t *mstp_port)
+{
+    (void)mstp_port;
+    return 0;
+}
+
+uint16_t MSTP_Get_Send(
+    volatile struct mstp_port_struct_t *mstp_port, unsigned timeout)
+{
+    (void)mstp_port;
+    (void)timeout;
+    return 0;
+}
+
+uint16_t MSTP_Get_Reply(
+    volatile struct mstp_port_struct_t *mstp_port, unsigned timeout)
+{
+    (void)mstp_port;
+    (void)timeout;
+    return 0;
+}
+
+/* the octets arrive without gaps, so the silence timer never expires */
+static uint32_t test_silence_timer(void *pArg)
+{
+    (void)pArg;
+    return 0;
+}
+
+static void test_silence_timer_reset(void *pArg)
+{
+    (void)pArg;
+}
+
+static void test_port_init(volatile struct mstp_port_struct_t *mstp_port,
+    uint8_t *input_buffer,
+    uint16_t input_buffer_size)
+{
+    memset((void *)mstp_port, 0, sizeof(*mstp_port));
+    mstp_port->InputBuffer = input_buffer;
+    mstp_port->InputBufferSize = input_buffer_size;
+    mstp_port->OutputBuffer = Test_Output;
+    mstp_port->OutputBufferSize = sizeof(Test_Output);
+    mstp_port->This_Station = TEST_STATION;
+    mstp_port->Nmax_info_frames = 1;
+    mstp_port->Nmax_master = 127;
+    mstp_port->SilenceTimer = test_silence_timer;
+    mstp_port->SilenceTimerReset = test_silence_timer_reset;
+    MSTP_Init(mstp_port);
+    memset(input_buffer, 0, input_buffer_size);
+}
+
+static void test_ports_init(void)
+{
+    test_port_init(
+        &Test_Port_Octet, Test_Input_Octet, sizeof(Test_Input_Octet));
+    test_port_init(
+        &Test_Port_Buffer, Test_Input_Buffer, sizeof(Test_Input_Buffer));
+}
+
+/**
+ * @brief Feed octets through DataRegister and DataAvailable, one at a
+ *  time, stopping when a frame is indicated as the buffer receive does
+ * @return number of octets consumed
+ */
+static uint16_t test_receive_octets(
+    volatile struct mstp_port_struct_t *mstp_port,
+    const uint8_t *data,
+    uint16_t data_len)
+{
+    uint16_t index = 0;
+
+    if (!mstp_port->DataAvailable) {
+        MSTP_Receive_Frame_FSM(mstp_port);
+    }
+    while ((index < data_len) && !mstp_port->ReceivedValidFrame &&
+        !mstp_port->ReceivedInvalidFrame && !mstp_port->ReceiveError) {
+        mstp_port->DataRegister = data[index];
+        mstp_port->DataAvailable = true;
+        MSTP_Receive_Frame_FSM(mstp_port);
+        index++;
+    }
+
+    return index;
+}
+
+/**
+ * @brief Feed the same octets to both ports and check that the octet
+ *  and buffer receive leave them in the same state
+ * @return number of octets consumed
+ */
+static uint16_t test_receive(const uint8_t *data, uint16_t data_len)
+{
+    uint16_t octet_len = 0;
+    uint16_t buffer_len = 0;
+
+    octet_len = test_receive_octets(&Test_Port_Octet, data, data_len);
+    buffer_len = MSTP_Receive_Frame_Buffer(&Test_Port_Buffer, data, data_len);
+    zassert_equal(octet_len, buffer_len, NULL);
+    zassert_equal(Test_Port_Octet.ReceivedValidFrame,
+        Test_Port_Buffer.ReceivedValidFrame, NULL);
+    zassert_equal(Test_Port_Octet.ReceivedInvalidFrame,
+        Test_Port_Buffer.ReceivedInvalidFrame, NULL);
+    zassert_equal(Test_Port_Octet.ReceivedValidFrameNotForUs,
+        Test_Port_Buffer.ReceivedValidFrameNotForUs, NULL);
+    zassert_equal(
+        Test_Port_Octet.receive_state, Test_Port_Buffer.receive_state, NULL);
+    zassert_equal(Test_Port_Octet.FrameType, Test_Port_Buffer.FrameType, NULL);
+    zassert_equal(Test_Port_Octet.DestinationAddress,
+        Test_Port_Buffer.DestinationAddress, NULL);
+    zassert_equal(
+        Test_Port_Octet.SourceAddress, Test_Port_Buffer.SourceAddress, NULL);
+    zassert_equal(
+        Test_Port_Octet.DataLength, Test_Port_Buffer.DataLength, NULL);
+    zassert_equal(Test_Port_Octet.DataCRC, Test_Port_Buffer.DataCRC, NULL);
+    zassert_equal(Test_Port_Octet.HeaderCRC, Test_Port_Buffer.HeaderCRC, NULL);
+    zassert_equal(Test_Port_Octet.Index, Test_Port_Buffer.Index, NULL);
+    zassert_equal(
+        Test_Port_Octet.EventCount, Test_Port_Buffer.EventCount, NULL);
+    zassert_mem_equal(
+        Test_Input_Octet, Test_Input_Buffer, sizeof(Test_Input_Octet), NULL);
+
+    return buffer_len;
+}
+
+/**
+ * @brief Clear the frame indications, as the Master Node FSM would
+ */
+static void test_receive_clear(void)
+{
+    Test_Port_Octet.ReceivedValidFrame = false;
+    Test_Port_Octet.ReceivedInvalidFrame = false;
+    Test_Port_Octet.ReceivedValidFrameNotForUs = false;
+    Test_Port_Buffer.ReceivedValidFrame = false;
+    Test_Port_Buffer.ReceivedInvalidFrame = false;
+    Test_Port_Buffer.ReceivedValidFrameNotForUs = false;
+}
+
+/**
+ * @brief Build a frame with some octets of line noise in front of it
+ * @return length of the stream
+ */
+static uint16_t test_stream(uint8_t *buffer,
+    uint16_t buffer_len,
+    uint8_t frame_type,
+    uint8_t destination,
+    uint16_t data_len)
+{
+    uint8_t data[TEST_MPDU_MAX] = { 0 };
+    uint16_t len = 0;
+    uint16_t i = 0;
+
+    for (i = 0; i < data_len; i++) {
+        /* include preamble octets in the data */
+        data[i] = (i % 3) ? (uint8_t)i : 0x55;
+    }
+    buffer[0] = 0x00;
+    buffer[1] = 0xFF;
+    buffer[2] = 0x12;
+    len = MSTP_Create_Frame(&buffer[3], buffer_len - 3, frame_type,
+        destination, TEST_SOURCE, data, data_len);
+    zassert_not_equal(len, 0, NULL);
+
+    return len + 3;
+}
+
+/**
+ * @addtogroup bacnet_tests
+ * @{
+ */
+
+/**
+ * @brief Test a valid data frame, a frame without data, and an extended
+ *  frame received in one buffer each
+ */
+static void test_mstp_receive_valid(void)
+{
+    uint16_t len = 0;
+
+    test_ports_init();
+    len = test_stream(Test_Stream, sizeof(Test_Stream),
+        FRAME_TYPE_BACNET_DATA_NOT_EXPECTING_REPLY, TEST_STATION, 50);
+    zassert_equal(test_receive(Test_Stream, len), len, NULL);
+    zassert_true(Test_Port_Buffer.ReceivedValidFrame, NULL);
+    zassert_equal(Test_Port_Buffer.DataLength, 50, NULL);
+    zassert_equal(Test_Port_Buffer.SourceAddress, TEST_SOURCE, NULL);
+    test_receive_clear();
+    len = test_stream(
+        Test_Stream, sizeof(Test_Stream), FRAME_TYPE_TOKEN, TEST_STATION, 0);
+    zassert_equal(test_receive(Test_Stream, len), len, NULL);
+    zassert_true(Test_Port_Buffer.ReceivedValidFrame, NULL);
+    zassert_equal(Test_Port_Buffer.FrameType, FRAME_TYPE_TOKEN, NULL);
+    test_receive_clear();
+    len = test_stream(Test_Stream, sizeof(Test_Stream),
+        FRAME_TYPE_BACNET_DATA_NOT_EXPECTING_REPLY, TEST_STATION, 600);
+    zassert_equal(test_receive(Test_Stream, len), len, NULL);
+    zassert_true(Test_Port_Buffer.ReceivedValidFrame, NULL);
+    zassert_equal(Test_Port_Buffer.FrameType,
+        FRAME_TYPE_BACNET_EXTENDED_DATA_NOT_EXPECTING_REPLY, NULL);
+    zassert_equal(Test_Port_Buffer.DataLength, 600, NULL);
+}
+
+/**
+ * @brief Test a frame with a bad header CRC and a frame with a bad
+ *  data CRC, each followed by a valid frame
+ */
+static void test_mstp_receive_bad_crc(void)
+{
+    uint16_t len = 0;
+    uint16_t offset = 0;
+
+    test_ports_init();
+    len = test_stream(Test_Stream, sizeof(Test_Stream),
+        FRAME_TYPE_BACNET_DATA_NOT_EXPECTING_REPLY, TEST_STATION, 40);
+    /* header CRC follows the noise, the preamble and five header octets */
+    Test_Stream[3 + 7] ^= 0x01;
+    offset = test_receive(Test_Stream, len);
+    zassert_true(Test_Port_Buffer.ReceivedInvalidFrame, NULL);
+    zassert_equal(offset, 3 + 8, NULL);
+    test_receive_clear();
+    /* the rest of the frame is noise until the next preamble */
+    test_receive(&Test_Stream[offset], len - offset);
+    zassert_false(Test_Port_Buffer.ReceivedValidFrame, NULL);
+    test_receive_clear();
+    len = test_stream(Test_Stream, sizeof(Test_Stream),
+        FRAME_TYPE_BACNET_DATA_NOT_EXPECTING_REPLY, TEST_STATION, 40);
+    Test_Stream[len - 1] ^= 0x01;
+    zassert_equal(test_receive(Test_Stream, len), len, NULL);
+    zassert_true(Test_Port_Buffer.ReceivedInvalidFrame, NULL);
+    test_receive_clear();
+    len = test_stream(Test_Stream, sizeof(Test_Stream),
+        FRAME_TYPE_BACNET_DATA_NOT_EXPECTING_REPLY, TEST_STATION, 40);
+    zassert_equal(test_receive(Test_Stream, len), len, NULL);
+    zassert_true(Test_Port_Buffer.ReceivedValidFrame, NULL);
+}
+
+/**
+ * @brief Test a frame split across two receive calls at every octet
+ */
+static void test_mstp_receive_split(void)
+{
+    uint16_t len = 0;
+    uint16_t split = 0;
+    uint16_t offset = 0;
+
+    len = test_stream(Test_Stream, sizeof(Test_Stream),
+        FRAME_TYPE_BACNET_DATA_EXPECTING_REPLY, TEST_STATION, 30);
+    for (split = 1; split < len; split++) {
+        test_ports_init();
+        offset = test_receive(Test_Stream, split);
+        zassert_equal(offset, split, NULL);
+        zassert_false(Test_Port_Buffer.ReceivedValidFrame, NULL);
+        offset += test_receive(&Test_Stream[split], len - split);
+        zassert_equal(offset, len, NULL);
+        zassert_true(Test_Port_Buffer.ReceivedValidFrame, NULL);
+        zassert_equal(Test_Port_Buffer.DataLength, 30, NULL);
+    }
+}
+
+/**
+ * @brief Test that a frame for another station is skipped without
+ *  stopping, and the frame for this station after it is received
+ */
+static void test_mstp_receive_not_for_us(void)
+{
+    uint16_t len = 0;
+
+    test_ports_init();
+    len = test_stream(Test_Stream, sizeof(Test_Stream),
+        FRAME_TYPE_BACNET_DATA_NOT_EXPECTING_REPLY, TEST_OTHER_STATION, 20);
+    len += test_stream(&Test_Stream[len], sizeof(Test_Stream) - len,
+        FRAME_TYPE_BACNET_DATA_NOT_EXPECTING_REPLY, TEST_STATION, 25);
+    zassert_equal(test_receive(Test_Stream, len), len, NULL);
+    zassert_true(Test_Port_Buffer.ReceivedValidFrameNotForUs, NULL);
+    zassert_true(Test_Port_Buffer.ReceivedValidFrame, NULL);
+    zassert_equal(Test_Port_Buffer.DestinationAddress, TEST_STATION, NULL);
+    zassert_equal(Test_Port_Buffer.DataLength, 25, NULL);
+}
+/**
+ * @}
+ */
+
+void test_main(void)
+{
+    ztest_test_suite(mstp_tests,
+     ztest_unit_test(test_mstp_receive_valid),
+     ztest_unit_test(test_mstp_receive_bad_crc),
+     ztest_unit_test(test_mstp_receive_split),
+     ztest_unit_test(test_mstp_receive_not_for_us)
+     );
+
+    ztest_run_test_suite(mstp_tests);
+}
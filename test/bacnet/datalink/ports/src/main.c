@@ -0,0 +1,636 @@
+/*
+ * Copyright (c) 2026 Legrand North America, LLC.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+/* @file
+ * @brief test BACnet datalink ports routed in one process
+ */
+
+#include <string.h>
+#include <ztest.h>
+#include <bacnet/npdu.h>
+#include <bacnet/bacdcode.h>
+#include <bacnet/datalink/datalink.h>
+#include <bacnet/datalink/mstpdef.h>
+#include <bacnet/basic/object/device.h>
+#include <bacnet/basic/services.h>
+
+/* datalink types of the stub ports */
+#define TEST_BIP 1
+#define TEST_MSTP 2
+
+/* a frame sent or to be received on a stub datalink */
+struct test_frame {
+    unsigned transport;
+    BACNET_ADDRESS addr;
+    uint8_t pdu[MAX_MPDU];
+    uint16_t pdu_len;
+};
+static struct test_frame Test_Tx[8];
+static unsigned Test_Tx_Count;
+static struct test_frame Test_Rx[3];
+static unsigned Test_Apdu_Count;
+static BACNET_ADDRESS Test_Apdu_Src;
+static unsigned Test_Reject_Count;
+
+static const uint8_t Test_BIP_MAC[6] = { 10, 0, 0, 1, 0xBA, 0xC0 };
+static const uint8_t Test_BIP_Broadcast_MAC[6] = { 10, 0, 0, 255, 0xBA,
+    0xC0 };
+static const uint8_t Test_BIP_Station_MAC[6] = { 10, 0, 0, 9, 0xBA, 0xC0 };
+static const uint8_t Test_BIP_Router_MAC[6] = { 10, 0, 0, 20, 0xBA, 0xC0 };
+#define TEST_MSTP_MAC 0x05
+#define TEST_MSTP_STATION_MAC 0x07
+/* Who-Is as an APDU */
+static const uint8_t Test_Apdu[] = { 0x10, 0x08 };
+
+void bvlc_maintenance_timer(uint16_t seconds)
+{
+    (void)seconds;
+}
+
+void bvlc6_maintenance_timer(uint16_t seconds)
+{
+    (void)seconds;
+}
+
+static int test_send(unsigned transport, BACNET_ADDRESS *dest, uint8_t *pdu,
+    unsigned pdu_len)
+{
+    struct test_frame *frame;
+
+    zassert_true(Test_Tx_Count < (sizeof(Test_Tx) / sizeof(Test_Tx[0])), NULL);
+    zassert_true(pdu_len <= MAX_MPDU, NULL);
+    frame = &Test_Tx[Test_Tx_Count++];
+    frame->transport = transport;
+    frame->addr = *dest;
+    memcpy(&frame->pdu[0], pdu, pdu_len);
+    frame->pdu_len = (uint16_t)pdu_len;
+
+    return (int)pdu_len;
+}
+
+static uint16_t test_receive(
+    unsigned transport, BACNET_ADDRESS *src, uint8_t *pdu, uint16_t max_pdu)
+{
+    struct test_frame *frame = &Test_Rx[transport];
+    uint16_t pdu_len = frame->pdu_len;
+
+    if ((pdu_len == 0) || (pdu_len > max_pdu)) {
+        return 0;
+    }
+    *src = frame->addr;
+    memcpy(pdu, &frame->pdu[0], pdu_len);
+    frame->pdu_len = 0;
+
+    return pdu_len;
+}
+
+bool bip_init(char *ifname)
+{
+    (void)ifname;
+    return true;
+}
+
+void bip_cleanup(void)
+{
+}
+
+int bip_send_pdu(BACNET_ADDRESS *dest,
+    BACNET_NPDU_DATA *npdu_data,
+    uint8_t *pdu,
+    unsigned pdu_len)
+{
+    (void)npdu_data;
+    return test_send(TEST_BIP, dest, pdu, pdu_len);
+}
+
+uint16_t bip_receive(
+    BACNET_ADDRESS *src, uint8_t *pdu, uint16_t max_pdu, unsigned timeout)
+{
+    (void)timeout;
+    return test_receive(TEST_BIP, src, pdu, max_pdu);
+}
+
+void bip_get_my_address(BACNET_ADDRESS *my_address)
+{
+    memset(my_address, 0, sizeof(*my_address));
+    my_address->mac_len = 6;
+    memcpy(&my_address->mac[0], Test_BIP_MAC, 6);
+}
+
+void bip_get_broadcast_address(BACNET_ADDRESS *dest)
+{
+    memset(dest, 0, sizeof(*dest));
+    dest->mac_len = 6;
+    memcpy(&dest->mac[0], Test_BIP_Broadcast_MAC, 6);
+    dest->net = BACNET_BROADCAST_NETWORK;
+}
+
+bool dlmstp_init(char *ifname)
+{
+    (void)ifname;
+    return true;
+}
+
+void dlmstp_cleanup(void)
+{
+}
+
+int dlmstp_send_pdu(BACNET_ADDRESS *dest,
+    BACNET_NPDU_DATA *npdu_data,
+    uint8_t *pdu,
+    unsigned pdu_len)
+{
+    (void)npdu_data;
+    return test_send(TEST_MSTP, dest, pdu, pdu_len);
+}
+
+uint16_t dlmstp_receive(
+    BACNET_ADDRESS *src, uint8_t *pdu, uint16_t max_pdu, unsigned timeout)
+{
+    (void)timeout;
+    return test_receive(TEST_MSTP, src, pdu, max_pdu);
+}
+
+void dlmstp_get_my_address(BACNET_ADDRESS *my_address)
+{
+    memset(my_address, 0, sizeof(*my_address));
+    my_address->mac_len = 1;
+    my_address->mac[0] = TEST_MSTP_MAC;
+}
+
+void dlmstp_get_broadcast_address(BACNET_ADDRESS *dest)
+{
+    memset(dest, 0, sizeof(*dest));
+    dest->mac_len = 1;
+    dest->mac[0] = MSTP_BROADCAST_ADDRESS;
+    dest->net = BACNET_BROADCAST_NETWORK;
+}
+
+void apdu_handler(BACNET_ADDRESS *src, uint8_t *apdu, uint16_t pdu_len)
+{
+    zassert_equal(pdu_len, sizeof(Test_Apdu), NULL);
+    zassert_mem_equal(apdu, Test_Apdu, sizeof(Test_Apdu), NULL);
+    Test_Apdu_Src = *src;
+    Test_Apdu_Count++;
+}
+
+bool Routed_Device_Is_Valid_Network(uint16_t dest_net, int *DNET_list)
+{
+    return (dest_net == 0) || (dest_net == BACNET_BROADCAST_NETWORK) ||
+        (dest_net == DNET_list[0]);
+}
+
+bool Routed_Device_GetNext(BACNET_ADDRESS *dest, int *DNET_list, int *cursor)
+{
+    (void)dest;
+    (void)DNET_list;
+    if (*cursor < 0) {
+        return false;
+    }
+    *cursor = -1;
+
+    return true;
+}
+
+void Send_I_Am_Router_To_Network(const int DNET_list[])
+{
+    (void)DNET_list;
+}
+
+void Send_Initialize_Routing_Table_Ack(BACNET_ADDRESS *dst, const int DNET_list[])
+{
+    (void)dst;
+    (void)DNET_list;
+}
+
+void Send_Reject_Message_To_Network(
+    BACNET_ADDRESS *dst, uint8_t reject_reason, int dnet)
+{
+    (void)dst;
+    (void)reject_reason;
+    (void)dnet;
+    Test_Reject_Count++;
+}
+
+const char *bactext_network_layer_msg_name(unsigned index)
+{
+    (void)index;
+    return "";
+}
+
+void debug_printf(const char *format, ...)
+{
+    (void)format;
+}
+
+static void test_ports_init(void)
+{
+    datalink_cleanup();
+    memset(Test_Rx, 0, sizeof(Test_Rx));
+    Test_Tx_Count = 0;
+    Test_Apdu_Count = 0;
+    Test_Reject_Count = 0;
+    zassert_equal(datalink_port_add("bip", NULL, 1), 0, NULL);
+    zassert_equal(datalink_port_add("mstp", NULL, 2), 1, NULL);
+}
+
+static void test_address(BACNET_ADDRESS *address,
+    uint16_t net,
+    const uint8_t *adr,
+    uint8_t len)
+{
+    memset(address, 0, sizeof(*address));
+    address->net = net;
+    address->len = len;
+    if (len) {
+        memcpy(&address->adr[0], adr, len);
+    }
+}
+
+static void test_mac(BACNET_ADDRESS *address, const uint8_t *mac, uint8_t len)
+{
+    memset(address, 0, sizeof(*address));
+    address->mac_len = len;
+    memcpy(&address->mac[0], mac, len);
+}
+
+/* encode an NPDU with the test APDU */
+static uint16_t test_npdu(uint8_t *pdu,
+    BACNET_ADDRESS *dest,
+    BACNET_ADDRESS *src,
+    uint8_t hop_count,
+    BACNET_NPDU_DATA *npdu_data)
+{
+    int len;
+
+    npdu_encode_npdu_data(npdu_data, false, MESSAGE_PRIORITY_NORMAL);
+    npdu_data->hop_count = hop_count;
+    len = npdu_encode_pdu(pdu, dest, src, npdu_data);
+    memcpy(&pdu[len], Test_Apdu, sizeof(Test_Apdu));
+
+    return (uint16_t)(len + sizeof(Test_Apdu));
+}
+
+/* decode a frame, and check that it carries the test APDU */
+static void test_frame_decode(struct test_frame *frame,
+    BACNET_ADDRESS *dest,
+    BACNET_ADDRESS *src,
+    BACNET_NPDU_DATA *npdu_data)
+{
+    int offset;
+
+    offset = bacnet_npdu_decode(
+        &frame->pdu[0], frame->pdu_len, dest, src, npdu_data);
+    zassert_true(offset > 0, NULL);
+    zassert_equal(frame->pdu_len - offset, sizeof(Test_Apdu), NULL);
+    zassert_mem_equal(&frame->pdu[offset], Test_Apdu, sizeof(Test_Apdu), NULL);
+}
+
+/**
+ * @addtogroup bacnet_tests
+ * @{
+ */
+
+/**
+ * @brief Test that datalink_send_pdu() picks the port of the network,
+ * and removes the DNET on a directly connected network
+ */
+static void test_datalink_ports_send(void)
+{
+    uint8_t pdu[MAX_MPDU] = { 0 };
+    uint8_t adr[MAX_MAC_LEN] = { TEST_MSTP_STATION_MAC };
+    uint8_t router_mac[1] = { 0x09 };
+    BACNET_ADDRESS dest = { 0 };
+    BACNET_ADDRESS router = { 0 };
+    BACNET_ADDRESS npdu_dest = { 0 };
+    BACNET_ADDRESS npdu_src = { 0 };
+    BACNET_NPDU_DATA npdu_data = { 0 };
+    uint16_t pdu_len;
+
+    test_ports_init();
+    /* a station on the network of the MS/TP port */
+    test_address(&dest, 2, adr, 1);
+    pdu_len = test_npdu(pdu, &dest, NULL, 255, &npdu_data);
+    zassert_true(datalink_send_pdu(&dest, &npdu_data, pdu, pdu_len) > 0, NULL);
+    zassert_equal(Test_Tx_Count, 1, NULL);
+    zassert_equal(Test_Tx[0].transport, TEST_MSTP, NULL);
+    zassert_equal(Test_Tx[0].addr.mac_len, 1, NULL);
+    zassert_equal(Test_Tx[0].addr.mac[0], TEST_MSTP_STATION_MAC, NULL);
+    test_frame_decode(&Test_Tx[0], &npdu_dest, &npdu_src, &npdu_data);
+    zassert_equal(npdu_dest.net, 0, NULL);
+    zassert_equal(npdu_src.net, 0, NULL);
+    /* a broadcast on the network of the MS/TP port */
+    test_address(&dest, 2, NULL, 0);
+    pdu_len = test_npdu(pdu, &dest, NULL, 255, &npdu_data);
+    datalink_send_pdu(&dest, &npdu_data, pdu, pdu_len);
+    zassert_equal(Test_Tx_Count, 2, NULL);
+    zassert_equal(Test_Tx[1].transport, TEST_MSTP, NULL);
+    zassert_equal(Test_Tx[1].addr.mac[0], MSTP_BROADCAST_ADDRESS, NULL);
+    test_frame_decode(&Test_Tx[1], &npdu_dest, &npdu_src, &npdu_data);
+    zassert_equal(npdu_dest.net, 0, NULL);
+    /* a local station goes out the first port as it is */
+    test_mac(&dest, Test_BIP_Station_MAC, 6);
+    pdu_len = test_npdu(pdu, NULL, NULL, 255, &npdu_data);
+    datalink_send_pdu(&dest, &npdu_data, pdu, pdu_len);
+    zassert_equal(Test_Tx_Count, 3, NULL);
+    zassert_equal(Test_Tx[2].transport, TEST_BIP, NULL);
+    zassert_mem_equal(&Test_Tx[2].addr.mac[0], Test_BIP_Station_MAC, 6, NULL);
+    zassert_equal(Test_Tx[2].pdu_len, pdu_len, NULL);
+    zassert_mem_equal(&Test_Tx[2].pdu[0], pdu, pdu_len, NULL);
+    /* a global broadcast goes out every port */
+    test_address(&dest, BACNET_BROADCAST_NETWORK, NULL, 0);
+    pdu_len = test_npdu(pdu, &dest, NULL, 255, &npdu_data);
+    datalink_send_pdu(&dest, &npdu_data, pdu, pdu_len);
+    zassert_equal(Test_Tx_Count, 5, NULL);
+    zassert_equal(Test_Tx[3].transport, TEST_BIP, NULL);
+    zassert_mem_equal(
+        &Test_Tx[3].addr.mac[0], Test_BIP_Broadcast_MAC, 6, NULL);
+    zassert_mem_equal(&Test_Tx[3].pdu[0], pdu, pdu_len, NULL);
+    zassert_equal(Test_Tx[4].transport, TEST_MSTP, NULL);
+    zassert_equal(Test_Tx[4].addr.mac[0], MSTP_BROADCAST_ADDRESS, NULL);
+    zassert_mem_equal(&Test_Tx[4].pdu[0], pdu, pdu_len, NULL);
+    /* a remote network goes to its router, with the DNET */
+    test_mac(&router, router_mac, 1);
+    datalink_port_route_add(1, 5, &router);
+    adr[0] = 0x01;
+    adr[1] = 0x02;
+    test_address(&dest, 5, adr, 2);
+    pdu_len = test_npdu(pdu, &dest, NULL, 255, &npdu_data);
+    datalink_send_pdu(&dest, &npdu_data, pdu, pdu_len);
+    zassert_equal(Test_Tx_Count, 6, NULL);
+    zassert_equal(Test_Tx[5].transport, TEST_MSTP, NULL);
+    zassert_equal(Test_Tx[5].addr.mac_len, 1, NULL);
+    zassert_equal(Test_Tx[5].addr.mac[0], 0x09, NULL);
+    zassert_equal(Test_Tx[5].pdu_len, pdu_len, NULL);
+    zassert_mem_equal(&Test_Tx[5].pdu[0], pdu, pdu_len, NULL);
+    /* an unknown network goes out the first port */
+    test_address(&dest, 6, adr, 2);
+    pdu_len = test_npdu(pdu, &dest, NULL, 255, &npdu_data);
+    datalink_send_pdu(&dest, &npdu_data, pdu, pdu_len);
+    zassert_equal(Test_Tx_Count, 7, NULL);
+    zassert_equal(Test_Tx[6].transport, TEST_BIP, NULL);
+    zassert_mem_equal(&Test_Tx[6].pdu[0], pdu, pdu_len, NULL);
+    datalink_cleanup();
+}
+
+/**
+ * @brief Test that datalink_receive() gives a source on another port
+ * its SNET and SADR, so that the reply goes back out that port
+ */
+static void test_datalink_ports_receive(void)
+{
+    uint8_t pdu[MAX_MPDU] = { 0 };
+    uint8_t adr[2] = { 0x01, 0x02 };
+    BACNET_ADDRESS src = { 0 };
+    BACNET_ADDRESS router = { 0 };
+    BACNET_ADDRESS npdu_dest = { 0 };
+    BACNET_ADDRESS npdu_src = { 0 };
+    BACNET_NPDU_DATA npdu_data = { 0 };
+    struct test_frame *frame;
+    uint16_t pdu_len, rx_len;
+    int offset;
+
+    test_ports_init();
+    /* from a station on the MS/TP port */
+    frame = &Test_Rx[TEST_MSTP];
+    frame->addr.mac_len = 1;
+    frame->addr.mac[0] = TEST_MSTP_STATION_MAC;
+    frame->pdu_len = test_npdu(&frame->pdu[0], NULL, NULL, 255, &npdu_data);
+    rx_len = frame->pdu_len;
+    pdu_len = datalink_receive(&src, pdu, sizeof(pdu), 0);
+    zassert_equal(pdu_len, rx_len + 4, NULL);
+    zassert_equal(src.mac[0], TEST_MSTP_STATION_MAC, NULL);
+    offset = bacnet_npdu_decode(pdu, pdu_len, &npdu_dest, &src, &npdu_data);
+    zassert_equal(pdu_len - offset, sizeof(Test_Apdu), NULL);
+    zassert_mem_equal(&pdu[offset], Test_Apdu, sizeof(Test_Apdu), NULL);
+    zassert_equal(npdu_dest.net, 0, NULL);
+    zassert_equal(src.net, 2, NULL);
+    zassert_equal(src.len, 1, NULL);
+    zassert_equal(src.adr[0], TEST_MSTP_STATION_MAC, NULL);
+    /* the reply to that source goes back to the station */
+    pdu_len = test_npdu(pdu, &src, NULL, 255, &npdu_data);
+    datalink_send_pdu(&src, &npdu_data, pdu, pdu_len);
+    zassert_equal(Test_Tx_Count, 1, NULL);
+    zassert_equal(Test_Tx[0].transport, TEST_MSTP, NULL);
+    zassert_equal(Test_Tx[0].addr.mac[0], TEST_MSTP_STATION_MAC, NULL);
+    test_frame_decode(&Test_Tx[0], &npdu_dest, &npdu_src, &npdu_data);
+    zassert_equal(npdu_dest.net, 0, NULL);
+    /* from a station on the first port, as it is */
+    frame = &Test_Rx[TEST_BIP];
+    test_mac(&frame->addr, Test_BIP_Station_MAC, 6);
+    frame->pdu_len = test_npdu(&frame->pdu[0], NULL, NULL, 255, &npdu_data);
+    rx_len = frame->pdu_len;
+    pdu_len = datalink_receive(&src, pdu, sizeof(pdu), 0);
+    zassert_equal(pdu_len, rx_len, NULL);
+    zassert_mem_equal(pdu, &frame->pdu[0], pdu_len, NULL);
+    /* from a station behind a router on the MS/TP port */
+    frame = &Test_Rx[TEST_MSTP];
+    frame->addr.mac_len = 1;
+    frame->addr.mac[0] = 0x09;
+    test_address(&npdu_src, 7, adr, 2);
+    frame->pdu_len =
+        test_npdu(&frame->pdu[0], NULL, &npdu_src, 255, &npdu_data);
+    rx_len = frame->pdu_len;
+    pdu_len = datalink_receive(&src, pdu, sizeof(pdu), 0);
+    zassert_equal(pdu_len, rx_len, NULL);
+    zassert_mem_equal(pdu, &frame->pdu[0], pdu_len, NULL);
+    zassert_equal(datalink_port_route_find(7, &router), 1, NULL);
+    zassert_equal(router.mac_len, 1, NULL);
+    zassert_equal(router.mac[0], 0x09, NULL);
+    /* no room for the SNET and SADR */
+    frame->addr.mac[0] = TEST_MSTP_STATION_MAC;
+    frame->pdu_len = test_npdu(&frame->pdu[0], NULL, NULL, 255, &npdu_data);
+    rx_len = frame->pdu_len;
+    zassert_equal(datalink_receive(&src, pdu, rx_len + 1, 0), 0, NULL);
+    datalink_cleanup();
+}
+
+/**
+ * @brief Test that routing_npdu_port_handler() forwards between ports
+ */
+static void test_routed_port_forward(void)
+{
+    int DNET_list[2] = { 100, -1 };
+    uint8_t pdu[MAX_MPDU] = { 0 };
+    uint8_t adr[MAX_MAC_LEN] = { TEST_MSTP_STATION_MAC };
+    BACNET_ADDRESS src = { 0 };
+    BACNET_ADDRESS dest = { 0 };
+    BACNET_ADDRESS router = { 0 };
+    BACNET_ADDRESS npdu_dest = { 0 };
+    BACNET_ADDRESS npdu_src = { 0 };
+    BACNET_NPDU_DATA npdu_data = { 0 };
+    uint16_t pdu_len;
+
+    test_ports_init();
+    /* from B/IP to a station on MS/TP */
+    test_mac(&src, Test_BIP_Station_MAC, 6);
+    test_address(&dest, 2, adr, 1);
+    pdu_len = test_npdu(pdu, &dest, NULL, 255, &npdu_data);
+    routing_npdu_port_handler(0, &src, DNET_list, pdu, pdu_len);
+    zassert_equal(Test_Apdu_Count, 0, NULL);
+    zassert_equal(Test_Tx_Count, 1, NULL);
+    zassert_equal(Test_Tx[0].transport, TEST_MSTP, NULL);
+    zassert_equal(Test_Tx[0].addr.mac_len, 1, NULL);
+    zassert_equal(Test_Tx[0].addr.mac[0], TEST_MSTP_STATION_MAC, NULL);
+    test_frame_decode(&Test_Tx[0], &npdu_dest, &npdu_src, &npdu_data);
+    zassert_equal(npdu_dest.net, 0, NULL);
+    zassert_equal(npdu_src.net, 1, NULL);
+    zassert_equal(npdu_src.len, 6, NULL);
+    zassert_mem_equal(&npdu_src.adr[0], Test_BIP_Station_MAC, 6, NULL);
+    /* from MS/TP to a station on B/IP */
+    test_mac(&src, adr, 1);
+    test_address(&dest, 1, Test_BIP_Station_MAC, 6);
+    pdu_len = test_npdu(pdu, &dest, NULL, 255, &npdu_data);
+    routing_npdu_port_handler(1, &src, DNET_list, pdu, pdu_len);
+    zassert_equal(Test_Tx_Count, 2, NULL);
+    zassert_equal(Test_Tx[1].transport, TEST_BIP, NULL);
+    zassert_mem_equal(&Test_Tx[1].addr.mac[0], Test_BIP_Station_MAC, 6, NULL);
+    test_frame_decode(&Test_Tx[1], &npdu_dest, &npdu_src, &npdu_data);
+    zassert_equal(npdu_dest.net, 0, NULL);
+    zassert_equal(npdu_src.net, 2, NULL);
+    zassert_equal(npdu_src.adr[0], TEST_MSTP_STATION_MAC, NULL);
+    /* a global broadcast is forwarded, and handled here too */
+    test_mac(&src, Test_BIP_Station_MAC, 6);
+    test_address(&dest, BACNET_BROADCAST_NETWORK, NULL, 0);
+    pdu_len = test_npdu(pdu, &dest, NULL, 255, &npdu_data);
+    routing_npdu_port_handler(0, &src, DNET_list, pdu, pdu_len);
+    zassert_equal(Test_Tx_Count, 3, NULL);
+    zassert_equal(Test_Tx[2].transport, TEST_MSTP, NULL);
+    zassert_equal(Test_Tx[2].addr.mac[0], MSTP_BROADCAST_ADDRESS, NULL);
+    test_frame_decode(&Test_Tx[2], &npdu_dest, &npdu_src, &npdu_data);
+    zassert_equal(npdu_dest.net, BACNET_BROADCAST_NETWORK, NULL);
+    zassert_equal(npdu_data.hop_count, 254, NULL);
+    zassert_equal(npdu_src.net, 1, NULL);
+    zassert_equal(Test_Apdu_Count, 1, NULL);
+    zassert_equal(Test_Apdu_Src.net, 1, NULL);
+    /* a local PDU is handled with the network of its port */
+    test_mac(&src, adr, 1);
+    pdu_len = test_npdu(pdu, NULL, NULL, 255, &npdu_data);
+    routing_npdu_port_handler(1, &src, DNET_list, pdu, pdu_len);
+    zassert_equal(Test_Tx_Count, 3, NULL);
+    zassert_equal(Test_Apdu_Count, 2, NULL);
+    zassert_equal(Test_Apdu_Src.net, 2, NULL);
+    zassert_equal(Test_Apdu_Src.len, 1, NULL);
+    zassert_equal(Test_Apdu_Src.adr[0], TEST_MSTP_STATION_MAC, NULL);
+    /* the hop count has run out */
+    test_mac(&src, Test_BIP_Station_MAC, 6);
+    test_address(&dest, 2, adr, 1);
+    pdu_len = test_npdu(pdu, &dest, NULL, 1, &npdu_data);
+    routing_npdu_port_handler(0, &src, DNET_list, pdu, pdu_len);
+    zassert_equal(Test_Tx_Count, 3, NULL);
+    zassert_equal(Test_Apdu_Count, 2, NULL);
+    /* addressed to this device on the other port */
+    adr[0] = TEST_MSTP_MAC;
+    test_address(&dest, 2, adr, 1);
+    pdu_len = test_npdu(pdu, &dest, NULL, 255, &npdu_data);
+    routing_npdu_port_handler(0, &src, DNET_list, pdu, pdu_len);
+    zassert_equal(Test_Tx_Count, 3, NULL);
+    zassert_equal(Test_Apdu_Count, 3, NULL);
+    zassert_equal(Test_Reject_Count, 0, NULL);
+    datalink_cleanup();
+}
+
+/**
+ * @brief Test the router network messages on the ports
+ */
+static void test_routed_port_network_messages(void)
+{
+    int DNET_list[2] = { 100, -1 };
+    uint8_t pdu[MAX_MPDU] = { 0 };
+    uint8_t adr[MAX_MAC_LEN] = { 0x03 };
+    BACNET_ADDRESS src = { 0 };
+    BACNET_ADDRESS dest = { 0 };
+    BACNET_ADDRESS router = { 0 };
+    BACNET_ADDRESS npdu_dest = { 0 };
+    BACNET_ADDRESS npdu_src = { 0 };
+    BACNET_NPDU_DATA npdu_data = { 0 };
+    uint16_t net = 0;
+    int len, offset;
+
+    test_ports_init();
+    /* Who-Is-Router-To-Network for any network, from MS/TP */
+    npdu_encode_npdu_network(&npdu_data,
+        NETWORK_MESSAGE_WHO_IS_ROUTER_TO_NETWORK, false,
+        MESSAGE_PRIORITY_NORMAL);
+    len = npdu_encode_pdu(pdu, NULL, NULL, &npdu_data);
+    src.mac_len = 1;
+    src.mac[0] = TEST_MSTP_STATION_MAC;
+    routing_npdu_port_handler(1, &src, DNET_list, pdu, (uint16_t)len);
+    zassert_equal(Test_Tx_Count, 1, NULL);
+    zassert_equal(Test_Tx[0].transport, TEST_MSTP, NULL);
+    zassert_equal(Test_Tx[0].addr.mac[0], MSTP_BROADCAST_ADDRESS, NULL);
+    offset = bacnet_npdu_decode(&Test_Tx[0].pdu[0], Test_Tx[0].pdu_len,
+        &npdu_dest, &npdu_src, &npdu_data);
+    zassert_true(npdu_data.network_layer_message, NULL);
+    zassert_equal(npdu_data.network_message_type,
+        NETWORK_MESSAGE_I_AM_ROUTER_TO_NETWORK, NULL);
+    zassert_equal(Test_Tx[0].pdu_len - offset, 4, NULL);
+    decode_unsigned16(&Test_Tx[0].pdu[offset], &net);
+    zassert_equal(net, 1, NULL);
+    decode_unsigned16(&Test_Tx[0].pdu[offset + 2], &net);
+    zassert_equal(net, 100, NULL);
+    /* Who-Is-Router-To-Network for the network of the other port */
+    npdu_encode_npdu_network(&npdu_data,
+        NETWORK_MESSAGE_WHO_IS_ROUTER_TO_NETWORK, false,
+        MESSAGE_PRIORITY_NORMAL);
+    len = npdu_encode_pdu(pdu, NULL, NULL, &npdu_data);
+    len += encode_unsigned16(&pdu[len], 2);
+    test_mac(&src, Test_BIP_Station_MAC, 6);
+    routing_npdu_port_handler(0, &src, DNET_list, pdu, (uint16_t)len);
+    zassert_equal(Test_Tx_Count, 2, NULL);
+    zassert_equal(Test_Tx[1].transport, TEST_BIP, NULL);
+    offset = bacnet_npdu_decode(&Test_Tx[1].pdu[0], Test_Tx[1].pdu_len,
+        &npdu_dest, &npdu_src, &npdu_data);
+    zassert_equal(Test_Tx[1].pdu_len - offset, 2, NULL);
+    decode_unsigned16(&Test_Tx[1].pdu[offset], &net);
+    zassert_equal(net, 2, NULL);
+    /* a network on its own port is not announced there */
+    routing_npdu_port_handler(1, &src, DNET_list, pdu, (uint16_t)len);
+    zassert_equal(Test_Tx_Count, 2, NULL);
+    /* I-Am-Router-To-Network from a router on B/IP */
+    npdu_encode_npdu_network(&npdu_data,
+        NETWORK_MESSAGE_I_AM_ROUTER_TO_NETWORK, false,
+        MESSAGE_PRIORITY_NORMAL);
+    len = npdu_encode_pdu(pdu, NULL, NULL, &npdu_data);
+    len += encode_unsigned16(&pdu[len], 9);
+    test_mac(&src, Test_BIP_Router_MAC, 6);
+    routing_npdu_port_handler(0, &src, DNET_list, pdu, (uint16_t)len);
+    zassert_equal(Test_Tx_Count, 2, NULL);
+    zassert_equal(datalink_port_route_find(9, &router), 0, NULL);
+    zassert_mem_equal(&router.mac[0], Test_BIP_Router_MAC, 6, NULL);
+    /* from MS/TP to that remote network, through the router */
+    test_mac(&src, adr, 1);
+    src.mac[0] = TEST_MSTP_STATION_MAC;
+    test_address(&dest, 9, adr, 1);
+    len = test_npdu(pdu, &dest, NULL, 255, &npdu_data);
+    routing_npdu_port_handler(1, &src, DNET_list, pdu, (uint16_t)len);
+    zassert_equal(Test_Tx_Count, 3, NULL);
+    zassert_equal(Test_Tx[2].transport, TEST_BIP, NULL);
+    zassert_mem_equal(&Test_Tx[2].addr.mac[0], Test_BIP_Router_MAC, 6, NULL);
+    test_frame_decode(&Test_Tx[2], &npdu_dest, &npdu_src, &npdu_data);
+    zassert_equal(npdu_dest.net, 9, NULL);
+    zassert_equal(npdu_dest.len, 1, NULL);
+    zassert_equal(npdu_dest.adr[0], 0x03, NULL);
+    zassert_equal(npdu_data.hop_count, 254, NULL);
+    zassert_equal(npdu_src.net, 2, NULL);
+    zassert_equal(npdu_src.adr[0], TEST_MSTP_STATION_MAC, NULL);
+    datalink_cleanup();
+}
+/**
+ * @}
+ */
+
+void test_main(void)
+{
+    ztest_test_suite(datalink_ports_tests,
+     ztest_unit_test(test_datalink_ports_send),
+     ztest_unit_test(test_datalink_ports_receive),
+     ztest_unit_test(test_routed_port_forward),
+     ztest_unit_test(test_routed_port_network_messages)
+     );
+
+    ztest_run_test_suite(datalink_ports_tests);
+}